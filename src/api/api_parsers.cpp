@@ -24,6 +24,7 @@ Revision History:
 #include "smt/smt_solver.h"
 #include "smt/smt2_extra_cmds.h"
 #include "parsers/smt2/smt2parser.h"
+#include "ast/ast_serialize.h"
 #include "solver/solver_na2as.h"
 #include "muz/fp/dl_cmds.h"
 #include "opt/opt_cmds.h"
@@ -264,4 +265,53 @@ extern "C" {
         RETURN_Z3(mk_c(c)->mk_external_string(ous.str()));
         Z3_CATCH_RETURN(mk_c(c)->mk_external_string(ous.str()));
     }
+
+    // ---------------
+    // Binary serialization
+
+    bool Z3_API Z3_serialize_to_file(Z3_context c, Z3_ast_vector v, Z3_string file_name) {
+        Z3_TRY;
+        LOG_Z3_serialize_to_file(c, v, file_name);
+        RESET_ERROR_CODE();
+        ast_manager& m = mk_c(c)->m();
+        expr_ref_vector es(m);
+        for (ast* a : to_ast_vector_ref(v)) {
+            if (!is_expr(a)) {
+                SET_ERROR_CODE(Z3_INVALID_ARG, "expression expected");
+                return false;
+            }
+            es.push_back(to_expr(a));
+        }
+        std::ofstream out(file_name, std::ios::binary);
+        if (!out) {
+            SET_ERROR_CODE(Z3_FILE_ACCESS_ERROR, nullptr);
+            return false;
+        }
+        serialize_exprs(m, es.size(), es.data(), out);
+        out.close();
+        if (!out) {
+            SET_ERROR_CODE(Z3_FILE_ACCESS_ERROR, nullptr);
+            return false;
+        }
+        return true;
+        Z3_CATCH_RETURN(false);
+    }
+
+    Z3_ast_vector Z3_API Z3_deserialize_file(Z3_context c, Z3_string file_name) {
+        Z3_TRY;
+        LOG_Z3_deserialize_file(c, file_name);
+        RESET_ERROR_CODE();
+        ast_manager& m = mk_c(c)->m();
+        expr_ref_vector es(m);
+        if (!deserialize_exprs_from_file(m, file_name, es)) {
+            SET_ERROR_CODE(Z3_FILE_ACCESS_ERROR, nullptr);
+            RETURN_Z3(nullptr);
+        }
+        Z3_ast_vector_ref * r = alloc(Z3_ast_vector_ref, *mk_c(c), m);
+        mk_c(c)->save_object(r);
+        for (expr* e : es)
+            r->m_ast_vector.push_back(e);
+        RETURN_Z3(of_ast_vector(r));
+        Z3_CATCH_RETURN(nullptr);
+    }
 }
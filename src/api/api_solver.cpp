@@ -22,7 +22,10 @@ Revision History:
 #include "util/file_path.h"
 #include "util/scoped_timer.h"
 #include "util/file_path.h"
+#include "util/timer.h"
 #include "ast/ast_pp.h"
+#include "ast/ast_translation.h"
+#include "ast/ast_util.h"
 #include "api/z3.h"
 #include "api/api_log_macros.h"
 #include "api/api_context.h"
@@ -45,7 +48,138 @@ Revision History:
 #include "sat/tactic/sat2goal.h"
 #include "cmd_context/extra_cmds/proof_cmds.h"
 #include "solver/simplifier_solver.h"
+#ifndef SINGLE_THREAD
+#include <condition_variable>
+#include <mutex>
+#endif
 
+namespace api {
+
+    /**
+       A check started by Z3_solver_check_async. It runs on a copy of the solver in a
+       manager of its own, so the thread of the check shares no terms with the context.
+       The results are translated back to the context after the check has finished.
+    */
+    struct async_check : public progress_callback {
+        ast_manager          m;
+        ref<::solver>        m_solver;
+        expr_ref_vector      m_asms;
+        unsigned             m_timeout = UINT_MAX;
+        unsigned             m_rlimit = 0;
+        timer                m_timer;
+        double               m_last_sample = 0;
+        model_ref            m_model;
+        expr_ref_vector      m_core;
+#ifndef SINGLE_THREAD
+        std::mutex              m_mux;
+        std::condition_variable m_cv;
+        std::thread             m_thread;
+#endif
+        // protected by m_mux
+        bool                 m_done = false;
+        lbool                m_result = l_undef;
+        std::string          m_reason_unknown;
+        statistics           m_stats;
+        unsigned             m_num_samples = 0;
+
+        async_check(ast_manager& src): m(src, true), m_asms(m), m_core(m) {}
+
+        ~async_check() override {
+            m.limit().cancel();
+#ifndef SINGLE_THREAD
+            if (m_thread.joinable())
+                m_thread.join();
+#endif
+        }
+
+        void snapshot() {
+            statistics st;
+            m_solver->collect_statistics(st);
+            get_rlimit_statistics(m.limit(), st);
+#ifndef SINGLE_THREAD
+            std::lock_guard<std::mutex> lock(m_mux);
+#endif
+            ++m_num_samples;
+            m_stats.reset();
+            m_stats.copy(st);
+            m_stats.update("async-progress-samples", m_num_samples);
+        }
+
+        // called by the solver in the thread of the check
+        void fast_progress_sample() override {
+            double now = m_timer.get_seconds();
+            if (now - m_last_sample >= 0.1) {
+                m_last_sample = now;
+                snapshot();
+            }
+        }
+
+        void run() {
+            lbool r = l_undef;
+            std::string reason;
+            cancel_eh<reslimit> eh(m.limit());
+            {
+                scoped_timer timer(m_timeout, &eh);
+                scoped_rlimit _rlimit(m.limit(), m_rlimit);
+                try {
+                    r = m_solver->check_sat(m_asms);
+                    if (r == l_true)
+                        m_solver->get_model(m_model);
+                    else if (r == l_false)
+                        m_solver->get_unsat_core(m_core);
+                }
+                catch (z3_exception& ex) {
+                    r = l_undef;
+                    reason = ex.msg();
+                }
+            }
+            m_solver->set_progress_callback(nullptr);
+            if (r == l_undef && reason.empty())
+                reason = eh.canceled() ? "canceled" : m_solver->reason_unknown();
+            snapshot();
+#ifndef SINGLE_THREAD
+            std::lock_guard<std::mutex> lock(m_mux);
+#endif
+            m_result = r;
+            m_reason_unknown = reason;
+            m_done = true;
+#ifndef SINGLE_THREAD
+            m_cv.notify_all();
+#endif
+        }
+
+        /**
+           Return true if the check has finished, in which case its thread is joined
+           and its results can be read without locking.
+        */
+        bool finished() {
+#ifndef SINGLE_THREAD
+            {
+                std::lock_guard<std::mutex> lock(m_mux);
+                if (!m_done)
+                    return false;
+            }
+            if (m_thread.joinable())
+                m_thread.join();
+#endif
+            return m_done;
+        }
+
+        bool wait(unsigned timeout) {
+#ifndef SINGLE_THREAD
+            std::unique_lock<std::mutex> lock(m_mux);
+            if (timeout == UINT_MAX)
+                m_cv.wait(lock, [&]() { return m_done; });
+            else
+                m_cv.wait_for(lock, std::chrono::milliseconds(timeout), [&]() { return m_done; });
+            if (!m_done)
+                return false;
+            lock.unlock();
+#endif
+            return finished();
+        }
+    };
+}
 
 extern "C" {
 
@@ -121,6 +255,8 @@ extern "C" {
         }
     }
 
+    Z3_solver_ref::~Z3_solver_ref() {}
+
     void Z3_solver_ref::set_eh(event_handler* eh) {
         lock_guard lock(m_mux);
         m_eh = eh;
@@ -691,7 +827,231 @@ extern "C" {
         return _solver_check(c, s, num_assumptions, assumptions);
         Z3_CATCH_RETURN(Z3_L_UNDEF);
     }
-    
+
+    void Z3_API Z3_solver_check_assumptions_batch(Z3_context c, Z3_solver s,
+                                                  unsigned num_sets, Z3_ast const assumption_sets[],
+                                                  unsigned num_workers, Z3_lbool results[], Z3_ast_vector cores) {
+        Z3_TRY;
+        LOG_Z3_solver_check_assumptions_batch(c, s, num_sets, assumption_sets, num_workers, results, cores);
+        RESET_ERROR_CODE();
+        init_solver(c, s);
+        ast_manager& m = mk_c(c)->m();
+        vector<expr_ref_vector> sets;
+        for (unsigned i = 0; i < num_sets; i++) {
+            results[i] = Z3_L_UNDEF;
+            if (!is_expr(to_ast(assumption_sets[i]))) {
+                SET_ERROR_CODE(Z3_INVALID_ARG, "assumption is not an expression");
+                return;
+            }
+            sets.push_back(expr_ref_vector(m));
+            sets.back().push_back(to_expr(assumption_sets[i]));
+            flatten_and(sets.back());
+        }
+        solver_params sp(to_solver(s)->m_params);
+        unsigned timeout     = mk_c(c)->get_timeout();
+        timeout              = to_solver(s)->m_params.get_uint("timeout", timeout);
+        timeout              = sp.timeout() != UINT_MAX ? sp.timeout() : timeout;
+        unsigned rlimit      = to_solver(s)->m_params.get_uint("rlimit", mk_c(c)->get_rlimit());
+        bool     use_ctrl_c  = to_solver(s)->m_params.get_bool("ctrl_c", true);
+        cancel_eh<reslimit> eh(m.limit());
+        to_solver(s)->set_eh(&eh);
+        api::context::set_interruptable si(*(mk_c(c)), eh);
+        svector<lbool> _results;
+        vector<expr_ref_vector> _cores;
+        {
+            scoped_ctrl_c ctrlc(eh, false, use_ctrl_c);
+            scoped_timer timer(timeout, &eh);
+            scoped_rlimit _rlimit(m.limit(), rlimit);
+            try {
+                to_solver_ref(s)->check_sat_batch(sets, num_workers, _results, cores ? &_cores : nullptr);
+            }
+            catch (z3_exception & ex) {
+                to_solver_ref(s)->set_reason_unknown(eh);
+                to_solver(s)->set_eh(nullptr);
+                if (m.inc()) {
+                    mk_c(c)->handle_exception(ex);
+                }
+                return;
+            }
+        }
+        to_solver(s)->set_eh(nullptr);
+        for (unsigned i = 0; i < num_sets; i++) {
+            results[i] = static_cast<Z3_lbool>(_results[i]);
+            if (cores) {
+                expr_ref core(m.mk_true(), m);
+                if (_results[i] == l_false)
+                    core = ::mk_and(_cores[i]);
+                to_ast_vector_ref(cores).push_back(core);
+            }
+        }
+        Z3_CATCH;
+    }
+
+    static api::async_check * get_async_check(Z3_context c, Z3_solver s, unsigned h) {
+        auto & checks = to_solver(s)->m_async;
+        if (h >= checks.size() || !checks[h]) {
+            SET_ERROR_CODE(Z3_INVALID_ARG, "invalid handle of an asynchronous check");
+            return nullptr;
+        }
+        return checks[h];
+    }
+
+    static api::async_check * get_finished_async_check(Z3_context c, Z3_solver s, unsigned h) {
+        api::async_check * ac = get_async_check(c, s, h);
+        if (ac && !ac->finished()) {
+            SET_ERROR_CODE(Z3_INVALID_USAGE, "the asynchronous check has not finished");
+            return nullptr;
+        }
+        return ac;
+    }
+
+    unsigned Z3_API Z3_solver_check_async(Z3_context c, Z3_solver s,
+                                          unsigned num_assumptions, Z3_ast const assumptions[],
+                                          unsigned timeout, unsigned rlimit) {
+        Z3_TRY;
+        LOG_Z3_solver_check_async(c, s, num_assumptions, assumptions, timeout, rlimit);
+        RESET_ERROR_CODE();
+        init_solver(c, s);
+        for (unsigned i = 0; i < num_assumptions; i++) {
+            if (!is_expr(to_ast(assumptions[i]))) {
+                SET_ERROR_CODE(Z3_INVALID_ARG, "assumption is not an expression");
+                return UINT_MAX;
+            }
+        }
+        ast_manager & m = mk_c(c)->m();
+        scoped_ptr<api::async_check> ac = alloc(api::async_check, m);
+        // the copies are made by the calling thread, which owns the terms of m
+        ac->m_solver = to_solver_ref(s)->translate(ac->m, to_solver(s)->m_params);
+        ast_translation tr(m, ac->m);
+        for (unsigned i = 0; i < num_assumptions; i++)
+            ac->m_asms.push_back(tr(to_expr(assumptions[i])));
+        if (timeout != 0)
+            ac->m_timeout = timeout;
+        ac->m_rlimit = rlimit;
+        ac->m_solver->set_progress_callback(ac.get());
+        api::async_check * job = ac.get();
+#ifndef SINGLE_THREAD
+        ac->m_thread = std::thread([job]() { job->run(); });
+#else
+        job->run();
+#endif
+        auto & checks = to_solver(s)->m_async;
+        checks.push_back(ac.detach());
+        return checks.size() - 1;
+        Z3_CATCH_RETURN(UINT_MAX);
+    }
+
+    bool Z3_API Z3_solver_async_poll(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_poll(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_async_check(c, s, h);
+        return ac && ac->finished();
+        Z3_CATCH_RETURN(false);
+    }
+
+    Z3_lbool Z3_API Z3_solver_async_wait(Z3_context c, Z3_solver s, unsigned h, unsigned timeout) {
+        Z3_TRY;
+        LOG_Z3_solver_async_wait(c, s, h, timeout);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_async_check(c, s, h);
+        if (!ac || !ac->wait(timeout))
+            return Z3_L_UNDEF;
+        return static_cast<Z3_lbool>(ac->m_result);
+        Z3_CATCH_RETURN(Z3_L_UNDEF);
+    }
+
+    void Z3_API Z3_solver_async_cancel(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_cancel(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_async_check(c, s, h);
+        if (ac)
+            ac->m.limit().cancel();
+        Z3_CATCH;
+    }
+
+    Z3_stats Z3_API Z3_solver_async_get_statistics(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_get_statistics(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_async_check(c, s, h);
+        if (!ac)
+            RETURN_Z3(nullptr);
+        Z3_stats_ref * st = alloc(Z3_stats_ref, *mk_c(c));
+        {
+#ifndef SINGLE_THREAD
+            std::lock_guard<std::mutex> lock(ac->m_mux);
+#endif
+            st->m_stats.copy(ac->m_stats);
+        }
+        mk_c(c)->save_object(st);
+        Z3_stats r = of_stats(st);
+        RETURN_Z3(r);
+        Z3_CATCH_RETURN(nullptr);
+    }
+
+    Z3_model Z3_API Z3_solver_async_get_model(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_get_model(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_finished_async_check(c, s, h);
+        if (!ac)
+            RETURN_Z3(nullptr);
+        if (!ac->m_model) {
+            SET_ERROR_CODE(Z3_INVALID_USAGE, "there is no current model");
+            RETURN_Z3(nullptr);
+        }
+        ast_translation tr(ac->m, mk_c(c)->m());
+        Z3_model_ref * m_ref = alloc(Z3_model_ref, *mk_c(c));
+        m_ref->m_model = ac->m_model->translate(tr);
+        model_params mp(to_solver(s)->m_params);
+        if (mp.compact()) m_ref->m_model->compress();
+        mk_c(c)->save_object(m_ref);
+        RETURN_Z3(of_model(m_ref));
+        Z3_CATCH_RETURN(nullptr);
+    }
+
+    Z3_ast_vector Z3_API Z3_solver_async_get_unsat_core(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_get_unsat_core(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_finished_async_check(c, s, h);
+        if (!ac)
+            RETURN_Z3(nullptr);
+        if (ac->m_result != l_false) {
+            SET_ERROR_CODE(Z3_INVALID_USAGE, "the asynchronous check did not return unsat");
+            RETURN_Z3(nullptr);
+        }
+        ast_translation tr(ac->m, mk_c(c)->m());
+        Z3_ast_vector_ref * v = alloc(Z3_ast_vector_ref, *mk_c(c), mk_c(c)->m());
+        mk_c(c)->save_object(v);
+        for (expr* e : ac->m_core)
+            v->m_ast_vector.push_back(tr(e));
+        RETURN_Z3(of_ast_vector(v));
+        Z3_CATCH_RETURN(nullptr);
+    }
+
+    Z3_string Z3_API Z3_solver_async_get_reason_unknown(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_get_reason_unknown(c, s, h);
+        RESET_ERROR_CODE();
+        api::async_check * ac = get_finished_async_check(c, s, h);
+        if (!ac)
+            return "";
+        return mk_c(c)->mk_external_string(std::string(ac->m_reason_unknown));
+        Z3_CATCH_RETURN("");
+    }
+
+    void Z3_API Z3_solver_async_del(Z3_context c, Z3_solver s, unsigned h) {
+        Z3_TRY;
+        LOG_Z3_solver_async_del(c, s, h);
+        RESET_ERROR_CODE();
+        if (get_async_check(c, s, h))
+            to_solver(s)->m_async.set(h, nullptr);
+        Z3_CATCH;
+    }
+
     Z3_model Z3_API Z3_solver_get_model(Z3_context c, Z3_solver s) {
         Z3_TRY;
         LOG_Z3_solver_get_model(c, s);
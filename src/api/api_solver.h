@@ -18,6 +18,7 @@ Revision History:
 #pragma once
 
 #include "util/mutex.h"
+#include "util/scoped_ptr_vector.h"
 #include "api/api_util.h"
 #include "solver/solver.h"
 
@@ -38,6 +39,10 @@ struct solver2smt2_pp {
 
 };
 
+namespace api {
+    struct async_check;
+}
+
 struct Z3_solver_ref : public api::object {
     scoped_ptr<solver_factory> m_solver_factory;
     ref<solver>                m_solver;
@@ -48,6 +53,8 @@ struct Z3_solver_ref : public api::object {
     scoped_ptr<cmd_context>    m_cmd_context;
     mutex                      m_mux;
     event_handler*             m_eh;
+    // checks started by Z3_solver_check_async, indexed by their handles
+    scoped_ptr_vector<api::async_check> m_async;
 
     Z3_solver_ref(api::context& c, solver_factory * f): 
         api::object(c), m_solver_factory(f), m_solver(nullptr), m_logic(symbol::null), m_eh(nullptr) {}
@@ -55,6 +62,8 @@ struct Z3_solver_ref : public api::object {
     Z3_solver_ref(api::context& c, solver * s): 
         api::object(c), m_solver_factory(nullptr), m_solver(s), m_logic(symbol::null), m_eh(nullptr) {}
 
+    ~Z3_solver_ref() override;
+
     void assert_expr(expr* e);
     void assert_expr(expr* e, expr* t);
     void set_eh(event_handler* eh);
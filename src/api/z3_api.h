@@ -5934,6 +5934,30 @@ extern "C" {
 
     Z3_string Z3_API Z3_eval_smtlib2_string(Z3_context c, Z3_string str);
 
+    /**
+       \brief Write the given formulas to a file in a compact binary format.
+
+       The file stores the formulas as a table of shared nodes and can be loaded
+       with #Z3_deserialize_file without parsing, which is much faster than reading
+       SMT-LIB2 for large formulas. Floating point and algebraic numerals,
+       polymorphic and lambda declarations are not supported. Datatypes have to be
+       declared in the context that loads the file.
+
+       \returns \c false if the file cannot be written.
+
+       def_API('Z3_serialize_to_file', BOOL, (_in(CONTEXT), _in(AST_VECTOR), _in(STRING)))
+    */
+    bool Z3_API Z3_serialize_to_file(Z3_context c, Z3_ast_vector v, Z3_string file_name);
+
+    /**
+       \brief Load the formulas written by #Z3_serialize_to_file.
+
+       The file is mapped into memory when the platform supports it.
+
+       def_API('Z3_deserialize_file', AST_VECTOR, (_in(CONTEXT), _in(STRING)))
+    */
+    Z3_ast_vector Z3_API Z3_deserialize_file(Z3_context c, Z3_string file_name);
+
 
     /** 
        \brief Create a parser context.
@@ -7242,6 +7266,125 @@ extern "C" {
     Z3_lbool Z3_API Z3_solver_check_assumptions(Z3_context c, Z3_solver s,
                                                 unsigned num_assumptions, Z3_ast const assumptions[]);
 
+    /**
+       \brief Check the assertions in the given solver modulo each of the
+       given sets of assumptions.
+
+       Each element of \c assumption_sets is a conjunction of assumptions
+       (a single literal or an \c and of literals) and \c results[i] receives
+       the outcome of checking the assertions modulo \c assumption_sets[i].
+       If \c cores is not null, then for each set one formula is appended to
+       \c cores: the conjunction of an unsat core of the set if the result
+       is \c Z3_L_FALSE and \c true otherwise.
+
+       With \c num_workers at most one, the sets are checked one after another
+       on \c s, so that lemmas learned for one set are reused by the next ones.
+       Otherwise, the sets are distributed over \c num_workers copies of \c s
+       that are checked in parallel. A set that could not be decided, e.g.,
+       because of a timeout, gets \c Z3_L_UNDEF. Models are not retained.
+
+       \sa Z3_solver_check_assumptions
+
+       def_API('Z3_solver_check_assumptions_batch', VOID, (_in(CONTEXT), _in(SOLVER), _in(UINT), _in_array(2, AST), _in(UINT), _out_array(2, LBOOL), _in(AST_VECTOR)))
+    */
+    void Z3_API Z3_solver_check_assumptions_batch(Z3_context c, Z3_solver s,
+                                                  unsigned num_sets, Z3_ast const assumption_sets[],
+                                                  unsigned num_workers, Z3_lbool results[], Z3_ast_vector cores);
+
+    /**
+       \brief Start checking the assertions in the given solver modulo the given
+       assumptions without blocking the calling thread, and return a handle of the check.
+
+       The check runs in a background thread on a copy of \c s, so \c s and the
+       context can be used while it runs, and later changes to \c s do not affect it.
+       Unlike #Z3_interrupt, the check can be stopped with #Z3_solver_async_cancel
+       without affecting other checks of the context.
+
+       \c timeout (in milliseconds) and \c rlimit bound the resources of this check only,
+       \c 0 means no bound.
+
+       The handle is valid until #Z3_solver_async_del is called or \c s is deleted.
+
+       \sa Z3_solver_async_poll
+       \sa Z3_solver_async_wait
+       \sa Z3_solver_async_cancel
+       \sa Z3_solver_async_get_statistics
+
+       def_API('Z3_solver_check_async', UINT, (_in(CONTEXT), _in(SOLVER), _in(UINT), _in_array(2, AST), _in(UINT), _in(UINT)))
+    */
+    unsigned Z3_API Z3_solver_check_async(Z3_context c, Z3_solver s,
+                                          unsigned num_assumptions, Z3_ast const assumptions[],
+                                          unsigned timeout, unsigned rlimit);
+
+    /**
+       \brief Return true if the asynchronous check \c h has finished.
+
+       def_API('Z3_solver_async_poll', BOOL, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    bool Z3_API Z3_solver_async_poll(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Wait at most \c timeout milliseconds (\c UINT_MAX for no bound) for the
+       asynchronous check \c h to finish and return its result.
+
+       \c Z3_L_UNDEF is returned if the check was undecided or has not finished yet,
+       use #Z3_solver_async_poll to tell both apart.
+
+       def_API('Z3_solver_async_wait', LBOOL, (_in(CONTEXT), _in(SOLVER), _in(UINT), _in(UINT)))
+    */
+    Z3_lbool Z3_API Z3_solver_async_wait(Z3_context c, Z3_solver s, unsigned h, unsigned timeout);
+
+    /**
+       \brief Stop the asynchronous check \c h. It finishes with \c Z3_L_UNDEF unless it was
+       already decided.
+
+       def_API('Z3_solver_async_cancel', VOID, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    void Z3_API Z3_solver_async_cancel(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Return the statistics of the asynchronous check \c h.
+
+       While the check runs, these are the statistics of the last progress sample,
+       which the solver takes periodically during search (at most every 100ms);
+       the statistic \c async-progress-samples counts the samples, so that callers
+       polling the check can compute the deltas between two samples. Once the check
+       has finished, these are its final statistics.
+
+       def_API('Z3_solver_async_get_statistics', STATS, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    Z3_stats Z3_API Z3_solver_async_get_statistics(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Return the model of the finished asynchronous check \c h, which must have
+       returned \c Z3_L_TRUE.
+
+       def_API('Z3_solver_async_get_model', MODEL, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    Z3_model Z3_API Z3_solver_async_get_model(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Return the unsat core of the finished asynchronous check \c h, which must
+       have returned \c Z3_L_FALSE.
+
+       def_API('Z3_solver_async_get_unsat_core', AST_VECTOR, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    Z3_ast_vector Z3_API Z3_solver_async_get_unsat_core(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Return the reason why the finished asynchronous check \c h returned \c Z3_L_UNDEF.
+
+       def_API('Z3_solver_async_get_reason_unknown', STRING, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    Z3_string Z3_API Z3_solver_async_get_reason_unknown(Z3_context c, Z3_solver s, unsigned h);
+
+    /**
+       \brief Cancel the asynchronous check \c h if it still runs and release it.
+
+       def_API('Z3_solver_async_del', VOID, (_in(CONTEXT), _in(SOLVER), _in(UINT)))
+    */
+    void Z3_API Z3_solver_async_del(Z3_context c, Z3_solver s, unsigned h);
+
     /**
        \brief Retrieve congruence class representatives for terms.
 
@@ -22,6 +22,9 @@ Notes:
 #include "util/stream_buffer.h"
 #include "util/symbol.h"
 #include "util/trace.h"
+#include<algorithm>
+#include<chrono>
+#include<iomanip>
 #include<iostream>
 #include<sstream>
 #include<vector>
@@ -50,6 +53,18 @@ struct z3_replayer::imp {
     svector<z3_replayer_cmd> m_cmds;
     std::vector<std::string>      m_cmds_names;
 
+    // latencies of the calls of each command (recorded only if m_timing), bucket i of the histogram counts the
+    // calls that took less than 2^(i+1) microseconds (and at least 2^i for i > 0), the last one counts the rest
+    static const unsigned NUM_TIMING_BUCKETS = 24;
+    struct call_timing {
+        unsigned m_count = 0;
+        double   m_total = 0;
+        double   m_max = 0;
+        unsigned m_buckets[NUM_TIMING_BUCKETS] = {};
+    };
+    bool                     m_timing = false;
+    std::vector<call_timing> m_timings;
+
     enum value_kind { INT64, UINT64, DOUBLE, STRING, SYMBOL, OBJECT, UINT_ARRAY, INT_ARRAY, SYMBOL_ARRAY, OBJECT_ARRAY, FLOAT };
 
     char const* kind2string(value_kind k) const {
@@ -522,6 +537,7 @@ struct z3_replayer::imp {
                 unsigned idx = static_cast<unsigned>(m_uint64);
                 if (idx >= m_cmds.size())
                     throw z3_replayer_exception("invalid command");
+                auto start = std::chrono::steady_clock::now();
                 try {
                     TRACE("z3_replayer_cmd", tout << idx << ":" << m_cmds_names[idx] << "\n";);
                     m_cmds[idx](m_owner);
@@ -532,6 +548,8 @@ struct z3_replayer::imp {
                 catch (z3_exception & ex) {
                     std::cout << "[z3 exception]: " << ex.msg() << std::endl;
                 }
+                if (m_timing)
+                    record_timing(idx, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
                 break;
             }
             case '=':
@@ -693,6 +711,50 @@ struct z3_replayer::imp {
         m_result = obj;
     }
 
+    void record_timing(unsigned idx, double seconds) {
+        if (m_timings.size() <= idx)
+            m_timings.resize(idx + 1);
+        call_timing & t = m_timings[idx];
+        t.m_count++;
+        t.m_total += seconds;
+        t.m_max = std::max(t.m_max, seconds);
+        unsigned bucket = 0;
+        for (double us = seconds * 1000000; us >= 2 && bucket + 1 < NUM_TIMING_BUCKETS; us /= 2)
+            bucket++;
+        t.m_buckets[bucket]++;
+    }
+
+    void display_timing(std::ostream & out) const {
+        std::vector<unsigned> idxs;
+        for (unsigned idx = 0; idx < m_timings.size(); ++idx)
+            if (m_timings[idx].m_count > 0)
+                idxs.push_back(idx);
+        // the most expensive commands first
+        std::sort(idxs.begin(), idxs.end(), [&](unsigned i, unsigned j) { return m_timings[i].m_total > m_timings[j].m_total; });
+        out << "call                                      count    total (s)    mean (ms)     max (ms)\n";
+        for (unsigned idx : idxs) {
+            call_timing const & t = m_timings[idx];
+            out << std::left << std::setw(40) << m_cmds_names[idx] << std::right
+                << std::setw(7) << t.m_count << std::fixed << std::setprecision(3)
+                << std::setw(13) << t.m_total << std::setw(13) << t.m_total * 1000 / t.m_count
+                << std::setw(13) << t.m_max * 1000 << "\n";
+        }
+        // latency histograms of the check calls (e.g. Z3_solver_check, Z3_solver_check_assumptions)
+        for (unsigned idx : idxs) {
+            if (m_cmds_names[idx].find("check") == std::string::npos)
+                continue;
+            call_timing const & t = m_timings[idx];
+            out << "latency of " << m_cmds_names[idx] << ":\n";
+            for (unsigned b = 0; b < NUM_TIMING_BUCKETS; ++b) {
+                if (t.m_buckets[b] == 0)
+                    continue;
+                out << "  " << (b + 1 == NUM_TIMING_BUCKETS ? ">= " : "< ") << std::setw(10)
+                    << (1ull << (b + 1 == NUM_TIMING_BUCKETS ? b : b + 1)) << " us: " << t.m_buckets[b] << "\n";
+            }
+        }
+        out.unsetf(std::ios::floatfield);
+    }
+
     void register_cmd(unsigned id, z3_replayer_cmd cmd, char const* name) {
         m_cmds.reserve(id+1, 0);
         while (static_cast<unsigned>(m_cmds_names.size()) <= id+1) {
@@ -822,3 +884,11 @@ void z3_replayer::register_cmd(unsigned id, z3_replayer_cmd cmd, char const* nam
 void z3_replayer::parse() {
     return m_imp->parse();
 }
+
+void z3_replayer::set_timing(bool f) {
+    m_imp->m_timing = f;
+}
+
+void z3_replayer::display_timing(std::ostream & out) const {
+    m_imp->display_timing(out);
+}
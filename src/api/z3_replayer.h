@@ -34,6 +34,9 @@ public:
     z3_replayer(std::istream & in);
     ~z3_replayer();
     void parse();
+    // record the latency of each call of the log (displayed by display_timing)
+    void set_timing(bool f);
+    void display_timing(std::ostream & out) const;
     unsigned get_line() const;
 
     int get_int(unsigned pos) const;
@@ -0,0 +1,708 @@
+/*++
+
+Module Name:
+
+    ast_serialize.cpp
+
+Abstract:
+
+    Compact binary serialization of expressions.
+
+Notes:
+
+    Layout (all integers are LEB128 varints, signed ones zig-zag encoded):
+
+      magic (8 bytes) version
+      num_symbols   { tag [length bytes | number] }
+      num_families  { length bytes }
+      num_nodes     { node }
+      num_roots     { node }
+
+    A node starts with its ast_kind, followed by
+      sort:        name tag [family kind] [params]
+      func_decl:   name arity domain range tag [family kind flags params]
+      app:         decl num_args args
+      var:         index sort
+      quantifier:  kind num_decls { name sort } body weight qid skid
+                   num_patterns patterns num_no_patterns no_patterns
+
+--*/
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#if !defined(_WINDOWS) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "util/map.h"
+#include "util/obj_hashtable.h"
+#include "ast/ast_serialize.h"
+
+namespace {
+
+    char const SERIALIZE_MAGIC[8] = { 'Z', '3', 'A', 'S', 'T', 'B', 'I', 'N' };
+    unsigned const SERIALIZE_VERSION = 1;
+
+    enum symbol_tag { SYM_NULL, SYM_STRING, SYM_NUMERICAL };
+
+    // kinds of sort and declaration infos
+    enum info_tag { INFO_NONE, INFO_USER_SORT, INFO_BUILTIN, INFO_USER_DECL };
+
+    enum decl_flag {
+        FLAG_LEFT_ASSOC  = 1 << 0,
+        FLAG_RIGHT_ASSOC = 1 << 1,
+        FLAG_FLAT_ASSOC  = 1 << 2,
+        FLAG_COMMUTATIVE = 1 << 3,
+        FLAG_CHAINABLE   = 1 << 4,
+        FLAG_PAIRWISE    = 1 << 5,
+        FLAG_INJECTIVE   = 1 << 6,
+        FLAG_IDEMPOTENT  = 1 << 7,
+        FLAG_SKOLEM      = 1 << 8
+    };
+
+    class writer {
+        typedef map<symbol, unsigned, symbol_hash_proc, symbol_eq_proc> symbol2idx;
+
+        ast_manager &          m;
+        std::string            m_nodes;
+        unsigned               m_num_nodes = 0;
+        obj_map<ast, unsigned> m_ids;
+        symbol2idx             m_symbol2idx;
+        svector<symbol>        m_symbols;
+        u_map<unsigned>        m_family2idx;
+        svector<family_id>     m_families;
+        ptr_vector<ast>        m_todo;
+
+        static void put_uint(std::string & out, uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        void put_uint(uint64_t v) { put_uint(m_nodes, v); }
+
+        void put_int(int64_t v) { put_uint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+
+        void put_string(std::string const & s) {
+            put_uint(s.size());
+            m_nodes += s;
+        }
+
+        void put_symbol(symbol const & s) {
+            unsigned idx;
+            if (!m_symbol2idx.find(s, idx)) {
+                idx = m_symbols.size();
+                m_symbols.push_back(s);
+                m_symbol2idx.insert(s, idx);
+            }
+            put_uint(idx);
+        }
+
+        void put_family(family_id fid) {
+            unsigned idx;
+            if (!m_family2idx.find(fid, idx)) {
+                idx = m_families.size();
+                m_families.push_back(fid);
+                m_family2idx.insert(fid, idx);
+            }
+            put_uint(idx);
+        }
+
+        void put_node(ast * n) { put_uint(m_ids[n]); }
+
+        void put_parameters(decl * d) {
+            put_uint(d->get_num_parameters());
+            for (parameter const & p : d->parameters()) {
+                put_uint(p.get_kind());
+                switch (p.get_kind()) {
+                case parameter::PARAM_INT:
+                    put_int(p.get_int());
+                    break;
+                case parameter::PARAM_AST:
+                    put_node(p.get_ast());
+                    break;
+                case parameter::PARAM_SYMBOL:
+                    put_symbol(p.get_symbol());
+                    break;
+                case parameter::PARAM_ZSTRING: {
+                    zstring const & s = p.get_zstring();
+                    put_uint(s.length());
+                    for (unsigned i = 0; i < s.length(); ++i)
+                        put_uint(s[i]);
+                    break;
+                }
+                case parameter::PARAM_RATIONAL:
+                    put_string(p.get_rational().to_string());
+                    break;
+                case parameter::PARAM_DOUBLE: {
+                    double d = p.get_double();
+                    uint64_t bits;
+                    memcpy(&bits, &d, sizeof(bits));
+                    put_uint(bits);
+                    break;
+                }
+                default:
+                    throw default_exception("binary serialization does not support external parameters of " + d->get_name().str());
+                }
+            }
+        }
+
+        void visit(ast * n) {
+            if (!m_ids.contains(n))
+                m_todo.push_back(n);
+        }
+
+        void visit_parameters(decl * d) {
+            for (parameter const & p : d->parameters())
+                if (p.is_ast())
+                    visit(p.get_ast());
+        }
+
+        void visit_children(ast * n) {
+            switch (n->get_kind()) {
+            case AST_SORT:
+                visit_parameters(to_sort(n));
+                break;
+            case AST_FUNC_DECL: {
+                func_decl * f = to_func_decl(n);
+                visit_parameters(f);
+                for (sort * s : *f)
+                    visit(s);
+                visit(f->get_range());
+                break;
+            }
+            case AST_APP:
+                visit(to_app(n)->get_decl());
+                for (expr * arg : *to_app(n))
+                    visit(arg);
+                break;
+            case AST_VAR:
+                visit(to_var(n)->get_sort());
+                break;
+            case AST_QUANTIFIER: {
+                quantifier * q = to_quantifier(n);
+                for (unsigned i = 0; i < q->get_num_decls(); ++i)
+                    visit(q->get_decl_sort(i));
+                visit(q->get_expr());
+                for (unsigned i = 0; i < q->get_num_patterns(); ++i)
+                    visit(q->get_pattern(i));
+                for (unsigned i = 0; i < q->get_num_no_patterns(); ++i)
+                    visit(q->get_no_pattern(i));
+                break;
+            }
+            default:
+                UNREACHABLE();
+            }
+        }
+
+        void write_sort(sort * s) {
+            put_symbol(s->get_name());
+            sort_info * info = s->get_info();
+            if (info == nullptr) {
+                put_uint(INFO_NONE);
+                return;
+            }
+            if (info->get_family_id() == user_sort_family_id) {
+                put_uint(INFO_USER_SORT);
+                put_parameters(s);
+                return;
+            }
+            if (s->is_type_var())
+                throw default_exception("binary serialization does not support type variables");
+            put_uint(INFO_BUILTIN);
+            put_family(info->get_family_id());
+            put_int(info->get_decl_kind());
+            put_parameters(s);
+        }
+
+        void write_func_decl(func_decl * f) {
+            put_symbol(f->get_name());
+            put_uint(f->get_arity());
+            for (sort * s : *f)
+                put_node(s);
+            put_node(f->get_range());
+            func_decl_info * info = f->get_info();
+            if (info == nullptr) {
+                put_uint(INFO_NONE);
+                return;
+            }
+            if (f->is_polymorphic() || info->is_lambda())
+                throw default_exception("binary serialization does not support the declaration " + f->get_name().str());
+            bool builtin = info->get_family_id() != null_family_id;
+            put_uint(builtin ? INFO_BUILTIN : INFO_USER_DECL);
+            if (builtin) {
+                put_family(info->get_family_id());
+                put_int(info->get_decl_kind());
+            }
+            unsigned flags = 0;
+            if (info->is_left_associative()) flags |= FLAG_LEFT_ASSOC;
+            if (info->is_right_associative()) flags |= FLAG_RIGHT_ASSOC;
+            if (info->is_flat_associative()) flags |= FLAG_FLAT_ASSOC;
+            if (info->is_commutative()) flags |= FLAG_COMMUTATIVE;
+            if (info->is_chainable()) flags |= FLAG_CHAINABLE;
+            if (info->is_pairwise()) flags |= FLAG_PAIRWISE;
+            if (info->is_injective()) flags |= FLAG_INJECTIVE;
+            if (info->is_idempotent()) flags |= FLAG_IDEMPOTENT;
+            if (info->is_skolem()) flags |= FLAG_SKOLEM;
+            put_uint(flags);
+            put_parameters(f);
+        }
+
+        void write_node(ast * n) {
+            put_uint(n->get_kind());
+            switch (n->get_kind()) {
+            case AST_SORT:
+                write_sort(to_sort(n));
+                break;
+            case AST_FUNC_DECL:
+                write_func_decl(to_func_decl(n));
+                break;
+            case AST_APP:
+                put_node(to_app(n)->get_decl());
+                put_uint(to_app(n)->get_num_args());
+                for (expr * arg : *to_app(n))
+                    put_node(arg);
+                break;
+            case AST_VAR:
+                put_uint(to_var(n)->get_idx());
+                put_node(to_var(n)->get_sort());
+                break;
+            case AST_QUANTIFIER: {
+                quantifier * q = to_quantifier(n);
+                put_uint(q->get_kind());
+                put_uint(q->get_num_decls());
+                for (unsigned i = 0; i < q->get_num_decls(); ++i) {
+                    put_symbol(q->get_decl_name(i));
+                    put_node(q->get_decl_sort(i));
+                }
+                put_node(q->get_expr());
+                put_int(q->get_weight());
+                put_symbol(q->get_qid());
+                put_symbol(q->get_skid());
+                put_uint(q->get_num_patterns());
+                for (unsigned i = 0; i < q->get_num_patterns(); ++i)
+                    put_node(q->get_pattern(i));
+                put_uint(q->get_num_no_patterns());
+                for (unsigned i = 0; i < q->get_num_no_patterns(); ++i)
+                    put_node(q->get_no_pattern(i));
+                break;
+            }
+            default:
+                UNREACHABLE();
+            }
+            m_ids.insert(n, m_num_nodes++);
+        }
+
+        void add(ast * root) {
+            visit(root);
+            while (!m_todo.empty()) {
+                ast * n = m_todo.back();
+                if (m_ids.contains(n)) {
+                    m_todo.pop_back();
+                    continue;
+                }
+                unsigned sz = m_todo.size();
+                visit_children(n);
+                if (sz == m_todo.size()) {
+                    m_todo.pop_back();
+                    write_node(n);
+                }
+            }
+        }
+
+    public:
+        writer(ast_manager & m): m(m) {}
+
+        void operator()(unsigned n, expr * const * es, std::ostream & out) {
+            for (unsigned i = 0; i < n; ++i)
+                add(es[i]);
+            std::string header(SERIALIZE_MAGIC, sizeof(SERIALIZE_MAGIC));
+            put_uint(header, SERIALIZE_VERSION);
+            put_uint(header, m_symbols.size());
+            for (symbol const & s : m_symbols) {
+                if (s.is_null())
+                    put_uint(header, SYM_NULL);
+                else if (s.is_numerical()) {
+                    put_uint(header, SYM_NUMERICAL);
+                    put_uint(header, s.get_num());
+                }
+                else {
+                    put_uint(header, SYM_STRING);
+                    size_t len = strlen(s.bare_str());
+                    put_uint(header, len);
+                    header.append(s.bare_str(), len);
+                }
+            }
+            put_uint(header, m_families.size());
+            std::string families;
+            for (family_id fid : m_families) {
+                std::string const name = m.get_family_name(fid).str();
+                put_uint(families, name.size());
+                families += name;
+            }
+            put_uint(families, m_num_nodes);
+            out.write(header.data(), header.size());
+            out.write(families.data(), families.size());
+            out.write(m_nodes.data(), m_nodes.size());
+            std::string roots;
+            put_uint(roots, n);
+            for (unsigned i = 0; i < n; ++i)
+                put_uint(roots, m_ids[es[i]]);
+            out.write(roots.data(), roots.size());
+        }
+    };
+
+    class reader {
+        ast_manager &      m;
+        char const *       m_curr;
+        char const *       m_end;
+        svector<symbol>    m_symbols;
+        svector<family_id> m_families;
+        ast_ref_vector     m_nodes;
+
+        [[noreturn]] static void malformed() {
+            throw default_exception("malformed binary expression data");
+        }
+
+        uint64_t get_uint() {
+            uint64_t r = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                if (m_curr == m_end)
+                    malformed();
+                uint64_t b = static_cast<unsigned char>(*m_curr++);
+                r |= (b & 0x7f) << shift;
+                if ((b & 0x80) == 0)
+                    return r;
+            }
+            malformed();
+        }
+
+        unsigned get_unsigned() {
+            uint64_t r = get_uint();
+            if (r > UINT_MAX)
+                malformed();
+            return static_cast<unsigned>(r);
+        }
+
+        int64_t get_int64() {
+            uint64_t r = get_uint();
+            return static_cast<int64_t>(r >> 1) ^ -static_cast<int64_t>(r & 1);
+        }
+
+        int get_int() {
+            int64_t r = get_int64();
+            if (r < INT_MIN || r > INT_MAX)
+                malformed();
+            return static_cast<int>(r);
+        }
+
+        // number of items of at least one byte each that can follow
+        unsigned get_count() {
+            uint64_t r = get_uint();
+            if (r > static_cast<uint64_t>(m_end - m_curr))
+                malformed();
+            return static_cast<unsigned>(r);
+        }
+
+        std::string get_string() {
+            unsigned len = get_count();
+            std::string r(m_curr, len);
+            m_curr += len;
+            return r;
+        }
+
+        symbol get_symbol() {
+            uint64_t idx = get_uint();
+            if (idx >= m_symbols.size())
+                malformed();
+            return m_symbols[static_cast<unsigned>(idx)];
+        }
+
+        family_id get_family() {
+            uint64_t idx = get_uint();
+            if (idx >= m_families.size())
+                malformed();
+            return m_families[static_cast<unsigned>(idx)];
+        }
+
+        ast * get_node() {
+            uint64_t idx = get_uint();
+            if (idx >= m_nodes.size())
+                malformed();
+            return m_nodes.get(static_cast<unsigned>(idx));
+        }
+
+        sort * get_sort() {
+            ast * n = get_node();
+            if (n->get_kind() != AST_SORT)
+                malformed();
+            return to_sort(n);
+        }
+
+        expr * get_expr() {
+            ast * n = get_node();
+            if (!is_expr(n))
+                malformed();
+            return to_expr(n);
+        }
+
+        void get_parameters(vector<parameter> & ps) {
+            unsigned n = get_count();
+            for (unsigned i = 0; i < n; ++i) {
+                switch (get_uint()) {
+                case parameter::PARAM_INT:
+                    ps.push_back(parameter(get_int()));
+                    break;
+                case parameter::PARAM_AST:
+                    ps.push_back(parameter(get_node()));
+                    break;
+                case parameter::PARAM_SYMBOL:
+                    ps.push_back(parameter(get_symbol()));
+                    break;
+                case parameter::PARAM_ZSTRING: {
+                    unsigned len = get_count();
+                    unsigned_vector chars;
+                    for (unsigned j = 0; j < len; ++j) {
+                        unsigned ch = get_unsigned();
+                        if (ch > zstring::max_char())
+                            malformed();
+                        chars.push_back(ch);
+                    }
+                    ps.push_back(parameter(zstring(len, chars.data())));
+                    break;
+                }
+                case parameter::PARAM_RATIONAL:
+                    ps.push_back(parameter(rational(get_string().c_str())));
+                    break;
+                case parameter::PARAM_DOUBLE: {
+                    uint64_t bits = get_uint();
+                    double d;
+                    memcpy(&d, &bits, sizeof(d));
+                    ps.push_back(parameter(d));
+                    break;
+                }
+                default:
+                    malformed();
+                }
+            }
+        }
+
+        sort * read_sort() {
+            symbol name = get_symbol();
+            vector<parameter> ps;
+            switch (get_uint()) {
+            case INFO_NONE:
+                return m.mk_uninterpreted_sort(name);
+            case INFO_USER_SORT:
+                get_parameters(ps);
+                return m.mk_uninterpreted_sort(name, ps.size(), ps.data());
+            case INFO_BUILTIN: {
+                family_id fid = get_family();
+                decl_kind k = get_int();
+                get_parameters(ps);
+                // the plugin recomputes the size and the private parameters of the sort
+                return m.mk_sort(fid, k, ps.size(), ps.data());
+            }
+            default:
+                malformed();
+            }
+        }
+
+        func_decl * read_func_decl() {
+            symbol name = get_symbol();
+            unsigned arity = get_count();
+            ptr_buffer<sort> domain;
+            for (unsigned i = 0; i < arity; ++i)
+                domain.push_back(get_sort());
+            sort * range = get_sort();
+            unsigned tag = get_unsigned();
+            if (tag == INFO_NONE)
+                return m.mk_func_decl(name, arity, domain.data(), range);
+            if (tag != INFO_BUILTIN && tag != INFO_USER_DECL)
+                malformed();
+            family_id fid = null_family_id;
+            decl_kind k = null_decl_kind;
+            if (tag == INFO_BUILTIN) {
+                fid = get_family();
+                k = get_int();
+            }
+            unsigned flags = get_unsigned();
+            vector<parameter> ps;
+            get_parameters(ps);
+            if (tag == INFO_BUILTIN) {
+                func_decl * f = m.mk_func_decl(fid, k, ps.size(), ps.data(), arity, domain.data(), range);
+                if (f == nullptr)
+                    malformed();
+                return f;
+            }
+            func_decl_info info(null_family_id, null_decl_kind, ps.size(), ps.data());
+            info.set_left_associative((flags & FLAG_LEFT_ASSOC) != 0);
+            info.set_right_associative((flags & FLAG_RIGHT_ASSOC) != 0);
+            info.set_flat_associative((flags & FLAG_FLAT_ASSOC) != 0);
+            info.set_commutative((flags & FLAG_COMMUTATIVE) != 0);
+            info.set_chainable((flags & FLAG_CHAINABLE) != 0);
+            info.set_pairwise((flags & FLAG_PAIRWISE) != 0);
+            info.set_injective((flags & FLAG_INJECTIVE) != 0);
+            info.set_idempotent((flags & FLAG_IDEMPOTENT) != 0);
+            info.set_skolem((flags & FLAG_SKOLEM) != 0);
+            return m.mk_func_decl(name, arity, domain.data(), range, info);
+        }
+
+        app * read_app() {
+            ast * d = get_node();
+            if (d->get_kind() != AST_FUNC_DECL)
+                malformed();
+            unsigned num_args = get_count();
+            ptr_buffer<expr> args;
+            for (unsigned i = 0; i < num_args; ++i)
+                args.push_back(get_expr());
+            return m.mk_app(to_func_decl(d), num_args, args.data());
+        }
+
+        quantifier * read_quantifier() {
+            unsigned k = get_unsigned();
+            if (k != forall_k && k != exists_k && k != lambda_k)
+                malformed();
+            unsigned num_decls = get_count();
+            if (num_decls == 0)
+                malformed();
+            buffer<symbol> names;
+            ptr_buffer<sort> sorts;
+            for (unsigned i = 0; i < num_decls; ++i) {
+                names.push_back(get_symbol());
+                sorts.push_back(get_sort());
+            }
+            expr * body = get_expr();
+            int weight = get_int();
+            symbol qid = get_symbol();
+            symbol skid = get_symbol();
+            ptr_buffer<expr> patterns, no_patterns;
+            unsigned num_patterns = get_count();
+            for (unsigned i = 0; i < num_patterns; ++i) {
+                patterns.push_back(get_expr());
+                if (!m.is_pattern(patterns.back()))
+                    malformed();
+            }
+            unsigned num_no_patterns = get_count();
+            for (unsigned i = 0; i < num_no_patterns; ++i)
+                no_patterns.push_back(get_expr());
+            if (k == lambda_k)
+                return m.mk_lambda(num_decls, sorts.data(), names.data(), body);
+            return m.mk_quantifier(static_cast<quantifier_kind>(k), num_decls, sorts.data(), names.data(), body, weight, qid, skid,
+                                   num_patterns, patterns.data(), num_no_patterns, no_patterns.data());
+        }
+
+        ast * read_node() {
+            switch (get_uint()) {
+            case AST_SORT:       return read_sort();
+            case AST_FUNC_DECL:  return read_func_decl();
+            case AST_APP:        return read_app();
+            case AST_VAR: {
+                unsigned idx = get_unsigned();
+                return m.mk_var(idx, get_sort());
+            }
+            case AST_QUANTIFIER: return read_quantifier();
+            default:
+                malformed();
+            }
+        }
+
+    public:
+        reader(ast_manager & m, char const * data, size_t size): m(m), m_curr(data), m_end(data + size), m_nodes(m) {}
+
+        void operator()(expr_ref_vector & result) {
+            if (static_cast<size_t>(m_end - m_curr) < sizeof(SERIALIZE_MAGIC) || memcmp(m_curr, SERIALIZE_MAGIC, sizeof(SERIALIZE_MAGIC)) != 0)
+                throw default_exception("data is not a binary expression file");
+            m_curr += sizeof(SERIALIZE_MAGIC);
+            if (get_uint() != SERIALIZE_VERSION)
+                throw default_exception("unsupported version of a binary expression file");
+            unsigned num_symbols = get_count();
+            for (unsigned i = 0; i < num_symbols; ++i) {
+                switch (get_uint()) {
+                case SYM_NULL:
+                    m_symbols.push_back(symbol::null);
+                    break;
+                case SYM_NUMERICAL:
+                    m_symbols.push_back(symbol(get_unsigned()));
+                    break;
+                case SYM_STRING:
+                    m_symbols.push_back(symbol(get_string().c_str()));
+                    break;
+                default:
+                    malformed();
+                }
+            }
+            unsigned num_families = get_count();
+            for (unsigned i = 0; i < num_families; ++i) {
+                std::string name = get_string();
+                symbol s(name.c_str());
+                if (!m.has_plugin(s))
+                    throw default_exception("binary expression file uses the unknown theory " + name);
+                m_families.push_back(m.get_family_id(s));
+            }
+            unsigned num_nodes = get_count();
+            for (unsigned i = 0; i < num_nodes; ++i)
+                m_nodes.push_back(read_node());
+            unsigned num_roots = get_count();
+            for (unsigned i = 0; i < num_roots; ++i)
+                result.push_back(get_expr());
+        }
+    };
+}
+
+void serialize_exprs(ast_manager & m, unsigned n, expr * const * es, std::ostream & out) {
+    writer w(m);
+    w(n, es, out);
+}
+
+void deserialize_exprs(ast_manager & m, char const * data, size_t size, expr_ref_vector & result) {
+    reader r(m, data, size);
+    r(result);
+}
+
+bool deserialize_exprs_from_file(ast_manager & m, char const * file_name, expr_ref_vector & result) {
+#if !defined(_WINDOWS) && !defined(_WIN32)
+    int fd = ::open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (file_stat.st_size == 0) {
+        ::close(fd);
+        deserialize_exprs(m, nullptr, 0, result);
+        return true;
+    }
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void * data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    try {
+        deserialize_exprs(m, static_cast<char const *>(data), size, result);
+    }
+    catch (...) {
+        munmap(data, size);
+        throw;
+    }
+    munmap(data, size);
+    return true;
+#else
+    std::ifstream in(file_name, std::ios::binary);
+    if (!in)
+        return false;
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    deserialize_exprs(m, data.data(), data.size(), result);
+    return true;
+#endif
+}
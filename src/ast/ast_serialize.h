@@ -0,0 +1,47 @@
+/*++
+
+Module Name:
+
+    ast_serialize.h
+
+Abstract:
+
+    Compact binary serialization of expressions.
+
+Notes:
+
+    The format stores a symbol table, the names of the used theory
+    families and the DAG of the expressions as a table of nodes in
+    topological order: sorts, declarations and expressions refer to
+    their children by (varint encoded) indices of earlier nodes.
+    Loading is a single pass over the table without any parsing or
+    type inference beyond what the ast_manager does when rebuilding the
+    nodes, and it reads directly from a memory buffer, so a file can be
+    mapped into memory and shared by several processes.
+
+    Parameters external to a decl_plugin (e.g., floating point or
+    algebraic numerals), polymorphic and lambda declarations are not
+    supported.
+
+--*/
+#pragma once
+
+#include <ostream>
+#include "ast/ast.h"
+
+/**
+   \brief Write the expressions es[0], ..., es[n-1] to out.
+*/
+void serialize_exprs(ast_manager & m, unsigned n, expr * const * es, std::ostream & out);
+
+/**
+   \brief Append the expressions stored in data[0], ..., data[size-1] to result.
+   Throws a default_exception if the data is malformed.
+*/
+void deserialize_exprs(ast_manager & m, char const * data, size_t size, expr_ref_vector & result);
+
+/**
+   \brief Append the expressions stored in the file to result.
+   Return false if the file cannot be opened.
+*/
+bool deserialize_exprs_from_file(ast_manager & m, char const * file_name, expr_ref_vector & result);
@@ -6120,29 +6120,39 @@ bool seq_rewriter::reduce_subsequence(expr_ref_vector& ls, expr_ref_vector& rs,
 } 
 
 seq_rewriter::op_cache::op_cache(ast_manager& m):
-    m_trail(m)
+    m_trail(m),
+    m_old_trail(m)
 {}
 
 expr* seq_rewriter::op_cache::find(decl_kind op, expr* a, expr* b, expr* c) {
     op_entry e(op, a, b, c, nullptr);
-    m_table.find(e, e);
-
+    if (m_table.find(e, e))
+        return e.r;
+    if (m_old_table.find(e, e)) 
+        // the young generation may grow past m_max_cache_size here, it is trimmed by the next insert
+        add(e);
     return e.r;
 }
 
 void seq_rewriter::op_cache::insert(decl_kind op, expr* a, expr* b, expr* c, expr* r) {
     cleanup();
-    if (a) m_trail.push_back(a);
-    if (b) m_trail.push_back(b);
-    if (c) m_trail.push_back(c);
-    if (r) m_trail.push_back(r);
-    m_table.insert(op_entry(op, a, b, c, r));
+    add(op_entry(op, a, b, c, r));
+}
+
+void seq_rewriter::op_cache::add(op_entry const& e) {
+    if (e.a) m_trail.push_back(e.a);
+    if (e.b) m_trail.push_back(e.b);
+    if (e.c) m_trail.push_back(e.c);
+    if (e.r) m_trail.push_back(e.r);
+    m_table.insert(e);
 }
 
 void seq_rewriter::op_cache::cleanup() {
     if (m_table.size() >= m_max_cache_size) {
-        m_trail.reset();
-        m_table.reset();
+        m_old_trail.reset();
+        m_old_table.reset();
+        m_old_trail.swap(m_trail);
+        m_old_table.swap(m_table);
         STRACE("seq_regex", tout << "Op cache reset!" << std::endl;);
         STRACE("seq_regex_brief", tout << "(OP CACHE RESET) ";);
         STRACE("seq_verbose", tout << "Derivative op cache reset" << std::endl;);
@@ -136,10 +136,16 @@ class seq_rewriter {
 
         typedef hashtable<op_entry, hash_entry, eq_entry> op_table;
 
-        unsigned        m_max_cache_size { 10000 };
+        // Entries are kept in two generations. When the young generation is full, the old one is dropped
+        // and the young one becomes old. Entries found in the old generation are moved back to the young one,
+        // so derivatives that are used again survive the eviction, as with an LRU cache.
+        unsigned        m_max_cache_size { 5000 };
         expr_ref_vector m_trail;
         op_table        m_table;
+        expr_ref_vector m_old_trail;
+        op_table        m_old_table;
         void cleanup();
+        void add(op_entry const& e);
 
     public:
         op_cache(ast_manager& m);
@@ -58,14 +58,19 @@ namespace euf {
         m_ff = m_egraph.mk(m.mk_false(), 0, 0, nullptr);
         m_rewriter.set_order_eq(true);
         m_rewriter.set_flat_and_or(false);
+        std::function<void(enode*, enode*)> on_merge = [&](enode* root, enode* other) {
+            m_changed.push_back(root);
+            m_changed.push_back(other);
+        };
+        m_egraph.set_on_merge(on_merge);
     }
 
     void completion::reduce() {
         m_has_new_eq = true;
         for (unsigned rounds = 0; m_has_new_eq && rounds <= 3 && !m_fmls.inconsistent(); ++rounds) {
-            ++m_epoch;
             m_has_new_eq = false;
             add_egraph();
+            invalidate();
             map_canonical();
             read_egraph();
             IF_VERBOSE(11, verbose_stream() << "(euf.completion :rounds " << rounds << ")\n");
@@ -104,6 +109,28 @@ namespace euf {
         m_egraph.propagate();
     }
 
+    /**
+     * The canonical forms are kept across rounds and increments. 
+     * A merge changes the canonical form of the merged class and of all terms that
+     * contain a term of the class, so these are invalidated and canonized again.
+     * The canonical forms of the other classes are reused.
+     */
+    void completion::invalidate() {
+        TRACE("euf_completion", tout << "merged " << m_changed.size() << "\n");
+        for (unsigned i = 0; i < m_changed.size(); ++i) {
+            enode* n = m_changed[i];
+            if (m_epochs.get(n->get_id(), 0) != m_epoch)
+                continue;
+            m_epochs[n->get_id()] = 0;
+            m_nodes_to_canonize.push_back(n->get_root());
+            for (enode* k : enode_class(n))
+                for (enode* p : enode_parents(k))
+                    m_changed.push_back(p->get_root());
+        }
+        TRACE("euf_completion", tout << "invalidated " << m_changed.size() << "\n");
+        m_changed.reset();
+    }
+
     void completion::read_egraph() {
 
         if (m_egraph.inconsistent()) {
@@ -338,12 +365,13 @@ namespace euf {
     }
 
     void completion::collect_statistics(statistics& st) const {
-        st.update("euf-completion-rewrites", m_stats.m_num_rewrites);        
+        st.update("euf-completion-rewrites", m_stats.m_num_rewrites);
+        st.update("euf-completion-reused", m_stats.m_num_reused);
     }
 
     void completion::map_canonical() {
         m_todo.reset();
-        enode_vector roots;
+        enode_vector roots, reused;
         if (m_nodes_to_canonize.empty())
             return;
         for (unsigned i = 0; i < m_nodes_to_canonize.size(); ++i) {
@@ -351,6 +379,11 @@ namespace euf {
             if (n->is_marked1())
                 continue;
             n->mark1();
+            if (get_canonical(n)) {
+                m_stats.m_num_reused++;
+                reused.push_back(n);
+                continue;
+            }
             roots.push_back(n);
             enode* rep = nullptr;
             for (enode* k : enode_class(n)) 
@@ -369,6 +402,8 @@ namespace euf {
         }
         for (enode* r : roots)
             r->unmark1();
+        for (enode* r : reused)
+            r->unmark1();
 
         // explain dependencies when no nodes are marked.
         // explain_eq uses both mark1 and mark2 on e-nodes so 
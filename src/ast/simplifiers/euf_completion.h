@@ -27,16 +27,18 @@ namespace euf {
 
         struct stats {
             unsigned m_num_rewrites = 0;
+            unsigned m_num_reused = 0;
             void reset() { memset(this, 0, sizeof(*this)); }
         };
 
         egraph                 m_egraph;
         enode*                 m_tt, *m_ff;
         ptr_vector<expr>       m_todo;
-        enode_vector           m_args, m_reps, m_nodes_to_canonize;
+        enode_vector           m_args, m_reps, m_nodes_to_canonize, m_changed;
         expr_ref_vector        m_canonical, m_eargs;
         expr_dependency_ref_vector m_deps;
-        unsigned               m_epoch = 0;
+        // m_canonical[id] is valid if m_epochs[id] == m_epoch, invalidated entries are set to 0
+        unsigned               m_epoch = 1;
         unsigned_vector        m_epochs;
         th_rewriter            m_rewriter;
         stats                  m_stats;
@@ -47,6 +49,7 @@ namespace euf {
         void update_has_new_eq(expr* g);
         expr_ref mk_and(expr* a, expr* b);
         void add_egraph();
+        void invalidate();
         void map_canonical();
         void read_egraph();
         expr_ref canonize(expr* f, expr_dependency_ref& dep);
@@ -60,7 +63,7 @@ namespace euf {
         completion(ast_manager& m, dependent_expr_state& fmls);
         char const* name() const override { return "euf-reduce"; }
         void push() override { m_egraph.push(); dependent_expr_simplifier::push(); }
-        void pop(unsigned n) override { dependent_expr_simplifier::pop(n); m_egraph.pop(n); }
+        void pop(unsigned n) override { dependent_expr_simplifier::pop(n); m_egraph.pop(n); m_changed.reset(); ++m_epoch; }
         void reduce() override;
         void collect_statistics(statistics& st) const override;
         void reset_statistics() override { m_stats.reset(); }
@@ -0,0 +1,283 @@
+/*++
+
+Module Name:
+
+    seq_eq_simplifier.cpp
+
+Abstract:
+
+    simplifier for top-level string equations
+
+--*/
+
+#include "params/tactic_params.hpp"
+#include "ast/ast_util.h"
+#include "ast/rewriter/expr_replacer.h"
+#include "ast/simplifiers/seq_eq_simplifier.h"
+
+seq_eq_simplifier::seq_eq_simplifier(ast_manager& m, params_ref const& p, dependent_expr_state& fmls):
+    dependent_expr_simplifier(m, fmls),
+    m_util(m),
+    m_rewriter(m),
+    m_lhs(m),
+    m_rhs(m),
+    m_deps(m) {
+    m_rewriter.set_flat_and_or(false);
+    updt_params(p);
+}
+
+bool seq_eq_simplifier::is_string_eq(expr* f, expr*& x, expr*& y) const {
+    return m.is_eq(f, x, y) && m_util.is_string(x->get_sort());
+}
+
+void seq_eq_simplifier::get_concats(expr* e, expr_ref_vector& es) {
+    ptr_buffer<expr> todo;
+    todo.push_back(e);
+    while (!todo.empty()) {
+        e = todo.back();
+        todo.pop_back();
+        if (m_util.str.is_concat(e)) {
+            for (unsigned i = to_app(e)->get_num_args(); i-- > 0; )
+                todo.push_back(to_app(e)->get_arg(i));
+        }
+        else if (!m_util.str.is_empty(e))
+            es.push_back(e);
+    }
+}
+
+/**
+   \brief Remove the common prefix and suffix of ls and rs.
+   Return false if the sides differ in the first or last character.
+*/
+bool seq_eq_simplifier::strip(expr_ref_vector& ls, expr_ref_vector& rs, bool& changed) {
+    zstring a, b;
+    unsigned li = 0, ri = 0, le = ls.size(), re = rs.size();
+    changed = false;
+    while (li < le && ri < re) {
+        expr* l = ls.get(li), * r = rs.get(ri);
+        if (l == r) {
+            ++li, ++ri;
+            continue;
+        }
+        if (!m_util.str.is_string(l, a) || !m_util.str.is_string(r, b))
+            break;
+        unsigned k = std::min(a.length(), b.length());
+        if (a.extract(0, k) != b.extract(0, k))
+            return false;
+        if (k == a.length())
+            ++li;
+        else
+            ls.set(li, m_util.str.mk_string(a.extract(k, a.length() - k)));
+        if (k == b.length())
+            ++ri;
+        else
+            rs.set(ri, m_util.str.mk_string(b.extract(k, b.length() - k)));
+        changed = true;
+    }
+    while (li < le && ri < re) {
+        expr* l = ls.get(le - 1), * r = rs.get(re - 1);
+        if (l == r) {
+            --le, --re;
+            continue;
+        }
+        if (!m_util.str.is_string(l, a) || !m_util.str.is_string(r, b))
+            break;
+        unsigned k = std::min(a.length(), b.length());
+        if (a.extract(a.length() - k, k) != b.extract(b.length() - k, k))
+            return false;
+        if (k == a.length())
+            --le;
+        else
+            ls.set(le - 1, m_util.str.mk_string(a.extract(0, a.length() - k)));
+        if (k == b.length())
+            --re;
+        else
+            rs.set(re - 1, m_util.str.mk_string(b.extract(0, b.length() - k)));
+        changed = true;
+    }
+    if (li == 0 && ri == 0 && le == ls.size() && re == rs.size())
+        return true;
+    changed = true;
+    auto shrink = [&](expr_ref_vector& es, unsigned lo, unsigned hi) {
+        unsigned j = 0;
+        for (unsigned i = lo; i < hi; ++i)
+            es[j++] = es.get(i);
+        es.shrink(j);
+    };
+    shrink(ls, li, le);
+    shrink(rs, ri, re);
+    return true;
+}
+
+bool seq_eq_simplifier::strip_eqs() {
+    bool change = false;
+    for (unsigned i : indices()) {
+        auto [f, p, d] = m_fmls[i]();
+        expr* x, * y;
+        if (!is_string_eq(f, x, y))
+            continue;
+        m_lhs.reset();
+        m_rhs.reset();
+        get_concats(x, m_lhs);
+        get_concats(y, m_rhs);
+        bool changed = false;
+        expr_ref r(m);
+        if (!strip(m_lhs, m_rhs, changed))
+            r = m.mk_false();
+        else if (m_lhs.empty() || m_rhs.empty()) {
+            expr_ref_vector const& es = m_lhs.empty() ? m_rhs : m_lhs;
+            if (!changed && es.size() <= 1)
+                continue;
+            expr_ref emp(m_util.str.mk_empty(x->get_sort()), m);
+            expr_ref_vector eqs(m);
+            for (expr* e : es)
+                // strip and get_concats leave only non-empty literals
+                eqs.push_back(m_util.str.is_string(e) ? m.mk_false() : m.mk_eq(e, emp));
+            r = mk_and(eqs);
+        }
+        else if (!changed)
+            continue;
+        else
+            r = m.mk_eq(m_util.str.mk_concat(m_lhs, x->get_sort()), m_util.str.mk_concat(m_rhs, x->get_sort()));
+        m_rewriter(r);
+        if (r == f)
+            continue;
+        m_fmls.update(i, dependent_expr(m, r, nullptr, d));
+        ++m_stats.m_num_stripped;
+        change = true;
+    }
+    return change;
+}
+
+unsigned seq_eq_simplifier::get_id(expr* x) {
+    unsigned id;
+    if (m_var2id.find(x, id))
+        return id;
+    id = m_uf.mk_var();
+    m_var2id.insert(x, id);
+    m_id2var.push_back(x);
+    m_is_empty.push_back(false);
+    m_deps.push_back(nullptr);
+    return id;
+}
+
+void seq_eq_simplifier::collect_eq(expr* f, expr_dependency* d) {
+    expr* x, * y;
+    if (m.is_and(f)) {
+        for (expr* arg : *to_app(f))
+            collect_eq(arg, d);
+        return;
+    }
+    if (!is_string_eq(f, x, y))
+        return;
+    if (m_util.str.is_empty(x))
+        std::swap(x, y);
+    if (!is_var(x))
+        return;
+    if (m_util.str.is_empty(y)) {
+        unsigned r = m_uf.find(get_id(x));
+        m_is_empty[r] = true;
+        m_deps[r] = m.mk_join(m_deps.get(r), d);
+    }
+    else if (is_var(y)) {
+        unsigned u = get_id(x), v = get_id(y);
+        unsigned r1 = m_uf.find(u), r2 = m_uf.find(v);
+        if (r1 == r2)
+            return;
+        bool is_empty = m_is_empty[r1] || m_is_empty[r2];
+        expr_dependency_ref dep(m.mk_join(d, m.mk_join(m_deps.get(r1), m_deps.get(r2))), m);
+        m_uf.merge(u, v);
+        unsigned r = m_uf.find(u);
+        m_is_empty[r] = is_empty;
+        m_deps[r] = dep;
+    }
+}
+
+/**
+   \brief Replace each class of equal string variables by a representative,
+   or by the empty string if one of them is equal to the empty string.
+   Frozen variables are never replaced.
+*/
+bool seq_eq_simplifier::propagate_vars() {
+    m_uf.reset();
+    m_var2id.reset();
+    m_id2var.reset();
+    m_is_empty.reset();
+    m_deps.reset();
+    for (unsigned i : indices()) {
+        auto [f, p, d] = m_fmls[i]();
+        collect_eq(f, d);
+    }
+    unsigned n = m_id2var.size();
+    if (n == 0)
+        return false;
+
+    ptr_vector<expr> rep(n, static_cast<expr*>(nullptr));
+    for (unsigned id = 0; id < n; ++id) {
+        unsigned r = m_uf.find(id);
+        if (!rep[r] && m_fmls.frozen(m_id2var[id]))
+            rep[r] = m_id2var[id];
+    }
+    scoped_ptr<expr_substitution> subst = alloc(expr_substitution, m, true, false);
+    for (unsigned id = 0; id < n; ++id) {
+        unsigned r = m_uf.find(id);
+        expr* x = m_id2var[id];
+        if (m_fmls.frozen(x))
+            continue;
+        if (!rep[r])
+            rep[r] = m_id2var[r];
+        expr_ref t(m_is_empty[r] ? m_util.str.mk_empty(x->get_sort()) : rep[r], m);
+        if (t != x)
+            subst->insert(x, t, m_deps.get(r));
+    }
+    if (subst->empty())
+        return false;
+
+    scoped_ptr<expr_replacer> rp = mk_default_expr_replacer(m, false);
+    rp->set_substitution(subst.get());
+    vector<dependent_expr> old_fmls;
+    for (unsigned i : indices()) {
+        auto [f, p, d] = m_fmls[i]();
+        auto [new_f, new_dep] = rp->replace_with_dep(f);
+        expr_ref tmp(m);
+        m_rewriter(new_f, tmp);
+        if (tmp == f)
+            continue;
+        old_fmls.push_back(m_fmls[i]);
+        m_fmls.update(i, dependent_expr(m, tmp, nullptr, m.mk_join(d, new_dep)));
+    }
+    m_stats.m_num_propagated += subst->size();
+    m_fmls.model_trail().push(subst.detach(), old_fmls);
+    return true;
+}
+
+void seq_eq_simplifier::reduce() {
+    if (m.proofs_enabled())
+        return;
+    m_fmls.freeze_suffix();
+    for (unsigned r = 0; r < m_max_rounds && m.inc() && !m_fmls.inconsistent(); ++r) {
+        bool change = strip_eqs();
+        if (!propagate_vars() && !change)
+            break;
+    }
+    m_lhs.reset();
+    m_rhs.reset();
+    m_deps.reset();
+    m_rewriter.reset();
+}
+
+void seq_eq_simplifier::collect_statistics(statistics& st) const {
+    st.update("seq-eqs-stripped", m_stats.m_num_stripped);
+    st.update("seq-eqs-propagated", m_stats.m_num_propagated);
+}
+
+void seq_eq_simplifier::updt_params(params_ref const& p) {
+    tactic_params tp(p);
+    m_max_rounds = p.get_uint("max_rounds", tp.propagate_values_max_rounds());
+    m_rewriter.updt_params(p);
+}
+
+void seq_eq_simplifier::collect_param_descrs(param_descrs& r) {
+    th_rewriter::get_param_descrs(r);
+    r.insert("max_rounds", CPK_UINT, "maximum number of rounds.", "4");
+}
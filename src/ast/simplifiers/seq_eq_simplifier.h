@@ -0,0 +1,72 @@
+/*++
+
+Module Name:
+
+    seq_eq_simplifier.h
+
+Abstract:
+
+    simplifier for top-level string equations
+
+    - common prefixes and suffixes of the two sides of an equation are stripped,
+      an equation whose sides start (or end) with different characters is false.
+    - an equation with an empty side is split into equations of each of the
+      atoms of the other side with the empty string.
+    - equations x = y and x = "" between string variables are propagated,
+      each class of equal variables is replaced by a representative
+      (or the empty string), the replaced variables are reconstructed in models.
+
+    The steps are the ones the string theory preprocessor otherwise repeats
+    on every final check.
+
+--*/
+
+#pragma once
+
+#include "util/union_find.h"
+#include "ast/seq_decl_plugin.h"
+#include "ast/expr_substitution.h"
+#include "ast/simplifiers/dependent_expr_state.h"
+#include "ast/rewriter/th_rewriter.h"
+
+
+class seq_eq_simplifier : public dependent_expr_simplifier {
+
+    struct stats {
+        unsigned m_num_stripped = 0;
+        unsigned m_num_propagated = 0;
+        void reset() { memset(this, 0, sizeof(*this)); }
+    };
+
+    seq_util                m_util;
+    th_rewriter             m_rewriter;
+    stats                   m_stats;
+    unsigned                m_max_rounds = 4;
+    expr_ref_vector         m_lhs, m_rhs;
+
+    // classes of equal string variables
+    basic_union_find        m_uf;
+    obj_map<expr, unsigned> m_var2id;
+    ptr_vector<expr>        m_id2var;
+    bool_vector             m_is_empty;   // the class of the variable contains the empty string
+    expr_dependency_ref_vector m_deps;    // dependencies of the equations merged into the class
+
+    bool is_string_eq(expr* f, expr*& x, expr*& y) const;
+    bool is_var(expr* e) const { return is_uninterp_const(e) && m_util.is_string(e->get_sort()); }
+    void get_concats(expr* e, expr_ref_vector& es);
+    bool strip(expr_ref_vector& ls, expr_ref_vector& rs, bool& changed);
+    bool strip_eqs();
+
+    unsigned get_id(expr* x);
+    void collect_eq(expr* f, expr_dependency* d);
+    bool propagate_vars();
+
+public:
+    seq_eq_simplifier(ast_manager& m, params_ref const& p, dependent_expr_state& fmls);
+    char const* name() const override { return "seq-eqs"; }
+    void reduce() override;
+    void collect_statistics(statistics& st) const override;
+    void reset_statistics() override { m_stats.reset(); }
+    void updt_params(params_ref const& p) override;
+    void collect_param_descrs(param_descrs& r) override;
+};
@@ -2267,6 +2267,8 @@ void cmd_context::display_statistics(bool show_total_time, double total_time) {
         st.update("total time", total_time);
     st.update("time", get_seconds());
     get_memory_statistics(st);
+    m().get_allocator().collect_statistics(st);
+    IF_VERBOSE(10, m().get_allocator().display_size_classes(verbose_stream()););
     get_rlimit_statistics(m().limit(), st);
     if (m_check_sat_result) {
         m_check_sat_result->collect_statistics(st);
@@ -2424,6 +2426,14 @@ void cmd_context::display_smt2_benchmark(std::ostream & out, unsigned num, expr
 void cmd_context::slow_progress_sample() {
     SASSERT(m_solver);
     statistics st;
+    if (m_params.m_progress_json) {
+        // one line per sample, the statistics contain the counters of all theories
+        m_solver->collect_statistics(st);
+        regular_stream() << "{\"progress\": {\"time\": " << get_seconds() << ", \"stats\": ";
+        st.display_json(regular_stream());
+        regular_stream() << "}}" << std::endl;
+        return;
+    }
     regular_stream() << "(progress\n";
     m_solver->collect_statistics(st);
     st.display_smt2(regular_stream());
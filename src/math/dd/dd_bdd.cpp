@@ -544,6 +544,30 @@ namespace dd {
         return bdd(m_var2bdd[2*i+1], this);
     }
 
+    bdd bdd_manager::translate(bdd const& b) {
+        if (b.m == this)
+            return b;
+        u_map<unsigned> cache;
+        vector<bdd> done;
+        return translate_rec(*b.m, b.root, cache, done);
+    }
+
+    bdd bdd_manager::translate_rec(bdd_manager const& src, BDD b, u_map<unsigned>& cache, vector<bdd>& done) {
+        if (src.is_true(b))
+            return mk_true();
+        if (src.is_false(b))
+            return mk_false();
+        unsigned idx;
+        if (cache.find(b, idx))
+            return done[idx];
+        bdd hi = translate_rec(src, src.hi(b), cache, done);
+        bdd lo = translate_rec(src, src.lo(b), cache, done);
+        bdd r = mk_ite(mk_var(src.var(b)), hi, lo);
+        cache.insert(b, done.size());
+        done.push_back(r);
+        return r;
+    }
+
     bdd bdd_manager::mk_not(bdd b) {
         bool first = true;
         scoped_push _sp(*this);
@@ -198,6 +198,7 @@ namespace dd {
 	bdd mk_cofactor(bdd const& a, bdd const& b);
 
         void reserve_var(unsigned v);
+        bdd translate_rec(bdd_manager const& src, BDD b, u_map<unsigned>& cache, vector<bdd>& done);
         bool well_formed();
 
         struct scoped_push {
@@ -266,6 +267,11 @@ namespace dd {
         std::ostream& display(std::ostream& out);
         std::ostream& display(std::ostream& out, bdd const& b);
 
+        /**
+         * \brief copy b of another manager into this manager, see pdd_manager::translate.
+         */
+        bdd translate(bdd const& b);
+
         void gc();
         void try_reorder();
         void try_cnf_reorder(bdd const& b);
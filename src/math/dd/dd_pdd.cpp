@@ -1416,6 +1416,32 @@ namespace dd {
         reserve_var(i);
         return pdd(m_var2pdd[i], this);        
     }
+
+    pdd pdd_manager::translate(pdd const& p) {
+        if (p.m == this)
+            return p;
+        pdd_manager const& src = *p.m;
+        SASSERT(m_semantics == src.m_semantics);
+        SASSERT(m_semantics != mod2N_e || m_power_of_2 == src.m_power_of_2);
+        u_map<unsigned> cache;
+        vector<pdd> done;
+        return translate_rec(src, p.root, cache, done);
+    }
+
+    // the translated nodes are kept alive in done, cache maps a node of src to its index in done
+    pdd pdd_manager::translate_rec(pdd_manager const& src, PDD p, u_map<unsigned>& cache, vector<pdd>& done) {
+        if (src.is_val(p))
+            return mk_val(src.val(p));
+        unsigned idx;
+        if (cache.find(p, idx))
+            return done[idx];
+        pdd hi = translate_rec(src, src.hi(p), cache, done);
+        pdd lo = translate_rec(src, src.lo(p), cache, done);
+        pdd r = mk_var(src.var(p)) * hi + lo;
+        cache.insert(p, done.size());
+        done.push_back(r);
+        return r;
+    }
     
     unsigned pdd_manager::dag_size(pdd const& b) {
         init_mark();
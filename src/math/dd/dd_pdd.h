@@ -293,6 +293,7 @@ namespace dd {
         void compute_reachable(bool_vector& reachable);
         void try_gc();
         void reserve_var(unsigned v);
+        pdd translate_rec(pdd_manager const& src, PDD p, u_map<unsigned>& cache, vector<pdd>& done);
         bool well_formed();
         bool well_formed(node const& n);
 
@@ -398,6 +399,15 @@ namespace dd {
         std::ostream& display(std::ostream& out);
         std::ostream& display(std::ostream& out, pdd const& b);
 
+        /**
+         * \brief copy p of another manager into this manager.
+         * The managers can use different variable orders but must have the same semantics.
+         * Only the nodes of the source manager are read, neither its reference counts nor its
+         * caches are modified. Solvers running in separate threads can keep their own managers
+         * and exchange polynomials this way, while the source manager is not modified.
+         */
+        pdd translate(pdd const& p);
+
         void gc();
     };
 
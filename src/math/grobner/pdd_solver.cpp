@@ -73,12 +73,16 @@ namespace dd {
     void solver::adjust_cfg() {
         auto & cfg = m_config;
         IF_VERBOSE(3, verbose_stream() << "start saturate\n"; display_statistics(verbose_stream()));
-        cfg.m_eqs_threshold = static_cast<unsigned>(cfg.m_eqs_growth * ceil(log(1 + m_to_simplify.size()))* m_to_simplify.size());
+        // the processed equations are those of a basis that is extended by the equations to simplify
+        unsigned num_eqs = m_to_simplify.size() + m_processed.size();
+        cfg.m_eqs_threshold = static_cast<unsigned>(cfg.m_eqs_growth * ceil(log(1 + num_eqs))* num_eqs);
         cfg.m_expr_size_limit = 0;
         cfg.m_expr_degree_limit = 0;
-        for (equation* e: m_to_simplify) {
-            cfg.m_expr_size_limit = std::max(cfg.m_expr_size_limit, (unsigned)e->poly().tree_size());
-            cfg.m_expr_degree_limit = std::max(cfg.m_expr_degree_limit, e->poly().degree());            
+        for (equation_vector const* eqs : { &m_to_simplify, &m_processed }) {
+            for (equation* e: *eqs) {
+                cfg.m_expr_size_limit = std::max(cfg.m_expr_size_limit, (unsigned)e->poly().tree_size());
+                cfg.m_expr_degree_limit = std::max(cfg.m_expr_degree_limit, e->poly().degree());            
+            }
         }
         cfg.m_expr_size_limit *= cfg.m_expr_size_growth;
         cfg.m_expr_degree_limit *= cfg.m_expr_degree_growth;;
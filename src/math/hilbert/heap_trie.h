@@ -275,6 +275,12 @@ public:
         return find_le(m_root, 0, keys, check);
     }
 
+    // find_le without statistics and without moving the children that match to the front.
+    // Several threads can call it at the same time as long as the trie is not modified.
+    bool find_le_shared(Key const* keys, check_value& check) const {
+        return find_le_shared(m_root, 0, keys, check);
+    }
+
     void remove(Key const* keys) {
         ++m_stats.m_num_removes;
         // assumption: key is in table.
@@ -586,6 +592,16 @@ private:
         }
     }
     
+    bool find_le_shared(node* n, unsigned index, Key const* keys, check_value& check) const {
+        if (index == num_keys()) 
+            return check(to_leaf(n)->get_value());
+        Key const& key = get_key(keys, index);
+        for (auto const& [k, m] : to_trie(n)->nodes()) 
+            if (m->ref_count() > 0 && m_le.le(k, key) && find_le_shared(m, index+1, keys, check)) 
+                return true;
+        return false;
+    }
+    
     void insert(node* n, unsigned num_keys, Key const* keys, unsigned const* permutation, Value const& val) {
         // assumption: key is not in table.
         for (unsigned i = 0; i < num_keys; ++i) {
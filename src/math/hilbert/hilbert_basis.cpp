@@ -18,6 +18,9 @@ Revision History:
 --*/
 
 #include "math/hilbert/hilbert_basis.h"
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
 #include "util/heap.h"
 #include "util/map.h"
 #include "math/hilbert/heap_trie.h"
@@ -190,7 +193,7 @@ class hilbert_basis::value_index2 {
     checker                      m_checker;
     unsigned                     m_offset;
 
-    numeral const* get_keys(values const& vs) {
+    numeral const* get_keys(values const& vs) const {
         return vs()-m_offset;
     }
 
@@ -221,6 +224,13 @@ public:
         return m_trie.find_le(get_keys(vs), m_checker);
     }
 
+    bool find_shared(offset_t idx, values const& vs) const {
+        checker ch;
+        ch.hb = &hb;
+        ch.m_value = idx;
+        return m_trie.find_le_shared(get_keys(vs), ch);
+    }
+
     void collect_statistics(statistics& st) const {
         m_trie.collect_statistics(st);
     }
@@ -316,6 +326,22 @@ public:
         }        
     }    
 
+    // read-only variant of find for concurrent subsumption checks
+    bool find_shared(offset_t idx, values const& vs) const {
+        if (vs.weight().is_pos()) {
+            return m_pos.find_shared(idx,  vs);
+        }
+        else if (vs.weight().is_zero()) {
+            return m_zero.find_shared(idx, vs);
+        }
+        else {
+            value_index* map;
+            return
+                m_neg.find(vs.weight(), map) && 
+                map->find_shared(idx, vs);
+        }        
+    }    
+
     void reset(unsigned num_ineqs) {
         value_map::iterator it = m_neg.begin(), end = m_neg.end();
         for (; it != end; ++it) {
@@ -943,6 +969,12 @@ lbool hilbert_basis::saturate(num_vector const& ineq, bool is_eq) {
     // resolve passive into active
     offset_t idx = alloc_vector();
     while (checkpoint() && !m_passive2->empty()) {
+#ifndef SINGLE_THREAD
+        if (m_num_threads > 1) {
+            saturate_batch();
+            continue;
+        }
+#endif
         offset_t sos, pas;
         TRACE("hilbert_basis", display(tout); );
         unsigned offset = m_passive2->pop(sos, pas);
@@ -984,6 +1016,71 @@ lbool hilbert_basis::saturate(num_vector const& ineq, bool is_eq) {
     return m_basis.empty()?l_false:l_true;
 }
 
+#ifndef SINGLE_THREAD
+/**
+   \brief resolve a batch of passive pairs and check the resolvents for subsumption on m_num_threads threads.
+   The threads only read the index. The resolvents that are not subsumed by the index are then checked
+   again and inserted one by one, so that they are also checked against each other.
+   The pairs of resolvents with the support set are generated when they are inserted into the 
+   passive set, so the basis does not depend on how the pairs are batched.
+*/
+void hilbert_basis::saturate_batch() {
+    svector<std::pair<offset_t, unsigned>> batch;
+    unsigned max_batch = s_batch_per_thread * m_num_threads;
+    while (batch.size() < max_batch && !m_passive2->empty()) {
+        offset_t sos, pas;
+        unsigned offset = m_passive2->pop(sos, pas);
+        SASSERT(can_resolve(sos, pas, true));
+        offset_t r = alloc_vector();
+        resolve(sos, pas, r);
+        batch.push_back({ r, offset });
+    }
+    unsigned n = batch.size();
+    unsigned num_threads = std::min(m_num_threads, n);
+    // 0 - not subsumed, 1 - subsumed, 2 - not checked
+    svector<char> subsumed(n, 2);
+    auto work = [&](unsigned w) {
+        try {
+            for (unsigned i = w; i < n; i += num_threads) 
+                subsumed[i] = m_index->find_shared(batch[i].first, vec(batch[i].first)) ? 1 : 0;
+        }
+        catch (...) {
+            // left to the sequential check
+        }
+    };
+    vector<std::thread> threads;
+    for (unsigned w = 1; w < num_threads; ++w)
+        threads.push_back(std::thread([&, w]() { work(w); }));
+    work(0);
+    for (auto& th : threads)
+        th.join();
+
+    for (unsigned i = 0; i < n; ++i) {
+        offset_t idx = batch[i].first;
+        if (subsumed[i] == 1) {
+            ++m_stats.m_num_subsumptions;
+            m_free_list.push_back(idx);
+            continue;
+        }
+        if (is_subsumed(idx)) {
+            m_free_list.push_back(idx);
+            continue;
+        }
+        values v = vec(idx);
+        m_index->insert(idx, v);
+        if (v.weight().is_zero()) {
+            m_zero.push_back(idx);
+        }
+        else {
+            m_passive2->insert(idx, m_use_ordered_support ? batch[i].second : 0);
+            if (v.weight().is_pos()) {
+                m_basis.push_back(idx);
+            }
+        }
+    }
+}
+#endif
+
 void hilbert_basis::get_basis_solution(unsigned i, rational_vector& v, bool& is_initial) {
     offset_t offs = m_basis[i];
     v.reset();
@@ -105,6 +105,8 @@ class hilbert_basis {
     bool               m_use_support;             // parameter: (associativity) resolve only against vectors that are initially in basis.
     bool               m_use_ordered_support;     // parameter: (commutativity) resolve in order
     bool               m_use_ordered_subsumption; // parameter
+    unsigned           m_num_threads = 1;         // parameter: threads used for subsumption checks
+    static const unsigned s_batch_per_thread = 64;
 
 
     class iterator {
@@ -144,6 +146,7 @@ class hilbert_basis {
 
     offset_t alloc_vector();
     void resolve(offset_t i, offset_t j, offset_t r);
+    void saturate_batch();
     iterator begin() const { return iterator(*this,0); }
     iterator end() const { return iterator(*this, m_basis.size()); }
 
@@ -166,6 +169,8 @@ public:
     void set_use_support(bool b) { m_use_support = b; }
     void set_use_ordered_support(bool b) { m_use_ordered_support = b; }
     void set_use_ordered_subsumption(bool b) { m_use_ordered_subsumption = b; }
+    // number of threads that check resolvents for subsumption during saturation
+    void set_num_threads(unsigned n) { m_num_threads = std::max(1u, n); }
 
     // add inequality v*x >= 0
     // add inequality v*x <= 0
@@ -492,6 +492,7 @@ public:
         auto add_cut = [&](const lar_term& t, const mpq& k, u_dependency * dep) {
             lp::lpvar j = lra.add_term(t.coeffs_as_vector(), UINT_MAX);
             lra.update_column_type_and_bound(j, lp::lconstraint_kind::GE,  k, dep); 
+            return j;
         };
         auto _check_feasible = [&](void) {
             lra.find_feasible_solution();
@@ -525,7 +526,7 @@ public:
                 continue;
             }
             has_small_cut = true;
-            add_cut(cc.m_t, cc.m_k, cc.m_dep);
+            lia.cut_pool().insert(lra, cc.m_t, cc.m_k, cc.m_dep, add_cut(cc.m_t, cc.m_k, cc.m_dep));
             if (lia.settings().get_cancel_flag())
                 return lia_move::undef;
         }
@@ -539,7 +540,7 @@ public:
 
             if (!feas)       
                 for (auto const& cut : big_cuts) 
-                    add_cut(cut.t, cut.k, cut.dep);
+                    lia.cut_pool().insert(lra, cut.t, cut.k, cut.dep, add_cut(cut.t, cut.k, cut.dep));
         }
         
         if (!_check_feasible())
@@ -0,0 +1,122 @@
+/*++
+Copyright (c) 2017 Microsoft Corporation
+
+Module Name:
+
+    int_cut_pool.cpp
+
+Abstract:
+
+    Pool of Gomory cuts
+
+Author:
+    Nikolaj Bjorner (nbjorner)
+    Lev Nachmanson (levnach)
+
+Revision History:
+--*/
+
+#include "math/lp/int_solver.h"
+#include "math/lp/lar_solver.h"
+#include "math/lp/int_cut_pool.h"
+
+namespace lp {
+
+    // j is the term column of the cut in lra
+    void int_cut_pool::insert(lar_solver& lra, const lar_term& t, const mpq& k, u_dependency* dep, lpvar j) {
+        unsigned capacity = lra.settings().cut_pool_size();
+        if (capacity == 0)
+            return;
+        cut c;
+        c.m_t = t;
+        c.m_k = k;
+        lra.dep_manager().linearize(dep, c.m_constraints);
+        c.m_max_column = 0;
+        for (lar_term::ival p : t)
+            c.m_max_column = std::max(c.m_max_column, p.j());
+        c.m_column = j;
+        c.m_age = 0;
+        m_cuts.push_back(std::move(c));
+        if (m_cuts.size() > capacity)
+            evict();
+    }
+
+    // remove the oldest half of the cuts
+    void int_cut_pool::evict() {
+        std::stable_sort(m_cuts.begin(), m_cuts.end(), [](cut const& a, cut const& b) { return a.m_age < b.m_age; });
+        m_cuts.shrink(m_cuts.size() / 2);
+    }
+
+    // the columns and constraints from column_count and cs.size() on were removed by pop
+    void int_cut_pool::pop(unsigned column_count, constraint_set const& cs) {
+        unsigned j = 0;
+        for (cut& c : m_cuts) {
+            if (c.m_max_column >= column_count)
+                continue;
+            if (any_of(c.m_constraints, [&](unsigned ci) { return !cs.valid_index(ci); }))
+                continue;
+            if (c.m_column != null_lpvar && c.m_column >= column_count)
+                c.m_column = null_lpvar;
+            if (&c != &m_cuts[j])
+                m_cuts[j] = std::move(c);
+            ++j;
+        }
+        m_cuts.shrink(j);
+    }
+
+    /**
+       \brief add the cuts of the pool that are violated by the current solution,
+       the most violated ones first.
+    */
+    lia_move int_cut_pool::add_violated(int_solver& lia) {
+        lar_solver& lra = lia.lra;
+        if (m_cuts.empty())
+            return lia_move::undef;
+        vector<std::pair<mpq, unsigned>> violated;
+        unsigned j = 0;
+        for (unsigned i = 0; i < m_cuts.size(); ++i) {
+            cut& c = m_cuts[i];
+            if (c.m_column == null_lpvar) {
+                bool active = all_of(c.m_constraints, [&](unsigned ci) { return lra.constraints().is_active(ci); });
+                impq val;
+                if (active) 
+                    for (lar_term::ival p : c.m_t)
+                        val += p.coeff() * lra.get_column_value(p.j());
+                if (active && val < impq(c.m_k))
+                    violated.push_back({ (c.m_k - val.x) / mpq(c.m_t.size()), j });
+                else if (++c.m_age > m_max_age)
+                    continue;
+            }
+            if (i != j)
+                m_cuts[j] = std::move(c);
+            ++j;
+        }
+        m_cuts.shrink(j);
+        if (violated.empty())
+            return lia_move::undef;
+
+        std::sort(violated.begin(), violated.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+        if (violated.size() > m_max_readd)
+            violated.shrink(m_max_readd);
+        for (auto const& [score, i] : violated) {
+            cut& c = m_cuts[i];
+            u_dependency* dep = nullptr;
+            for (unsigned ci : c.m_constraints)
+                dep = lra.join_deps(dep, lra.dep_manager().mk_leaf(ci));
+            c.m_column = lra.add_term(c.m_t.coeffs_as_vector(), UINT_MAX);
+            lra.update_column_type_and_bound(c.m_column, lconstraint_kind::GE, c.m_k, dep);
+            c.m_age = 0;
+            lia.settings().stats().m_cut_pool_cuts++;
+        }
+        TRACE("gomory_cut", tout << "re-added " << violated.size() << " cuts of " << m_cuts.size() << "\n";);
+
+        lra.find_feasible_solution();
+        if (!lra.is_feasible() && !lia.settings().get_cancel_flag()) {
+            lra.get_infeasibility_explanation(*lia.m_ex);
+            return lia_move::conflict;
+        }
+        if (!lia.has_inf_int())
+            return lia_move::sat;
+        return lia_move::continue_with_check;
+    }
+}
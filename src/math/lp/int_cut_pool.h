@@ -0,0 +1,57 @@
+/*++
+Copyright (c) 2017 Microsoft Corporation
+
+Module Name:
+
+    int_cut_pool.h
+
+Abstract:
+
+    Pool of Gomory cuts
+
+    Cuts are added to lar_solver as bounded term columns and are
+    removed by pop together with the scope they were added in.
+    The pool remembers the cuts together with the constraints they
+    depend on, and adds them back when they are violated by the
+    current solution and all of their constraints are active again.
+    Cuts that stay satisfied age and are evicted.
+
+Author:
+    Nikolaj Bjorner (nbjorner)
+    Lev Nachmanson (levnach)
+
+Revision History:
+--*/
+#pragma once
+
+#include "math/lp/lar_term.h"
+#include "math/lp/lia_move.h"
+#include "math/lp/lar_constraints.h"
+
+namespace lp {
+    class int_solver;
+    class lar_solver;
+    class int_cut_pool {
+        struct cut {
+            lar_term            m_t;            // the cut is m_t >= m_k
+            mpq                 m_k;
+            unsigned_vector     m_constraints;  // the constraints the cut depends on
+            lpvar               m_max_column;   // the largest column of m_t
+            lpvar               m_column;       // the term column of the cut while it is in lar_solver
+            unsigned            m_age;
+        };
+        vector<cut>             m_cuts;
+        // maximal number of cuts re-added by one call
+        unsigned                m_max_readd = 8;
+        // cuts that were satisfied in this many calls are evicted
+        unsigned                m_max_age = 32;
+        
+        void evict();
+    public:
+        void insert(lar_solver& lra, const lar_term& t, const mpq& k, u_dependency* dep, lpvar j);
+        void pop(unsigned column_count, constraint_set const& cs);
+        lia_move add_violated(int_solver& lia);
+        unsigned size() const { return m_cuts.size(); }
+        void reset() { m_cuts.reset(); }
+    };
+}
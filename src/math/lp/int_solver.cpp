@@ -198,6 +198,7 @@ namespace lp {
         if (r == lia_move::undef) lra.move_non_basic_columns_to_bounds();
         if (r == lia_move::undef && should_hnf_cut()) r = hnf_cut();
 
+        if (r == lia_move::undef) r = m_cut_pool.add_violated(*this);
         if (r == lia_move::undef && should_gomory_cut()) r = gomory(*this).get_gomory_cuts(2);
 
         if (r == lia_move::undef) r = int_branch(*this)();
@@ -25,6 +25,7 @@ Revision History:
 #include "math/lp/lar_constraints.h"
 #include "math/lp/hnf_cutter.h"
 #include "math/lp/int_gcd_test.h"
+#include "math/lp/int_cut_pool.h"
 #include "math/lp/lia_move.h"
 #include "math/lp/explanation.h"
 
@@ -39,6 +40,7 @@ class int_solver {
     friend class int_branch;
     friend class int_gcd_test;
     friend class hnf_cutter;
+    friend class int_cut_pool;
 
     class patcher {
         int_solver&         lia;
@@ -68,6 +70,7 @@ class int_solver {
     hnf_cutter          m_hnf_cutter;
     unsigned            m_hnf_cut_period;
     unsigned_vector     m_cut_vars;        // variables that should not be selected for cuts
+    int_cut_pool        m_cut_pool;        // Gomory cuts that are added back after they were popped
     
     vector<equality>       m_equalities;
 public:
@@ -89,6 +92,7 @@ public:
     bool at_upper(unsigned j) const;
     void simplify(std::function<bool(unsigned)>& is_root);
     vector<equality> const& equalities() const { return m_equalities; }
+    int_cut_pool& cut_pool() { return m_cut_pool; }
 
 private:
     // lia_move patch_nbasic_columns();
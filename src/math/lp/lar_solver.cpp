@@ -216,6 +216,8 @@ namespace lp {
         TRACE("lar_solver", tout << "k = " << k << std::endl;);
         m_crossed_bounds_column = null_lpvar;
         m_crossed_bounds_deps = nullptr;
+        // only the basis of the rows removed by the last pop is kept (undo_add_column fills it)
+        m_popped_term_basis.clear();
         m_trail.pop_scope(k);
         unsigned n = m_columns.size();
         m_var_register.shrink(n);
@@ -245,6 +247,8 @@ namespace lp {
         lp_assert(m_mpq_lar_core_solver.m_r_solver.reduced_costs_are_correct_tableau());
         m_usage_in_terms.pop(k);
         m_dependencies.pop_scope(k);
+        if (m_int_solver)
+            m_int_solver->cut_pool().pop(A_r().column_count(), m_constraints);
         // init the nbasis sorting
 		require_nbasis_sort();
         set_status(lp_status::UNKNOWN);
@@ -1398,6 +1402,13 @@ namespace lp {
         undo_add_column(lar_solver& s) : s(s) {}
         void undo() override {
             auto& col = s.m_columns.back();
+            if (col.term() != nullptr && s.settings().reuse_popped_basis()) {
+                auto const& rslv = s.m_mpq_lar_core_solver.m_r_solver;
+                unsigned j = s.m_columns.size() - 1;
+                lpvar b = rslv.m_basis[s.A_r().row_count() - 1];
+                if (b != j && rslv.m_basis_heading[j] < 0)
+                    s.m_popped_term_basis[*col.term()] = b;
+            }
             if (col.term() != nullptr) {
                 if (s.m_need_register_terms)
                     s.deregister_normalized_term(*col.term());
@@ -1566,6 +1577,40 @@ namespace lp {
                 m_usage_in_terms.push_back(0);
             m_usage_in_terms[j] = m_usage_in_terms[j] + 1;
         }
+        if (!m_popped_term_basis.empty())
+            reuse_popped_basis(*term, j);
+    }
+
+    /**
+       \brief Warm start for terms re-added after a pop: if the row of the same term had another basic column
+       when it was removed, the column becomes basic in the new row again, so the simplex starts
+       from the previous (feasible) basis instead of pivoting to it again.
+    */
+    void lar_solver::reuse_popped_basis(const lar_term& term, lpvar j) {
+        auto it = m_popped_term_basis.find(term);
+        if (it == m_popped_term_basis.end())
+            return;
+        lpvar b = it->second;
+        m_popped_term_basis.erase(it);
+        auto& rslv = m_mpq_lar_core_solver.m_r_solver;
+        unsigned i = A_r().row_count() - 1;
+        if (b >= j || rslv.m_basis_heading[b] >= 0 || rslv.m_basis[i] != j)
+            return;
+        bool in_row = false;
+        for (auto const& rc : A_r().m_rows[i])
+            if (rc.var() == b) {
+                in_row = true;
+                break;
+            }
+        if (!in_row)
+            return;
+        TRACE("lar_solver", tout << "reusing basic column " << b << " for the row of term column " << j << "\n";);
+        if (!rslv.pivot_column_tableau(b, i))
+            return;
+        rslv.change_basis_unconditionally(b, j);
+        rslv.remove_column_from_inf_heap(j);
+        rslv.track_column_feasibility(b);
+        m_settings.stats().m_reused_basis++;
     }
 
     void lar_solver::add_basic_var_to_core_fields() {
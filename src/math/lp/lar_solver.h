@@ -74,6 +74,29 @@ class lar_solver : public column_namer {
         }
     };
 
+    // lar_term::operator== never identifies terms, these compare the coefficients (independently of their order)
+    struct term_coeffs_hasher {
+        std::size_t operator()(const lar_term& t) const {
+            size_t seed = 0;
+            for (const auto p : t) 
+                seed += mk_mix(p.j(), p.coeff().hash(), 17);
+            return seed;
+        }
+    };
+
+    struct term_coeffs_comparer {
+        bool operator()(const lar_term& a, const lar_term& b) const {
+            if (a.size() != b.size())
+                return false;
+            for (const auto p : a) {
+                auto* e = b.coeffs().find_core(p.j());
+                if (!e || e->get_data().m_value != p.coeff())
+                    return false;
+            }
+            return true;
+        }
+    };
+
     //////////////////// fields //////////////////////////
     trail_stack m_trail;
     lp_settings m_settings;
@@ -106,6 +129,8 @@ class lar_solver : public column_namer {
     std::unordered_map<lar_term, std::pair<mpq, unsigned>, term_hasher, term_comparer>
         m_normalized_terms_to_columns;
     vector<impq> m_backup_x;
+    // term -> column basic in the row of the term when the row was removed by the last pop
+    std::unordered_map<lar_term, lpvar, term_coeffs_hasher, term_coeffs_comparer> m_popped_term_basis;
     stacked_vector<unsigned> m_usage_in_terms;
     // ((x[j], is_int(j))->j)  for fixed j, used in equalities propagation
     // maps values to integral fixed vars
@@ -136,6 +161,7 @@ class lar_solver : public column_namer {
     bool term_coeffs_are_ok(const vector<std::pair<mpq, lpvar>>& coeffs);
     void add_row_from_term_no_constraint(lar_term* term, unsigned term_ext_index);
     void add_basic_var_to_core_fields();
+    void reuse_popped_basis(const lar_term& term, lpvar j);
     bool compare_values(impq const& lhs, lconstraint_kind k, const mpq& rhs);
 
     inline void clear_columns_with_changed_bounds() { m_columns_with_changed_bounds.reset(); }
@@ -276,10 +276,11 @@ pivot_column_tableau(unsigned j, unsigned piv_row_index) {
         m_A.m_rows[piv_row_index][column[0].offset()].offset() = 0;
         m_A.m_rows[c.var()][c.offset()].offset() = pivot_col_cell_index;
     }
+    m_A.gather_pivot_row(piv_row_index, j);
     while (column.size() > 1) {
         auto & c = column.back();
         lp_assert(c.var() != piv_row_index);
-        if(! m_A.pivot_row_to_row_given_cell(piv_row_index, c, j)) {
+        if(! m_A.pivot_gathered_row_to_row_given_cell(c)) {
             return false;
         }
         if (m_touched_rows!= nullptr)
@@ -32,4 +32,6 @@ void lp::lp_settings::updt_params(params_ref const& _p) {
     report_frequency = p.arith_rep_freq();
     m_simplex_strategy = static_cast<lp::simplex_strategy_enum>(p.arith_simplex_strategy());
     m_nlsat_delay = p.arith_nl_delay();
+    m_reuse_popped_basis = p.arith_reuse_popped_basis();
+    m_cut_pool_size = p.arith_cut_pool_size();
 }
@@ -126,8 +126,11 @@ struct statistics {
     unsigned m_cross_nested_forms;
     unsigned m_grobner_calls;
     unsigned m_grobner_conflicts;
+    unsigned m_grobner_reused;
     unsigned m_offset_eqs;
     unsigned m_fixed_eqs;
+    unsigned m_reused_basis;
+    unsigned m_cut_pool_cuts;
     statistics() { reset(); }
     void reset() { memset(this, 0, sizeof(*this)); }
     void collect_statistics(::statistics& st) const {
@@ -142,13 +145,16 @@ struct statistics {
         st.update("arith-patches", m_patches);
         st.update("arith-patches-success", m_patches_success);
         st.update("arith-hnf-calls", m_hnf_cutter_calls);
+        st.update("arith-reused-basis", m_reused_basis);
         st.update("arith-hnf-cuts", m_hnf_cuts);
         st.update("arith-gomory-cuts", m_gomory_cuts);
+        st.update("arith-cut-pool-cuts", m_cut_pool_cuts);
         st.update("arith-horner-calls", m_horner_calls);
         st.update("arith-horner-conflicts", m_horner_conflicts);
         st.update("arith-horner-cross-nested-forms", m_cross_nested_forms);
         st.update("arith-grobner-calls", m_grobner_calls);
         st.update("arith-grobner-conflicts", m_grobner_conflicts);
+        st.update("arith-grobner-reused", m_grobner_reused);
         st.update("arith-offset-eqs", m_offset_eqs);
         st.update("arith-fixed-eqs", m_fixed_eqs);
         st.update("arith-nla-add-bounds", m_nla_add_bounds);
@@ -191,6 +197,8 @@ public:
     unsigned nlsat_delay() const { return m_nlsat_delay; }
     bool int_run_gcd_test() const { return m_int_run_gcd_test; }
     bool& int_run_gcd_test() { return m_int_run_gcd_test; }
+    bool reuse_popped_basis() const { return m_reuse_popped_basis; }
+    unsigned cut_pool_size() const { return m_cut_pool_size; }
     unsigned      reps_in_scaler = 20;
     int           c_partial_pivoting = 10; // this is the constant c from page 410
     unsigned      depth_of_rook_search = 4;
@@ -223,6 +231,8 @@ public:
 private:
     unsigned         m_nlsat_delay;
     bool             m_enable_hnf = true;
+    bool             m_reuse_popped_basis = true;
+    unsigned         m_cut_pool_size = 256;
     bool             m_print_external_var_name = false;
     bool             m_propagate_eqs = false;
 public:
@@ -137,12 +137,14 @@ void core::add_monic(lpvar v, unsigned sz, lpvar const* vs) {
 void core::push() {
     TRACE("nla_solver_verbose", tout << "\n";);
     m_emons.push();
+    m_grobner.push();
 }
 
      
 void core::pop(unsigned n) {
     TRACE("nla_solver_verbose", tout << "n = " << n << "\n";);
     m_emons.pop(n);
+    m_grobner.pop(n);
     SASSERT(elists_are_consistent(false));
 }
 
@@ -55,6 +55,7 @@ namespace nla {
         if (!configure())
             return;
         m_solver.saturate();
+        m_basis_valid = m_core.m_reslim.inc();
 
         if (m_delay_base > 0)
             --m_delay_base;
@@ -93,6 +94,7 @@ namespace nla {
     dd::solver::equation_vector const& grobner::core_equations(bool all_eqs) {
         flet<bool> _add_all(m_add_all_eqs, all_eqs);
         find_nl_cluster();        
+        m_basis_valid = false;
         if (!configure()) 
             throw dd::pdd_manager::mem_out();
         return m_solver.equations();
@@ -226,9 +228,9 @@ namespace nla {
     }
 
     bool grobner::configure() {
-        m_solver.reset();
+        bool same_order;
         try {
-            set_level2var();
+            same_order = set_level2var();
             TRACE("grobner",
                   tout << "base vars: ";
                   for (lpvar j : c().active_var_set())
@@ -245,8 +247,31 @@ namespace nla {
         }
         catch (dd::pdd_manager::mem_out) {
             IF_VERBOSE(2, verbose_stream() << "pdd throw\n");
+            m_new_inputs.clear();
+            reset_basis();
+            return false;
+        }
+
+        try {
+            if (same_order && reuse_basis()) 
+                lp_settings().stats().m_grobner_reused++;
+            else {
+                reset_basis();
+                for (auto& [p, dep] : m_new_inputs) {
+                    dd::pdd q = p;
+                    add_eq(q, dep);
+                }
+            }
+        }
+        catch (dd::pdd_manager::mem_out) {
+            IF_VERBOSE(2, verbose_stream() << "pdd throw\n");
+            m_new_inputs.clear();
+            reset_basis();
             return false;
         }
+        m_inputs.swap(m_new_inputs);
+        m_new_inputs.clear();
+        m_basis_lvl = m_scope_lvl;
         TRACE("grobner", m_solver.display(tout));
 
 #if 0
@@ -555,7 +580,54 @@ namespace nla {
         for (lpvar k : c().emons()[j].vars())
             r *= pdd_expr(rational::one(), k, dep);
         r -= val_of_fixed_var_with_deps(j, dep);
-        add_eq(r, dep);
+        add_input(r, dep);
+    }
+
+    void grobner::reset_basis() {
+        m_solver.reset();
+        m_inputs.clear();
+        m_basis_valid = false;
+    }
+
+    /**
+       \brief continue from the saturated basis of the previous call if all of its
+       input equations are among the new ones, only the new inputs are added to it.
+       The equations of the basis are consequences of its inputs, and their dependencies
+       are still alive as long as the scope they were created in was not popped.
+    */
+    bool grobner::reuse_basis() {
+        if (!m_basis_valid || !c().params().arith_nl_grobner_incremental())
+            return false;
+        typedef std::pair<unsigned, u_dependency*> key;
+        svector<key> old_keys, new_keys;
+        for (auto const& [p, dep] : m_inputs)
+            old_keys.push_back({ p.index(), dep });
+        for (auto const& [p, dep] : m_new_inputs)
+            new_keys.push_back({ p.index(), dep });
+        std::sort(old_keys.begin(), old_keys.end());
+        std::sort(new_keys.begin(), new_keys.end());
+        if (!std::includes(new_keys.begin(), new_keys.end(), old_keys.begin(), old_keys.end()))
+            return false;
+        // rebuilding is cheaper than extending a basis by many new equations
+        if (2 * (new_keys.size() - old_keys.size()) > old_keys.size())
+            return false;
+        for (auto& [p, dep] : m_new_inputs) {
+            if (std::binary_search(old_keys.begin(), old_keys.end(), key(p.index(), dep)))
+                continue;
+            dd::pdd q = p;
+            add_eq(q, dep);
+        }
+        // the step limits are relative to this call
+        m_solver.get_stats().reset();
+        TRACE("grobner", tout << "reuse basis of " << old_keys.size() << " inputs, " << new_keys.size() - old_keys.size() << " new\n");
+        return true;
+    }
+
+    void grobner::pop(unsigned n) {
+        SASSERT(n <= m_scope_lvl);
+        m_scope_lvl -= n;
+        if (m_scope_lvl < m_basis_lvl)
+            m_basis_valid = false;
     }
 
     void grobner::add_row(const vector<lp::row_cell<rational>> & row) {
@@ -565,7 +637,7 @@ namespace nla {
         for (const auto &p : row) 
             sum += pdd_expr(p.coeff(), p.var(), dep);
         TRACE("grobner", c().print_row(row, tout) << " " << sum << "\n");
-        add_eq(sum, dep);
+        add_input(sum, dep);
     }
 
     void grobner::find_nl_cluster() {        
@@ -601,7 +673,8 @@ namespace nla {
             c().print_row(r, out) << std::endl;
     }
     
-    void grobner::set_level2var() {
+    // returns true if the variable order is unchanged, the pdds of the previous call are still valid then
+    bool grobner::set_level2var() {
         unsigned n = lra.column_count();
         unsigned_vector sorted_vars(n), weighted_vars(n);
         for (unsigned j = 0; j < n; j++) {
@@ -628,12 +701,17 @@ namespace nla {
         for (unsigned j = 0; j < n; j++)
             l2v[j] = sorted_vars[j];
 
-        m_pdd_manager.reset(l2v);
-
         TRACE("grobner",
             for (auto v : sorted_vars)
                 tout << "j" << v << " w:" << weighted_vars[v] << " ";
         tout << "\n");
+
+        // keeping the manager keeps its operation cache for the equations that are built again
+        if (c().params().arith_nl_grobner_incremental() && l2v == m_pdd_manager.get_level2var())
+            return true;
+        reset_basis();
+        m_pdd_manager.reset(l2v);
+        return false;
     }
 
     bool grobner::is_nla_conflict(const dd::solver::equation& eq) {
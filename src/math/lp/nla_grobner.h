@@ -28,6 +28,12 @@ namespace nla {
         unsigned                 m_delay = 0;
         bool                     m_add_all_eqs = false;
         std::unordered_map<unsigned_vector, lpvar, hash_svector> m_mon2var;
+        // the input equations of the basis in m_solver, they are kept alive so that their roots identify them
+        std::vector<std::pair<dd::pdd, u_dependency*>> m_inputs;
+        std::vector<std::pair<dd::pdd, u_dependency*>> m_new_inputs;
+        bool                     m_basis_valid = false;  // m_solver is saturated from m_inputs
+        unsigned                 m_scope_lvl = 0;
+        unsigned                 m_basis_lvl = 0;        // the dependencies of m_inputs live at this level
 
         lp::lp_settings& lp_settings();
 
@@ -56,7 +62,9 @@ namespace nla {
 
         // setup
         bool configure();
-        void set_level2var();
+        bool set_level2var();
+        bool reuse_basis();
+        void reset_basis();
         void find_nl_cluster();
         void prepare_rows_and_active_vars();
         void add_var_and_its_factors_to_q_and_collect_new_rows(lpvar j, svector<lpvar>& q);           
@@ -64,6 +72,7 @@ namespace nla {
         void add_fixed_monic(unsigned j);
         bool is_solved(dd::pdd const& p, unsigned& v, dd::pdd& r);
         void add_eq(dd::pdd& p, u_dependency* dep);        
+        void add_input(dd::pdd const& p, u_dependency* dep) { m_new_inputs.push_back({ p, dep }); }
         const rational& val_of_fixed_var_with_deps(lpvar j, u_dependency*& dep);
         dd::pdd pdd_expr(const rational& c, lpvar j, u_dependency*& dep);                
 
@@ -74,5 +83,7 @@ namespace nla {
         grobner(core *core);        
         void operator()();
         dd::solver::equation_vector const& core_equations(bool all_eqs);
+        void push() { ++m_scope_lvl; }
+        void pop(unsigned n);
     }; 
 }
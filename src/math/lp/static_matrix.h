@@ -67,6 +67,10 @@ class static_matrix
     std::stack<dim> m_stack;
 public:
     vector<int> m_vector_of_row_offsets;
+    // pivot row gathered by gather_pivot_row (structure of arrays, without the pivot column)
+    unsigned_vector m_pivot_row_vars;
+    vector<T> m_pivot_row_coeffs;
+    unsigned_vector m_zero_offsets;
     indexed_vector<T> m_work_vector;
     vector<row_strip<T>> m_rows;
     vector<column_strip> m_columns;
@@ -288,6 +292,10 @@ public:
 
     // pivot row i to row ii
     bool pivot_row_to_row_given_cell(unsigned i, column_cell& c, unsigned);
+    // copy row i without the pivot column to the dense buffers used by pivot_gathered_row_to_row_given_cell,
+    // it is done once when the row is pivoted to all rows of the pivot column
+    void gather_pivot_row(unsigned i, unsigned pivot_col);
+    bool pivot_gathered_row_to_row_given_cell(column_cell& c);
     void scan_row_ii_to_offset_vector(const row_strip<T> & rvals);
 
     void transpose_rows(unsigned i, unsigned ii) {
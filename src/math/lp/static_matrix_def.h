@@ -22,6 +22,8 @@ Revision History:
 #include "util/vector.h"
 #include <utility>
 #include <set>
+#include <algorithm>
+#include <functional>
 #include "math/lp/static_matrix.h"
 namespace lp {
 // each assignment for this matrix should be issued only once!!!
@@ -48,26 +50,68 @@ template <typename T, typename X> void static_matrix<T, X>::scan_row_ii_to_offse
 
 
 template <typename T, typename X> bool static_matrix<T, X>::pivot_row_to_row_given_cell(unsigned i, column_cell & c, unsigned pivot_col) {
+    lp_assert(i < row_count() && c.var() != i);
+    gather_pivot_row(i, pivot_col);
+    return pivot_gathered_row_to_row_given_cell(c);
+}
+
+template <typename T, typename X> void static_matrix<T, X>::gather_pivot_row(unsigned i, unsigned pivot_col) {
+    m_pivot_row_vars.reset();
+    m_pivot_row_coeffs.reset();
+    for (const auto & iv : m_rows[i]) {
+        if (iv.var() == pivot_col) continue;
+        lp_assert(!is_zero(iv.coeff()));
+        m_pivot_row_vars.push_back(iv.var());
+        m_pivot_row_coeffs.push_back(iv.coeff());
+    }
+}
+
+// add alpha times the gathered pivot row to row c.var(), eliminating the pivot column from it
+template <typename T, typename X> bool static_matrix<T, X>::pivot_gathered_row_to_row_given_cell(column_cell & c) {
     unsigned ii = c.var();
-    lp_assert(i < row_count() && ii < column_count() && i != ii);
+    lp_assert(ii < row_count());
     T alpha = -get_val(c);
     lp_assert(!is_zero(alpha));
     auto & rowii = m_rows[ii];
     remove_element(rowii, rowii[c.offset()]);
     scan_row_ii_to_offset_vector(rowii);
     unsigned prev_size_ii = rowii.size();
-    // run over the pivot row and update row ii
-    for (const auto & iv : m_rows[i]) {
-        unsigned j = iv.var();
-        if (j == pivot_col) continue;
-        lp_assert(!is_zero(iv.coeff()));
-        int j_offs = m_vector_of_row_offsets[j];
-        if (j_offs == -1) { // it is a new element
-            T alv = alpha * iv.coeff();
-            add_new_element(ii, j, alv);
+    unsigned const sz = m_pivot_row_vars.size();
+    unsigned const* vars = m_pivot_row_vars.data();
+    T const* coeffs = m_pivot_row_coeffs.data();
+    m_zero_offsets.reset();
+    // run over the pivot row and update row ii, unit multipliers (the common case) avoid the multiplication
+    if (alpha == one_of_type<T>()) {
+        for (unsigned k = 0; k < sz; ++k) {
+            int j_offs = m_vector_of_row_offsets[vars[k]];
+            if (j_offs == -1) 
+                add_new_element(ii, vars[k], coeffs[k]);
+            else if (is_zero(rowii[j_offs].coeff() += coeffs[k]))
+                m_zero_offsets.push_back(j_offs);
         }
-        else {
-            addmul(rowii[j_offs].coeff(), iv.coeff(), alpha);
+    }
+    else if (alpha == -one_of_type<T>()) {
+        for (unsigned k = 0; k < sz; ++k) {
+            int j_offs = m_vector_of_row_offsets[vars[k]];
+            if (j_offs == -1) 
+                add_new_element(ii, vars[k], -coeffs[k]);
+            else if (is_zero(rowii[j_offs].coeff() -= coeffs[k]))
+                m_zero_offsets.push_back(j_offs);
+        }
+    }
+    else {
+        for (unsigned k = 0; k < sz; ++k) {
+            int j_offs = m_vector_of_row_offsets[vars[k]];
+            if (j_offs == -1) { // it is a new element
+                T alv = alpha * coeffs[k];
+                add_new_element(ii, vars[k], alv);
+            }
+            else {
+                T & r = rowii[j_offs].coeff();
+                addmul(r, coeffs[k], alpha);
+                if (is_zero(r))
+                    m_zero_offsets.push_back(j_offs);
+            }
         }
     }
     // clean the work vector
@@ -75,11 +119,11 @@ template <typename T, typename X> bool static_matrix<T, X>::pivot_row_to_row_giv
         m_vector_of_row_offsets[rowii[k].var()] = -1;
     }
 
-    // remove zeroes
-    for (unsigned k = rowii.size(); k-- > 0;  ) {
-        if (is_zero(rowii[k].coeff()))
-            remove_element(rowii, rowii[k]);
-    }
+    // remove zeroes, only updated cells can become zero; the new cells are non-zero and at the end, so removing
+    // by decreasing offsets never moves a zero cell
+    std::sort(m_zero_offsets.begin(), m_zero_offsets.end(), std::greater<unsigned>());
+    for (unsigned k : m_zero_offsets) 
+        remove_element(rowii, rowii[k]);
     return !rowii.empty();
 }
 
@@ -81,15 +81,68 @@ namespace polynomial {
         };
     };
 
+    struct projection_entry {
+        unsigned_vector       m_key;      // x followed by the sorted ids of the polynomials
+        unsigned              m_hash;
+        ptr_vector<polynomial> m_result;
+        unsigned_vector       m_ends;
+
+        struct hash_proc { unsigned operator()(projection_entry const * entry) const { return entry->m_hash; } };
+
+        struct eq_proc {
+            bool operator()(projection_entry const * e1, projection_entry const * e2) const {
+                return e1->m_key == e2->m_key;
+            }
+        };
+    };
+
     typedef chashtable<polynomial*, poly_hash_proc, poly_eq_proc> polynomial_table;
+    struct derivative_entry {
+        polynomial const * m_p;
+        var                m_x;
+        unsigned           m_hash;
+        polynomial *       m_result;
+
+        derivative_entry(polynomial const * p, var x, unsigned h):
+            m_p(p),
+            m_x(x),
+            m_hash(h),
+            m_result(nullptr) {
+        }
+
+        struct hash_proc { unsigned operator()(derivative_entry const * entry) const { return entry->m_hash; } };
+
+        struct eq_proc { 
+            bool operator()(derivative_entry const * e1, derivative_entry const * e2) const {
+                return e1->m_p == e2->m_p && e1->m_x == e2->m_x;
+            }
+        };
+    };
+
     typedef chashtable<psc_chain_entry*, psc_chain_entry::hash_proc, psc_chain_entry::eq_proc> psc_chain_cache;
     typedef chashtable<factor_entry*, factor_entry::hash_proc, factor_entry::eq_proc> factor_cache;
+    typedef chashtable<derivative_entry*, derivative_entry::hash_proc, derivative_entry::eq_proc> derivative_cache;
+    typedef chashtable<projection_entry*, projection_entry::hash_proc, projection_entry::eq_proc> projection_cache;
     
+    struct cache_stats {
+        unsigned m_psc_chain_hits = 0;
+        unsigned m_psc_chain_misses = 0;
+        unsigned m_factor_hits = 0;
+        unsigned m_factor_misses = 0;
+        unsigned m_derivative_hits = 0;
+        unsigned m_derivative_misses = 0;
+        unsigned m_projection_hits = 0;
+        unsigned m_projection_misses = 0;
+    };
+
     struct cache::imp { 
         manager &                m;
+        cache_stats              m_stats;
         polynomial_table         m_poly_table;
         psc_chain_cache          m_psc_chain_cache;
         factor_cache             m_factor_cache;
+        derivative_cache         m_derivative_cache;
+        projection_cache         m_projection_cache;
         polynomial_ref_vector    m_cached_polys;
         svector<char>            m_in_cache;
         small_object_allocator & m_allocator;
@@ -100,6 +153,8 @@ namespace polynomial {
         ~imp() {
             reset_psc_chain_cache();
             reset_factor_cache();
+            reset_derivative_cache();
+            reset_projection_cache();
         }
 
         void del_psc_chain_entry(psc_chain_entry * entry) {
@@ -125,6 +180,20 @@ namespace polynomial {
             m_psc_chain_cache.reset();
         }
 
+        void reset_derivative_cache() {
+            for (derivative_entry * entry : m_derivative_cache) {
+                entry->~derivative_entry();
+                m_allocator.deallocate(sizeof(derivative_entry), entry);
+            }
+            m_derivative_cache.reset();
+        }
+
+        void reset_projection_cache() {
+            for (projection_entry * entry : m_projection_cache)
+                dealloc(entry);
+            m_projection_cache.reset();
+        }
+
         void reset_factor_cache() {
             factor_cache::iterator it  = m_factor_cache.begin();
             factor_cache::iterator end = m_factor_cache.end();
@@ -151,10 +220,17 @@ namespace polynomial {
         void psc_chain(polynomial * p, polynomial * q, var x, polynomial_ref_vector & S) {
             p = mk_unique(p);
             q = mk_unique(q);
+            // The chain is computed for the polynomial of the higher degree first, so (q, p) has the same chain.
+            // For equal degrees the principal subresultant coefficients of (q, p) and (p, q) only differ in sign.
+            // Use the same entry for both orders.
+            unsigned dp = m.degree(p, x), dq = m.degree(q, x);
+            if (dp < dq || (dp == dq && pid(p) > pid(q)))
+                std::swap(p, q);
             unsigned h = hash_u_u(pid(p), pid(q));
             psc_chain_entry * entry = new (m_allocator.allocate(sizeof(psc_chain_entry))) psc_chain_entry(p, q, x, h);
             psc_chain_entry * old_entry = m_psc_chain_cache.insert_if_not_there(entry); 
             if (entry != old_entry) {
+                m_stats.m_psc_chain_hits++;
                 entry->~psc_chain_entry();
                 m_allocator.deallocate(sizeof(psc_chain_entry), entry);
                 S.reset();
@@ -163,6 +239,7 @@ namespace polynomial {
                 }
             }
             else {
+                m_stats.m_psc_chain_misses++;
                 m.psc_chain(p, q, x, S);
                 unsigned sz = S.size();
                 entry->m_result_sz = sz;
@@ -175,6 +252,73 @@ namespace polynomial {
             }
         }
 
+        polynomial * derivative(polynomial * p, var x) {
+            p = mk_unique(p);
+            unsigned h = hash_u_u(pid(p), x);
+            derivative_entry * entry = new (m_allocator.allocate(sizeof(derivative_entry))) derivative_entry(p, x, h);
+            derivative_entry * old_entry = m_derivative_cache.insert_if_not_there(entry);
+            if (entry != old_entry) {
+                m_stats.m_derivative_hits++;
+                entry->~derivative_entry();
+                m_allocator.deallocate(sizeof(derivative_entry), entry);
+                return old_entry->m_result;
+            }
+            m_stats.m_derivative_misses++;
+            polynomial_ref d(m);
+            d = m.derivative(p, x);
+            entry->m_result = mk_unique(d);
+            return entry->m_result;
+        }
+
+        void psc_projection(polynomial_ref_vector const & ps, var x, polynomial_ref_vector & S, unsigned_vector & ends) {
+            S.reset();
+            ends.reset();
+            ptr_vector<polynomial> uniq;
+            for (polynomial * p : ps)
+                uniq.push_back(mk_unique(p));
+            std::sort(uniq.begin(), uniq.end(), [&](polynomial * p, polynomial * q) { return pid(p) < pid(q); });
+            uniq.shrink(static_cast<unsigned>(std::unique(uniq.begin(), uniq.end()) - uniq.begin()));
+            projection_entry * entry = alloc(projection_entry);
+            entry->m_key.push_back(x);
+            unsigned h = hash_u(x);
+            for (polynomial * p : uniq) {
+                entry->m_key.push_back(pid(p));
+                h = hash_u_u(h, pid(p));
+            }
+            entry->m_hash = h;
+            projection_entry * old_entry = m_projection_cache.insert_if_not_there(entry);
+            if (entry != old_entry) {
+                m_stats.m_projection_hits++;
+                dealloc(entry);
+                for (polynomial * s : old_entry->m_result)
+                    S.push_back(s);
+                ends.append(old_entry->m_ends);
+                return;
+            }
+            m_stats.m_projection_misses++;
+            polynomial_ref_vector chain(m);
+            auto add_chain = [&]() {
+                for (polynomial * s : chain) {
+                    S.push_back(s);
+                    entry->m_result.push_back(s);
+                }
+                ends.push_back(S.size());
+            };
+            for (polynomial * p : uniq) {
+                if (m.degree(p, x) < 2)
+                    continue;
+                psc_chain(p, derivative(p, x), x, chain);
+                add_chain();
+            }
+            for (unsigned i = 0; i + 1 < uniq.size(); ++i) {
+                for (unsigned j = i + 1; j < uniq.size(); ++j) {
+                    psc_chain(uniq[i], uniq[j], x, chain);
+                    add_chain();
+                }
+            }
+            entry->m_ends.append(ends);
+        }
+
         void factor(polynomial * p, polynomial_ref_vector & distinct_factors) {
             distinct_factors.reset();
             p = mk_unique(p);
@@ -182,6 +326,7 @@ namespace polynomial {
             factor_entry * entry = new (m_allocator.allocate(sizeof(factor_entry))) factor_entry(p, h);
             factor_entry * old_entry = m_factor_cache.insert_if_not_there(entry); 
             if (entry != old_entry) {
+                m_stats.m_factor_hits++;
                 entry->~factor_entry();
                 m_allocator.deallocate(sizeof(factor_entry), entry);
                 distinct_factors.reset();
@@ -190,6 +335,7 @@ namespace polynomial {
                 }
             }
             else {
+                m_stats.m_factor_misses++;
                 factors fs(m);
                 m.factor(p, fs);
                 unsigned sz = fs.distinct_factors();
@@ -224,13 +370,39 @@ namespace polynomial {
         m_imp->psc_chain(const_cast<polynomial*>(p), const_cast<polynomial*>(q), x, S);
     }
 
+    polynomial * cache::derivative(polynomial const * p, var x) {
+        return m_imp->derivative(const_cast<polynomial*>(p), x);
+    }
+
+    void cache::psc_projection(polynomial_ref_vector const & ps, var x, polynomial_ref_vector & S, unsigned_vector & ends) {
+        m_imp->psc_projection(ps, x, S, ends);
+    }
+
     void cache::factor(polynomial const * p, polynomial_ref_vector & distinct_factors) {
         m_imp->factor(const_cast<polynomial*>(p), distinct_factors);
     }
     
     void cache::reset() {
         manager & _m = m();
+        cache_stats st = m_imp->m_stats;
         dealloc(m_imp);
         m_imp = alloc(imp, _m);
+        m_imp->m_stats = st;
+    }
+
+    void cache::collect_statistics(statistics & st) const {
+        cache_stats const & s = m_imp->m_stats;
+        st.update("polynomial psc cache hits", s.m_psc_chain_hits);
+        st.update("polynomial psc cache misses", s.m_psc_chain_misses);
+        st.update("polynomial factor cache hits", s.m_factor_hits);
+        st.update("polynomial factor cache misses", s.m_factor_misses);
+        st.update("polynomial derivative cache hits", s.m_derivative_hits);
+        st.update("polynomial derivative cache misses", s.m_derivative_misses);
+        st.update("polynomial projection cache hits", s.m_projection_hits);
+        st.update("polynomial projection cache misses", s.m_projection_misses);
+    }
+
+    void cache::reset_statistics() {
+        m_imp->m_stats = cache_stats();
     }
 };
@@ -19,6 +19,7 @@ Notes:
 #pragma once
 
 #include "math/polynomial/polynomial.h"
+#include "util/statistics.h"
 
 namespace polynomial {
 
@@ -36,7 +37,26 @@ namespace polynomial {
         polynomial * mk_unique(polynomial * p);
         void psc_chain(polynomial const * p, polynomial const * q, var x, polynomial_ref_vector & S);
         void factor(polynomial const * p, polynomial_ref_vector & distinct_factors);
+        /**
+           \brief Return the (unique) derivative of p with respect to x.
+        */
+        polynomial * derivative(polynomial const * p, var x);
+        /**
+           \brief Store in S the psc chains of (p, dp/dx) for each p of degree at least 2 in ps
+           followed by the psc chains of all pairs of distinct polynomials of ps. The chain i
+           ends at position ends[i] of S.
+
+           The result is cached for the set of (unique) polynomials and x.
+
+           \pre all polynomials in ps contain x
+        */
+        void psc_projection(polynomial_ref_vector const & ps, var x, polynomial_ref_vector & S, unsigned_vector & ends);
+        /**
+           \brief Remove all polynomials and cached results, the statistics are kept.
+        */
         void reset();
+        void collect_statistics(statistics & st) const;
+        void reset_statistics();
     };
 };
 
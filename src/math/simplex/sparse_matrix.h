@@ -135,6 +135,8 @@ namespace simplex {
         vector<_row>            m_rows;
         svector<unsigned>       m_dead_rows;        // rows to recycle
         vector<column>          m_columns;          // per var
+        vector<_row>            m_free_rows;        // rows emptied by reset, their entries are reused by mk_row
+        vector<column>          m_free_columns;     // columns emptied by reset, reused by ensure_var
         svector<int>            m_var_pos;          // temporary map from variables to positions in row
         unsigned_vector         m_var_pos_idx;      // indices in m_var_pos
         stats                   m_stats;
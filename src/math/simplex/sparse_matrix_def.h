@@ -263,11 +263,23 @@ namespace simplex {
         }
     }
 
+    /**
+       \brief Remove all rows and columns. Their entry storage is kept for the rows
+       and columns of the next use of the matrix, so that a matrix that is
+       reset and filled again does not go to the allocator for every row.
+    */
     template<typename Ext>
     void sparse_matrix<Ext>::reset() {
-        reset_rows();
+        for (auto& r : m_rows) {
+            r.reset(m);
+            m_free_rows.push_back(std::move(r));
+        }
         m_rows.reset();
         m_dead_rows.reset();
+        for (auto& c : m_columns) {
+            c.reset();
+            m_free_columns.push_back(std::move(c));
+        }
         m_columns.reset();
         m_var_pos.reset();
         m_var_pos_idx.reset();
@@ -277,7 +289,12 @@ namespace simplex {
     template<typename Ext>
     void sparse_matrix<Ext>::ensure_var(var_t v) {
         while (m_columns.size() <= v) {
-            m_columns.push_back(column());
+            if (m_free_columns.empty())
+                m_columns.push_back(column());
+            else {
+                m_columns.push_back(std::move(m_free_columns.back()));
+                m_free_columns.pop_back();
+            }
             m_var_pos.push_back(-1);
         }
     }
@@ -287,7 +304,12 @@ namespace simplex {
     sparse_matrix<Ext>::mk_row() {
         if (m_dead_rows.empty()) {
             row r(m_rows.size());
-            m_rows.push_back(_row());            
+            if (m_free_rows.empty())
+                m_rows.push_back(_row());            
+            else {
+                m_rows.push_back(std::move(m_free_rows.back()));
+                m_free_rows.pop_back();
+            }
             return r;
         }
         else {
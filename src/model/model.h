@@ -110,6 +110,8 @@ public:
     bool is_false(expr_ref_vector const& ts);
     bool are_equal(expr* s, expr* t);
     void reset_eval_cache();
+    void set_incremental_eval(bool f) { m_mev.set_incremental(f); }
+    void invalidate_eval_cache(func_decl* f) { m_mev.invalidate(f); }
     bool has_solver(); 
     void set_solver(expr_solver* solver);
     void add_rec_funs();
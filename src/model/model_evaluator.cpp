@@ -727,17 +727,147 @@ struct evaluator_cfg : public default_rewriter_cfg {
 
 struct model_evaluator::imp : public rewriter_tpl<mev::evaluator_cfg> {
     mev::evaluator_cfg m_cfg;
+
+    // incremental evaluation:
+    // the values of subterms are kept until a declaration they depend on is invalidated.
+    bool                              m_incremental = false;
+    obj_map<expr, expr*>              m_values;      // the values are referenced
+    obj_map<expr, ptr_vector<expr>>   m_parents;     // parents of the terms among the linked terms
+    obj_map<func_decl, ptr_vector<expr>> m_decl2terms; // linked terms by their declaration
+    ptr_vector<expr>                  m_opaque;      // terms evaluated as a whole, invalidated on every change
+    expr_mark                         m_linked;
+    expr_ref_vector                   m_inc_pinned;
+
     imp(model_core & md, params_ref const & p):
         rewriter_tpl<mev::evaluator_cfg>(md.get_manager(),
                                     false, // no proofs for evaluator
                                     m_cfg),
-        m_cfg(md.get_manager(), md, p) {
+        m_cfg(md.get_manager(), md, p),
+        m_inc_pinned(md.get_manager()) {
+    }
+    ~imp() {
+        reset_incremental();
     }
     void expand_stores(expr_ref &val) {m_cfg.expand_stores(val);}
     void reset() {
         rewriter_tpl<mev::evaluator_cfg>::reset();
         m_cfg.reset();
         m_cfg.m_def_cache.reset();
+        reset_incremental();
+    }
+
+    void reset_incremental() {
+        for (auto const& [k, v] : m_values)
+            m().dec_ref(v);
+        m_values.reset();
+        m_parents.reset();
+        m_decl2terms.reset();
+        m_opaque.reset();
+        m_linked.reset();
+        m_inc_pinned.reset();
+    }
+
+    void set_value(expr* e, expr* v) {
+        m().inc_ref(v);
+        m_values.insert(e, v);
+    }
+
+    void link(app* a) {
+        if (m_linked.is_marked(a))
+            return;
+        m_linked.mark(a, true);
+        m_inc_pinned.push_back(a);
+        for (expr* arg : *a)
+            m_parents.insert_if_not_there(arg, ptr_vector<expr>()).push_back(a);
+        m_decl2terms.insert_if_not_there(a->get_decl(), ptr_vector<expr>()).push_back(a);
+    }
+
+    /**
+       \brief Evaluate t bottom-up, reusing the values of subterms that are still valid.
+       Each application is evaluated by rewriting its declaration applied to the values of its arguments.
+    */
+    void eval_incremental(expr* t, expr_ref& result) {
+        ptr_buffer<expr> todo, vals;
+        expr_ref r(m());
+        todo.push_back(t);
+        while (!todo.empty()) {
+            expr* e = todo.back();
+            if (m_values.contains(e)) {
+                todo.pop_back();
+                continue;
+            }
+            if (!is_app(e)) {
+                (*this)(e, r);
+                m_opaque.push_back(e);
+                m_inc_pinned.push_back(e);
+                set_value(e, r);
+                todo.pop_back();
+                continue;
+            }
+            app* a = to_app(e);
+            expr* c, * th, * el, * v;
+            if (m().is_ite(a, c, th, el)) {
+                // only the branch selected by the value of the condition is evaluated
+                if (!m_values.find(c, v)) {
+                    todo.push_back(c);
+                    continue;
+                }
+                expr* br = m().is_true(v) ? th : m().is_false(v) ? el : nullptr;
+                if (br) {
+                    expr* bv;
+                    if (!m_values.find(br, bv)) {
+                        todo.push_back(br);
+                        continue;
+                    }
+                    link(a);
+                    set_value(a, bv);
+                    todo.pop_back();
+                    continue;
+                }
+            }
+            bool ready = true;
+            for (expr* arg : *a) {
+                if (!m_values.contains(arg)) {
+                    todo.push_back(arg);
+                    ready = false;
+                }
+            }
+            if (!ready)
+                continue;
+            vals.reset();
+            for (expr* arg : *a)
+                vals.push_back(m_values[arg]);
+            app_ref na(m().mk_app(a->get_decl(), vals.size(), vals.data()), m());
+            (*this)(na, r);
+            link(a);
+            set_value(a, r);
+            todo.pop_back();
+        }
+        result = m_values[t];
+    }
+
+    void invalidate(func_decl* f) {
+        m_cfg.m_def_cache.remove(f);
+        // the rewriter cache may contain applications of f to values
+        rewriter_tpl<mev::evaluator_cfg>::reset();
+        ptr_vector<expr> todo;
+        auto* ts = m_decl2terms.find_core(f);
+        if (ts)
+            todo.append(ts->get_data().m_value);
+        todo.append(m_opaque);
+        m_opaque.reset();
+        while (!todo.empty()) {
+            expr* e = todo.back();
+            todo.pop_back();
+            expr* v;
+            if (!m_values.find(e, v))
+                continue;
+            m_values.remove(e);
+            m().dec_ref(v);
+            auto* ps = m_parents.find_core(e);
+            if (ps)
+                todo.append(ps->get_data().m_value);
+        }
     }
 };
 
@@ -782,8 +912,10 @@ unsigned model_evaluator::get_num_steps() const {
 
 void model_evaluator::cleanup(params_ref const & p) {
     model_core & md = m_imp->cfg().m_model;
+    bool incremental = m_imp->m_incremental;
     m_imp->~imp();
     new (m_imp) imp(md, p);
+    m_imp->m_incremental = incremental;
 }
 
 void model_evaluator::reset(params_ref const & p) {
@@ -792,14 +924,33 @@ void model_evaluator::reset(params_ref const & p) {
 }
 
 void model_evaluator::reset(model_core &model, params_ref const& p) {
+    bool incremental = m_imp->m_incremental;
     m_imp->~imp();
     new (m_imp) imp(model, p);
+    m_imp->m_incremental = incremental;
+}
+
+
+void model_evaluator::set_incremental(bool f) {
+    if (m_imp->m_incremental != f) {
+        m_imp->reset_incremental();
+        m_imp->m_incremental = f;
+    }
 }
 
+void model_evaluator::invalidate(func_decl* f) {
+    if (m_imp->m_incremental)
+        m_imp->invalidate(f);
+    else
+        reset();
+}
 
 void model_evaluator::operator()(expr * t, expr_ref & result) {
     TRACE("model_evaluator", tout << mk_ismt2_pp(t, m()) << "\n";);
-    m_imp->operator()(t, result);
+    if (m_imp->m_incremental)
+        m_imp->eval_incremental(t, result);
+    else
+        m_imp->operator()(t, result);
     m_imp->expand_stores(result);
     TRACE("model_evaluator", tout << "eval: " << mk_ismt2_pp(t, m()) << " --> " << result << "\n";);
 }
@@ -66,6 +66,20 @@ public:
      */
     expr_ref eval_array_eq(app* e, expr* arg1, expr* arg2);
 
+    /**
+       \brief Keep the values of subterms across evaluations, also when the model is updated.
+       After changing the interpretation of f, call invalidate(f); then only the terms that
+       contain f are evaluated again. Interpretations of other declarations that refer to f
+       are not tracked and need to be invalidated as well.
+    */
+    void set_incremental(bool f);
+
+    /**
+       \brief Drop the cached values that depend on the interpretation of f.
+       Without incremental evaluation the whole cache is dropped.
+    */
+    void invalidate(func_decl* f);
+
     void cleanup(params_ref const & p = params_ref());
     void reset(params_ref const & p = params_ref());
     void reset(model_core& model, params_ref const & p = params_ref());
@@ -44,14 +44,21 @@ bool spacer_arith_kernel::compute_kernel() {
 
 namespace {
 class simplex_arith_kernel_plugin : public spacer_arith_kernel::plugin {
+    using qmatrix = simplex::sparse_matrix<simplex::mpq_ext>;
+    unsynch_mpq_manager m;
+    // kept between calls so that their row storage is reused
+    qmatrix m_qmat;
+    qmatrix m_kern;
+
   public:
-    simplex_arith_kernel_plugin() {}
+    simplex_arith_kernel_plugin() : m_qmat(m), m_kern(m) {}
 
     bool compute_kernel(const spacer_matrix &in, spacer_matrix &out,
                         vector<unsigned> &basics) override {
-        using qmatrix = simplex::sparse_matrix<simplex::mpq_ext>;
-        unsynch_mpq_manager m;
-        qmatrix qmat(m);
+        qmatrix &qmat = m_qmat;
+        qmatrix &kern = m_kern;
+        qmat.reset();
+        kern.reset();
 
         // extra column for column of 1
         qmat.ensure_var(in.num_cols());
@@ -66,7 +73,6 @@ class simplex_arith_kernel_plugin : public spacer_arith_kernel::plugin {
         }
         TRACE("gg", qmat.display(tout););
 
-        qmatrix kern(m);
         simplex::sparse_matrix_ops::kernel_ffe<simplex::mpq_ext>(qmat, kern,
                                                                  basics);
 
@@ -1338,6 +1338,17 @@ bool pred_transformer::is_qblocked (pob &n) {
 void pred_transformer::mbp(app_ref_vector &vars, expr_ref &fml, model &mdl,
                            bool reduce_all_selects, bool force) {
     scoped_watch _t_(m_mbp_watch);
+    if (use_native_mbp()) {
+        // same as qe_project, but with the session of the context, which reuses
+        // the projections of repeated queries
+        params_ref p;
+        p.set_bool("reduce_all_selects", reduce_all_selects);
+        p.set_bool("dont_sub", !force);
+        qe::mbproj &mbp = ctx.get_mbp();
+        mbp.updt_params(p);
+        mbp.spacer(vars, mdl, fml);
+        return;
+    }
     qe_project(m, vars, fml, mdl, reduce_all_selects, use_native_mbp(), !force);
 }
 
@@ -2284,6 +2295,7 @@ context::context(fp_params const& params, ast_manager& m) :
     m(m),
     m_context(nullptr),
     m_pm(m),
+    m_mbp(m),
     m_query_pred(m),
     m_query(nullptr),
     m_pob_queue(),
@@ -4125,6 +4137,7 @@ void context::collect_statistics(statistics& st) const
     m_pool0->collect_statistics(st);
     m_pool1->collect_statistics(st);
     m_pool2->collect_statistics(st);
+    m_mbp.collect_statistics(st);
 
     for (auto const& kv : m_rels) {
         kv.m_value->collect_statistics(st);
@@ -4290,7 +4303,9 @@ void context::new_lemma_eh(pred_transformer &pt, lemma *lem) {
     }
     if (!handle)
         return;
-    if ((is_infty_level(lem->level()) && m_params.spacer_p3_share_invariants()) ||
+    // all lemmas are exchanged between the instances of a parallel run
+    if (m_params.spacer_threads() > 1 ||
+        (is_infty_level(lem->level()) && m_params.spacer_p3_share_invariants()) ||
         (!is_infty_level(lem->level()) && m_params.spacer_p3_share_lemmas())) {
         expr_ref_vector args(m);
         for (unsigned i = 0; i < pt.sig_size(); ++i) {
@@ -32,6 +32,7 @@ Notes:
 #include "muz/spacer/spacer_prop_solver.h"
 #include "muz/spacer/spacer_sem_matcher.h"
 #include "util/scoped_ptr_vector.h"
+#include "qe/qe_mbp.h"
 
 #include "muz/base/fp_params.hpp"
 
@@ -1137,6 +1138,9 @@ class context {
     scoped_ptr<solver_pool> m_pool1;
     scoped_ptr<solver_pool> m_pool2;
 
+    // projection session shared by all calls of native MBP
+    qe::mbproj           m_mbp;
+
     random_gen           m_random;
     spacer_children_order m_children_order;
     decl2rel             m_rels;         // Map from relation predicate to fp-operator.
@@ -1271,6 +1275,7 @@ class context {
     const fp_params &get_params() const { return m_params; }
     bool use_eq_prop() const { return m_use_eq_prop; }
     bool use_native_mbp() const { return m_use_native_mbp; }
+    qe::mbproj &get_mbp() { return m_mbp; }
     bool use_ground_pob() const { return m_ground_pob; }
     bool use_instantiate() const { return m_instantiate; }
     bool weak_abs() const { return m_weak_abs; }
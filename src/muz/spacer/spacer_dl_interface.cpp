@@ -35,6 +35,7 @@ Revision History:
 #include "ast/scoped_proof.h"
 #include "muz/transforms/dl_transforms.h"
 #include "muz/spacer/spacer_callback.h"
+#include "muz/spacer/spacer_parallel.h"
 
 using namespace spacer;
 
@@ -81,6 +82,15 @@ void dl_interface::check_reset()
 }
 
 
+lbool dl_interface::solve(unsigned from_lvl)
+{
+    unsigned num_threads = m_ctx.get_params().spacer_threads();
+    if (num_threads > 1 && !m_ctx.get_params().spacer_gpdr()) {
+        return solve_parallel(*m_context, m_spacer_rules, from_lvl, num_threads);
+    }
+    return m_context->solve(from_lvl);
+}
+
 lbool dl_interface::query(expr * query)
 {
     //we restore the initial state in the datalog context
@@ -164,7 +174,7 @@ lbool dl_interface::query(expr * query)
         return l_false;
     }
 
-    return m_context->solve(m_ctx.get_params().spacer_min_level());
+    return solve(m_ctx.get_params().spacer_min_level());
 
 }
 
@@ -257,7 +267,7 @@ lbool dl_interface::query_from_lvl(expr * query, unsigned lvl)
         return l_false;
     }
 
-    return m_context->solve(lvl);
+    return solve(lvl);
 
 }
 
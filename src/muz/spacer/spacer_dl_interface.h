@@ -41,6 +41,7 @@ class dl_interface : public datalog::engine_base {
     ast_ref_vector    m_refs;
 
     void check_reset();
+    lbool solve(unsigned from_lvl);
 
 public:
     dl_interface(datalog::context& ctx);
@@ -0,0 +1,250 @@
+/**++
+Copyright (c) 2017 Microsoft Corporation
+
+Module Name:
+
+    spacer_parallel.cpp
+
+Abstract:
+
+    Parallel SPACER: helper instances exchanging lemmas with the main instance
+
+Author:
+
+
+Notes:
+
+--*/
+
+#include "ast/ast_translation.h"
+#include "ast/rewriter/expr_safe_replace.h"
+#include "muz/base/dl_context.h"
+#include "muz/base/fp_params.hpp"
+#include "muz/spacer/spacer_context.h"
+#include "muz/spacer/spacer_parallel.h"
+#include "smt/params/smt_params.h"
+#include "util/cancel_eh.h"
+#include "util/scoped_ptr_vector.h"
+#ifndef SINGLE_THREAD
+#include <mutex>
+#include <thread>
+#endif
+
+namespace spacer {
+
+#ifndef SINGLE_THREAD
+
+    namespace {
+
+        /**
+           Lemmas published by the instances, stored in a manager of their own.
+           A property is over the variables 0, ..., n-1 standing for the
+           arguments of its predicate (as expected by context::add_cover).
+        */
+        class lemma_exchange {
+            struct entry {
+                unsigned   m_source;
+                func_decl* m_pred;
+                expr*      m_property;
+                unsigned   m_level;
+            };
+            std::mutex          m_mux;
+            ast_manager         m;
+            vector<entry>       m_entries;
+            ast_ref_vector      m_pinned;
+        public:
+            lemma_exchange(ast_manager& main): m(main, true), m_pinned(m) {}
+
+            void publish(unsigned source, ast_manager& from, func_decl* pred, expr* property, unsigned level) {
+                std::lock_guard<std::mutex> lock(m_mux);
+                ast_translation tr(from, m);
+                func_decl* p = tr(pred);
+                expr* e = tr(property);
+                m_pinned.push_back(p);
+                m_pinned.push_back(e);
+                m_entries.push_back({ source, p, e, level });
+            }
+
+            /**
+               Translate the lemmas from position next on that were not
+               published by dest; returns the new position.
+            */
+            unsigned fetch(unsigned dest, unsigned next, ast_manager& to, func_decl_ref_vector& preds,
+                           expr_ref_vector& properties, unsigned_vector& levels) {
+                std::lock_guard<std::mutex> lock(m_mux);
+                ast_translation tr(m, to);
+                for (; next < m_entries.size(); ++next) {
+                    entry const& e = m_entries[next];
+                    if (e.m_source == dest)
+                        continue;
+                    preds.push_back(tr(e.m_pred));
+                    properties.push_back(tr(e.m_property));
+                    levels.push_back(e.m_level);
+                }
+                return next;
+            }
+        };
+
+        /**
+           Publishes the new lemmas of an instance and imports the lemmas of
+           the others before each proof obligation and each new level.
+        */
+        class exchange_callback : public spacer_callback {
+            unsigned        m_id;
+            lemma_exchange& m_exchange;
+            unsigned        m_next = 0;
+            bool            m_importing = false;
+            unsigned        m_num_imported = 0;
+
+            void import() {
+                ast_manager& m = m_context.get_ast_manager();
+                func_decl_ref_vector preds(m);
+                expr_ref_vector properties(m);
+                unsigned_vector levels;
+                m_next = m_exchange.fetch(m_id, m_next, m, preds, properties, levels);
+                flet<bool> _importing(m_importing, true);
+                for (unsigned i = 0; i < preds.size(); ++i) {
+                    // skip predicates only known to the rules of the publisher
+                    if (!m_context.get_pred_transformers().contains(preds.get(i)))
+                        continue;
+                    int level = is_infty_level(levels[i]) ? -1 : static_cast<int>(levels[i]);
+                    m_context.add_cover(level, preds.get(i), properties.get(i));
+                    ++m_num_imported;
+                }
+            }
+
+        public:
+            exchange_callback(context& ctx, unsigned id, lemma_exchange& ex):
+                spacer_callback(ctx), m_id(id), m_exchange(ex) {}
+
+            unsigned num_imported() const { return m_num_imported; }
+
+            bool new_lemma() override { return true; }
+
+            void new_lemma_eh(expr* lemma, unsigned level) override {
+                if (m_importing)
+                    return;
+                ast_manager& m = m_context.get_ast_manager();
+                expr* head, *body;
+                if (!m.is_implies(lemma, head, body) || !is_app(head) || !is_ground(body))
+                    return;
+                app* h = to_app(head);
+                expr_safe_replace sub(m);
+                for (unsigned i = 0; i < h->get_num_args(); ++i)
+                    sub.insert(h->get_arg(i), m.mk_var(i, h->get_arg(i)->get_sort()));
+                expr_ref property(body, m);
+                sub(property);
+                m_exchange.publish(m_id, m, h->get_decl(), property, level);
+            }
+
+            bool predecessor() override { return true; }
+            void predecessor_eh() override { import(); }
+
+            bool unfold() override { return true; }
+            void unfold_eh() override { import(); }
+        };
+
+        class no_engine : public datalog::register_engine_base {
+        public:
+            datalog::engine_base* mk_engine(datalog::DL_ENGINE engine_type) override { return nullptr; }
+            void set_context(datalog::context* ctx) override {}
+        };
+
+        /**
+           A helper instance with a copy of the rules in its own manager.
+        */
+        struct helper {
+            ast_manager             m;
+            smt_params              m_fparams;
+            no_engine               m_engine;
+            datalog::context        m_dctx;
+            scoped_ptr<context>     m_ctx;
+
+            helper(ast_manager& main, datalog::context& main_dctx, params_ref const& p):
+                m(main, true),
+                m_fparams(main_dctx.get_fparams()),
+                m_dctx(m, m_engine, m_fparams, p) {}
+        };
+    }
+
+    lbool solve_parallel(context& ctx, datalog::rule_set const& rules, unsigned from_lvl, unsigned num_threads) {
+        ast_manager& m = ctx.get_ast_manager();
+        datalog::context& dctx = rules.get_context();
+        func_decl* query_pred = rules.get_output_predicate();
+        lemma_exchange exchange(m);
+
+        // the helpers are set up by this thread, since they read the terms of m
+        scoped_ptr_vector<helper> helpers;
+        for (unsigned i = 1; i < num_threads; ++i) {
+            params_ref p;
+            p.copy(dctx.get_params().p);
+            p.set_uint("spacer.random_seed", dctx.get_params().spacer_random_seed() + i);
+            helper* h = alloc(helper, m, dctx, p);
+            helpers.push_back(h);
+            ast_translation tr(m, h->m);
+            expr_ref fml(m);
+            for (datalog::rule* r : rules) {
+                dctx.get_rule_manager().to_formula(*r, fml);
+                h->m_dctx.register_predicate(tr(r->get_decl()), false);
+                for (unsigned j = 0; j < r->get_uninterpreted_tail_size(); ++j)
+                    h->m_dctx.register_predicate(tr(r->get_decl(j)), false);
+                h->m_dctx.add_rule(tr(fml.get()), r->name());
+            }
+            datalog::rule_set& hrules = h->m_dctx.get_rules();
+            hrules.set_output_predicate(tr(query_pred));
+            hrules.close();
+            h->m_ctx = alloc(context, h->m_dctx.get_params(), h->m);
+            h->m_ctx->set_query(tr(query_pred));
+            h->m_ctx->update_rules(hrules);
+            h->m_ctx->callbacks().push_back(alloc(exchange_callback, *h->m_ctx, i, exchange));
+        }
+        exchange_callback* cb = alloc(exchange_callback, ctx, 0, exchange);
+        ctx.callbacks().push_back(cb);
+
+        lbool result = l_undef;
+        {
+            scoped_limits sl(m.limit());
+            for (helper* h : helpers)
+                sl.push_child(&(h->m.limit()));
+            vector<std::thread> threads;
+            for (unsigned i = 0; i < helpers.size(); ++i) {
+                helper* h = helpers[i];
+                threads.push_back(std::thread([h, i, from_lvl]() {
+                    try {
+                        h->m_ctx->solve(from_lvl);
+                    }
+                    catch (z3_exception& ex) {
+                        IF_VERBOSE(1, verbose_stream() << "(spacer.parallel helper " << (i + 1) << " stopped: " << ex.msg() << ")\n");
+                    }
+                }));
+            }
+            auto stop = [&]() {
+                for (helper* h : helpers)
+                    h->m.limit().cancel();
+                for (auto& th : threads)
+                    th.join();
+            };
+            try {
+                result = ctx.solve(from_lvl);
+            }
+            catch (...) {
+                stop();
+                ctx.callbacks().pop_back();
+                throw;
+            }
+            stop();
+        }
+        IF_VERBOSE(1, verbose_stream() << "(spacer.parallel :imported-lemmas " << cb->num_imported() << ")\n");
+        ctx.callbacks().pop_back();
+        return result;
+    }
+
+#else
+
+    lbool solve_parallel(context& ctx, datalog::rule_set const& rules, unsigned from_lvl, unsigned num_threads) {
+        return ctx.solve(from_lvl);
+    }
+
+#endif
+
+}
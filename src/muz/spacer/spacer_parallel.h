@@ -0,0 +1,45 @@
+/**++
+Copyright (c) 2017 Microsoft Corporation
+
+Module Name:
+
+    spacer_parallel.h
+
+Abstract:
+
+    Parallel SPACER: helper instances exchanging lemmas with the main instance
+
+Author:
+
+
+Notes:
+
+--*/
+
+#pragma once
+
+#include "util/lbool.h"
+#include "muz/base/dl_rule_set.h"
+
+namespace spacer {
+
+    class context;
+
+    /**
+       Solve the query of ctx over rules with num_threads - 1 helper
+       instances of spacer running in the background.
+
+       Every helper has its own manager, a copy of the rules and a different
+       random seed, so it explores the proof obligations in a different
+       order. Ground lemmas learned by any instance are published to a shared
+       store and imported by the other instances between two proof
+       obligations. The lemmas of a level over-approximate the states
+       reachable in that many steps in every instance, so they can be added
+       to the frames of the same level anywhere.
+
+       ctx stays the only instance whose frames decide the result: the
+       helpers are canceled once it finishes, so models, invariants and
+       certificates are those of ctx.
+    */
+    lbool solve_parallel(context& ctx, datalog::rule_set const& rules, unsigned from_lvl, unsigned num_threads);
+}
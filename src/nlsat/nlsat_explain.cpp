@@ -38,6 +38,8 @@ namespace nlsat {
         polynomial_ref_vector   m_ps;
         polynomial_ref_vector   m_ps2;
         polynomial_ref_vector   m_psc_tmp;
+        polynomial_ref_vector   m_psc_chains;
+        unsigned_vector         m_psc_ends;
         polynomial_ref_vector   m_factors, m_factors_save;
         scoped_anum_vector      m_roots_tmp;
         bool                    m_simplify_cores;
@@ -141,6 +143,7 @@ namespace nlsat {
             m_ps(m_pm),
             m_ps2(m_pm),
             m_psc_tmp(m_pm),
+            m_psc_chains(m_pm),
             m_factors(m_pm),
             m_factors_save(m_pm),
             m_roots_tmp(m_am),
@@ -230,7 +233,6 @@ namespace nlsat {
            \brief Wrapper for psc chain computation
         */
         void psc_chain(polynomial_ref & p, polynomial_ref & q, unsigned x, polynomial_ref_vector & result) {
-            // TODO caching
             SASSERT(max_var(p) == max_var(q));
             SASSERT(max_var(p) == x);
             m_cache.psc_chain(p, q, x, result);
@@ -663,8 +665,16 @@ namespace nlsat {
                       s = S.get(i);
                       tout << "psc: " << s << "\n";
                   });
+            add_psc(S, 0, sz);
+        }
 
-            for (unsigned i = 0; i < sz; i++) {
+        /**
+           \brief Add the first non-vanishing element of the psc chain S[begin], ..., S[end-1]
+           into m_todo, polynomials that vanish before it become zero assumptions.
+        */
+        void add_psc(polynomial_ref_vector const & S, unsigned begin, unsigned end) {
+            polynomial_ref s(m_pm);
+            for (unsigned i = begin; i < end; i++) {
                 s = S.get(i);
                 TRACE("nlsat_explain", display(tout << "processing psc(" << i << ")\n", s) << "\n";); 
                 if (is_zero(s)) {
@@ -680,14 +690,7 @@ namespace nlsat {
                     add_zero_assumption(s);
                     continue;
                 }
-                TRACE("nlsat_explain", 
-                      tout << "adding v-psc of\n";
-                      display(tout, p);
-                      tout << "\n";
-                      display(tout, q);
-                      tout << "\n---->\n";
-                      display(tout, s);
-                      tout << "\n";);
+                TRACE("nlsat_explain", tout << "adding v-psc\n"; display(tout, s); tout << "\n";);
                 // s did not vanish completely, but its leading coefficient may have vanished
                 add_factors(s);
                 return; 
@@ -710,7 +713,7 @@ namespace nlsat {
                 p = ps.get(i);
                 if (degree(p, x) < 2)
                     continue;
-                p_prime = derivative(p, x);
+                p_prime = m_cache.derivative(p, x);
                 psc(p, p_prime, x);
             }
         }
@@ -736,6 +739,19 @@ namespace nlsat {
             }
         }
 
+        /**
+           \brief psc_discriminant and psc_resultant with the psc chains of the whole set ps
+           taken from the projection cache, which persists across conflicts.
+        */
+        void psc_projection(polynomial_ref_vector & ps, var x) {
+            m_cache.psc_projection(ps, x, m_psc_chains, m_psc_ends);
+            unsigned begin = 0;
+            for (unsigned end : m_psc_ends) {
+                add_psc(m_psc_chains, begin, end);
+                begin = end;
+            }
+        }
+
         void test_root_literal(atom::kind k, var y, unsigned i, poly * p, scoped_literal_vector& result) {
             m_result = &result;
             add_root_literal(k, y, i, p);
@@ -1029,8 +1045,7 @@ namespace nlsat {
                 TRACE("nlsat_explain", tout << "project loop, processing var "; display_var(tout, x); tout << "\npolynomials\n";
                       display(tout, ps); tout << "\n";);
                 add_lc(ps, x);
-                psc_discriminant(ps, x);
-                psc_resultant(ps, x);
+                psc_projection(ps, x);
                 if (m_todo.empty())
                     break;
                 x = m_todo.remove_max_polys(ps);
@@ -74,7 +74,13 @@ Notes:
 #include "opt/maxsmt.h"
 #include "opt/maxcore.h"
 #include "opt/totalizer.h"
+#include "ast/ast_translation.h"
+#include "util/cancel_eh.h"
 #include <iostream>
+#ifndef SINGLE_THREAD
+#include <mutex>
+#include <thread>
+#endif
 
 using namespace opt;
 
@@ -135,9 +141,27 @@ private:
     unsigned         m_lns_conflicts = 1000;           // number of conflicts used for LNS improvement
     bool             m_enable_core_rotate = false;     // enable core rotation
     bool             m_use_totalizer = true;           // use totalizer instead of cardinality encoding
+    unsigned         m_num_core_threads = 1;           // number of threads extracting disjoint cores
+    unsigned         m_max_num_cores = 200;            // maximal number of cores of a thread per round
     std::string      m_trace_id;
     typedef ptr_vector<expr> exprs;
 
+    /**
+       A copy of the solver in its own manager used by a thread extracting
+       disjoint cores (see get_parallel_cores). The assertions of the main
+       solver are translated to it incrementally.
+    */
+    struct core_worker {
+        ast_manager            wm;
+        ref<solver>            s;
+        expr_ref_vector        m_sent;     // assertions of the main solver already in s
+        expr_ref_vector        m_asms;     // the assumptions translated to wm
+        obj_map<expr, unsigned> m_asm2index;
+        vector<unsigned_vector> m_cores;   // cores as indices into m_asms
+        core_worker(ast_manager& m): wm(m, true), m_sent(m), m_asms(wm) {}
+    };
+    scoped_ptr_vector<core_worker> m_core_workers;
+
 public:
     maxcore(maxsat_context& c, unsigned index,
            vector<soft>& soft,
@@ -426,6 +450,12 @@ public:
             if (core.size() >= m_max_core_size)
                 break;
 
+            if (m_num_core_threads > 1 && get_parallel_cores(cores)) {
+                // the remaining assumptions are checked again by the caller
+                is_sat = l_true;
+                break;
+            }
+
             is_sat = check_sat_hill_climb(m_asms);
         }
 
@@ -437,6 +467,161 @@ public:
         return is_sat;
     }
 
+    /**
+       Extract disjoint cores of the current assumptions concurrently from
+       copies of the solver. Thread 0 takes the assumptions ordered by weight,
+       thread i takes the first i weight levels (strata of the hill climbing)
+       or, if there are fewer levels, all assumptions in a random order. Each
+       thread extracts cores until its assumptions are satisfiable, removing
+       the assumptions of each core. The threads share the best lower bound
+       obtained by one of them and stop once it closes the gap to the upper bound.
+       The cores are merged in the order of the threads, a core is taken only
+       if it is disjoint from the cores taken before. The taken cores are
+       minimized and split as in get_cores.
+
+       Return true if some core was added to cores.
+    */
+    bool get_parallel_cores(vector<weighted_core>& cores) {
+#ifdef SINGLE_THREAD
+        return false;
+#else
+        unsigned num_threads = std::min(m_num_core_threads, std::max(1u, (unsigned) std::thread::hardware_concurrency()));
+        if (num_threads <= 1 || m_asms.empty() || !m.inc())
+            return false;
+
+        expr_ref_vector asms(m_asms);
+        sort_assumptions(asms);
+        unsigned_vector level_ends;
+        for (unsigned i = 0; i < asms.size(); ) {
+            i = next_index(asms, i);
+            level_ends.push_back(i);
+        }
+        std::vector<double> weights;
+        for (expr* a : asms)
+            weights.push_back(get_weight(a).get_double());
+        double gap = (m_upper - m_lower).get_double();
+
+        // the translations read the terms of m, so they are done by this thread
+        expr_ref_vector assertions = s().get_assertions();
+        while (m_core_workers.size() < num_threads)
+            m_core_workers.push_back(alloc(core_worker, m));
+        for (unsigned i = 0; i < num_threads; ++i) {
+            core_worker& w = *m_core_workers[i];
+            bool same = w.s && w.m_sent.size() <= assertions.size();
+            for (unsigned j = 0; same && j < w.m_sent.size(); ++j)
+                same = w.m_sent.get(j) == assertions.get(j);
+            ast_translation tr(m, w.wm);
+            if (!same) {
+                w.s = mk_smt_solver(w.wm, m_params, symbol());
+                w.m_sent.reset();
+            }
+            for (unsigned j = w.m_sent.size(); j < assertions.size(); ++j) {
+                w.s->assert_expr(tr(assertions.get(j)));
+                w.m_sent.push_back(assertions.get(j));
+            }
+            w.m_asms.reset();
+            w.m_asm2index.reset();
+            w.m_cores.reset();
+            for (unsigned j = 0; j < asms.size(); ++j) {
+                w.m_asms.push_back(tr(asms.get(j)));
+                w.m_asm2index.insert(w.m_asms.get(j), j);
+            }
+        }
+
+        std::mutex mux;
+        double best_bound = 0;
+        auto extract = [&](unsigned i) {
+            core_worker& w = *m_core_workers[i];
+            unsigned_vector order;
+            unsigned sz = (i == 0 || i > level_ends.size()) ? asms.size() : level_ends[i - 1];
+            for (unsigned j = 0; j < sz; ++j)
+                order.push_back(j);
+            if (i > level_ends.size()) {
+                random_gen rand(i);
+                shuffle(order.size(), order.data(), rand);
+            }
+            double bound = 0;
+            try {
+                expr_ref_vector cur(w.wm), core(w.wm);
+                while (w.wm.inc() && w.m_cores.size() < m_max_num_cores) {
+                    {
+                        std::lock_guard<std::mutex> lock(mux);
+                        if (best_bound >= gap)
+                            break;
+                    }
+                    cur.reset();
+                    for (unsigned j : order)
+                        cur.push_back(w.m_asms.get(j));
+                    if (w.s->check_sat(cur) != l_false)
+                        break;
+                    core.reset();
+                    w.s->get_unsat_core(core);
+                    if (core.empty())
+                        break;
+                    unsigned_vector core_idx;
+                    double core_w = -1;
+                    for (expr* c : core) {
+                        unsigned j = w.m_asm2index.find(c);
+                        core_idx.push_back(j);
+                        core_w = core_w < 0 ? weights[j] : std::min(core_w, weights[j]);
+                    }
+                    w.m_cores.push_back(core_idx);
+                    unsigned k = 0;
+                    for (unsigned j : order)
+                        if (!core_idx.contains(j))
+                            order[k++] = j;
+                    order.shrink(k);
+                    bound += core_w;
+                    std::lock_guard<std::mutex> lock(mux);
+                    best_bound = std::max(best_bound, bound);
+                }
+            }
+            catch (z3_exception& ex) {
+                IF_VERBOSE(1, verbose_stream() << "(opt.maxres core thread " << i << " failed: " << ex.msg() << ")\n";);
+            }
+        };
+
+        {
+            scoped_limits sl(m.limit());
+            for (unsigned i = 0; i < num_threads; ++i)
+                sl.push_child(&(m_core_workers[i]->wm.limit()));
+            vector<std::thread> threads(num_threads);
+            for (unsigned i = 0; i < num_threads; ++i)
+                threads[i] = std::thread([&, i]() { extract(i); });
+            for (auto& th : threads)
+                th.join();
+        }
+        if (!m.inc())
+            return false;
+
+        // merge the cores
+        obj_hashtable<expr> used;
+        unsigned num_cores = cores.size();
+        for (unsigned i = 0; i < num_threads; ++i) {
+            for (unsigned_vector const& core_idx : m_core_workers[i]->m_cores) {
+                expr_ref_vector _core(m);
+                for (unsigned j : core_idx)
+                    _core.push_back(asms.get(j));
+                if (any_of(_core, [&](expr* c) { return used.contains(c); }))
+                    continue;
+                if (minimize_core(_core) != l_true)
+                    return cores.size() > num_cores;
+                if (_core.empty())
+                    continue;
+                exprs core(_core.size(), _core.data());
+                for (expr* c : core)
+                    used.insert(c);
+                ++m_stats.m_num_cores;
+                cores.push_back(weighted_core(core, core_weight(core)));
+                remove_soft(core, m_asms);
+                split_core(core);
+            }
+        }
+        IF_VERBOSE(2, verbose_stream() << "(opt.maxres parallel cores " << (cores.size() - num_cores) << ")\n";);
+        return cores.size() > num_cores;
+#endif
+    }
+
     void get_current_correction_set(exprs& cs) {
         model_ref mdl;
         s().get_model(mdl);
@@ -1053,6 +1238,8 @@ public:
         m_hill_climb =              p.maxres_hill_climb();
         m_add_upper_bound_block =   p.maxres_add_upper_bound_block();
         m_max_core_size =           p.maxres_max_core_size();
+        m_num_core_threads =        p.maxres_threads();
+        m_max_num_cores =           p.maxres_max_num_cores();
         m_maximize_assignment =     p.maxres_maximize_assignment();
         m_max_correction_set_size = p.maxres_max_correction_set_size();
         m_pivot_on_cs =             p.maxres_pivot_on_correction_set();
@@ -1061,6 +1248,7 @@ public:
         m_enable_lns =              p.enable_lns();
         m_enable_core_rotate =      p.enable_core_rotate();
         m_lns_conflicts =           p.lns_conflicts();
+        m_lns.set_threads(p.lns_threads());
         m_use_totalizer =           p.rc2_totalizer();
 	if (m_c.num_objectives() > 1)
 	  m_add_upper_bound_block = false;
@@ -17,11 +17,19 @@ Author:
 
 #include "ast/ast_ll_pp.h"
 #include "ast/ast_pp.h"
+#include "ast/ast_translation.h"
 #include "ast/pb_decl_plugin.h"
 #include "opt/maxsmt.h"
 #include "opt/opt_lns.h"
 #include "sat/sat_params.hpp"
+#include "smt/smt_solver.h"
+#include "util/cancel_eh.h"
 #include <algorithm>
+#ifndef SINGLE_THREAD
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif
 
 namespace opt {
 
@@ -33,6 +41,20 @@ namespace opt {
           m_unprocessed(m)
     {}
 
+    /**
+       A copy of the solver in its own manager used by a thread of the parallel
+       search. The assertions of the main solver are translated to it incrementally.
+    */
+    struct lns::worker {
+        ast_manager     wm;
+        ref<solver>     s;
+        expr_ref_vector m_sent;   // assertions of the main solver already in s
+        expr_ref_vector m_soft;   // the soft constraints translated to wm
+        worker(ast_manager& m): wm(m, true), m_sent(m), m_soft(wm) {}
+    };
+
+    lns::~lns() {}
+
     void lns::set_lns_params() {
         params_ref p;
         p.set_sym("phase", symbol("frozen"));
@@ -53,6 +75,11 @@ namespace opt {
     }
 
     unsigned lns::climb(model_ref& mdl) {
+#ifndef SINGLE_THREAD
+        unsigned num_threads = std::min(m_num_threads, std::max(1u, (unsigned) std::thread::hardware_concurrency()));
+        if (num_threads > 1)
+            return climb_parallel(mdl, num_threads);
+#endif
         IF_VERBOSE(1, verbose_stream() << "(opt.lns :climb)\n");
         m_num_improves = 0;
         params_ref old_p(s.get_params());
@@ -68,6 +95,195 @@ namespace opt {
         return m_num_improves;
     }
 
+    void lns::sync_workers(unsigned num_threads) {
+        // the translations read the terms of m, so they are done by the calling thread
+        expr_ref_vector assertions = s.get_assertions();
+        params_ref p;
+        p.set_uint("max_conflicts", m_max_conflicts);
+        while (m_workers.size() < num_threads)
+            m_workers.push_back(alloc(worker, m));
+        for (unsigned i = 0; i < num_threads; ++i) {
+            worker& w = *m_workers[i];
+            bool same = w.s && w.m_sent.size() <= assertions.size();
+            for (unsigned j = 0; same && j < w.m_sent.size(); ++j)
+                same = w.m_sent.get(j) == assertions.get(j);
+            ast_translation tr(m, w.wm);
+            if (!same) {
+                w.s = mk_smt_solver(w.wm, p, symbol());
+                w.m_sent.reset();
+            }
+            w.s->updt_params(p);
+            for (unsigned j = w.m_sent.size(); j < assertions.size(); ++j) {
+                w.s->assert_expr(tr(assertions.get(j)));
+                w.m_sent.push_back(assertions.get(j));
+            }
+            w.m_soft.reset();
+            for (expr* e : ctx.soft())
+                w.m_soft.push_back(tr(e));
+        }
+    }
+
+    /**
+       Each round takes the soft constraints that are false in the best model
+       (the incumbent) in a random order. For each of them a thread checks a
+       neighborhood of the incumbent: the soft constraint and the soft
+       constraints true in the incumbent, except m_neighborhood_size random ones,
+       are assumed. Models with a lower cost replace the incumbent, which is
+       shared by the threads, so the later neighborhoods are taken around it.
+       After a round, the incumbent is reported to the context and the size of
+       the neighborhoods is adapted: it is halved if most checks ran out of
+       conflicts and doubled if most were unsatisfiable.
+    */
+    unsigned lns::climb_parallel(model_ref& mdl, unsigned num_threads) {
+#ifdef SINGLE_THREAD
+        return 0;
+#else
+        IF_VERBOSE(1, verbose_stream() << "(opt.lns :climb-parallel " << num_threads << ")\n");
+        m_num_improves = 0;
+        update_best_model(mdl);
+        expr_ref_vector const& soft = ctx.soft();
+        unsigned n = soft.size();
+        if (n == 0 || !m_best_model)
+            return 0;
+        sync_workers(num_threads);
+
+        std::vector<double> weights;
+        for (expr* e : soft)
+            weights.push_back(ctx.weight(e).get_double());
+        auto get_cost = [&](std::vector<bool> const& is_true) {
+            double cost = 0;
+            for (unsigned j = 0; j < n; ++j)
+                if (!is_true[j])
+                    cost += weights[j];
+            return cost;
+        };
+
+        struct incumbent {
+            std::mutex        mux;
+            std::vector<bool> is_true;
+            double            cost = 0;
+            unsigned          owner = UINT_MAX;   // worker whose model is in mdl
+            model_ref         mdl;
+        } inc;
+        for (expr* e : soft)
+            inc.is_true.push_back(m_best_model->is_true(e));
+        inc.cost = get_cost(inc.is_true);
+        if (m_neighborhood_size == 0)
+            m_neighborhood_size = std::max(1u, n / 10);
+
+        for (unsigned round = 0; round < 2 && m.inc(); ++round) {
+            unsigned_vector tasks;
+            for (unsigned j = 0; j < n; ++j)
+                if (!inc.is_true[j])
+                    tasks.push_back(j);
+            if (tasks.empty())
+                break;
+            shuffle(tasks.size(), tasks.data(), m_rand);
+            unsigned_vector seeds;
+            for (unsigned i = 0; i < num_threads; ++i)
+                seeds.push_back(m_rand());
+            std::vector<bool> before = inc.is_true;
+            double cost_before = inc.cost;
+            unsigned k = m_neighborhood_size;
+            std::atomic<unsigned> next_task(0), num_sat(0), num_unsat(0), num_undef(0);
+
+            auto run = [&](unsigned i) {
+                worker& w = *m_workers[i];
+                random_gen rand(seeds[i]);
+                expr_ref_vector asms(w.wm);
+                try {
+                    while (w.wm.inc()) {
+                        unsigned t = next_task++;
+                        if (t >= tasks.size())
+                            break;
+                        unsigned e = tasks[t];
+                        unsigned_vector trues;
+                        {
+                            std::lock_guard<std::mutex> lock(inc.mux);
+                            if (inc.is_true[e])
+                                continue;
+                            for (unsigned j = 0; j < n; ++j)
+                                if (inc.is_true[j])
+                                    trues.push_back(j);
+                        }
+                        shuffle(trues.size(), trues.data(), rand);
+                        asms.reset();
+                        asms.push_back(w.m_soft.get(e));
+                        for (unsigned j = std::min(k, trues.size()); j < trues.size(); ++j)
+                            asms.push_back(w.m_soft.get(trues[j]));
+                        switch (w.s->check_sat(asms)) {
+                        case l_true: {
+                            ++num_sat;
+                            model_ref wmdl;
+                            w.s->get_model(wmdl);
+                            if (!wmdl)
+                                break;
+                            std::vector<bool> is_true;
+                            for (expr* f : w.m_soft)
+                                is_true.push_back(wmdl->is_true(f));
+                            double cost = get_cost(is_true);
+                            std::lock_guard<std::mutex> lock(inc.mux);
+                            if (cost < inc.cost) {
+                                inc.is_true = std::move(is_true);
+                                inc.cost = cost;
+                                inc.owner = i;
+                                inc.mdl = wmdl;
+                            }
+                            break;
+                        }
+                        case l_false:
+                            ++num_unsat;
+                            break;
+                        default:
+                            ++num_undef;
+                            break;
+                        }
+                    }
+                }
+                catch (z3_exception& ex) {
+                    IF_VERBOSE(1, verbose_stream() << "(opt.lns thread " << i << " failed: " << ex.msg() << ")\n");
+                }
+            };
+
+            {
+                scoped_limits sl(m.limit());
+                for (unsigned i = 0; i < num_threads; ++i)
+                    sl.push_child(&(m_workers[i]->wm.limit()));
+                vector<std::thread> threads(num_threads);
+                for (unsigned i = 0; i < num_threads; ++i)
+                    threads[i] = std::thread([&, i]() { run(i); });
+                for (auto& th : threads)
+                    th.join();
+            }
+            if (!m.inc())
+                break;
+
+            if (num_undef > num_sat + num_unsat)
+                m_neighborhood_size = std::max(1u, k / 2);
+            else if (num_unsat > num_sat)
+                m_neighborhood_size = std::min(n, 2 * k);
+            IF_VERBOSE(2, verbose_stream() << "(opt.lns :sat " << num_sat << " :unsat " << num_unsat << " :undef " << num_undef
+                       << " :neighborhood " << m_neighborhood_size << ")\n");
+
+            if (inc.owner == UINT_MAX)
+                break;
+            ast_translation tr(m_workers[inc.owner]->wm, m);
+            model_ref best = inc.mdl->translate(tr);
+            inc.owner = UINT_MAX;
+            inc.mdl = nullptr;
+            for (unsigned j = 0; j < n; ++j)
+                if (inc.is_true[j] && !before[j])
+                    ++m_num_improves;
+            IF_VERBOSE(1, verbose_stream() << "(opt.lns :num-improves " << m_num_improves << ")\n");
+            ctx.update_model(best);
+            update_best_model(best);
+            if (inc.cost >= cost_before)
+                break;
+        }
+        return m_num_improves;
+#endif
+    }
+
     void lns::update_best_model(model_ref& mdl) {
         rational cost = ctx.cost(*mdl);
         if (m_best_cost.is_zero() || m_best_cost >= cost) {
@@ -16,6 +16,9 @@ Abstract:
     The soft constraints are assumed sorted by weight, such that the highest 
     weight soft constraint is first, followed by soft constraints of lower weight.
 
+    With more threads, neighborhoods of the best model are checked concurrently
+    on copies of the solver (see climb_parallel).
+
 Author:
 
     Nikolaj Bjorner (nbjorner) 2021-02-01
@@ -24,6 +27,8 @@ Author:
 
 #pragma once
 
+#include "util/scoped_ptr_vector.h"
+
 namespace opt {
 
     class lns_context {
@@ -48,6 +53,12 @@ namespace opt {
         bool             m_cores_are_valid { true };
         bool             m_enable_scoped_bounding { false };
         unsigned         m_best_bound { 0 };
+        unsigned         m_num_threads { 1 };
+        // number of soft constraints freed in a neighborhood of the parallel search
+        unsigned         m_neighborhood_size { 0 };
+
+        struct worker;
+        scoped_ptr_vector<worker> m_workers;
 
         rational         m_best_cost;
         model_ref        m_best_model;
@@ -71,10 +82,14 @@ namespace opt {
         lbool improve_step(model_ref& mdl, expr* e);
         void relax_cores();
         unsigned improve_linear(model_ref& mdl);
+        void sync_workers(unsigned num_threads);
+        unsigned climb_parallel(model_ref& mdl, unsigned num_threads);
 
     public:
         lns(solver& s, lns_context& ctx);
+        ~lns();
         void set_conflicts(unsigned c) { m_max_conflicts = c; }
+        void set_threads(unsigned n) { m_num_threads = n; }
         unsigned climb(model_ref& mdl);
     };
 };
@@ -90,6 +90,9 @@ void context_params::set(char const * param, char const * value) {
     else if (p == "stats") {
         set_bool(m_statistics, param, value);
     }
+    else if (p == "progress_json") {
+        set_bool(m_progress_json, param, value);
+    }
     else if (p == "trace") {
         set_bool(m_trace, param, value);
     }
@@ -151,6 +154,7 @@ void context_params::updt_params(params_ref const & p) {
     m_debug_ref_count   = p.get_bool("debug_ref_count", m_debug_ref_count);
     m_smtlib2_compliant = p.get_bool("smtlib2_compliant", m_smtlib2_compliant);
     m_statistics        = p.get_bool("stats", m_statistics);
+    m_progress_json     = p.get_bool("progress_json", m_progress_json);
     m_encoding          = p.get_str("encoding", m_encoding.c_str());
 }
 
@@ -168,6 +172,7 @@ void context_params::collect_param_descrs(param_descrs & d) {
     d.insert("debug_ref_count", CPK_BOOL, "debug support for AST reference counting", "false");
     d.insert("smtlib2_compliant", CPK_BOOL, "enable/disable SMT-LIB 2.0 compliance", "false");
     d.insert("stats", CPK_BOOL, "enable/disable statistics", "false");
+    d.insert("progress_json", CPK_BOOL, "report progress samples (see smt.progress_sampling_freq) as JSON lines with the current statistics instead of s-expressions", "false");
     d.insert("encoding", CPK_STRING, "string encoding used internally: unicode|bmp|ascii", "unicode");
     // statistics are hidden as they are controlled by the /st option.
     collect_solver_param_descrs(d);
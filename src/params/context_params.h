@@ -43,6 +43,7 @@ public:
     bool             m_unsat_core { false };
     bool             m_smtlib2_compliant { false }; // it must be here because it enable/disable the use of coercions in the ast_manager.
     bool             m_statistics { false };
+    bool             m_progress_json { false };
     std::string      m_encoding { "unicode" };
 
     unsigned rlimit() const { return m_rlimit; }
@@ -50,10 +50,36 @@ namespace smt2 {
         m_spos++;
     }
 
+    /**
+       \brief Consume the characters from curr() on that satisfy p and are in the current buffer in one step,
+       it is the same as calling next() for each of them. The last character of the buffer is left
+       to next(), which refills the buffer. If keep is true, the consumed characters are added to m_string.
+    */
+    template<typename P>
+    void scanner::skip_buffered(P const& p, bool keep) {
+        if (m_interactive || m_at_eof || m_bpos == 0)
+            return;
+        // curr() is m_buffer[m_bpos - 1]
+        unsigned b = m_bpos - 1;
+        unsigned e = b;
+        while (e + 1 < m_bend && p(m_buffer[e]))
+            ++e;
+        if (e == b)
+            return;
+        if (keep)
+            m_string.append(e - b, m_buffer + b);
+        if (m_cache_input)
+            m_cache.append(e - b, m_buffer + b);
+        m_curr = m_buffer[e];
+        m_bpos = e + 1;
+        m_spos += e - b;
+    }
+
     void scanner::read_comment() {
         SASSERT(curr() == ';');
         next();
         while (true) {
+            skip_buffered([](char c) { return c != '\n'; }, false);
             char c = curr();
             if (m_at_eof)
                 return;
@@ -70,6 +96,7 @@ namespace smt2 {
         SASSERT(curr() == '|');
         next();
         while (true) {
+            skip_buffered([](char c) { return c != '\n' && c != '|'; }, false);
             char c = curr();
             if (m_at_eof)
                 return;
@@ -92,6 +119,8 @@ namespace smt2 {
         m_string.reset();
         next();
         while (true) {
+            if (!escape)
+                skip_buffered([](char c) { return c != '|' && c != '\\' && c != '\n'; }, true);
             char c = curr();
             if (m_at_eof) {
                 throw scanner_exception("unexpected end of quoted symbol", m_line, m_spos);
@@ -119,9 +148,9 @@ namespace smt2 {
 
     scanner::token scanner::read_symbol_core() {
         while (!m_at_eof) {
+            skip_buffered([&](char c) { return is_symbol_char(c); }, true);
             char c = curr();
-            signed char n = m_normalized[static_cast<unsigned char>(c)];
-            if (n == 'a' || n == '0' || n == '-') {
+            if (is_symbol_char(c)) {
                 m_string.push_back(c);
                 next();
             }
@@ -200,6 +229,7 @@ namespace smt2 {
         next();
         m_string.reset();
         while (true) {
+            skip_buffered([](char c) { return c != '\"' && c != '\n'; }, true);
             char c = curr();
             if (m_at_eof)
                 throw scanner_exception("unexpected end of string", m_line, m_spos);
@@ -341,6 +371,7 @@ namespace smt2 {
             switch (m_normalized[(unsigned char) c]) {
             case ' ':
                 next();
+                skip_buffered([&](char c) { return m_normalized[(unsigned char) c] == ' '; }, false);
                 break;
             case '\n':
                 next();
@@ -44,7 +44,7 @@ namespace smt2 {
         unsigned           m_bv_size;
         // end of data
         signed char        m_normalized[256];
-#define SCANNER_BUFFER_SIZE 1024
+#define SCANNER_BUFFER_SIZE (1 << 16)
         char               m_buffer[SCANNER_BUFFER_SIZE];
         unsigned           m_bpos;
         unsigned           m_bend;
@@ -59,6 +59,12 @@ namespace smt2 {
         char curr() const { return m_curr; }
         void new_line() { m_line++; m_spos = 0; }
         void next();
+        template<typename P>
+        void skip_buffered(P const& p, bool keep);
+        bool is_symbol_char(char c) const {
+            signed char n = m_normalized[static_cast<unsigned char>(c)];
+            return n == 'a' || n == '0' || n == '-';
+        }
         
     public:
         
@@ -19,6 +19,8 @@ Revision History:
 --*/
 
 #include "qe/qe_mbp.h"
+#include "ast/arith_decl_plugin.h"
+#include "ast/array_decl_plugin.h"
 #include "ast/ast_pp.h"
 #include "ast/ast_util.h"
 #include "ast/expr_functors.h"
@@ -31,6 +33,7 @@ Revision History:
 #include "ast/scoped_proof.h"
 #include "ast/seq_decl_plugin.h"
 #include "util/gparams.h"
+#include "util/scoped_ptr_vector.h"
 #include "model/model_evaluator.h"
 #include "model/model_pp.h"
 #include "qe/lite/qe_lite_tactic.h"
@@ -151,6 +154,28 @@ class mbproj::impl {
     bool m_reduce_all_selects;
     bool m_dont_sub;
     bool m_use_qel;
+    unsigned m_cache_size;
+
+    /**
+       Projection of a call on the formulas of the key: the result is reused by
+       calls with the same formulas, variables and flags, provided the free
+       constants of the formulas have the same values in the model.
+    */
+    struct projection_entry {
+        unsigned             m_kind;
+        app_ref_vector       m_vars;
+        expr_ref_vector      m_values;     // values of the free constants, nullptr if uninterpreted
+        app_ref_vector       m_result_vars;
+        expr_ref_vector      m_result;
+        func_decl_ref_vector m_new_decls;  // constants added to the model by the projection
+        expr_ref_vector      m_new_values;
+        projection_entry(ast_manager& m):
+            m_vars(m), m_values(m), m_result_vars(m), m_result(m), m_new_decls(m), m_new_values(m) {}
+    };
+    scoped_ptr_vector<projection_entry> m_entries;
+    obj_map<expr, unsigned_vector>      m_key2entries;
+    expr_ref_vector                     m_keys;
+    unsigned                            m_num_hits = 0;
 
     void add_plugin(mbp::project_plugin* p) {
         family_id fid = p->get_family_id();
@@ -330,6 +355,99 @@ class mbproj::impl {
         vars.shrink(j);
     }
 
+    /**
+       Collect the values of the free constants of e in the order of a traversal of e.
+       Return false if the projection of e may depend on more of the model than these
+       values (uninterpreted functions, partial arithmetic operators, arrays, sequences,
+       non-value interpretations, quantifiers).
+    */
+    bool get_key_values(expr* e, model& mdl, expr_ref_vector& values) {
+        arith_util a(m);
+        array_util arr(m);
+        seq_util seq(m);
+        for (expr* t : subterms::all(expr_ref(e, m))) {
+            if (!is_app(t))
+                return false;
+            app* ap = to_app(t);
+            sort* s = ap->get_sort();
+            if (arr.is_array(s) || seq.is_seq(s) || seq.is_re(s) || seq.is_char(s))
+                return false;
+            if (is_uninterp_const(ap)) {
+                expr* v = mdl.get_const_interp(ap->get_decl());
+                if (v && !m.is_value(v))
+                    return false;
+                values.push_back(v);
+            }
+            else if (ap->get_family_id() == null_family_id ||
+                     a.is_div(ap) || a.is_idiv(ap) || a.is_mod(ap) || a.is_rem(ap) || a.is_power(ap))
+                return false;
+        }
+        return true;
+    }
+
+    unsigned cache_kind(unsigned entry_point, bool force_elim) const {
+        return entry_point | (force_elim << 1) | (m_dont_sub << 2) | (m_reduce_all_selects << 3) | (m_use_qel << 4);
+    }
+
+    /**
+       Look up a projection of key for vars with the values of the model,
+       on success add the constants introduced by the projection to mdl.
+    */
+    projection_entry* cache_find(unsigned kind, app_ref_vector const& vars, expr* key, model& mdl, expr_ref_vector const& values) {
+        unsigned_vector const* ids = m_key2entries.find_core(key) ? &m_key2entries[key] : nullptr;
+        if (!ids)
+            return nullptr;
+        for (unsigned id : *ids) {
+            projection_entry& e = *m_entries[id];
+            if (e.m_kind != kind || e.m_vars != vars || e.m_values != values)
+                continue;
+            bool consistent = true;
+            for (unsigned i = 0; consistent && i < e.m_new_decls.size(); ++i) {
+                expr* v = mdl.get_const_interp(e.m_new_decls.get(i));
+                consistent = !v || v == e.m_new_values.get(i);
+            }
+            if (!consistent)
+                continue;
+            for (unsigned i = 0; i < e.m_new_decls.size(); ++i)
+                if (!mdl.get_const_interp(e.m_new_decls.get(i)))
+                    mdl.register_decl(e.m_new_decls.get(i), e.m_new_values.get(i));
+            ++m_num_hits;
+            return &e;
+        }
+        return nullptr;
+    }
+
+    void cache_insert(unsigned kind, app_ref_vector const& vars, expr* key, expr_ref_vector const& values, model& mdl,
+                      unsigned num_consts, unsigned num_funcs, app_ref_vector const& result_vars, expr_ref_vector const& result) {
+        if (mdl.get_num_functions() != num_funcs || mdl.get_num_constants() < num_consts)
+            return;
+        if (m_entries.size() >= m_cache_size)
+            cache_reset();
+        projection_entry* e = alloc(projection_entry, m);
+        e->m_kind = kind;
+        e->m_vars.append(vars);
+        e->m_values.append(values);
+        e->m_result_vars.append(result_vars);
+        e->m_result.append(result);
+        for (unsigned i = num_consts; i < mdl.get_num_constants(); ++i) {
+            func_decl* d = mdl.get_constant(i);
+            e->m_new_decls.push_back(d);
+            e->m_new_values.push_back(mdl.get_const_interp(d));
+        }
+        if (!m_key2entries.contains(key)) {
+            m_keys.push_back(key);
+            m_key2entries.insert(key, unsigned_vector());
+        }
+        m_key2entries[key].push_back(m_entries.size());
+        m_entries.push_back(e);
+    }
+
+    void cache_reset() {
+        m_entries.reset();
+        m_key2entries.reset();
+        m_keys.reset();
+    }
+
 public:
 
     opt::inf_eps maximize(expr_ref_vector const& fmls, model& mdl, app* t, expr_ref& ge, expr_ref& gt) {
@@ -342,7 +460,7 @@ public:
         proj.extract_literals(model, vars, fmls);
     }
 
-    impl(ast_manager& m, params_ref const& p) :m(m), m_params(p), m_rw(m) {
+    impl(ast_manager& m, params_ref const& p) :m(m), m_params(p), m_rw(m), m_keys(m) {
         add_plugin(alloc(mbp::arith_project_plugin, m));
         add_plugin(alloc(mbp::datatype_project_plugin, m));
         add_plugin(alloc(mbp::array_project_plugin, m));
@@ -357,6 +475,7 @@ public:
         m_params.append(p);
         m_reduce_all_selects = m_params.get_bool("reduce_all_selects", false);
         m_dont_sub = m_params.get_bool("dont_sub", false);
+        m_cache_size = m_params.get_uint("cache_size", 1000);
         auto q = gparams::get_module("smt");
         m_params.append(q);
         m_use_qel = m_params.get_bool("qsat_use_qel", true);
@@ -412,6 +531,63 @@ public:
         e = mk_and(fmls);
         return any_of(subterms::all(e), [&](expr* c) { return seq.is_char(c) || seq.is_seq(c); });
     }
+    /**
+       The entry points of mbproj: the projections are cached, see projection_entry.
+    */
+    void cached_mbp(bool force_elim, app_ref_vector& vars, model& model, expr_ref_vector& fmls) {
+        if (m_cache_size == 0) {
+            (*this)(force_elim, vars, model, fmls);
+            return;
+        }
+        expr_ref key = mk_and(fmls);
+        expr_ref_vector values(m);
+        if (!get_key_values(key, model, values)) {
+            (*this)(force_elim, vars, model, fmls);
+            return;
+        }
+        unsigned kind = cache_kind(0, force_elim);
+        if (projection_entry* e = cache_find(kind, vars, key, model, values)) {
+            vars.reset();
+            vars.append(e->m_result_vars);
+            fmls.reset();
+            fmls.append(e->m_result);
+            return;
+        }
+        app_ref_vector vars0(vars);
+        unsigned num_consts = model.get_num_constants(), num_funcs = model.get_num_functions();
+        (*this)(force_elim, vars, model, fmls);
+        if (m.limit().inc())
+            cache_insert(kind, vars0, key, values, model, num_consts, num_funcs, vars, fmls);
+    }
+
+    void cached_spacer(app_ref_vector& vars, model& mdl, expr_ref& fml) {
+        expr_ref_vector values(m);
+        if (m_cache_size == 0 || !get_key_values(fml, mdl, values)) {
+            spacer(vars, mdl, fml);
+            return;
+        }
+        unsigned kind = cache_kind(1, false);
+        if (projection_entry* e = cache_find(kind, vars, fml, mdl, values)) {
+            vars.reset();
+            vars.append(e->m_result_vars);
+            fml = e->m_result.get(0);
+            return;
+        }
+        app_ref_vector vars0(vars);
+        expr_ref key(fml);
+        unsigned num_consts = mdl.get_num_constants(), num_funcs = mdl.get_num_functions();
+        spacer(vars, mdl, fml);
+        if (m.limit().inc()) {
+            expr_ref_vector result(m);
+            result.push_back(fml);
+            cache_insert(kind, vars0, key, values, mdl, num_consts, num_funcs, vars, result);
+        }
+    }
+
+    void collect_statistics(statistics& st) const {
+        st.update("mbp cache hits", m_num_hits);
+    }
+
     void operator()(bool force_elim, app_ref_vector& vars, model& model, expr_ref_vector& fmls) {
             //don't use mbp_qel on some theories where model evaluation is
             //incomplete This is not a limitation of qel. Fix this either by
@@ -694,16 +870,21 @@ void mbproj::get_param_descrs(param_descrs& r) {
     r.insert("reduce_all_selects", CPK_BOOL, "(default: false) reduce selects");
     r.insert("dont_sub", CPK_BOOL, "(default: false) disable substitution of values for free variables");
     r.insert("use_qel", CPK_BOOL, "(default: true) use egraph based QEL");
+    r.insert("cache_size", CPK_UINT, "(default: 1000) number of projections reused by later calls on the same formulas and model values, 0 to disable");
 }
 
 void mbproj::operator()(bool force_elim, app_ref_vector& vars, model& mdl, expr_ref_vector& fmls) {
     scoped_no_proof _sp(fmls.get_manager());
-    (*m_impl)(force_elim, vars, mdl, fmls);
+    m_impl->cached_mbp(force_elim, vars, mdl, fmls);
 }
 
 void mbproj::spacer(app_ref_vector& vars, model& mdl, expr_ref& fml) {
     scoped_no_proof _sp(fml.get_manager());
-    m_impl->spacer(vars, mdl, fml);
+    m_impl->cached_spacer(vars, mdl, fml);
+}
+
+void mbproj::collect_statistics(statistics& st) const {
+    m_impl->collect_statistics(st);
 }
 
 void mbproj::solve(model& model, app_ref_vector& vars, expr_ref_vector& fmls) {
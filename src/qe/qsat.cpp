@@ -1357,6 +1357,7 @@ namespace qe {
             m_pred_abs.collect_statistics(st);
             st.update("qsat num rounds", m_stats.m_num_rounds); 
             m_pred_abs.collect_statistics(st);
+            m_mbp.collect_statistics(st);
         }
         
         void reset_statistics() override {
@@ -16,10 +16,17 @@ Author:
 Revision History:
 
 --*/
+#include <fstream>
 #include "sat/dimacs.h"
 #undef max
 #undef min
 #include "sat/sat_solver.h"
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 template<typename Buffer>
 static bool is_whitespace(Buffer & in) {
@@ -144,6 +151,156 @@ bool parse_dimacs(std::istream & in, std::ostream& err, sat::solver & solver) {
     return parse_dimacs_core(_in, err, solver);
 }
 
+namespace {
+
+    struct mapped_file {
+        char const* m_data = nullptr;
+        size_t      m_size = 0;
+        mapped_file(char const* file_name) {
+#ifndef _WINDOWS
+            int fd = open(file_name, O_RDONLY);
+            if (fd < 0)
+                return;
+            struct stat st;
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                    m_data = static_cast<char const*>(p);
+                    m_size = static_cast<size_t>(st.st_size);
+                }
+            }
+            close(fd);
+#endif
+        }
+        ~mapped_file() {
+#ifndef _WINDOWS
+            if (m_data)
+                munmap(const_cast<char*>(m_data), m_size);
+#endif
+        }
+        bool is_mapped() const { return m_data != nullptr; }
+    };
+
+    /**
+       \brief parser of DIMACS in memory, integers are read by tight pointer loops.
+    */
+    class memory_parser {
+        char const* m_begin;
+        char const* m_curr;
+        char const* m_end;
+        std::ostream& m_err;
+
+        static bool is_space(char c) { return static_cast<unsigned char>(c - 9) <= 4 || c == ' '; }
+        static bool is_digit(char c) { return static_cast<unsigned char>(c - '0') <= 9; }
+
+        unsigned line() const { return 1 + static_cast<unsigned>(std::count(m_begin, m_curr, '\n')); }
+
+        void skip_whitespace() {
+            while (m_curr < m_end && is_space(*m_curr))
+                ++m_curr;
+        }
+
+        void skip_line() {
+            char const* nl = static_cast<char const*>(memchr(m_curr, '\n', m_end - m_curr));
+            m_curr = nl ? nl + 1 : m_end;
+        }
+
+        [[noreturn]] void unexpected() {
+            if (m_curr == m_end)
+                m_err << "(error, \"unexpected end of file line: " << line() << "\")\n";
+            else
+                m_err << "(error, \"unexpected char: " << *m_curr << " line: " << line() << "\")\n";
+            throw dimacs::lex_error();
+        }
+
+        int parse_int() {
+            skip_whitespace();
+            bool neg = false;
+            if (m_curr < m_end && (*m_curr == '-' || *m_curr == '+')) {
+                neg = *m_curr == '-';
+                ++m_curr;
+            }
+            if (m_curr == m_end || !is_digit(*m_curr))
+                unexpected();
+            unsigned val = 0;
+            do {
+                val = 10 * val + static_cast<unsigned>(*m_curr - '0');
+                ++m_curr;
+            }
+            while (m_curr < m_end && is_digit(*m_curr));
+            return neg ? -static_cast<int>(val) : static_cast<int>(val);
+        }
+
+        // header "p cnf <vars> <clauses>", the declared variables are created at once.
+        void parse_header(sat::solver& solver) {
+            char const* start = m_curr;
+            ++m_curr;
+            skip_whitespace();
+            if (m_end - m_curr > 3 && m_curr[0] == 'c' && m_curr[1] == 'n' && m_curr[2] == 'f' && is_space(m_curr[3])) {
+                m_curr += 3;
+                int num_vars = parse_int();
+                while (num_vars >= 0 && static_cast<unsigned>(num_vars) >= solver.num_vars())
+                    solver.mk_var();
+            }
+            m_curr = start;
+            skip_line();
+        }
+
+    public:
+        memory_parser(char const* data, size_t size, std::ostream& err):
+            m_begin(data), m_curr(data), m_end(data + size), m_err(err) {}
+
+        bool operator()(sat::solver& solver) {
+            sat::literal_vector lits;
+            try {
+                while (true) {
+                    skip_whitespace();
+                    if (m_curr == m_end)
+                        break;
+                    if (*m_curr == 'c') {
+                        skip_line();
+                        continue;
+                    }
+                    if (*m_curr == 'p') {
+                        parse_header(solver);
+                        continue;
+                    }
+                    lits.reset();
+                    while (true) {
+                        int parsed_lit = parse_int();
+                        if (parsed_lit == 0)
+                            break;
+                        unsigned var = static_cast<unsigned>(abs(parsed_lit));
+                        while (var >= solver.num_vars())
+                            solver.mk_var();
+                        lits.push_back(sat::literal(var, parsed_lit < 0));
+                    }
+                    solver.mk_clause(lits.size(), lits.data());
+                }
+            }
+            catch (dimacs::lex_error) {
+                return false;
+            }
+            return true;
+        }
+    };
+}
+
+bool parse_dimacs(char const* file_name, std::ostream& err, sat::solver & solver) {
+    mapped_file f(file_name);
+    if (f.is_mapped()) {
+        memory_parser p(f.m_data, f.m_size, err);
+        return p(solver);
+    }
+    std::ifstream in(file_name, std::ios_base::in | std::ios_base::binary);
+    if (in.bad() || in.fail()) {
+        err << "(error \"failed to open file '" << file_name << "'\")" << std::endl;
+        return false;
+    }
+    return parse_dimacs(in, err, solver);
+}
+
 
 namespace dimacs {
 
@@ -25,6 +25,12 @@ Revision History:
 
 bool parse_dimacs(std::istream & s, std::ostream& err, sat::solver & solver);
 
+/**
+   \brief parse the DIMACS file file_name mapped to memory.
+   Falls back to the stream parser if the file cannot be mapped (pipes, special files).
+*/
+bool parse_dimacs(char const* file_name, std::ostream& err, sat::solver & solver);
+
 namespace dimacs {
     struct lex_error {};
 
@@ -37,15 +43,16 @@ namespace dimacs {
     stream_buffer(std::istream & s):
         m_stream(s),
             m_line(0) {
-            m_val = m_stream.get();
+            m_val = m_stream.rdbuf()->sbumpc();
         }
         
         int  operator *() const { 
             return m_val;
         }
         
+        // read through the stream buffer, it avoids the sentry of std::istream::get for every character.
         void operator ++() { 
-            m_val = m_stream.get();
+            m_val = m_stream.rdbuf()->sbumpc();
             if (m_val == '\n') ++m_line;
         }
         
@@ -33,6 +33,7 @@ class sat_allocator {
     };
     char const *              m_id;
     size_t                    m_alloc_size;
+    size_t                    m_small_size;   // part of m_alloc_size allocated in chunks
     ptr_vector<chunk>         m_chunks;
     void *                    m_chunk_ptr;
     ptr_vector<void>          m_free[NUM_FREE];
@@ -44,13 +45,14 @@ class sat_allocator {
         return (static_cast<unsigned>(size >> PTR_ALIGNMENT) + ((0 != (size & MASK)) ? 1u : 0u));
     }
 public:
-    sat_allocator(char const * id = "unknown"): m_id(id), m_alloc_size(0), m_chunk_ptr(nullptr) {}
+    sat_allocator(char const * id = "unknown"): m_id(id), m_alloc_size(0), m_small_size(0), m_chunk_ptr(nullptr) {}
     ~sat_allocator() { reset(); }
     void reset() {
         for (chunk * ch : m_chunks) dealloc(ch);
         m_chunks.reset();
         for (unsigned i = 0; i < NUM_FREE; ++i) m_free[i].reset();
         m_alloc_size = 0;
+        m_small_size = 0;
         m_chunk_ptr = nullptr;
     }
     void * allocate(size_t size) {
@@ -58,6 +60,7 @@ public:
         if (size >= SMALL_OBJ_SIZE) {
             return memory::allocate(size);
         }
+        m_small_size += size;
         unsigned slot_id = free_slot_id(size);
         if (!m_free[slot_id].empty()) {
             void* result = m_free[slot_id].back();
@@ -85,12 +88,16 @@ public:
             memory::deallocate(p);
         }
         else {
+            m_small_size -= size;
             m_free[free_slot_id(size)].push_back(p);
         }
     }
     size_t get_allocation_size() const { return m_alloc_size; }
+    size_t get_small_allocation_size() const { return m_small_size; }
+    size_t get_chunk_size() const { return m_chunks.size() * sizeof(chunk); }
 
     char const* id() const { return m_id; }
+    void set_id(char const* id) { m_id = id; }
 };
 
 inline void * operator new(size_t s, sat_allocator & r) { return r.allocate(s); }
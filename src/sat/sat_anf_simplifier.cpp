@@ -22,6 +22,10 @@
 #include "sat/sat_xor_finder.h"
 #include "sat/sat_aig_finder.h"
 #include "math/grobner/pdd_solver.h"
+#ifndef SINGLE_THREAD
+#include <thread>
+#include <mutex>
+#endif
 
 namespace sat {
 
@@ -40,29 +44,164 @@ namespace sat {
         }
     };
             
-    void anf_simplifier::operator()() {
-        dd::pdd_manager m(20, dd::pdd_manager::semantics::mod2_e);
+    struct anf_simplifier::worker {
+        dd::pdd_manager      m;
         u_dependency_manager dm;
-        pdd_solver solver(s.rlimit(), dm, m);
+        pdd_solver           ps;
+        worker(reslimit& lim): m(20, dd::pdd_manager::semantics::mod2_e), ps(lim, dm, m) {}
+    };
+
+    void anf_simplifier::operator()() {
         report _report(*this);
-        configure_solver(solver);
-        clauses2anf(solver);
-        TRACE("anf_simplifier", solver.display(tout); s.display(tout););
-        solver.simplify();
-        TRACE("anf_simplifier", solver.display(tout););
-        anf2clauses(solver);
-        anf2phase(solver);
-        save_statistics(solver);
+        vector<constraint> cs;
+        clauses2anf(cs);
+
+        // the variable order and the seed are shared by all pdd managers
+        unsigned nv = s.num_vars();
+        unsigned_vector l2v(nv), var2id(nv), id2var(nv);
+        svector<std::pair<unsigned, unsigned>> vl(nv);
+        for (unsigned i = 0; i < nv; ++i) var2id[i] = i;
+        shuffle(var2id.size(), var2id.data(), s.rand());
+        for (unsigned i = 0; i < nv; ++i) id2var[var2id[i]] = i;
+        for (unsigned i = 0; i < nv; ++i) vl[i] = std::make_pair(i, var2id[i]);
+        std::sort(vl.begin(), vl.end());
+        for (unsigned i = 0; i < nv; ++i) l2v[i] = id2var[vl[i].second];
+        unsigned seed = s.rand()();
+
+        vector<unsigned_vector> groups;
+        partition(cs, groups);
+        unsigned num_workers = groups.size();
+        scoped_ptr_vector<worker> workers;
+        ptr_vector<pdd_solver> solvers;
+        vector<reslimit> lims(num_workers);
+        scoped_limits sl(s.rlimit());
+        for (unsigned i = 0; i < num_workers; ++i) {
+            if (num_workers == 1)
+                workers.push_back(alloc(worker, s.rlimit()));
+            else {
+                sl.push_child(&lims[i]);
+                workers.push_back(alloc(worker, lims[i]));
+            }
+            configure_solver(l2v, seed, workers[i]->ps);
+            solvers.push_back(&workers[i]->ps);
+        }
+
+#ifndef SINGLE_THREAD
+        if (num_workers > 1) {
+            std::mutex mux;
+            std::string ex_msg;
+            bool failed = false;
+            vector<std::thread> threads;
+            for (unsigned i = 0; i < num_workers; ++i) {
+                threads.push_back(std::thread([&, i]() {
+                    try {
+                        simplify(cs, groups[i], *solvers[i]);
+                    }
+                    catch (z3_exception& ex) {
+                        std::lock_guard<std::mutex> lock(mux);
+                        ex_msg = ex.msg();
+                        failed = true;
+                        for (reslimit& l : lims)
+                            l.cancel();
+                    }
+                }));
+            }
+            for (auto& t : threads)
+                t.join();
+            if (failed)
+                throw default_exception(std::move(ex_msg));
+        }
+        else
+#endif
+        for (unsigned i = 0; i < num_workers; ++i)
+            simplify(cs, groups[i], *solvers[i]);
+
+        TRACE("anf_simplifier", for (pdd_solver* ps : solvers) ps->display(tout););
+        anf2clauses(solvers);
+        for (pdd_solver* ps : solvers)
+            anf2phase(*ps);
+        save_statistics(solvers);
         IF_VERBOSE(10, m_st.display(verbose_stream() << "(sat.anf.simplifier\n"); verbose_stream() << ")\n");
     }
 
+    /**
+       \brief compile the constraints of group to polynomials of ps and simplify them.
+       Runs in the thread of a worker, so it only uses the pdd manager of ps.
+     */
+    void anf_simplifier::simplify(vector<constraint> const& cs, unsigned_vector const& group, pdd_solver& ps) {
+        try {
+            for (unsigned i : group)
+                add_constraint(cs[i], ps);
+        }
+        catch (dd::pdd_manager::mem_out) {
+            IF_VERBOSE(1, verbose_stream() << "(sat.anf memout)\n");
+        }
+        ps.simplify();
+    }
+
+    /**
+       \brief partition the constraints into groups without shared variables.
+       The connected components of the variable occurrence graph are distributed
+       over at most m_num_threads groups, largest component first to the smallest group.
+       Constraints in different groups do not interact during elimination, so the
+       groups are simplified independently.
+     */
+    void anf_simplifier::partition(vector<constraint> const& cs, vector<unsigned_vector>& groups) {
+        groups.reset();
+        unsigned num_threads = std::max(1u, m_config.m_num_threads);
+        if (num_threads == 1 || cs.size() < 2) {
+            groups.push_back(unsigned_vector());
+            for (unsigned i = 0; i < cs.size(); ++i)
+                groups[0].push_back(i);
+            return;
+        }
+        union_find_default_ctx ctx;
+        union_find<> uf(ctx);
+        for (unsigned v = s.num_vars(); v-- > 0; ) uf.mk_var();
+        for (constraint const& c : cs) {
+            bool_var v = c.m_head == null_literal ? null_bool_var : c.m_head.var();
+            for (literal l : c.m_lits) {
+                if (v != null_bool_var)
+                    uf.merge(v, l.var());
+                v = l.var();
+            }
+        }
+        u_map<unsigned> root2comp;
+        vector<unsigned_vector> comps;
+        for (unsigned i = 0; i < cs.size(); ++i) {
+            constraint const& c = cs[i];
+            bool_var v = c.m_head == null_literal ? c.m_lits[0].var() : c.m_head.var();
+            unsigned r = uf.find(v), k;
+            if (!root2comp.find(r, k)) {
+                k = comps.size();
+                root2comp.insert(r, k);
+                comps.push_back(unsigned_vector());
+            }
+            comps[k].push_back(i);
+        }
+        unsigned num_groups = std::min(num_threads, comps.size());
+        unsigned_vector order;
+        for (unsigned k = 0; k < comps.size(); ++k)
+            order.push_back(k);
+        std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return comps[a].size() > comps[b].size(); });
+        groups.resize(num_groups);
+        for (unsigned k : order) {
+            unsigned best = 0;
+            for (unsigned g = 1; g < num_groups; ++g)
+                if (groups[g].size() < groups[best].size())
+                    best = g;
+            groups[best].append(comps[k]);
+        }
+        TRACE("anf_simplifier", tout << comps.size() << " components in " << num_groups << " groups\n";);
+    }
+
     /**
        \brief extract learned units and equivalences from processed anf.
 
        TBD: could learn binary clauses
        TBD: could try simplify equations using BIG subsumption similar to asymm_branch
      */
-    void anf_simplifier::anf2clauses(pdd_solver& solver) {
+    void anf_simplifier::anf2clauses(ptr_vector<pdd_solver> const& solvers) {
 
         union_find_default_ctx ctx;
         union_find<> uf(ctx);
@@ -73,30 +212,34 @@ namespace sat {
         };
 
         unsigned old_num_eqs = m_stats.m_num_eqs;
-        for (auto* e : solver.equations()) {
-            auto const& p = e->poly();
-            if (p.is_one()) {
-                s.set_conflict();
-                break;
-            }
-            else if (p.is_unary()) {
-                // unit
-                SASSERT(!p.is_val() && p.lo().is_val() && p.hi().is_val());
-                literal lit(p.var(), p.lo().is_zero());
-                s.assign_unit(lit);
-                ++m_stats.m_num_units;
-                TRACE("anf_simplifier", tout << "unit " << p << " : " << lit << "\n";);
-            }
-            else if (p.is_binary()) {
-                // equivalence
-                // x + y + c = 0
-                SASSERT(!p.is_val() && p.hi().is_one() && !p.lo().is_val() && p.lo().hi().is_one() && p.lo().lo().is_val());
-                literal x(p.var(), false);
-                literal y(p.lo().var(), p.lo().lo().is_one());
-                add_eq(x, y);
-                ++m_stats.m_num_eqs;
-                TRACE("anf_simplifier", tout << "equivalence " << p << " : " << x << " == " << y << "\n";);
+        for (pdd_solver* solver : solvers) {
+            for (auto* e : solver->equations()) {
+                auto const& p = e->poly();
+                if (p.is_one()) {
+                    s.set_conflict();
+                    break;
+                }
+                else if (p.is_unary()) {
+                    // unit
+                    SASSERT(!p.is_val() && p.lo().is_val() && p.hi().is_val());
+                    literal lit(p.var(), p.lo().is_zero());
+                    s.assign_unit(lit);
+                    ++m_stats.m_num_units;
+                    TRACE("anf_simplifier", tout << "unit " << p << " : " << lit << "\n";);
+                }
+                else if (p.is_binary()) {
+                    // equivalence
+                    // x + y + c = 0
+                    SASSERT(!p.is_val() && p.hi().is_one() && !p.lo().is_val() && p.lo().hi().is_one() && p.lo().lo().is_val());
+                    literal x(p.var(), false);
+                    literal y(p.lo().var(), p.lo().lo().is_one());
+                    add_eq(x, y);
+                    ++m_stats.m_num_eqs;
+                    TRACE("anf_simplifier", tout << "equivalence " << p << " : " << x << " == " << y << "\n";);
+                }
             }
+            if (s.inconsistent())
+                break;
         }
 
         if (old_num_eqs < m_stats.m_num_eqs) {
@@ -156,26 +299,46 @@ namespace sat {
         m_eval_ts += 2;
     }
 
-    void anf_simplifier::clauses2anf(pdd_solver& solver) {
+    void anf_simplifier::clauses2anf(vector<constraint>& cs) {
         svector<solver::bin_clause> bins;
         m_relevant.reset();
         m_relevant.resize(s.num_vars(), false);
         clause_vector clauses(s.clauses());
         s.collect_bin_clauses(bins, false, false);
         collect_clauses(clauses, bins);
-        try {
-            compile_xors(clauses, solver);
-            compile_aigs(clauses, bins, solver);
-
-            for (auto const& b : bins) {
-                add_bin(b, solver);
-            }                
-            for (clause* cp : clauses) {
-                add_clause(*cp, solver);
-            }
+        compile_xors(clauses, cs);
+        compile_aigs(clauses, bins, cs);
+
+        for (auto const& b : bins) {
+            literal_vector lits;
+            lits.push_back(b.first); lits.push_back(b.second);
+            cs.push_back(constraint(constraint::bin_k, null_literal, lits));
         }
-        catch (dd::pdd_manager::mem_out) {
-            IF_VERBOSE(1, verbose_stream() << "(sat.anf memout)\n");
+        for (clause* cp : clauses) {
+            if (is_too_large(*cp))
+                continue;
+            cs.push_back(constraint(constraint::clause_k, null_literal, literal_vector(cp->size(), cp->begin())));
+            cs.back().m_clause = cp;
+        }
+    }
+
+    void anf_simplifier::add_constraint(constraint const& c, pdd_solver& ps) {
+        switch (c.m_kind) {
+        case constraint::bin_k:
+            add_bin(solver::bin_clause(c.m_lits[0], c.m_lits[1]), ps);
+            break;
+        case constraint::clause_k:
+            add_clause(*c.m_clause, ps);
+            break;
+        case constraint::xor_k:
+            add_xor(c.m_lits, ps);
+            break;
+        case constraint::aig_k:
+            add_aig(c.m_head, c.m_lits, ps);
+            break;
+        case constraint::ite_k:
+            add_if(c.m_head, c.m_lits[0], c.m_lits[1], c.m_lits[2], ps);
+            break;
         }
     }
 
@@ -295,13 +458,13 @@ namespace sat {
        Add the extracted xors to pdd_solver.
        Remove clauses from list that correspond to extracted xors
      */
-    void anf_simplifier::compile_xors(clause_vector& clauses, pdd_solver& ps) {
+    void anf_simplifier::compile_xors(clause_vector& clauses, vector<constraint>& cs) {
         if (!m_config.m_compile_xor) {
             return;
         }
         std::function<void(literal_vector const&)> f =
             [&,this](literal_vector const& x) { 
-            add_xor(x, ps);
+            cs.push_back(constraint(constraint::xor_k, null_literal, x));
             m_stats.m_num_xors++;
         };
         xor_finder xf(s);
@@ -323,7 +486,7 @@ namespace sat {
        Remove clauses from list that correspond to extracted AIGs
        Remove binary clauses that correspond to extracted AIGs.       
      */
-    void anf_simplifier::compile_aigs(clause_vector& clauses, svector<solver::bin_clause>& bins, pdd_solver& ps) {
+    void anf_simplifier::compile_aigs(clause_vector& clauses, svector<solver::bin_clause>& bins, vector<constraint>& cs) {
         if (!m_config.m_compile_aig) {
             return;
         }
@@ -331,7 +494,7 @@ namespace sat {
 
         std::function<void(literal head, literal_vector const& tail)> on_aig =
             [&,this](literal head, literal_vector const& tail) {
-            add_aig(head, tail, ps);
+            cs.push_back(constraint(constraint::aig_k, head, tail));
             for (literal l : tail) {                
                 seen_bin.insert(normalize(solver::bin_clause(~l, head)));
             }
@@ -339,7 +502,9 @@ namespace sat {
         };
         std::function<void(literal head, literal c, literal th, literal el)> on_if = 
             [&,this](literal head, literal c, literal th, literal el) {
-            add_if(head, c, th, el, ps);
+            literal_vector cte;
+            cte.push_back(c); cte.push_back(th); cte.push_back(el);
+            cs.push_back(constraint(constraint::ite_k, head, cte));
             m_stats.m_num_ifs++;
         };
         aig_finder af(s);
@@ -353,30 +518,19 @@ namespace sat {
     }
 
     /**
-       assign levels to variables. 
-       use variable id as a primary source for the level of a variable.
-       secondarily, sort variables randomly (each variable is assigned
+       assign levels to variables given by l2v.
+       l2v uses variable id as a primary source for the level of a variable.
+       secondarily, it sorts variables randomly (each variable is assigned
        a random, unique, id).
     */
-    void anf_simplifier::configure_solver(pdd_solver& ps) {
-        unsigned nv = s.num_vars();
-        unsigned_vector l2v(nv), var2id(nv), id2var(nv);
-        svector<std::pair<unsigned, unsigned>> vl(nv);
-
-        for (unsigned i = 0; i < nv; ++i) var2id[i] = i;
-        shuffle(var2id.size(), var2id.data(), s.rand());
-        for (unsigned i = 0; i < nv; ++i) id2var[var2id[i]] = i;
-        for (unsigned i = 0; i < nv; ++i) vl[i] = std::make_pair(i, var2id[i]);
-        std::sort(vl.begin(), vl.end());
-        for (unsigned i = 0; i < nv; ++i) l2v[i] = id2var[vl[i].second];
-
+    void anf_simplifier::configure_solver(unsigned_vector const& l2v, unsigned seed, pdd_solver& ps) {
         ps.get_manager().reset(l2v);
 
         // set configuration parameters.
         dd::solver::config cfg;
         cfg.m_expr_size_limit = 1000;
         cfg.m_max_steps = 1000;
-        cfg.m_random_seed = s.rand()();
+        cfg.m_random_seed = seed;
         cfg.m_enable_exlin = m_config.m_enable_exlin;
 
         unsigned max_num_nodes = 1 << 18;
@@ -428,8 +582,9 @@ namespace sat {
         TRACE("anf_simplifier", tout << "ite: " << head << " == " << c << "?" << th << ":" << el << " poly : " << p << "\n";);
     }
 
-    void anf_simplifier::save_statistics(pdd_solver& solver) {
-        solver.collect_statistics(m_st);
+    void anf_simplifier::save_statistics(ptr_vector<pdd_solver> const& solvers) {
+        for (pdd_solver* solver : solvers)
+            solver->collect_statistics(m_st);
         m_st.update("sat-anf.units", m_stats.m_num_units);
         m_st.update("sat-anf.eqs",   m_stats.m_num_eqs);
         m_st.update("sat-anf.ands",  m_stats.m_num_aigs);
@@ -43,18 +43,35 @@ namespace sat {
             bool     m_compile_aig;
             bool     m_anf2phase;
             bool     m_enable_exlin;
+            unsigned m_num_threads;
             config():
                 m_max_clause_size(3),
                 m_max_clauses(10000),
                 m_compile_xor(true),
                 m_compile_aig(true),
                 m_anf2phase(false),
-                m_enable_exlin(false)
+                m_enable_exlin(false),
+                m_num_threads(1)
             {}
         };
 
     private:
         struct report;
+        struct worker;
+
+        /**
+           \brief clause, xor, and-gate or if-then-else extracted from the clauses.
+           The constraints are collected before they are compiled to polynomials,
+           such that independent constraints can be compiled by different pdd managers.
+         */
+        struct constraint {
+            enum kind_t { bin_k, clause_k, xor_k, aig_k, ite_k };
+            kind_t         m_kind;
+            literal        m_head;
+            literal_vector m_lits;
+            clause*        m_clause = nullptr;
+            constraint(kind_t k, literal head, literal_vector const& lits): m_kind(k), m_head(head), m_lits(lits) {}
+        };
 
         struct stats {
             unsigned m_num_units, m_num_eqs;
@@ -73,23 +90,26 @@ namespace sat {
         unsigned        m_eval_ts;
         bool_vector   m_used_for_evaluation;
 
-        void clauses2anf(pdd_solver& solver);
-        void anf2clauses(pdd_solver& solver);
+        void clauses2anf(vector<constraint>& cs);
+        void anf2clauses(ptr_vector<pdd_solver> const& solvers);
         void anf2phase(pdd_solver& solver);
 
         void collect_clauses(clause_vector & clauses, svector<solver::bin_clause>& bins);
 
-        void compile_xors(clause_vector& clauses, pdd_solver& ps);
-        void compile_aigs(clause_vector& clauses, svector<solver::bin_clause>& bins, pdd_solver& ps);
+        void compile_xors(clause_vector& clauses, vector<constraint>& cs);
+        void compile_aigs(clause_vector& clauses, svector<solver::bin_clause>& bins, vector<constraint>& cs);
 
         void collect_xors(vector<literal_vector>& xors);
-        void configure_solver(pdd_solver& ps);
+        void partition(vector<constraint> const& cs, vector<unsigned_vector>& groups);
+        void simplify(vector<constraint> const& cs, unsigned_vector const& group, pdd_solver& ps);
+        void configure_solver(unsigned_vector const& l2v, unsigned seed, pdd_solver& ps);
+        void add_constraint(constraint const& c, pdd_solver& ps);
         void add_clause(clause const& c, pdd_solver& ps);
         void add_bin(solver::bin_clause const& b, pdd_solver& ps);
         void add_xor(literal_vector const& x, pdd_solver& ps);
         void add_if(literal head, literal c, literal t, literal e, pdd_solver& ps);
         void add_aig(literal head, literal_vector const& ands, pdd_solver& ps);        
-        void save_statistics(pdd_solver& ps);
+        void save_statistics(ptr_vector<pdd_solver> const& solvers);
 
         bool eval(dd::pdd const& p);
         void reset_eval();
@@ -100,6 +100,7 @@ namespace sat {
 
         void collect_statistics(statistics & st) const;
         void reset_statistics();
+        unsigned num_elim_literals() const { return m_elim_literals; }
 
         void init_search() { m_calls = 0; }
 
@@ -34,7 +34,8 @@ namespace sat {
         m_reinit_stack(false),
         m_inact_rounds(0),
         m_glue(255),
-        m_psm(255) {
+        m_psm(255),
+        m_tier(0) {
         memcpy(m_lits, lits, sizeof(literal) * sz);
         mark_strengthened();
         SASSERT(check_approx());
@@ -156,12 +157,40 @@ namespace sat {
         }
     }
 
-    clause_allocator::clause_allocator():
-        m_allocator("clause-allocator") {
+    clause_allocator::clause_allocator() {
+        m_allocator[CORE_TIER].set_id("clause-allocator-core");
+        m_allocator[MID_TIER].set_id("clause-allocator-mid");
+        m_allocator[LOCAL_TIER].set_id("clause-allocator-local");
     }
 
     void clause_allocator::finalize() {
-        m_allocator.reset();
+        for (sat_allocator& a : m_allocator)
+            a.reset();
+    }
+
+    size_t clause_allocator::get_allocation_size() const {
+        size_t sz = 0;
+        for (sat_allocator const& a : m_allocator)
+            sz += a.get_allocation_size();
+        return sz;
+    }
+
+    bool clause_allocator::is_fragmented() const {
+        size_t reserved = 0, live = 0;
+        for (sat_allocator const& a : m_allocator) {
+            reserved += a.get_chunk_size();
+            live += a.get_small_allocation_size();
+        }
+        // ignore small arenas, there is not much to gain
+        return reserved > (1u << 22) && reserved > 2 * live;
+    }
+
+    clause_allocator::tier clause_allocator::get_tier(clause const& c) {
+        if (!c.is_learned() || c.glue() <= 2)
+            return CORE_TIER;
+        if (c.glue() <= 6)
+            return MID_TIER;
+        return LOCAL_TIER;
     }
 
     clause * clause_allocator::get_clause(clause_offset cls_off) const {
@@ -174,19 +203,24 @@ namespace sat {
         return reinterpret_cast<size_t>(cls);
     }
 
-    clause * clause_allocator::mk_clause(unsigned num_lits, literal const * lits, bool learned) {
+    clause * clause_allocator::alloc_clause(tier t, unsigned num_lits, literal const * lits, bool learned) {
         size_t size = clause::get_obj_size(num_lits);
-        void * mem = m_allocator.allocate(size);
+        void * mem = m_allocator[t].allocate(size);
         clause * cls = new (mem) clause(m_id_gen.mk(), num_lits, lits, learned);
+        cls->m_tier = t;
+        return cls;
+    }
+
+    clause * clause_allocator::mk_clause(unsigned num_lits, literal const * lits, bool learned) {
+        // the glue of a new learned clause is not known yet
+        clause * cls = alloc_clause(learned ? LOCAL_TIER : CORE_TIER, num_lits, lits, learned);
         TRACE("sat_clause", tout << "alloc: " << cls->id() << " " << *cls << " " << (learned?"l":"a") << "\n";);
         SASSERT(!learned || cls->is_learned());
         return cls;
     }
 
     clause * clause_allocator::copy_clause(clause const& other) {
-        size_t size = clause::get_obj_size(other.size());
-        void * mem = m_allocator.allocate(size);
-        clause * cls = new (mem) clause(m_id_gen.mk(), other.size(), other.m_lits, other.is_learned());
+        clause * cls = alloc_clause(get_tier(other), other.size(), other.m_lits, other.is_learned());
         cls->m_reinit_stack = other.on_reinit_stack();
         cls->m_glue   = other.glue();
         cls->m_psm    = other.psm();
@@ -199,8 +233,9 @@ namespace sat {
         TRACE("sat_clause", tout << "delete: " << cls->id() << " " << *cls << "\n";);
         m_id_gen.recycle(cls->id());
         size_t size = clause::get_obj_size(cls->m_capacity);
+        unsigned t = cls->m_tier;
         cls->~clause();
-        m_allocator.deallocate(size, cls);
+        m_allocator[t].deallocate(size, cls);
     }
 
     std::ostream & operator<<(std::ostream & out, clause const & c) {
@@ -53,6 +53,7 @@ namespace sat {
         unsigned           m_inact_rounds:8;
         unsigned           m_glue:8;
         unsigned           m_psm:8;  // transient field used during gc
+        unsigned           m_tier:2; // arena of the clause allocator holding the clause
         literal            m_lits[0];
 
         static size_t get_obj_size(unsigned num_lits) { return sizeof(clause) + num_lits * sizeof(literal); }
@@ -136,15 +137,30 @@ namespace sat {
        \brief Simple clause allocator that allows uint (32bit integers) to be used to reference clauses (even in 64bit machines).
     */
     class clause_allocator {
-        sat_allocator    m_allocator;
+    public:
+        // clauses are kept in separate arenas by how long they are expected to live, so that the clauses
+        // visited during propagation share cache lines with clauses of similar activity.
+        enum tier {
+            CORE_TIER = 0,  // irredundant clauses and learned clauses of small glue
+            MID_TIER,       // learned clauses of moderate glue
+            LOCAL_TIER,     // other learned clauses, most of them are removed by the next gc
+            NUM_TIERS
+        };
+    private:
+        sat_allocator    m_allocator[NUM_TIERS];
         id_gen           m_id_gen;
+        clause *      alloc_clause(tier t, unsigned num_lits, literal const * lits, bool learned);
     public:
         clause_allocator();
         void          finalize();
-        size_t        get_allocation_size() const { return m_allocator.get_allocation_size(); }
+        size_t        get_allocation_size() const;
+        // true if the arenas hold much more memory than their live clauses (defragmentation pays off).
+        bool          is_fragmented() const;
+        static tier   get_tier(clause const& c);
         clause *      get_clause(clause_offset cls_off) const;
         clause_offset get_offset(clause const * ptr) const;
         clause *      mk_clause(unsigned num_lits, literal const * lits, bool learned);
+        // copy of other in the arena of its tier (used to defragment the clauses).
         clause *      copy_clause(clause const& other);
         void          del_clause(clause * cls);
     };
@@ -84,6 +84,8 @@ namespace sat {
         m_propagate_prefetch = p.propagate_prefetch();
         m_inprocess_max   = p.inprocess_max();
         m_inprocess_out   = p.inprocess_out();
+        m_inprocess_adaptive = p.inprocess_adaptive();
+        m_inprocess_max_backoff = p.inprocess_max_backoff();
 
         m_random_freq     = p.random_freq();
         m_random_seed     = p.random_seed();
@@ -96,6 +98,13 @@ namespace sat {
         
         m_max_conflicts   = p.max_conflicts();
         m_num_threads     = p.threads();
+        m_par_share_max_size  = p.par_share_max_size();
+        m_par_share_max_glue  = p.par_share_max_glue();
+        m_par_share_core_glue = p.par_share_core_glue();
+        m_cc              = p.cc();
+        m_cc_threads      = p.cc_threads();
+        m_cc_dir          = p.cc_dir();
+        m_cc_worker       = p.cc_worker();
         m_ddfw_search     = p.ddfw_search();
         m_ddfw_threads    = p.ddfw_threads();
         m_prob_search     = p.prob_search();
@@ -111,6 +120,7 @@ namespace sat {
         m_anf_simplify      = p.anf();
         m_anf_delay         = p.anf_delay();
         m_anf_exlin         = p.anf_exlin();
+        m_anf_threads       = p.anf_threads();
         m_cut_simplify      = p.cut();
         m_cut_delay         = p.cut_delay();
         m_cut_aig           = p.cut_aig();
@@ -210,6 +220,8 @@ namespace sat {
              m_smt_proof_check ||
              m_drat_check_sat);
         m_drat_binary     = p.drat_binary();
+        m_drat_buffer_size = p.drat_buffer_size();
+        m_drat_flush_size = p.drat_flush_size();
         m_drat_activity   = p.drat_activity();
         m_dyn_sub_res     = p.dyn_sub_res();
 
@@ -106,12 +106,21 @@ namespace sat {
         double             m_slow_glue_avg;
         unsigned           m_inprocess_max;
         symbol             m_inprocess_out;
+        bool               m_inprocess_adaptive;
+        unsigned           m_inprocess_max_backoff;
         double             m_random_freq;
         unsigned           m_random_seed;
         unsigned           m_burst_search;
         bool               m_enable_pre_simplify;
         unsigned           m_max_conflicts;
         unsigned           m_num_threads;
+        unsigned           m_par_share_max_size;
+        unsigned           m_par_share_max_glue;
+        unsigned           m_par_share_core_glue;
+        bool               m_cc;
+        unsigned           m_cc_threads;
+        symbol             m_cc_dir;
+        bool               m_cc_worker;
         bool               m_ddfw_search;
         unsigned           m_ddfw_threads;
         bool               m_prob_search;
@@ -132,6 +141,7 @@ namespace sat {
         bool               m_anf_simplify;
         unsigned           m_anf_delay;
         bool               m_anf_exlin;
+        unsigned           m_anf_threads;
         bool               m_lookahead_simplify;
         bool               m_lookahead_simplify_bca;
         cutoff_t           m_lookahead_cube_cutoff;
@@ -179,6 +189,8 @@ namespace sat {
         bool               m_drat_disable;
         bool               m_drat_binary;
         symbol             m_drat_file;
+        unsigned           m_drat_buffer_size;
+        unsigned           m_drat_flush_size;
         bool               m_smt_proof_check;
         bool               m_drat_check_unsat;
         bool               m_drat_check_sat;
@@ -0,0 +1,514 @@
+/*++
+
+Module Name:
+
+    sat_cube_conquer.cpp
+
+Abstract:
+
+    Cube-and-conquer driver.
+
+--*/
+
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#ifndef SINGLE_THREAD
+#include <mutex>
+#include <thread>
+#endif
+#include "util/rlimit.h"
+#include "sat/sat_cube_conquer.h"
+#include "sat/sat_solver.h"
+#include "sat/sat_params.hpp"
+
+namespace sat {
+
+    namespace fs = std::filesystem;
+
+    namespace {
+
+        void sleep_a_bit() {
+#ifndef SINGLE_THREAD
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+        }
+
+        /**
+           \brief queue of the worker threads of one process.
+        */
+        class memory_queue : public cube_conquer::queue {
+#ifndef SINGLE_THREAD
+            std::mutex                      m_mux;
+#define CC_LOCK() std::lock_guard<std::mutex> _lock(m_mux)
+#else
+#define CC_LOCK()
+#endif
+            std::deque<cube_conquer::task>  m_todo;
+            unsigned                        m_open = 0;
+            bool                            m_refuted = false;
+            bool                            m_sat = false;
+            model                           m_model;
+            literal_vector                  m_units;
+            uint_set                        m_unit_set;
+        public:
+            void push(cube_conquer::task const& t) override {
+                CC_LOCK();
+                m_todo.push_back(t);
+                ++m_open;
+            }
+
+            bool pop(cube_conquer::task& t) override {
+                CC_LOCK();
+                if (m_todo.empty())
+                    return false;
+                t = m_todo.front();
+                m_todo.pop_front();
+                return true;
+            }
+
+            void done(cube_conquer::task const& t, cube_conquer::outcome o, vector<literal_vector> const& children, model const& mdl) override {
+                CC_LOCK();
+                switch (o) {
+                case cube_conquer::outcome::unsat:
+                    break;
+                case cube_conquer::outcome::refuted:
+                    m_refuted = true;
+                    break;
+                case cube_conquer::outcome::sat:
+                    if (!m_sat) {
+                        m_sat = true;
+                        m_model.reset();
+                        m_model.append(mdl);
+                    }
+                    break;
+                case cube_conquer::outcome::split:
+                    for (unsigned i = 0; i < children.size(); ++i) {
+                        m_todo.push_front(cube_conquer::task{ t.m_id + "." + std::to_string(i), children[i] });
+                        ++m_open;
+                    }
+                    break;
+                }
+                --m_open;
+            }
+
+            void share_units(literal_vector const& units) override {
+                CC_LOCK();
+                for (literal l : units) {
+                    if (!m_unit_set.contains(l.index())) {
+                        m_unit_set.insert(l.index());
+                        m_units.push_back(l);
+                    }
+                }
+            }
+
+            void get_units(literal_vector& units) override {
+                CC_LOCK();
+                units.reset();
+                units.append(m_units);
+            }
+
+            bool is_finished() override {
+                CC_LOCK();
+                return m_sat || m_refuted || m_open == 0;
+            }
+
+            lbool result(model& mdl) override {
+                CC_LOCK();
+                if (m_sat) {
+                    mdl.reset();
+                    mdl.append(m_model);
+                    return l_true;
+                }
+                return m_refuted || m_open == 0 ? l_false : l_undef;
+            }
+#undef CC_LOCK
+        };
+
+        /**
+           \brief queue in a directory shared with worker processes, see sat_cube_conquer.h for the protocol.
+        */
+        class dir_queue : public cube_conquer::queue {
+            fs::path              m_dir;
+            std::string           m_tag;
+            bool                  m_is_driver;
+            // driver state, read from the result files
+            std::set<std::string> m_seen;
+            unsigned              m_open = 0;
+            bool                  m_refuted = false;
+            bool                  m_sat = false;
+            model                 m_model;
+
+            static bool ends_with(std::string const& s, std::string const& suffix) {
+                return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+            }
+
+            void write_file(fs::path const& p, std::string const& content) {
+                fs::path tmp = p;
+                tmp += ".tmp." + m_tag;
+                {
+                    std::ofstream out(tmp, std::ios_base::out | std::ios_base::trunc);
+                    out << content;
+                }
+                std::error_code ec;
+                fs::rename(tmp, p, ec);
+            }
+
+            static void read_lits(std::istream& in, literal_vector& lits) {
+                lits.reset();
+                unsigned idx;
+                // indices are shifted by one in the files, so 0 terminates
+                while (in >> idx && idx != 0)
+                    lits.push_back(to_literal(idx - 1));
+            }
+
+            static std::string encode(literal_vector const& lits) {
+                std::ostringstream out;
+                for (literal l : lits)
+                    out << (l.index() + 1) << " ";
+                out << "0\n";
+                return out.str();
+            }
+
+            void collect_results() {
+                std::error_code ec;
+                for (auto const& e : fs::directory_iterator(m_dir, ec)) {
+                    std::string name = e.path().filename().string();
+                    if (!ends_with(name, ".result") || m_seen.count(name))
+                        continue;
+                    std::ifstream in(e.path());
+                    std::string kind;
+                    if (!(in >> kind))
+                        continue;
+                    m_seen.insert(name);
+                    if (kind == "unsat")
+                        --m_open;
+                    else if (kind == "refuted")
+                        m_refuted = true;
+                    else if (kind == "split") {
+                        unsigned n = 0;
+                        in >> n;
+                        m_open += n;
+                        --m_open;
+                    }
+                    else if (kind == "sat" && !m_sat) {
+                        m_sat = true;
+                        m_model.reset();
+                        std::string val;
+                        while (in >> val && val != "0")
+                            m_model.push_back(val == "1" ? l_true : val == "-1" ? l_false : l_undef);
+                    }
+                }
+            }
+
+        public:
+            dir_queue(std::string const& dir, std::string const& tag, bool is_driver):
+                m_dir(dir), m_tag(tag), m_is_driver(is_driver) {
+                std::error_code ec;
+                fs::create_directories(m_dir, ec);
+                if (is_driver)
+                    fs::remove(m_dir / "finished", ec);
+            }
+
+            void push(cube_conquer::task const& t) override {
+                write_file(m_dir / ("cube-" + t.m_id + ".todo"), encode(t.m_cube));
+                ++m_open;
+            }
+
+            bool pop(cube_conquer::task& t) override {
+                std::error_code ec;
+                for (auto const& e : fs::directory_iterator(m_dir, ec)) {
+                    std::string name = e.path().filename().string();
+                    if (!ends_with(name, ".todo"))
+                        continue;
+                    std::string id = name.substr(5, name.size() - 10);
+                    fs::path run = m_dir / ("cube-" + id + ".run." + m_tag);
+                    std::error_code ec2;
+                    fs::rename(e.path(), run, ec2);
+                    if (ec2)
+                        continue; // claimed by another worker
+                    std::ifstream in(run);
+                    t.m_id = id;
+                    // literal indices are shifted, see encode
+                    read_lits(in, t.m_cube);
+                    return true;
+                }
+                return false;
+            }
+
+            void done(cube_conquer::task const& t, cube_conquer::outcome o, vector<literal_vector> const& children, model const& mdl) override {
+                std::ostringstream out;
+                switch (o) {
+                case cube_conquer::outcome::unsat:
+                    out << "unsat\n";
+                    break;
+                case cube_conquer::outcome::refuted:
+                    out << "refuted\n";
+                    break;
+                case cube_conquer::outcome::sat:
+                    out << "sat\n";
+                    for (lbool v : mdl)
+                        out << (v == l_true ? "1 " : v == l_false ? "-1 " : "u ");
+                    out << "0\n";
+                    break;
+                case cube_conquer::outcome::split:
+                    // the children exist before the result which accounts for them
+                    for (unsigned i = 0; i < children.size(); ++i)
+                        write_file(m_dir / ("cube-" + t.m_id + "." + std::to_string(i) + ".todo"), encode(children[i]));
+                    out << "split " << children.size() << "\n";
+                    break;
+                }
+                write_file(m_dir / ("cube-" + t.m_id + ".result"), out.str());
+                std::error_code ec;
+                fs::remove(m_dir / ("cube-" + t.m_id + ".run." + m_tag), ec);
+            }
+
+            void share_units(literal_vector const& units) override {
+                write_file(m_dir / ("units." + m_tag), encode(units));
+            }
+
+            void get_units(literal_vector& units) override {
+                units.reset();
+                std::error_code ec;
+                literal_vector lits;
+                for (auto const& e : fs::directory_iterator(m_dir, ec)) {
+                    std::string name = e.path().filename().string();
+                    if (name.compare(0, 6, "units.") != 0 || name.find(".tmp.") != std::string::npos)
+                        continue;
+                    std::ifstream in(e.path());
+                    read_lits(in, lits);
+                    units.append(lits);
+                }
+            }
+
+            bool is_finished() override {
+                std::error_code ec;
+                if (!m_is_driver)
+                    return fs::exists(m_dir / "finished", ec);
+                collect_results();
+                bool finished = m_sat || m_refuted || m_open == 0;
+                if (finished)
+                    write_file(m_dir / "finished", "");
+                return finished;
+            }
+
+            lbool result(model& mdl) override {
+                if (m_sat) {
+                    mdl.reset();
+                    mdl.append(m_model);
+                    return l_true;
+                }
+                return m_refuted || m_open == 0 ? l_false : l_undef;
+            }
+        };
+
+        std::string mk_tag(unsigned i) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            return std::to_string(static_cast<unsigned long long>(now)) + "-" + std::to_string(i);
+        }
+
+    }
+
+    cube_conquer::queue* cube_conquer::mk_queue(bool is_driver, std::string const& tag) {
+        symbol dir = s.get_config().m_cc_dir;
+        if (dir.is_non_empty_string())
+            return alloc(dir_queue, dir.str(), tag, is_driver);
+        return alloc(memory_queue);
+    }
+
+    /**
+       \brief solve one cube of q by w, returns false if there was no cube to solve.
+    */
+    bool cube_conquer::step(solver& w, queue& q, literal_vector& units) {
+        task t;
+        if (!q.pop(t))
+            return false;
+        w.pop_to_base_level();
+        q.get_units(units);
+        for (literal l : units) {
+            if (l.var() < w.num_vars() && !w.was_eliminated(l.var()) && w.value(l) == l_undef && !w.inconsistent())
+                w.assign_unit(l);
+        }
+        // dropping literals of eliminated variables weakens the cube, which keeps both outcomes sound
+        literal_vector cube;
+        for (literal l : t.m_cube)
+            if (l.var() < w.num_vars() && !w.was_eliminated(l.var()))
+                cube.push_back(l);
+
+        lbool r = w.check(cube.size(), cube.data());
+
+        units.reset();
+        unsigned sz = w.init_trail_size();
+        for (unsigned i = 0; i < sz; ++i)
+            units.push_back(w.m_trail[i]);
+        if (!units.empty())
+            q.share_units(units);
+
+        vector<literal_vector> children;
+        model none;
+        if (r == l_true)
+            q.done(t, outcome::sat, children, w.get_model());
+        else if (r == l_false)
+            q.done(t, w.get_core().empty() ? outcome::refuted : outcome::unsat, children, none);
+        else if (!w.rlimit().inc()) {
+            // canceled, put the cube back for another worker
+            q.done(t, outcome::split, vector<literal_vector>(1, t.m_cube), none);
+        }
+        else {
+            // the conflict budget is exhausted: split on the most active free variable.
+            w.pop_to_base_level();
+            bool_var best = null_bool_var;
+            uint_set in_cube;
+            for (literal l : cube)
+                in_cube.insert(l.var());
+            for (bool_var v = 0; v < w.num_vars(); ++v) {
+                if (w.value(v) != l_undef || w.was_eliminated(v) || in_cube.contains(v))
+                    continue;
+                if (best == null_bool_var || w.m_activity[v] > w.m_activity[best])
+                    best = v;
+            }
+            if (best == null_bool_var) {
+                children.push_back(t.m_cube);
+            }
+            else {
+                literal_vector c(t.m_cube);
+                c.push_back(literal(best, false));
+                children.push_back(c);
+                c.back().neg();
+                children.push_back(c);
+                ++m_num_splits;
+            }
+            IF_VERBOSE(2, verbose_stream() << "(sat.cc :split " << t.m_id << " :depth " << t.m_cube.size() << ")\n";);
+            q.done(t, outcome::split, children, none);
+        }
+        ++m_num_cubes;
+        return true;
+    }
+
+    static params_ref worker_params(params_ref const& p, unsigned seed) {
+        params_ref wp;
+        wp.copy(p);
+        wp.set_bool("cc", false);
+        wp.set_bool("cc.worker", false);
+        wp.set_uint("threads", 1);
+        wp.set_uint("local_search_threads", 0);
+        wp.set_uint("ddfw.threads", 0);
+        wp.set_uint("random_seed", seed);
+        wp.set_uint("max_conflicts", sat_params(p).cc_conflicts());
+        return wp;
+    }
+
+    lbool cube_conquer::operator()() {
+        // create the frontier of cubes
+        vector<literal_vector> cubes;
+        {
+            solver cuber(s.m_params, s.rlimit());
+            cuber.copy(s);
+            bool_var_vector vars;
+            literal_vector lits;
+            while (true) {
+                vars.reset();
+                lbool r = cuber.cube(vars, lits, UINT_MAX);
+                if (r == l_false)
+                    break;
+                if (r == l_true) {
+                    s.set_model(cuber.get_model(), true);
+                    return l_true;
+                }
+                if (lits.empty()) {
+                    // the rest of the search space is not split, give up splitting
+                    cubes.reset();
+                    cubes.push_back(literal_vector());
+                    break;
+                }
+                cubes.push_back(lits);
+            }
+            if (cubes.empty()) {
+                s.m_core.reset();
+                return l_false;
+            }
+        }
+        IF_VERBOSE(1, verbose_stream() << "(sat.cc :cubes " << cubes.size() << ")\n";);
+
+        scoped_ptr<queue> q = mk_queue(true, mk_tag(0));
+        for (unsigned i = 0; i < cubes.size(); ++i)
+            q->push(task{ std::to_string(i), cubes[i] });
+
+        unsigned num_workers = std::max(1u, s.get_config().m_cc_threads);
+        vector<reslimit> lims(num_workers);
+        scoped_limits sl(s.rlimit());
+        scoped_ptr_vector<solver> workers;
+        for (unsigned i = 0; i < num_workers; ++i) {
+            workers.push_back(alloc(solver, worker_params(s.m_params, s.m_rand()), lims[i]));
+            workers.back()->copy(s, true);
+            sl.push_child(&lims[i]);
+        }
+        std::string ex_msg;
+        bool failed = false;
+#ifndef SINGLE_THREAD
+        std::mutex mux;
+        auto run = [&](unsigned i) {
+            literal_vector units;
+            try {
+                while (!q->is_finished() && lims[i].inc())
+                    if (!step(*workers[i], *q, units))
+                        sleep_a_bit();
+            }
+            catch (z3_exception& ex) {
+                std::lock_guard<std::mutex> lock(mux);
+                ex_msg = ex.msg();
+                failed = true;
+            }
+        };
+        // the queue is polled only by the driver for directory queues
+        vector<std::thread> threads;
+        for (unsigned i = 0; i < num_workers; ++i)
+            threads.push_back(std::thread([&, i]() { run(i); }));
+        while (!q->is_finished() && s.rlimit().inc() && !failed)
+            sleep_a_bit();
+        for (reslimit& l : lims)
+            l.cancel();
+        for (auto& t : threads)
+            t.join();
+#else
+        literal_vector units;
+        while (!q->is_finished() && s.rlimit().inc())
+            step(*workers[0], *q, units);
+#endif
+        s.m_aux_stats.update("sat cc cubes", m_num_cubes);
+        s.m_aux_stats.update("sat cc splits", m_num_splits);
+        if (failed)
+            throw default_exception(std::move(ex_msg));
+        model mdl;
+        lbool r = q->result(mdl);
+        if (r == l_true)
+            s.set_model(mdl, true);
+        else if (r == l_false)
+            s.m_core.reset();
+        return r;
+    }
+
+    lbool cube_conquer::work() {
+        scoped_ptr<queue> q = mk_queue(false, mk_tag(1));
+        reslimit lim;
+        scoped_limits sl(s.rlimit());
+        sl.push_child(&lim);
+        solver w(worker_params(s.m_params, s.m_rand()), lim);
+        w.copy(s, true);
+        literal_vector units;
+        while (!q->is_finished() && s.rlimit().inc())
+            if (!step(w, *q, units))
+                sleep_a_bit();
+        IF_VERBOSE(1, verbose_stream() << "(sat.cc.worker :cubes " << m_num_cubes << " :splits " << m_num_splits << ")\n";);
+        return l_undef;
+    }
+
+    void cube_conquer::collect_statistics(statistics& st) const {
+        st.update("sat cc cubes", m_num_cubes);
+        st.update("sat cc splits", m_num_splits);
+    }
+
+}
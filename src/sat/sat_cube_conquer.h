@@ -0,0 +1,86 @@
+/*++
+
+Module Name:
+
+    sat_cube_conquer.h
+
+Abstract:
+
+    Cube-and-conquer driver.
+
+    The problem is split into a frontier of cubes by lookahead (see lookahead::cube,
+    controlled by the lookahead.cube.* parameters). The cubes are put into a work queue
+    and solved by CDCL workers under the cube as assumptions with a conflict budget
+    (sat.cc.conflicts). A worker which exhausts the budget splits its cube on the most
+    active free variable and puts both halves back to the queue. Units learned by the
+    workers are shared through the queue.
+
+    The queue is either in memory (local worker threads) or a directory (sat.cc.dir)
+    which is also served by worker processes on other nodes (sat.cc.worker=true, started
+    on the same CNF). The directory protocol:
+       cube-<id>.todo          cube to solve, literal indices terminated by 0
+       cube-<id>.run.<tag>     cube claimed by worker <tag> (claimed by renaming the .todo file)
+       cube-<id>.result        "unsat", "refuted" (unsat without the cube), "split <n>"
+                               (the children cube-<id>.<i>.todo were created before) or
+                               "sat" followed by the model
+       units.<tag>             units learned by worker <tag>
+       finished                created by the driver when the search is over
+    Files are written to a temporary name first and renamed, so readers never see partial files.
+
+--*/
+#pragma once
+
+#include <string>
+#include "sat/sat_types.h"
+
+namespace sat {
+
+    class solver;
+
+    class cube_conquer {
+    public:
+        struct task {
+            std::string    m_id;
+            literal_vector m_cube;
+        };
+
+        enum class outcome { unsat, refuted, sat, split };
+
+        class queue {
+        public:
+            virtual ~queue() = default;
+            virtual void push(task const& t) = 0;
+            // claim the next cube, false if there is none at the moment.
+            virtual bool pop(task& t) = 0;
+            // report the outcome of t, children are the cubes t was split into (outcome::split).
+            virtual void done(task const& t, outcome o, vector<literal_vector> const& children, model const& mdl) = 0;
+            virtual void share_units(literal_vector const& units) = 0;
+            virtual void get_units(literal_vector& units) = 0;
+            // true if the search is over: all cubes are unsat, a cube is refuted, a model is found,
+            // or (for workers of another process) the driver finished.
+            virtual bool is_finished() = 0;
+            // l_true (with mdl), l_false or l_undef if the search is not over.
+            virtual lbool result(model& mdl) = 0;
+        };
+
+    private:
+        solver&   s;
+        unsigned  m_num_cubes = 0;
+        unsigned  m_num_splits = 0;
+
+        bool step(solver& w, queue& q, literal_vector& units);
+        queue* mk_queue(bool is_driver, std::string const& tag);
+
+    public:
+        cube_conquer(solver& s): s(s) {}
+
+        // split, distribute and solve the problem of s.
+        lbool operator()();
+
+        // serve the queue in sat.cc.dir until the driver finishes.
+        lbool work();
+
+        void collect_statistics(statistics& st) const;
+    };
+
+}
@@ -17,6 +17,9 @@
 #include "sat/sat_cutset_compute_shift.h"
 #include <memory>
 #include <sstream>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 
 namespace sat {
@@ -179,6 +182,12 @@ namespace sat {
         return true;
     }
 
+    // effect_mask(i) for i = 0..6
+    static const uint64_t s_effect_mask[7] = {
+        0x5555555555555555ull, 0x3333333333333333ull, 0x0F0F0F0F0F0F0F0Full, 0x00FF00FF00FF00FFull,
+        0x0000FFFF0000FFFFull, 0x00000000FFFFFFFFull, ~0ull
+    };
+
     /**
      * \brief create the masks
      * i = 0: 101010101010101
@@ -189,19 +198,25 @@ namespace sat {
 
     uint64_t cut::effect_mask(unsigned i) {
         SASSERT(i <= 6);
-        uint64_t m = 0;
-        if (i == 6) {
-            m = ~((uint64_t)0);
-        }
-        else {
-            m = (1ull << (1u << i)) - 1;   // i = 0: m = 1
-            unsigned w = 1u << (i + 1);    // i = 0: w = 2
-            while (w < 64) {
-                m |= (m << w);             // i = 0: m = 1 + 4
-                w *= 2;
-            }
-        }
-        return m;
+        return s_effect_mask[i];
+    }
+
+    /**
+       \brief compress the bits of t selected by effect_mask(i) into the low half.
+       The selected bits come in blocks of 2^i bits, every other block.
+       Adjacent blocks are joined word-parallel in log steps, which uses 
+       pext where BMI2 is available.
+    */
+    uint64_t cut::compress_table(uint64_t t, unsigned i) {
+        SASSERT(i < 6);
+#if defined(__BMI2__)
+        return _pext_u64(t, s_effect_mask[i]);
+#else
+        t &= s_effect_mask[i];
+        for (unsigned j = i, s = 1u << i; s < 32; ++j, s *= 2) 
+            t = (t | (t >> s)) & s_effect_mask[j + 1];
+        return t;
+#endif
     }
 
     /**
@@ -212,15 +227,7 @@ namespace sat {
             m_elems[j-1] = m_elems[j]; 
         }
         --m_size;
-        uint64_t m = effect_mask(i);
-        uint64_t t = 0;
-        for (unsigned j = 0, offset = 0; j < 64; ++j) {
-            if (0 != (m & (1ull << j))) {
-                t |= ((m_table >> j) & 1u) << offset;
-                ++offset;
-            }
-        }
-        m_table = t;
+        m_table = compress_table(m_table, i);
         m_dont_care = 0;
         unsigned f = 0;
         for (unsigned e : *this) {
@@ -232,24 +239,28 @@ namespace sat {
     /**
        sat-sweep evaluation. Given 64 bits worth of possible values per variable, 
        find possible values for function table encoded by cut.
+
+       The 64 samples are evaluated word-parallel by a multiplexer tree 
+       over the truth table: the leaves are the table bits and level j 
+       selects between the cofactors of input j.
     */
     cut_val cut::eval(cut_eval const& env) const {
-        cut_val v;
         uint64_t t = table();
-        uint64_t n = table();
         unsigned sz = size();
         if (sz == 1 && t == 2) {
             return env[m_elems[0]];
         }
-        for (unsigned i = 0; i < 64; ++i) {
-            unsigned offset = 0;
-            for (unsigned j = 0; j < sz; ++j) {
-                offset |= (((env[m_elems[j]].m_t >> i) & 0x1) << j);
-            }
-            v.m_t |= ((t >> offset) & 0x1) << i;
-            v.m_f |= ((n >> offset) & 0x1) << i;
+        uint64_t w[32];
+        unsigned n = 1u << sz;
+        for (unsigned k = 0; k < n; ++k) 
+            w[k] = 0ull - ((t >> k) & 1ull);
+        for (unsigned j = 0; j < sz; ++j) {
+            uint64_t x = env[m_elems[j]].m_t;
+            n /= 2;
+            for (unsigned k = 0; k < n; ++k) 
+                w[k] = (x & w[2*k + 1]) | (~x & w[2*k]);
         }
-        return v;
+        return cut_val(w[0], w[0]);
     }
     
     std::ostream& cut::display(std::ostream& out) const {
@@ -154,6 +154,8 @@ namespace sat {
 
         static uint64_t effect_mask(unsigned i);
 
+        static uint64_t compress_table(uint64_t t, unsigned i);
+
         std::ostream& display(std::ostream& out) const;
 
         static std::ostream& display_table(std::ostream& out, unsigned num_input, uint64_t table);
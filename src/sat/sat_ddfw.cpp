@@ -277,6 +277,7 @@ namespace sat {
         m_parsync_next = m_config.m_parsync_base;
 
         m_min_sz = m_unsat.size();
+        m_model_unsat = UINT_MAX;
         m_flips = 0;
         m_last_flips = 0;
         m_shifts = 0;
@@ -295,6 +296,14 @@ namespace sat {
         flatten_use_list();
     }
 
+    void ddfw::import_phase(bool_vector const& phase) {
+        unsigned n = std::min(num_vars(), phase.size());
+        for (bool_var v = 0; v < n; ++v) 
+            if (value(v) != phase[v])
+                flip(v);
+        m_steps_since_progress = 0;
+    }
+
     void ddfw::flatten_use_list() {
         m_use_list_index.reset();
         m_flat_use_list.reset();
@@ -456,8 +465,9 @@ namespace sat {
     }
 
     void ddfw::do_parallel_sync() {
-        if (m_par->from_solver(*this)) 
-            m_par->to_solver(*this);
+        // publish the best assignment before it is possibly replaced by the one of another worker
+        m_par->to_solver(*this);
+        m_par->from_solver(*this);
         
         ++m_parsync_count;
         m_parsync_next *= 3;
@@ -468,6 +478,7 @@ namespace sat {
         m_model.reserve(num_vars());
         for (unsigned i = 0; i < num_vars(); ++i) 
             m_model[i] = to_lbool(value(i));
+        m_model_unsat = m_unsat.size();
         save_priorities();
         if (m_plugin)
             m_plugin->on_save_model();
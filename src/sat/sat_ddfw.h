@@ -114,6 +114,7 @@ namespace sat {
         svector<double>      m_probs;       // var -> probability of flipping
         svector<double>      m_scores;      // reward -> score
         model                m_model;       // var -> best assignment
+        unsigned             m_model_unsat = UINT_MAX; // number of unsatisfied clauses of m_model
         unsigned             m_init_weight = 2; 
         
         vector<unsigned_vector> m_use_list;
@@ -272,6 +273,10 @@ namespace sat {
         void add(solver const& s) override;
 
         bool get_value(bool_var v) const override { return value(v); }
+
+        unsigned get_model_unsat() const override { return m_model_unsat; }
+
+        void import_phase(bool_vector const& phase) override;
        
         std::ostream& display(std::ostream& out) const;
 
@@ -23,6 +23,7 @@ Notes:
 #include "util/rational.h"
 #include "sat/sat_solver.h"
 #include "sat/sat_drat.h"
+#include "sat/sat_drat_writer.h"
 
 namespace sat {
     
@@ -31,7 +32,12 @@ namespace sat {
     {
         if (s.get_config().m_drat && s.get_config().m_drat_file.is_non_empty_string()) {
             auto mode = s.get_config().m_drat_binary ? (std::ios_base::binary | std::ios_base::out | std::ios_base::trunc) : std::ios_base::out;
-            m_out = alloc(std::ofstream, s.get_config().m_drat_file.str(), mode);
+            unsigned buffer_size = s.get_config().m_drat_buffer_size;
+            if (buffer_size > 0)
+                m_out = alloc(drat_writer, s.get_config().m_drat_file.str().c_str(), mode,
+                              1024 * static_cast<size_t>(buffer_size), 1024 * static_cast<size_t>(s.get_config().m_drat_flush_size));
+            else
+                m_out = alloc(std::ofstream, s.get_config().m_drat_file.str(), mode);
             if (s.get_config().m_drat_binary) 
                 std::swap(m_out, m_bout);            
         }
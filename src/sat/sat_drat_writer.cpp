@@ -0,0 +1,136 @@
+/*++
+
+Module Name:
+
+    sat_drat_writer.cpp
+
+Abstract:
+   
+    Output stream for DRAT proofs written by a background thread.
+
+--*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "sat/sat_drat_writer.h"
+
+namespace sat {
+
+    drat_writer::ring_buf::ring_buf(char const* file, std::ios_base::openmode mode, size_t ring_size, size_t flush_size):
+        m_file(file, mode),
+        m_ring(new char[std::max<size_t>(ring_size, 2 * sizeof(m_local))]),
+        m_ring_size(std::max<size_t>(ring_size, 2 * sizeof(m_local))),
+        m_flush_size(std::min(std::max<size_t>(flush_size, 1), m_ring_size / 2)) {
+        setp(m_local, m_local + sizeof(m_local));
+#ifndef SINGLE_THREAD
+        m_thread = std::thread([this]() { run(); });
+#endif
+    }
+
+    drat_writer::ring_buf::~ring_buf() {
+        publish();
+        m_done.store(true, std::memory_order_release);
+#ifndef SINGLE_THREAD
+        m_thread.join();
+#endif
+        consume(true);
+        m_file.flush();
+    }
+
+    // move the put area to the ring, wait for the writer thread while the ring is full.
+    void drat_writer::ring_buf::publish() {
+        char const* src = pbase();
+        size_t n = pptr() - pbase();
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        while (n > 0) {
+            uint64_t tail = m_tail.load(std::memory_order_acquire);
+            size_t free = m_ring_size - static_cast<size_t>(head - tail);
+            if (free == 0) {
+#ifdef SINGLE_THREAD
+                consume(true);
+#else
+                std::this_thread::yield();
+#endif
+                continue;
+            }
+            size_t pos = static_cast<size_t>(head % m_ring_size);
+            size_t k = std::min({ n, free, m_ring_size - pos });
+            memcpy(m_ring.get() + pos, src, k);
+            src += k;
+            n -= k;
+            head += k;
+            m_head.store(head, std::memory_order_release);
+        }
+        setp(m_local, m_local + sizeof(m_local));
+    }
+
+    // write the available bytes to the file, if all is false only when there are at least m_flush_size of them.
+    void drat_writer::ring_buf::consume(bool all) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        if (head == tail || (!all && head - tail < m_flush_size))
+            return;
+        while (tail < head) {
+            size_t pos = static_cast<size_t>(tail % m_ring_size);
+            size_t k = std::min(static_cast<size_t>(head - tail), m_ring_size - pos);
+            m_file.write(m_ring.get() + pos, k);
+            tail += k;
+            m_tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    void drat_writer::ring_buf::run() {
+#ifndef SINGLE_THREAD
+        while (!m_done.load(std::memory_order_acquire)) {
+            uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            consume(false);
+            if (tail == m_tail.load(std::memory_order_relaxed))
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+#endif
+    }
+
+    drat_writer::ring_buf::int_type drat_writer::ring_buf::overflow(int_type ch) {
+        publish();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize drat_writer::ring_buf::xsputn(char const* s, std::streamsize n) {
+        std::streamsize written = 0;
+        while (written < n) {
+            if (pptr() == epptr())
+                publish();
+            std::streamsize k = std::min<std::streamsize>(n - written, epptr() - pptr());
+            memcpy(pptr(), s + written, static_cast<size_t>(k));
+            pbump(static_cast<int>(k));
+            written += k;
+        }
+        return n;
+    }
+
+    int drat_writer::ring_buf::sync() {
+        publish();
+#ifdef SINGLE_THREAD
+        consume(false);
+#endif
+        return 0;
+    }
+
+    drat_writer::drat_writer(char const* file, std::ios_base::openmode mode, size_t ring_size, size_t flush_size):
+        std::ostream(nullptr),
+        m_buf(file, mode, ring_size, flush_size) {
+        rdbuf(&m_buf);
+        if (!m_buf.is_open())
+            setstate(std::ios_base::failbit);
+    }
+
+    drat_writer::~drat_writer() {
+        rdbuf(nullptr);
+    }
+
+}
@@ -0,0 +1,71 @@
+/*++
+
+Module Name:
+
+    sat_drat_writer.h
+
+Abstract:
+   
+    Output stream for DRAT proofs written by a background thread.
+
+Notes:
+
+    The solver thread appends the proof steps to a lock-free ring buffer
+    (single producer, single consumer) and a writer thread copies them to
+    the file once at least flush_size bytes are available, so conflict
+    analysis does not wait for the file system. The producer only blocks
+    when the ring is full.
+
+--*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
+
+namespace sat {
+
+    class drat_writer : public std::ostream {
+
+        class ring_buf : public std::streambuf {
+            std::ofstream            m_file;
+            std::unique_ptr<char[]>  m_ring;
+            size_t                   m_ring_size;
+            size_t                   m_flush_size;
+            std::atomic<uint64_t>    m_head{ 0 }; // written by the producer
+            std::atomic<uint64_t>    m_tail{ 0 }; // written by the writer thread
+            std::atomic<bool>        m_done{ false };
+            char                     m_local[4096];  // put area of the producer
+#ifndef SINGLE_THREAD
+            std::thread              m_thread;
+#endif
+            void publish();
+            void consume(bool all);
+            void run();
+        protected:
+            int_type overflow(int_type ch) override;
+            std::streamsize xsputn(char const* s, std::streamsize n) override;
+            int sync() override;
+        public:
+            ring_buf(char const* file, std::ios_base::openmode mode, size_t ring_size, size_t flush_size);
+            ~ring_buf() override;
+            bool is_open() const { return m_file.is_open(); }
+        };
+
+        ring_buf m_buf;
+
+    public:
+        /**
+           \brief open file with a ring of ring_size bytes, chunks of at least flush_size bytes are written at once.
+        */
+        drat_writer(char const* file, std::ios_base::openmode mode, size_t ring_size, size_t flush_size);
+        ~drat_writer() override;
+    };
+
+}
@@ -22,69 +22,67 @@ Revision History:
 
 namespace sat {
 
-    void parallel::vector_pool::next(unsigned& index) {
-        SASSERT(index < m_size);
-        unsigned n = index + 2 + get_length(index);
-        index = (n >= m_size) ? 0 : n;
+    void parallel::clause_ring::reserve(unsigned sz) {
+        m_data = std::make_unique<std::atomic<unsigned>[]>(sz);
+        m_capacity = sz;
+        m_tail.store(0, std::memory_order_relaxed);
+        m_reserved.store(0, std::memory_order_relaxed);
     }
 
-    void parallel::vector_pool::reserve(unsigned num_threads, unsigned sz) {
-        m_vectors.reset();
-        m_vectors.resize(sz, 0);
-        m_heads.reset();
-        m_heads.resize(num_threads, 0);
-        m_at_end.reset();
-        m_at_end.resize(num_threads, true);
-        m_tail = 0;
-        m_size = sz;
+    void parallel::clause_ring::push(unsigned n, literal const* lits) {
+        SASSERT(n + 1 <= m_capacity);
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        uint64_t end = tail + n + 1;
+        // readers which see any of the new words also see the new reservation (ordered by the fences)
+        m_reserved.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_data[tail % m_capacity].store(n, std::memory_order_relaxed);
+        for (unsigned i = 0; i < n; ++i)
+            m_data[(tail + 1 + i) % m_capacity].store(lits[i].index(), std::memory_order_relaxed);
+        m_tail.store(end, std::memory_order_release);
     }
-    
-    void parallel::vector_pool::begin_add_vector(unsigned owner, unsigned n) {
-        SASSERT(m_tail < m_size);
-        unsigned capacity = n + 2;
-        m_vectors.reserve(m_size + capacity, 0);
-        IF_VERBOSE(3, verbose_stream() << owner << ": begin-add " << n << " tail: " << m_tail << " size: " << m_size << "\n";);
-        for (unsigned i = 0; i < m_heads.size(); ++i) {
-            while (m_tail < m_heads[i] && m_heads[i] < m_tail + capacity) {
-                next(m_heads[i]);
+
+    bool parallel::clause_ring::get(uint64_t& cursor, literal_vector& lits) const {
+        while (true) {
+            uint64_t tail = m_tail.load(std::memory_order_acquire);
+            if (cursor >= tail)
+                return false;
+            if (tail - cursor > m_capacity) {
+                // the records at cursor were overwritten
+                cursor = tail;
+                return false;
+            }
+            unsigned n = m_data[cursor % m_capacity].load(std::memory_order_relaxed);
+            bool valid = n > 0 && cursor + 1 + n <= tail;
+            lits.reset();
+            for (unsigned i = 0; valid && i < n; ++i)
+                lits.push_back(to_literal(m_data[(cursor + 1 + i) % m_capacity].load(std::memory_order_relaxed)));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (valid && m_reserved.load(std::memory_order_relaxed) - cursor <= m_capacity) {
+                cursor += n + 1;
+                return true;
             }
-            m_at_end[i] = false;
+            // the owner overwrote the record while it was copied
+            IF_VERBOSE(3, verbose_stream() << "(sat-parallel skip overwritten clauses)\n";);
+            cursor = m_tail.load(std::memory_order_acquire);
         }
-        m_vectors[m_tail++] = owner;
-        m_vectors[m_tail++] = n;    
     }
 
-    void parallel::vector_pool::add_vector_elem(unsigned e) {
-        m_vectors[m_tail++] = e;
-    }
-
-    void parallel::vector_pool::end_add_vector() {
-        if (m_tail >= m_size) 
-            m_tail = 0;
-    }
-
-
-    bool parallel::vector_pool::get_vector(unsigned owner, unsigned& n, unsigned const*& ptr) {
-        unsigned head = m_heads[owner];      
-        unsigned iterations = 0;
-        while (head != m_tail || !m_at_end[owner]) {
-            ++iterations;
-            SASSERT(head < m_size && m_tail < m_size);            
-            bool is_self = owner == get_owner(head);
-            next(m_heads[owner]);
-            IF_VERBOSE(static_cast<unsigned>(iterations > m_size ? 0 : 3), verbose_stream() << owner << ": [" << head << ":" << m_heads[owner] << "] tail: " << m_tail << "\n";);
-            m_at_end[owner] = (m_heads[owner] == m_tail);
-            if (!is_self) {
-                n = get_length(head);
-                ptr = get_ptr(head);
-                return true;
-            }
-            head = m_heads[owner];
+    void parallel::reserve(unsigned num_owners, unsigned sz) {
+        m_rings.reset();
+        for (unsigned i = 0; i < num_owners; ++i) {
+            m_rings.push_back(alloc(clause_ring));
+            m_rings.back()->reserve(sz);
         }
-        return false;
+        m_cursors.reset();
+        m_cursors.resize(num_owners * num_owners, 0);
     }
 
-    parallel::parallel(solver& s): m_num_clauses(0), m_consumer_ready(false), m_scoped_rlimit(s.rlimit()) {}
+    parallel::parallel(solver& s): 
+        m_share_max_size(s.get_config().m_par_share_max_size),
+        m_share_max_glue(s.get_config().m_par_share_max_glue),
+        m_share_core_glue(s.get_config().m_par_share_core_glue),
+        m_num_clauses(0), m_consumer_ready(false), m_scoped_rlimit(s.rlimit()) {}
 
     parallel::~parallel() {
         m_limits.reset();
@@ -97,6 +95,15 @@ namespace sat {
         m_solvers.init(num_extra_solvers);
         m_limits.init(num_extra_solvers);
         symbol saved_phase = s.m_params.get_sym("phase", symbol("caching"));
+
+        m_max_units = 2 * s.num_vars();
+        m_units = std::make_unique<std::atomic<unsigned>[]>(m_max_units);
+        m_unit_set = std::make_unique<std::atomic<bool>[]>(m_max_units);
+        for (unsigned i = 0; i < m_max_units; ++i) {
+            m_units[i].store(null_literal.index(), std::memory_order_relaxed);
+            m_unit_set[i].store(false, std::memory_order_relaxed);
+        }
+        m_num_units.store(0, std::memory_order_relaxed);
         
         for (unsigned i = 0; i < num_extra_solvers; ++i) {
             s.m_params.set_uint("random_seed", s.m_rand());
@@ -119,20 +126,20 @@ namespace sat {
     void parallel::exchange(solver& s, literal_vector const& in, unsigned& limit, literal_vector& out) {
         if (s.get_config().m_num_threads == 1 || s.m_par_syncing_clauses) return;
         flet<bool> _disable_sync_clause(s.m_par_syncing_clauses, true);
-        {
-            lock_guard lock(m_mux);
-            if (limit < m_units.size()) {
-                // this might repeat some literals.
-                out.append(m_units.size() - limit, m_units.data() + limit);
-            }
-            for (unsigned i = 0; i < in.size(); ++i) {
-                literal lit = in[i];
-                if (!m_unit_set.contains(lit.index())) {
-                    m_unit_set.insert(lit.index());
-                    m_units.push_back(lit);
-                }
-            }
-            limit = m_units.size();
+        // this might repeat some literals, including the ones added by s.
+        unsigned num_units = std::min(m_num_units.load(std::memory_order_acquire), m_max_units);
+        for (; limit < num_units; ++limit) {
+            unsigned idx = m_units[limit].load(std::memory_order_acquire);
+            if (idx == null_literal.index())
+                break;
+            out.push_back(to_literal(idx));
+        }
+        for (literal lit : in) {
+            if (lit.index() >= m_max_units || m_unit_set[lit.index()].exchange(true, std::memory_order_acq_rel))
+                continue;
+            unsigned slot = m_num_units.fetch_add(1, std::memory_order_relaxed);
+            SASSERT(slot < m_max_units);
+            m_units[slot].store(lit.index(), std::memory_order_release);
         }
     }
 
@@ -140,58 +147,49 @@ namespace sat {
         if (s.get_config().m_num_threads == 1 || s.m_par_syncing_clauses) return;
         flet<bool> _disable_sync_clause(s.m_par_syncing_clauses, true);
         IF_VERBOSE(3, verbose_stream() << s.m_par_id << ": share " <<  l1 << " " << l2 << "\n";);
-        {
-            lock_guard lock(m_mux);
-            m_pool.begin_add_vector(s.m_par_id, 2);
-            m_pool.add_vector_elem(l1.index());
-            m_pool.add_vector_elem(l2.index());            
-            m_pool.end_add_vector();
-        }        
+        literal lits[2] = { l1, l2 };
+        m_rings[s.m_par_id]->push(2, lits);
     }
 
     void parallel::share_clause(solver& s, clause const& c) {        
         if (s.get_config().m_num_threads == 1 || !enable_add(c) || s.m_par_syncing_clauses) return;
+        clause_ring& ring = *m_rings[s.m_par_id];
+        if (c.size() + 1 > ring.capacity()) return;
         flet<bool> _disable_sync_clause(s.m_par_syncing_clauses, true);
-        unsigned n = c.size();
-        unsigned owner = s.m_par_id;
-        IF_VERBOSE(3, verbose_stream() << owner << ": share " <<  c << "\n";);
-        lock_guard lock(m_mux);
-        m_pool.begin_add_vector(owner, n);                
-        for (unsigned i = 0; i < n; ++i) 
-            m_pool.add_vector_elem(c[i].index());
-        m_pool.end_add_vector();        
+        IF_VERBOSE(3, verbose_stream() << s.m_par_id << ": share " <<  c << "\n";);
+        ring.push(c.size(), c.begin());
     }
 
     void parallel::get_clauses(solver& s) {
         if (s.m_par_syncing_clauses) return;
         flet<bool> _disable_sync_clause(s.m_par_syncing_clauses, true);
-        lock_guard lock(m_mux);
         _get_clauses(s);        
     }
 
     void parallel::_get_clauses(solver& s) {
-        unsigned n;
-        unsigned const* ptr;
-        unsigned owner = s.m_par_id;
-        while (m_pool.get_vector(owner, n, ptr)) {
-            m_lits.reset();
-            bool usable_clause = true;
-            for (unsigned i = 0; usable_clause && i < n; ++i) {
-                literal lit(to_literal(ptr[i]));                
-                m_lits.push_back(lit);
-                usable_clause = lit.var() <= s.m_par_num_vars && !s.was_eliminated(lit.var());
-            }
-            IF_VERBOSE(3, verbose_stream() << s.m_par_id << ": retrieve " << m_lits << "\n";);
-            SASSERT(n >= 2);
-            if (usable_clause) {
-                s.mk_clause_core(m_lits.size(), m_lits.data(), sat::status::redundant());
+        unsigned consumer = s.m_par_id;
+        unsigned num_owners = m_rings.size();
+        literal_vector lits;
+        for (unsigned owner = 0; owner < num_owners; ++owner) {
+            if (owner == consumer)
+                continue;
+            uint64_t& cursor = m_cursors[consumer * num_owners + owner];
+            while (m_rings[owner]->get(cursor, lits)) {
+                bool usable_clause = true;
+                for (unsigned i = 0; usable_clause && i < lits.size(); ++i) 
+                    usable_clause = lits[i].var() < s.m_par_num_vars && !s.was_eliminated(lits[i].var());
+                IF_VERBOSE(3, verbose_stream() << s.m_par_id << ": retrieve " << lits << "\n";);
+                SASSERT(lits.size() >= 2);
+                if (usable_clause) {
+                    s.mk_clause_core(lits.size(), lits.data(), sat::status::redundant());
+                }
             }
-        }        
+        }
     }
 
     bool parallel::enable_add(clause const& c) const {
-        // plingeling, glucose heuristic:
-        return (c.size() <= 40 && c.glue() <= 8) || c.glue() <= 2;
+        // plingeling, glucose heuristic: short clauses of small glue and clauses of any size with a core glue.
+        return (c.size() <= m_share_max_size && c.glue() <= m_share_max_glue) || c.glue() <= m_share_core_glue;
     }
 
     void parallel::_from_solver(solver& s) {
@@ -207,15 +205,15 @@ namespace sat {
 
 
     void parallel::_to_solver(solver& s) {
-        return;
-#if 0
-        if (m_priorities.empty())
+        unsigned id = s.m_par_id;
+        m_ls_phase_seen.reserve(id + 1, 0);
+        if (m_ls_phase_seen[id] == m_ls_phase_gen)
             return;
-        
-        for (bool_var v = 0; v < m_priorities.size(); ++v) 
-            s.update_activity(v, m_priorities[v]);
-        s.m_activity_inc = 128;
-#endif
+        m_ls_phase_seen[id] = m_ls_phase_gen;
+        unsigned n = std::min(s.num_vars(), m_ls_phase.size());
+        IF_VERBOSE(2, verbose_stream() << "(sat-parallel phase :unsat " << m_ls_phase_unsat << ")\n";);
+        for (bool_var v = 0; v < n; ++v)
+            s.set_phase(literal(v, !m_ls_phase[v]));
     }
 
     void parallel::from_solver(solver& s) {
@@ -229,13 +227,15 @@ namespace sat {
     }
 
     void parallel::_to_solver(i_local_search& s) {        
-        return;
-#if 0
-        m_priorities.reset();
-        for (bool_var v = 0; m_solver_copy && v < m_solver_copy->num_vars(); ++v) {
-            m_priorities.push_back(s.get_priority(v));
-        }
-#endif
+        unsigned unsat = s.get_model_unsat();
+        if (unsat >= m_ls_phase_unsat)
+            return;
+        model const& mdl = s.get_model();
+        m_ls_phase.reset();
+        for (lbool val : mdl)
+            m_ls_phase.push_back(val == l_true);
+        m_ls_phase_unsat = unsat;
+        ++m_ls_phase_gen;
     }
 
     bool parallel::_from_solver(i_local_search& s) {
@@ -245,6 +245,9 @@ namespace sat {
             copied = true;
             s.reinit(*m_solver_copy.get(), m_solver_copy->m_best_phase);
         }
+        else if (m_ls_phase_unsat < s.get_model_unsat()) {
+            s.import_phase(m_ls_phase);
+        }
         return copied;
     }
 
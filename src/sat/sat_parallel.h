@@ -24,28 +24,30 @@ Revision History:
 #include "util/rlimit.h"
 #include "util/scoped_ptr_vector.h"
 #include "util/mutex.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
 namespace sat {
 
     class parallel {
 
-        // shared pool of learned clauses.
-        class vector_pool {
-            unsigned_vector m_vectors;
-            unsigned        m_size{ 0 };
-            unsigned        m_tail{ 0 };
-            unsigned_vector m_heads;
-            bool_vector   m_at_end;
-            void next(unsigned& index);
-            unsigned get_owner(unsigned index) const { return m_vectors[index]; }
-            unsigned get_length(unsigned index) const { return m_vectors[index+1]; }
-            unsigned const* get_ptr(unsigned index) const { return m_vectors.data() + index + 2; }
+        // learned clauses shared by one solver.
+        // The owner appends records (length, literals) without locking and every other solver reads them
+        // with its own cursor. Positions only grow, a record is stored at its position modulo the capacity,
+        // and a reader whose records were overwritten in the meantime skips to the newest record.
+        class clause_ring {
+            std::unique_ptr<std::atomic<unsigned>[]> m_data;
+            unsigned              m_capacity{ 0 };
+            std::atomic<uint64_t> m_tail{ 0 };     // end of the published records
+            std::atomic<uint64_t> m_reserved{ 0 }; // end of the record being written
         public:
-            void reserve(unsigned num_owners, unsigned sz);
-            void begin_add_vector(unsigned owner, unsigned n);
-            void end_add_vector();
-            void add_vector_elem(unsigned e);
-            bool get_vector(unsigned owner, unsigned& n, unsigned const*& ptr);
+            void reserve(unsigned sz);
+            unsigned capacity() const { return m_capacity; }
+            // called by the owner only
+            void push(unsigned n, literal const* lits);
+            // read the record at cursor into lits and advance cursor, false if there is no more record.
+            bool get(uint64_t& cursor, literal_vector& lits) const;
         };
 
         bool enable_add(clause const& c) const;
@@ -55,12 +57,23 @@ namespace sat {
         bool _from_solver(i_local_search& s);
         void _to_solver(i_local_search& s);
 
-        typedef hashtable<unsigned, u_hash, u_eq> index_set;
-        literal_vector m_units;
-        index_set      m_unit_set;
-        literal_vector m_lits;
-        vector_pool    m_pool;
-        mutex          m_mux;
+        // units shared by all solvers, each literal is appended at most once.
+        // Free slots hold null_literal, readers stop at the first slot which is not filled yet.
+        std::unique_ptr<std::atomic<unsigned>[]> m_units;
+        std::unique_ptr<std::atomic<bool>[]>     m_unit_set;
+        unsigned              m_max_units{ 0 };
+        std::atomic<unsigned> m_num_units{ 0 };
+
+        scoped_ptr_vector<clause_ring> m_rings;
+        // m_cursors[consumer * m_rings.size() + owner] is the read position of consumer in the ring of owner.
+        svector<uint64_t> m_cursors;
+        // guards the exchange with local search
+        mutex             m_mux;
+
+        // filter of shared learned clauses
+        unsigned m_share_max_size;
+        unsigned m_share_max_glue;
+        unsigned m_share_core_glue;
 
         // for exchange with local search:
         unsigned           m_num_clauses;
@@ -68,6 +81,13 @@ namespace sat {
         bool               m_consumer_ready;
         svector<double>    m_priorities;
 
+        // best assignment of the local search workers.
+        // It is imported by the workers with a worse assignment and used as phase hint by the CDCL solvers.
+        bool_vector        m_ls_phase;
+        unsigned           m_ls_phase_unsat{ UINT_MAX };
+        unsigned           m_ls_phase_gen{ 0 };
+        unsigned_vector    m_ls_phase_seen; // generation of m_ls_phase imported by each solver
+
         scoped_limits      m_scoped_rlimit;
         vector<reslimit>   m_limits;
         ptr_vector<solver> m_solvers;
@@ -82,8 +102,8 @@ namespace sat {
 
         void push_child(reslimit& rl);
 
-        // reserve space
-        void reserve(unsigned num_owners, unsigned sz) { m_pool.reserve(num_owners, sz); }
+        // reserve space: a ring of sz literals for each owner
+        void reserve(unsigned num_owners, unsigned sz);
 
         solver& get_solver(unsigned i) { return *m_solvers[i]; }
 
@@ -25,6 +25,9 @@ Revision History:
 #include "sat/sat_integrity_checker.h"
 #include "util/stopwatch.h"
 #include "util/trace.h"
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
 
 namespace sat {
 
@@ -1810,6 +1813,14 @@ namespace sat {
         CTRACE("resolve_bug", !c1.contains(l) || !c2.contains(~l), tout << c1 << "\n" << c2 << "\nl: " << l << "\n";);
         if (m_visited.size() <= 2*s.num_vars())
             m_visited.resize(2*s.num_vars(), false);
+        return resolve_core(c1, c2, l, r, m_visited, m_elim_counter);
+    }
+
+    /**
+       \brief resolve using the marks visited and the work counter counter,
+       it only reads the clauses so it can be used by several threads with their own marks and counters.
+    */
+    bool simplifier::resolve_core(clause_wrapper const & c1, clause_wrapper const & c2, literal l, literal_vector & r, svector<char>& visited, int& counter) {
         if (c1.was_removed() && !c1.contains(l))
             return false;
         if (c2.was_removed() && !c2.contains(~l))
@@ -1817,13 +1828,13 @@ namespace sat {
         SASSERT(c1.contains(l));
         SASSERT(c2.contains(~l));
         bool res = true;
-        m_elim_counter -= c1.size() + c2.size();
+        counter -= c1.size() + c2.size();
         unsigned sz1 = c1.size();
         for (unsigned i = 0; i < sz1; ++i) {
             literal l1 = c1[i];
             if (l == l1)
                 continue;
-            m_visited[l1.index()] = true;
+            visited[l1.index()] = true;
             r.push_back(l1);
         }
 
@@ -1833,25 +1844,43 @@ namespace sat {
             literal l2 = c2[i];
             if (not_l == l2)
                 continue;
-            if ((~l2).index() >= m_visited.size()) {
-                //s.display(std::cout << l2 << " " << s.num_vars() << " " << m_visited.size() << "\n");
+            if ((~l2).index() >= visited.size()) {
                 UNREACHABLE();
             }
-            if (m_visited[(~l2).index()]) {
+            if (visited[(~l2).index()]) {
                 res = false;
                 break;
             }
-            if (!m_visited[l2.index()])
+            if (!visited[l2.index()])
                 r.push_back(l2);
         }
 
         for (unsigned i = 0; i < sz1; ++i) {
             literal l1 = c1[i];
-            m_visited[l1.index()] = false;
+            visited[l1.index()] = false;
         }
         return res;
     }
 
+    /**
+       \brief check that there are at most before_clauses non-tautological resolvents of pos and neg on pos_l.
+    */
+    bool simplifier::within_resolvent_bound(clause_wrapper_vector const& pos, clause_wrapper_vector const& neg, literal pos_l, unsigned before_clauses, 
+                                            svector<char>& visited, literal_vector& tmp, int& counter) {
+        unsigned after_clauses = 0;
+        for (clause_wrapper const& c1 : pos) {
+            for (clause_wrapper const& c2 : neg) {
+                tmp.reset();
+                if (resolve_core(c1, c2, pos_l, tmp, visited, counter)) {
+                    after_clauses++;
+                    if (after_clauses > before_clauses) 
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
     void simplifier::save_clauses(model_converter::entry & mc_entry, clause_wrapper_vector const & cs) {
         for (auto & e : cs) {
             s.m_mc.insert(mc_entry, e);
@@ -1913,25 +1942,25 @@ namespace sat {
         }
     }
 
-    bool simplifier::try_eliminate(bool_var v) {
-        if (value(v) != l_undef)
-            return false;
-
+    /**
+       \brief check the cutoffs on the occurrences of v for elimination by resolution.
+    */
+    bool simplifier::elim_cutoffs(bool_var v, unsigned& num_pos, unsigned& num_neg, unsigned& before_lits) {
         literal pos_l(v, false);
         literal neg_l(v, true);
         unsigned num_bin_pos = num_nonlearned_bin(pos_l);
         unsigned num_bin_neg = num_nonlearned_bin(neg_l);
         clause_use_list & pos_occs = m_use_list.get(pos_l);
         clause_use_list & neg_occs = m_use_list.get(neg_l);
-        unsigned num_pos = pos_occs.num_irredundant() + num_bin_pos;
-        unsigned num_neg = neg_occs.num_irredundant() + num_bin_neg;
+        num_pos = pos_occs.num_irredundant() + num_bin_pos;
+        num_neg = neg_occs.num_irredundant() + num_bin_neg;
 
         TRACE("sat_simplifier", tout << v << " num_pos: " << num_pos << " neg_pos: " << num_neg << "\n";);
 
         if (num_pos >= m_res_occ_cutoff && num_neg >= m_res_occ_cutoff)
             return false;
 
-        unsigned before_lits = num_bin_pos*2 + num_bin_neg*2;
+        before_lits = num_bin_pos*2 + num_bin_neg*2;
 
         for (auto it = pos_occs.mk_iterator(); !it.at_end(); it.next()) {
             if (!it.curr().is_learned())
@@ -1953,6 +1982,22 @@ namespace sat {
         if (num_pos >= m_res_occ_cutoff1 && num_neg >= m_res_occ_cutoff1 && before_lits > m_res_lit_cutoff1 &&
             s.m_clauses.size() <= m_res_cls_cutoff1)
             return false;
+        return true;
+    }
+
+    /**
+       \brief eliminate v by resolution, 
+       bound_checked is set if the number of resolvents was already checked (see elim_vars_par).
+    */
+    bool simplifier::try_eliminate(bool_var v, bool bound_checked) {
+        if (value(v) != l_undef)
+            return false;
+
+        literal pos_l(v, false);
+        literal neg_l(v, true);
+        unsigned num_pos, num_neg, before_lits;
+        if (!elim_cutoffs(v, num_pos, num_neg, before_lits))
+            return false;
 
         m_pos_cls.reset();
         m_neg_cls.reset();
@@ -1961,22 +2006,15 @@ namespace sat {
 
         TRACE("sat_simplifier", tout << "collecting number of after_clauses\n";);
         unsigned before_clauses = num_pos + num_neg;
-        unsigned after_clauses  = 0;
-        for (clause_wrapper& c1 : m_pos_cls) {
-            for (clause_wrapper& c2 : m_neg_cls) {
-                m_new_cls.reset();
-                if (resolve(c1, c2, pos_l, m_new_cls)) {
-                    TRACE("sat_simplifier", tout << c1 << "\n" << c2 << "\n-->\n";
-                          for (literal l : m_new_cls) tout << l << " "; tout << "\n";);
-                    after_clauses++;
-                    if (after_clauses > before_clauses) {
-                        TRACE("sat_simplifier", tout << "too many after clauses: " << after_clauses << "\n";);
-                        return false;
-                    }
-                }
+        if (!bound_checked) {
+            if (m_visited.size() <= 2*s.num_vars())
+                m_visited.resize(2*s.num_vars(), false);
+            if (!within_resolvent_bound(m_pos_cls, m_neg_cls, pos_l, before_clauses, m_visited, m_new_cls, m_elim_counter)) {
+                TRACE("sat_simplifier", tout << "too many after clauses\n";);
+                return false;
             }
         }
-        TRACE("sat_simplifier", tout << "eliminate " << v << ", before: " << before_clauses << " after: " << after_clauses << "\n";
+        TRACE("sat_simplifier", tout << "eliminate " << v << ", before: " << before_clauses << "\n";
               tout << "pos\n";
               for (auto & c : m_pos_cls) 
                   tout << c << "\n";
@@ -2075,12 +2113,127 @@ namespace sat {
         }
     };
 
+    struct simplifier::elim_candidate {
+        bool_var              m_var;
+        unsigned              m_before_clauses;
+        clause_wrapper_vector m_pos, m_neg;
+        bool                  m_bounded = false;
+        elim_candidate(bool_var v, unsigned before): m_var(v), m_before_clauses(before) {}
+    };
+
+    /**
+       \brief variable elimination where the number of resolvents is checked by several threads.
+       
+       Candidates are taken in the order of vars and grouped into batches of variables that do not occur in 
+       the clauses of each other (so eliminating one of them does not change the clauses of the others).
+       The bound on the resolvents, which is the costly part, is checked for the candidates of a batch 
+       concurrently, the clauses are only read. The candidates within the bound are then eliminated 
+       sequentially in the order of vars, so the result does not depend on the scheduling of the threads
+       and the model converter records the eliminations as in the sequential mode.
+    */
+    void simplifier::elim_vars_par(bool_var_vector const& vars, sat::elim_vars& elim_bdd) {
+        unsigned num_threads = m_elim_vars_threads;
+        unsigned batch_size = 256 * num_threads;
+        bool_var_vector todo(vars), deferred;
+        bool_vector marked;
+        scoped_ptr_vector<elim_candidate> batch;
+        unsigned head = 0;
+        while (head < todo.size() || !deferred.empty()) {
+            checkpoint();
+            if (m_elim_counter < 0 || s.inconsistent())
+                break;
+            // deferred candidates keep their order before the ones which were not scanned yet
+            if (!deferred.empty()) {
+                bool_var_vector rest;
+                rest.append(deferred);
+                for (unsigned i = head; i < todo.size(); ++i)
+                    rest.push_back(todo[i]);
+                todo.swap(rest);
+                deferred.reset();
+                head = 0;
+            }
+            marked.reset();
+            marked.resize(s.num_vars(), false);
+            batch.reset();
+            for (; head < todo.size() && batch.size() < batch_size; ++head) {
+                bool_var v = todo[head];
+                unsigned num_pos, num_neg, before_lits;
+                if (is_external(v) || was_eliminated(v) || value(v) != l_undef || !elim_cutoffs(v, num_pos, num_neg, before_lits))
+                    continue;
+                if (marked[v]) {
+                    deferred.push_back(v);
+                    continue;
+                }
+                elim_candidate* c = alloc(elim_candidate, v, num_pos + num_neg);
+                collect_clauses(literal(v, false), c->m_pos);
+                collect_clauses(literal(v, true), c->m_neg);
+                bool independent = true;
+                for (clause_wrapper_vector const* cs : { &c->m_pos, &c->m_neg })
+                    for (clause_wrapper const& cw : *cs)
+                        for (unsigned i = 0; independent && i < cw.size(); ++i)
+                            independent = cw[i].var() == v || !marked[cw[i].var()];
+                if (!independent) {
+                    dealloc(c);
+                    deferred.push_back(v);
+                    continue;
+                }
+                marked[v] = true;
+                for (clause_wrapper_vector const* cs : { &c->m_pos, &c->m_neg })
+                    for (clause_wrapper const& cw : *cs)
+                        for (unsigned i = 0; i < cw.size(); ++i)
+                            marked[cw[i].var()] = true;
+                m_elim_counter -= num_pos * num_neg + before_lits;
+                batch.push_back(c);
+            }
+            if (batch.empty())
+                continue;
+
+            unsigned num_vars = s.num_vars();
+            svector<int> counters(num_threads, 0);
+            auto check_bounds = [&](unsigned id) {
+                svector<char> visited(2 * num_vars, false);
+                literal_vector tmp;
+                for (unsigned i = id; i < batch.size(); i += num_threads) {
+                    elim_candidate& c = *batch[i];
+                    c.m_bounded = within_resolvent_bound(c.m_pos, c.m_neg, literal(c.m_var, false), c.m_before_clauses, visited, tmp, counters[id]);
+                }
+            };
+#ifndef SINGLE_THREAD
+            vector<std::thread> threads;
+            for (unsigned id = 1; id < num_threads; ++id)
+                threads.push_back(std::thread([&, id]() { check_bounds(id); }));
+            check_bounds(0);
+            for (auto& t : threads)
+                t.join();
+#else
+            for (unsigned id = 0; id < num_threads; ++id)
+                check_bounds(id);
+#endif
+            for (int c : counters)
+                m_elim_counter += c;
+
+            for (elim_candidate* c : batch) {
+                checkpoint();
+                if (s.inconsistent())
+                    break;
+                if (c->m_bounded && try_eliminate(c->m_var, true))
+                    m_num_elim_vars++;
+                else if (!c->m_bounded && elim_vars_bdd_enabled() && elim_bdd(c->m_var))
+                    m_num_elim_vars++;
+            }
+        }
+    }
+
     void simplifier::elim_vars() {
         if (!elim_vars_enabled()) return;
         elim_var_report rpt(*this);
         bool_var_vector vars;
         order_vars_for_elim(vars);
         sat::elim_vars elim_bdd(*this);
+        if (m_elim_vars_threads > 1) {
+            elim_vars_par(vars, elim_bdd);
+            vars.reset();
+        }
         for (bool_var v : vars) {
             checkpoint();
             if (m_elim_counter < 0) 
@@ -2128,6 +2281,7 @@ namespace sat {
         m_elim_vars               = p.elim_vars();
         m_elim_vars_bdd           = false && p.elim_vars_bdd(); // buggy?
         m_elim_vars_bdd_delay     = p.elim_vars_bdd_delay();
+        m_elim_vars_threads       = std::max(1u, p.elim_vars_threads());
         m_incremental_mode        = s.get_config().m_incremental && !p.override_incremental();
     }
 
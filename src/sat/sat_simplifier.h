@@ -37,6 +37,7 @@ namespace pb {
 
 namespace sat {
     class solver;
+    class elim_vars;
 
     class use_list {
         vector<clause_use_list> m_use_list;
@@ -105,6 +106,7 @@ namespace sat {
         bool                   m_elim_vars;
         bool                   m_elim_vars_bdd;
         unsigned               m_elim_vars_bdd_delay;
+        unsigned               m_elim_vars_threads;
 
         // stats
         unsigned               m_num_bce;
@@ -199,12 +201,18 @@ namespace sat {
         clause_wrapper_vector m_neg_cls;
         literal_vector m_new_cls;
         bool resolve(clause_wrapper const & c1, clause_wrapper const & c2, literal l, literal_vector & r);
+        static bool resolve_core(clause_wrapper const & c1, clause_wrapper const & c2, literal l, literal_vector & r, svector<char>& visited, int& counter);
+        static bool within_resolvent_bound(clause_wrapper_vector const& pos, clause_wrapper_vector const& neg, literal pos_l, unsigned before_clauses, 
+                                           svector<char>& visited, literal_vector& tmp, int& counter);
         void save_clauses(model_converter::entry & mc_entry, clause_wrapper_vector const & cs);
         void add_non_learned_binary_clause(literal l1, literal l2);
         void remove_bin_clauses(literal l);
         void remove_clauses(clause_use_list const & cs, literal l);
-        bool try_eliminate(bool_var v);
+        bool elim_cutoffs(bool_var v, unsigned& num_pos, unsigned& num_neg, unsigned& before_lits);
+        bool try_eliminate(bool_var v, bool bound_checked = false);
         void elim_vars();
+        struct elim_candidate;
+        void elim_vars_par(bool_var_vector const& vars, class elim_vars& elim_bdd);
 
         struct blocked_cls_report;
         struct subsumption_report;
@@ -241,6 +249,7 @@ namespace sat {
 
         void collect_statistics(statistics & st) const;
         void reset_statistics();
+        unsigned num_elim_lits() const { return m_num_elim_lits; }
 
         void propagate_unit(literal l);
         void subsume();
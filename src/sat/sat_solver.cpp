@@ -33,6 +33,8 @@ Revision History:
 #include "sat/sat_prob.h"
 #include "sat/sat_anf_simplifier.h"
 #include "sat/sat_cut_simplifier.h"
+#include "sat/sat_cube_conquer.h"
+#include "sat/sat_params.hpp"
 #if defined(_MSC_VER) && !defined(_M_ARM) && !defined(_M_ARM64)
 # include <xmmintrin.h>
 #endif
@@ -657,7 +659,7 @@ namespace sat {
 
     bool solver::should_defrag() {
         if (m_defrag_threshold > 0) --m_defrag_threshold;
-        return m_defrag_threshold == 0 && m_config.m_gc_defrag;
+        return m_config.m_gc_defrag && (m_defrag_threshold == 0 || cls_allocator().is_fragmented());
     }
 
     void solver::defrag_clauses() {
@@ -1248,6 +1250,11 @@ namespace sat {
             SASSERT(scope_lvl() == 0);
             return check_par(num_lits, lits);
         }
+        if ((m_config.m_cc || m_config.m_cc_worker) && num_lits == 0 && !m_par && !m_ext) {
+            m_cleaner(true);
+            cube_conquer cc(*this);
+            return m_config.m_cc_worker ? cc.work() : cc();
+        }
         flet<bool> _searching(m_searching, true);
         m_clone = nullptr;
         if (m_mc.empty() && gparams::get_ref().get_bool("model_validate", false)) {
@@ -1481,7 +1488,14 @@ namespace sat {
         // set up ddfw search
         for (int i = 0; i < num_ddfw; ++i) {
             ddfw* d = alloc(ddfw);
-            d->updt_params(m_params);
+            // diversify the weight transfer of the workers, they exchange their best assignments through par.
+            params_ref p(m_params);
+            if (i > 0) {
+                sat_params sp(m_params);
+                p.set_uint("ddfw.init_clause_weight", sp.ddfw_init_clause_weight() + 2 * (i % 4));
+                p.set_uint("ddfw.use_reward_pct", (sp.ddfw_use_reward_pct() + 5 * i) % 50);
+            }
+            d->updt_params(p);
             d->set_seed(m_config.m_random_seed + i);
             d->add(*this);
             ls.push_back(d);
@@ -2006,6 +2020,69 @@ namespace sat {
     bool solver::should_simplify() const {
         return m_conflicts_since_init >= m_next_simplify && m_simplify_enabled;
     }
+    /**
+       \brief run the inprocessing technique f unless it is skipped by the adaptive schedule,
+       and account for the clauses and literals it removed and the units it found.
+    */
+    template<typename F>
+    void solver::inprocess(inprocess_kind k, F const& f) {
+        inprocess_info& info = m_inprocess[k];
+        if (inconsistent())
+            return;
+        if (m_config.m_inprocess_adaptive && info.m_delay > 0) {
+            --info.m_delay;
+            ++info.m_skipped;
+            return;
+        }
+        unsigned units = init_trail_size();
+        unsigned clauses = num_clauses() - units;
+        uint64_t literals = num_inprocess_elim_literals();
+        stopwatch sw;
+        sw.start();
+        f();
+        sw.stop();
+        unsigned new_units = init_trail_size();
+        unsigned new_clauses = num_clauses() - new_units;
+        // strengthening removes literals without removing clauses
+        uint64_t removed_literals = num_inprocess_elim_literals() - literals;
+        uint64_t removed = (clauses > new_clauses ? clauses - new_clauses : 0) + (new_units > units ? new_units - units : 0) + removed_literals;
+        ++info.m_runs;
+        info.m_removed += removed;
+        info.m_removed_literals += removed_literals;
+        info.m_time += sw.get_seconds();
+        if (removed == 0 && !inconsistent()) {
+            info.m_delay = info.m_backoff;
+            info.m_backoff = std::min(2 * info.m_backoff + 1, m_config.m_inprocess_max_backoff);
+        }
+        else {
+            info.m_backoff /= 2;
+        }
+    }
+
+    /**
+       \brief number of literals removed from clauses by the inprocessing techniques that strengthen clauses.
+    */
+    uint64_t solver::num_inprocess_elim_literals() const {
+        return static_cast<uint64_t>(m_asymm_branch.num_elim_literals()) + m_simplifier.num_elim_lits();
+    }
+
+    void solver::collect_inprocess_statistics(statistics& st) const {
+        static char const* names[IP_NUM] = { "scc", "simplifier", "probing", "asymm-branch", "lookahead", "binspr", "anf", "cuts" };
+        for (unsigned k = 0; k < IP_NUM; ++k) {
+            inprocess_info const& info = m_inprocess[k];
+            if (info.m_runs == 0 && info.m_skipped == 0)
+                continue;
+            std::string prefix = std::string("sat inprocess ") + names[k];
+            st.update((prefix + " runs").c_str(), info.m_runs);
+            st.update((prefix + " skipped").c_str(), info.m_skipped);
+            st.update((prefix + " removed").c_str(), static_cast<double>(info.m_removed));
+            st.update((prefix + " removed literals").c_str(), static_cast<double>(info.m_removed_literals));
+            // removed clauses, units and literals per second
+            if (info.m_time > 0)
+                st.update((prefix + " efficiency").c_str(), info.m_removed / info.m_time);
+        }
+    }
+
     /**
        \brief Apply all simplifications.
     */
@@ -2038,22 +2115,24 @@ namespace sat {
         m_cleaner(m_config.m_force_cleanup);
         CASSERT("sat_simplify_bug", check_invariant());
 
-        m_scc();
+        inprocess(IP_SCC, [&]() { m_scc(); });
         CASSERT("sat_simplify_bug", check_invariant());
 
         if (m_ext) {
             m_ext->pre_simplify();
         }
       
-        m_simplifier(false);
+        inprocess(IP_SIMPLIFIER, [&]() {
+            m_simplifier(false);
 
-        CASSERT("sat_simplify_bug", check_invariant());
-        CASSERT("sat_missed_prop", check_missed_propagation());
-        if (!m_learned.empty()) {
-            m_simplifier(true);
-            CASSERT("sat_missed_prop", check_missed_propagation());
             CASSERT("sat_simplify_bug", check_invariant());
-        }
+            CASSERT("sat_missed_prop", check_missed_propagation());
+            if (!m_learned.empty()) {
+                m_simplifier(true);
+                CASSERT("sat_missed_prop", check_missed_propagation());
+                CASSERT("sat_simplify_bug", check_invariant());
+            }
+        });
         sort_watch_lits();
         CASSERT("sat_simplify_bug", check_invariant());
 
@@ -2064,15 +2143,17 @@ namespace sat {
             m_ext->simplify();
         }
 
-        m_probing();
+        inprocess(IP_PROBING, [&]() { m_probing(); });
         CASSERT("sat_missed_prop", check_missed_propagation());
         CASSERT("sat_simplify_bug", check_invariant());
-        m_asymm_branch(false);
+        inprocess(IP_ASYMM_BRANCH, [&]() { m_asymm_branch(false); });
 
         if (m_config.m_lookahead_simplify && !m_ext) {
-            lookahead lh(*this);
-            lh.simplify(true);
-            lh.collect_statistics(m_aux_stats);
+            inprocess(IP_LOOKAHEAD, [&]() {
+                lookahead lh(*this);
+                lh.simplify(true);
+                lh.collect_statistics(m_aux_stats);
+            });
         }
 
         reinit_assumptions();
@@ -2093,20 +2174,23 @@ namespace sat {
         }
 
         if (m_config.m_binspr && !inconsistent()) {
-            m_binspr();
+            inprocess(IP_BINSPR, [&]() { m_binspr(); });
         }
 
         if (m_config.m_anf_simplify && m_simplifications > m_config.m_anf_delay && !inconsistent()) {
-            anf_simplifier anf(*this);
-            anf_simplifier::config cfg;
-            cfg.m_enable_exlin = m_config.m_anf_exlin;
-            anf();
-            anf.collect_statistics(m_aux_stats);
-            // TBD: throttle anf_delay based on yield
+            inprocess(IP_ANF, [&]() {
+                anf_simplifier anf(*this);
+                anf_simplifier::config cfg;
+                cfg.m_enable_exlin = m_config.m_anf_exlin;
+                cfg.m_num_threads = m_config.m_anf_threads;
+                anf.set(cfg);
+                anf();
+                anf.collect_statistics(m_aux_stats);
+            });
         }
         
         if (m_cut_simplifier && m_simplifications > m_config.m_cut_delay && !inconsistent()) {
-            (*m_cut_simplifier)();
+            inprocess(IP_CUTS, [&]() { (*m_cut_simplifier)(); });
         }
 
         if (m_config.m_inprocess_out.is_non_empty_string()) {
@@ -3784,6 +3868,7 @@ namespace sat {
         if (m_ext) m_ext->collect_statistics(st);
         if (m_local_search) m_local_search->collect_statistics(st);
         if (m_cut_simplifier) m_cut_simplifier->collect_statistics(st);
+        collect_inprocess_statistics(st);
         st.copy(m_aux_stats);
     }
 
@@ -3794,6 +3879,12 @@ namespace sat {
         m_asymm_branch.reset_statistics();
         m_probing.reset_statistics();
         m_aux_stats.reset();
+        for (inprocess_info& info : m_inprocess) {
+            // the schedule is kept, only the counters are reset
+            info.m_runs = info.m_skipped = 0;
+            info.m_removed = info.m_removed_literals = 0;
+            info.m_time = 0;
+        }
     }
 
     // -----------------------
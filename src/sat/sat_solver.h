@@ -238,6 +238,7 @@ namespace sat {
         friend class lut_finder;
         friend class npn3_finder;
         friend class proof_trim;
+        friend class cube_conquer;
         friend struct backoff;
     public:
         solver(params_ref const & p, reslimit& l);
@@ -572,6 +573,25 @@ namespace sat {
         bool is_assumption(literal l) const;
         bool should_simplify() const;
         void do_simplify();
+
+        // adaptive schedule of inprocessing techniques:
+        // a technique which removed nothing (no clause, unit or literal) is skipped for a number of
+        // simplification rounds that doubles with every unproductive run, productive runs halve it again.
+        enum inprocess_kind { IP_SCC, IP_SIMPLIFIER, IP_PROBING, IP_ASYMM_BRANCH, IP_LOOKAHEAD, IP_BINSPR, IP_ANF, IP_CUTS, IP_NUM };
+        struct inprocess_info {
+            unsigned m_runs = 0;
+            unsigned m_skipped = 0;
+            unsigned m_delay = 0;   // rounds to skip
+            unsigned m_backoff = 0; // delay after the next unproductive run
+            uint64_t m_removed = 0; // clauses removed, units found and literals removed
+            uint64_t m_removed_literals = 0;
+            double   m_time = 0;
+        };
+        inprocess_info m_inprocess[IP_NUM];
+        template<typename F>
+        void inprocess(inprocess_kind k, F const& f);
+        void collect_inprocess_statistics(statistics& st) const;
+        uint64_t num_inprocess_elim_literals() const;
         void mk_model();
         bool check_model(model const & m) const;
         void do_restart(bool to_base);
@@ -92,6 +92,10 @@ namespace sat {
         virtual void collect_statistics(statistics& st) const = 0;        
         virtual double get_priority(bool_var v) const = 0;
         virtual bool get_value(bool_var v) const { return true; }
+        // number of unsatisfied clauses of get_model(), UINT_MAX if there is no model to share.
+        virtual unsigned get_model_unsat() const { return UINT_MAX; }
+        // continue the search from the assignment phase (found by another worker).
+        virtual void import_phase(bool_vector const& phase) {}
     };
 
     class proof_hint {
@@ -238,7 +238,8 @@ unsigned read_dimacs(char const * file_name) {
             std::cerr << "(error \"failed to open file '" << file_name << "'\")" << std::endl;
             exit(ERR_OPEN_FILE);
         }
-        parse_dimacs(in, std::cerr, solver);
+        in.close();
+        parse_dimacs(file_name, std::cerr, solver);
     }
     else {
         parse_dimacs(std::cin, std::cerr, solver);
@@ -49,6 +49,9 @@ typedef enum { IN_UNSPECIFIED, IN_SMTLIB_2, IN_DATALOG, IN_DIMACS, IN_WCNF, IN_O
 static char const * g_input_file          = nullptr;
 static char const * g_drat_input_file     = nullptr;
 static bool         g_standard_input      = false;
+static bool         g_server              = false;
+static char const * g_server_socket       = nullptr;
+static char const * g_server_base_file    = nullptr;
 static input_kind   g_input_kind          = IN_UNSPECIFIED;
 bool                g_display_statistics  = false;
 bool                g_display_model       = false;
@@ -88,6 +91,9 @@ void display_usage() {
     std::cout << "  -log        use parser for Z3 log input format.\n";
     std::cout << "  -in         read formula from standard input.\n";
     std::cout << "  -model      display model for satisfiable SMT.\n";
+    std::cout << "  -server[:socket]  serve SMT 2 scripts, each framed by a line with its length in bytes (and an optional timeout in milli seconds),\n";
+    std::cout << "              read from standard input or from the given Unix socket.\n";
+    std::cout << "  -server_base:file  parse the SMT 2 file once and run the scripts of the server in scopes above it.\n";
     std::cout << "\nMiscellaneous:\n";
     std::cout << "  -h, -?      prints this message.\n";
     std::cout << "  -version    prints version number of Z3.\n";
@@ -109,7 +115,7 @@ void display_usage() {
     std::cout << "  -memory:Megabytes  set a limit for virtual memory consumption.\n";
     // 
     std::cout << "\nOutput:\n";
-    std::cout << "  -st         display statistics.\n";
+    std::cout << "  -st         display statistics (for -log, the latencies of the replayed calls).\n";
 #if defined(Z3DEBUG) || defined(_TRACE)
     std::cout << "\nDebugging support:\n";
 #endif
@@ -195,6 +201,15 @@ static void parse_cmd_line_args(std::string& input_file, int argc, char ** argv)
             else if (strcmp(opt_name, "in") == 0) {
                 g_standard_input = true;
             }
+            else if (strcmp(opt_name, "server") == 0) {
+                g_server = true;
+                g_server_socket = opt_arg;
+            }
+            else if (strcmp(opt_name, "server_base") == 0) {
+                if (!opt_arg)
+                    error("option argument (-server_base:file) is missing.");
+                g_server_base_file = opt_arg;
+            }
             else if (strcmp(opt_name, "dimacs") == 0) {
                 g_input_kind = IN_DIMACS;
             }
@@ -347,6 +362,13 @@ int STD_CALL main(int argc, char ** argv) {
         parse_cmd_line_args(input_file, argc, argv);
         env_params::updt_params();
 
+        if (g_server) {
+            memory::exit_when_out_of_memory(true, "(error \"out of memory\")");
+            return_value = read_smtlib2_server(g_server_socket, g_server_base_file);
+            disable_timeout();
+            memory::finalize();
+            return return_value;
+        }
         if (g_input_file && g_standard_input) {
             error("using standard input to read formula.");
         }
@@ -402,7 +424,7 @@ int STD_CALL main(int argc, char ** argv) {
             read_datalog(g_input_file);
             break;
         case IN_Z3_LOG:
-            replay_z3_log(g_input_file);
+            replay_z3_log(g_input_file, g_display_statistics);
             break;
         case IN_DRAT:
             return_value = read_drat(g_drat_input_file);
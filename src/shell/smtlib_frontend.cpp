@@ -21,7 +21,17 @@ Revision History:
 #include<iostream>
 #include<time.h>
 #include<signal.h>
+#include<sstream>
+#include<cstring>
+#include<cerrno>
+#ifndef _WINDOWS
+#include<sys/socket.h>
+#include<sys/un.h>
+#include<unistd.h>
+#endif
 #include "util/timeout.h"
+#include "util/cancel_eh.h"
+#include "util/scoped_timer.h"
 #include "util/mutex.h"
 #include "parsers/smt2/smt2parser.h"
 #include "muz/fp/dl_cmds.h"
@@ -191,3 +201,264 @@ unsigned read_smtlib2_commands(char const * file_name) {
     return result ? 0 : 1;
 }
 
+
+/**
+   \brief Channel of the server mode.
+
+   A request is a header line "<length> [<timeout>]" followed by <length> bytes of
+   an SMT-LIB2 script. <timeout> is a soft timeout in milliseconds for the request.
+   A response is a line "<length>" followed by <length> bytes of output of the script.
+   The header "0" stops the server.
+*/
+class server_channel {
+public:
+    virtual ~server_channel() = default;
+    virtual bool read_request(std::string& script, unsigned& timeout) = 0;
+    virtual void write_response(std::string const& out) = 0;
+
+    static bool parse_header(std::string const& line, size_t& len, unsigned& timeout) {
+        std::istringstream hdr(line);
+        timeout = 0;
+        if (!(hdr >> len))
+            return false;
+        hdr >> timeout;
+        return true;
+    }
+};
+
+class stdin_channel : public server_channel {
+public:
+    bool read_request(std::string& script, unsigned& timeout) override {
+        std::string line;
+        size_t len = 0;
+        do {
+            if (!std::getline(std::cin, line))
+                return false;
+        }
+        while (line.empty());
+        if (!parse_header(line, len, timeout) || len == 0)
+            return false;
+        script.resize(len);
+        std::cin.read(script.data(), len);
+        return static_cast<size_t>(std::cin.gcount()) == len;
+    }
+
+    void write_response(std::string const& out) override {
+        std::cout << out.size() << "\n" << out;
+        std::cout.flush();
+    }
+};
+
+#ifndef _WINDOWS
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+class socket_channel : public server_channel {
+    int         m_listen = -1;
+    int         m_conn = -1;
+    std::string m_buffer;
+
+    bool fill() {
+        char buf[4096];
+        ssize_t n;
+        while (m_conn >= 0) {
+            n = ::read(m_conn, buf, sizeof(buf));
+            if (n > 0) {
+                m_buffer.append(buf, n);
+                return true;
+            }
+            ::close(m_conn);
+            m_conn = -1;
+            m_buffer.clear();
+        }
+        return false;
+    }
+
+    bool connect() {
+        while (m_conn < 0) {
+            m_conn = ::accept(m_listen, nullptr, nullptr);
+            if (m_conn < 0)
+                return false;
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+            int on = 1;
+            ::setsockopt(m_conn, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        }
+        return true;
+    }
+
+public:
+    socket_channel(char const* path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(addr.sun_path))
+            throw default_exception("socket path is too long");
+        strcpy(addr.sun_path, path);
+        ::unlink(path);
+        m_listen = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listen < 0 ||
+            ::bind(m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(m_listen, 1) < 0)
+            throw default_exception(std::string("could not listen on socket ") + path);
+    }
+
+    ~socket_channel() override {
+        if (m_conn >= 0)
+            ::close(m_conn);
+        if (m_listen >= 0)
+            ::close(m_listen);
+    }
+
+    bool read_request(std::string& script, unsigned& timeout) override {
+        size_t len = 0;
+        while (true) {
+            if (!connect())
+                return false;
+            size_t nl;
+            while ((nl = m_buffer.find('\n')) == std::string::npos)
+                if (!fill())
+                    break;
+            if (m_conn < 0)
+                continue;
+            std::string line = m_buffer.substr(0, nl);
+            m_buffer.erase(0, nl + 1);
+            if (line.empty())
+                continue;
+            if (!parse_header(line, len, timeout) || len == 0)
+                return false;
+            while (m_buffer.size() < len)
+                if (!fill())
+                    break;
+            if (m_conn < 0)
+                continue;
+            script = m_buffer.substr(0, len);
+            m_buffer.erase(0, len);
+            return true;
+        }
+    }
+
+    void write_response(std::string const& out) override {
+        std::string msg = std::to_string(out.size()) + "\n" + out;
+        size_t off = 0;
+        while (m_conn >= 0 && off < msg.size()) {
+            // a client that disconnected must not kill the server by SIGPIPE, the write fails with EPIPE instead
+            ssize_t n = ::send(m_conn, msg.data() + off, msg.size() - off, SEND_FLAGS);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0) {
+                ::close(m_conn);
+                m_conn = -1;
+                m_buffer.clear();
+            }
+            else
+                off += n;
+        }
+    }
+};
+#endif
+
+static void install_server_cmds(cmd_context& ctx) {
+    ctx.set_solver_factory(mk_smt_strategic_solver_factory());
+    install_dl_cmds(ctx);
+    install_dbg_cmds(ctx);
+    install_polynomial_cmds(ctx);
+    install_subpaving_cmds(ctx);
+    install_opt_cmds(ctx);
+    install_smt2_extra_cmds(ctx);
+    install_proof_cmds(ctx);
+}
+
+/**
+   \brief Serve SMT-LIB2 scripts read from standard input, or from a Unix socket
+   if socket_path is not null, see server_channel for the framing.
+
+   The process, parameters and modules are initialized once. Without base_file,
+   every request runs in a fresh command context. With base_file, the base script
+   is parsed once into a persistent command context and every request runs in a
+   scope above it that is popped afterwards, so that the declarations and assertions
+   of the base script, and the terms and caches of its manager, are shared
+   between requests.
+*/
+unsigned read_smtlib2_server(char const * socket_path, char const * base_file) {
+    scoped_ptr<server_channel> ch;
+#ifndef _WINDOWS
+    if (socket_path)
+        ch = alloc(socket_channel, socket_path);
+#else
+    if (socket_path)
+        throw default_exception("the server mode does not support sockets on this platform");
+#endif
+    if (!ch)
+        ch = alloc(stdin_channel);
+
+    std::string base;
+    if (base_file) {
+        std::ifstream in(base_file);
+        if (in.bad() || in.fail()) {
+            std::cerr << "(error \"failed to open file '" << base_file << "'\")" << std::endl;
+            exit(ERR_OPEN_FILE);
+        }
+        std::stringstream buf;
+        buf << in.rdbuf();
+        base = buf.str();
+    }
+
+    scoped_ptr<cmd_context> persistent;
+    unsigned base_level = 0;
+    std::string script;
+    unsigned timeout = 0;
+    while (ch->read_request(script, timeout)) {
+        std::ostringstream out;
+        clock_t start_time = clock();
+        scoped_ptr<cmd_context> fresh;
+        if (base_file && (!persistent || persistent->num_scopes() < base_level)) {
+            // the base scope was left by (reset) or a pop of a previous request
+            persistent = alloc(cmd_context);
+            install_server_cmds(*persistent);
+            std::istringstream in(base);
+            persistent->set_regular_stream(out);
+            persistent->set_diagnostic_stream(out);
+            parse_smt2_commands(*persistent, in);
+            persistent->push();
+            base_level = persistent->num_scopes();
+        }
+        if (!base_file) {
+            fresh = alloc(cmd_context);
+            install_server_cmds(*fresh);
+        }
+        cmd_context& ctx = base_file ? *persistent : *fresh;
+        ctx.set_regular_stream(out);
+        ctx.set_diagnostic_stream(out);
+        g_cmd_context = &ctx;
+        {
+            cancel_eh<reslimit> eh(ctx.m().limit());
+            scoped_timer timer(timeout, &eh);
+            std::istringstream in(script);
+            parse_smt2_commands(ctx, in);
+        }
+        ctx.m().limit().reset_cancel();
+        if (g_display_statistics)
+            ctx.display_statistics(true, (static_cast<double>(clock()) - static_cast<double>(start_time)) / CLOCKS_PER_SEC);
+        if (g_display_model) {
+            model_ref mdl;
+            if (ctx.is_model_available(mdl))
+                ctx.display_model(mdl);
+        }
+        if (base_file && ctx.num_scopes() > base_level)
+            ctx.pop(ctx.num_scopes() - base_level);
+        if (base_file && ctx.num_scopes() == base_level) {
+            // fresh scope for the next request
+            ctx.pop(1);
+            ctx.push();
+        }
+        ctx.set_regular_stream("stdout");
+        ctx.set_diagnostic_stream("stderr");
+        g_cmd_context = nullptr;
+        ch->write_response(out.str());
+    }
+    return 0;
+}
@@ -20,6 +20,7 @@ Revision History:
 
 unsigned read_smtlib_file(char const * benchmark_file);
 unsigned read_smtlib2_commands(char const * command_file);
+unsigned read_smtlib2_server(char const * socket_path, char const * base_file);
 void help_tactics();
 void help_simplifiers();
 void help_probes();
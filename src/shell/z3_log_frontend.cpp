@@ -24,9 +24,11 @@ Revision History:
 #include "util/error_codes.h"
 #include "api/z3_replayer.h"
 
-static void solve(char const * stream_name, std::istream & in) {
+static void solve(char const * stream_name, std::istream & in, bool display_timing) {
     clock_t start_time = clock();
+    // the log is executed while it is read, each call as soon as its line is parsed
     z3_replayer r(in);
+    r.set_timing(display_timing);
     try {
         r.parse();
     }
@@ -34,13 +36,15 @@ static void solve(char const * stream_name, std::istream & in) {
         std::cerr << "Error at line " << r.get_line() << ": " << ex.msg() << std::endl;
     }
     clock_t end_time = clock();
+    if (display_timing)
+        r.display_timing(std::cout);
     memory::display_max_usage(std::cout);
     std::cout << "time:               " << ((static_cast<double>(end_time) - static_cast<double>(start_time)) / CLOCKS_PER_SEC) << "\n";
 }
 
-void replay_z3_log(char const * file_name) {
+void replay_z3_log(char const * file_name, bool display_timing) {
     if (!file_name) {
-        solve(file_name, std::cin);
+        solve(file_name, std::cin, display_timing);
     }
     else {
         std::ifstream in(file_name);
@@ -48,7 +52,7 @@ void replay_z3_log(char const * file_name) {
             std::cerr << "Error: failed to open file \"" << file_name << "\".\n";
             exit(ERR_OPEN_FILE);
         }
-        solve(file_name, in);
+        solve(file_name, in, display_timing);
     }
     exit(0);
 }
@@ -19,7 +19,8 @@ Revision History:
 --*/
 #pragma once
 
-void replay_z3_log(char const * benchmark_file);
+// display_timing: display the latencies of the calls of the log (per API function)
+void replay_z3_log(char const * benchmark_file, bool display_timing = false);
 
 
 
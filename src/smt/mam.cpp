@@ -17,6 +17,9 @@ Revision History:
 
 --*/
 #include <algorithm>
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
 
 #include "util/pool.h"
 #include "util/trail.h"
@@ -1864,6 +1867,58 @@ namespace {
 
         pool<enode_vector>  m_pool;
 
+    public:
+        /**
+           \brief match found by an interpreter running on a worker thread (see mam_impl::match_par).
+           The bindings are stored in m_match_bindings at [m_offset, m_offset + m_num_bindings).
+        */
+        struct match_record {
+            unsigned     m_tree;
+            quantifier * m_qa;
+            app *        m_pat;
+            unsigned     m_offset;
+            unsigned     m_num_bindings;
+            unsigned     m_max_generation;
+            unsigned     m_min_top_generation;
+            unsigned     m_max_top_generation;
+        };
+
+    private:
+        // An interpreter on a worker thread only reads the e-graph: it records the matches
+        // instead of reporting them, and does not use the shared temporary enode of the context.
+        bool                  m_worker;
+        tmp_enode             m_tmp_enode;
+        unsigned              m_tree_idx = 0;
+        obj_hashtable<enode>  m_seen;
+        svector<match_record> m_matches;
+        enode_vector          m_match_bindings;
+
+        bool cancel_flag() {
+            return m_worker ? m.limit().is_canceled() : m_context.get_cancel_flag();
+        }
+
+        bool limits_exceeded() {
+            return m_worker ? m.limit().is_canceled() : m_context.resource_limits_exceeded();
+        }
+
+        enode * get_enode_eq_to(func_decl * f, unsigned num_args, enode * const * args) {
+            if (m_worker)
+                return m_context.get_cg_table().find_registered(m_tmp_enode.set(f, num_args, args));
+            return m_context.get_enode_eq_to(f, num_args, args);
+        }
+
+        void on_match(yield const * y, unsigned num_bindings) {
+            if (!m_worker) {
+                m_mam.on_match(y->m_qa, y->m_pat, num_bindings, m_bindings.begin(), m_max_generation, m_used_enodes);
+                return;
+            }
+            unsigned min_gen = 0, max_gen = 0;
+            get_min_max_top_generation(min_gen, max_gen);
+            m_matches.push_back({ m_tree_idx, y->m_qa, y->m_pat, m_match_bindings.size(), num_bindings, m_max_generation, min_gen, max_gen });
+            for (unsigned i = 0; i < num_bindings; ++i)
+                m_match_bindings.push_back(m_bindings[i]);
+        }
+
         enode_vector * mk_enode_vector() {
             enode_vector * r = m_pool.mk();
             r->reset();
@@ -1987,11 +2042,12 @@ namespace {
 #define INIT_ARGS_SIZE 16
 
     public:
-        interpreter(context & ctx, mam & ma, bool use_filters):
+        interpreter(context & ctx, mam & ma, bool use_filters, bool worker = false):
             m_context(ctx),
             m(ctx.get_manager()),
             m_mam(ma),
-            m_use_filters(use_filters) {
+            m_use_filters(use_filters),
+            m_worker(worker) {
             m_args.resize(INIT_ARGS_SIZE);
         }
 
@@ -2010,11 +2066,22 @@ namespace {
             TRACE("trigger_bug", tout << "execute for code tree:\n"; t->display(tout););
             init(t);
 #define CLEANUP  for (enode* app : t->get_candidates()) if (app->is_marked()) app->unset_mark();
-            if (t->filter_candidates()) {
+            if (t->filter_candidates() && m_worker) {
+                // the marks of the enodes are not written concurrently
+                m_seen.reset();
+                for (enode* app : t->get_candidates()) {
+                    if (!m_seen.contains(app) && app->is_cgr()) {
+                        if (limits_exceeded() || !execute_core(t, app)) 
+                            return false;
+                        m_seen.insert(app);
+                    }
+                }
+            }
+            else if (t->filter_candidates()) {
                 for (enode* app : t->get_candidates()) {
                     TRACE("trigger_bug", tout << "candidate\n" << mk_ismt2_pp(app->get_expr(), m) << "\n";);
                     if (!app->is_marked() && app->is_cgr()) {
-                        if (m_context.resource_limits_exceeded() || !execute_core(t, app)) {
+                        if (limits_exceeded() || !execute_core(t, app)) {
                             CLEANUP;
                             return false;
                         }
@@ -2030,7 +2097,7 @@ namespace {
                     if (app->is_cgr()) {
                         TRACE("trigger_bug", tout << "is_cgr\n";);
                         // scoped_suspend_rlimit susp(m.limit(), false);
-                        if (m_context.resource_limits_exceeded() || !execute_core(t, app))
+                        if (limits_exceeded() || !execute_core(t, app))
                             return false;
                     }
                 }
@@ -2041,6 +2108,12 @@ namespace {
         // init(t) must be invoked before execute_core
         bool execute_core(code_tree * t, enode * n);
 
+        // the matches recorded by a worker interpreter, tagged by tree_idx at the time they were found
+        void set_tree_idx(unsigned idx) { m_tree_idx = idx; }
+        svector<match_record> const & matches() const { return m_matches; }
+        enode * const * match_bindings(match_record const & r) const { return m_match_bindings.data() + r.m_offset; }
+        void reset_matches() { m_matches.reset(); m_match_bindings.reset(); }
+
         // Return the min, max generation of the enodes in m_pattern_instances.
 
         void get_min_max_top_generation(unsigned& min, unsigned& max) {
@@ -2537,14 +2610,10 @@ namespace {
             m_bindings[0] = m_registers[static_cast<const yield *>(m_pc)->m_bindings[0]];
 #define ON_MATCH(NUM)                                                   \
             m_max_generation = std::max(m_max_generation, get_max_generation(NUM, m_bindings.begin())); \
-            if (m_context.get_cancel_flag()) {                          \
+            if (cancel_flag()) {                                        \
                 return false;                                           \
             }                                                           \
-            m_mam.on_match(static_cast<const yield *>(m_pc)->m_qa,                                      \
-                           static_cast<const yield *>(m_pc)->m_pat,                                     \
-                           NUM,                                                                         \
-                           m_bindings.begin(),                                                          \
-                           m_max_generation, m_used_enodes)
+            on_match(static_cast<const yield *>(m_pc), NUM)
             ON_MATCH(1);
             goto backtrack;
 
@@ -2602,7 +2671,7 @@ namespace {
 
         case GET_CGR1:
 #define GET_CGR_COMMON()                                                                                                                                                \
-            m_n1 = m_context.get_enode_eq_to(static_cast<const get_cgr *>(m_pc)->m_label, static_cast<const get_cgr *>(m_pc)->m_num_args, m_args.data());              \
+            m_n1 = get_enode_eq_to(static_cast<const get_cgr *>(m_pc)->m_label, static_cast<const get_cgr *>(m_pc)->m_num_args, m_args.data());                        \
             if (m_n1 == 0 || !m_context.is_relevant(m_n1))                                                                                                              \
                 goto backtrack;                                                                                                                                         \
             update_max_generation(m_n1, nullptr);                                                                                                                       \
@@ -2713,7 +2782,7 @@ namespace {
 
         if (since_last_check++ > 100) {
             since_last_check = 0;
-            if (m_context.resource_limits_exceeded()) {
+            if (limits_exceeded()) {
                 // Soft timeout...
                 // Cleanup before exiting
                 while (m_top != 0) {
@@ -3096,6 +3165,7 @@ namespace {
         code_tree_manager           m_ct_manager;
         compiler                    m_compiler;
         interpreter                 m_interpreter;
+        scoped_ptr_vector<interpreter> m_workers;   // interpreters of the matching threads
         code_tree_map               m_trees;
 
         ptr_vector<code_tree>       m_tmp_trees;
@@ -3888,8 +3958,95 @@ namespace {
             }
         }
 
+        // matching is distributed over threads only for enough candidates to pay for the threads.
+        static const unsigned s_min_par_candidates = 256;
+
+        bool use_match_par() const {
+#ifdef SINGLE_THREAD
+            return false;
+#else
+            unsigned num_threads = m_context.get_fparams().m_qi_match_threads;
+            if (num_threads <= 1 || m_to_match.size() <= 1)
+                return false;
+            if (m.has_trace_stream() || is_trace_enabled("causality"))
+                return false;
+            DEBUG_CODE(if (m_check_missing_instances) return false;);
+            unsigned num_candidates = 0;
+            for (code_tree* t : m_to_match)
+                num_candidates += t->get_candidates().size();
+            return num_candidates >= s_min_par_candidates;
+#endif
+        }
+
+#ifndef SINGLE_THREAD
+        /**
+           \brief match the code trees in m_to_match on worker threads. The candidates of distinct 
+           code trees are distinct, and the e-graph is not modified while the workers run: they only 
+           record the matches. The matches are then reported in the order of the code trees and, 
+           within a code tree, in the order they were found, which is the order of the sequential matcher.
+        */
+        bool match_par() {
+            unsigned num_trees = m_to_match.size();
+            unsigned num_threads = std::min(m_context.get_fparams().m_qi_match_threads, num_trees);
+            while (m_workers.size() < num_threads)
+                m_workers.push_back(alloc(interpreter, m_context, *this, m_use_filters, true));
+            bool_vector done(num_trees, false);
+            auto work = [&](unsigned w) {
+                interpreter & in = *m_workers[w];
+                in.reset_matches();
+                for (unsigned i = w; i < num_trees; i += num_threads) {
+                    in.set_tree_idx(i);
+                    if (!in.execute(m_to_match[i]))
+                        return;
+                    done[i] = true;
+                }
+            };
+            vector<std::thread> threads;
+            for (unsigned w = 1; w < num_threads; ++w)
+                threads.push_back(std::thread([&, w]() { work(w); }));
+            work(0);
+            for (auto & th : threads)
+                th.join();
+
+            unsigned_vector cursor(num_threads, 0u);
+            vector<std::tuple<enode *, enode *>> used_enodes;
+            for (unsigned i = 0; i < num_trees; ++i) {
+                interpreter & in = *m_workers[i % num_threads];
+                auto const & matches = in.matches();
+                unsigned & j = cursor[i % num_threads];
+                for (; j < matches.size() && matches[j].m_tree == i; ++j) {
+                    auto const & r = matches[j];
+                    m_context.add_instance(r.m_qa, r.m_pat, r.m_num_bindings, in.match_bindings(r), nullptr, 
+                                           r.m_max_generation, r.m_min_top_generation, r.m_max_top_generation, used_enodes);
+                }
+            }
+            unsigned k = 0;
+            for (unsigned i = 0; i < num_trees; ++i) {
+                if (done[i])
+                    m_to_match[i]->reset_candidates();
+                else
+                    m_to_match[k++] = m_to_match[i];
+            }
+            m_to_match.shrink(k);
+            for (interpreter * in : m_workers)
+                in->reset_matches();
+            return k == 0;
+        }
+#endif
+
         void match() override {
             TRACE("trigger_bug", tout << "match\n"; display(tout););
+#ifndef SINGLE_THREAD
+            if (use_match_par()) {
+                if (!match_par())
+                    return;
+                if (!m_new_patterns.empty()) {
+                    match_new_patterns();
+                    m_new_patterns.reset();
+                }
+                return;
+            }
+#endif
             for (code_tree* t : m_to_match) {
                 SASSERT(t->has_candidates());
                 if (!m_interpreter.execute(t))
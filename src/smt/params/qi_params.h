@@ -37,6 +37,7 @@ struct qi_params {
     bool               m_qi_profile = false;
     unsigned           m_qi_profile_freq = UINT_MAX;
     quick_checker_mode m_qi_quick_checker = MC_NO;
+    unsigned           m_qi_match_threads = 1;
     bool               m_qi_lazy_quick_checker = true;
     bool               m_qi_promote_unsat = true;
     unsigned           m_qi_max_instances = UINT_MAX;
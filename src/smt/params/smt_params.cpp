@@ -36,6 +36,7 @@ void smt_params::updt_local_params(params_ref const & _p) {
     m_restart_strategy = static_cast<restart_strategy>(p.restart_strategy());
     if (m_restart_strategy > RS_ARITHMETIC) throw default_exception("illegal restart strategy numeral");
     m_restart_factor = p.restart_factor();
+    m_progress_sampling_freq = p.progress_sampling_freq();
     m_case_split_strategy = static_cast<case_split_strategy>(p.case_split());
     m_theory_case_split = p.theory_case_split();
     m_theory_aware_branching = p.theory_aware_branching();
@@ -48,10 +49,17 @@ void smt_params::updt_local_params(params_ref const & _p) {
     m_threads       = p.threads();
     m_threads_max_conflicts  = p.threads_max_conflicts();
     m_threads_cube_frequency = p.threads_cube_frequency();
+    m_threads_share_size = p.threads_share_size();
+    m_distributed_dir = p.distributed_dir();
+    m_distributed_worker = p.distributed_worker();
+    m_distributed_cube_depth = p.distributed_cube_depth();
     m_core_validate = p.core_validate();
     m_logic = _p.get_sym("logic", m_logic);
     m_string_solver = p.string_solver();
     m_up_persist_clauses = p.up_persist_clauses();
+    m_lemma_gc_tiered = p.lemma_gc_tiered();
+    m_lemma_gc_core_glue = p.lemma_gc_core_glue();
+    m_lemma_gc_tier2_glue = p.lemma_gc_tier2_glue();
     validate_string_solver(m_string_solver);
     if (_p.get_bool("arith.greatest_error_pivot", false))
         m_arith_pivot_strategy = arith_pivot_strategy::ARITH_PIVOT_GREATEST_ERROR;
@@ -121,6 +129,10 @@ void smt_params::display(std::ostream & out) const {
     DISPLAY_PARAM(m_threads);
     DISPLAY_PARAM(m_threads_max_conflicts);
     DISPLAY_PARAM(m_threads_cube_frequency);
+    DISPLAY_PARAM(m_threads_share_size);
+    DISPLAY_PARAM(m_distributed_dir);
+    DISPLAY_PARAM(m_distributed_worker);
+    DISPLAY_PARAM(m_distributed_cube_depth);
     DISPLAY_PARAM(m_simplify_clauses);
     DISPLAY_PARAM(m_tick);
     DISPLAY_PARAM(m_display_features);
@@ -149,6 +161,9 @@ void smt_params::display(std::ostream & out) const {
     DISPLAY_PARAM(m_up_persist_clauses);
     DISPLAY_PARAM(m_lemma_gc_strategy);
     DISPLAY_PARAM(m_lemma_gc_half);
+    DISPLAY_PARAM(m_lemma_gc_tiered);
+    DISPLAY_PARAM(m_lemma_gc_core_glue);
+    DISPLAY_PARAM(m_lemma_gc_tier2_glue);
     DISPLAY_PARAM(m_recent_lemmas_size);
     DISPLAY_PARAM(m_lemma_gc_initial);
     DISPLAY_PARAM(m_lemma_gc_factor);
@@ -186,9 +201,9 @@ void smt_params::display(std::ostream & out) const {
 }
 
 void smt_params::validate_string_solver(symbol const& s) const {
-    if (s == "z3str3" || s == "seq" || s == "empty" || s == "auto" || s == "none" || s == "noodler")
+    if (s == "z3str3" || s == "seq" || s == "empty" || s == "auto" || s == "none" || s == "noodler" || s == "portfolio")
         return;
-    throw default_exception("Invalid string solver value. Legal values are z3str3, seq, empty, auto, none");
+    throw default_exception("Invalid string solver value. Legal values are z3str3, seq, empty, auto, none, noodler, portfolio");
 }
 
 void smt_params::setup_QF_UF() {
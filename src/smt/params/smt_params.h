@@ -108,6 +108,10 @@ struct smt_params : public preprocessor_params,
     unsigned         m_threads = 1;
     unsigned         m_threads_max_conflicts = UINT_MAX;
     unsigned         m_threads_cube_frequency = 2;
+    unsigned         m_threads_share_size = 8;
+    symbol           m_distributed_dir;
+    bool             m_distributed_worker = false;
+    unsigned         m_distributed_cube_depth = 4;
     bool             m_simplify_clauses = true;
     unsigned         m_tick = 1000;
     bool             m_display_features = false;
@@ -162,6 +166,9 @@ struct smt_params : public preprocessor_params,
     // -----------------------------------
     lemma_gc_strategy m_lemma_gc_strategy = lemma_gc_strategy::LGC_FIXED;
     bool              m_lemma_gc_half = false;
+    bool              m_lemma_gc_tiered = false;
+    unsigned          m_lemma_gc_core_glue = 2;   //!< lemmas with at most this glue are never deleted by the tiered strategy.
+    unsigned          m_lemma_gc_tier2_glue = 6;  //!< lemmas with at most this glue are kept as long as they are used.
     unsigned          m_recent_lemmas_size = 100;
     unsigned          m_lemma_gc_initial = 5000;
     double            m_lemma_gc_factor = 1.1;
@@ -10,7 +10,52 @@ void theory_str_noodler_params::updt_params(params_ref const & _p) {
     m_try_nielsen = p.str_try_nielsen();
     m_try_length_proc = p.str_try_length_proc();
     m_underapprox_length = p.str_underapprox_length();
+    m_underapprox_length_max = p.str_underapprox_length_max();
+    m_underapprox_round_time = p.str_underapprox_round_time();
+    m_interval_cases_limit = p.str_interval_cases_limit();
     m_try_length_proc = p.str_try_length_proc();
+    m_dp_threads = p.str_dp_threads();
+    m_inclusion_order = static_cast<inclusion_order>(p.str_inclusion_order());
+    if (m_inclusion_order > IO_FEWEST_NOODLES) throw default_exception("illegal inclusion order numeral");
+    m_worklist_order = static_cast<worklist_order>(p.str_worklist_order());
+    if (m_worklist_order > WO_FEWEST_NOODLES) throw default_exception("illegal worklist order numeral");
+    m_worklist_aging = p.str_worklist_aging();
+    m_length_pruning = p.str_length_pruning();
+    m_model_guided_noodles = p.str_model_guided_noodles();
+    m_shortest_witnesses = p.str_shortest_witnesses();
+    m_alphabet_classes = p.str_alphabet_classes();
+    m_fc_time_budget = p.str_fc_time_budget();
+    m_fc_max_solving_states = p.str_fc_max_solving_states();
+    m_fc_max_aut_states = p.str_fc_max_aut_states();
+    m_fc_max_memory = p.str_fc_max_memory();
+    m_split_components = p.str_split_components();
+    m_prep_size_limit = p.str_prep_size_limit();
+    m_reduction_policy = static_cast<reduction_policy>(p.str_reduction_policy());
+    if (m_reduction_policy > RP_ADAPTIVE) throw default_exception("illegal reduction policy numeral");
+    m_reduction_minimize_states = p.str_reduction_minimize_states();
+    m_reduction_simulation_states = p.str_reduction_simulation_states();
+    m_nielsen_max_depth = p.str_nielsen_max_depth();
+    m_nielsen_threads = p.str_nielsen_threads();
+    m_deterministic = p.str_deterministic();
+    m_portfolio = p.str_portfolio();
+    m_sls = p.str_sls();
+    m_sls_max_flips = p.str_sls_max_flips();
+    m_bounded_length = p.str_bounded_length();
+    m_procedure_selector = static_cast<procedure_selector>(p.str_procedure_selector());
+    if (m_procedure_selector > PS_TABLE) throw default_exception("illegal procedure selector numeral");
+    m_lazy_axioms = p.str_lazy_axioms();
+    m_search_propagation = p.str_search_propagation();
+    m_core_shrink_checks = p.str_core_shrink_checks();
+    m_len_presolve = p.str_len_presolve();
+    m_len_block_core = p.str_len_block_core();
+    m_event_log_capacity = p.str_event_log();
+    m_event_log_file = p.str_event_log_file();
+    m_record_dir = p.str_record_dir();
+    m_session_caches = p.str_session_caches();
+    m_nfa_cache_memory = p.str_nfa_cache_memory();
+    m_cache_memory = p.str_cache_memory();
+    m_nfa_cache_file = p.str_nfa_cache_file();
+    m_rewrite_cache_size = p.str_rewrite_cache_size();
 }
 
 #define DISPLAY_PARAM(X) out << #X"=" << X << std::endl;
@@ -22,5 +67,46 @@ void theory_str_noodler_params::display(std::ostream & out) const {
     DISPLAY_PARAM(m_try_nielsen);
     DISPLAY_PARAM(m_try_length_proc);
     DISPLAY_PARAM(m_underapprox_length);
+    DISPLAY_PARAM(m_underapprox_length_max);
+    DISPLAY_PARAM(m_underapprox_round_time);
+    DISPLAY_PARAM(m_interval_cases_limit);
     DISPLAY_PARAM(m_try_length_proc);
+    DISPLAY_PARAM(m_dp_threads);
+    DISPLAY_PARAM(m_inclusion_order);
+    DISPLAY_PARAM(m_worklist_order);
+    DISPLAY_PARAM(m_worklist_aging);
+    DISPLAY_PARAM(m_length_pruning);
+    DISPLAY_PARAM(m_model_guided_noodles);
+    DISPLAY_PARAM(m_shortest_witnesses);
+    DISPLAY_PARAM(m_alphabet_classes);
+    DISPLAY_PARAM(m_fc_time_budget);
+    DISPLAY_PARAM(m_fc_max_solving_states);
+    DISPLAY_PARAM(m_fc_max_aut_states);
+    DISPLAY_PARAM(m_fc_max_memory);
+    DISPLAY_PARAM(m_split_components);
+    DISPLAY_PARAM(m_prep_size_limit);
+    DISPLAY_PARAM(m_reduction_policy);
+    DISPLAY_PARAM(m_reduction_minimize_states);
+    DISPLAY_PARAM(m_reduction_simulation_states);
+    DISPLAY_PARAM(m_nielsen_max_depth);
+    DISPLAY_PARAM(m_nielsen_threads);
+    DISPLAY_PARAM(m_deterministic);
+    DISPLAY_PARAM(m_portfolio);
+    DISPLAY_PARAM(m_sls);
+    DISPLAY_PARAM(m_sls_max_flips);
+    DISPLAY_PARAM(m_bounded_length);
+    DISPLAY_PARAM(m_procedure_selector);
+    DISPLAY_PARAM(m_lazy_axioms);
+    DISPLAY_PARAM(m_search_propagation);
+    DISPLAY_PARAM(m_core_shrink_checks);
+    DISPLAY_PARAM(m_len_presolve);
+    DISPLAY_PARAM(m_len_block_core);
+    DISPLAY_PARAM(m_event_log_capacity);
+    DISPLAY_PARAM(m_event_log_file);
+    DISPLAY_PARAM(m_record_dir);
+    DISPLAY_PARAM(m_session_caches);
+    DISPLAY_PARAM(m_nfa_cache_memory);
+    DISPLAY_PARAM(m_cache_memory);
+    DISPLAY_PARAM(m_nfa_cache_file);
+    DISPLAY_PARAM(m_rewrite_cache_size);
 }
@@ -1,8 +1,54 @@
 
 #pragma once
 
+#include <string>
+
 #include "util/params.h"
 
+/**
+ * @brief Heuristics ordering the inclusions processed by the decision procedure (ties are broken
+ * by the order given by the inclusion graph).
+ */
+enum inclusion_order {
+    IO_GRAPH,
+    IO_SMALLEST_AUT,        // the smallest sum of states of automata of the terms first
+    IO_LENGTH_VARS,         // the most length-sensitive variables first
+    IO_FEWEST_NOODLES,      // the fewest expected noodles (estimated from the numbers of states) first
+};
+
+/**
+ * @brief Order in which the decision procedure explores its solving states. Besides the default order, the states
+ * are explored best-first by the given cost (see DecisionProcedure::get_state_cost()).
+ */
+enum worklist_order {
+    WO_DEFAULT,             // breadth-first for inclusions on a cycle, depth-first otherwise
+    WO_INCLUSIONS,          // the fewest remaining inclusions first
+    WO_SMALLEST_AUT,        // the smallest sum of states of automata first
+    WO_LENGTH_VARS,         // the fewest length-sensitive variables first
+    WO_FEWEST_NOODLES,      // the fewest expected noodles of the next inclusion first
+};
+
+/**
+ * @brief Policies of reducing automata obtained by concatenations of right sides and by noodlifications
+ * in the decision procedure (see ReductionPolicy).
+ */
+enum reduction_policy {
+    RP_DEFAULT,             // no reduction of concatenations, simulation reduction before noodlification
+    RP_NONE,
+    RP_TRIM,
+    RP_SIMULATION,
+    RP_MINIMIZE,
+    RP_ADAPTIVE,            // chosen by the number of states (see m_reduction_minimize_states and m_reduction_simulation_states)
+};
+
+/**
+ * @brief Selectors of the order of procedures tried before the main decision procedure (see ProcedureSelector).
+ */
+enum procedure_selector {
+    PS_FIXED,               // the fixed order (length-based procedure for equations only, Nielsen, length-based procedure, underapproximation)
+    PS_TABLE,               // the order given by the built-in table of instance features
+};
+
 struct theory_str_noodler_params {
    
     bool m_underapproximation = false;
@@ -11,8 +57,71 @@ struct theory_str_noodler_params {
     bool m_try_nielsen = false;
     bool m_try_length_proc = false;
     unsigned m_underapprox_length = 5;
+    unsigned m_underapprox_length_max = 0;
+    unsigned m_underapprox_round_time = 0;
+    // maximal number of disjuncts of the explicit encoding of digit words in conversions (0 means no limit)
+    unsigned m_interval_cases_limit = 1000;
     bool is_underapprox = false;
     bool m_try_length_proc = false;
+    unsigned m_dp_threads = 1;
+    inclusion_order m_inclusion_order = IO_GRAPH;
+    worklist_order m_worklist_order = WO_DEFAULT;
+    // number of processed states after which the cost of newly pushed states grows by one (best-first orders only)
+    unsigned m_worklist_aging = 16;
+    // prune solving states whose length bounds exclude the current arithmetic assignment
+    bool m_length_pruning = false;
+    // explore the solving states compatible with the current arithmetic assignment first
+    bool m_model_guided_noodles = true;
+    // satisfy acyclic inclusion graphs without length variables by shortest words before noodlification
+    bool m_shortest_witnesses = true;
+    bool m_alphabet_classes = false;
+    // budgets of the decision procedure for one final check (0 means no limit)
+    unsigned m_fc_time_budget = 0;
+    unsigned m_fc_max_solving_states = 0;
+    unsigned m_fc_max_aut_states = 0;
+    // approximate memory of the worklist of the decision procedure in megabytes
+    unsigned m_fc_max_memory = 0;
+    bool m_split_components = true;
+    // limit of predicted sizes of automata in optional preprocessing steps (0 means no limit)
+    unsigned m_prep_size_limit = 100000;
+    reduction_policy m_reduction_policy = RP_DEFAULT;
+    // thresholds of RP_ADAPTIVE: automata with at most this number of states are minimized/reduced by simulation
+    unsigned m_reduction_minimize_states = 30;
+    unsigned m_reduction_simulation_states = 5000;
+    // maximal depth of Nielsen graphs (0 means no limit), reached by iterative deepening
+    unsigned m_nielsen_max_depth = 0;
+    unsigned m_nielsen_threads = 1;
+    // the parallel paths give the same results as for one thread of the same seed (work is distributed in rounds)
+    bool m_deterministic = false;
+    bool m_portfolio = false;
+    // stochastic local search for words with the current lengths before the other procedures
+    bool m_sls = false;
+    unsigned m_sls_max_flips = 20000;
+    // maximal length of words of variables of instances solved by the bounded SAT encoding (0 means never)
+    unsigned m_bounded_length = 0;
+    procedure_selector m_procedure_selector = PS_FIXED;
+    bool m_lazy_axioms = false;
+    bool m_search_propagation = true;
+    // refute length formulas by difference constraints and divisibility before the arithmetic solver is called
+    bool m_len_presolve = true;
+    // weaken blocked length formulas to the conjuncts of their unsat cores
+    bool m_len_block_core = false;
+    // maximal number of decision procedure runs removing constraints from a string conflict (0 means no shrinking)
+    unsigned m_core_shrink_checks = 0;
+    // number of events kept in the event log (0 means no event log) and the file to which it is dumped
+    unsigned m_event_log_capacity = 0;
+    std::string m_event_log_file;
+    // directory to which the instances of final checks are recorded (empty means no recording)
+    std::string m_record_dir;
+    // caches shared by the string solvers of one ast manager and the memory limit of the cache of automata
+    bool m_session_caches = true;
+    unsigned m_nfa_cache_memory = 256;
+    // memory limit (in megabytes) of all caches together enforced by the cache governor of the session
+    unsigned m_cache_memory = 1024;
+    // size of the cache of the rewriter above which it is cleared on backtracking
+    unsigned m_rewrite_cache_size = 100000;
+    // file of automata of regexes used to warm-start the automata cache (empty means no file)
+    std::string m_nfa_cache_file;
 
     theory_str_noodler_params(params_ref const & p = params_ref()) {
         updt_params(p);
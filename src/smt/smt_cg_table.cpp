@@ -63,6 +63,92 @@ namespace smt {
         return true;
     }
 
+    unsigned cg_table::flat_table::find_idx(entry const & key, bool & comm) const {
+        if (m_entries.empty())
+            return UINT_MAX;
+        unsigned mask = m_entries.size() - 1;
+        for (unsigned i = key.m_hash & mask; ; i = (i + 1) & mask) {
+            entry const & e = m_entries[i];
+            if (!e.m_n)
+                return UINT_MAX;
+            if (e.m_n != deleted() && matches(e, key, comm))
+                return i;
+        }
+    }
+
+    void cg_table::flat_table::rehash(unsigned capacity) {
+        svector<entry> old;
+        old.swap(m_entries);
+        m_entries.resize(capacity, entry{ nullptr, nullptr, nullptr, 0 });
+        unsigned mask = capacity - 1;
+        for (entry const & e : old) {
+            if (!e.m_n || e.m_n == deleted())
+                continue;
+            unsigned i = e.m_hash & mask;
+            while (m_entries[i].m_n)
+                i = (i + 1) & mask;
+            m_entries[i] = e;
+        }
+        m_num_deleted = 0;
+    }
+
+    enode * cg_table::flat_table::insert_if_not_there(enode * n, bool & comm) {
+        entry key;
+        mk_key(n, key);
+        unsigned idx = find_idx(key, comm);
+        if (idx != UINT_MAX)
+            return m_entries[idx].m_n;
+        // keep the load, including deleted entries, below 3/4.
+        // The table grows if it is at least a quarter full, otherwise the deleted entries are purged.
+        if (4 * (m_size + m_num_deleted + 1) > 3 * m_entries.size()) {
+            unsigned capacity = m_entries.size();
+            if (capacity == 0)
+                capacity = 8;
+            else if (4 * (m_size + 1) > capacity)
+                capacity *= 2;
+            rehash(capacity);
+        }
+        unsigned mask = m_entries.size() - 1;
+        unsigned i = key.m_hash & mask;
+        while (m_entries[i].m_n && m_entries[i].m_n != deleted())
+            i = (i + 1) & mask;
+        if (m_entries[i].m_n == deleted())
+            --m_num_deleted;
+        m_entries[i] = key;
+        ++m_size;
+        return n;
+    }
+
+    bool cg_table::flat_table::find(enode * n, enode * & r) const {
+        entry key;
+        mk_key(n, key);
+        bool comm = false;
+        unsigned idx = find_idx(key, comm);
+        if (idx == UINT_MAX)
+            return false;
+        r = m_entries[idx].m_n;
+        return true;
+    }
+
+    void cg_table::flat_table::erase(enode * n) {
+        entry key;
+        mk_key(n, key);
+        bool comm = false;
+        unsigned idx = find_idx(key, comm);
+        if (idx == UINT_MAX)
+            return;
+        unsigned mask = m_entries.size() - 1;
+        if (!m_entries[(idx + 1) & mask].m_n) {
+            // no probe sequence continues after idx
+            m_entries[idx].m_n = nullptr;
+        }
+        else {
+            m_entries[idx].m_n = deleted();
+            ++m_num_deleted;
+        }
+        --m_size;
+    }
+
     cg_table::cg_table(ast_manager & m):
         m_manager(m) {
     }
@@ -76,7 +162,7 @@ namespace smt {
         SASSERT(d->get_arity() >= 1);
         switch (d->get_arity()) {
         case 1:
-            r = TAG(void*, alloc(unary_table), UNARY);
+            r = TAG(void*, alloc(flat_table, 1, false), UNARY);
             SASSERT(GET_TAG(r) == UNARY);
             return r;
         case 2:
@@ -87,12 +173,12 @@ namespace smt {
                 return r;
             }
             else if (d->is_commutative()) {
-                r = TAG(void*, alloc(comm_table, cg_comm_hash(), cg_comm_eq(m_commutativity)), BINARY_COMM);
+                r = TAG(void*, alloc(flat_table, 2, true), BINARY_COMM);
                 SASSERT(GET_TAG(r) == BINARY_COMM);
                 return r;
             }
             else {
-                r = TAG(void*, alloc(binary_table), BINARY);
+                r = TAG(void*, alloc(flat_table, 2, false), BINARY);
                 SASSERT(GET_TAG(r) == BINARY);
                 return r;
             }
@@ -126,13 +212,9 @@ namespace smt {
         for (void* t : m_tables) {
             switch (GET_TAG(t)) {
             case UNARY:
-                dealloc(UNTAG(unary_table*, t));
-                break;
             case BINARY:
-                dealloc(UNTAG(binary_table*, t));
-                break;
             case BINARY_COMM:
-                dealloc(UNTAG(comm_table*, t));
+                dealloc(UNTAG(flat_table*, t));
                 break;
             case NARY:
                 dealloc(UNTAG(table*, t));
@@ -168,7 +250,7 @@ namespace smt {
     }
 
     void cg_table::display_binary(std::ostream& out, void* t) const {
-        binary_table* tb = UNTAG(binary_table*, t);
+        flat_table* tb = UNTAG(flat_table*, t);
         out << "b ";
         for (enode* n : *tb) {
             out << n->get_owner_id() << " " << cg_binary_hash()(n) << " ";
@@ -177,7 +259,7 @@ namespace smt {
     }
     
     void cg_table::display_binary_comm(std::ostream& out, void* t) const {
-        comm_table* tb = UNTAG(comm_table*, t);
+        flat_table* tb = UNTAG(flat_table*, t);
         out << "bc ";
         for (enode* n : *tb) {
             out << n->get_owner_id() << " ";
@@ -186,7 +268,7 @@ namespace smt {
     }
     
     void cg_table::display_unary(std::ostream& out, void* t) const {
-        unary_table* tb = UNTAG(unary_table*, t);
+        flat_table* tb = UNTAG(flat_table*, t);
         out << "un ";
         for (enode* n : *tb) {
             out << n->get_owner_id() << " ";
@@ -213,16 +295,16 @@ namespace smt {
         void * t = get_table(n); 
         switch (static_cast<table_kind>(GET_TAG(t))) {
         case UNARY:
-            n_prime = UNTAG(unary_table*, t)->insert_if_not_there(n);
+            n_prime = UNTAG(flat_table*, t)->insert_if_not_there(n, m_commutativity);
             return enode_bool_pair(n_prime, false);
         case BINARY:
-            n_prime = UNTAG(binary_table*, t)->insert_if_not_there(n);
+            n_prime = UNTAG(flat_table*, t)->insert_if_not_there(n, m_commutativity);
             TRACE("cg_table", tout << "insert: " << n->get_owner_id() << " " << cg_binary_hash()(n) << " inserted: " << (n == n_prime) << " " << n_prime->get_owner_id() << "\n";
                   display_binary(tout, t); tout << "contains_ptr: " << contains_ptr(n) << "\n";); 
             return enode_bool_pair(n_prime, false);
         case BINARY_COMM:
             m_commutativity = false;
-            n_prime = UNTAG(comm_table*, t)->insert_if_not_there(n);
+            n_prime = UNTAG(flat_table*, t)->insert_if_not_there(n, m_commutativity);
             return enode_bool_pair(n_prime, m_commutativity);
         default:
             n_prime = UNTAG(table*, t)->insert_if_not_there(n);
@@ -235,14 +317,14 @@ namespace smt {
         void * t = get_table(n); 
         switch (static_cast<table_kind>(GET_TAG(t))) {
         case UNARY:
-            UNTAG(unary_table*, t)->erase(n);
+            UNTAG(flat_table*, t)->erase(n);
             break;
         case BINARY:
             TRACE("cg_table", tout << "erase: " << n->get_owner_id() << " " << cg_binary_hash()(n) << " contains: " << contains_ptr(n) << "\n";);
-            UNTAG(binary_table*, t)->erase(n);
+            UNTAG(flat_table*, t)->erase(n);
             break;
         case BINARY_COMM:
-            UNTAG(comm_table*, t)->erase(n);
+            UNTAG(flat_table*, t)->erase(n);
             break;
         default:
             UNTAG(table*, t)->erase(n);
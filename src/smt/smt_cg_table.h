@@ -7,7 +7,8 @@ Module Name:
 
 Abstract:
 
-    <abstract>
+    Congruence table: one table per function symbol, applications of unary and binary
+    symbols are kept in open addressing tables with the argument roots inline.
 
 Author:
 
@@ -39,17 +40,6 @@ namespace smt {
             }
         };
 
-        struct cg_unary_eq {
-            bool operator()(enode * n1, enode * n2) const {
-                SASSERT(n1->get_num_args() == 1);
-                SASSERT(n2->get_num_args() == 1);
-                SASSERT(n1->get_decl() == n2->get_decl());
-                return n1->get_arg(0)->get_root() == n2->get_arg(0)->get_root();
-            }
-        };
-
-        typedef chashtable<enode *, cg_unary_hash, cg_unary_eq> unary_table;
-        
         struct cg_binary_hash {
             unsigned operator()(enode * n) const {
                 SASSERT(n->get_num_args() == 2);
@@ -57,19 +47,6 @@ namespace smt {
             }
         };
 
-        struct cg_binary_eq {
-            bool operator()(enode * n1, enode * n2) const {
-                SASSERT(n1->get_num_args() == 2);
-                SASSERT(n2->get_num_args() == 2);
-                SASSERT(n1->get_decl() == n2->get_decl());
-                return 
-                    n1->get_arg(0)->get_root() == n2->get_arg(0)->get_root() &&
-                    n1->get_arg(1)->get_root() == n2->get_arg(1)->get_root();
-            }
-        };
-
-        typedef chashtable<enode*, cg_binary_hash, cg_binary_eq> binary_table;
-        
         struct cg_comm_hash {
             unsigned operator()(enode * n) const {
                 SASSERT(n->get_num_args() == 2);
@@ -81,29 +58,77 @@ namespace smt {
             }
         };
         
-        struct cg_comm_eq {
-            bool & m_commutativity;
-            cg_comm_eq(bool & c):m_commutativity(c) {}
-            bool operator()(enode * n1, enode * n2) const {
-                SASSERT(n1->get_num_args() == 2);
-                SASSERT(n2->get_num_args() == 2);
-                SASSERT(n1->get_decl() == n2->get_decl());
-                enode * c1_1 = n1->get_arg(0)->get_root();
-                enode * c1_2 = n1->get_arg(1)->get_root();
-                enode * c2_1 = n2->get_arg(0)->get_root();
-                enode * c2_2 = n2->get_arg(1)->get_root();
-                if (c1_1 == c2_1 && c1_2 == c2_2) {
-                    return true;
+        /**
+           \brief Open addressing table for applications of unary and binary function symbols.
+           Each entry keeps the roots of the arguments and the hash code inline, so probing does
+           not dereference the enodes. The roots of the arguments of an enode in the table do not 
+           change: the parents are erased before a merge (and its undo) and reinserted after it.
+        */
+        class flat_table {
+            struct entry {
+                enode *  m_n;
+                enode *  m_arg0;
+                enode *  m_arg1;
+                unsigned m_hash;
+            };
+
+            static enode * deleted() { return reinterpret_cast<enode*>(static_cast<size_t>(1)); }
+
+            svector<entry> m_entries;
+            unsigned       m_size = 0;
+            unsigned       m_num_deleted = 0;
+            unsigned       m_arity;
+            bool           m_comm;
+
+            void mk_key(enode * n, entry & e) const {
+                e.m_n = n;
+                e.m_arg0 = n->get_arg(0)->get_root();
+                if (m_arity == 1) {
+                    e.m_arg1 = nullptr;
+                    e.m_hash = cg_unary_hash()(n);
+                }
+                else {
+                    e.m_arg1 = n->get_arg(1)->get_root();
+                    e.m_hash = m_comm ? cg_comm_hash()(n) : cg_binary_hash()(n);
                 }
-                if (c1_1 == c2_2 && c1_2 == c2_1) {
-                    m_commutativity = true;
+            }
+
+            bool matches(entry const & e, entry const & key, bool & comm) const {
+                if (e.m_hash != key.m_hash)
+                    return false;
+                if (e.m_arg0 == key.m_arg0 && e.m_arg1 == key.m_arg1)
+                    return true;
+                if (m_comm && e.m_arg0 == key.m_arg1 && e.m_arg1 == key.m_arg0) {
+                    comm = true;
                     return true;
                 }
                 return false;
             }
-        };
 
-        typedef chashtable<enode*, cg_comm_hash, cg_comm_eq> comm_table;
+            // index of the entry matching key, or UINT_MAX
+            unsigned find_idx(entry const & key, bool & comm) const;
+            void rehash(unsigned capacity);
+
+        public:
+            flat_table(unsigned arity, bool comm): m_arity(arity), m_comm(comm) {}
+
+            enode * insert_if_not_there(enode * n, bool & comm);
+            bool find(enode * n, enode * & r) const;
+            bool contains(enode * n) const { enode * r; return find(n, r); }
+            void erase(enode * n);
+
+            class iterator {
+                entry const * m_it, * m_end;
+                void move_to_used() { while (m_it != m_end && (!m_it->m_n || m_it->m_n == deleted())) ++m_it; }
+            public:
+                iterator(entry const * it, entry const * end): m_it(it), m_end(end) { move_to_used(); }
+                enode * operator*() const { return m_it->m_n; }
+                iterator & operator++() { ++m_it; move_to_used(); return *this; }
+                bool operator!=(iterator const & other) const { return m_it != other.m_it; }
+            };
+            iterator begin() const { return iterator(m_entries.begin(), m_entries.end()); }
+            iterator end() const { return iterator(m_entries.end(), m_entries.end()); }
+        };
 
         struct cg_hash {
             unsigned operator()(enode * n) const;
@@ -157,11 +182,9 @@ namespace smt {
             void * t = const_cast<cg_table*>(this)->get_table(n); 
             switch (static_cast<table_kind>(GET_TAG(t))) {
             case UNARY:
-                return UNTAG(unary_table*, t)->contains(n);
             case BINARY:
-                return UNTAG(binary_table*, t)->contains(n);
             case BINARY_COMM:
-                return UNTAG(comm_table*, t)->contains(n);
+                return UNTAG(flat_table*, t)->contains(n);
             default:
                 return UNTAG(table*, t)->contains(n);
             }
@@ -173,11 +196,33 @@ namespace smt {
             void * t = const_cast<cg_table*>(this)->get_table(n); 
             switch (static_cast<table_kind>(GET_TAG(t))) {
             case UNARY:
-                return UNTAG(unary_table*, t)->find(n, r) ? r : nullptr;
             case BINARY:
-                return UNTAG(binary_table*, t)->find(n, r) ? r : nullptr;
             case BINARY_COMM:
-                return UNTAG(comm_table*, t)->find(n, r) ? r : nullptr;
+                return UNTAG(flat_table*, t)->find(n, r) ? r : nullptr;
+            default:
+                return UNTAG(table*, t)->find(n, r) ? r : nullptr;
+            }
+        }
+
+        /**
+           \brief Like find, but does not register the function symbol of n if the table has not seen it,
+           so concurrent readers can use it while the table is not modified.
+        */
+        enode * find_registered(enode * n) const {
+            SASSERT(n->get_num_args() > 0);
+            unsigned tid = n->get_func_decl_id();
+            if (tid == UINT_MAX) {
+                if (!m_func_decl2id.find(n->get_decl(), tid))
+                    return nullptr;
+                n->set_func_decl_id(tid);
+            }
+            enode * r = nullptr;
+            void * t = m_tables[tid];
+            switch (static_cast<table_kind>(GET_TAG(t))) {
+            case UNARY:
+            case BINARY:
+            case BINARY_COMM:
+                return UNTAG(flat_table*, t)->find(n, r) ? r : nullptr;
             default:
                 return UNTAG(table*, t)->find(n, r) ? r : nullptr;
             }
@@ -189,11 +234,9 @@ namespace smt {
             void * t = const_cast<cg_table*>(this)->get_table(n); 
             switch (static_cast<table_kind>(GET_TAG(t))) {
             case UNARY:
-                return UNTAG(unary_table*, t)->find(n, r) && n == r;
             case BINARY:
-                return UNTAG(binary_table*, t)->find(n, r) && n == r;
             case BINARY_COMM:
-                return UNTAG(comm_table*, t)->find(n, r) && n == r;
+                return UNTAG(flat_table*, t)->find(n, r) && n == r;
             default:
                 return UNTAG(table*, t)->find(n, r) && n == r;
             }
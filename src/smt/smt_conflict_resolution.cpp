@@ -521,8 +521,10 @@ namespace smt {
             case b_justification::CLAUSE: {
                 clause * cls = js.get_clause();
                 TRACE("conflict_smt2", m_ctx.display_clause_smt2(tout, *cls););
-                if (cls->is_lemma())
+                if (cls->is_lemma()) {
                     cls->inc_clause_activity();
+                    m_ctx.update_glue(cls);
+                }
                 unsigned num_lits = cls->get_num_literals();
                 unsigned i        = 0;
                 if (consequent != false_literal) {
@@ -643,11 +645,19 @@ namespace smt {
     bool conflict_resolution::process_antecedent_for_minimization(literal antecedent) {
         bool_var var = antecedent.var();
         unsigned lvl = m_ctx.get_assign_level(var);
-        if (!m_ctx.is_marked(var) && lvl > m_ctx.get_base_level()) {
+        if (lvl <= m_ctx.get_base_level() || is_min_cached(var))
+            return true;
+        if (m_ctx.is_marked(var)) {
+            if (var >= m_min_visited.size() || m_min_visited[var] != m_min_stamp)
+                m_min_used_marks = true;
+        }
+        else {
             if (m_lvl_set.may_contain(lvl)) {
                 m_ctx.set_mark(var);
                 m_unmark.push_back(var);
                 m_lemma_min_stack.push_back(var);
+                m_min_visited.reserve(var + 1, 0);
+                m_min_visited[var] = m_min_stamp;
             }
             else {
                 return false;
@@ -663,12 +673,39 @@ namespace smt {
         // The method unmark_justifications must be invoked to reset these caches.
         // Remark: The method reset_unmark_and_justifications invokes unmark_justifications.
         justification2literals_core(js, antecedents);
-        for (literal l : antecedents) 
-            if (!process_antecedent_for_minimization(l))
+        // Theory explanations are large: reject them before any antecedent is marked.
+        unsigned base_lvl = m_ctx.get_base_level();
+        for (literal l : antecedents) {
+            unsigned lvl = m_ctx.get_assign_level(l);
+            if (lvl > base_lvl && !m_lvl_set.may_contain(lvl) && !m_ctx.is_marked(l.var()) && !is_min_cached(l.var()))
                 return false;
+        }
+        for (literal l : antecedents) 
+            VERIFY(process_antecedent_for_minimization(l));
         return true;
     }
 
+    void conflict_resolution::min_cache(bool_var v) {
+        m_min_cache.reserve(v + 1, false);
+        if (m_min_cache[v])
+            return;
+        m_min_cache[v] = true;
+        unsigned lvl = m_ctx.get_assign_level(v);
+        m_min_cache_lim.reserve(lvl + 1);
+        m_min_cache_lim[lvl].push_back(v);
+    }
+
+    /**
+       \brief Invalidate the minimization cache entries of variables assigned above new_lvl.
+    */
+    void conflict_resolution::pop_scope(unsigned new_lvl) {
+        for (unsigned lvl = new_lvl + 1; lvl < m_min_cache_lim.size(); ++lvl) {
+            for (bool_var v : m_min_cache_lim[lvl])
+                m_min_cache[v] = false;
+            m_min_cache_lim[lvl].reset();
+        }
+    }
+
     /**
        \brief Return true if lit is implied by other marked literals
        and/or literals assigned at the base level.
@@ -677,10 +714,17 @@ namespace smt {
        as soon as we find a literal assigned in a level that is not in lvl_set.
     */
     bool conflict_resolution::implied_by_marked(literal lit) {
+        if (is_min_cached(lit.var()))
+            return true;
         m_lemma_min_stack.reset();  // avoid recursive function
         m_lemma_min_stack.push_back(lit.var());
         unsigned old_size     = m_unmark.size();
         unsigned old_js_qhead = m_todo_js_qhead;
+        m_min_used_marks      = false;
+        if (++m_min_stamp == 0) {
+            m_min_visited.reset();
+            m_min_stamp = 1;
+        }
 
         while (!m_lemma_min_stack.empty()) {
             bool_var var       = m_lemma_min_stack.back();
@@ -730,6 +774,12 @@ namespace smt {
                 break;
             }
         }
+        if (!m_min_used_marks) {
+            // the traversal reached only base level literals: the visited literals are redundant in later conflicts too.
+            min_cache(lit.var());
+            for (unsigned i = old_size; i < m_unmark.size(); ++i)
+                min_cache(m_unmark[i]);
+        }
         return true;
     }
 
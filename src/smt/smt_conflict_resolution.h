@@ -117,6 +117,10 @@ namespace smt {
                 js->set_mark();
                 m_todo_js.push_back(js);
             }
+            else {
+                // the antecedents of js may rely on marks of an earlier traversal
+                m_min_used_marks = true;
+            }
         }
 
         void mark_eq(enode * n1, enode * n2) {
@@ -130,6 +134,9 @@ namespace smt {
                     m_todo_eqs.push_back(p);
                     SASSERT(m_already_processed_eqs.contains(p));
                 }
+                else {
+                    m_min_used_marks = true;
+                }
             }
         }
 
@@ -158,6 +165,7 @@ namespace smt {
         void mk_proof(enode * lhs, enode * rhs, ptr_buffer<proof> & result);
         void mk_proof(enode * lhs, enode * rhs);
         void reset();
+        void pop_scope(unsigned new_lvl);
         void mk_conflict_proof(b_justification conflict, literal not_l);
 
     protected:
@@ -182,6 +190,15 @@ namespace smt {
         bool_var_vector m_unmark;
         bool_var_vector m_lemma_min_stack;
         level_approx_set m_lvl_set;
+        // Cross-conflict cache of literals implied by base level literals only. Such literals are
+        // redundant in every lemma, the entry of a variable is valid until its assignment is undone.
+        svector<char>   m_min_cache;
+        vector<bool_var_vector> m_min_cache_lim; //!< cached variables by assignment level
+        unsigned_vector m_min_visited;           //!< stamp of the implied_by_marked traversal visiting the variable
+        unsigned        m_min_stamp = 0;
+        bool            m_min_used_marks = false;
+        bool is_min_cached(bool_var v) const { return v < m_min_cache.size() && m_min_cache[v]; }
+        void min_cache(bool_var v);
         level_approx_set get_lemma_approx_level_set();
         void reset_unmark(unsigned old_size);
         void reset_unmark_and_justifications(unsigned old_size, unsigned old_js_qhead);
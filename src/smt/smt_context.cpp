@@ -42,6 +42,7 @@ Revision History:
 #include "smt/smt_model_checker.h"
 #include "smt/smt_model_finder.h"
 #include "smt/smt_parallel.h"
+#include "smt/smt_distributed.h"
 #include "smt/smt_arith_value.h"
 #include <iostream>
 
@@ -120,7 +121,7 @@ namespace smt {
         return std::min(m_relevancy_lvl, m_fparams.m_relevancy_lvl);
     }
 
-    void context::copy(context& src_ctx, context& dst_ctx, bool override_base) {
+    void context::copy(context& src_ctx, context& dst_ctx, bool override_base, bool internalize) {
         ast_manager& dst_m = dst_ctx.get_manager();
         ast_manager& src_m = src_ctx.get_manager();
         src_ctx.pop_to_base_lvl();
@@ -171,8 +172,12 @@ namespace smt {
             dst_ctx.assert_expr(fml1);
         }
 
-        dst_ctx.setup_context(dst_ctx.m_fparams.m_auto_config);
-        dst_ctx.internalize_assertions();
+        // registered expressions of a user propagator are copied after the assertions are internalized
+        SASSERT(internalize || !src_ctx.m_user_propagator);
+        if (internalize) {
+            dst_ctx.setup_context(dst_ctx.m_fparams.m_auto_config);
+            dst_ctx.internalize_assertions();
+        }
         
         dst_ctx.copy_user_propagator(src_ctx, true);
 
@@ -181,6 +186,42 @@ namespace smt {
               dst_ctx.display(tout););
     }
 
+    void context::get_snapshot(context_snapshot & s, bool include_assignments) {
+        s.reset();
+        s.m_num_conflicts = m_stats.m_num_conflicts;
+        expr_mark asserted;
+        for (unsigned i = 0; i < get_num_asserted_formulas(); ++i) {
+            expr * f = get_asserted_formula(i);
+            if (m.is_true(f) || asserted.is_marked(f))
+                continue;
+            asserted.mark(f);
+            s.m_asserted.push_back(f);
+        }
+        if (!include_assignments)
+            return;
+        unsigned num_base = m_scope_lvl == m_base_lvl ? m_assigned_literals.size() : m_scopes[m_base_lvl].m_assigned_literals_lim;
+        expr_ref e(m);
+        for (unsigned i = 0; i < m_assigned_literals.size(); ++i) {
+            literal lit = m_assigned_literals[i];
+            if (lit.var() == true_bool_var || !is_relevant(lit))
+                continue;
+            literal2expr(lit, e);
+            if (asserted.is_marked(e))
+                continue;
+            (i < num_base ? s.m_units : s.m_assigns).push_back(e);
+        }
+    }
+
+    void context::assert_snapshot(context_snapshot const & s, bool include_assignments) {
+        for (expr * f : s.m_asserted)
+            assert_expr(f);
+        for (expr * u : s.m_units)
+            assert_expr(u);
+        if (include_assignments)
+            for (expr * a : s.m_assigns)
+                assert_expr(a);
+    }
+
     context::~context() {
         flush();
         m_asserted_formulas.finalize();
@@ -1592,7 +1633,7 @@ namespace smt {
             if (fid != m.get_basic_family_id()) {
                 theory * th = get_theory(fid);
                 if (th != nullptr) {
-                    th->relevant_eh(to_app(n));
+                    theory_relevant_eh(th, to_app(n));
                     propagated_th = th; // <<< mark that relevancy_eh was already invoked for theory th.
                 }
             }
@@ -1605,13 +1646,41 @@ namespace smt {
                     theory *   th    = get_theory(th_id);
                     // I don't want to invoke relevant_eh twice for the same n.
                     if (th != propagated_th)
-                        th->relevant_eh(to_app(n));
+                        theory_relevant_eh(th, to_app(n));
                     l = l->get_next();
                 }
             }
         }
     }
 
+    void context::theory_relevant_eh(theory * th, app * n) {
+        if (!th->use_relevant_batch()) {
+            th->relevant_eh(n);
+            return;
+        }
+        theory_id id = th->get_id();
+        m_relevant_batch.reserve(id + 1);
+        if (m_relevant_batch[id].empty())
+            m_relevant_batch_ths.push_back(id);
+        m_relevant_batch[id].push_back(n);
+    }
+
+    /**
+       \brief Invoke relevant_batch_eh of the theories with pending relevant applications.
+       The handlers may mark further expressions as relevant, they are processed in the next round.
+    */
+    void context::flush_relevant_batch() {
+        ptr_vector<app> batch;
+        while (!m_relevant_batch_ths.empty() && !inconsistent()) {
+            theory_id id = m_relevant_batch_ths.back();
+            m_relevant_batch_ths.pop_back();
+            batch.reset();
+            batch.swap(m_relevant_batch[id]);
+            TRACE("propagate_relevancy", tout << "relevant batch of theory " << id << ": " << batch.size() << "\n";);
+            get_theory(id)->relevant_batch_eh(batch.size(), batch.data());
+        }
+    }
+
     /**
        \brief Propagate relevancy using the queue of new assigned literals
        located at [qhead, m_assigned_literals.size()).
@@ -1629,6 +1698,10 @@ namespace smt {
             m_relevancy_propagator->assign_eh(n, !l.sign());
         }
         m_relevancy_propagator->propagate();
+        while (!m_relevant_batch_ths.empty() && !inconsistent()) {
+            flush_relevant_batch();
+            m_relevancy_propagator->propagate();
+        }
     }
 
     bool context::propagate_theories() {
@@ -1680,6 +1753,7 @@ namespace smt {
             m_qhead != m_assigned_literals.size() ||
             m_relevancy_propagator->can_propagate() ||
             !m_atom_propagation_queue.empty() ||
+            !m_relevant_batch_ths.empty() ||
             m_qmanager->can_propagate() ||
             can_theories_propagate() ||
             !m_eq_propagation_queue.empty() ||
@@ -1927,6 +2001,9 @@ namespace smt {
         if (m.has_trace_stream() && !m_is_auxiliary)
             m.trace_stream() << "[push] " << m_scope_lvl << "\n";
 
+        // applications marked as relevant in this scope must be handled before it is left
+        flush_relevant_batch();
+
         m_scope_lvl++;
         m_region.push_scope();
         m_scopes.push_back(scope());
@@ -2455,8 +2532,12 @@ namespace smt {
             m_th_eq_propagation_queue.reset();
             m_th_diseq_propagation_queue.reset();
             m_atom_propagation_queue.reset();
+            for (theory_id id : m_relevant_batch_ths)
+                m_relevant_batch[id].reset();
+            m_relevant_batch_ths.reset();
             m_region.pop_scope(num_scopes);
             m_scopes.shrink(new_lvl);
+            m_conflict_resolution->pop_scope(new_lvl);
             m_conflict_resolution->reset();
 
             m_scope_lvl = new_lvl;
@@ -2718,6 +2799,8 @@ namespace smt {
     inline void context::del_inactive_lemmas() {
         if (m_fparams.m_lemma_gc_strategy == LGC_NONE)
             return;
+        else if (m_fparams.m_lemma_gc_tiered)
+            del_inactive_lemmas3();
         else if (m_fparams.m_lemma_gc_half)
             del_inactive_lemmas1();
         else
@@ -2833,6 +2916,100 @@ namespace smt {
         IF_VERBOSE(2, verbose_stream() << " :num-deleted-clauses " << num_del_cls << ")" << std::endl;);
     }
 
+    /**
+       \brief Delete lemmas by tiers of glue. Lemmas with glue at most m_lemma_gc_core_glue are kept,
+       lemmas with glue at most m_lemma_gc_tier2_glue are kept if they were used in a conflict since the 
+       last collection and are demoted otherwise, and the less active half of the remaining lemmas is deleted.
+       Recent lemmas are kept. The deleted lemmas are removed from the watch lists in one pass per watch list.
+    */
+    void context::del_inactive_lemmas3() {
+        unsigned sz            = m_lemmas.size();
+        unsigned start_at      = m_base_lvl == 0 ? 0 : m_base_scopes[m_base_lvl - 1].m_lemmas_lim;
+        SASSERT(start_at <= sz);
+        if (start_at + m_fparams.m_recent_lemmas_size >= sz)
+            return;
+        IF_VERBOSE(2, verbose_stream() << "(smt.delete-inactive-lemmas"; verbose_stream().flush(););
+        unsigned end_at        = sz - m_fparams.m_recent_lemmas_size;
+        unsigned core_glue     = m_fparams.m_lemma_gc_core_glue;
+        unsigned tier2_glue    = std::max(core_glue, m_fparams.m_lemma_gc_tier2_glue);
+        clause_vector local, to_delete;
+        unsigned num_core = 0, num_tier2 = 0;
+        for (unsigned i = start_at; i < end_at; ++i) {
+            clause * cls = m_lemmas[i];
+            if (cls->deleted() && can_delete(cls)) 
+                to_delete.push_back(cls);
+            else if (cls->get_glue() <= core_glue) 
+                ++num_core;
+            else if (cls->get_glue() <= tier2_glue) {
+                // the activity counts the uses since the last collection
+                if (cls->get_activity() == 0)
+                    cls->set_glue(tier2_glue + 1);
+                cls->set_activity(0);
+                ++num_tier2;
+            }
+            else 
+                local.push_back(cls);
+        }
+        std::stable_sort(local.begin(), local.end(), clause_lt());
+        for (unsigned i = local.size() / 2; i < local.size(); ++i)
+            if (can_delete(local[i]))
+                to_delete.push_back(local[i]);
+        for (clause* cls : local) 
+            cls->set_activity(cls->get_activity() / std::max(1u, m_fparams.m_clause_decay));
+
+        uint_set watches;
+        for (clause* cls : to_delete) {
+            m_clause_proof.del(*cls);
+            if (!cls->deleted()) {
+                remove_lit_occs(*cls, get_num_bool_vars());
+                cls->mark_as_deleted(m);
+                watches.insert((~cls->get_literal(0)).index());
+                watches.insert((~cls->get_literal(1)).index());
+            }
+        }
+        for (unsigned w : watches) 
+            m_watches[w].remove_deleted();
+
+        unsigned j = start_at;
+        for (unsigned i = start_at; i < sz; ++i) {
+            clause * cls = m_lemmas[i];
+            if (!cls->deleted() || !can_delete(cls)) 
+                m_lemmas[j++] = cls;
+            else if (i >= end_at) 
+                del_clause(true, cls); // recent lemma marked for deletion before
+        }
+        m_lemmas.shrink(j);
+        for (clause* cls : to_delete) 
+            cls->deallocate(m);
+        m_stats.m_num_del_clause += to_delete.size();
+        IF_VERBOSE(2, verbose_stream() << " :core " << num_core << " :tier2 " << num_tier2 << " :local " << local.size() 
+                   << " :num-deleted-clauses " << to_delete.size() << ")" << std::endl;);
+    }
+
+    /**
+       \brief Return the number of distinct decision levels of the assigned literals in lits (LBD).
+    */
+    unsigned context::compute_glue(unsigned num_lits, literal const* lits) {
+        if (++m_glue_stamp_id == 0) {
+            m_glue_stamp.fill(0);
+            m_glue_stamp_id = 1;
+        }
+        unsigned glue = 0;
+        for (unsigned i = 0; i < num_lits; ++i) {
+            literal l = lits[i];
+            if (get_assignment(l) == l_undef)
+                continue;
+            unsigned lvl = get_assign_level(l);
+            if (lvl >= m_glue_stamp.size())
+                m_glue_stamp.resize(lvl + 1, 0);
+            if (m_glue_stamp[lvl] != m_glue_stamp_id) {
+                m_glue_stamp[lvl] = m_glue_stamp_id;
+                ++glue;
+            }
+        }
+        return glue;
+    }
+
     /**
        \brief Return true if "cls" has more than (or equal to) k unassigned literals.
     */
@@ -3553,6 +3730,11 @@ namespace smt {
         SASSERT(!m_setup.already_configured());
         setup_context(m_fparams.m_auto_config);
 
+        if (m_fparams.m_distributed_dir.is_non_empty_string() && !m.has_trace_stream()) {
+            distributed d(*this);
+            expr_ref_vector asms(m);
+            return d(asms);
+        }
         if (m_fparams.m_threads > 1 && !m.has_trace_stream()) {
             parallel p(*this);
             expr_ref_vector asms(m);
@@ -3618,6 +3800,11 @@ namespace smt {
         if (!check_preamble(reset_cancel)) return l_undef;
         SASSERT(at_base_level());
         setup_context(false);
+        if (m_fparams.m_distributed_dir.is_non_empty_string() && !m.has_trace_stream()) {
+            expr_ref_vector asms(m, num_assumptions, assumptions);
+            distributed d(*this);
+            return d(asms);
+        }
         if (m_fparams.m_threads > 1 && !m.has_trace_stream()) {            
             expr_ref_vector asms(m, num_assumptions, assumptions);
             parallel p(*this);
@@ -3960,13 +4147,7 @@ namespace smt {
                 return true;
             }
 
-            if (m_progress_callback) {
-                m_progress_callback->fast_progress_sample();
-                if (m_fparams.m_progress_sampling_freq > 0 && m_timer.ms_timeout(m_next_progress_sample + 1)) {
-                    m_progress_callback->slow_progress_sample();
-                    m_next_progress_sample = (unsigned)(m_timer.get_seconds() * 1000) + m_fparams.m_progress_sampling_freq;
-                }
-            }
+            sample_progress();
         }
 
         if (get_cancel_flag()) {
@@ -3982,6 +4163,16 @@ namespace smt {
         return false;
     }
 
+    void context::sample_progress() {
+        if (!m_progress_callback)
+            return;
+        m_progress_callback->fast_progress_sample();
+        if (m_fparams.m_progress_sampling_freq > 0 && m_timer.ms_timeout(m_next_progress_sample + 1)) {
+            m_progress_callback->slow_progress_sample();
+            m_next_progress_sample = (unsigned)(m_timer.get_seconds() * 1000) + m_fparams.m_progress_sampling_freq;
+        }
+    }
+
     final_check_status context::final_check() {
         TRACE("final_check", tout << "final_check inconsistent: " << inconsistent() << "\n"; display(tout); display_normalized_enodes(tout););
         CASSERT("relevancy", check_relevancy());
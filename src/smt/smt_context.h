@@ -65,6 +65,22 @@ namespace smt {
 
     struct cancel_exception {};
 
+    /**
+       \brief Snapshot of a context used to start side queries (see context::get_snapshot).
+
+       Only expressions are stored: a sub-solver asserts them (context::assert_snapshot)
+       instead of the original problem. Theory state, e.g. bounds derived by arithmetic,
+       is exported through the assigned theory atoms.
+    */
+    struct context_snapshot {
+        expr_ref_vector m_asserted;  //!< asserted formulas
+        expr_ref_vector m_units;     //!< relevant literals assigned at the base level
+        expr_ref_vector m_assigns;   //!< relevant literals assigned above the base level
+        unsigned        m_num_conflicts = 0; //!< number of conflicts of the context when the snapshot was taken
+        context_snapshot(ast_manager& m): m_asserted(m), m_units(m), m_assigns(m) {}
+        void reset() { m_asserted.reset(); m_units.reset(); m_assigns.reset(); m_num_conflicts = 0; }
+    };
+
     struct enode_pp {
         context const& ctx;
         enode*   n;
@@ -75,6 +91,7 @@ namespace smt {
         friend class model_generator;
         friend class lookahead;
         friend class parallel;
+        friend class distributed;
     public:
         statistics                  m_stats;
 
@@ -208,6 +225,8 @@ namespace smt {
 
 
         literal_vector              m_atom_propagation_queue;
+        vector<ptr_vector<app>>     m_relevant_batch;     // theory id -> applications waiting for relevant_batch_eh
+        svector<theory_id>          m_relevant_batch_ths; // theories with a non-empty batch
 
         obj_map<expr, unsigned>     m_cached_generation;
         obj_hashtable<expr>         m_cache_generation_visited;
@@ -757,6 +776,9 @@ namespace smt {
         svector<expr_bool_pair> ts_todo;
         char_vector       tcolors;
         char_vector       fcolors;
+        unsigned_vector   ts_colored;  //!< ids of the expressions colored by top_sort_expr, they are reset to White afterwards.
+
+        void reserve_internalization(unsigned num_bool_vars, unsigned max_expr_id);
 
         bool should_internalize_rec(expr* e) const;
 
@@ -1152,6 +1174,8 @@ namespace smt {
 
         enode * get_enode_eq_to(func_decl * f, unsigned num_args, enode * const * args);
 
+        cg_table const & get_cg_table() const { return m_cg_table; }
+
         bool guess(bool_var var, lbool phase);
 
     protected:
@@ -1211,6 +1235,22 @@ namespace smt {
 
         void del_inactive_lemmas2();
 
+        void del_inactive_lemmas3();
+
+        unsigned_vector m_glue_stamp;
+        unsigned        m_glue_stamp_id = 0;
+
+        unsigned compute_glue(unsigned num_lits, literal const* lits);
+
+    public:
+        void update_glue(clause* cls) {
+            unsigned glue = compute_glue(cls->get_num_literals(), cls->begin());
+            if (glue < cls->get_glue()) 
+                cls->set_glue(glue);
+        }
+
+    protected:
+
         bool more_than_k_unassigned_literals(clause * cls, unsigned k);
 
 
@@ -1285,6 +1325,10 @@ namespace smt {
         // event handler for relevancy_propagator class
         void relevant_eh(expr * n);
 
+        void theory_relevant_eh(theory * th, app * n);
+
+        void flush_relevant_batch();
+
         bool is_relevant(expr * n) const {
             return !relevancy() || is_relevant_core(n);
         }
@@ -1615,7 +1659,23 @@ namespace smt {
         */
         context * mk_fresh(symbol const * l = nullptr,  smt_params * smtp = nullptr, params_ref const & p = params_ref());
 
-        static void copy(context& src, context& dst, bool override_base = false);
+        /**
+           \brief Copy the assertions of src into dst. If internalize is false, the configuration and
+           internalization of dst is left to the caller (it only touches dst, so it can run on dst's thread).
+        */
+        static void copy(context& src, context& dst, bool override_base = false, bool internalize = true);
+
+        /**
+           \brief Export the asserted formulas and the relevant assigned literals (if include_assignments)
+           to s. Literals equal to an asserted formula are not exported again.
+        */
+        void get_snapshot(context_snapshot & s, bool include_assignments = true);
+
+        /**
+           \brief Assert the formulas of a snapshot taken from a context over the same manager.
+           The assignments above the base level are asserted only if include_assignments.
+        */
+        void assert_snapshot(context_snapshot const & s, bool include_assignments = true);
 
         /**
            \brief Translate context to use new manager m.
@@ -1655,6 +1715,13 @@ namespace smt {
 
         bool resource_limits_exceeded();
 
+        /**
+           \brief Report a progress sample to the progress callback, the slow sample
+           only if smt.progress_sampling_freq milliseconds passed since the last one.
+           Theories call it during long final checks.
+        */
+        void sample_progress();
+
         failure get_last_search_failure() const;
 
         proof * get_proof();
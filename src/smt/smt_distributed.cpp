@@ -0,0 +1,450 @@
+/*++
+
+Module Name:
+
+    smt_distributed.cpp
+
+Abstract:
+
+    Distributed cube-and-conquer for the SMT core.
+
+--*/
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
+#include "util/rlimit.h"
+#include "ast/ast_util.h"
+#include "ast/ast_translation.h"
+#include "ast/ast_serialize.h"
+#include "smt/smt_distributed.h"
+#include "smt/smt_lookahead.h"
+
+namespace smt {
+
+    namespace fs = std::filesystem;
+
+    namespace {
+
+        void sleep_a_bit() {
+#ifndef SINGLE_THREAD
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+        }
+
+        std::string mk_tag(unsigned i) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            return std::to_string(static_cast<unsigned long long>(now)) + "-" + std::to_string(i);
+        }
+
+        bool starts_with(std::string const& s, std::string const& prefix) {
+            return s.compare(0, prefix.size(), prefix) == 0;
+        }
+
+        bool ends_with(std::string const& s, std::string const& suffix) {
+            return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        void write_file(fs::path const& p, std::string const& content, std::string const& tag) {
+            fs::path tmp = p;
+            tmp += ".tmp." + tag;
+            {
+                std::ofstream out(tmp, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+                out << content;
+            }
+            std::error_code ec;
+            fs::rename(tmp, p, ec);
+        }
+
+        bool read_file(fs::path const& p, std::string& content) {
+            std::ifstream in(p, std::ios_base::in | std::ios_base::binary);
+            if (!in)
+                return false;
+            std::ostringstream buf;
+            buf << in.rdbuf();
+            content = buf.str();
+            return true;
+        }
+
+        /**
+           \brief a file is a header line followed by serialized expressions.
+        */
+        std::string encode(ast_manager& m, std::string const& header, expr_ref_vector const& es) {
+            std::ostringstream out;
+            out << header << "\n";
+            serialize_exprs(m, es.size(), es.data(), out);
+            return out.str();
+        }
+
+        void decode(ast_manager& m, std::string const& content, std::string& header, expr_ref_vector& es) {
+            size_t nl = content.find('\n');
+            if (nl == std::string::npos)
+                throw default_exception("malformed distributed cube file");
+            header = content.substr(0, nl);
+            es.reset();
+            deserialize_exprs(m, content.data() + nl + 1, content.size() - nl - 1, es);
+        }
+
+        enum class outcome { unsat, unknown, sat, split, canceled };
+
+    }
+
+    /**
+       \brief a worker, with its own manager and context for the assertions of the base file.
+    */
+    class distributed::worker {
+        fs::path              m_dir;
+        std::string           m_tag;
+        ast_manager           m;
+        smt_params            m_fparams;
+        params_ref            m_params;
+        scoped_ptr<context>   m_ctx;
+        unsigned              m_max_conflicts;
+        unsigned              m_cube_frequency;
+        unsigned              m_share_size;
+        expr_ref_vector       m_lemmas;     // lemmas exported by this worker
+        expr_ref_vector       m_imported;
+        obj_hashtable<expr>   m_imported_set;
+
+        void add_lemma(expr_ref_vector const& core) {
+            m_ctx->pop_to_base_lvl();
+            expr_ref lemma = mk_not(mk_and(core));
+            m_ctx->assert_expr(lemma);
+            if (core.size() > m_share_size)
+                return;
+            m_lemmas.push_back(lemma);
+            m_imported_set.insert(lemma);
+            m_imported.push_back(lemma);
+            write_file(m_dir / ("lemmas." + m_tag), encode(m, "lemmas", m_lemmas), m_tag);
+        }
+
+        void import_lemmas() {
+            std::error_code ec;
+            std::string content, header;
+            expr_ref_vector es(m);
+            m_ctx->pop_to_base_lvl();
+            for (auto const& e : fs::directory_iterator(m_dir, ec)) {
+                std::string name = e.path().filename().string();
+                if (!starts_with(name, "lemmas.") || name.find(".tmp.") != std::string::npos || name == "lemmas." + m_tag)
+                    continue;
+                if (!read_file(e.path(), content))
+                    continue;
+                decode(m, content, header, es);
+                for (expr* l : es) {
+                    if (m_imported_set.contains(l))
+                        continue;
+                    m_imported_set.insert(l);
+                    m_imported.push_back(l);
+                    m_ctx->assert_expr(l);
+                }
+            }
+        }
+
+    public:
+        unsigned m_num_cubes = 0;
+        unsigned m_num_splits = 0;
+
+        worker(context& src, fs::path const& dir, std::string const& tag):
+            m_dir(dir),
+            m_tag(tag),
+            m(src.get_manager(), true),
+            m_fparams(src.get_fparams()),
+            m_params(src.get_params()),
+            m_lemmas(m),
+            m_imported(m) {
+            m_fparams.m_threads = 1;
+            m_fparams.m_distributed_dir = symbol::null;
+            m_fparams.m_distributed_worker = false;
+            m_max_conflicts = std::max(1u, m_fparams.m_threads_max_conflicts);
+            m_cube_frequency = std::max(1u, m_fparams.m_threads_cube_frequency);
+            m_share_size = m_fparams.m_threads_share_size;
+        }
+
+        ast_manager& get_manager() { return m; }
+
+        bool load_base() {
+            std::string content, header;
+            if (!read_file(m_dir / "base", content))
+                return false;
+            expr_ref_vector fmls(m);
+            decode(m, content, header, fmls);
+            m_ctx = alloc(context, m, m_fparams, m_params);
+            for (expr* f : fmls)
+                m_ctx->assert_expr(f);
+            return true;
+        }
+
+        /**
+           \brief solve cube under a doubling conflict budget.
+           With split_first, the cube is split as soon as the first budget is exhausted.
+        */
+        outcome solve(expr_ref_vector const& cube, bool split_first, vector<expr_ref_vector>& children, expr_ref_vector& eqs) {
+            children.reset();
+            eqs.reset();
+            import_lemmas();
+            ++m_num_cubes;
+            unsigned budget = m_max_conflicts;
+            for (unsigned rounds = 1; ; ++rounds) {
+                m_fparams.m_max_conflicts = budget;
+                lbool r = m_ctx->check(cube.size(), cube.data());
+                if (!m.inc())
+                    return outcome::canceled;
+                if (r == l_undef && m_ctx->get_num_conflicts() >= budget) {
+                    if (split_first || rounds % m_cube_frequency == 0) {
+                        m_ctx->pop_to_base_lvl();
+                        lookahead lh(*m_ctx);
+                        expr_ref c = lh.choose();
+                        if (c) {
+                            children.push_back(cube);
+                            children.back().push_back(c);
+                            children.push_back(cube);
+                            children.back().push_back(m.mk_not(c));
+                            ++m_num_splits;
+                            IF_VERBOSE(2, verbose_stream() << "(smt.distributed :split " << cube.size() << ")\n";);
+                            return outcome::split;
+                        }
+                    }
+                    budget = budget > UINT_MAX / 2 ? UINT_MAX : 2 * budget;
+                    continue;
+                }
+                switch (r) {
+                case l_false:
+                    add_lemma(m_ctx->unsat_core());
+                    return outcome::unsat;
+                case l_true: {
+                    model_ref mdl;
+                    m_ctx->get_model(mdl);
+                    if (mdl) {
+                        for (unsigned i = 0; i < mdl->get_num_constants(); ++i) {
+                            func_decl* f = mdl->get_constant(i);
+                            expr* v = mdl->get_const_interp(f);
+                            // elements of uninterpreted sorts have no meaning outside of the model
+                            if (v && m.is_value(v) && !m.is_uninterp(f->get_range()))
+                                eqs.push_back(m.mk_eq(m.mk_const(f), v));
+                        }
+                    }
+                    return outcome::sat;
+                }
+                default:
+                    return outcome::unknown;
+                }
+            }
+        }
+
+        /**
+           \brief claim and solve a cube of the directory, returns false if there was none.
+        */
+        bool step() {
+            std::error_code ec;
+            fs::path run;
+            std::string id;
+            for (auto const& e : fs::directory_iterator(m_dir, ec)) {
+                std::string name = e.path().filename().string();
+                if (!starts_with(name, "cube-") || !ends_with(name, ".todo"))
+                    continue;
+                id = name.substr(5, name.size() - 10);
+                run = m_dir / ("cube-" + id + ".run." + m_tag);
+                std::error_code ec2;
+                fs::rename(e.path(), run, ec2);
+                if (!ec2)
+                    break;
+                // claimed by another worker
+                run.clear();
+            }
+            std::string content, header;
+            if (run.empty() || !read_file(run, content))
+                return false;
+            expr_ref_vector cube(m), eqs(m);
+            decode(m, content, header, cube);
+            vector<expr_ref_vector> children;
+            std::string result;
+            switch (solve(cube, false, children, eqs)) {
+            case outcome::unsat:
+                result = "unsat\n";
+                break;
+            case outcome::unknown:
+                result = "unknown\n";
+                break;
+            case outcome::split:
+                // the children exist before the result which accounts for them
+                for (unsigned i = 0; i < children.size(); ++i)
+                    write_file(m_dir / ("cube-" + id + "." + std::to_string(i) + ".todo"), encode(m, "cube", children[i]), m_tag);
+                result = "split " + std::to_string(children.size()) + "\n";
+                break;
+            case outcome::sat: {
+                expr_ref_vector es(cube);
+                es.append(eqs);
+                result = encode(m, "sat " + std::to_string(cube.size()), es);
+                break;
+            }
+            case outcome::canceled:
+                return true;
+            }
+            write_file(m_dir / ("cube-" + id + ".result"), result, m_tag);
+            fs::remove(run, ec);
+            return true;
+        }
+    };
+
+    lbool distributed::operator()(expr_ref_vector const& asms) {
+        if (ctx.get_fparams().m_distributed_worker)
+            return work();
+        return drive(asms);
+    }
+
+    lbool distributed::drive(expr_ref_vector const& asms) {
+        ast_manager& m = ctx.get_manager();
+        fs::path dir(ctx.get_fparams().m_distributed_dir.str());
+        std::string tag = mk_tag(0);
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        // remove the files of a previous run
+        for (auto const& e : fs::directory_iterator(dir, ec)) {
+            std::string name = e.path().filename().string();
+            std::error_code ec2;
+            if (name == "base" || name == "finished" || starts_with(name, "cube-") || starts_with(name, "lemmas."))
+                fs::remove(e.path(), ec2);
+        }
+
+        ptr_vector<expr> fmls;
+        ctx.get_asserted_formulas(fmls);
+        expr_ref_vector base(m);
+        base.append(fmls.size(), fmls.data());
+        std::string content;
+        try {
+            content = encode(m, "base", base);
+        }
+        catch (z3_exception& ex) {
+            IF_VERBOSE(1, verbose_stream() << "(smt.distributed :sequential \"" << ex.msg() << "\")\n";);
+            flet<symbol> _dir(ctx.m_fparams.m_distributed_dir, symbol::null);
+            return ctx.check(asms.size(), asms.data());
+        }
+        write_file(dir / "base", content, tag);
+
+        // the driver also solves cubes
+        worker w(ctx, dir, tag);
+        ast_manager& wm = w.get_manager();
+        scoped_limits sl(m.limit());
+        sl.push_child(&wm.limit());
+        if (!w.load_base())
+            throw default_exception("could not read the base file of distributed cube-and-conquer");
+
+        // rebuild the model of a satisfiable cube in ctx
+        auto rebuild = [&](expr_ref_vector const& cube, expr_ref_vector const& eqs) {
+            flet<symbol> _dir(ctx.m_fparams.m_distributed_dir, symbol::null);
+            expr_ref_vector lasms(cube);
+            lasms.append(eqs);
+            lbool r = ctx.check(lasms.size(), lasms.data());
+            if (r != l_true)
+                r = ctx.check(cube.size(), cube.data());
+            return r == l_true ? l_true : l_undef;
+        };
+
+        // initial split into cubes
+        ast_translation tr(m, wm), tr2(wm, m);
+        vector<expr_ref_vector> cubes, next, children;
+        cubes.push_back(tr(asms));
+        expr_ref_vector eqs(wm);
+        bool unknown = false;
+        unsigned depth = ctx.get_fparams().m_distributed_cube_depth;
+        for (unsigned d = 0; d < depth && !cubes.empty(); ++d) {
+            next.reset();
+            for (auto const& c : cubes) {
+                switch (w.solve(c, true, children, eqs)) {
+                case outcome::unsat:
+                    break;
+                case outcome::unknown:
+                    unknown = true;
+                    break;
+                case outcome::split:
+                    for (auto const& ch : children)
+                        next.push_back(ch);
+                    break;
+                case outcome::sat:
+                    return rebuild(tr2(c), tr2(eqs));
+                case outcome::canceled:
+                    return l_undef;
+                }
+            }
+            cubes.swap(next);
+        }
+        IF_VERBOSE(1, verbose_stream() << "(smt.distributed :cubes " << cubes.size() << ")\n";);
+        for (unsigned i = 0; i < cubes.size(); ++i)
+            write_file(dir / ("cube-" + std::to_string(i) + ".todo"), encode(wm, "cube", cubes[i]), tag);
+
+        unsigned open = cubes.size();
+        std::set<std::string> seen;
+        std::string header;
+        expr_ref_vector sat_cube(m), sat_eqs(m), es(m);
+        bool sat = false;
+        while (open > 0 && !sat && m.inc()) {
+            if (!w.step())
+                sleep_a_bit();
+            for (auto const& e : fs::directory_iterator(dir, ec)) {
+                std::string name = e.path().filename().string();
+                if (!ends_with(name, ".result") || seen.count(name) || !read_file(e.path(), content))
+                    continue;
+                seen.insert(name);
+                std::istringstream in(content);
+                std::string kind;
+                unsigned n = 0;
+                in >> kind >> n;
+                if (kind == "unsat")
+                    --open;
+                else if (kind == "unknown") {
+                    --open;
+                    unknown = true;
+                }
+                else if (kind == "split")
+                    open += n - 1;
+                else if (kind == "sat" && !sat) {
+                    sat = true;
+                    decode(m, content, header, es);
+                    for (unsigned i = 0; i < es.size(); ++i)
+                        (i < n ? sat_cube : sat_eqs).push_back(es.get(i));
+                }
+            }
+        }
+        write_file(dir / "finished", "", tag);
+        m_num_cubes = seen.size();
+        m_num_splits = w.m_num_splits;
+        ctx.m_aux_stats.update("smt distributed cubes", m_num_cubes);
+        ctx.m_aux_stats.update("smt distributed splits", m_num_splits);
+        if (sat)
+            return rebuild(sat_cube, sat_eqs);
+        if (!m.inc() || unknown)
+            return l_undef;
+        ctx.m_unsat_core.reset();
+        ctx.m_unsat_core.append(asms);
+        return l_false;
+    }
+
+    lbool distributed::work() {
+        ast_manager& m = ctx.get_manager();
+        fs::path dir(ctx.get_fparams().m_distributed_dir.str());
+        std::error_code ec;
+        // wait for the base of a run of a driver
+        while (m.inc() && (!fs::exists(dir / "base", ec) || fs::exists(dir / "finished", ec)))
+            sleep_a_bit();
+        worker w(ctx, dir, mk_tag(1));
+        scoped_limits sl(m.limit());
+        sl.push_child(&w.get_manager().limit());
+        if (!m.inc() || !w.load_base())
+            return l_undef;
+        while (m.inc() && !fs::exists(dir / "finished", ec))
+            if (!w.step())
+                sleep_a_bit();
+        m_num_cubes = w.m_num_cubes;
+        m_num_splits = w.m_num_splits;
+        IF_VERBOSE(1, verbose_stream() << "(smt.distributed.worker :cubes " << m_num_cubes << " :splits " << m_num_splits << ")\n";);
+        ctx.m_aux_stats.update("smt distributed cubes", m_num_cubes);
+        ctx.m_aux_stats.update("smt distributed splits", m_num_splits);
+        return l_undef;
+    }
+
+}
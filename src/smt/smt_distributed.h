@@ -0,0 +1,58 @@
+/*++
+
+Module Name:
+
+    smt_distributed.h
+
+Abstract:
+
+    Distributed cube-and-conquer for the SMT core.
+
+    The driver splits the problem by lookahead into cubes (smt.distributed.cube_depth)
+    and puts them, together with the serialized assertions (see ast_serialize.h), into
+    a directory (smt.distributed.dir) that worker processes on other nodes serve
+    (smt.distributed.worker=true with the same directory, any input). The driver
+    process is one of the workers. A worker solves a cube with the assumptions of the
+    check and the cube as assumptions under a conflict budget (smt.threads.max_conflicts)
+    that doubles each time it is exhausted. After smt.threads.cube_frequency exhausted
+    budgets it splits the cube by lookahead and puts both halves back. The negation of
+    the unsat core of a refuted cube is a lemma, lemmas with at most smt.threads.share_size
+    literals are shared with the other workers.
+
+    The directory protocol, in the style of sat.cc.dir (sat_cube_conquer.h):
+       base                    the assertions of the problem
+       cube-<id>.todo          cube to solve (the assumptions of the check followed by the cube literals)
+       cube-<id>.run.<tag>     cube claimed by worker <tag> (claimed by renaming the .todo file)
+       cube-<id>.result        "unsat", "unknown" (the cube could not be decided), "split <n>"
+                               (the children cube-<id>.<i>.todo were created before) or
+                               "sat <n>" followed by the cube and equalities of the model
+       lemmas.<tag>            lemmas learned by worker <tag>
+       finished                created by the driver when the search is over
+    Files are written to a temporary name first and renamed, so readers never see partial files.
+
+    The unsat core of an unsatisfiable check is the set of all its assumptions.
+    A model is rebuilt by the driver from the equalities of the model of the worker.
+
+--*/
+#pragma once
+
+#include "smt/smt_context.h"
+
+namespace smt {
+
+    class distributed {
+        class worker;
+        context& ctx;
+        unsigned m_num_cubes = 0;
+        unsigned m_num_splits = 0;
+
+        lbool drive(expr_ref_vector const& asms);
+        lbool work();
+
+    public:
+        distributed(context& ctx): ctx(ctx) {}
+
+        lbool operator()(expr_ref_vector const& asms);
+    };
+
+}
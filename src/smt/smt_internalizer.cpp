@@ -155,14 +155,16 @@ namespace smt {
     }
 
     void context::top_sort_expr(expr* const* exprs, unsigned num_exprs, svector<expr_bool_pair> & sorted_exprs) {
-        tcolors.reset();
-        fcolors.reset();
+        // only the colored entries are reset, so the cost is proportional to the sorted expressions
+        // and not to the largest expression id.
+        SASSERT(ts_colored.empty());
         while (!ts_todo.empty()) {
             expr_bool_pair & p = ts_todo.back();
             expr * curr        = p.first;
             bool   gate_ctx    = p.second;
             switch (get_color(tcolors, fcolors, curr, gate_ctx)) {
             case White:
+                ts_colored.push_back(curr->get_id());
                 set_color(tcolors, fcolors, curr, gate_ctx, Grey);
                 ts_visit_children(curr, gate_ctx, ts_todo);
                 break;
@@ -181,9 +183,40 @@ namespace smt {
                 UNREACHABLE();
             }
         }
+        for (unsigned id : ts_colored) {
+            if (id < tcolors.size()) tcolors[id] = White;
+            if (id < fcolors.size()) fcolors[id] = White;
+        }
+        ts_colored.reset();
     }
 
-#define DEEP_EXPR_THRESHOLD 1024
+    /**
+       \brief grow the capacity of the tables indexed by boolean variables and expression ids
+       before a batch of expressions is internalized.
+    */
+    void context::reserve_internalization(unsigned num_bool_vars, unsigned max_expr_id) {
+        auto reserve = [](auto& v, unsigned n) {
+            if (n > v.capacity()) {
+                unsigned sz = v.size();
+                v.resize(n);
+                v.shrink(sz);
+            }
+        };
+        reserve(m_bdata, num_bool_vars);
+        reserve(m_activity, num_bool_vars);
+        reserve(m_bool_var2expr, num_bool_vars);
+        reserve(m_assignment, 2 * num_bool_vars);
+        reserve(m_watches, 2 * num_bool_vars);
+        reserve(m_lit_occs, 2 * num_bool_vars);
+#if USE_BOOL_VAR_VECTOR
+        reserve(m_expr2bool_var, max_expr_id + 1);
+#endif
+        reserve(m_app2enode, max_expr_id + 1);
+    }
+
+    // Expressions deeper than this are internalized bottom-up in topological order, 
+    // so the recursion of internalize_rec stays shallow.
+#define DEEP_EXPR_THRESHOLD 64
 
     bool context::should_internalize_rec(expr* e) const {
         return !is_app(e) || 
@@ -206,9 +239,19 @@ namespace smt {
             }
         }
 
+        if (ts_todo.empty())
+            return;
+
         svector<expr_bool_pair> sorted_exprs;
         top_sort_expr(exprs, num_exprs, sorted_exprs);
         TRACE("deep_internalize", for (auto & kv : sorted_exprs) tout << "#" << kv.first->get_id() << " " << kv.second << "\n"; );
+        unsigned num_bool = 0, max_id = 0;
+        for (auto & kv : sorted_exprs) {
+            if (m.is_bool(kv.first))
+                ++num_bool;
+            max_id = std::max(max_id, kv.first->get_id());
+        }
+        reserve_internalization(get_num_bool_vars() + num_bool, max_id);
         for (auto & kv : sorted_exprs) {
             expr* e = kv.first;
             SASSERT(should_internalize_rec(e));
@@ -1467,6 +1510,7 @@ namespace smt {
             m_clause_proof.add(*cls, &simp_lits);
             if (lemma) {
                 cls->set_activity(activity);
+                cls->set_glue(compute_glue(num_lits, lits));
                 if (k == CLS_LEARNED) {
                     int w2_idx  = select_learned_watch_lit(cls);
                     cls->swap_lits(1, w2_idx);
@@ -181,6 +181,14 @@ namespace smt {
     void kernel::get_units(expr_ref_vector & result) {
         m_imp->m_kernel.get_units(result);
     }    
+
+    void kernel::get_snapshot(context_snapshot & s, bool include_assignments) {
+        m_imp->m_kernel.get_snapshot(s, include_assignments);
+    }
+
+    void kernel::assert_snapshot(context_snapshot const & s, bool include_assignments) {
+        m_imp->m_kernel.assert_snapshot(s, include_assignments);
+    }
         
     void kernel::get_relevant_labels(expr * cnstr, buffer<symbol> & result) {
         m_imp->m_kernel.get_relevant_labels(cnstr, result);
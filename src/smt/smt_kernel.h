@@ -41,6 +41,7 @@ namespace smt {
 
     class enode;
     class context;
+    struct context_snapshot;
     
     class kernel {
         struct imp;
@@ -208,6 +209,16 @@ namespace smt {
            \brief Return units assigned by the kernel.
         */
         void get_units(expr_ref_vector& result);
+
+        /**
+           \brief Export the state of the kernel for side queries (see context::get_snapshot).
+        */
+        void get_snapshot(context_snapshot & s, bool include_assignments = true);
+
+        /**
+           \brief Assert a snapshot taken from a kernel or context over the same manager.
+        */
+        void assert_snapshot(context_snapshot const & s, bool include_assignments = true);
         
         /**
            \brief Return the set of relevant labels in the last check command.
@@ -9,6 +9,11 @@ Abstract:
 
     Parallel SMT, portfolio loop specialized to SMT core.
 
+    The workers solve cubes asynchronously. A worker which exhausts its conflict
+    budget while another worker is idle splits its cube by lookahead and leaves
+    one half to the idle worker. Units and short learned clauses are exchanged
+    each time a worker exhausts its budget.
+
 Author:
 
     nbjorner 2020-01-31
@@ -36,8 +41,63 @@ namespace smt {
 #else
 
 #include <thread>
+#include <mutex>
+#include <chrono>
 
 namespace smt {
+
+    namespace {
+
+        /**
+           \brief state shared by the worker threads, kept in the manager of the main context.
+           All members are accessed under m_mux. Workers only hold the lock while they exchange
+           cubes, clauses and results, so there is no barrier between the threads.
+        */
+        class batch_manager {
+        public:
+            enum par_exception_kind {
+                DEFAULT_EX,
+                ERROR_EX
+            };
+
+            std::mutex              m_mux;
+            ast_manager&            m;
+            vector<expr_ref_vector> m_cubes;        // cubes waiting for a worker
+            unsigned                m_open = 1;     // cubes in m_cubes or being solved, the empty cube initially
+            unsigned                m_idle = 0;     // workers waiting for a cube
+            expr_ref_vector         m_shared;       // units and short learned clauses
+            unsigned_vector         m_shared_owner;
+            obj_hashtable<expr>     m_shared_set;
+            obj_hashtable<expr>     m_atoms;        // atoms of the main context, only they are shared
+            expr_ref_vector         m_core;         // assumptions used to refute the cubes
+            obj_hashtable<expr>     m_core_set;
+            lbool                   m_result = l_undef;
+            unsigned                m_finished_id = UINT_MAX;
+            bool                    m_done = false;
+            bool                    m_all_refuted = false;
+            std::string             m_ex_msg;
+            par_exception_kind      m_ex_kind = DEFAULT_EX;
+            unsigned                m_error_code = 0;
+            unsigned                m_num_splits = 0;
+
+            batch_manager(ast_manager& m): m(m), m_shared(m), m_core(m) {
+                m_cubes.push_back(expr_ref_vector(m));
+            }
+        };
+
+        struct worker {
+            unsigned          m_id;
+            ast_manager&      m;
+            context&          ctx;
+            expr_ref_vector   m_asms;
+            unsigned          m_unit_lim = 0;
+            unsigned          m_lemma_lim = 0;
+            unsigned          m_shared_lim = 0;
+
+            worker(unsigned id, context& ctx, expr_ref_vector const& asms):
+                m_id(id), m(ctx.get_manager()), ctx(ctx), m_asms(asms) {}
+        };
+    }
     
     lbool parallel::operator()(expr_ref_vector const& asms) {
 
@@ -46,6 +106,8 @@ namespace smt {
         flet<unsigned> _nt(ctx.m_fparams.m_threads, 1);
         unsigned thread_max_conflicts = ctx.get_fparams().m_threads_max_conflicts;
         unsigned max_conflicts = ctx.get_fparams().m_max_conflicts;
+        unsigned cube_frequency = std::max(1u, ctx.get_fparams().m_threads_cube_frequency);
+        unsigned share_size = ctx.get_fparams().m_threads_share_size;
 
         // try first sequential with a low conflict budget to make super easy problems cheap
         unsigned max_c = std::min(thread_max_conflicts, 40u);
@@ -55,192 +117,284 @@ namespace smt {
             return result;
         }        
 
-        enum par_exception_kind {
-            DEFAULT_EX,
-            ERROR_EX
-        };
-
         vector<smt_params> smt_params;
         scoped_ptr_vector<ast_manager> pms;
         scoped_ptr_vector<context> pctxs;
-        vector<expr_ref_vector> pasms;
+        scoped_ptr_vector<worker> workers;
 
         ast_manager& m = ctx.m;
         scoped_limits sl(m.limit());
-        unsigned finished_id = UINT_MAX;
-        std::string        ex_msg;
-        par_exception_kind ex_kind = DEFAULT_EX;
-        unsigned error_code = 0;
-        bool done = false;
-        unsigned num_rounds = 0;
         if (m.has_trace_stream())
             throw default_exception("trace streams have to be off in parallel mode");
 
+        batch_manager bm(m);
+        for (unsigned v = 0; v < ctx.get_num_bool_vars(); ++v)
+            if (ctx.bool_var2expr(v))
+                bm.m_atoms.insert(ctx.bool_var2expr(v));
         
         for (unsigned i = 0; i < num_threads; ++i) {
             smt_params.push_back(ctx.get_fparams());
         }
+        // The translation reads (and references) the terms of m, so the contexts are copied one by one.
+        // Configuring and internalizing a copy only touches its own manager, it is done by the worker threads.
+        bool internalize_in_workers = !ctx.m_user_propagator && ctx.m_setup.already_configured();
         for (unsigned i = 0; i < num_threads; ++i) {
             ast_manager* new_m = alloc(ast_manager, m, true);
             pms.push_back(new_m);
             pctxs.push_back(alloc(context, *new_m, smt_params[i], ctx.get_params())); 
             context& new_ctx = *pctxs.back();
-            context::copy(ctx, new_ctx, true);
+            context::copy(ctx, new_ctx, true, !internalize_in_workers);
             new_ctx.set_random_seed(i + ctx.get_fparams().m_random_seed);
             ast_translation tr(m, *new_m);
-            pasms.push_back(tr(asms));
+            workers.push_back(alloc(worker, i, new_ctx, tr(asms)));
             sl.push_child(&(new_m->limit()));
         }
 
-        auto cube = [](context& ctx, expr_ref_vector& lasms, expr_ref& c) {
-            lookahead lh(ctx);
-            c = lh.choose();
-            if (c) {
-                if ((ctx.get_random_value() % 2) == 0) 
-                    c = c.get_manager().mk_not(c);
-                lasms.push_back(c);
+        auto cancel_others = [&](unsigned id) {
+            for (unsigned j = 0; j < num_threads; ++j)
+                if (j != id) pms[j]->limit().cancel();
+        };
+
+        // called under the lock
+        auto set_result = [&](worker& w, lbool r) {
+            if (bm.m_finished_id == UINT_MAX || (r != l_undef && bm.m_result == l_undef)) {
+                bm.m_finished_id = w.m_id;
+                bm.m_result = r;
             }
+            bm.m_done = true;
         };
 
-        obj_hashtable<expr> unit_set;
-        expr_ref_vector unit_trail(ctx.m);
-        unsigned_vector unit_lim;
-        for (unsigned i = 0; i < num_threads; ++i) unit_lim.push_back(0);
-
-        std::function<void(void)> collect_units = [&,this]() {
-            for (unsigned i = 0; i < num_threads; ++i) {
-                context& pctx = *pctxs[i];
-                pctx.pop_to_base_lvl();
-                ast_translation tr(pctx.m, ctx.m);
-                unsigned sz = pctx.assigned_literals().size();
-                for (unsigned j = unit_lim[i]; j < sz; ++j) {
-                    literal lit = pctx.assigned_literals()[j];
-                    expr_ref e(pctx.bool_var2expr(lit.var()), pctx.m);
-                    if (lit.sign()) e = pctx.m.mk_not(e);
-                    expr_ref ce(tr(e.get()), ctx.m);
-                    if (!unit_set.contains(ce)) {
-                        unit_set.insert(ce);
-                        unit_trail.push_back(ce);
-                    }
-                }
+        // only clauses over atoms of the main context are shared, atoms introduced
+        // by a worker (e.g. fresh skolem terms) have no meaning for the other workers.
+        auto translate_clause = [&](worker& w, ast_translation& tr, unsigned n, literal const* lits, expr_ref& result) {
+            expr_ref_vector lits_m(m);
+            for (unsigned j = 0; j < n; ++j) {
+                expr* a = w.ctx.bool_var2expr(lits[j].var());
+                if (!a) return false;
+                expr_ref e(tr(a), m);
+                if (!bm.m_atoms.contains(e)) return false;
+                lits_m.push_back(lits[j].sign() ? m.mk_not(e) : e.get());
             }
+            result = mk_or(lits_m);
+            return true;
+        };
 
-            unsigned sz = unit_trail.size();
-            for (unsigned i = 0; i < num_threads; ++i) {
-                context& pctx = *pctxs[i];
-                ast_translation tr(ctx.m, pctx.m);
-                for (unsigned j = unit_lim[i]; j < sz; ++j) {
-                    expr_ref src(ctx.m), dst(pctx.m);
-                    dst = tr(unit_trail.get(j));
-                    pctx.assert_expr(dst);
+        // export new units and short lemmas of w, import the ones of the other workers
+        auto share = [&](worker& w) {
+            context& pctx = w.ctx;
+            pctx.pop_to_base_lvl();
+            std::lock_guard<std::mutex> lock(bm.m_mux);
+            ast_translation tr(w.m, m);
+            expr_ref e(m);
+            auto add = [&](unsigned n, literal const* lits) {
+                if (translate_clause(w, tr, n, lits, e) && !bm.m_shared_set.contains(e)) {
+                    bm.m_shared_set.insert(e);
+                    bm.m_shared.push_back(e);
+                    bm.m_shared_owner.push_back(w.m_id);
                 }
-                unit_lim[i] = sz;
+            };
+            unsigned sz = pctx.assigned_literals().size();
+            for (unsigned j = w.m_unit_lim; j < sz; ++j) 
+                add(1, &pctx.assigned_literals()[j]);
+            w.m_unit_lim = sz;
+            // lemmas can be garbage collected between calls, in which case some are skipped.
+            clause_vector const& lemmas = pctx.get_lemmas();
+            if (w.m_lemma_lim > lemmas.size())
+                w.m_lemma_lim = lemmas.size();
+            for (unsigned j = w.m_lemma_lim; j < lemmas.size(); ++j) {
+                clause* cls = lemmas[j];
+                if (cls->get_num_literals() <= share_size) 
+                    add(cls->get_num_literals(), cls->begin());
             }
-            IF_VERBOSE(1, verbose_stream() << "(smt.thread :units " << sz << ")\n");
+            w.m_lemma_lim = lemmas.size();
+
+            ast_translation tr2(m, w.m);
+            for (unsigned j = w.m_shared_lim; j < bm.m_shared.size(); ++j) 
+                if (bm.m_shared_owner[j] != w.m_id)
+                    pctx.assert_expr(tr2(bm.m_shared.get(j)));
+            w.m_shared_lim = bm.m_shared.size();
+            // units asserted above are not re-exported
+            w.m_unit_lim = pctx.assigned_literals().size();
         };
 
-        std::mutex mux;
-
-        auto worker_thread = [&](int i) {
-            try {
-                context& pctx = *pctxs[i];
-                ast_manager& pm = *pms[i];
-                expr_ref_vector lasms(pasms[i]);
-                expr_ref c(pm);
-
-                pctx.get_fparams().m_max_conflicts = std::min(thread_max_conflicts, max_conflicts);
-                if (num_rounds > 0 && (pctx.get_fparams().m_threads_cube_frequency % num_rounds) == 0) 
-                    cube(pctx, lasms, c);
-                IF_VERBOSE(1, verbose_stream() << "(smt.thread " << i; 
-                           if (num_rounds > 0) verbose_stream() << " :round " << num_rounds;
-                           if (c) verbose_stream() << " :cube " << mk_bounded_pp(c, pm, 3);
-                           verbose_stream() << ")\n";);
-                lbool r = pctx.check(lasms.size(), lasms.data());
-                
-                if (r == l_undef && pctx.m_num_conflicts >= max_conflicts) 
-                    ; // no-op
-                else if (r == l_undef && pctx.m_num_conflicts >= thread_max_conflicts) 
-                    return;
-                else if (r == l_false && pctx.unsat_core().contains(c)) {
-                    IF_VERBOSE(1, verbose_stream() << "(smt.thread " << i << " :learn " << mk_bounded_pp(c, pm, 3) << ")");
-                    pctx.assert_expr(mk_not(mk_and(pctx.unsat_core())));
-                    return;
-                } 
-                
-
-                bool first = false;
+        // claim a cube, waiting while other workers may still split theirs
+        auto get_cube = [&](worker& w, expr_ref_vector& cube) {
+            bool idle = false;
+            while (true) {
                 {
-                    std::lock_guard<std::mutex> lock(mux);
-                    if (finished_id == UINT_MAX) {
-                        finished_id = i;
-                        first = true;
-                        result = r;
-                        done = true;
+                    std::lock_guard<std::mutex> lock(bm.m_mux);
+                    if (bm.m_done || !w.m.limit().inc()) {
+                        if (idle) --bm.m_idle;
+                        return false;
                     }
-                    if (!first && r != l_undef && result == l_undef) {
-                        finished_id = i;
-                        result = r;                        
+                    if (!bm.m_cubes.empty()) {
+                        if (idle) --bm.m_idle;
+                        ast_translation tr(m, w.m);
+                        cube.reset();
+                        for (expr* e : bm.m_cubes.back())
+                            cube.push_back(tr(e));
+                        bm.m_cubes.pop_back();
+                        return true;
+                    }
+                    if (bm.m_open == 0) {
+                        // every cube was refuted
+                        if (idle) --bm.m_idle;
+                        bm.m_all_refuted = true;
+                        bm.m_result = l_false;
+                        bm.m_finished_id = w.m_id;
+                        bm.m_done = true;
+                        return false;
+                    }
+                    if (!idle) {
+                        idle = true;
+                        ++bm.m_idle;
                     }
-                    else if (!first) return;
                 }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        };
 
-                for (ast_manager* m : pms) {
-                    if (m != &pm) m->limit().cancel();
-                }
+        // give half of the cube to an idle worker, or split after cube_frequency exhausted budgets
+        auto split = [&](worker& w, expr_ref_vector& cube, unsigned rounds) {
+            {
+                std::lock_guard<std::mutex> lock(bm.m_mux);
+                if (bm.m_idle == 0 && (rounds % cube_frequency) != 0)
+                    return;
+            }
+            lookahead lh(w.ctx);
+            expr_ref c(lh.choose(), w.m);
+            if (!c) 
+                return;
+            if ((w.ctx.get_random_value() % 2) == 0) 
+                c = w.m.mk_not(c);
+            std::lock_guard<std::mutex> lock(bm.m_mux);
+            ast_translation tr(w.m, m);
+            expr_ref_vector other(m);
+            for (expr* e : cube)
+                other.push_back(tr(e));
+            other.push_back(m.mk_not(tr(c.get())));
+            bm.m_cubes.push_back(other);
+            ++bm.m_open;
+            ++bm.m_num_splits;
+            cube.push_back(c);
+            IF_VERBOSE(1, verbose_stream() << "(smt.thread " << w.m_id << " :split " << mk_bounded_pp(c, w.m, 3) << " :depth " << cube.size() << ")\n";);
+        };
 
+        auto worker_thread = [&](int i) {
+            worker& w = *workers[i];
+            try {
+                context& pctx = w.ctx;
+                ast_manager& pm = w.m;
+                if (internalize_in_workers) {
+                    pctx.setup_context(pctx.get_fparams().m_auto_config);
+                    pctx.internalize_assertions();
+                }
+                unsigned total_conflicts = 0;
+                expr_ref_vector cube(pm), lasms(pm);
+                while (get_cube(w, cube)) {
+                    unsigned budget = thread_max_conflicts;
+                    for (unsigned rounds = 1; ; ++rounds) {
+                        lasms.reset();
+                        lasms.append(w.m_asms);
+                        lasms.append(cube);
+                        pctx.get_fparams().m_max_conflicts = std::min(budget, max_conflicts - std::min(max_conflicts, total_conflicts));
+                        IF_VERBOSE(1, verbose_stream() << "(smt.thread " << i << " :cube " << cube.size() << " :budget " << pctx.get_fparams().m_max_conflicts << ")\n";);
+                        lbool r = pctx.check(lasms.size(), lasms.data());
+                        total_conflicts += pctx.m_num_conflicts;
+                        
+                        if (r == l_undef && pctx.m_num_conflicts >= pctx.get_fparams().m_max_conflicts && total_conflicts < max_conflicts) {
+                            share(w);
+                            split(w, cube, rounds);
+                            budget *= 2;
+                            continue;
+                        }
+                        if (r == l_false) {
+                            expr_ref_vector const& core = pctx.unsat_core();
+                            bool uses_cube = any_of(core, [&](expr* e) { return cube.contains(e); });
+                            if (uses_cube) {
+                                IF_VERBOSE(1, verbose_stream() << "(smt.thread " << i << " :refuted " << cube.size() << ")\n");
+                                pctx.assert_expr(mk_not(mk_and(core)));
+                                share(w);
+                                std::lock_guard<std::mutex> lock(bm.m_mux);
+                                ast_translation tr(pm, m);
+                                for (expr* e : core) {
+                                    if (cube.contains(e)) continue;
+                                    expr_ref ce(tr(e), m);
+                                    if (!bm.m_core_set.contains(ce)) {
+                                        bm.m_core_set.insert(ce);
+                                        bm.m_core.push_back(ce);
+                                    }
+                                }
+                                --bm.m_open;
+                                break;
+                            }
+                        }
+                        {
+                            std::lock_guard<std::mutex> lock(bm.m_mux);
+                            if (bm.m_done && (r == l_undef || bm.m_result != l_undef))
+                                return;
+                            set_result(w, r);
+                        }
+                        cancel_others(i);
+                        return;
+                    }
+                }
             }
             catch (z3_error & err) {
-                if (finished_id == UINT_MAX) {
-                    error_code = err.error_code();
-                    ex_kind = ERROR_EX;
-                    done = true;
+                std::lock_guard<std::mutex> lock(bm.m_mux);
+                if (bm.m_finished_id == UINT_MAX) {
+                    bm.m_error_code = err.error_code();
+                    bm.m_ex_kind = batch_manager::ERROR_EX;
+                    bm.m_done = true;
                 }
             }
             catch (z3_exception & ex) {
-                if (finished_id == UINT_MAX) {
-                    ex_msg = ex.msg();
-                    ex_kind = DEFAULT_EX;
-                    done = true;
+                std::lock_guard<std::mutex> lock(bm.m_mux);
+                if (bm.m_finished_id == UINT_MAX) {
+                    bm.m_ex_msg = ex.msg();
+                    bm.m_ex_kind = batch_manager::DEFAULT_EX;
+                    bm.m_done = true;
                 }
             }
             catch (...) {
-                if (finished_id == UINT_MAX) {
-                    ex_msg = "unknown exception";
-                    ex_kind = ERROR_EX;
-                    done = true;
+                std::lock_guard<std::mutex> lock(bm.m_mux);
+                if (bm.m_finished_id == UINT_MAX) {
+                    bm.m_ex_msg = "unknown exception";
+                    bm.m_ex_kind = batch_manager::ERROR_EX;
+                    bm.m_done = true;
                 }
             }
+            cancel_others(i);
         };
 
         // for debugging:  num_threads = 1;
 
-        while (true) {
-            vector<std::thread> threads(num_threads);
-            for (unsigned i = 0; i < num_threads; ++i) {
-                threads[i] = std::thread([&, i]() { worker_thread(i); });
-            }
-            for (auto & th : threads) {
-                th.join();
-            }
-            if (done) break;
-
-            collect_units();
-            ++num_rounds;
-            max_conflicts = (max_conflicts < thread_max_conflicts) ? 0 : (max_conflicts - thread_max_conflicts);
-            thread_max_conflicts *= 2;            
+        vector<std::thread> threads(num_threads);
+        for (unsigned i = 0; i < num_threads; ++i) {
+            threads[i] = std::thread([&, i]() { worker_thread(i); });
+        }
+        for (auto & th : threads) {
+            th.join();
         }
 
         for (context* c : pctxs) {
             c->collect_statistics(ctx.m_aux_stats);
         }
+        ctx.m_aux_stats.update("smt parallel shared", bm.m_shared.size());
+        ctx.m_aux_stats.update("smt parallel splits", bm.m_num_splits);
 
+        unsigned finished_id = bm.m_finished_id;
         if (finished_id == UINT_MAX) {
-            switch (ex_kind) {
-            case ERROR_EX: throw z3_error(error_code);
-            default: throw default_exception(std::move(ex_msg));
+            switch (bm.m_ex_kind) {
+            case batch_manager::ERROR_EX: throw z3_error(bm.m_error_code);
+            default: 
+                if (bm.m_ex_msg.empty())
+                    return l_undef; // canceled
+                throw default_exception(std::move(bm.m_ex_msg));
             }
         }        
 
+        result = bm.m_result;
         model_ref mdl;        
         context& pctx = *pctxs[finished_id];
         ast_translation tr(*pms[finished_id], m);
@@ -252,8 +406,14 @@ namespace smt {
             break;
         case l_false:
             ctx.m_unsat_core.reset();
-            for (expr* e : pctx.unsat_core()) 
-                ctx.m_unsat_core.push_back(tr(e));
+            if (bm.m_all_refuted) {
+                // all cubes were refuted, the core collects the assumptions used
+                ctx.m_unsat_core.append(bm.m_core);
+            }
+            else {
+                for (expr* e : pctx.unsat_core()) 
+                    ctx.m_unsat_core.push_back(tr(e));
+            }
             break;
         default:
             break;
@@ -19,6 +19,8 @@ Revision History:
 #include "smt/smt_context.h"
 #include "smt/smt_setup.h"
 #include "ast/static_features.h"
+#include "ast/for_each_expr.h"
+#include "ast/seq_decl_plugin.h"
 #include "smt/theory_arith.h"
 #include "smt/theory_lra.h"
 #include "smt/theory_dense_diff_logic.h"
@@ -572,6 +574,12 @@ namespace smt {
         else if (m_params.m_string_solver == "noodler") {
             setup_str_noodler();
         }
+        else if (m_params.m_string_solver == "portfolio") {
+            if (use_str_noodler())
+                setup_str_noodler();
+            else
+                setup_unknown();
+        }
         else if (m_params.m_string_solver == "auto") {
             setup_unknown();
         }
@@ -747,6 +755,10 @@ namespace smt {
         else if (m_params.m_string_solver == "seq") {
             setup_seq();
         } 
+        else if (m_params.m_string_solver == "portfolio") {
+            // noodler is only set up for QF_S and QF_SLIA
+            setup_seq();
+        }
         else if (m_params.m_string_solver == "empty") {
             setup_seq();
         }
@@ -785,6 +797,44 @@ namespace smt {
         m_context.register_plugin(alloc(noodler::theory_str_noodler, m_context, m_manager, m_params));
     }
 
+    namespace {
+        struct str_noodler_unsupported_proc {
+            struct found {};
+            seq_util u;
+            str_noodler_unsupported_proc(ast_manager& m): u(m) {}
+            void operator()(var*) {}
+            void operator()(quantifier*) { throw found(); }
+            void operator()(app* n) {
+                if (u.str.is_replace_all(n) || u.str.is_replace_re_all(n))
+                    throw found();
+                if (u.is_seq(n) && !u.is_string(n->get_sort()))
+                    throw found();
+            }
+        };
+    }
+
+    /**
+       \brief Static choice of smt.string_solver=portfolio: use noodler unless the
+       assertions contain quantifiers, sequences other than strings or operations
+       that noodler does not support.
+    */
+    bool setup::use_str_noodler() {
+        ptr_vector<expr> fmls;
+        m_context.get_asserted_formulas(fmls);
+        str_noodler_unsupported_proc proc(m_manager);
+        expr_fast_mark1 visited;
+        try {
+            for (expr* f : fmls)
+                quick_for_each_expr(proc, visited, f);
+        }
+        catch (const str_noodler_unsupported_proc::found&) {
+            IF_VERBOSE(2, verbose_stream() << "(smt.string-solver seq)\n");
+            return false;
+        }
+        IF_VERBOSE(2, verbose_stream() << "(smt.string-solver noodler)\n");
+        return true;
+    }
+
     void setup::setup_seq() {
         m_context.register_plugin(alloc(smt::theory_seq, m_context));
         setup_char();
@@ -109,6 +109,7 @@ namespace smt {
         void setup_fpa();
         void setup_str();
         void setup_str_noodler();
+        bool use_str_noodler();
 
     public:
         setup(context & c, smt_params & params);
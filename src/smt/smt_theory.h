@@ -255,6 +255,22 @@ namespace smt {
          */
         virtual void relevant_eh(app * n) {
         }
+
+        /**
+           \brief Return true if the theory wants to receive the applications marked as relevant
+           during a propagation round in a single relevant_batch_eh call instead of
+           one relevant_eh call per application.
+        */
+        virtual bool use_relevant_batch() const { return false; }
+
+        /**
+           \brief This method is invoked with the theory applications marked as relevant
+           since the last call, if use_relevant_batch() is true.
+        */
+        virtual void relevant_batch_eh(unsigned num, app * const * ns) {
+            for (unsigned i = 0; i < num; ++i)
+                relevant_eh(ns[i]);
+        }
         
         /**
            \brief This method is invoked when a new backtracking point
@@ -2274,14 +2274,35 @@ public:
         lp_bounds const& bounds = m_bounds[v];
         bool first = true;
         unsigned count = 0;
-        for (unsigned i = 0; i < bounds.size(); ++i) {
-            api_bound* b = bounds[i];
-            if (ctx().get_assignment(b->get_lit()) != l_undef) 
-                continue;
-            literal lit = is_bound_implied(be.kind(), be.m_bound, *b);
-            if (lit == null_literal) 
-                continue;
-            TRACE("arith", tout << lit << " bound: " << *b << " first: " << first << "\n";);
+        m_implied_lits.reset();
+        if (params().m_arith_bprop_strongest) {
+            // the bound axioms between the bounds of v propagate the weaker literals,
+            // so only the strongest implied literal of each bound kind is assigned
+            bool is_upper = be.kind() == lp::LE || be.kind() == lp::LT;
+            api_bound* strongest[2] = { nullptr, nullptr };
+            for (api_bound* b : bounds) {
+                if (ctx().get_assignment(b->get_lit()) != l_undef ||
+                    null_literal == is_bound_implied(be.kind(), be.m_bound, *b)) 
+                    continue;
+                api_bound*& s = strongest[b->get_bound_kind() == lp_api::upper_t];
+                if (!s || (is_upper ? b->get_value() < s->get_value() : s->get_value() < b->get_value()))
+                    s = b;
+            }
+            for (api_bound* b : strongest) 
+                if (b) 
+                    m_implied_lits.push_back(is_bound_implied(be.kind(), be.m_bound, *b));
+        }
+        else {
+            for (api_bound* b : bounds) {
+                if (ctx().get_assignment(b->get_lit()) != l_undef) 
+                    continue;
+                literal lit = is_bound_implied(be.kind(), be.m_bound, *b);
+                if (lit != null_literal) 
+                    m_implied_lits.push_back(lit);
+            }
+        }
+        for (literal lit : m_implied_lits) {
+            TRACE("arith", tout << lit << " first: " << first << "\n";);
 
             ++count;
 
@@ -2318,6 +2339,8 @@ public:
         return count;
     }
 
+    literal_vector m_implied_lits;
+
     void refine_bound(theory_var v, const lp::implied_bound& be) {
         lpvar vi = be.m_j;
         if (lp().column_has_term(vi))
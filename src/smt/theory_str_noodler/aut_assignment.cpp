@@ -1,4 +1,6 @@
 #include "aut_assignment.h"
+#include <algorithm>
+#include <functional>
 #include "util.h"
 
 namespace smt::noodler {
@@ -6,36 +8,88 @@ namespace smt::noodler {
         return AutAssignment::get_lengths(*at(var), var);
     }
 
+    LenNode AutAssignment::get_lengths(const BasicTerm& var, WordLengthsMemo& memo) const {
+        const std::shared_ptr<mata::nfa::Nfa>& aut = at(var);
+        auto it = memo.find(aut.get());
+        if (it == memo.end()) {
+            it = memo.emplace(aut.get(), mata::strings::get_word_lengths(*aut)).first;
+        }
+        return AutAssignment::get_lengths(it->second, var);
+    }
+
+    void AutAssignment::deduplicate() {
+        // automata already sharing a pointer are hashed only once
+        std::unordered_map<const mata::nfa::Nfa*, std::shared_ptr<mata::nfa::Nfa>> canonical;
+        std::unordered_map<size_t, std::vector<std::shared_ptr<mata::nfa::Nfa>>> by_hash;
+        for (auto& pr : *this) {
+            auto [it, inserted] = canonical.try_emplace(pr.second.get(), pr.second);
+            if (inserted) {
+                std::vector<std::shared_ptr<mata::nfa::Nfa>>& same_hash = by_hash[AutomataPool::structural_hash(*pr.second)];
+                auto identical = std::find_if(same_hash.begin(), same_hash.end(), [&pr](const std::shared_ptr<mata::nfa::Nfa>& other) {
+                    return AutomataPool::structurally_equal(*other, *pr.second);
+                });
+                if (identical != same_hash.end()) {
+                    it->second = *identical;
+                } else {
+                    same_hash.push_back(pr.second);
+                }
+            }
+            pr.second = it->second;
+        }
+    }
+
     LenNode AutAssignment::get_lengths(const mata::nfa::Nfa& aut, const BasicTerm& var) {
-        // each (c1, c2) from following set represents the lengths of automaton for var
+        return AutAssignment::get_lengths(mata::strings::get_word_lengths(aut), var);
+    }
+
+    LenNode AutAssignment::get_lengths(const std::set<std::pair<int, int>>& aut_constr, const BasicTerm& var) {
+        // each (c1, c2) from aut_constr represents the lengths of automaton for var
         // where we take c1 + k*c2 for each k >= 0
-        std::set<std::pair<int, int>> aut_constr = mata::strings::get_word_lengths(aut);
 
-        LenNode res(LenFormulaType::FALSE, {});
+        // instead of a fresh k for each lasso, the lengths c1 + k*c2 are encoded as (var mod c2 = c1 mod c2 && c1 <= var);
+        // lassos with the same period and residue differ only in their least length, so only the smallest one is kept
+        std::map<std::pair<int, int>, int> lassos; // (period, residue) -> least length
+        std::vector<int> fixed;
         for(const auto& cns : aut_constr) { // for each (c1, c2) representing lengths of var
-            LenNode c1(cns.first);
-            LenNode c2(cns.second);
-            LenNode k(util::mk_noodler_var_fresh("k"));
-
             if(cns.second != 0) {
-                // c1 + k*c2
-                LenNode right(LenFormulaType::PLUS, {c1, LenNode(LenFormulaType::TIMES, {k, c2})});
-                // add (var = c1 + k*c2 && 0 <= k) to result
-                res = LenNode(LenFormulaType::OR, 
-                                {res,
-                                 LenNode(LenFormulaType::AND,
-                                            {LenNode(LenFormulaType::EQ, {var, right}),
-                                             LenNode(LenFormulaType::LEQ, {LenNode(0), k})
-                                            })
-                                });
+                auto [it, inserted] = lassos.try_emplace({cns.second, cns.first % cns.second}, cns.first);
+                if(!inserted) {
+                    it->second = std::min(it->second, cns.first);
+                }
             } else {
+                fixed.push_back(cns.first);
+            }
+        }
+
+        // disjuncts are collected first, so that the disjunction is not copied for each of them
+        std::vector<LenNode> disjuncts;
+        for(int c1 : fixed) {
+            // lengths already covered by some lasso are skipped
+            bool subsumed = std::any_of(lassos.begin(), lassos.end(), [c1](const auto& lasso) {
+                return c1 >= lasso.second && c1 % lasso.first.first == lasso.first.second;
+            });
+            if(!subsumed) {
                 // add (var = c1) to result
-                res = LenNode(LenFormulaType::OR, {res, LenNode(LenFormulaType::EQ, {var, c1})});
+                disjuncts.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{var, c1});
+            }
+        }
+        for(const auto& [period_residue, least] : lassos) {
+            const auto& [period, residue] = period_residue;
+            LenNode lower(LenFormulaType::LEQ, {least, var});
+            if(period == 1) {
+                // add (c1 <= var) to result
+                disjuncts.push_back(std::move(lower));
+            } else {
+                // add (var mod c2 = c1 mod c2 && c1 <= var) to result
+                disjuncts.emplace_back(LenFormulaType::AND, std::vector<LenNode>{
+                                        LenNode(LenFormulaType::EQ, {LenNode(LenFormulaType::MOD, {var, period}), residue}),
+                                        std::move(lower)
+                                      });
             }
         }
 
         // to be safe, var must be >= 0
-        res = LenNode(LenFormulaType::AND, {res, LenNode(LenFormulaType::LEQ, {0, var})});
+        LenNode res(LenFormulaType::AND, {LenNode(LenFormulaType::OR, std::move(disjuncts)), LenNode(LenFormulaType::LEQ, {0, var})});
         return res;
     }
 
@@ -51,6 +105,126 @@ namespace smt::noodler {
         return nfa;
     }
 
+    std::optional<std::vector<mata::Symbol>> AutAssignment::get_word(const mata::nfa::Nfa& aut, std::optional<unsigned> length) {
+        // layers[i] maps the states reachable by words of length i to their predecessors (state and symbol) in layers[i-1]
+        using Predecessor = std::pair<mata::nfa::State, mata::Symbol>;
+        std::vector<std::unordered_map<mata::nfa::State, Predecessor>> layers(1);
+        // for shortest words, each state is visited only in the first layer in which it is reachable
+        std::unordered_set<mata::nfa::State> visited;
+        for (mata::nfa::State initial : aut.initial) {
+            layers[0].emplace(initial, Predecessor{initial, 0});
+            visited.insert(initial);
+        }
+
+        while (!layers.back().empty()) {
+            if (!length.has_value() || layers.size() - 1 == *length) {
+                for (const auto& [state, predecessor] : layers.back()) {
+                    if (!aut.final.contains(state)) {
+                        continue;
+                    }
+                    std::vector<mata::Symbol> word;
+                    mata::nfa::State current = state;
+                    for (size_t i = layers.size() - 1; i > 0; --i) {
+                        const Predecessor& pred = layers[i].at(current);
+                        word.push_back(pred.second);
+                        current = pred.first;
+                    }
+                    std::reverse(word.begin(), word.end());
+                    return word;
+                }
+                if (length.has_value()) {
+                    return std::nullopt;
+                }
+            }
+
+            std::unordered_map<mata::nfa::State, Predecessor> next_layer;
+            for (const auto& [state, predecessor] : layers.back()) {
+                for (const auto& symbol_post : aut.delta[state]) {
+                    for (mata::nfa::State target : symbol_post.targets) {
+                        if (!length.has_value() && !visited.insert(target).second) {
+                            continue;
+                        }
+                        next_layer.try_emplace(target, Predecessor{state, symbol_post.symbol});
+                    }
+                }
+            }
+            layers.push_back(std::move(next_layer));
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::set<std::vector<mata::Symbol>>> AutAssignment::get_finite_words(const mata::nfa::Nfa& aut, size_t max_words) {
+        mata::nfa::Nfa trimmed = aut;
+        trimmed.trim();
+        if (!trimmed.is_acyclic()) {
+            return std::nullopt;
+        }
+        // paths of the deterministic automaton correspond to words, so each word is enumerated once
+        mata::nfa::Nfa det = mata::nfa::determinize(trimmed);
+        det.trim();
+        std::set<std::vector<mata::Symbol>> words;
+        std::vector<mata::Symbol> word;
+        std::function<bool(mata::nfa::State)> collect = [&](mata::nfa::State state) {
+            if (det.final.contains(state)) {
+                words.insert(word);
+                if (words.size() > max_words) {
+                    return false;
+                }
+            }
+            for (const auto& symbol_post : det.delta[state]) {
+                for (mata::nfa::State target : symbol_post.targets) {
+                    word.push_back(symbol_post.symbol);
+                    bool ok = collect(target);
+                    word.pop_back();
+                    if (!ok) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+        for (mata::nfa::State initial : det.initial) {
+            if (!collect(initial)) {
+                return std::nullopt;
+            }
+        }
+        return words;
+    }
+
+    mata::nfa::Nfa AutAssignment::not_containing_word_nfa(const std::vector<mata::Symbol>& word, const std::set<mata::Symbol>& alphabet) {
+        assert(!word.empty());
+        const size_t n = word.size();
+        // state i means that the longest suffix of the read word that is a prefix of word has length i, reaching n
+        // means that word was read (that state is not created); all other states are final
+        mata::nfa::Nfa nfa(n, { 0 }, { 0 });
+        std::vector<mata::Symbol> symbols(alphabet.begin(), alphabet.end());
+        symbols.insert(symbols.end(), word.begin(), word.end());
+        std::sort(symbols.begin(), symbols.end());
+        symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+        // next[i][a] is the state after reading symbols[a] in state i (the standard construction of the KMP automaton,
+        // restart is the state in which the automaton is after reading word[1..i-1])
+        std::vector<std::vector<size_t>> next(n, std::vector<size_t>(symbols.size(), 0));
+        auto index_of = [&symbols](mata::Symbol symbol) {
+            return static_cast<size_t>(std::lower_bound(symbols.begin(), symbols.end(), symbol) - symbols.begin());
+        };
+        next[0][index_of(word[0])] = 1;
+        size_t restart = 0;
+        for (size_t i = 1; i < n; ++i) {
+            next[i] = next[restart];
+            next[i][index_of(word[i])] = i + 1;
+            restart = next[restart][index_of(word[i])];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            nfa.final.insert(i);
+            for (size_t a = 0; a < symbols.size(); ++a) {
+                if (next[i][a] < n) {
+                    nfa.delta.add(i, symbols[a], next[i][a]);
+                }
+            }
+        }
+        return nfa;
+    }
+
     std::vector<interval_word> AutAssignment::get_interval_words(const mata::nfa::Nfa& aut) {
         assert(aut.initial.size() == 1); // is deterministic and accepts a non-empty language
         assert(aut.is_acyclic()); // accepts a finite language
@@ -75,9 +249,7 @@ namespace smt::noodler {
                 // st - state reachable in n steps
                 // interval_words - interval words with whose we can reach st from the initial state
 
-                auto trans_from_st_it = aut.delta[st].begin();
-
-                if (trans_from_st_it == aut.delta[st].end()) {
+                if (aut.delta[st].empty()) {
                     // if there are no transitions, st must be final state (and there is no other state that can be reached in n number of steps)
                     assert(aut.final.contains(st));
                     assert(cur_level.size() == 1);
@@ -95,67 +267,252 @@ namespace smt::noodler {
                     return interval_words;
                 }
 
-                // From mata representation, symbols are ordered in aut.delta[st], so we can easily compute the intervals by checking
-                // for "change" of target of the next transition (aut is deterministic, so we always have just one target).
-                // For example, if we have transitions
-                //      st -5-> t1
-                //      st -6-> t1
-                //      st -8-> t1
-                //      st -9-> t2
-                //      st -10-> t2
-                //      st -11-> t2
-                //      st -12-> t3
-                // we get intervals
-                //      st -[5-6]-> t1
-                //      st -[8-8]-> t1
-                //      st -[9-11]-> t2
-                //      st -[12-12]-> t3
-
-                assert(trans_from_st_it->targets.size() == 1); // should be deterministic
-
-                // target of previous transition
-                mata::nfa::State last_target = *trans_from_st_it->targets.begin();
-                // symbol of previous transition
-                mata::Symbol last_symbol = trans_from_st_it->symbol;
-                // starting symbol of the interval we are currently computing
-                mata::Symbol last_starting_symbol = trans_from_st_it->symbol;
-
-                ++trans_from_st_it;
-
-                while (trans_from_st_it != aut.delta[st].end()) {
-                    assert(trans_from_st_it->targets.size() == 1); // should be deterministic
-
-                    mata::nfa::State cur_target = *trans_from_st_it->targets.begin();
-                    mata::nfa::State cur_symbol = trans_from_st_it->symbol;
-                    
-                    if (cur_target != last_target || cur_symbol != last_symbol+1) {
-                        // we should end the current interval, as the target changed, or there is a gap between symbols
-                        std::pair<mata::Symbol,mata::Symbol> cur_interval = {last_starting_symbol, last_symbol};
-                        
-                        // add the interval to all interval words with whose we reached st and add these interval words to state last_target
-                        for (auto vec_of_intervals : interval_words) {
-                            vec_of_intervals.push_back(cur_interval);
-                            next_level[last_target].push_back(vec_of_intervals);
-                        }
-
-                        // start new interval
-                        last_starting_symbol = cur_symbol;
+                for (const auto& [cur_interval, target] : get_interval_transitions(aut, st)) {
+                    // add the interval to all interval words with whose we reached st and add these interval words to state target
+                    for (auto vec_of_intervals : interval_words) {
+                        vec_of_intervals.push_back(cur_interval);
+                        next_level[target].push_back(vec_of_intervals);
                     }
-                    
-                    last_target = cur_target;
-                    last_symbol = cur_symbol;
-                    ++trans_from_st_it;
                 }
+            }
+            
+            cur_level = next_level;
+        }
+    }
+
+    std::vector<std::pair<std::pair<mata::Symbol,mata::Symbol>,mata::nfa::State>> AutAssignment::get_interval_transitions(const mata::nfa::Nfa& aut, mata::nfa::State state) {
+        std::vector<std::pair<std::pair<mata::Symbol,mata::Symbol>,mata::nfa::State>> res;
+
+        auto trans_from_st_it = aut.delta[state].begin();
+        if (trans_from_st_it == aut.delta[state].end()) {
+            return res;
+        }
+
+        // From mata representation, symbols are ordered in aut.delta[state], so we can easily compute the intervals by checking
+        // for "change" of target of the next transition (aut is deterministic, so we always have just one target).
+        // For example, if we have transitions
+        //      state -5-> t1
+        //      state -6-> t1
+        //      state -8-> t1
+        //      state -9-> t2
+        //      state -10-> t2
+        //      state -11-> t2
+        //      state -12-> t3
+        // we get intervals
+        //      state -[5-6]-> t1
+        //      state -[8-8]-> t1
+        //      state -[9-11]-> t2
+        //      state -[12-12]-> t3
+
+        assert(trans_from_st_it->targets.size() == 1); // should be deterministic
+
+        // target of previous transition
+        mata::nfa::State last_target = *trans_from_st_it->targets.begin();
+        // symbol of previous transition
+        mata::Symbol last_symbol = trans_from_st_it->symbol;
+        // starting symbol of the interval we are currently computing
+        mata::Symbol last_starting_symbol = trans_from_st_it->symbol;
+
+        ++trans_from_st_it;
 
-                // we need to also handle the last interval
+        while (trans_from_st_it != aut.delta[state].end()) {
+            assert(trans_from_st_it->targets.size() == 1); // should be deterministic
+
+            mata::nfa::State cur_target = *trans_from_st_it->targets.begin();
+            mata::nfa::State cur_symbol = trans_from_st_it->symbol;
+            
+            if (cur_target != last_target || cur_symbol != last_symbol+1) {
+                // we should end the current interval, as the target changed, or there is a gap between symbols
                 std::pair<mata::Symbol,mata::Symbol> cur_interval = {last_starting_symbol, last_symbol};
-                for (auto vec_of_intervals : interval_words) {
-                    vec_of_intervals.push_back(cur_interval);
-                    next_level[last_target].push_back(vec_of_intervals);
-                }
+                
+                res.push_back({cur_interval, last_target});
+
+                // start new interval
+                last_starting_symbol = cur_symbol;
             }
             
-            cur_level = next_level;
+            last_target = cur_target;
+            last_symbol = cur_symbol;
+            ++trans_from_st_it;
+        }
+
+        // we need to also handle the last interval
+        std::pair<mata::Symbol,mata::Symbol> cur_interval = {last_starting_symbol, last_symbol};
+        res.push_back({cur_interval, last_target});
+        return res;
+    }
+
+    size_t AutomataPool::structural_hash(const mata::nfa::Nfa& nfa) {
+        size_t res = nfa.num_of_states();
+        auto combine = [&res](size_t val) { res ^= val + 0x9e3779b9 + (res << 6) + (res >> 2); };
+        // initial and final states are not ordered, so their hashes are combined commutatively
+        size_t initial_hash = 0, final_hash = 0;
+        for (mata::nfa::State st : nfa.initial) {
+            initial_hash += std::hash<mata::nfa::State>{}(st) * 0x9e3779b9;
+        }
+        for (mata::nfa::State st : nfa.final) {
+            final_hash += std::hash<mata::nfa::State>{}(st) * 0x9e3779b9;
+        }
+        combine(initial_hash);
+        combine(final_hash);
+        for (mata::nfa::State st = 0; st < nfa.num_of_states(); ++st) {
+            for (const auto& symbol_post : nfa.delta[st]) {
+                combine(symbol_post.symbol);
+                for (mata::nfa::State target : symbol_post.targets) {
+                    combine(target);
+                }
+            }
+        }
+        return res;
+    }
+
+    bool AutomataPool::structurally_equal(const mata::nfa::Nfa& a, const mata::nfa::Nfa& b) {
+        if (a.num_of_states() != b.num_of_states() || a.initial.size() != b.initial.size() || a.final.size() != b.final.size()) {
+            return false;
+        }
+        for (mata::nfa::State st : a.initial) {
+            if (!b.initial.contains(st)) {
+                return false;
+            }
+        }
+        for (mata::nfa::State st : a.final) {
+            if (!b.final.contains(st)) {
+                return false;
+            }
+        }
+        for (mata::nfa::State st = 0; st < a.num_of_states(); ++st) {
+            auto it_a = a.delta[st].begin();
+            auto it_b = b.delta[st].begin();
+            for (; it_a != a.delta[st].end() && it_b != b.delta[st].end(); ++it_a, ++it_b) {
+                if (it_a->symbol != it_b->symbol || !(it_a->targets == it_b->targets)) {
+                    return false;
+                }
+            }
+            if (it_a != a.delta[st].end() || it_b != b.delta[st].end()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t AutomataPool::approx_bytes(const mata::nfa::Nfa& nfa) {
+        size_t bytes = sizeof(mata::nfa::Nfa) + (nfa.initial.size() + nfa.final.size()) * sizeof(mata::nfa::State);
+        for (mata::nfa::State s = 0; s < nfa.num_of_states(); ++s) {
+            bytes += sizeof(mata::nfa::StatePost);
+            for (const auto& symbol_post : nfa.delta[s]) {
+                bytes += sizeof(mata::nfa::SymbolPost) + symbol_post.targets.size() * sizeof(mata::nfa::State);
+            }
+        }
+        return bytes;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> AutomataPool::intern_ptr(const std::shared_ptr<mata::nfa::Nfa>& nfa) {
+        auto it = this->interned.find(nfa);
+        if (it != this->interned.end()) {
+            return *it;
+        }
+        if (this->interned.size() >= MAX_INTERNED) {
+            STRACE("str-aut-pool", tout << "automata pool is full, dropping " << this->interned.size() << " automata" << std::endl;);
+            reset();
+            ++this->generation;
+        }
+        this->interned.insert(nfa);
+        this->interned_bytes += approx_bytes(*nfa);
+        return nfa;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> AutomataPool::intern(mata::nfa::Nfa nfa) {
+        // the pool does not keep pointers to (possibly local) mata alphabets
+        nfa.alphabet = nullptr;
+        return intern_ptr(std::make_shared<mata::nfa::Nfa>(std::move(nfa)));
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> AutomataPool::get_sigma_star(const std::set<mata::Symbol>& alphabet) {
+        auto it = this->sigma_stars.find(alphabet);
+        if (it != this->sigma_stars.end()) {
+            return it->second;
+        }
+        mata::EnumAlphabet mata_alphabet(alphabet.begin(), alphabet.end());
+        auto nfa = intern(mata::nfa::builder::create_sigma_star_nfa(&mata_alphabet));
+        this->sigma_stars[alphabet] = nfa;
+        return nfa;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> AutomataPool::get_word(const zstring& word) {
+        auto it = this->words.find(word);
+        if (it != this->words.end()) {
+            return it->second;
+        }
+        auto nfa = intern(AutAssignment::create_word_nfa(word));
+        this->words[word] = nfa;
+        return nfa;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> AutomataPool::get_intersection(const std::shared_ptr<mata::nfa::Nfa>& aut1, const std::shared_ptr<mata::nfa::Nfa>& aut2) {
+        unsigned start_generation = this->generation;
+        std::shared_ptr<mata::nfa::Nfa> shared1 = intern_ptr(aut1);
+        std::shared_ptr<mata::nfa::Nfa> shared2 = intern_ptr(aut2);
+        if (shared1 == shared2) {
+            // identical (shared) automata, e.g., more memberships of a variable with the same regex
+            return shared1;
+        }
+        // intersection is commutative (up to the structure of the result, which does not matter here)
+        aut_pair key{shared1.get(), shared2.get()};
+        if (key.second < key.first) {
+            std::swap(key.first, key.second);
+        }
+        auto it = this->intersections.find(key);
+        if (it != this->intersections.end()) {
+            return it->second;
+        }
+        auto res = intern(mata::nfa::reduce(intersect(*shared1, *shared2)));
+        if (this->intersections.size() >= MAX_MEMOIZED) {
+            this->intersections.clear();
+        }
+        // if the pool was dropped in the meantime, the pointers in the key are not kept alive by the pool anymore
+        if (this->generation == start_generation) {
+            this->intersections[key] = res;
+        }
+        return res;
+    }
+
+    bool AutomataPool::is_included(const std::shared_ptr<mata::nfa::Nfa>& aut1, const std::shared_ptr<mata::nfa::Nfa>& aut2) {
+        unsigned start_generation = this->generation;
+        std::shared_ptr<mata::nfa::Nfa> shared1 = intern_ptr(aut1);
+        std::shared_ptr<mata::nfa::Nfa> shared2 = intern_ptr(aut2);
+        if (shared1 == shared2) {
+            return true;
+        }
+        if (this->generation != start_generation) {
+            // the pool was dropped while interning, shared1 is not kept alive by the pool anymore
+            return mata::nfa::is_included(*shared1, *shared2);
+        }
+        aut_pair key{shared1.get(), shared2.get()};
+        auto it = this->inclusions.find(key);
+        if (it != this->inclusions.end()) {
+            return it->second;
+        }
+        bool res = mata::nfa::is_included(*shared1, *shared2);
+        if (this->inclusions.size() >= MAX_MEMOIZED) {
+            this->inclusions.clear();
+        }
+        this->inclusions[key] = res;
+        return res;
+    }
+
+    const std::set<std::pair<int, int>>& LengthAbstractionCache::get_word_lengths(const std::shared_ptr<mata::nfa::Nfa>& aut) {
+        auto it = abstractions.find(aut.get());
+        if (it != abstractions.end()) {
+            ++hits;
+            return it->second.second;
+        }
+        if (abstractions.size() >= MAX_MEMOIZED) {
+            reset();
         }
+        const std::set<std::pair<int, int>>& lengths = abstractions.emplace(aut.get(), std::make_pair(aut, mata::strings::get_word_lengths(*aut))).first->second.second;
+        // the node of the map and the nodes of the set
+        bytes += sizeof(const mata::nfa::Nfa*) + sizeof(std::shared_ptr<mata::nfa::Nfa>) + 2 * sizeof(void*)
+            + lengths.size() * (sizeof(std::pair<int, int>) + 3 * sizeof(void*));
+        return lengths;
     }
 }
@@ -8,12 +8,16 @@
 #include <queue>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
 
 #include <mata/nfa/nfa.hh>
 #include <mata/nfa/strings.hh>
 #include <mata/nfa/builder.hh>
 
 #include "formula.h"
+#include "nfa_product.h"
 
 namespace smt::noodler {
 
@@ -86,38 +90,56 @@ namespace smt::noodler {
 
         /**
          * @brief Returns automaton that accept non-empty words containing only symbols encoding digits (symbols from 48 to 57)
+         *
+         * The digit automata do not depend on the alphabet, so each of them is created only once.
          */
-        static mata::nfa::Nfa digit_automaton() {
-            mata::nfa::Nfa only_digits_aut(2, {0}, {1});
-            for (mata::Symbol digit = DIGIT_SYMBOL_START; digit <= DIGIT_SYMBOL_END; ++digit) {
-                only_digits_aut.delta.add(0, digit, 1);
-                only_digits_aut.delta.add(1, digit, 1);
-            }
+        static const mata::nfa::Nfa& digit_automaton() {
+            static const mata::nfa::Nfa only_digits_aut = [] {
+                mata::nfa::Nfa res(2, {0}, {1});
+                for (mata::Symbol digit = DIGIT_SYMBOL_START; digit <= DIGIT_SYMBOL_END; ++digit) {
+                    res.delta.add(0, digit, 1);
+                    res.delta.add(1, digit, 1);
+                }
+                return res;
+            }();
             return only_digits_aut;
         }
 
         /**
          * @brief Returns automaton that accept (possibly empty) words containing only symbols encoding digits (symbols from 48 to 57)
          */
-        static mata::nfa::Nfa digit_automaton_with_epsilon() {
-            mata::nfa::Nfa only_digits_and_epsilon(1, {0}, {0});
-            for (mata::Symbol digit = AutAssignment::DIGIT_SYMBOL_START; digit <= AutAssignment::DIGIT_SYMBOL_END; ++digit) {
-                only_digits_and_epsilon.delta.add(0, digit, 0);
-            }
+        static const mata::nfa::Nfa& digit_automaton_with_epsilon() {
+            static const mata::nfa::Nfa only_digits_and_epsilon = [] {
+                mata::nfa::Nfa res(1, {0}, {0});
+                for (mata::Symbol digit = AutAssignment::DIGIT_SYMBOL_START; digit <= AutAssignment::DIGIT_SYMBOL_END; ++digit) {
+                    res.delta.add(0, digit, 0);
+                }
+                return res;
+            }();
             return only_digits_and_epsilon;
         }
 
         /**
          * @brief Returns automaton that accept words of length @p length containing only symbols encoding digits (symbols from 48 to 57)
+         *
+         * The automata are created once for each length (they can be requested by more decision procedures running concurrently).
          */
-        static mata::nfa::Nfa digit_automaton_of_length(unsigned length) {
-            mata::nfa::Nfa only_digits_of_length(length+1, {0}, {length});
-            for (unsigned i = 0; i < length; ++i) {
-                for (mata::Symbol digit = AutAssignment::DIGIT_SYMBOL_START; digit <= AutAssignment::DIGIT_SYMBOL_END; ++digit) {
-                    only_digits_of_length.delta.add(i, digit, i+1);
+        static const mata::nfa::Nfa& digit_automaton_of_length(unsigned length) {
+            static std::mutex mutex;
+            static std::map<unsigned, mata::nfa::Nfa> digit_automata;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = digit_automata.find(length);
+            if (it == digit_automata.end()) {
+                mata::nfa::Nfa only_digits_of_length(length+1, {0}, {length});
+                for (unsigned i = 0; i < length; ++i) {
+                    for (mata::Symbol digit = AutAssignment::DIGIT_SYMBOL_START; digit <= AutAssignment::DIGIT_SYMBOL_END; ++digit) {
+                        only_digits_of_length.delta.add(i, digit, i+1);
+                    }
                 }
+                it = digit_automata.emplace(length, std::move(only_digits_of_length)).first;
             }
-            return only_digits_of_length;
+            // map nodes are not moved by later insertions, so the reference stays valid
+            return it->second;
         }
 
         /**
@@ -138,12 +160,36 @@ namespace smt::noodler {
          */
         static std::vector<interval_word> get_interval_words(const mata::nfa::Nfa& aut);
 
+        /**
+         * @brief Get the transitions from @p state of deterministic @p aut grouped into intervals of symbols with the same target
+         *
+         * For example, transitions state -5-> t1, state -6-> t1, state -8-> t1, state -9-> t2 are grouped into
+         *      ([5-6], t1), ([8-8], t1), ([9-9], t2)
+         */
+        static std::vector<std::pair<std::pair<mata::Symbol,mata::Symbol>,mata::nfa::State>> get_interval_transitions(const mata::nfa::Nfa& aut, mata::nfa::State state);
+
+        /**
+         * @brief Get the concatenation of the automata of @p concat.
+         *
+         * The automata are concatenated as a balanced tree, so each state is copied only logarithmically many
+         * times (instead of once for each following term as in the concatenation from left to right).
+         */
         mata::nfa::Nfa get_automaton_concat(const std::vector<BasicTerm>& concat) const {
-            mata::nfa::Nfa ret = mata::nfa::builder::create_empty_string_nfa();
-            for(const BasicTerm& t : concat) {
-                ret = mata::nfa::concatenate(ret, *(this->at(t)));  // fails when not found
+            if(concat.empty()) {
+                return mata::nfa::builder::create_empty_string_nfa();
             }
-            return ret;
+            return get_automaton_concat(concat, 0, concat.size());
+        }
+
+        /**
+         * @brief Get the concatenation of the automata of the (nonempty) range @p from .. @p to - 1 of @p concat.
+         */
+        mata::nfa::Nfa get_automaton_concat(const std::vector<BasicTerm>& concat, size_t from, size_t to) const {
+            if(to - from == 1) {
+                return *(this->at(concat[from]));  // fails when not found
+            }
+            const size_t middle = from + (to - from) / 2;
+            return mata::nfa::concatenate(get_automaton_concat(concat, from, middle), get_automaton_concat(concat, middle, to));
         }
 
         /**
@@ -225,7 +271,7 @@ namespace smt::noodler {
         bool are_disjoint(const BasicTerm &t1, const BasicTerm& t2) const {
             mata::nfa::Nfa aut_t1 = *this->at(t1);
             mata::nfa::Nfa aut_t2 = *this->at(t2);
-            return  mata::nfa::intersection(aut_t1, aut_t2).is_lang_empty();
+            return  intersect(aut_t1, aut_t2).is_lang_empty();
         }
 
         /**
@@ -246,13 +292,31 @@ namespace smt::noodler {
         }
 
         /**
-         * @brief Check if all automata in the map have non-empty language.
+         * @brief Get the length of the longest word of the language of @p t (std::nullopt if the language is infinite).
+         */
+        std::optional<unsigned> get_max_length(const BasicTerm& t) const {
+            std::optional<unsigned> max_len = 0;
+            for (const auto& [c1, c2] : mata::strings::get_word_lengths(*this->at(t))) {
+                if (c2 != 0) {
+                    return std::nullopt;
+                }
+                max_len = std::max(*max_len, static_cast<unsigned>(c1));
+            }
+            return max_len;
+        }
+
+        /**
+         * @brief Check if all automata in the map have non-empty language (automata shared by more terms are checked once).
          *
          * @return true All have non-empty language
          * @return false There is at least one NFA with the empty language
          */
         bool is_sat() const {
+            std::unordered_set<const mata::nfa::Nfa*> checked;
             for (const auto& pr : *this) {
+                if (!checked.insert(pr.second.get()).second) {
+                    continue;
+                }
                 if(pr.second->final.size() == 0) {
                     return false;
                 }
@@ -263,11 +327,23 @@ namespace smt::noodler {
         }
 
         /**
-         * @brief Reduce all automata occurring in the map.
+         * @brief Replace structurally identical automata (see AutomataPool::structurally_equal) by one shared pointer,
+         * so that the results computed for automata (emptiness, lengths, reductions) are computed once for each of them.
+         */
+        void deduplicate();
+
+        /**
+         * @brief Reduce all automata occurring in the map (identical automata are deduplicated and reduced once).
          */
         void reduce() {
-             for (auto& pr : *this) {
-                pr.second = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(*pr.second));
+            deduplicate();
+            std::unordered_map<const mata::nfa::Nfa*, std::shared_ptr<mata::nfa::Nfa>> reduced;
+            for (auto& pr : *this) {
+                auto [it, inserted] = reduced.try_emplace(pr.second.get());
+                if (inserted) {
+                    it->second = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(*pr.second));
+                }
+                pr.second = it->second;
             }
         }
 
@@ -300,7 +376,7 @@ namespace smt::noodler {
          * @param restr_nfa Language restriction represented by an NFA.
          */
         void restrict_lang(const BasicTerm& t, const mata::nfa::Nfa& restr_nfa) {
-            (*this)[t] = std::make_shared<mata::nfa::Nfa>(mata::nfa::intersection(restr_nfa, *this->at(t)));
+            (*this)[t] = std::make_shared<mata::nfa::Nfa>(intersect(restr_nfa, *this->at(t)));
         }
 
         /**
@@ -308,11 +384,26 @@ namespace smt::noodler {
          */
         LenNode get_lengths(const BasicTerm& var) const;
 
+        /// lengths of words of automata (see mata::strings::get_word_lengths) keyed by their identity
+        using WordLengthsMemo = std::unordered_map<const mata::nfa::Nfa*, std::set<std::pair<int, int>>>;
+
+        /**
+         * @brief Get the length formula of @p var as get_lengths(var), the lengths of its automaton are taken from
+         * (or added to) @p memo.
+         */
+        LenNode get_lengths(const BasicTerm& var, WordLengthsMemo& memo) const;
+
         /**
          * @brief Get the lengths formula representing all possible lengths of the automaton for @p var and corresponding NFA @p aut.
          */
         static LenNode get_lengths(const mata::nfa::Nfa& aut, const BasicTerm& var);
 
+        /**
+         * @brief Get the lengths formula for @p var from the lengths @p word_lengths of its words,
+         * each (c1, c2) represents lengths c1 + k*c2 for k >= 0 (see mata::strings::get_word_lengths).
+         */
+        static LenNode get_lengths(const std::set<std::pair<int, int>>& word_lengths, const BasicTerm& var);
+
         /**
          * Create NFA accepting a word in Z3 zstring representation.
          * @param word Word to accept.
@@ -320,13 +411,33 @@ namespace smt::noodler {
          */
         static mata::nfa::Nfa create_word_nfa(const zstring& word);
 
+        /**
+         * @brief Get a word of @p aut of length @p length (a shortest word if @p length is std::nullopt), or
+         * std::nullopt if there is no such word. The word consists of the symbols of transitions of @p aut
+         * (so it can contain the dummy symbol).
+         */
+        static std::optional<std::vector<mata::Symbol>> get_word(const mata::nfa::Nfa& aut, std::optional<unsigned> length = std::nullopt);
+
+        /**
+         * @brief Get all words of @p aut if its language is finite and has at most @p max_words words
+         * (std::nullopt otherwise).
+         */
+        static std::optional<std::set<std::vector<mata::Symbol>>> get_finite_words(const mata::nfa::Nfa& aut, size_t max_words);
+
+        /**
+         * @brief Get the deterministic automaton of the words over @p alphabet that do not contain the non-empty
+         * @p word as a factor (the complement of Σ*·word·Σ*). It is constructed directly as the automaton of the
+         * prefixes of @p word matched by the Knuth-Morris-Pratt algorithm, without determinizing Σ*·word·Σ*.
+         */
+        static mata::nfa::Nfa not_containing_word_nfa(const std::vector<mata::Symbol>& word, const std::set<mata::Symbol>& alphabet);
+
         /**
          * @brief Complement the given automaton wrt the alphabet induced by the AutAssignment.
          * 
          * @param aut Automaton to be complemented
          * @return mata::nfa::Nfa 
          */
-        mata::nfa::Nfa complement_aut(mata::nfa::Nfa& aut) {
+        mata::nfa::Nfa complement_aut(const mata::nfa::Nfa& aut) {
             auto alphabet =  this->get_alphabet(false);
             mata::OnTheFlyAlphabet mata_alphabet{};
             for (const auto& symbol : alphabet) {
@@ -347,6 +458,143 @@ namespace smt::noodler {
 
     };
 
+    /**
+     * @brief Pool of automata shared by the aut assignments of one solver session.
+     *
+     * Automata that are created many times for the same input (sigma star for an alphabet, word NFAs
+     * for literals) are created only once and shared. Other automata can be interned, so that structurally
+     * identical automata are represented by one pointer, which allows memoizing intersections and
+     * inclusions of identical pairs. Automata obtained from the pool must not be modified in place
+     * (replace the pointer in the aut assignment instead, as everywhere else).
+     */
+    class AutomataPool {
+    private:
+        struct NfaHash {
+            size_t operator()(const std::shared_ptr<mata::nfa::Nfa>& nfa) const { return AutomataPool::structural_hash(*nfa); }
+        };
+        struct NfaEqual {
+            bool operator()(const std::shared_ptr<mata::nfa::Nfa>& a, const std::shared_ptr<mata::nfa::Nfa>& b) const {
+                return AutomataPool::structurally_equal(*a, *b);
+            }
+        };
+        using aut_pair = std::pair<const mata::nfa::Nfa*, const mata::nfa::Nfa*>;
+
+        std::unordered_set<std::shared_ptr<mata::nfa::Nfa>, NfaHash, NfaEqual> interned;
+        std::map<std::set<mata::Symbol>, std::shared_ptr<mata::nfa::Nfa>> sigma_stars;
+        // word NFAs do not depend on the alphabet, so they are keyed only by the literal
+        std::map<zstring, std::shared_ptr<mata::nfa::Nfa>> words;
+        // memoized results for pairs of interned automata (the interned set keeps the pointers valid)
+        std::map<aut_pair, std::shared_ptr<mata::nfa::Nfa>> intersections;
+        std::map<aut_pair, bool> inclusions;
+        // increased whenever the pool is dropped because it is full
+        unsigned generation = 0;
+        // approximate memory of the interned automata
+        size_t interned_bytes = 0;
+
+        // the memoized results are dropped after reaching this number of entries, the whole pool after
+        // reaching this number of interned automata (already shared automata stay valid)
+        static const size_t MAX_MEMOIZED = 5000;
+        static const size_t MAX_INTERNED = 5000;
+
+        std::shared_ptr<mata::nfa::Nfa> intern_ptr(const std::shared_ptr<mata::nfa::Nfa>& nfa);
+
+    public:
+        AutomataPool() = default;
+
+        static size_t structural_hash(const mata::nfa::Nfa& nfa);
+        static bool structurally_equal(const mata::nfa::Nfa& a, const mata::nfa::Nfa& b);
+
+        /**
+         * @brief Get the approximate memory of @p nfa in bytes (its states and transitions).
+         */
+        static size_t approx_bytes(const mata::nfa::Nfa& nfa);
+
+        /**
+         * @brief Get the shared automaton structurally identical to @p nfa (interning @p nfa if there is none yet).
+         */
+        std::shared_ptr<mata::nfa::Nfa> intern(mata::nfa::Nfa nfa);
+
+        /**
+         * @brief Get the shared sigma star automaton over @p alphabet (without a pointer to a mata alphabet).
+         */
+        std::shared_ptr<mata::nfa::Nfa> get_sigma_star(const std::set<mata::Symbol>& alphabet);
+
+        /**
+         * @brief Get the shared automaton accepting only @p word (see AutAssignment::create_word_nfa).
+         */
+        std::shared_ptr<mata::nfa::Nfa> get_word(const zstring& word);
+
+        /**
+         * @brief Get the (interned) reduced intersection of @p aut1 and @p aut2, computing it only if it is not memoized.
+         */
+        std::shared_ptr<mata::nfa::Nfa> get_intersection(const std::shared_ptr<mata::nfa::Nfa>& aut1, const std::shared_ptr<mata::nfa::Nfa>& aut2);
+
+        /**
+         * @brief Check whether L(@p aut1) is included in L(@p aut2), computing it only if it is not memoized.
+         */
+        bool is_included(const std::shared_ptr<mata::nfa::Nfa>& aut1, const std::shared_ptr<mata::nfa::Nfa>& aut2);
+
+        void reset() {
+            intersections.clear();
+            inclusions.clear();
+            sigma_stars.clear();
+            words.clear();
+            interned.clear();
+            interned_bytes = 0;
+        }
+
+        size_t size() const { return interned.size(); }
+
+        /**
+         * @brief Get the approximate memory of the pool in bytes (the memoized entries are counted as map nodes).
+         */
+        size_t get_bytes() const {
+            return interned_bytes + interned.size() * (sizeof(std::shared_ptr<mata::nfa::Nfa>) + 2 * sizeof(void*))
+                + (sigma_stars.size() + words.size() + intersections.size() + inclusions.size()) * (sizeof(aut_pair) + 4 * sizeof(void*));
+        }
+    };
+
+    /**
+     * @brief Memo of length abstractions of automata (semilinear sets of lengths of their words, see
+     * mata::strings::get_word_lengths), keyed by the identity of automata.
+     *
+     * Automata of memberships are interned in AutomataPool, so they keep their identity between final checks
+     * and the lengths of unchanged memberships are extracted only once.
+     */
+    class LengthAbstractionCache {
+    private:
+        // the automaton is kept alive, so that its address is not reused by another automaton
+        std::unordered_map<const mata::nfa::Nfa*, std::pair<std::shared_ptr<mata::nfa::Nfa>, std::set<std::pair<int, int>>>> abstractions;
+        unsigned hits = 0;
+        // approximate memory of the abstractions
+        size_t bytes = 0;
+
+        static const size_t MAX_MEMOIZED = 5000;
+
+    public:
+        /**
+         * @brief Get the (memoized) lengths of words of @p aut.
+         */
+        const std::set<std::pair<int, int>>& get_word_lengths(const std::shared_ptr<mata::nfa::Nfa>& aut);
+
+        /**
+         * @brief Get the length formula representing all possible lengths of the automaton for @p var in @p aut_ass
+         * (see AutAssignment::get_lengths).
+         */
+        LenNode get_lengths(const AutAssignment& aut_ass, const BasicTerm& var) {
+            return AutAssignment::get_lengths(get_word_lengths(aut_ass.at(var)), var);
+        }
+
+        unsigned get_hits() const { return hits; }
+
+        size_t get_bytes() const { return bytes; }
+
+        void reset() {
+            abstractions.clear();
+            bytes = 0;
+        }
+    };
+
 } // Namespace smt::noodler.
 
 #endif //Z3_STR_AUT_ASSIGNMENT_H_
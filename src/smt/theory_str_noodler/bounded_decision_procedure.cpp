@@ -0,0 +1,397 @@
+#include <deque>
+
+#include "bounded_decision_procedure.h"
+
+namespace smt::noodler {
+
+    namespace {
+        // the SAT solver is run in slices of this many steps, so that the computation can be cancelled between them
+        constexpr unsigned RLIMIT_SLICE = 1000000;
+        // encodings with more position-symbol pairs of the sides of predicates are not built
+        constexpr uint64_t MAX_ENCODING_SIZE = 20000000;
+    }
+
+    BoundedStringProcedure::BoundedStringProcedure(const Formula& form, const AutAssignment& aut_ass,
+                                                   const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                                   const theory_str_noodler_params& par)
+        : formula(form), aut_ass(aut_ass), init_length_sensitive_vars(init_length_sensitive_vars), length_bound(par.m_bounded_length) { }
+
+    sat::literal BoundedStringProcedure::mk_lit() {
+        return sat::literal(solver->mk_var(), false);
+    }
+
+    void BoundedStringProcedure::add_clause(std::vector<sat::literal> lits) {
+        // the constant literals are simplified away
+        size_t j = 0;
+        for (sat::literal lit : lits) {
+            if (lit == true_lit) {
+                return;
+            }
+            if (lit != ~true_lit) {
+                lits[j++] = lit;
+            }
+        }
+        lits.resize(j);
+        solver->mk_clause(lits.size(), lits.data());
+    }
+
+    BoundedStringProcedure::Str BoundedStringProcedure::mk_str(unsigned bound) {
+        Str s;
+        s.bound = bound;
+        for (unsigned i = 0; i < bound; ++i) {
+            s.len.push_back(mk_lit());
+            if (i > 0) {
+                add_clause({ ~s.len[i], s.len[i - 1] });
+            }
+            std::vector<sat::literal> chr;
+            std::vector<sat::literal> some_symbol{ ~s.len[i] };
+            for (size_t a = 0; a < alphabet.size(); ++a) {
+                chr.push_back(mk_lit());
+                // positions beyond the length have no symbol
+                add_clause({ ~chr[a], s.len[i] });
+                some_symbol.push_back(chr[a]);
+                for (size_t b = 0; b < a; ++b) {
+                    add_clause({ ~chr[a], ~chr[b] });
+                }
+            }
+            add_clause(std::move(some_symbol));
+            s.chr.push_back(std::move(chr));
+        }
+        return s;
+    }
+
+    BoundedStringProcedure::Str BoundedStringProcedure::mk_literal_str(const zstring& word) {
+        Str s;
+        s.bound = word.length();
+        for (unsigned i = 0; i < word.length(); ++i) {
+            s.len.push_back(true_lit);
+            std::vector<sat::literal> chr(alphabet.size(), ~true_lit);
+            // the symbol of a literal is never the dummy one, so it has a single index
+            chr[symbol_indices.at(word[i])[0]] = true_lit;
+            s.chr.push_back(std::move(chr));
+        }
+        return s;
+    }
+
+    sat::literal BoundedStringProcedure::exact_len(Str& s, unsigned l) {
+        if (l > s.bound) {
+            return ~true_lit;
+        }
+        if (s.exact_len.empty()) {
+            s.exact_len.assign(s.bound + 1, sat::null_literal);
+        }
+        if (s.exact_len[l] != sat::null_literal) {
+            return s.exact_len[l];
+        }
+        // the length is l iff the string is longer than l - 1 and not longer than l
+        sat::literal longer = l == 0 ? true_lit : s.len[l - 1];
+        sat::literal not_longer = l == s.bound ? true_lit : ~s.len[l];
+        sat::literal res;
+        if (longer == ~true_lit || not_longer == ~true_lit) {
+            res = ~true_lit;
+        } else if (longer == true_lit) {
+            res = not_longer;
+        } else if (not_longer == true_lit) {
+            res = longer;
+        } else {
+            res = mk_lit();
+            add_clause({ ~res, longer });
+            add_clause({ ~res, not_longer });
+            add_clause({ res, ~longer, ~not_longer });
+        }
+        s.exact_len[l] = res;
+        return res;
+    }
+
+    void BoundedStringProcedure::encode_membership(Str& s, const mata::nfa::Nfa& aut) {
+        // states[i][q]: the run of the automaton is in q after reading i symbols (created for reachable states only)
+        std::vector<std::unordered_map<mata::nfa::State, sat::literal>> states(s.bound + 1);
+        std::vector<sat::literal> some_initial;
+        for (mata::nfa::State q : aut.initial) {
+            states[0].emplace(q, mk_lit());
+            some_initial.push_back(states[0].at(q));
+        }
+        add_clause(std::move(some_initial));
+        for (unsigned i = 0; i <= s.bound; ++i) {
+            for (const auto& [q, lit] : states[i]) {
+                // the word ends in q only if q is final
+                if (!aut.final.contains(q)) {
+                    add_clause({ ~lit, i < s.bound ? s.len[i] : ~true_lit });
+                }
+                if (i == s.bound) {
+                    continue;
+                }
+                std::vector<std::vector<sat::literal>> successors(alphabet.size());
+                for (const auto& symbol_post : aut.delta[q]) {
+                    auto it = symbol_indices.find(symbol_post.symbol);
+                    if (it == symbol_indices.end()) {
+                        continue;
+                    }
+                    for (mata::nfa::State target : symbol_post.targets) {
+                        auto [target_it, inserted] = states[i + 1].try_emplace(target, sat::null_literal);
+                        if (inserted) {
+                            target_it->second = mk_lit();
+                        }
+                        for (unsigned a : it->second) {
+                            successors[a].push_back(target_it->second);
+                        }
+                    }
+                }
+                for (size_t a = 0; a < alphabet.size(); ++a) {
+                    std::vector<sat::literal> clause{ ~lit, ~s.len[i], ~s.chr[i][a] };
+                    clause.insert(clause.end(), successors[a].begin(), successors[a].end());
+                    add_clause(std::move(clause));
+                }
+            }
+        }
+    }
+
+    void BoundedStringProcedure::encode_side(std::vector<Str*> terms, Str& side) {
+        // offsets[p]: the current term starts at position p of the side
+        std::vector<sat::literal> offsets(side.bound + 1, sat::null_literal);
+        offsets[0] = true_lit;
+        for (Str* t : terms) {
+            std::vector<sat::literal> next(side.bound + 1, sat::null_literal);
+            for (unsigned p = 0; p <= side.bound; ++p) {
+                if (offsets[p] == sat::null_literal) {
+                    continue;
+                }
+                // the symbols of the term are the symbols of the side from p
+                for (unsigned i = 0; i < t->bound; ++i) {
+                    if (p + i >= side.bound) {
+                        add_clause({ ~offsets[p], ~t->len[i] });
+                        break;
+                    }
+                    for (size_t a = 0; a < alphabet.size(); ++a) {
+                        add_clause({ ~offsets[p], ~t->len[i], ~t->chr[i][a], side.chr[p + i][a] });
+                    }
+                }
+                // the next term starts after the term
+                for (unsigned l = 0; l <= t->bound; ++l) {
+                    sat::literal len_l = exact_len(*t, l);
+                    if (len_l == ~true_lit) {
+                        continue;
+                    }
+                    if (p + l > side.bound) {
+                        add_clause({ ~offsets[p], ~len_l });
+                        continue;
+                    }
+                    if (next[p + l] == sat::null_literal) {
+                        next[p + l] = mk_lit();
+                    }
+                    add_clause({ ~offsets[p], ~len_l, next[p + l] });
+                }
+            }
+            offsets = std::move(next);
+        }
+        for (unsigned p = 0; p <= side.bound; ++p) {
+            if (offsets[p] != sat::null_literal) {
+                add_clause({ ~offsets[p], exact_len(side, p) });
+            }
+        }
+    }
+
+    void BoundedStringProcedure::encode_predicate(const Predicate& pred) {
+        // strings of literals are kept until the predicate is encoded
+        std::deque<Str> literal_strs;
+        auto get_terms = [&](const Concat& side, unsigned& bound) {
+            std::vector<Str*> terms;
+            bound = 0;
+            for (const BasicTerm& term : side) {
+                if (term.is_literal()) {
+                    literal_strs.push_back(mk_literal_str(term.get_name()));
+                    terms.push_back(&literal_strs.back());
+                } else {
+                    terms.push_back(&var_strs.at(term));
+                }
+                bound += terms.back()->bound;
+            }
+            return terms;
+        };
+        unsigned left_bound, right_bound;
+        std::vector<Str*> left = get_terms(pred.get_left_side(), left_bound);
+        std::vector<Str*> right = get_terms(pred.get_right_side(), right_bound);
+
+        if (pred.is_equation()) {
+            // both sides are placed into the same string
+            Str side = mk_str(std::min(left_bound, right_bound));
+            encode_side(left, side);
+            encode_side(right, side);
+            return;
+        }
+
+        Str left_side = mk_str(left_bound);
+        Str right_side = mk_str(right_bound);
+        encode_side(left, left_side);
+        encode_side(right, right_side);
+        // the sides have different lengths or they differ in a symbol at some position
+        std::vector<sat::literal> differ;
+        for (unsigned l = 0; l <= left_bound; ++l) {
+            sat::literal left_len = exact_len(left_side, l);
+            if (left_len == ~true_lit) {
+                continue;
+            }
+            sat::literal d = mk_lit();
+            add_clause({ ~d, left_len });
+            add_clause({ ~d, ~exact_len(right_side, l) });
+            differ.push_back(d);
+        }
+        for (unsigned p = 0; p < std::min(left_bound, right_bound); ++p) {
+            for (size_t a = 0; a < alphabet.size(); ++a) {
+                sat::literal d = mk_lit();
+                add_clause({ ~d, left_side.chr[p][a] });
+                add_clause({ ~d, right_side.len[p] });
+                add_clause({ ~d, ~right_side.chr[p][a] });
+                differ.push_back(d);
+            }
+        }
+        add_clause(std::move(differ));
+    }
+
+    void BoundedStringProcedure::init_computation() {
+        solver = std::make_unique<sat::solver>(params_ref(), limit);
+        true_lit = mk_lit();
+        solver->mk_clause(1, &true_lit);
+
+        std::set<mata::Symbol> symbols;
+        bool has_disequations = false;
+        for (const Predicate& pred : formula.get_predicates()) {
+            if (!pred.is_eq_or_ineq()) {
+                // not supported
+                failed = true;
+                return;
+            }
+            has_disequations |= pred.is_inequation();
+            for (const Concat& side : pred.get_params()) {
+                for (const BasicTerm& term : side) {
+                    if (term.is_literal()) {
+                        for (unsigned i = 0; i < term.get_name().length(); ++i) {
+                            symbols.insert(term.get_name()[i]);
+                        }
+                    } else if (!aut_ass.contains(term)) {
+                        failed = true;
+                        return;
+                    }
+                }
+            }
+        }
+        for (mata::Symbol s : aut_ass.get_alphabet(true)) {
+            symbols.insert(s);
+        }
+        for (mata::Symbol s : symbols) {
+            symbol_indices[s].push_back(alphabet.size());
+            alphabet.push_back(s);
+        }
+        if (has_disequations && symbol_indices.contains(get_dummy_symbol())) {
+            // the dummy symbol stands for all symbols not occurring in the formula, two of them can differ
+            symbol_indices[get_dummy_symbol()].push_back(alphabet.size());
+            alphabet.push_back(get_dummy_symbol());
+        }
+
+        for (const auto& [var, aut] : aut_ass) {
+            if (!var.is_variable()) {
+                continue;
+            }
+            std::optional<unsigned> max_len = aut_ass.get_max_length(var);
+            if (!max_len.has_value() || *max_len > length_bound) {
+                complete = false;
+            }
+            var_strs.emplace(var, Str{});
+            var_strs.at(var).bound = max_len.has_value() ? std::min(*max_len, length_bound) : length_bound;
+        }
+
+        // the clauses of the sides of predicates dominate the size of the encoding
+        uint64_t size = 0;
+        for (const Predicate& pred : formula.get_predicates()) {
+            uint64_t num_terms = 0, bound = 0, max_term_bound = 0;
+            for (const Concat& side : pred.get_params()) {
+                for (const BasicTerm& term : side) {
+                    uint64_t term_bound = term.is_literal() ? term.get_name().length() : var_strs.at(term).bound;
+                    ++num_terms;
+                    bound += term_bound;
+                    max_term_bound = std::max(max_term_bound, term_bound);
+                }
+            }
+            size += num_terms * bound * max_term_bound * alphabet.size();
+        }
+        if (size > MAX_ENCODING_SIZE) {
+            STRACE("str", tout << "bounded: the encoding is too large (" << size << ")" << std::endl);
+            failed = true;
+            return;
+        }
+
+        for (auto& [var, s] : var_strs) {
+            unsigned bound = s.bound;
+            s = mk_str(bound);
+            encode_membership(s, *aut_ass.at(var));
+        }
+        for (const Predicate& pred : formula.get_predicates()) {
+            encode_predicate(pred);
+        }
+        STRACE("str", tout << "bounded: " << solver->num_vars() << " variables, " << solver->num_clauses() << " clauses" << std::endl);
+    }
+
+    unsigned BoundedStringProcedure::get_word_length(const Str& s) const {
+        unsigned len = 0;
+        while (len < s.bound && solver->get_model()[s.len[len].var()] == l_true) {
+            ++len;
+        }
+        return len;
+    }
+
+    lbool BoundedStringProcedure::compute_next_solution() {
+        if (failed) {
+            return l_undef;
+        }
+        if (solved) {
+            // the lengths of the last solution are blocked
+            solver->pop_to_base_level();
+            std::vector<sat::literal> block;
+            for (const auto& [var, len] : solution_lengths) {
+                block.push_back(~exact_len(var_strs.at(var), len));
+            }
+            add_clause(std::move(block));
+            solved = false;
+        }
+        lbool result = l_undef;
+        while (!exhausted) {
+            if (is_cancelled()) {
+                return l_undef;
+            }
+            scoped_rlimit slice(limit, RLIMIT_SLICE);
+            result = solver->check();
+            if (result == l_false) {
+                exhausted = true;
+            } else if (result == l_true) {
+                break;
+            } else if (!limit.is_canceled()) {
+                // unknown for another reason than the end of the slice
+                return l_undef;
+            }
+        }
+        if (exhausted) {
+            return complete ? l_false : l_undef;
+        }
+
+        solved = true;
+        solution_lengths.clear();
+        for (const BasicTerm& var : init_length_sensitive_vars) {
+            auto it = var_strs.find(var);
+            if (it != var_strs.end()) {
+                solution_lengths[var] = get_word_length(it->second);
+            }
+        }
+        return l_true;
+    }
+
+    std::pair<LenNode, LenNodePrecision> BoundedStringProcedure::get_lengths() {
+        LenNode conj(LenFormulaType::AND);
+        for (const auto& [var, len] : solution_lengths) {
+            conj.succ.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{ LenNode(var), LenNode(static_cast<int>(len)) });
+        }
+        if (conj.succ.empty()) {
+            return { LenNode(LenFormulaType::TRUE), LenNodePrecision::PRECISE };
+        }
+        return { conj, LenNodePrecision::PRECISE };
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef _NOODLER_BOUNDED_DECISION_PROCEDURE_H_
+#define _NOODLER_BOUNDED_DECISION_PROCEDURE_H_
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "util/rlimit.h"
+#include "sat/sat_solver.h"
+#include "smt/params/theory_str_noodler_params.h"
+
+#include "formula.h"
+#include "aut_assignment.h"
+#include "decision_procedure.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Decision procedure encoding word (dis)equations with regular memberships up to a length bound into SAT.
+     *
+     * Each string (variable, literal, side of a predicate) of length at most k is encoded by unary length literals
+     * (the string is longer than i) and one-hot character literals for each position. The automata of variables are
+     * unrolled into transition constraints over the positions, the terms of a side of a predicate are placed into the
+     * string of the side by offset literals. The bound of a variable is the maximal length of the words of its
+     * language (or str.bounded_length if it is infinite).
+     *
+     * The solutions are the assignments of the SAT solver, get_lengths() gives the lengths of the length sensitive
+     * variables of the last one, which is blocked before the next solution is computed. If the languages of all
+     * variables are finite (so the bounds do not exclude any word), the procedure is complete and returns l_false once
+     * all lengths of solutions are blocked, otherwise it returns l_undef.
+     */
+    class BoundedStringProcedure : public AbstractDecisionProcedure {
+    public:
+        BoundedStringProcedure(const Formula& form, const AutAssignment& aut_ass,
+                               const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                               const theory_str_noodler_params& par);
+
+        lbool preprocess(PreprocessType opt = PreprocessType::PLAIN, const BasicTermEqiv &len_eq_vars = {}) override { return l_undef; }
+        void init_computation() override;
+        lbool compute_next_solution() override;
+        LenNode get_initial_lengths() override { return LenNode(LenFormulaType::TRUE); }
+        std::pair<LenNode, LenNodePrecision> get_lengths() override;
+
+    private:
+        // encoded string of length at most bound
+        struct Str {
+            unsigned bound = 0;
+            // len[i]: the string is longer than i
+            std::vector<sat::literal> len;
+            // chr[i][a]: the symbol at position i is alphabet[a]
+            std::vector<std::vector<sat::literal>> chr;
+            // exact_len[l]: the length of the string is l (created lazily)
+            std::vector<sat::literal> exact_len;
+        };
+
+        Formula formula;
+        AutAssignment aut_ass;
+        std::unordered_set<BasicTerm> init_length_sensitive_vars;
+        unsigned length_bound;
+
+        reslimit limit;
+        std::unique_ptr<sat::solver> solver;
+        // literal that is always true
+        sat::literal true_lit;
+
+        std::vector<mata::Symbol> alphabet;
+        std::unordered_map<mata::Symbol, std::vector<unsigned>> symbol_indices;
+        std::unordered_map<BasicTerm, Str> var_strs;
+        // lengths of the length sensitive variables in the last solution
+        std::map<BasicTerm, unsigned> solution_lengths;
+
+        // all words are within the bounds, so the absence of solutions is definitive
+        bool complete = true;
+        bool failed = false;
+        bool exhausted = false;
+        bool solved = false;
+
+        sat::literal mk_lit();
+        void add_clause(std::vector<sat::literal> lits);
+        Str mk_str(unsigned bound);
+        Str mk_literal_str(const zstring& word);
+        sat::literal exact_len(Str& s, unsigned l);
+        void encode_membership(Str& s, const mata::nfa::Nfa& aut);
+        void encode_side(std::vector<Str*> terms, Str& side);
+        void encode_predicate(const Predicate& pred);
+        unsigned get_word_length(const Str& s) const;
+    };
+}
+
+#endif
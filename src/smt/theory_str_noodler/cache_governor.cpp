@@ -0,0 +1,59 @@
+#include <algorithm>
+
+#include "util/trace.h"
+#include "cache_governor.h"
+
+namespace smt::noodler {
+
+    void CacheGovernor::register_cache(const char* stat_name, std::function<size_t()> get_bytes, std::function<void(size_t)> shrink,
+                                       std::function<size_t()> get_uses) {
+        Cache cache;
+        cache.stat_name = stat_name;
+        cache.get_bytes = std::move(get_bytes);
+        cache.shrink = std::move(shrink);
+        cache.get_uses = std::move(get_uses);
+        caches.push_back(std::move(cache));
+    }
+
+    void CacheGovernor::enforce() {
+        size_t total = 0;
+        for (Cache& cache : caches) {
+            size_t bytes = cache.get_bytes();
+            size_t uses = cache.get_uses ? cache.get_uses() : 0;
+            if (bytes != cache.last_bytes || uses != cache.last_uses) {
+                cache.referenced = true;
+            }
+            cache.last_bytes = bytes;
+            cache.last_uses = uses;
+            total += bytes;
+        }
+        last_bytes = total;
+        max_bytes = std::max(max_bytes, total);
+        if (budget == 0 || total <= budget) {
+            return;
+        }
+
+        STRACE("str-cache", tout << "caches use " << total << " bytes, the budget is " << budget << " bytes" << std::endl;);
+        // two rounds of the hand suffice, the first one clears all second chances
+        for (size_t step = 0; step < 2 * caches.size() && total > budget; ++step) {
+            Cache& cache = caches[hand];
+            hand = (hand + 1) % caches.size();
+            if (cache.referenced) {
+                cache.referenced = false;
+                continue;
+            }
+            if (cache.last_bytes == 0) {
+                continue;
+            }
+            const size_t excess = total - budget;
+            cache.shrink(cache.last_bytes > excess ? cache.last_bytes - excess : 0);
+            const size_t bytes = std::min(cache.get_bytes(), cache.last_bytes);
+            STRACE("str-cache", tout << "evicted " << cache.stat_name << ": " << cache.last_bytes << " -> " << bytes << " bytes" << std::endl;);
+            total -= cache.last_bytes - bytes;
+            cache.last_bytes = bytes;
+            cache.last_uses = cache.get_uses ? cache.get_uses() : 0;
+            ++cache.num_evictions;
+            ++num_evictions;
+        }
+    }
+}
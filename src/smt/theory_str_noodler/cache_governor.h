@@ -0,0 +1,63 @@
+#ifndef _NOODLER_CACHE_GOVERNOR_H_
+#define _NOODLER_CACHE_GOVERNOR_H_
+
+#include <functional>
+#include <vector>
+
+namespace smt::noodler {
+
+    /**
+     * @brief Governor bounding the total memory of the caches of a session (see NoodlerSession).
+     *
+     * Each cache registers an estimator of its memory, an eviction callback shrinking the cache to the given number
+     * of bytes (caches without an order of their entries simply drop all of them) and optionally a counter of its
+     * uses (e.g. hits). When enforce() finds the total memory above the budget, the caches are evicted by the clock
+     * algorithm: a cache that was used since the previous enforcement (its memory or its counter of uses changed)
+     * gets a second chance, the other ones are evicted until the total memory fits into the budget. The governor is
+     * enforced between final checks, so no cache is evicted while its entries are used.
+     */
+    class CacheGovernor {
+    public:
+        struct Cache {
+            // name of the statistic of the evictions of the cache
+            const char* stat_name;
+            std::function<size_t()> get_bytes;
+            std::function<void(size_t)> shrink;
+            // nullptr if the cache does not count its uses
+            std::function<size_t()> get_uses;
+            size_t last_bytes = 0;
+            size_t last_uses = 0;
+            bool referenced = false;
+            unsigned num_evictions = 0;
+        };
+
+    private:
+        std::vector<Cache> caches;
+        // position of the clock hand in caches
+        size_t hand = 0;
+        // budget in bytes, 0 means no limit
+        size_t budget = 0;
+        size_t last_bytes = 0;
+        size_t max_bytes = 0;
+        unsigned num_evictions = 0;
+
+    public:
+        void register_cache(const char* stat_name, std::function<size_t()> get_bytes, std::function<void(size_t)> shrink,
+                            std::function<size_t()> get_uses = nullptr);
+
+        void set_budget(size_t bytes) { budget = bytes; }
+
+        /**
+         * @brief Evict the caches if their total memory exceeds the budget.
+         */
+        void enforce();
+
+        const std::vector<Cache>& get_caches() const { return caches; }
+        // the total memory of the caches at the last enforcement (before evicting) and the maximum of it
+        size_t get_last_bytes() const { return last_bytes; }
+        size_t get_max_bytes() const { return max_bytes; }
+        unsigned get_num_evictions() const { return num_evictions; }
+    };
+}
+
+#endif
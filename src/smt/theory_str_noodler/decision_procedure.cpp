@@ -1,15 +1,372 @@
 #include <queue>
 #include <utility>
 #include <algorithm>
+#include <climits>
+#include <cmath>
 #include <functional>
+#include <atomic>
+#include <exception>
+#ifndef SINGLE_THREAD
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#endif
 
 #include <mata/nfa/strings.hh>
 #include "util.h"
 #include "aut_assignment.h"
 #include "decision_procedure.h"
+#include "profile_markers.h"
 
 namespace smt::noodler {
 
+    namespace {
+        // statistics can be updated by more threads (see explore_worklist_parallel)
+        void add_to_stat(unsigned& stat, unsigned value) {
+            std::atomic_ref<unsigned>(stat) += value;
+        }
+
+        void max_to_stat(unsigned& stat, unsigned value) {
+            std::atomic_ref<unsigned> stat_ref(stat);
+            unsigned current = stat_ref.load();
+            while (current < value && !stat_ref.compare_exchange_weak(current, value)) {}
+        }
+
+        template<typename Container>
+        size_t approx_predicates_bytes(const Container& predicates) {
+            // nodes of std::set and std::deque are approximated by two pointers per element
+            size_t bytes = 0;
+            for (const Predicate& pred : predicates) {
+                bytes += sizeof(Predicate) + 2 * sizeof(void*);
+                for (const auto& side : pred.get_params()) {
+                    bytes += sizeof(side) + side.size() * sizeof(BasicTerm);
+                }
+            }
+            return bytes;
+        }
+    }
+
+    ReductionPolicy::Reduction ReductionPolicy::decide(Site site, size_t num_of_states) const {
+        switch (policy) {
+        case RP_DEFAULT:
+            return (site == Site::NOODLE) ? Reduction::SIMULATION : Reduction::NONE;
+        case RP_NONE:
+            return Reduction::NONE;
+        case RP_TRIM:
+            return Reduction::TRIM;
+        case RP_SIMULATION:
+            return Reduction::SIMULATION;
+        case RP_MINIMIZE:
+            return Reduction::MINIMIZE;
+        case RP_ADAPTIVE:
+            if (num_of_states <= minimize_states) {
+                return Reduction::MINIMIZE;
+            } else if (num_of_states <= simulation_states) {
+                return Reduction::SIMULATION;
+            }
+            return Reduction::TRIM;
+        default:
+            UNREACHABLE();
+            return Reduction::NONE;
+        }
+    }
+
+    std::unordered_map<std::string, std::string> ReductionPolicy::noodlify_params(size_t product_states, Reduction& done) const {
+        if (decide(Site::NOODLE, product_states) >= Reduction::SIMULATION) {
+            done = Reduction::SIMULATION;
+            return {{"reduce", "forward"}};
+        }
+        done = Reduction::TRIM;
+        return {{"reduce", "false"}};
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> ReductionPolicy::reduce(Site site, const std::shared_ptr<mata::nfa::Nfa>& aut, Reduction done) const {
+        Reduction reduction = decide(site, aut->num_of_states());
+        if (reduction <= done) {
+            return aut;
+        }
+        switch (reduction) {
+        case Reduction::TRIM: {
+            auto res = std::make_shared<mata::nfa::Nfa>(*aut);
+            res->trim();
+            return res;
+        }
+        case Reduction::SIMULATION:
+            return std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(mata::nfa::Nfa(*aut).trim()));
+        case Reduction::MINIMIZE:
+            return std::make_shared<mata::nfa::Nfa>(mata::nfa::minimize(*aut).trim());
+        default:
+            UNREACHABLE();
+            return aut;
+        }
+    }
+
+    bool InclusionCache::is_included(const std::vector<std::shared_ptr<mata::nfa::Nfa>>& left_automata,
+                                     const std::shared_ptr<mata::nfa::Nfa>& right_automaton, bool& cache_hit) {
+        NOODLER_PHASE("inclusion");
+        if (left_automata.size() == 1 && left_automata[0] == right_automaton) {
+            // the same (shared) automaton on both sides, the inclusion trivially holds
+            cache_hit = true;
+            return true;
+        }
+        std::vector<const mata::nfa::Nfa*> key;
+        for (const auto& aut : left_automata) {
+            key.push_back(aut.get());
+        }
+        key.push_back(right_automaton.get());
+
+        std::optional<mata::nfa::Run> known_counterexample;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                cache_hit = true;
+                return it->second.result;
+            }
+            auto cex_it = counterexamples.find(right_automaton.get());
+            if (cex_it != counterexamples.end()) {
+                known_counterexample = cex_it->second;
+            }
+        }
+
+        mata::nfa::Nfa left_concat = mata::nfa::builder::create_empty_string_nfa();
+        for (const auto& aut : left_automata) {
+            left_concat = mata::nfa::concatenate(left_concat, *aut);
+        }
+
+        Entry entry{ left_automata, false, std::nullopt };
+        entry.automata.push_back(right_automaton);
+        // the known counterexample is not in L(right), if it is in L(left), the inclusion does not hold
+        cache_hit = known_counterexample.has_value() && left_concat.is_in_lang(*known_counterexample);
+        if (cache_hit) {
+            entry.counterexample = known_counterexample;
+        } else {
+            mata::nfa::Run counterexample;
+            entry.result = mata::nfa::is_included(left_concat, *right_automaton, &counterexample);
+            if (!entry.result) {
+                entry.counterexample = std::move(counterexample);
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (cache.size() >= max_size) {
+            STRACE("str-inclusion-cache", tout << "inclusion cache is full, dropping " << cache.size() << " entries" << std::endl;);
+            cache.clear();
+            counterexamples.clear();
+        }
+        if (entry.counterexample.has_value()) {
+            counterexamples[right_automaton.get()] = *entry.counterexample;
+        }
+        bool result = entry.result;
+        cache.emplace(std::move(key), std::move(entry));
+        return result;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> SegmentPool::intern(const std::shared_ptr<mata::nfa::Nfa>& nfa, bool& shared) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = segments.find(nfa);
+        shared = (it != segments.end());
+        if (shared) {
+            return *it;
+        }
+        if (segments.size() >= max_size) {
+            STRACE("str-segment-pool", tout << "segment pool is full, dropping " << segments.size() << " automata" << std::endl;);
+            segments.clear();
+        }
+        segments.insert(nfa);
+        return nfa;
+    }
+
+    std::shared_ptr<mata::nfa::Nfa> SegmentPool::get_concatenation(const std::shared_ptr<mata::nfa::Nfa>& left, const std::shared_ptr<mata::nfa::Nfa>& right,
+                                                                   const std::function<std::shared_ptr<mata::nfa::Nfa>(std::shared_ptr<mata::nfa::Nfa>)>& reduce,
+                                                                   bool& memo_hit) {
+        std::pair<const mata::nfa::Nfa*, const mata::nfa::Nfa*> key{ left.get(), right.get() };
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = concatenations.find(key);
+            memo_hit = (it != concatenations.end());
+            if (memo_hit) {
+                return it->second.result;
+            }
+        }
+
+        bool shared;
+        std::shared_ptr<mata::nfa::Nfa> result = intern(reduce(std::make_shared<mata::nfa::Nfa>(mata::nfa::concatenate(*left, *right))), shared);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (concatenations.size() >= max_size) {
+            STRACE("str-segment-pool", tout << "concatenation memo is full, dropping " << concatenations.size() << " entries" << std::endl;);
+            concatenations.clear();
+        }
+        concatenations.emplace(key, Concatenation{ left, right, result });
+        return result;
+    }
+
+    std::vector<std::shared_ptr<mata::nfa::Nfa>> NogoodStore::get_automata(const Predicate& inclusion, const AutAssignment& aut_ass) {
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> automata;
+        for (const auto* side : { &inclusion.get_left_side(), &inclusion.get_right_side() }) {
+            for (const BasicTerm& term : *side) {
+                auto it = aut_ass.find(term);
+                automata.push_back(it != aut_ass.end() ? it->second : nullptr);
+            }
+        }
+        return automata;
+    }
+
+    size_t NogoodStore::hash(const Predicate& inclusion, const std::vector<std::shared_ptr<mata::nfa::Nfa>>& automata) {
+        size_t res = std::hash<Predicate>{}(inclusion);
+        for (const auto& aut : automata) {
+            res = res * 31 + std::hash<const mata::nfa::Nfa*>{}(aut.get());
+        }
+        return res;
+    }
+
+    void NogoodStore::add(const Predicate& inclusion, const AutAssignment& aut_ass) {
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> automata = get_automata(inclusion, aut_ass);
+        const size_t key = hash(inclusion, automata);
+        std::lock_guard<std::mutex> guard(lock);
+        if (num_nogoods >= max_size) {
+            STRACE("str-nogoods", tout << "nogood store is full, dropping " << num_nogoods << " nogoods" << std::endl;);
+            nogoods.clear();
+            num_nogoods = 0;
+        }
+        nogoods[key].push_back(Nogood{ inclusion, std::move(automata) });
+        ++num_nogoods;
+    }
+
+    bool NogoodStore::contains_nogood(const SolvingState& state) const {
+        std::lock_guard<std::mutex> guard(lock);
+        if (num_nogoods == 0) {
+            return false;
+        }
+        for (const Predicate& inclusion : *state.inclusions) {
+            std::vector<std::shared_ptr<mata::nfa::Nfa>> automata = get_automata(inclusion, state.aut_ass);
+            auto it = nogoods.find(hash(inclusion, automata));
+            if (it == nogoods.end()) {
+                continue;
+            }
+            for (const Nogood& nogood : it->second) {
+                if (nogood.inclusion == inclusion && nogood.automata == automata) {
+                    STRACE("str-nogoods", tout << "nogood " << inclusion << " prunes a solving state" << std::endl;);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    PreprocessMemo::Key::Key(PreprocessType opt, const Formula& formula, const Formula& not_contains, const AutAssignment& aut_ass,
+                             const std::unordered_set<BasicTerm>& length_vars, const BasicTermEqiv& len_eq_vars,
+                             const std::vector<TermConversion>& conversions)
+        : opt(opt), formula(formula), not_contains(not_contains), automata(aut_ass.begin(), aut_ass.end()),
+          length_vars(length_vars.begin(), length_vars.end()), len_eq_vars(len_eq_vars) {
+        std::sort(automata.begin(), automata.end(), [](const auto& a1, const auto& a2) { return a1.first < a2.first; });
+        std::sort(this->length_vars.begin(), this->length_vars.end());
+        for (const TermConversion& conv : conversions) {
+            conversion_vars.push_back(conv.string_var);
+        }
+        std::sort(conversion_vars.begin(), conversion_vars.end());
+        conversion_vars.erase(std::unique(conversion_vars.begin(), conversion_vars.end()), conversion_vars.end());
+    }
+
+    bool PreprocessMemo::Key::operator==(const Key& other) const {
+        if (opt != other.opt || automata.size() != other.automata.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < automata.size(); ++i) {
+            if (automata[i].first != other.automata[i].first || automata[i].second != other.automata[i].second) {
+                return false;
+            }
+        }
+        return length_vars == other.length_vars && conversion_vars == other.conversion_vars
+            && len_eq_vars == other.len_eq_vars && formula == other.formula && not_contains == other.not_contains;
+    }
+
+    size_t PreprocessMemo::Key::hash() const {
+        size_t res = static_cast<size_t>(opt);
+        auto combine = [&res](size_t val) { res ^= val + 0x9e3779b9 + (res << 6) + (res >> 2); };
+        for (const Predicate& pred : formula.get_predicates()) {
+            combine(std::hash<Predicate>()(pred));
+        }
+        for (const Predicate& pred : not_contains.get_predicates()) {
+            combine(std::hash<Predicate>()(pred));
+        }
+        for (const auto& [var, aut] : automata) {
+            combine(std::hash<BasicTerm>()(var));
+            combine(std::hash<const mata::nfa::Nfa*>()(aut.get()));
+        }
+        for (const BasicTerm& var : length_vars) {
+            combine(std::hash<BasicTerm>()(var));
+        }
+        for (const BasicTerm& var : conversion_vars) {
+            combine(std::hash<BasicTerm>()(var));
+        }
+        combine(len_eq_vars.size());
+        return res;
+    }
+
+    std::shared_ptr<const FormulaPreprocessor> PreprocessMemo::find(const Key& key) const {
+        return find(memo, key);
+    }
+
+    void PreprocessMemo::insert(Key key, std::shared_ptr<const FormulaPreprocessor> prep) {
+        insert(memo, std::move(key), std::move(prep));
+    }
+
+    std::shared_ptr<const FormulaPreprocessor> PreprocessMemo::find(const Table& table, const Key& key) {
+        auto it = table.find(key.hash());
+        if (it == table.end()) {
+            return nullptr;
+        }
+        for (const auto& [memo_key, prep] : it->second) {
+            if (memo_key == key) {
+                return prep;
+            }
+        }
+        return nullptr;
+    }
+
+    void PreprocessMemo::insert(Table& table, Key key, std::shared_ptr<const FormulaPreprocessor> prep) {
+        if (num_entries >= max_size) {
+            STRACE("str-prep", tout << "preprocessing memo is full, dropping " << num_entries << " entries" << std::endl;);
+            clear();
+        }
+        // the key and the preprocessor hold the instance, the instance after the passes is counted as the original one
+        const size_t num_preds = key.formula.get_predicates().size() + key.not_contains.get_predicates().size();
+        bytes += 2 * (sizeof(Key) + num_preds * (sizeof(Predicate) + 2 * sizeof(void*))
+            + key.automata.size() * (sizeof(BasicTerm) + 4 * sizeof(void*)) + key.length_vars.size() * sizeof(BasicTerm));
+        size_t key_hash = key.hash();
+        table[key_hash].emplace_back(std::move(key), std::move(prep));
+        ++num_entries;
+    }
+
+    FormulaPreprocessor PreprocessMemo::get_shared(PreprocessMemo* memo, Formula formula, AutAssignment aut_ass,
+                                                   std::unordered_set<BasicTerm> length_vars, const theory_str_noodler_params& par,
+                                                   PreprocessProfile* profile, LiteralStore* store) {
+        std::optional<Key> key;
+        if (memo != nullptr) {
+            key.emplace(PreprocessType::PLAIN, formula, Formula(), aut_ass, length_vars, BasicTermEqiv(), std::vector<TermConversion>());
+            std::shared_ptr<const FormulaPreprocessor> memoized = find(memo->shared, *key);
+            if (memoized != nullptr) {
+                STRACE("str-prep", tout << "Using memoized shared preprocessing" << std::endl;);
+                FormulaPreprocessor prep_handler(*memoized);
+                prep_handler.set_literal_store(store);
+                return prep_handler;
+            }
+        }
+
+        FormulaPreprocessor prep_handler{std::move(formula), std::move(aut_ass), std::move(length_vars), par};
+        prep_handler.set_literal_store(store);
+        PreprocessScheduler sched(prep_handler, profile);
+        sched.run("remove_trivial", PREP_FORMULA, [&](FormulaPreprocessor& p) { p.remove_trivial(); });
+        // only makes variable a literal or removes the disequation
+        sched.run("reduce_diseqalities", PREP_ALL, [&](FormulaPreprocessor& p) { p.reduce_diseqalities(); });
+        if (key.has_value()) {
+            memo->insert(memo->shared, std::move(*key), std::make_shared<const FormulaPreprocessor>(prep_handler));
+        }
+        return prep_handler;
+    }
+
     void SolvingState::substitute_vars(std::unordered_map<BasicTerm, std::vector<BasicTerm>> &substitution_map) {
         // substitutes variables in a vector using substitution_map
         auto substitute_vector = [&substitution_map](const std::vector<BasicTerm> &vector) {
@@ -36,7 +393,7 @@ namespace smt::noodler {
         auto inclusion_has_same_sides = [](const Predicate &inclusion) { return inclusion.get_left_side() == inclusion.get_right_side(); };
 
         // substitutes variables of inclusions in a vector using substitute_map, but does not keep the ones that have the same sides after substitution
-        auto substitute_set = [&substitute_inclusion, &inclusion_has_same_sides](const std::set<Predicate> inclusions) {
+        auto substitute_set = [&substitute_inclusion, &inclusion_has_same_sides](const std::set<Predicate>& inclusions) {
             std::set<Predicate> new_inclusions;
             for (const auto &old_inclusion : inclusions) {
                 auto new_inclusion = substitute_inclusion(old_inclusion);
@@ -47,29 +404,43 @@ namespace smt::noodler {
             return new_inclusions;
         };
 
-        inclusions = substitute_set(inclusions);
-        inclusions_not_on_cycle = substitute_set(inclusions_not_on_cycle);
+        // the substituted containers are built anew, so the shared ones are not copied
+        inclusions = substitute_set(*inclusions);
+        inclusions_not_on_cycle = substitute_set(*inclusions_not_on_cycle);
 
         // substituting inclusions to process is bit harder, it is possible that two inclusions that were supposed to
         // be processed become same after substituting, so we do not want to keep both in inclusions to process
-        std::set<Predicate> substituted_inclusions_to_process;
+        std::unordered_set<Predicate> substituted_inclusions_to_process;
         std::deque<Predicate> new_inclusions_to_process;
-        while (!inclusions_to_process.empty()) {
-            Predicate substituted_inclusion = substitute_inclusion(inclusions_to_process.front());
-            inclusions_to_process.pop_front();
-            
+        for (const Predicate& inclusion : *inclusions_to_process) {
+            Predicate substituted_inclusion = substitute_inclusion(inclusion);
+
             if (!inclusion_has_same_sides(substituted_inclusion) // we do not want to add inclusion that is already in inclusions_to_process
-                && substituted_inclusions_to_process.count(substituted_inclusion) == 0) {
+                && substituted_inclusions_to_process.insert(substituted_inclusion).second) {
                 new_inclusions_to_process.push_back(substituted_inclusion);
             }
         }
-        inclusions_to_process = new_inclusions_to_process;
+        inclusions_to_process = std::move(new_inclusions_to_process);
+        reindex();
     }
 
-    LenNode SolvingState::get_lengths(const BasicTerm& var) const {
+    void SolvingState::reindex() {
+        inclusions_to_process_set = std::unordered_set<Predicate>(inclusions_to_process->begin(), inclusions_to_process->end());
+        std::unordered_map<BasicTerm, std::set<Predicate>> occurrences;
+        for (const Predicate& inclusion : *inclusions) {
+            for (const BasicTerm& var : inclusion.get_right_set()) {
+                if (var.is_variable()) {
+                    occurrences[var].insert(inclusion);
+                }
+            }
+        }
+        right_side_occurrences = std::move(occurrences);
+    }
+
+    LenNode SolvingState::get_lengths(const BasicTerm& var, AutAssignment::WordLengthsMemo* memo) const {
         if (aut_ass.count(var) > 0) {
             // if var is not substituted, get length constraint from its automaton
-            return aut_ass.get_lengths(var);
+            return memo != nullptr ? aut_ass.get_lengths(var, *memo) : aut_ass.get_lengths(var);
         } else if (substitution_map.count(var) > 0) {
             // if var is substituted, i.e. state.substitution_map[var] = x_1 x_2 ... x_n, then we have to create length equation
             //      |var| = |x_1| + |x_2| + ... + |x_n|
@@ -142,212 +513,816 @@ namespace smt::noodler {
                            << "Getting another solution"
                            << "------------------------" << std::endl;);
 
+        budget_exceeded = false;
+        lbool found_solution;
+#ifndef SINGLE_THREAD
+        if (m_params.m_dp_threads > 1 && m_params.m_deterministic) {
+            found_solution = explore_worklist_rounds(m_params.m_dp_threads);
+        } else if (m_params.m_dp_threads > 1) {
+            found_solution = explore_worklist_parallel(m_params.m_dp_threads);
+        } else
+#endif
+        if (m_params.m_worklist_order != WO_DEFAULT) {
+            found_solution = explore_worklist_best_first();
+        } else {
+            found_solution = explore_worklist();
+        }
+
+        if (found_solution == l_undef) {
+            STRACE("str", tout << "Budget of the decision procedure exceeded" << std::endl;);
+            budget_exceeded = true;
+            return l_undef;
+        }
+
+        if (found_solution == l_false) {
+            // there are no solving states left, which means nothing led to solution -> it must be unsatisfiable
+            return l_false;
+        }
+
+        STRACE("str",
+            tout << "Found solution:" << std::endl;
+            for (const auto &var_substitution : solution.substitution_map) {
+                tout << "    " << var_substitution.first << " ->";
+                for (const auto& subst_var : var_substitution.second) {
+                    tout << " " << subst_var;
+                }
+                tout << std::endl;
+            }
+            for (const auto& var_aut : solution.aut_ass) {
+                tout << "    " << var_aut.first << " -> NFA" << std::endl;
+                if (is_trace_enabled("str-nfa")) {
+                    var_aut.second->print_to_mata(tout);
+                }
+            }
+        );
+        return l_true;
+    }
+
+    bool DecisionProcedure::is_over_budget() {
+        if (is_cancelled()) {
+            return true;
+        }
+        // statistics can be updated by more threads (see explore_worklist_parallel)
+        if (budget.solving_states != 0 && std::atomic_ref<unsigned>(stats.num_solving_states).load() - budget_start_stats.num_solving_states > budget.solving_states) {
+            return true;
+        }
+        if (budget.aut_states != 0 && std::atomic_ref<unsigned>(stats.total_aut_states).load() - budget_start_stats.total_aut_states > budget.aut_states) {
+            return true;
+        }
+        return budget.time_ms != 0 && budget_watch.get_current_seconds() * 1000 > budget.time_ms;
+    }
+
+    size_t DecisionProcedure::estimate_state_bytes(const SolvingState& state) {
+        size_t bytes = sizeof(SolvingState);
+        for (const auto& [var, aut] : state.aut_ass) {
+            // node of the hash map and the share of the automaton
+            bytes += sizeof(BasicTerm) + sizeof(aut) + 2 * sizeof(void*) + AutomataPool::approx_bytes(*aut) / std::max(aut.use_count(), 1L);
+        }
+        for (const auto& [var, subst] : state.substitution_map) {
+            bytes += sizeof(BasicTerm) + sizeof(subst) + subst.size() * sizeof(BasicTerm) + 2 * sizeof(void*);
+        }
+        bytes += approx_predicates_bytes(*state.inclusions) / std::max(state.inclusions.use_count(), 1L);
+        bytes += approx_predicates_bytes(*state.inclusions_not_on_cycle) / std::max(state.inclusions_not_on_cycle.use_count(), 1L);
+        bytes += approx_predicates_bytes(*state.inclusions_to_process) / std::max(state.inclusions_to_process.use_count(), 1L);
+        bytes += state.length_sensitive_vars.size() * (sizeof(BasicTerm) + 2 * sizeof(void*));
+        return bytes;
+    }
+
+    bool DecisionProcedure::account_pushed_state(SolvingState& state, std::atomic<size_t>& worklist_bytes, size_t memory_limit) {
+        if (memory_limit == 0) {
+            return false;
+        }
+        state.approx_bytes = estimate_state_bytes(state);
+        const size_t bytes = worklist_bytes += state.approx_bytes;
+        max_to_stat(stats.max_worklist_kb, static_cast<unsigned>(bytes >> 10));
+        // depth-first exploration, the states of the frontier are processed before new siblings are created
+        return bytes > memory_limit / 2;
+    }
+
+    unsigned DecisionProcedure::evict_states(std::deque<SolvingState>& states, std::atomic<size_t>& worklist_bytes, size_t memory_limit) {
+        unsigned num_evicted = 0;
+        // the last states are the ones that would be processed last by the breadth-first exploration
+        while (states.size() > 1 && worklist_bytes > memory_limit - memory_limit / 4) {
+            worklist_bytes -= states.back().approx_bytes;
+            states.pop_back();
+            ++num_evicted;
+        }
+        add_to_stat(stats.num_evicted_states, num_evicted);
+        return num_evicted;
+    }
+
+    lbool DecisionProcedure::explore_worklist() {
+        const size_t memory_limit = static_cast<size_t>(budget.memory_mb) << 20;
+        std::atomic<size_t> worklist_bytes = 0;
+        for (SolvingState& state : worklist) {
+            account_pushed_state(state, worklist_bytes, memory_limit);
+        }
+
+        auto push_to_worklist = [&](SolvingState&& state, bool to_front) {
+            if (account_pushed_state(state, worklist_bytes, memory_limit)) {
+                to_front = true;
+            }
+            if (to_front) {
+                worklist.push_front(std::move(state));
+            } else {
+                worklist.push_back(std::move(state));
+            }
+        };
+
         while (!worklist.empty()) {
+            if (is_over_budget()) {
+                return l_undef;
+            }
+
+            if (memory_limit != 0 && worklist_bytes > memory_limit) {
+                evict_states(worklist, worklist_bytes, memory_limit);
+                states_evicted = true;
+                STRACE("str", tout << "worklist over its memory limit, evicted states (" << stats.num_evicted_states << " in total)" << std::endl;);
+            }
+
             SolvingState element_to_process = std::move(worklist.front());
             worklist.pop_front();
+            if (memory_limit != 0) {
+                worklist_bytes -= element_to_process.approx_bytes;
+            }
 
-            if (element_to_process.inclusions_to_process.empty()) {
+            if (process_solving_state(element_to_process, push_to_worklist)) {
                 // we found another solution, element_to_process contain the automata
                 // assignment and variable substition that satisfy the original
                 // inclusion graph
                 solution = std::move(element_to_process);
-                STRACE("str",
-                    tout << "Found solution:" << std::endl;
-                    for (const auto &var_substitution : solution.substitution_map) {
-                        tout << "    " << var_substitution.first << " ->";
-                        for (const auto& subst_var : var_substitution.second) {
-                            tout << " " << subst_var;
-                        }
-                        tout << std::endl;
+                return l_true;
+            }
+        }
+        return states_evicted ? l_undef : l_false;
+    }
+
+    std::pair<unsigned, std::optional<unsigned>> DecisionProcedure::get_length_bounds(const SolvingState& state, const BasicTerm& var) {
+        auto aut_it = state.aut_ass.find(var);
+        if (aut_it != state.aut_ass.end()) {
+            auto [it, inserted] = length_bounds_memo.try_emplace(aut_it->second.get());
+            if (inserted) {
+                std::pair<unsigned, std::optional<unsigned>> bounds{ UINT_MAX, 0 };
+                for (const auto& [c1, c2] : mata::strings::get_word_lengths(*aut_it->second)) {
+                    bounds.first = std::min(bounds.first, static_cast<unsigned>(c1));
+                    if (c2 != 0) {
+                        bounds.second = std::nullopt;
+                    } else if (bounds.second.has_value()) {
+                        bounds.second = std::max(*bounds.second, static_cast<unsigned>(c1));
+                    }
+                }
+                it->second = { aut_it->second, bounds };
+            }
+            return it->second.second;
+        }
+        std::pair<unsigned, std::optional<unsigned>> bounds{ 0, 0 };
+        auto subst_it = state.substitution_map.find(var);
+        if (subst_it == state.substitution_map.end()) {
+            // literals are not in aut_ass, they do not restrict anything
+            return { 0, std::nullopt };
+        }
+        for (const BasicTerm& subst_var : subst_it->second) {
+            auto [min_len, max_len] = get_length_bounds(state, subst_var);
+            bounds.first = (min_len == UINT_MAX || bounds.first == UINT_MAX) ? UINT_MAX : bounds.first + min_len;
+            if (!max_len.has_value()) {
+                bounds.second = std::nullopt;
+            } else if (bounds.second.has_value()) {
+                bounds.second = *bounds.second + *max_len;
+            }
+        }
+        return bounds;
+    }
+
+    std::optional<LenNode> DecisionProcedure::get_length_conflict(const SolvingState& state) {
+        if (length_assignment.empty()) {
+            return std::nullopt;
+        }
+        std::lock_guard<std::mutex> guard(length_pruning_lock);
+        for (const auto& [var, length] : length_assignment) {
+            if (state.aut_ass.count(var) == 0 && state.substitution_map.count(var) == 0) {
+                continue;
+            }
+            auto [min_len, max_len] = get_length_bounds(state, var);
+            if (min_len <= length && (!max_len.has_value() || length <= *max_len)) {
+                continue;
+            }
+            STRACE("str", tout << "length of " << var << " is not in the bounds of the solving state" << std::endl;);
+            if (min_len == UINT_MAX || (max_len.has_value() && min_len > *max_len)) {
+                // the state has no solution at all
+                return LenNode(LenFormulaType::FALSE);
+            } else if (max_len.has_value()) {
+                return LenNode(LenFormulaType::AND, {
+                    LenNode(LenFormulaType::LEQ, { min_len, var }), LenNode(LenFormulaType::LEQ, { var, *max_len }) });
+            } else {
+                return LenNode(LenFormulaType::LEQ, { min_len, var });
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool DecisionProcedure::is_pruned(const SolvingState& state) {
+        if (nogoods.contains_nogood(state)) {
+            add_to_stat(stats.num_nogood_pruned_states, 1);
+            return true;
+        }
+        if (!m_params.m_length_pruning) {
+            return false;
+        }
+        std::optional<LenNode> bounds = get_length_conflict(state);
+        if (!bounds.has_value()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(length_pruning_lock);
+        pruned_length_bounds.push_back(std::move(*bounds));
+        add_to_stat(stats.num_length_pruned_states, 1);
+        return true;
+    }
+
+    bool DecisionProcedure::is_length_compatible(const SolvingState& state) {
+        if (!m_params.m_model_guided_noodles || get_length_conflict(state) == std::nullopt) {
+            return true;
+        }
+        add_to_stat(stats.num_model_deferred_states, 1);
+        return false;
+    }
+
+    LenNode DecisionProcedure::get_pruned_length_bounds() {
+        std::lock_guard<std::mutex> guard(length_pruning_lock);
+        if (pruned_length_bounds.empty()) {
+            return LenNode(LenFormulaType::FALSE);
+        }
+        return LenNode(LenFormulaType::OR, pruned_length_bounds);
+    }
+
+    double DecisionProcedure::get_state_cost(const SolvingState& state) const {
+        if (state.next_noodle_state) {
+            return state.cost;
+        }
+        auto num_of_states = [&state](const BasicTerm& term) -> double {
+            auto it = state.aut_ass.find(term);
+            return it != state.aut_ass.end() ? it->second->num_of_states() : 1.0;
+        };
+        switch (m_params.m_worklist_order) {
+            case WO_INCLUSIONS:
+                return state.inclusions_to_process->size();
+            case WO_SMALLEST_AUT: {
+                // automata shared by more variables are counted once
+                std::unordered_set<const mata::nfa::Nfa*> counted;
+                double sum = 0;
+                for (const auto& [var, aut] : state.aut_ass) {
+                    if (counted.insert(aut.get()).second) {
+                        sum += aut->num_of_states();
+                    }
+                }
+                return std::log2(1 + sum);
+            }
+            case WO_LENGTH_VARS:
+                return state.length_sensitive_vars.size();
+            case WO_FEWEST_NOODLES: {
+                if (state.inclusions_to_process->empty()) {
+                    // solution
+                    return 0;
+                }
+                // the same estimate as for IO_FEWEST_NOODLES (see get_inclusion_order()), in the logarithm
+                const Predicate& inclusion = state.inclusions_to_process->front();
+                double right_states = 0;
+                for (const BasicTerm& term : inclusion.get_right_side()) {
+                    right_states += num_of_states(term);
+                }
+                return (std::max<double>(inclusion.get_left_side().size(), 1) - 1) * std::log2(std::max(right_states, 1.0));
+            }
+            default:
+                return 0;
+        }
+    }
+
+    lbool DecisionProcedure::explore_worklist_best_first() {
+        // (priority, sequence number) of the states, the lower is processed first (the sequence number breaks the ties
+        // in the order in which the states were pushed)
+        struct Entry {
+            double priority;
+            uint64_t seq;
+            SolvingState state;
+        };
+        auto later = [](const Entry& a, const Entry& b) {
+            return a.priority > b.priority || (a.priority == b.priority && a.seq > b.seq);
+        };
+        std::vector<Entry> heap;
+        uint64_t num_pushed = 0;
+        uint64_t num_processed = 0;
+
+        const size_t memory_limit = static_cast<size_t>(budget.memory_mb) << 20;
+        std::atomic<size_t> worklist_bytes = 0;
+
+        auto push_to_worklist = [&](SolvingState&& state, bool /* to_front */) {
+            state.cost = get_state_cost(state);
+            // the order is given by the priorities, so the state is not pushed depth-first above half of the limit
+            account_pushed_state(state, worklist_bytes, memory_limit);
+            const double age = m_params.m_worklist_aging == 0 ? 0.0 : static_cast<double>(num_processed / m_params.m_worklist_aging);
+            heap.push_back(Entry{ state.cost + age, num_pushed++, std::move(state) });
+            std::push_heap(heap.begin(), heap.end(), later);
+        };
+        // the states left by the previous call keep their order
+        while (!worklist.empty()) {
+            push_to_worklist(std::move(worklist.front()), false);
+            worklist.pop_front();
+        }
+        // the unprocessed states are kept for the next call (or for another exploration)
+        on_scope_exit keep_unprocessed([&]() {
+            std::sort(heap.begin(), heap.end(), [&later](const Entry& a, const Entry& b) { return later(b, a); });
+            for (Entry& entry : heap) {
+                worklist.push_back(std::move(entry.state));
+            }
+        });
+
+        while (!heap.empty()) {
+            if (is_over_budget()) {
+                return l_undef;
+            }
+
+            if (memory_limit != 0 && worklist_bytes > memory_limit) {
+                // the states with the worst priority would be processed last, after sorting they are at the end
+                std::sort(heap.begin(), heap.end(), [&later](const Entry& a, const Entry& b) { return later(b, a); });
+                while (heap.size() > 1 && worklist_bytes > memory_limit - memory_limit / 4) {
+                    worklist_bytes -= heap.back().state.approx_bytes;
+                    heap.pop_back();
+                    ++stats.num_evicted_states;
+                }
+                std::make_heap(heap.begin(), heap.end(), later);
+                states_evicted = true;
+                STRACE("str", tout << "worklist over its memory limit, evicted states (" << stats.num_evicted_states << " in total)" << std::endl;);
+            }
+
+            std::pop_heap(heap.begin(), heap.end(), later);
+            SolvingState element_to_process = std::move(heap.back().state);
+            heap.pop_back();
+            if (memory_limit != 0) {
+                worklist_bytes -= element_to_process.approx_bytes;
+            }
+            ++num_processed;
+
+            if (process_solving_state(element_to_process, push_to_worklist)) {
+                solution = std::move(element_to_process);
+                return l_true;
+            }
+        }
+        return states_evicted ? l_undef : l_false;
+    }
+
+#ifndef SINGLE_THREAD
+    lbool DecisionProcedure::explore_worklist_parallel(unsigned num_threads) {
+        const size_t memory_limit = static_cast<size_t>(budget.memory_mb) << 20;
+        // approximate memory of the states in all the queues
+        std::atomic<size_t> worklist_bytes = 0;
+        std::vector<std::deque<SolvingState>> queues(num_threads);
+        std::vector<std::mutex> queue_locks(num_threads);
+        // distribute the states from the worklist between the threads
+        unsigned next_queue = 0;
+        while (!worklist.empty()) {
+            account_pushed_state(worklist.front(), worklist_bytes, memory_limit);
+            queues[next_queue].push_back(std::move(worklist.front()));
+            worklist.pop_front();
+            next_queue = (next_queue + 1) % num_threads;
+        }
+
+        // number of states that are in some of the queues or are just being processed
+        std::atomic<unsigned> pending = 0;
+        // number of states that are in some of the queues
+        std::atomic<unsigned> queued = 0;
+        for (const auto& queue : queues) {
+            pending += queue.size();
+            queued += queue.size();
+        }
+        std::atomic<bool> done = false;
+        std::atomic<bool> over_budget = false;
+        std::atomic<bool> evicted = false;
+        std::mutex result_lock;
+        bool found_solution = false;
+        std::exception_ptr worker_exception = nullptr;
+
+        // the threads with nothing to process wait until some state is queued or the exploration ends
+        std::mutex wait_lock;
+        std::condition_variable wait_cond;
+        auto wake_workers = [&]() {
+            // the lock orders the change of the counters before the check of a waiting thread
+            { std::lock_guard<std::mutex> lock(wait_lock); }
+            wait_cond.notify_all();
+        };
+
+        // takes state from the front of the own queue or steals it from the back of some other one
+        auto take_state = [&](unsigned worker, SolvingState& state) {
+            for (unsigned i = 0; i < num_threads; ++i) {
+                unsigned victim = (worker + i) % num_threads;
+                std::lock_guard<std::mutex> lock(queue_locks[victim]);
+                if (!queues[victim].empty()) {
+                    if (victim == worker) {
+                        state = std::move(queues[victim].front());
+                        queues[victim].pop_front();
+                    } else {
+                        state = std::move(queues[victim].back());
+                        queues[victim].pop_back();
                     }
-                    for (const auto& var_aut : solution.aut_ass) {
-                        tout << "    " << var_aut.first << " -> NFA" << std::endl;
-                        if (is_trace_enabled("str-nfa")) {
-                            var_aut.second->print_to_mata(tout);
+                    --queued;
+                    if (memory_limit != 0) {
+                        worklist_bytes -= state.approx_bytes;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // evicts the last states of the queues (starting with the own one) until the memory fits the limit again
+        auto evict_from_queues = [&](unsigned worker) {
+            unsigned num_evicted = 0;
+            for (unsigned i = 0; i < num_threads && worklist_bytes > memory_limit - memory_limit / 4; ++i) {
+                unsigned victim = (worker + i) % num_threads;
+                std::lock_guard<std::mutex> lock(queue_locks[victim]);
+                num_evicted += evict_states(queues[victim], worklist_bytes, memory_limit);
+            }
+            if (num_evicted == 0) {
+                return;
+            }
+            queued -= num_evicted;
+            if ((pending -= num_evicted) == 0) {
+                wake_workers();
+            }
+            evicted = true;
+            STRACE("str", tout << "worklist over its memory limit, evicted states (" << std::atomic_ref<unsigned>(stats.num_evicted_states).load() << " in total)" << std::endl;);
+        };
+
+        auto worker_thread = [&](unsigned worker) {
+            auto push_to_worklist = [&](SolvingState&& state, bool to_front) {
+                if (account_pushed_state(state, worklist_bytes, memory_limit)) {
+                    to_front = true;
+                }
+                ++pending;
+                {
+                    std::lock_guard<std::mutex> lock(queue_locks[worker]);
+                    if (to_front) {
+                        queues[worker].push_front(std::move(state));
+                    } else {
+                        queues[worker].push_back(std::move(state));
+                    }
+                }
+                ++queued;
+                wake_workers();
+            };
+
+            try {
+                SolvingState element_to_process;
+                while (!done && pending > 0) {
+                    if (is_over_budget()) {
+                        over_budget = true;
+                        done = true;
+                        wake_workers();
+                        break;
+                    }
+                    if (memory_limit != 0 && worklist_bytes > memory_limit) {
+                        evict_from_queues(worker);
+                    }
+                    if (!take_state(worker, element_to_process)) {
+                        // some other thread is processing the last states, wait for new ones
+                        std::unique_lock<std::mutex> lock(wait_lock);
+                        wait_cond.wait(lock, [&]() { return done || pending == 0 || queued > 0; });
+                        continue;
+                    }
+                    if (process_solving_state(element_to_process, push_to_worklist)) {
+                        std::lock_guard<std::mutex> lock(result_lock);
+                        if (!found_solution) {
+                            found_solution = true;
+                            solution = std::move(element_to_process);
+                            done = true;
+                        } else {
+                            // some other thread was faster, keep this solution for the next call
+                            push_to_worklist(std::move(element_to_process), true);
                         }
                     }
-                );
+                    if (--pending == 0 || done) {
+                        wake_workers();
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(result_lock);
+                if (worker_exception == nullptr) {
+                    worker_exception = std::current_exception();
+                }
+                done = true;
+                wake_workers();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < num_threads; ++i) {
+            threads.emplace_back(worker_thread, i);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // the states that were not processed are kept for the next call
+        for (auto& queue : queues) {
+            for (auto& state : queue) {
+                worklist.push_back(std::move(state));
+            }
+        }
+        if (evicted) {
+            states_evicted = true;
+        }
+
+        if (worker_exception != nullptr) {
+            std::rethrow_exception(worker_exception);
+        }
+        if (found_solution) {
+            return l_true;
+        }
+        return over_budget || states_evicted ? l_undef : l_false;
+    }
+
+    lbool DecisionProcedure::explore_worklist_rounds(unsigned num_threads) {
+        // what the worker of each rank did with its state in the current round
+        struct Outcome {
+            bool is_solution = false;
+            std::vector<std::pair<SolvingState, bool>> pushed;
+        };
+        std::vector<SolvingState> round;
+        std::vector<Outcome> outcomes;
+        const size_t memory_limit = static_cast<size_t>(budget.memory_mb) << 20;
+        std::atomic<size_t> worklist_bytes = 0;
+        for (SolvingState& state : worklist) {
+            account_pushed_state(state, worklist_bytes, memory_limit);
+        }
+
+        while (!worklist.empty()) {
+            if (is_over_budget()) {
+                return l_undef;
+            }
+            if (memory_limit != 0 && worklist_bytes > memory_limit) {
+                evict_states(worklist, worklist_bytes, memory_limit);
+                states_evicted = true;
+                STRACE("str", tout << "worklist over its memory limit, evicted states (" << stats.num_evicted_states << " in total)" << std::endl;);
+            }
+            round.clear();
+            while (round.size() < num_threads && !worklist.empty()) {
+                round.push_back(std::move(worklist.front()));
+                worklist.pop_front();
+                if (memory_limit != 0) {
+                    worklist_bytes -= round.back().approx_bytes;
+                }
+            }
+            outcomes.clear();
+            outcomes.resize(round.size());
+            std::vector<std::exception_ptr> exceptions(round.size(), nullptr);
+
+            auto worker_thread = [&](size_t rank) {
+                try {
+                    auto push_to_worklist = [&](SolvingState&& state, bool to_front) {
+                        outcomes[rank].pushed.emplace_back(std::move(state), to_front);
+                    };
+                    outcomes[rank].is_solution = process_solving_state(round[rank], push_to_worklist);
+                } catch (...) {
+                    exceptions[rank] = std::current_exception();
+                }
+            };
+            std::vector<std::thread> threads;
+            for (size_t rank = 1; rank < round.size(); ++rank) {
+                threads.emplace_back(worker_thread, rank);
+            }
+            worker_thread(0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            for (const std::exception_ptr& ex : exceptions) {
+                if (ex != nullptr) {
+                    std::rethrow_exception(ex);
+                }
+            }
+
+            // the memory of the new states is accounted by rank (not while the workers push them), so that the
+            // states pushed depth-first above half of the memory limit do not depend on the timing of the workers
+            for (Outcome& outcome : outcomes) {
+                for (auto& [state, to_front] : outcome.pushed) {
+                    if (account_pushed_state(state, worklist_bytes, memory_limit)) {
+                        to_front = true;
+                    }
+                }
+            }
+            // the states pushed to the front by lower ranks come first, the ones pushed to the back come last
+            for (size_t rank = round.size(); rank-- > 0; ) {
+                auto& pushed = outcomes[rank].pushed;
+                for (auto it = pushed.rbegin(); it != pushed.rend(); ++it) {
+                    if (it->second) {
+                        worklist.push_front(std::move(it->first));
+                    }
+                }
+            }
+            for (Outcome& outcome : outcomes) {
+                for (auto& [state, to_front] : outcome.pushed) {
+                    if (!to_front) {
+                        worklist.push_back(std::move(state));
+                    }
+                }
+            }
+
+            std::optional<size_t> winner;
+            for (size_t rank = round.size(); rank-- > 0; ) {
+                if (!outcomes[rank].is_solution) {
+                    continue;
+                }
+                if (winner.has_value()) {
+                    account_pushed_state(round[*winner], worklist_bytes, memory_limit);
+                    worklist.push_front(std::move(round[*winner]));
+                }
+                winner = rank;
+            }
+            if (winner.has_value()) {
+                solution = std::move(round[*winner]);
                 return l_true;
             }
+        }
+        return states_evicted ? l_undef : l_false;
+    }
+#endif
+
+    bool DecisionProcedure::process_solving_state(SolvingState& element_to_process, const std::function<void(SolvingState&&, bool)>& push_to_worklist) {
+        NOODLER_PHASE("noodlification");
+        if (element_to_process.next_noodle_state) {
+            // suspended noodlification, we resume it to get the state for the next noodle and we keep the
+            // suspended noodlification behind it, so the remaining noodles are created only after this one is processed
+            SolvingState new_element;
+            if (element_to_process.next_noodle_state(new_element)) {
+                add_to_stat(stats.num_solving_states, 1);
+                push_to_worklist(std::move(element_to_process), true);
+                if (!is_pruned(new_element)) {
+                    // the states incompatible with the lengths of the arithmetic assignment are explored after the others
+                    const bool compatible = is_length_compatible(new_element);
+                    push_to_worklist(std::move(new_element), compatible);
+                }
+            }
+            return false;
+        }
+
+        if (element_to_process.inclusions_to_process->empty()) {
+            // we found another solution, element_to_process contain the automata
+            // assignment and variable substition that satisfy the original
+            // inclusion graph
+            return true;
+        }
+
+        // we will now process one inclusion from the inclusion graph which is at front
+        // i.e. we will update automata assignments and substitutions so that this inclusion is fulfilled
+        Predicate inclusion_to_process = element_to_process.pop_front_inclusion_to_process();
 
-            // we will now process one inclusion from the inclusion graph which is at front
-            // i.e. we will update automata assignments and substitutions so that this inclusion is fulfilled
-            Predicate inclusion_to_process = element_to_process.inclusions_to_process.front();
-            element_to_process.inclusions_to_process.pop_front();
+        // this will decide whether we will continue in our search by DFS or by BFS
+        bool is_inclusion_to_process_on_cycle = element_to_process.is_inclusion_on_cycle(inclusion_to_process);
 
-            // this will decide whether we will continue in our search by DFS or by BFS
-            bool is_inclusion_to_process_on_cycle = element_to_process.is_inclusion_on_cycle(inclusion_to_process);
+        STRACE("str", tout << "Processing node with inclusion " << inclusion_to_process << " which is" << (is_inclusion_to_process_on_cycle ? " " : " not ") << "on the cycle" << std::endl;);
+        STRACE("str",
+            tout << "Length variables are:";
+            for(auto const &var : inclusion_to_process.get_vars()) {
+                if (element_to_process.length_sensitive_vars.count(var)) {
+                    tout << " " << var.to_string();
+                }
+            }
+            tout << std::endl;
+        );
 
-            STRACE("str", tout << "Processing node with inclusion " << inclusion_to_process << " which is" << (is_inclusion_to_process_on_cycle ? " " : " not ") << "on the cycle" << std::endl;);
-            STRACE("str",
-                tout << "Length variables are:";
-                for(auto const &var : inclusion_to_process.get_vars()) {
-                    if (element_to_process.length_sensitive_vars.count(var)) {
-                        tout << " " << var.to_string();
+        const auto &left_side_vars = inclusion_to_process.get_left_side();
+        const auto &right_side_vars = inclusion_to_process.get_right_side();
+
+        /********************************************************************************************************/
+        /****************************************** One side is empty *******************************************/
+        /********************************************************************************************************/
+        // As kinda optimization step, we do "noodlification" for empty sides separately (i.e. sides that
+        // represent empty string). This is because it is simpler, we would get only one noodle so we just need to
+        // check that the non-empty side actually contains empty string and replace the vars on that side by epsilon.
+        if (right_side_vars.empty() || left_side_vars.empty()) {
+            std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map;
+            auto const non_empty_side_vars = right_side_vars.empty() ? 
+                                                    inclusion_to_process.get_left_set()
+                                                  : inclusion_to_process.get_right_set();
+            bool non_empty_side_contains_empty_word = true;
+            for (const auto &var : non_empty_side_vars) {
+                if (element_to_process.aut_ass.contains_epsilon(var)) {
+                    // var contains empty word, we substitute it with only empty word, but only if...
+                    if (right_side_vars.empty() // ...non-empty side is the left side (var is from left) or...
+                           || element_to_process.length_sensitive_vars.count(var) > 0 // ...var is length-aware
+                     ) {
+                        assert(substitution_map.count(var) == 0 && element_to_process.aut_ass.count(var) > 0);
+                        // we prepare substitution for all vars on the left or only the length vars on the right
+                        // (as non-length vars are probably not needed? TODO: would it make sense to update non-length vars too?)
+                        substitution_map[var] = {};
+                        element_to_process.aut_ass.erase(var);
                     }
+                } else {
+                    // var does not contain empty word => whole non-empty side cannot contain empty word
+                    non_empty_side_contains_empty_word = false;
+                    break;
                 }
-                tout << std::endl;
-            );
+            }
+            if (!non_empty_side_contains_empty_word) {
+                // in the case that the non_empty side does not contain empty word
+                // the inclusion cannot hold (noodlification would not create anything)
+                return false;
+            }
 
-            const auto &left_side_vars = inclusion_to_process.get_left_side();
-            const auto &right_side_vars = inclusion_to_process.get_right_side();
-
-            /********************************************************************************************************/
-            /****************************************** One side is empty *******************************************/
-            /********************************************************************************************************/
-            // As kinda optimization step, we do "noodlification" for empty sides separately (i.e. sides that
-            // represent empty string). This is because it is simpler, we would get only one noodle so we just need to
-            // check that the non-empty side actually contains empty string and replace the vars on that side by epsilon.
-            if (right_side_vars.empty() || left_side_vars.empty()) {
-                std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map;
-                auto const non_empty_side_vars = right_side_vars.empty() ? 
-                                                        inclusion_to_process.get_left_set()
-                                                      : inclusion_to_process.get_right_set();
-                bool non_empty_side_contains_empty_word = true;
-                for (const auto &var : non_empty_side_vars) {
-                    if (element_to_process.aut_ass.contains_epsilon(var)) {
-                        // var contains empty word, we substitute it with only empty word, but only if...
-                        if (right_side_vars.empty() // ...non-empty side is the left side (var is from left) or...
-                               || element_to_process.length_sensitive_vars.count(var) > 0 // ...var is length-aware
-                         ) {
-                            assert(substitution_map.count(var) == 0 && element_to_process.aut_ass.count(var) > 0);
-                            // we prepare substitution for all vars on the left or only the length vars on the right
-                            // (as non-length vars are probably not needed? TODO: would it make sense to update non-length vars too?)
-                            substitution_map[var] = {};
-                            element_to_process.aut_ass.erase(var);
-                        }
-                    } else {
-                        // var does not contain empty word => whole non-empty side cannot contain empty word
-                        non_empty_side_contains_empty_word = false;
-                        break;
-                    }
-                }
-                if (!non_empty_side_contains_empty_word) {
-                    // in the case that the non_empty side does not contain empty word
-                    // the inclusion cannot hold (noodlification would not create anything)
-                    continue;
-                }
+            // TODO: all this following shit is done also during normal noodlification, I need to split it to some better defined functions
+
+            element_to_process.remove_inclusion(inclusion_to_process);
+
+            // We might be updating left side, in that case we need to process all nodes that contain the variables from the left,
+            // i.e. those nodes to which inclusion_to_process goes to. In the case we are updating right side, there will be no edges
+            // coming from inclusion_to_process, so this for loop will do nothing.
+            for (const auto &dependent_inclusion : element_to_process.get_dependent_inclusions(inclusion_to_process)) {
+                // we push only those nodes which are not already in inclusions_to_process
+                // if the inclusion_to_process is on cycle, we need to do BFS
+                // if it is not on cycle, we can do DFS
+                // TODO: can we really do DFS??
+                element_to_process.push_unique(dependent_inclusion, is_inclusion_to_process_on_cycle);
+            }
 
-                // TODO: all this following shit is done also during normal noodlification, I need to split it to some better defined functions
+            // do substitution in the inclusion graph
+            element_to_process.substitute_vars(substitution_map);
+            // update the substitution_map of new_element by the new substitutions
+            element_to_process.substitution_map.merge(substitution_map);
 
-                element_to_process.remove_inclusion(inclusion_to_process);
+            // TODO: should we really push to front when not on cycle?
+            // TODO: maybe for this case of one side being empty, we should just push to front?
+            if (!is_inclusion_to_process_on_cycle) {
+                push_to_worklist(std::move(element_to_process), true);
+            } else {
+                push_to_worklist(std::move(element_to_process), false);
+            }
+            return false;
+        }
+        /********************************************************************************************************/
+        /*************************************** End of one side is empty ***************************************/
+        /********************************************************************************************************/
 
-                // We might be updating left side, in that case we need to process all nodes that contain the variables from the left,
-                // i.e. those nodes to which inclusion_to_process goes to. In the case we are updating right side, there will be no edges
-                // coming from inclusion_to_process, so this for loop will do nothing.
-                for (const auto &dependent_inclusion : element_to_process.get_dependent_inclusions(inclusion_to_process)) {
-                    // we push only those nodes which are not already in inclusions_to_process
-                    // if the inclusion_to_process is on cycle, we need to do BFS
-                    // if it is not on cycle, we can do DFS
-                    // TODO: can we really do DFS??
-                    element_to_process.push_unique(dependent_inclusion, is_inclusion_to_process_on_cycle);
-                }
 
-                // do substitution in the inclusion graph
-                element_to_process.substitute_vars(substitution_map);
-                // update the substitution_map of new_element by the new substitutions
-                element_to_process.substitution_map.merge(substitution_map);
 
-                // TODO: should we really push to front when not on cycle?
-                // TODO: maybe for this case of one side being empty, we should just push to front?
-                if (!is_inclusion_to_process_on_cycle) {
-                    worklist.push_front(element_to_process);
-                } else {
-                    worklist.push_back(element_to_process);
-                }
-                continue;
+        /********************************************************************************************************/
+        /****************************************** Process left side *******************************************/
+        /********************************************************************************************************/
+        const ReductionPolicy reduction_policy(m_params);
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> left_side_automata;
+        STRACE("str-nfa", tout << "Left automata:" << std::endl);
+        for (const auto &l_var : left_side_vars) {
+            left_side_automata.push_back(element_to_process.aut_ass.at(l_var));
+            STRACE("str-nfa",
+                tout << "Automaton for left var " << l_var.get_name() << ":" << std::endl;
+                left_side_automata.back()->print_to_DOT(tout);
+            );
+        }
+        /********************************************************************************************************/
+        /************************************** End of left side processing *************************************/
+        /********************************************************************************************************/
+
+
+
+
+        /********************************************************************************************************/
+        /***************************************** Process right side *******************************************/
+        /********************************************************************************************************/
+        // We combine the right side into automata where we concatenate non-length-aware vars next to each other.
+        // Each right side automaton corresponds to either concatenation of non-length-aware vars (vector of
+        // basic terms) or one lenght-aware var (vector of one basic term). Division then contains for each right
+        // side automaton the variables whose concatenation it represents.
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> right_side_automata;
+        std::vector<std::vector<BasicTerm>> right_side_division;
+
+        assert(!right_side_vars.empty()); // empty case was processed at the beginning
+        auto right_var_it = right_side_vars.begin();
+        auto right_side_end = right_side_vars.end();
+
+        // the automata of a run of non-length-aware vars are concatenated as a balanced tree (see concat_run), the
+        // run is closed when a length-aware var follows
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> next_run{ element_to_process.aut_ass[*right_var_it] };
+        std::vector<BasicTerm> next_division{ *right_var_it };
+        bool last_was_length = (element_to_process.length_sensitive_vars.count(*right_var_it) > 0);
+        bool is_there_length_on_right = last_was_length;
+        ++right_var_it;
+
+        // Concatenation of next_run[from..to) as a balanced tree, so that the intermediate results are not copied again
+        // for each var of a long run. Each node is reduced by the reduction policy and memoized in the segment pool, as
+        // sibling noodles share the automata of their segments, the nodes of their common parts of runs are reused.
+        std::function<std::shared_ptr<mata::nfa::Nfa>(size_t, size_t)> concat_run = [&](size_t from, size_t to) {
+            if (to - from == 1) {
+                return next_run[from];
             }
-            /********************************************************************************************************/
-            /*************************************** End of one side is empty ***************************************/
-            /********************************************************************************************************/
-
-
-
-            /********************************************************************************************************/
-            /****************************************** Process left side *******************************************/
-            /********************************************************************************************************/
-            std::vector<std::shared_ptr<mata::nfa::Nfa>> left_side_automata;
-            STRACE("str-nfa", tout << "Left automata:" << std::endl);
-            for (const auto &l_var : left_side_vars) {
-                left_side_automata.push_back(element_to_process.aut_ass.at(l_var));
-                STRACE("str-nfa",
-                    tout << "Automaton for left var " << l_var.get_name() << ":" << std::endl;
-                    left_side_automata.back()->print_to_DOT(tout);
-                );
-            }
-            /********************************************************************************************************/
-            /************************************** End of left side processing *************************************/
-            /********************************************************************************************************/
-
-
-
-
-            /********************************************************************************************************/
-            /***************************************** Process right side *******************************************/
-            /********************************************************************************************************/
-            // We combine the right side into automata where we concatenate non-length-aware vars next to each other.
-            // Each right side automaton corresponds to either concatenation of non-length-aware vars (vector of
-            // basic terms) or one lenght-aware var (vector of one basic term). Division then contains for each right
-            // side automaton the variables whose concatenation it represents.
-            std::vector<std::shared_ptr<mata::nfa::Nfa>> right_side_automata;
-            std::vector<std::vector<BasicTerm>> right_side_division;
-
-            assert(!right_side_vars.empty()); // empty case was processed at the beginning
-            auto right_var_it = right_side_vars.begin();
-            auto right_side_end = right_side_vars.end();
-
-            std::shared_ptr<mata::nfa::Nfa> next_aut = element_to_process.aut_ass[*right_var_it];
-            std::vector<BasicTerm> next_division{ *right_var_it };
-            bool last_was_length = (element_to_process.length_sensitive_vars.count(*right_var_it) > 0);
-            bool is_there_length_on_right = last_was_length;
-            ++right_var_it;
-
-            STRACE("str-nfa", tout << "Right automata:" << std::endl);
-            for (; right_var_it != right_side_end; ++right_var_it) {
-                std::shared_ptr<mata::nfa::Nfa> right_var_aut = element_to_process.aut_ass.at(*right_var_it);
-                if (element_to_process.length_sensitive_vars.count(*right_var_it) > 0) {
-                    // current right_var is length-aware
-                    right_side_automata.push_back(next_aut);
-                    right_side_division.push_back(next_division);
-                    STRACE("str-nfa",
-                        tout << "Automaton for right var(s)";
-                        for (const auto &r_var : next_division) {
-                            tout << " " << r_var.get_name();
-                        }
-                        tout << ":" << std::endl;
-                        next_aut->print_to_DOT(tout);
-                    );
-                    next_aut = right_var_aut;
-                    next_division = std::vector<BasicTerm>{ *right_var_it };
-                    last_was_length = true;
-                    is_there_length_on_right = true;
-                } else {
-                    // current right_var is not length-aware
-                    if (last_was_length) {
-                        // if last var was length-aware, we need to add automaton for it into right_side_automata
-                        right_side_automata.push_back(next_aut);
-                        right_side_division.push_back(next_division);
-                        STRACE("str-nfa",
-                            tout << "Automaton for right var(s)";
-                            for (const auto &r_var : next_division) {
-                                tout << " " << r_var.get_name();
-                            }
-                            tout << ":" << std::endl;
-                            next_aut->print_to_DOT(tout);
-                        );
-                        next_aut = right_var_aut;
-                        next_division = std::vector<BasicTerm>{ *right_var_it };
-                    } else {
-                        // if last var was not length-aware, we combine it (and possibly the non-length-aware vars before)
-                        // with the current one
-                        next_aut = std::make_shared<mata::nfa::Nfa>(mata::nfa::concatenate(*next_aut, *right_var_aut));
-                        next_division.push_back(*right_var_it);
-                        // TODO should we reduce size here?
-                    }
-                    last_was_length = false;
-                }
+            const size_t middle = from + (to - from) / 2;
+            bool memo_hit = false;
+            std::shared_ptr<mata::nfa::Nfa> result = segment_pool.get_concatenation(concat_run(from, middle), concat_run(middle, to), [&reduction_policy](std::shared_ptr<mata::nfa::Nfa> aut) {
+                return reduction_policy.reduce(ReductionPolicy::Site::CONCATENATION, aut);
+            }, memo_hit);
+            if (memo_hit) {
+                add_to_stat(stats.num_concatenation_memo_hits, 1);
             }
-            right_side_automata.push_back(next_aut);
+            return result;
+        };
+        // closes the current run (or the length-aware var) and starts a new one with the current var
+        auto close_run = [&](const std::shared_ptr<mata::nfa::Nfa>& right_var_aut) {
+            right_side_automata.push_back(concat_run(0, next_run.size()));
             right_side_division.push_back(next_division);
             STRACE("str-nfa",
                 tout << "Automaton for right var(s)";
@@ -355,224 +1330,353 @@ namespace smt::noodler {
                     tout << " " << r_var.get_name();
                 }
                 tout << ":" << std::endl;
-                next_aut->print_to_DOT(tout);
+                right_side_automata.back()->print_to_DOT(tout);
             );
-            /********************************************************************************************************/
-            /************************************* End of right side processing *************************************/
-            /********************************************************************************************************/
-
-
-            /********************************************************************************************************/
-            /****************************************** Inclusion test **********************************************/
-            /********************************************************************************************************/
-            if (!is_there_length_on_right) {
-                // we have no length-aware variables on the right hand side => we need to check if inclusion holds
-                assert(right_side_automata.size() == 1); // there should be exactly one element in right_side_automata as we do not have length variables
-                // TODO probably we should try shortest words, it might work correctly
-                if (is_inclusion_to_process_on_cycle // we do not test inclusion if we have node that is not on cycle, because we will not go back to it (TODO: should we really not test it?)
-                    && mata::nfa::is_included(element_to_process.aut_ass.get_automaton_concat(left_side_vars), *right_side_automata[0])) {
-                    // TODO can I push to front? I think I can, and I probably want to, so I can immediately test if it is not sat (if element_to_process.inclusions_to_process is empty), or just to get to sat faster
-                    worklist.push_front(element_to_process);
-                    // we continue as there is no need for noodlification, inclusion already holds
-                    continue;
+            next_run = { right_var_aut };
+            next_division = std::vector<BasicTerm>{ *right_var_it };
+        };
+
+        STRACE("str-nfa", tout << "Right automata:" << std::endl);
+        for (; right_var_it != right_side_end; ++right_var_it) {
+            std::shared_ptr<mata::nfa::Nfa> right_var_aut = element_to_process.aut_ass.at(*right_var_it);
+            if (element_to_process.length_sensitive_vars.count(*right_var_it) > 0) {
+                // current right_var is length-aware
+                close_run(right_var_aut);
+                last_was_length = true;
+                is_there_length_on_right = true;
+            } else {
+                // current right_var is not length-aware
+                if (last_was_length) {
+                    // if last var was length-aware, we need to add automaton for it into right_side_automata
+                    close_run(right_var_aut);
+                } else {
+                    // if last var was not length-aware, the current one is added to the run of the non-length-aware
+                    // vars before it
+                    next_run.push_back(right_var_aut);
+                    next_division.push_back(*right_var_it);
                 }
+                last_was_length = false;
             }
-            /********************************************************************************************************/
-            /*************************************** End of inclusion test ******************************************/
-            /********************************************************************************************************/
-
-            element_to_process.remove_inclusion(inclusion_to_process);
-
-            // We are going to change the automata on the left side (potentially also split some on the right side, but that should not have impact)
-            // so we need to add all nodes whose variable assignments are going to change on the right side (i.e. we follow inclusion graph) for processing.
-            // Warning: Self-loops are not in inclusion graph, but we might still want to add this node again to inclusions_to_process, however, this node will be
-            // split during noodlification, so we will only add parts whose right sides actually change (see below in noodlification)
-            for (const auto &node : element_to_process.get_dependent_inclusions(inclusion_to_process)) {
-                // we push only those nodes which are not already in inclusions_to_process
-                // if the inclusion_to_process is on cycle, we need to do BFS
-                // if it is not on cycle, we can do DFS
-                // TODO: can we really do DFS??
-                element_to_process.push_unique(node, is_inclusion_to_process_on_cycle);
+        }
+        right_side_automata.push_back(concat_run(0, next_run.size()));
+        right_side_division.push_back(next_division);
+        STRACE("str-nfa",
+            tout << "Automaton for right var(s)";
+            for (const auto &r_var : next_division) {
+                tout << " " << r_var.get_name();
             }
-            // We will need the set of left vars, so we can sort the 'non-existing self-loop' in noodlification (see previous warning)
-            const auto left_vars_set = inclusion_to_process.get_left_set();
-
-
-            /* TODO check here if we have empty elements_to_process, if we do, then every noodle we get should finish and return sat
-             * right now if we test sat at the beginning it should work, but it is probably better to immediatly return sat if we have
-             * empty elements_to_process, however, we need to remmeber the state of the algorithm, we would need to return back to noodles
-             * and process them if z3 realizes that the result is actually not sat (because of lengths)
-             */
+            tout << ":" << std::endl;
+            right_side_automata.back()->print_to_DOT(tout);
+        );
+        /********************************************************************************************************/
+        /************************************* End of right side processing *************************************/
+        /********************************************************************************************************/
+
+
+        /********************************************************************************************************/
+        /****************************************** Inclusion test **********************************************/
+        /********************************************************************************************************/
+        if (!is_there_length_on_right) {
+            // we have no length-aware variables on the right hand side => we need to check if inclusion holds
+            assert(right_side_automata.size() == 1); // there should be exactly one element in right_side_automata as we do not have length variables
+            // TODO probably we should try shortest words, it might work correctly
+            bool inclusion_holds = false;
+            if (is_inclusion_to_process_on_cycle) { // we do not test inclusion if we have node that is not on cycle, because we will not go back to it (TODO: should we really not test it?)
+                add_to_stat(stats.num_inclusion_checks, 1);
+                std::vector<std::shared_ptr<mata::nfa::Nfa>> left_side_automata;
+                for (const BasicTerm& left_var : left_side_vars) {
+                    left_side_automata.push_back(element_to_process.aut_ass.at(left_var));
+                }
+                bool cache_hit = false;
+                inclusion_holds = inclusion_cache.is_included(left_side_automata, right_side_automata[0], cache_hit);
+                if (cache_hit) {
+                    add_to_stat(stats.num_inclusion_cache_hits, 1);
+                }
+            }
+            if (inclusion_holds) {
+                // TODO can I push to front? I think I can, and I probably want to, so I can immediately test if it is not sat (if element_to_process.inclusions_to_process is empty), or just to get to sat faster
+                push_to_worklist(std::move(element_to_process), true);
+                // we continue as there is no need for noodlification, inclusion already holds
+                return false;
+            }
+        }
+        /********************************************************************************************************/
+        /*************************************** End of inclusion test ******************************************/
+        /********************************************************************************************************/
+
+        element_to_process.remove_inclusion(inclusion_to_process);
+
+        // We are going to change the automata on the left side (potentially also split some on the right side, but that should not have impact)
+        // so we need to add all nodes whose variable assignments are going to change on the right side (i.e. we follow inclusion graph) for processing.
+        // Warning: Self-loops are not in inclusion graph, but we might still want to add this node again to inclusions_to_process, however, this node will be
+        // split during noodlification, so we will only add parts whose right sides actually change (see below in noodlification)
+        for (const auto &node : element_to_process.get_dependent_inclusions(inclusion_to_process)) {
+            // we push only those nodes which are not already in inclusions_to_process
+            // if the inclusion_to_process is on cycle, we need to do BFS
+            // if it is not on cycle, we can do DFS
+            // TODO: can we really do DFS??
+            element_to_process.push_unique(node, is_inclusion_to_process_on_cycle);
+        }
+        // We will need the set of left vars, so we can sort the 'non-existing self-loop' in noodlification (see previous warning)
+        const auto left_vars_set = inclusion_to_process.get_left_set();
 
-            
 
-            /********************************************************************************************************/
-            /******************************************* Noodlification *********************************************/
-            /********************************************************************************************************/
-            /**
-             * We get noodles where each noodle consists of automata connected with a vector of numbers.
-             * So for example if we have some noodle and automaton noodle[i].first, then noodle[i].second is a vector,
-             * where first element i_l = noodle[i].second[0] tells us that automaton noodle[i].first belongs to the
-             * i_l-th left var (i.e. left_side_vars[i_l]) and the second element i_r = noodle[i].second[1] tell us that
-             * it belongs to the i_r-th division of the right side (i.e. right_side_division[i_r])
-             **/
-            auto noodles = mata::strings::seg_nfa::noodlify_for_equation(left_side_automata, 
-                                                                        right_side_automata,
-                                                                        false, 
-                                                                        {{"reduce", "forward"}});
+        /* TODO check here if we have empty elements_to_process, if we do, then every noodle we get should finish and return sat
+         * right now if we test sat at the beginning it should work, but it is probably better to immediatly return sat if we have
+         * empty elements_to_process, however, we need to remmeber the state of the algorithm, we would need to return back to noodles
+         * and process them if z3 realizes that the result is actually not sat (because of lengths)
+         */
 
-            for (const auto &noodle : noodles) {
-                STRACE("str", tout << "Processing noodle" << (is_trace_enabled("str-nfa") ? " with automata:" : "") << std::endl;);
-                SolvingState new_element = element_to_process;
-
-                /* Explanation of the next code on an example:
-                 * Left side has variables x_1, x_2, x_3, x_2 while the right side has variables x_4, x_1, x_5, x_6, where x_1
-                 * and x_4 are length-aware (i.e. there is one automaton for concatenation of x_5 and x_6 on the right side).
-                 * Assume that noodle represents the case where it was split like this:
-                 *              | x_1 |    x_2    | x_3 |       x_2       |
-                 *              | t_1 | t_2 | t_3 | t_4 | t_5 |    t_6    |
-                 *              |    x_4    |       x_1       | x_5 | x_6 |
-                 * In the following for loop, we create the vars t1, t2, ..., t6 and prepare two vectors left_side_vars_to_new_vars
-                 * and right_side_divisions_to_new_vars which map left vars and right divisions into the concatenation of the new
-                 * vars. So for example left_side_vars_to_new_vars[1] = t_2 t_3, because second left var is x_2 and we map it to t_2 t_3,
-                 * while right_side_divisions_to_new_vars[2] = t_6, because the third division on the right represents the automaton for
-                 * concatenation of x_5 and x_6 and we map it to t_6.
-                 */
-                std::vector<std::vector<BasicTerm>> left_side_vars_to_new_vars(left_side_vars.size());
-                std::vector<std::vector<BasicTerm>> right_side_divisions_to_new_vars(right_side_division.size());
-                for (unsigned i = 0; i < noodle.size(); ++i) {
-                    // TODO do not make a new_var if we can replace it with one left or right var (i.e. new_var is exactly left or right var)
-                    // TODO also if we can substitute with epsilon, we should do that first? or generally process epsilon substitutions better, in some sort of 'preprocessing'
-                    BasicTerm new_var = util::mk_noodler_var_fresh(std::string("align_") + std::to_string(noodlification_no));
-                    left_side_vars_to_new_vars[noodle[i].second[0]].push_back(new_var);
-                    right_side_divisions_to_new_vars[noodle[i].second[1]].push_back(new_var);
-                    new_element.aut_ass[new_var] = noodle[i].first; // we assign the automaton to new_var
-                    STRACE("str-nfa", tout << new_var << std::endl << *noodle[i].first;);
-                }
-
-                // Each variable that occurs in the left side or is length-aware needs to be substituted, we use this map for that 
-                std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map;
-
-                /* Following the example from before, the following loop will create these inclusions from the right side divisions:
-                 *         t_1 t_2 ⊆ x_4
-                 *     t_3 t_4 t_5 ⊆ x_1
-                 *             t_6 ⊆ x_5 x_6
-                 * However, we do not add the first two inclusions into the inclusion graph but use them for substitution, i.e.
-                 *        substitution_map[x_4] = t_1 t_2
-                 *        substitution_map[x_1] = t_3 t_4 t_5
-                 * because they are length-aware vars.
-                 */
-                for (unsigned i = 0; i < right_side_division.size(); ++i) {
-                    const auto &division = right_side_division[i];
-                    if (division.size() == 1 && element_to_process.length_sensitive_vars.count(division[0]) != 0) {
-                        // right side is length-aware variable y => we are either substituting or adding new inclusion "new_vars ⊆ y"
-                        const BasicTerm &right_var = division[0];
-                        if (substitution_map.count(right_var)) {
-                            // right_var is already substituted, therefore we add 'new_vars ⊆ right_var' to the inclusion graph
-                            // TODO: how to decide if sometihng is on cycle? by previous node being on cycle, or when we recompute inclusion graph edges?
-                            const auto &new_inclusion = new_element.add_inclusion(right_side_divisions_to_new_vars[i], division, is_inclusion_to_process_on_cycle);
-                            // we also add this inclusion to the worklist, as it represents unification
-                            // we push it to the front if we are processing node that is not on the cycle, because it should not get stuck in the cycle then
-                            // TODO: is this correct? can we push to the front?
-                            // TODO: can't we push to front even if it is on cycle??
-                            new_element.push_unique(new_inclusion, is_inclusion_to_process_on_cycle);
-                            STRACE("str", tout << "added new inclusion from the right side because it could not be substituted: " << new_inclusion << std::endl; );
-                        } else {
-                            // right_var is not substitued by anything yet, we will substitute it
-                            substitution_map[right_var] = right_side_divisions_to_new_vars[i];
-                            STRACE("str", tout << "right side var " << right_var.get_name() << " replaced with:"; for (auto const &var : right_side_divisions_to_new_vars[i]) { tout << " " << var.get_name(); } tout << std::endl; );
-                            // as right_var wil be substituted in the inclusion graph, we do not need to remember the automaton assignment for it
-                            new_element.aut_ass.erase(right_var);
-                            // update the length variables
-                            for (const BasicTerm &new_var : right_side_divisions_to_new_vars[i]) {
-                                new_element.length_sensitive_vars.insert(new_var);
-                            }
-                        }
+        
 
-                    } else {
-                        // right side is non-length concatenation "y_1...y_n" => we are adding new inclusion "new_vars ⊆ y1...y_n"
-                        // TODO: how to decide if sometihng is on cycle? by previous node being on cycle, or when we recompute inclusion graph edges?
-                        // TODO: do we need to add inclusion if previous node was not on cycle? because I think it is not possible to get to this new node anyway
-                        const auto &new_inclusion = new_element.add_inclusion(right_side_divisions_to_new_vars[i], division, is_inclusion_to_process_on_cycle);
-                        // we add this inclusion to the worklist only if the right side contains something that was on the left (i.e. it was possibly changed)
-                        if (SolvingState::is_dependent(left_vars_set, new_inclusion.get_right_set())) {
-                            // TODO: again, push to front? back? where the fuck to push??
-                            new_element.push_unique(new_inclusion, is_inclusion_to_process_on_cycle);
-                        }
-                        STRACE("str", tout << "added new inclusion from the right side (non-length): " << new_inclusion << std::endl; );
+        /********************************************************************************************************/
+        /******************************************* Noodlification *********************************************/
+        /********************************************************************************************************/
+        /**
+         * We get noodles where each noodle consists of automata connected with a vector of numbers.
+         * So for example if we have some noodle and automaton noodle[i].first, then noodle[i].second is a vector,
+         * where first element i_l = noodle[i].second[0] tells us that automaton noodle[i].first belongs to the
+         * i_l-th left var (i.e. left_side_vars[i_l]) and the second element i_r = noodle[i].second[1] tell us that
+         * it belongs to the i_r-th division of the right side (i.e. right_side_division[i_r])
+         **/
+        // the product of the noodlification has at most (states of left side) * (states of right side) states
+        size_t left_states = 0, right_states = 0;
+        for (const auto &aut : left_side_automata) {
+            left_states += aut->num_of_states();
+        }
+        for (const auto &aut : right_side_automata) {
+            right_states += aut->num_of_states();
+        }
+        ReductionPolicy::Reduction product_reduction;
+        auto noodles = mata::strings::seg_nfa::noodlify_for_equation(left_side_automata, 
+                                                                    right_side_automata,
+                                                                    false, 
+                                                                    reduction_policy.noodlify_params(left_states * right_states, product_reduction));
+        // noodles can share automata, each of them is reduced only once, and structurally identical segments
+        // (of these or earlier noodles) are replaced by one shared automaton
+        std::unordered_map<const mata::nfa::Nfa*, std::shared_ptr<mata::nfa::Nfa>> reduced_noodle_auts;
+        for (auto &noodle : noodles) {
+            for (auto &noodle_aut : noodle) {
+                auto [it, inserted] = reduced_noodle_auts.try_emplace(noodle_aut.first.get());
+                if (inserted) {
+                    bool shared = false;
+                    it->second = segment_pool.intern(reduction_policy.reduce(ReductionPolicy::Site::NOODLE, noodle_aut.first, product_reduction), shared);
+                    if (shared) {
+                        add_to_stat(stats.num_shared_segments, 1);
                     }
                 }
+                noodle_aut.first = it->second;
+            }
+        }
+        add_to_stat(stats.num_noodlifications, 1);
+        add_to_stat(stats.num_noodles, noodles.size());
+        for (const auto &aut : left_side_automata) {
+            max_to_stat(stats.max_aut_states, aut->num_of_states());
+        }
+        for (const auto &aut : right_side_automata) {
+            max_to_stat(stats.max_aut_states, aut->num_of_states());
+        }
+        for (const auto &noodle : noodles) {
+            for (const auto &noodle_aut : noodle) {
+                max_to_stat(stats.max_aut_states, noodle_aut.first->num_of_states());
+                add_to_stat(stats.total_aut_states, noodle_aut.first->num_of_states());
+            }
+        }
 
-                /* Following the example from before, the following loop will create these inclusions from the left side:
-                 *           x_1 ⊆ t_1
-                 *           x_2 ⊆ t_2 t_3
-                 *           x_3 ⊆ t_4
-                 *           x_2 ⊆ t_5 t_6
-                 * Again, we want to use the inclusions for substitutions, but we replace only those variables which were
-                 * not substituted yet, so the first inclusion stays (x_1 was substituted from the right side) and the
-                 * fourth inclusion stays (as we substitute x_2 using the second inclusion). So from the second and third
-                 * inclusion we get:
-                 *        substitution_map[x_2] = t_2 t_3
-                 *        substitution_map[x_3] = t_4
-                 */
-                for (unsigned i = 0; i < left_side_vars.size(); ++i) {
-                    // TODO maybe if !is_there_length_on_right, we should just do intersection and not create new inclusions
-                    const BasicTerm &left_var = left_side_vars[i];
-                    if (left_var.is_literal()) {
-                        // we skip literals, we do not want to substitute them
-                        continue;
-                    }
-                    if (substitution_map.count(left_var)) {
-                        // left_var is already substituted, therefore we add 'left_var ⊆ left_side_vars_to_new_vars[i]' to the inclusion graph
-                        std::vector<BasicTerm> new_inclusion_left_side{ left_var };
+        if (noodles.empty()) {
+            // the inclusion cannot hold for the current automata of its terms, other solving states where it has the same automata fail too
+            STRACE("str", tout << "no noodle for " << inclusion_to_process << ", learned as nogood" << std::endl;);
+            nogoods.add(inclusion_to_process, element_to_process.aut_ass);
+            add_to_stat(stats.num_nogoods, 1);
+            return false;
+        }
+
+        // creates the solving state for one noodle, it can be called also later, after this function
+        // returns (see the suspended noodlification below), so it cannot capture local variables by reference
+        auto create_state_from_noodle = [left_side_vars = left_side_vars, right_side_division = std::move(right_side_division),
+                                         left_vars_set, is_inclusion_to_process_on_cycle]
+                                        (const SolvingState& base, const auto& noodle) {
+            STRACE("str", tout << "Processing noodle" << (is_trace_enabled("str-nfa") ? " with automata:" : "") << std::endl;);
+            SolvingState new_element = base;
+
+            /* Explanation of the next code on an example:
+             * Left side has variables x_1, x_2, x_3, x_2 while the right side has variables x_4, x_1, x_5, x_6, where x_1
+             * and x_4 are length-aware (i.e. there is one automaton for concatenation of x_5 and x_6 on the right side).
+             * Assume that noodle represents the case where it was split like this:
+             *              | x_1 |    x_2    | x_3 |       x_2       |
+             *              | t_1 | t_2 | t_3 | t_4 | t_5 |    t_6    |
+             *              |    x_4    |       x_1       | x_5 | x_6 |
+             * In the following for loop, we create the vars t1, t2, ..., t6 and prepare two vectors left_side_vars_to_new_vars
+             * and right_side_divisions_to_new_vars which map left vars and right divisions into the concatenation of the new
+             * vars. So for example left_side_vars_to_new_vars[1] = t_2 t_3, because second left var is x_2 and we map it to t_2 t_3,
+             * while right_side_divisions_to_new_vars[2] = t_6, because the third division on the right represents the automaton for
+             * concatenation of x_5 and x_6 and we map it to t_6.
+             */
+            std::vector<std::vector<BasicTerm>> left_side_vars_to_new_vars(left_side_vars.size());
+            std::vector<std::vector<BasicTerm>> right_side_divisions_to_new_vars(right_side_division.size());
+            for (unsigned i = 0; i < noodle.size(); ++i) {
+                // TODO do not make a new_var if we can replace it with one left or right var (i.e. new_var is exactly left or right var)
+                // TODO also if we can substitute with epsilon, we should do that first? or generally process epsilon substitutions better, in some sort of 'preprocessing'
+                BasicTerm new_var = util::mk_noodler_var_fresh("align");
+                left_side_vars_to_new_vars[noodle[i].second[0]].push_back(new_var);
+                right_side_divisions_to_new_vars[noodle[i].second[1]].push_back(new_var);
+                new_element.aut_ass[new_var] = noodle[i].first; // we assign the automaton to new_var
+                STRACE("str-nfa", tout << new_var << std::endl << *noodle[i].first;);
+            }
+
+            // Each variable that occurs in the left side or is length-aware needs to be substituted, we use this map for that 
+            std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map;
+
+            /* Following the example from before, the following loop will create these inclusions from the right side divisions:
+             *         t_1 t_2 ⊆ x_4
+             *     t_3 t_4 t_5 ⊆ x_1
+             *             t_6 ⊆ x_5 x_6
+             * However, we do not add the first two inclusions into the inclusion graph but use them for substitution, i.e.
+             *        substitution_map[x_4] = t_1 t_2
+             *        substitution_map[x_1] = t_3 t_4 t_5
+             * because they are length-aware vars.
+             */
+            for (unsigned i = 0; i < right_side_division.size(); ++i) {
+                const auto &division = right_side_division[i];
+                if (division.size() == 1 && base.length_sensitive_vars.count(division[0]) != 0) {
+                    // right side is length-aware variable y => we are either substituting or adding new inclusion "new_vars ⊆ y"
+                    const BasicTerm &right_var = division[0];
+                    if (substitution_map.count(right_var)) {
+                        // right_var is already substituted, therefore we add 'new_vars ⊆ right_var' to the inclusion graph
                         // TODO: how to decide if sometihng is on cycle? by previous node being on cycle, or when we recompute inclusion graph edges?
-                        const auto &new_inclusion = new_element.add_inclusion(new_inclusion_left_side, left_side_vars_to_new_vars[i], is_inclusion_to_process_on_cycle);
+                        const auto &new_inclusion = new_element.add_inclusion(right_side_divisions_to_new_vars[i], division, is_inclusion_to_process_on_cycle);
                         // we also add this inclusion to the worklist, as it represents unification
                         // we push it to the front if we are processing node that is not on the cycle, because it should not get stuck in the cycle then
                         // TODO: is this correct? can we push to the front?
                         // TODO: can't we push to front even if it is on cycle??
                         new_element.push_unique(new_inclusion, is_inclusion_to_process_on_cycle);
-                        STRACE("str", tout << "added new inclusion from the left side because it could not be substituted: " << new_inclusion << std::endl; );
+                        STRACE("str", tout << "added new inclusion from the right side because it could not be substituted: " << new_inclusion << std::endl; );
                     } else {
-                        // TODO make this function or something, we do the same thing here as for the right side when substituting
-                        // left_var is not substitued by anything yet, we will substitute it
-                        substitution_map[left_var] = left_side_vars_to_new_vars[i];
-                        STRACE("str", tout << "left side var " << left_var.get_name() << " replaced with:"; for (auto const &var : left_side_vars_to_new_vars[i]) { tout << " " << var.get_name(); } tout << std::endl; );
-                        // as left_var wil be substituted in the inclusion graph, we do not need to remember the automaton assignment for it
-                        new_element.aut_ass.erase(left_var);
+                        // right_var is not substitued by anything yet, we will substitute it
+                        substitution_map[right_var] = right_side_divisions_to_new_vars[i];
+                        STRACE("str", tout << "right side var " << right_var.get_name() << " replaced with:"; for (auto const &var : right_side_divisions_to_new_vars[i]) { tout << " " << var.get_name(); } tout << std::endl; );
+                        // as right_var wil be substituted in the inclusion graph, we do not need to remember the automaton assignment for it
+                        new_element.aut_ass.erase(right_var);
                         // update the length variables
-                        if (new_element.length_sensitive_vars.count(left_var) > 0) { // if left_var is length-aware => substituted vars should become length-aware
-                            for (const BasicTerm &new_var : left_side_vars_to_new_vars[i]) {
-                                new_element.length_sensitive_vars.insert(new_var);
-                            }
+                        for (const BasicTerm &new_var : right_side_divisions_to_new_vars[i]) {
+                            new_element.length_sensitive_vars.insert(new_var);
                         }
                     }
-                }
-
-                // do substitution in the inclusion graph
-                new_element.substitute_vars(substitution_map);
 
-                // update the substitution_map of new_element by the new substitutions
-                new_element.substitution_map.merge(substitution_map);
-
-                // TODO should we really push to front when not on cycle?
-                if (!is_inclusion_to_process_on_cycle) {
-                    worklist.push_front(new_element);
                 } else {
-                    worklist.push_back(new_element);
+                    // right side is non-length concatenation "y_1...y_n" => we are adding new inclusion "new_vars ⊆ y1...y_n"
+                    // TODO: how to decide if sometihng is on cycle? by previous node being on cycle, or when we recompute inclusion graph edges?
+                    // TODO: do we need to add inclusion if previous node was not on cycle? because I think it is not possible to get to this new node anyway
+                    const auto &new_inclusion = new_element.add_inclusion(right_side_divisions_to_new_vars[i], division, is_inclusion_to_process_on_cycle);
+                    // we add this inclusion to the worklist only if the right side contains something that was on the left (i.e. it was possibly changed)
+                    if (SolvingState::is_dependent(left_vars_set, new_inclusion.get_right_set())) {
+                        // TODO: again, push to front? back? where the fuck to push??
+                        new_element.push_unique(new_inclusion, is_inclusion_to_process_on_cycle);
+                    }
+                    STRACE("str", tout << "added new inclusion from the right side (non-length): " << new_inclusion << std::endl; );
                 }
+            }
 
+            /* Following the example from before, the following loop will create these inclusions from the left side:
+             *           x_1 ⊆ t_1
+             *           x_2 ⊆ t_2 t_3
+             *           x_3 ⊆ t_4
+             *           x_2 ⊆ t_5 t_6
+             * Again, we want to use the inclusions for substitutions, but we replace only those variables which were
+             * not substituted yet, so the first inclusion stays (x_1 was substituted from the right side) and the
+             * fourth inclusion stays (as we substitute x_2 using the second inclusion). So from the second and third
+             * inclusion we get:
+             *        substitution_map[x_2] = t_2 t_3
+             *        substitution_map[x_3] = t_4
+             */
+            for (unsigned i = 0; i < left_side_vars.size(); ++i) {
+                // TODO maybe if !is_there_length_on_right, we should just do intersection and not create new inclusions
+                const BasicTerm &left_var = left_side_vars[i];
+                if (left_var.is_literal()) {
+                    // we skip literals, we do not want to substitute them
+                    continue;
+                }
+                if (substitution_map.count(left_var)) {
+                    // left_var is already substituted, therefore we add 'left_var ⊆ left_side_vars_to_new_vars[i]' to the inclusion graph
+                    std::vector<BasicTerm> new_inclusion_left_side{ left_var };
+                    // TODO: how to decide if sometihng is on cycle? by previous node being on cycle, or when we recompute inclusion graph edges?
+                    const auto &new_inclusion = new_element.add_inclusion(new_inclusion_left_side, left_side_vars_to_new_vars[i], is_inclusion_to_process_on_cycle);
+                    // we also add this inclusion to the worklist, as it represents unification
+                    // we push it to the front if we are processing node that is not on the cycle, because it should not get stuck in the cycle then
+                    // TODO: is this correct? can we push to the front?
+                    // TODO: can't we push to front even if it is on cycle??
+                    new_element.push_unique(new_inclusion, is_inclusion_to_process_on_cycle);
+                    STRACE("str", tout << "added new inclusion from the left side because it could not be substituted: " << new_inclusion << std::endl; );
+                } else {
+                    // TODO make this function or something, we do the same thing here as for the right side when substituting
+                    // left_var is not substitued by anything yet, we will substitute it
+                    substitution_map[left_var] = left_side_vars_to_new_vars[i];
+                    STRACE("str", tout << "left side var " << left_var.get_name() << " replaced with:"; for (auto const &var : left_side_vars_to_new_vars[i]) { tout << " " << var.get_name(); } tout << std::endl; );
+                    // as left_var wil be substituted in the inclusion graph, we do not need to remember the automaton assignment for it
+                    new_element.aut_ass.erase(left_var);
+                    // update the length variables
+                    if (new_element.length_sensitive_vars.count(left_var) > 0) { // if left_var is length-aware => substituted vars should become length-aware
+                        for (const BasicTerm &new_var : left_side_vars_to_new_vars[i]) {
+                            new_element.length_sensitive_vars.insert(new_var);
+                        }
+                    }
+                }
             }
 
-            ++noodlification_no; // TODO: when to do this increment?? maybe noodlification_no should be part of SolvingState?
-            /********************************************************************************************************/
-            /*************************************** End of noodlification ******************************************/
-            /********************************************************************************************************/
+            // do substitution in the inclusion graph
+            new_element.substitute_vars(substitution_map);
+
+            // update the substitution_map of new_element by the new substitutions
+            new_element.substitution_map.merge(substitution_map);
+
+            return new_element;
+        };
 
+        if (is_inclusion_to_process_on_cycle) {
+            // BFS, all the noodles are going to be processed after the states that are already in the worklist
+            // (the states incompatible with the lengths of the arithmetic assignment are pushed after the others)
+            std::vector<SolvingState> incompatible_states;
+            for (const auto &noodle : noodles) {
+                add_to_stat(stats.num_solving_states, 1);
+                SolvingState new_element = create_state_from_noodle(element_to_process, noodle);
+                if (is_pruned(new_element)) {
+                    continue;
+                }
+                if (is_length_compatible(new_element)) {
+                    push_to_worklist(std::move(new_element), false);
+                } else {
+                    incompatible_states.push_back(std::move(new_element));
+                }
+            }
+            for (SolvingState& new_element : incompatible_states) {
+                push_to_worklist(std::move(new_element), false);
+            }
+        } else {
+            // DFS, we create the solving states one at a time, only when the previous ones did not lead to a
+            // solution, by pushing the suspended noodlification to the front of the worklist. The noodles
+            // are taken from the back, so the states are processed in the same order as if we pushed them all
+            // to the front. Only the states are deferred, the noodles were all computed by noodlify_for_equation
+            // above (mata has no noodlification producing them one at a time).
+            auto remaining_noodles = std::make_shared<decltype(noodles)>(std::move(noodles));
+            auto base = std::make_shared<const SolvingState>(std::move(element_to_process));
+            SolvingState suspended;
+            suspended.cost = base->cost;
+            suspended.next_noodle_state = [remaining_noodles, base, create_state_from_noodle](SolvingState& new_element) {
+                if (remaining_noodles->empty()) {
+                    return false;
+                }
+                new_element = create_state_from_noodle(*base, remaining_noodles->back());
+                remaining_noodles->pop_back();
+                return true;
+            };
+            push_to_worklist(std::move(suspended), true);
         }
 
-        // there are no solving states left, which means nothing led to solution -> it must be unsatisfiable
-        return l_false;
+        /********************************************************************************************************/
+        /*************************************** End of noodlification ******************************************/
+        /********************************************************************************************************/
+
+        return false;
     }
 
     LenNode DecisionProcedure::get_initial_lengths() {
@@ -586,7 +1690,11 @@ namespace smt::noodler {
 
         // for each initial length variable get the lengths of all its possible words for automaton in init_aut_ass
         for (const BasicTerm &var : init_length_sensitive_vars) {
-            conjuncts.push_back(init_aut_ass.get_lengths(var));
+            if (length_abstraction_cache != nullptr) {
+                conjuncts.push_back(length_abstraction_cache->get_lengths(init_aut_ass, var));
+            } else {
+                conjuncts.push_back(init_aut_ass.get_lengths(var));
+            }
         }
 
         return LenNode(LenFormulaType::AND, conjuncts);
@@ -605,9 +1713,12 @@ namespace smt::noodler {
         // add length formula from preprocessing
         conjuncts.push_back(preprocessing_len_formula);
 
-        // create length constraints from the solution, we only need to look at length sensitive vars
+        // create length constraints from the solution, we only need to look at length sensitive vars,
+        // the lengths of identical automata (e.g., of the variables from noodles) are computed once
+        solution.aut_ass.deduplicate();
+        AutAssignment::WordLengthsMemo word_lengths;
         for (const BasicTerm &len_var : solution.length_sensitive_vars) {
-            conjuncts.push_back(solution.get_lengths(len_var));
+            conjuncts.push_back(solution.get_lengths(len_var, &word_lengths));
         }
 
         // the following functions (getting formula for conversions) assume that we have flattened substitution map
@@ -676,27 +1787,55 @@ namespace smt::noodler {
                 }
             }
 
+            // the code points are encoded by the maximal intervals of consecutive code points, e.g., any letter is
+            // the disjunction of two interval constraints instead of one equation for each letter
+            using Intervals = std::vector<std::pair<mata::Symbol, mata::Symbol>>;
+            Intervals intervals;
+            // extends the last interval of the (sorted) intervals by s if possible
+            auto add_to_intervals = [](Intervals& intervals, mata::Symbol s) {
+                if (!intervals.empty() && intervals.back().second + 1 == s) {
+                    intervals.back().second = s;
+                } else {
+                    intervals.emplace_back(s, s);
+                }
+            };
             if (!is_there_dummy_symbol) {
-                // if there is no dummy symbol, we can just create disjunction that code_version_of(c) is equal to one of the symbols in real_symbols_of_code_var
-                std::vector<LenNode> equal_to_one_of_symbols;
+                // if there is no dummy symbol, code_version_of(c) is equal to one of the symbols in real_symbols_of_code_var
                 for (mata::Symbol s : real_symbols_of_code_var) {
-                    equal_to_one_of_symbols.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{code_version_of(c), s});
+                    add_to_intervals(intervals, s);
                 }
-                char_case.succ.emplace_back(LenFormulaType::OR, equal_to_one_of_symbols);
             } else {
-                // if there is dummy symbol, then code_version_of(c) can be code point of any char, except those in the alphabet but not in real_symbols_of_code_var
-                
-                // code_version_of(c) is valid code_point: (0 <= code_version_of(c) <= max_char)
-                char_case.succ.emplace_back(LenFormulaType::LEQ, std::vector<LenNode>{0, code_version_of(c)});
-                char_case.succ.emplace_back(LenFormulaType::LEQ, std::vector<LenNode>{code_version_of(c), zstring::max_char()});
-
-                // code_version_of(c) is not equal to code point of some symbol in the alphabet that is not in real_symbols_of_code_var
+                // if there is dummy symbol, then code_version_of(c) can be code point of any char, except those in the alphabet
+                // but not in real_symbols_of_code_var, i.e., it is in one of the gaps between the intervals of these excluded symbols
+                Intervals excluded;
                 for (mata::Symbol s : solution.aut_ass.get_alphabet()) {
                     if (!is_dummy_symbol(s) && !real_symbols_of_code_var.contains(s)) {
-                        char_case.succ.emplace_back(LenFormulaType::NEQ, std::vector<LenNode>{code_version_of(c), s});
+                        add_to_intervals(excluded, s);
                     }
                 }
+                mata::Symbol next_allowed = 0;
+                for (const auto& [lo, hi] : excluded) {
+                    if (next_allowed < lo) {
+                        intervals.emplace_back(next_allowed, lo - 1);
+                    }
+                    next_allowed = hi + 1;
+                }
+                if (next_allowed <= zstring::max_char()) {
+                    intervals.emplace_back(next_allowed, zstring::max_char());
+                }
+            }
+            std::vector<LenNode> in_one_of_intervals;
+            for (const auto& [lo, hi] : intervals) {
+                if (lo == hi) {
+                    in_one_of_intervals.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{code_version_of(c), lo});
+                } else {
+                    in_one_of_intervals.emplace_back(LenFormulaType::AND, std::vector<LenNode>{
+                        LenNode(LenFormulaType::LEQ, {lo, code_version_of(c)}),
+                        LenNode(LenFormulaType::LEQ, {code_version_of(c), hi})
+                    });
+                }
             }
+            char_case.succ.emplace_back(LenFormulaType::OR, std::move(in_one_of_intervals));
             
             result.succ.emplace_back(LenFormulaType::OR, std::vector<LenNode>{
                 non_char_case,
@@ -795,13 +1934,169 @@ namespace smt::noodler {
         return result;
     }
 
+    LenNode DecisionProcedure::encode_interval_automaton(const BasicTerm& var, const mata::nfa::Nfa& aut) {
+        assert(aut.initial.size() == 1);
+        const mata::nfa::State initial = *aut.initial.begin();
+
+        // Each state q of aut is reached only after reading some specific number of digits (see AutAssignment::get_interval_words),
+        // so the rest of the word read from q encodes the number value_of(q) with a fixed number of digits rest_of(q).
+        // The transitions from q grouped into intervals then give the formula
+        //      value_of(q) = d*10^(rest_of(q)-1) + value_of(t) && s <= d <= e
+        // for some transition q -[s-e]-> t, where d is an auxiliary variable (the digit read from q). For the initial state,
+        // value_of(initial) is var and for the final state, value_of(final) = 0.
+        std::map<mata::nfa::State, std::vector<std::pair<std::pair<mata::Symbol,mata::Symbol>,mata::nfa::State>>> interval_transitions;
+        std::map<mata::nfa::State, unsigned> depth = { {initial, 0} };
+        std::deque<mata::nfa::State> worklist = { initial };
+        unsigned length = 0;
+        while (!worklist.empty()) {
+            mata::nfa::State st = worklist.front();
+            worklist.pop_front();
+            auto& transitions = interval_transitions[st] = AutAssignment::get_interval_transitions(aut, st);
+            if (transitions.empty()) {
+                length = depth.at(st);
+            }
+            for (const auto& [interval, target] : transitions) {
+                if (depth.try_emplace(target, depth.at(st) + 1).second) {
+                    worklist.push_back(target);
+                }
+            }
+        }
+
+        // the names of auxiliary variables contain the length, as var can have automata for more lengths
+        const zstring prefix = var.get_name() + ("!" + std::to_string(length) + "_").c_str();
+        auto value_of = [&](mata::nfa::State st) {
+            if (st == initial) {
+                return LenNode(var);
+            }
+            if (interval_transitions.at(st).empty()) {
+                return LenNode(0);
+            }
+            return LenNode(BasicTerm(BasicTermType::Variable, prefix + ("value_" + std::to_string(st)).c_str()));
+        };
+
+        LenNode result(LenFormulaType::AND);
+        for (const auto& [st, transitions] : interval_transitions) {
+            if (transitions.empty()) {
+                continue;
+            }
+            rational place_value(1);
+            for (unsigned i = depth.at(st) + 1; i < length; ++i) {
+                place_value *= 10;
+            }
+            const BasicTerm digit(BasicTermType::Variable, prefix + ("digit_" + std::to_string(st)).c_str());
+
+            LenNode state_formula(LenFormulaType::OR);
+            for (const auto& [interval, target] : transitions) {
+                rational interval_start(interval.first - AutAssignment::DIGIT_SYMBOL_START);
+                rational interval_end(interval.second - AutAssignment::DIGIT_SYMBOL_START);
+                if (interval_start == interval_end) {
+                    // value_of(st) = s*10^(...) + value_of(target)
+                    state_formula.succ.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{
+                        value_of(st),
+                        LenNode(LenFormulaType::PLUS, { interval_start*place_value, value_of(target) })
+                    });
+                } else {
+                    // s <= digit <= e && value_of(st) = digit*10^(...) + value_of(target)
+                    state_formula.succ.emplace_back(LenFormulaType::AND, std::vector<LenNode>{
+                        LenNode(LenFormulaType::LEQ, { interval_start, digit }),
+                        LenNode(LenFormulaType::LEQ, { digit, interval_end }),
+                        LenNode(LenFormulaType::EQ, {
+                            value_of(st),
+                            LenNode(LenFormulaType::PLUS, { LenNode(LenFormulaType::TIMES, { digit, place_value }), value_of(target) })
+                        })
+                    });
+                }
+            }
+            if (state_formula.succ.size() == 1) {
+                result.succ.push_back(std::move(state_formula.succ[0]));
+            } else {
+                result.succ.push_back(std::move(state_formula));
+            }
+        }
+        return result;
+    }
+
+    std::optional<std::vector<interval_word>> DecisionProcedure::get_explicit_interval_words(const mata::nfa::Nfa& aut) {
+        const unsigned limit = m_params.m_interval_cases_limit;
+        if (limit == 0) {
+            return AutAssignment::get_interval_words(aut);
+        }
+
+        // the number of interval words is computed first (without enumerating them), counts above limit are not distinguished
+        assert(aut.initial.size() == 1);
+        std::map<mata::nfa::State, size_t> num_of_words = { {*aut.initial.begin(), 1} };
+        std::map<mata::nfa::State, size_t> cur_level = num_of_words;
+        size_t num_of_interval_words = 0;
+        while (!cur_level.empty()) {
+            std::map<mata::nfa::State, size_t> next_level;
+            for (const auto& [st, num] : cur_level) {
+                auto transitions = AutAssignment::get_interval_transitions(aut, st);
+                if (transitions.empty()) {
+                    num_of_interval_words = num;
+                }
+                for (const auto& [interval, target] : transitions) {
+                    next_level[target] = std::min<size_t>(next_level[target] + num, limit + 1);
+                }
+            }
+            cur_level = std::move(next_level);
+        }
+        if (num_of_interval_words > limit) {
+            return std::nullopt;
+        }
+
+        // each interval word is split by encode_interval_words into the cases for all digits preceding its last interval that is not [0-9]
+        std::vector<interval_word> interval_words = AutAssignment::get_interval_words(aut);
+        size_t num_of_cases = 0;
+        for (const interval_word& word : interval_words) {
+            size_t cases = 1;
+            auto interval_it = word.crbegin();
+            while (interval_it != word.crend() && interval_it->first == AutAssignment::DIGIT_SYMBOL_START && interval_it->second == AutAssignment::DIGIT_SYMBOL_END) {
+                ++interval_it;
+            }
+            if (interval_it != word.crend()) {
+                ++interval_it;
+            }
+            for (; interval_it != word.crend() && cases <= limit; ++interval_it) {
+                cases *= interval_it->second - interval_it->first + 1;
+            }
+            num_of_cases += cases;
+            if (num_of_cases > limit) {
+                return std::nullopt;
+            }
+        }
+        return interval_words;
+    }
+
+    DigitDecomposition& DecisionProcedure::get_digit_decomposition(const std::shared_ptr<mata::nfa::Nfa>& aut, const mata::nfa::Nfa& contain_non_digit) {
+        auto [it, inserted] = digit_decompositions.try_emplace(aut.get());
+        if (inserted) {
+            DigitDecomposition& decomposition = it->second;
+            decomposition.aut = aut;
+            decomposition.valid_part = mata::nfa::reduce(intersect(*aut, AutAssignment::digit_automaton_with_epsilon()));
+            decomposition.non_valid_part = mata::nfa::reduce(intersect(*aut, contain_non_digit));
+        }
+        return it->second;
+    }
+
+    const DigitDecomposition::OfLength& DecisionProcedure::get_digit_words_of_length(DigitDecomposition& decomposition, unsigned length) {
+        auto [it, inserted] = decomposition.of_length.try_emplace(length);
+        if (inserted) {
+            DigitDecomposition::OfLength& words = it->second;
+            words.aut = mata::nfa::minimize(intersect(decomposition.valid_part, AutAssignment::digit_automaton_of_length(length)));
+            if (!words.aut.is_lang_empty()) {
+                words.interval_words = get_explicit_interval_words(words.aut);
+            }
+        }
+        return it->second;
+    }
+
     std::pair<LenNode, LenNodePrecision> DecisionProcedure::get_formula_for_int_subst_vars(const std::set<BasicTerm>& int_subst_vars, const std::set<BasicTerm>& code_subst_vars, std::map<BasicTerm,std::vector<unsigned>>& int_subst_vars_to_possible_valid_lengths) {
         LenNode result(LenFormulaType::AND);
         LenNodePrecision res_precision = LenNodePrecision::PRECISE;
 
         // automaton representing all valid inputs (only digits)
         // - we also keep empty word, because we will use it for substituted vars, and one of them can be empty, while other has only digits (for example s1="45", s2="" but s=s1s2 = "45" is valid)
-        mata::nfa::Nfa only_digits = AutAssignment::digit_automaton_with_epsilon();
+        const mata::nfa::Nfa& only_digits = AutAssignment::digit_automaton_with_epsilon();
         STRACE("str-conversion-int", tout << "only-digit NFA:" << std::endl << only_digits << std::endl;);
         // automaton representing all non-valid inputs (contain non-digit)
         mata::nfa::Nfa contain_non_digit = solution.aut_ass.complement_aut(only_digits);
@@ -817,11 +2112,11 @@ namespace smt::noodler {
             std::shared_ptr<mata::nfa::Nfa> aut = solution.aut_ass.at(int_subst_var);
             STRACE("str-conversion-int", tout << "NFA for " << int_subst_var << ":" << std::endl << *aut << std::endl;);
 
-            // part containing only digits
-            mata::nfa::Nfa aut_valid_part = mata::nfa::reduce(mata::nfa::intersection(*aut, only_digits).trim());
+            // parts containing only digits and containing some non-digit (memoized, as the same automata occur in more solutions)
+            DigitDecomposition& decomposition = get_digit_decomposition(aut, contain_non_digit);
+            const mata::nfa::Nfa& aut_valid_part = decomposition.valid_part;
             STRACE("str-conversion-int", tout << "only-digit NFA:" << std::endl << aut_valid_part << std::endl;);
-            // part containing some non-digit
-            mata::nfa::Nfa aut_non_valid_part = mata::nfa::reduce(mata::nfa::intersection(*aut, contain_non_digit).trim());
+            const mata::nfa::Nfa& aut_non_valid_part = decomposition.non_valid_part;
             STRACE("str-conversion-int", tout << "contains-non-digit NFA:" << std::endl << aut_non_valid_part << std::endl;);
 
             // First handle the case of all words (except empty word) from solution.aut_ass.at(int_subst_var) that do not represent numbers
@@ -877,16 +2172,16 @@ namespace smt::noodler {
             } else {
                 // there is infinite number of such words => we need to underapproximate
                 STRACE("str-conversion", tout << "infinite NFA for which we need to do underapproximation:" << std::endl << aut_valid_part << std::endl;);
-                max_length_of_words = m_params.m_underapprox_length;
+                max_length_of_words = underapprox_length;
                 res_precision = LenNodePrecision::UNDERAPPROX;
             }
 
             // for lengths l=1 to max_length_of_words
             for (unsigned l = 1; l <= max_length_of_words; ++l) {
                 // get automaton representing all accepted words containing only digits of length l
-                mata::nfa::Nfa aut_valid_of_length = mata::nfa::minimize(mata::nfa::intersection(aut_valid_part, AutAssignment::digit_automaton_of_length(l)).trim());
+                const DigitDecomposition::OfLength& valid_of_length = get_digit_words_of_length(decomposition, l);
 
-                if (aut_valid_of_length.is_lang_empty()) {
+                if (valid_of_length.aut.is_lang_empty()) {
                     // there are no such words
                     continue;
                 }
@@ -897,7 +2192,7 @@ namespace smt::noodler {
                 // |int_subst_var| = l && encode that int_version_of(int_subst_var) is a numeral represented by some interval word accepted by aut_valid_of_length
                 formula_for_int_subst_var.succ.emplace_back(LenFormulaType::AND, std::vector<LenNode>{
                     LenNode(LenFormulaType::EQ, { int_subst_var, l }),
-                    encode_interval_words(int_version_of(int_subst_var), AutAssignment::get_interval_words(aut_valid_of_length))
+                    encode_digit_automaton(int_version_of(int_subst_var), valid_of_length)
                 });
                 
                 if (code_subst_vars.contains(int_subst_var) && l == 1) {
@@ -1157,6 +2452,64 @@ namespace smt::noodler {
         return {result, res_precision};
     }
 
+    /**
+     * @brief Get the order of inclusions of @p state given by m_params.m_inclusion_order.
+     */
+    Graph::PredicateOrder DecisionProcedure::get_inclusion_order(const SolvingState& state) const {
+        if (m_params.m_inclusion_order == IO_GRAPH) {
+            return {};
+        }
+
+        auto num_of_states = [&state](const BasicTerm& term) -> double {
+            return state.aut_ass.count(term) > 0 ? state.aut_ass.at(term)->num_of_states() : 1.0;
+        };
+        // lower score -> processed first
+        auto score = [this, &state, num_of_states](const Predicate& inclusion) -> double {
+            switch (m_params.m_inclusion_order) {
+                case IO_SMALLEST_AUT: {
+                    double sum = 0;
+                    for (const auto& side : inclusion.get_params()) {
+                        for (const BasicTerm& term : side) {
+                            sum += num_of_states(term);
+                        }
+                    }
+                    return sum;
+                }
+                case IO_LENGTH_VARS: {
+                    double len_vars = 0;
+                    for (const BasicTerm& var : inclusion.get_vars()) {
+                        len_vars += state.length_sensitive_vars.count(var);
+                    }
+                    return -len_vars;
+                }
+                case IO_FEWEST_NOODLES: {
+                    // each left term is split between the (concatenation of) right automata, so we estimate the number of noodles
+                    // by the number of states of the right side raised to the number of left terms that can be split
+                    double right_states = 0;
+                    for (const BasicTerm& term : inclusion.get_right_side()) {
+                        right_states += num_of_states(term);
+                    }
+                    return std::pow(right_states, std::max<double>(inclusion.get_left_side().size(), 1) - 1);
+                }
+                default:
+                    return 0;
+            }
+        };
+
+        // scores are computed only once for each inclusion (the order is copied, so the cache is shared)
+        auto scores = std::make_shared<std::unordered_map<Predicate, double, Predicate::HashFunction>>();
+        return [scores, score](const Predicate& lhs, const Predicate& rhs) {
+            auto get_score = [&scores, &score](const Predicate& inclusion) {
+                auto it = scores->find(inclusion);
+                if (it == scores->end()) {
+                    it = scores->emplace(inclusion, score(inclusion)).first;
+                }
+                return it->second;
+            };
+            return get_score(lhs) < get_score(rhs);
+        };
+    }
+
     /**
      * @brief Creates initial inclusion graph according to the preprocessed instance.
      */
@@ -1192,39 +2545,158 @@ namespace smt::noodler {
         if (!equations.get_predicates().empty()) {
             // TODO we probably want to completely get rid of inclusion graphs
             std::deque<std::shared_ptr<GraphNode>> tmp;
-            Graph incl_graph = Graph::create_inclusion_graph(equations, tmp);
+            Graph incl_graph = Graph::create_inclusion_graph(equations, tmp, get_inclusion_order(init_solving_state));
             for (auto const &node : incl_graph.get_nodes()) {
-                init_solving_state.inclusions.insert(node->get_predicate());
-                if (!incl_graph.is_on_cycle(node)) {
-                    init_solving_state.inclusions_not_on_cycle.insert(node->get_predicate());
-                }
+                init_solving_state.add_inclusion(node->get_predicate(), incl_graph.is_on_cycle(node));
             }
-            // TODO the ordering of inclusions_to_process right now is given by how they were added from the splitting graph, should we use something different? also it is not deterministic now, depends on hashes
+            // the ordering of inclusions_to_process is given by how they were added from the splitting graph (which is
+            // deterministic), the choice between inclusions that can be added at the same time is given by get_inclusion_order()
             while (!tmp.empty()) {
-                init_solving_state.inclusions_to_process.push_back(tmp.front()->get_predicate());
+                init_solving_state.push_back_unique(tmp.front()->get_predicate());
                 tmp.pop_front();
             }
         }
 
-        worklist.push_back(init_solving_state);
+        // each case of the split not_contains predicates is a separate initial state
+        for (SolvingState& state : split_not_contains(init_solving_state)) {
+            if (m_params.m_shortest_witnesses && state.length_sensitive_vars.empty() && conversions.empty()
+                    && disequations_len_formula_conjuncts.empty()
+                    && state.inclusions_not_on_cycle->size() == state.inclusions->size()) {
+                // the state with words is an underapproximation, if it has no solution, the initial state is explored after it
+                std::optional<SolvingState> witness_state = get_shortest_witness_state(state);
+                if (witness_state.has_value()) {
+                    worklist.push_back(std::move(*witness_state));
+                }
+            }
+
+            worklist.push_back(std::move(state));
+        }
     }
 
-    lbool DecisionProcedure::preprocess(PreprocessType opt, const BasicTermEqiv &len_eq_vars) {
-        FormulaPreprocessor prep_handler{std::move(this->formula), std::move(this->init_aut_ass), std::move(this->init_length_sensitive_vars), m_params};
+    std::optional<SolvingState> DecisionProcedure::get_shortest_witness_state(const SolvingState& state) {
+        using Word = std::vector<mata::Symbol>;
+        std::unordered_map<BasicTerm, Word> words;
+        std::deque<Predicate> unsatisfied;
+        for (const Predicate& inclusion : *state.inclusions_to_process) {
+            // words chosen for the terms of this inclusion, they are kept only if the inclusion is satisfied
+            std::unordered_map<BasicTerm, Word> chosen;
+            auto has_word = [&](const BasicTerm& term) {
+                return words.count(term) > 0 || chosen.count(term) > 0;
+            };
+            auto word_of = [&](const BasicTerm& term) -> const Word* {
+                auto it = words.find(term);
+                if (it != words.end()) {
+                    return &it->second;
+                }
+                it = chosen.find(term);
+                if (it != chosen.end()) {
+                    return &it->second;
+                }
+                std::optional<Word> word = AutAssignment::get_word(*state.aut_ass.at(term));
+                if (!word.has_value()) {
+                    return nullptr;
+                }
+                return &chosen.emplace(term, std::move(*word)).first->second;
+            };
+
+            bool satisfied = true;
+            Word right_word;
+            for (const BasicTerm& term : inclusion.get_right_side()) {
+                const Word* word = word_of(term);
+                if (word == nullptr) {
+                    satisfied = false;
+                    break;
+                }
+                right_word.insert(right_word.end(), word->begin(), word->end());
+            }
+
+            const std::vector<BasicTerm>& left_side = inclusion.get_left_side();
+            std::optional<size_t> rest_idx;
+            for (size_t i = left_side.size(); i-- > 0;) {
+                if (left_side[i].is_variable() && !has_word(left_side[i])) {
+                    if (std::count(left_side.begin(), left_side.end(), left_side[i]) == 1) {
+                        rest_idx = i;
+                    }
+                    break;
+                }
+            }
+            // the word of the left side without the rest term, which would be at rest_pos
+            Word left_word;
+            size_t rest_pos = 0;
+            for (size_t i = 0; satisfied && i < left_side.size(); ++i) {
+                if (rest_idx == i) {
+                    rest_pos = left_word.size();
+                    continue;
+                }
+                const Word* word = word_of(left_side[i]);
+                if (word == nullptr) {
+                    satisfied = false;
+                    break;
+                }
+                left_word.insert(left_word.end(), word->begin(), word->end());
+            }
+            if (satisfied && rest_idx.has_value()) {
+                const size_t suffix_len = left_word.size() - rest_pos;
+                satisfied = left_word.size() <= right_word.size()
+                            && std::equal(left_word.begin(), left_word.begin() + rest_pos, right_word.begin())
+                            && std::equal(left_word.begin() + rest_pos, left_word.end(), right_word.end() - suffix_len);
+                if (satisfied) {
+                    Word rest(right_word.begin() + rest_pos, right_word.end() - suffix_len);
+                    satisfied = state.aut_ass.at(left_side[*rest_idx])->is_in_lang(mata::nfa::Run{ rest, {} });
+                    chosen.emplace(left_side[*rest_idx], std::move(rest));
+                }
+            } else if (satisfied) {
+                satisfied = (left_word == right_word);
+            }
+
+            STRACE("str", tout << "Inclusion " << inclusion << (satisfied ? " is" : " is not") << " satisfied by shortest words" << std::endl;);
+            if (satisfied) {
+                words.merge(chosen);
+            } else {
+                unsatisfied.push_back(inclusion);
+            }
+        }
 
+        const size_t num_satisfied = state.inclusions_to_process->size() - unsatisfied.size();
+        if (num_satisfied == 0) {
+            return std::nullopt;
+        }
+        add_to_stat(stats.num_witness_inclusions, num_satisfied);
+
+        SolvingState witness_state = state;
+        for (const auto& [term, word] : words) {
+            if (!term.is_variable()) {
+                continue;
+            }
+            mata::nfa::Nfa word_nfa{ word.size() + 1, { 0 }, { word.size() } };
+            for (size_t i = 0; i < word.size(); ++i) {
+                word_nfa.delta.add(i, word[i], i + 1);
+            }
+            witness_state.aut_ass[term] = std::make_shared<mata::nfa::Nfa>(std::move(word_nfa));
+        }
+        witness_state.clear_inclusions();
+        for (const Predicate& inclusion : unsatisfied) {
+            witness_state.add_inclusion(inclusion, false);
+            witness_state.push_back_unique(inclusion);
+        }
+        return witness_state;
+    }
+
+    void DecisionProcedure::run_preprocess_passes(FormulaPreprocessor& prep_handler, PreprocessType opt, const BasicTermEqiv &len_eq_vars) {
         // we collect variables used in conversions, some preprocessing rules cannot be applied for them
         std::unordered_set<BasicTerm> conv_vars;
         for (const auto &conv : conversions) {
             conv_vars.insert(conv.string_var);
         }
 
-        // So-far just lightweight preprocessing
-        prep_handler.remove_trivial();
-        prep_handler.reduce_diseqalities();
+        // So-far just lightweight preprocessing; passes that cannot change anything (their last run did not change
+        // anything and the parts of the instance they read did not change since then) are skipped by the scheduler
+        // remove_trivial and reduce_diseqalities were already run by PreprocessMemo::get_shared()
+        PreprocessScheduler sched(prep_handler, preprocess_profile);
         if (opt == PreprocessType::UNDERAPPROX) {
-            prep_handler.underapprox_languages();
+            sched.run("underapprox_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.underapprox_languages(); });
         }
-        prep_handler.propagate_eps();
+        sched.run("propagate_eps", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_eps(); });
         // Refinement of languages is beneficial only for instances containing not(contains) or disequalities (it is used to reduce the number of 
         // disequations/not(contains). For a strong reduction you need to have languages as precise as possible). In the case of 
         // pure equalitities it could create bigger automata, which may be problem later during the noodlification.
@@ -1232,25 +2704,25 @@ namespace smt::noodler {
             // Refine languages is applied in the order given by the predicates. Single iteration 
             // might not update crucial variables that could contradict the formula. 
             // Two iterations seem to be a good trade-off since the automata could explode in the fixpoint.
-            prep_handler.refine_languages();
-            prep_handler.refine_languages();
+            sched.run("refine_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.refine_languages(); });
+            sched.run("refine_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.refine_languages(); });
         }
-        prep_handler.propagate_variables();
-        prep_handler.propagate_eps();
-        prep_handler.infer_alignment();
-        prep_handler.remove_regular(conv_vars);
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
+        sched.run("propagate_eps", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_eps(); });
+        sched.run("infer_alignment", PREP_ALL, [&](FormulaPreprocessor& p) { p.infer_alignment(); });
+        sched.run("remove_regular", PREP_ALL, [&](FormulaPreprocessor& p) { p.remove_regular(conv_vars); });
         // Skip_len_sat is not compatible with not(contains) and conversions as the preprocessing may skip equations with variables 
         // inside not(contains)/conversion. (Note that if opt == PreprocessType::UNDERAPPROX, there is no not(contains)).
         if(this->not_contains.get_predicates().empty() && this->conversions.empty()) {
-            prep_handler.skip_len_sat();
+            sched.run("skip_len_sat", PREP_ALL, [&](FormulaPreprocessor& p) { p.skip_len_sat(); });
         }
-        prep_handler.generate_identities();
-        prep_handler.propagate_variables();
-        prep_handler.refine_languages();
-        prep_handler.reduce_diseqalities();
-        prep_handler.remove_trivial();
-        prep_handler.reduce_regular_sequence(3);
-        prep_handler.remove_regular(conv_vars);
+        sched.run("generate_identities", PREP_ALL, [&](FormulaPreprocessor& p) { p.generate_identities(); });
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
+        sched.run("refine_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.refine_languages(); });
+        sched.run("reduce_diseqalities", PREP_ALL, [&](FormulaPreprocessor& p) { p.reduce_diseqalities(); });
+        sched.run("remove_trivial", PREP_FORMULA, [&](FormulaPreprocessor& p) { p.remove_trivial(); });
+        sched.run("reduce_regular_sequence(3)", PREP_ALL, [&](FormulaPreprocessor& p) { p.reduce_regular_sequence(3); });
+        sched.run("remove_regular", PREP_ALL, [&](FormulaPreprocessor& p) { p.remove_regular(conv_vars); });
 
         // the following should help with Leetcode
         /// TODO: should be simplyfied? So many preprocessing steps now
@@ -1263,23 +2735,49 @@ namespace smt::noodler {
                 tout << std::endl;
             }   
         );
-        prep_handler.generate_equiv(len_eq_vars);
-        prep_handler.common_prefix_propagation();
-        prep_handler.common_suffix_propagation();
-        prep_handler.propagate_variables();
-        prep_handler.generate_identities();
-        prep_handler.remove_regular(conv_vars);
-        prep_handler.propagate_variables();
+        sched.run("generate_equiv", PREP_ALL, [&](FormulaPreprocessor& p) { p.generate_equiv(len_eq_vars); });
+        sched.run("common_prefix_propagation", PREP_ALL, [&](FormulaPreprocessor& p) { p.common_prefix_propagation(); });
+        sched.run("common_suffix_propagation", PREP_ALL, [&](FormulaPreprocessor& p) { p.common_suffix_propagation(); });
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
+        sched.run("generate_identities", PREP_ALL, [&](FormulaPreprocessor& p) { p.generate_identities(); });
+        sched.run("remove_regular", PREP_ALL, [&](FormulaPreprocessor& p) { p.remove_regular(conv_vars); });
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
         // underapproximation
         if(opt == PreprocessType::UNDERAPPROX) {
-            prep_handler.underapprox_languages();
-            prep_handler.skip_len_sat();
-            prep_handler.reduce_regular_sequence(3);
-            prep_handler.remove_regular(conv_vars);
-            prep_handler.skip_len_sat();
+            sched.run("underapprox_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.underapprox_languages(); });
+            sched.run("skip_len_sat", PREP_ALL, [&](FormulaPreprocessor& p) { p.skip_len_sat(); });
+            sched.run("reduce_regular_sequence(3)", PREP_ALL, [&](FormulaPreprocessor& p) { p.reduce_regular_sequence(3); });
+            sched.run("remove_regular", PREP_ALL, [&](FormulaPreprocessor& p) { p.remove_regular(conv_vars); });
+            sched.run("skip_len_sat", PREP_ALL, [&](FormulaPreprocessor& p) { p.skip_len_sat(); });
+        }
+        sched.run("reduce_regular_sequence(1)", PREP_ALL, [&](FormulaPreprocessor& p) { p.reduce_regular_sequence(1); });
+        sched.run("remove_regular", PREP_ALL, [&](FormulaPreprocessor& p) { p.remove_regular(conv_vars); });
+
+        add_to_stat(stats.num_preprocess_passes_skipped, sched.get_num_skipped());
+        add_to_stat(stats.num_preprocess_ops_gated, prep_handler.get_num_gated_ops());
+    }
+
+    lbool DecisionProcedure::preprocess(PreprocessType opt, const BasicTermEqiv &len_eq_vars) {
+        // if the same instance was already preprocessed in this session, we start from the memoized preprocessor
+        std::optional<PreprocessMemo::Key> memo_key;
+        std::shared_ptr<const FormulaPreprocessor> memoized;
+        if (preprocess_memo != nullptr) {
+            memo_key.emplace(opt, this->formula, this->not_contains, this->init_aut_ass, this->init_length_sensitive_vars, len_eq_vars, this->conversions);
+            memoized = preprocess_memo->find(*memo_key);
+        }
+        FormulaPreprocessor prep_handler = memoized != nullptr ? FormulaPreprocessor(*memoized)
+            : PreprocessMemo::get_shared(preprocess_memo, std::move(this->formula), std::move(this->init_aut_ass),
+                                         std::move(this->init_length_sensitive_vars), m_params, preprocess_profile, literal_store);
+        prep_handler.set_literal_store(literal_store);
+        if (memoized != nullptr) {
+            STRACE("str-prep", tout << "Using memoized preprocessing" << std::endl;);
+            add_to_stat(stats.num_preprocess_memo_hits, 1);
+        } else {
+            run_preprocess_passes(prep_handler, opt, len_eq_vars);
+            if (memo_key.has_value()) {
+                preprocess_memo->insert(std::move(*memo_key), std::make_shared<const FormulaPreprocessor>(prep_handler));
+            }
         }
-        prep_handler.reduce_regular_sequence(1);
-        prep_handler.remove_regular(conv_vars);
 
         prep_handler.conversions_validity(conversions);
 
@@ -1325,7 +2823,7 @@ namespace smt::noodler {
         if (!this->init_aut_ass.is_sat()) {
             // some automaton in the assignment is empty => we won't find solution
             return l_false;
-        } else if (this->formula.get_predicates().empty()) {
+        } else if (this->formula.get_predicates().empty() && this->not_contains_splits.empty()) {
             // preprocessing solved all (dis)equations => we set the solution (for lengths check)
             this->solution = SolvingState(this->init_aut_ass, {}, {}, {}, this->init_length_sensitive_vars, {});
             return l_true;
@@ -1464,12 +2962,59 @@ namespace smt::noodler {
             if(right.size() == 1 && this->init_aut_ass.is_epsilon(right[0])) {
                 return l_false;
             }
+            if(left.size() == 1 && right.size() == 1 && left[0].is_variable() && right[0].is_variable() && left[0] != right[0]) {
+                // the needle (right) has finitely many words => case split on its word, each case is regular
+                std::optional<std::set<std::vector<mata::Symbol>>> words = AutAssignment::get_finite_words(*this->init_aut_ass.at(right[0]), NOT_CONTAINS_MAX_WORDS);
+                size_t branches = words.has_value() ? words->size() : 0;
+                for (const NotContainsSplit& split : this->not_contains_splits) {
+                    branches *= split.words.size();
+                }
+                if(words.has_value() && branches <= NOT_CONTAINS_MAX_BRANCHES) {
+                    // each word contains the empty word, so only the non-empty words of the needle are cases
+                    words->erase(std::vector<mata::Symbol>{});
+                    if(words->empty()) {
+                        return l_false;
+                    }
+                    STRACE("str", tout << "not_contains " << pred << " is split into " << words->size() << " cases" << std::endl;);
+                    this->not_contains_splits.push_back(NotContainsSplit{ right[0], left[0], { words->begin(), words->end() } });
+                    continue;
+                }
+            }
             remain_not_contains.add_predicate(pred);
         }
         this->not_contains = remain_not_contains;
         return l_undef;
     }
 
+    std::vector<SolvingState> DecisionProcedure::split_not_contains(const SolvingState& state) const {
+        std::vector<SolvingState> states{ state };
+        for (const NotContainsSplit& split : this->not_contains_splits) {
+            std::vector<SolvingState> next_states;
+            for (SolvingState& current : states) {
+                // the symbols read by the haystack are added, so that the restriction does not remove its symbols
+                std::set<mata::Symbol> alphabet = current.aut_ass.get_alphabet();
+                for (mata::Symbol symbol : mata::nfa::create_alphabet(*current.aut_ass.at(split.haystack)).get_alphabet_symbols()) {
+                    alphabet.insert(symbol);
+                }
+                for (const std::vector<mata::Symbol>& word : split.words) {
+                    SolvingState next = current;
+                    mata::nfa::Nfa word_nfa(word.size() + 1, { 0 }, { word.size() });
+                    for (size_t i = 0; i < word.size(); ++i) {
+                        word_nfa.delta.add(i, word[i], i + 1);
+                    }
+                    next.aut_ass.restrict_lang(split.needle, word_nfa);
+                    next.aut_ass.restrict_lang(split.haystack, AutAssignment::not_containing_word_nfa(word, alphabet));
+                    if (next.aut_ass.at(split.needle)->is_lang_empty() || next.aut_ass.at(split.haystack)->is_lang_empty()) {
+                        continue;
+                    }
+                    next_states.push_back(std::move(next));
+                }
+            }
+            states = std::move(next_states);
+        }
+        return states;
+    }
+
     /**
      * @brief Check if it is possible to syntactically unify not contains terms. If they are included (in the sense of vectors) the 
      * not(contain) is unsatisfiable.
@@ -4,7 +4,12 @@
 #include <memory>
 #include <deque>
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
 
+#include "util/stopwatch.h"
 #include "smt/params/theory_str_noodler_params.h"
 #include "formula.h"
 #include "inclusion_graph.h"
@@ -98,7 +103,52 @@ namespace smt::noodler {
             throw std::runtime_error("Unimplemented");
         }
 
+        /**
+         * @brief Set the flag by which the computation can be cancelled from another thread. When it is set,
+         * compute_next_solution() stops and returns l_undef.
+         */
+        void set_cancel_flag(const std::atomic<bool>* flag) { cancel_flag = flag; }
+
         virtual ~AbstractDecisionProcedure()=default;
+
+    protected:
+        const std::atomic<bool>* cancel_flag = nullptr;
+
+        bool is_cancelled() const { return cancel_flag != nullptr && cancel_flag->load(); }
+    };
+
+    /**
+     * @brief Copy-on-write holder of a value of type @p T.
+     *
+     * Copies of the holder share the value, it is copied only when it is going to be modified
+     * (by write()) while some other holder still points to it.
+     */
+    template<typename T>
+    class CopyOnWrite {
+    private:
+        std::shared_ptr<T> ptr;
+
+    public:
+        CopyOnWrite() : ptr(std::make_shared<T>()) { }
+        CopyOnWrite(T val) : ptr(std::make_shared<T>(std::move(val))) { }
+
+        const T& operator*() const { return *ptr; }
+        const T* operator->() const { return ptr.get(); }
+
+        /**
+         * @brief Number of holders sharing the value.
+         */
+        long use_count() const { return ptr.use_count(); }
+
+        /**
+         * @brief Get the value for modification, copying it if it is shared.
+         */
+        T& write() {
+            if (ptr.use_count() > 1) {
+                ptr = std::make_shared<T>(*ptr);
+            }
+            return *ptr;
+        }
     };
 
     /// A state of decision procedure that can lead to a solution
@@ -110,18 +160,35 @@ namespace smt::noodler {
         AutAssignment aut_ass;
         std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map;
 
+        // The following containers are shared between a state and its copies (which are created
+        // for each noodle) until one of them modifies them. Use write() for modification.
+
         // set of inclusions where we are trying to find aut_ass + substitution_map such that they hold 
-        std::set<Predicate> inclusions;
+        CopyOnWrite<std::set<Predicate>> inclusions;
         // set of inclusion from the previous set that for sure are not on cycle in the inclusion graph
         // that would be generated from inclusions
-        std::set<Predicate> inclusions_not_on_cycle;
+        CopyOnWrite<std::set<Predicate>> inclusions_not_on_cycle;
 
         // contains inclusions where we need to check if it holds (and if not, do something so that the inclusion holds)
-        std::deque<Predicate> inclusions_to_process;
+        CopyOnWrite<std::deque<Predicate>> inclusions_to_process;
+        // the inclusions of inclusions_to_process, for the uniqueness checks of push_unique()
+        CopyOnWrite<std::unordered_set<Predicate>> inclusions_to_process_set;
+        // right_side_occurrences[x] are the inclusions from inclusions whose right side contains variable x
+        CopyOnWrite<std::unordered_map<BasicTerm, std::set<Predicate>>> right_side_occurrences;
 
         // the variables that have length constraint on them in the rest of formula
         std::unordered_set<BasicTerm> length_sensitive_vars;
 
+        // if set, this is not a real solving state but a suspended noodlification, calling it creates the solving
+        // state for the next noodle in its argument and returns false if there are no noodles left
+        std::function<bool(SolvingState&)> next_noodle_state;
+
+        // approximate number of bytes owned by the state, set when it is pushed to the worklist (only if the
+        // memory of the worklist is limited, see estimate_state_bytes())
+        size_t approx_bytes = 0;
+        // cost of the state in the best-first exploration (see DecisionProcedure::get_state_cost()), set when it
+        // is pushed to the worklist, a suspended noodlification has the cost of the state it was created from
+        double cost = 0;
 
         SolvingState() = default;
         SolvingState(AutAssignment aut_ass,
@@ -132,25 +199,37 @@ namespace smt::noodler {
                      std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution_map)
                         : aut_ass(aut_ass),
                           substitution_map(substitution_map),
-                          inclusions(inclusions),
-                          inclusions_not_on_cycle(inclusions_not_on_cycle),
-                          inclusions_to_process(inclusions_to_process),
-                          length_sensitive_vars(length_sensitive_vars) {}
+                          inclusions(std::move(inclusions)),
+                          inclusions_not_on_cycle(std::move(inclusions_not_on_cycle)),
+                          inclusions_to_process(std::move(inclusions_to_process)),
+                          length_sensitive_vars(length_sensitive_vars) {
+            reindex();
+        }
 
         /// pushes inclusion to the beginning of inclusions_to_process but only if it is not in it yet
         void push_front_unique(const Predicate &inclusion) {
-            if (std::find(inclusions_to_process.begin(), inclusions_to_process.end(), inclusion) == inclusions_to_process.end()) {
-                inclusions_to_process.push_front(inclusion);
+            if (inclusions_to_process_set->count(inclusion) == 0) {
+                inclusions_to_process_set.write().insert(inclusion);
+                inclusions_to_process.write().push_front(inclusion);
             }
         }
 
         /// pushes node to the end of nodes_to_process but only if it is not in it yet
         void push_back_unique(const Predicate &inclusion) {
-            if (std::find(inclusions_to_process.begin(), inclusions_to_process.end(), inclusion) == inclusions_to_process.end()) {
-                inclusions_to_process.push_back(inclusion);
+            if (inclusions_to_process_set->count(inclusion) == 0) {
+                inclusions_to_process_set.write().insert(inclusion);
+                inclusions_to_process.write().push_back(inclusion);
             }
         }
 
+        /// removes and returns the inclusion at the beginning of inclusions_to_process (which cannot be empty)
+        Predicate pop_front_inclusion_to_process() {
+            Predicate inclusion = inclusions_to_process->front();
+            inclusions_to_process.write().pop_front();
+            inclusions_to_process_set.write().erase(inclusion);
+            return inclusion;
+        }
+
         /// pushes node either to the end or beginning of inclusions_to_process (according to @p to_back) but only if it is not in it yet
         void push_unique(const Predicate &inclusion, bool to_back) {
             if (to_back) {
@@ -165,7 +244,7 @@ namespace smt::noodler {
          * and say that inclusion is on cycle even if it is not).
          */
         bool is_inclusion_on_cycle(const Predicate &inclusion) {
-            return (inclusions_not_on_cycle.count(inclusion) == 0);
+            return (inclusions_not_on_cycle->count(inclusion) == 0);
         }
 
         /**
@@ -176,9 +255,15 @@ namespace smt::noodler {
          * @param is_on_cycle Whether the inclusion would be on cycle in the inclusion graph (if not sure, set to true)
          */
         void add_inclusion(const Predicate &inclusion, bool is_on_cycle = true) {
-            inclusions.insert(inclusion);
+            if (inclusions.write().insert(inclusion).second) {
+                for (const BasicTerm& var : inclusion.get_right_set()) {
+                    if (var.is_variable()) {
+                        right_side_occurrences.write()[var].insert(inclusion);
+                    }
+                }
+            }
             if (!is_on_cycle) {
-                inclusions_not_on_cycle.insert(inclusion);
+                inclusions_not_on_cycle.write().insert(inclusion);
             }
         }
 
@@ -198,26 +283,51 @@ namespace smt::noodler {
         }
 
         void remove_inclusion(const Predicate &inclusion) {
-            inclusions.erase(inclusion);
-            inclusions_not_on_cycle.erase(inclusion);
+            if (inclusions->count(inclusion) > 0) {
+                inclusions.write().erase(inclusion);
+                for (const BasicTerm& var : inclusion.get_right_set()) {
+                    if (right_side_occurrences->count(var) > 0) {
+                        auto& occurrences = right_side_occurrences.write();
+                        auto it = occurrences.find(var);
+                        it->second.erase(inclusion);
+                        if (it->second.empty()) {
+                            occurrences.erase(it);
+                        }
+                    }
+                }
+            }
+            if (inclusions_not_on_cycle->count(inclusion) > 0) {
+                inclusions_not_on_cycle.write().erase(inclusion);
+            }
+        }
+
+        /**
+         * Removes all inclusions from this solving state (including inclusions_to_process).
+         */
+        void clear_inclusions() {
+            inclusions = std::set<Predicate>();
+            inclusions_not_on_cycle = std::set<Predicate>();
+            inclusions_to_process = std::deque<Predicate>();
+            reindex();
         }
 
         /**
          * Returns the vector of inclusions that would depend on the given @p inclusion in the inclusion graph.
          * That this all inclusions whose right side contain some variable from the left side of the given @p inclusion.
+         * The inclusions are looked up in right_side_occurrences, they are ordered as in inclusions.
          * 
          * @param inclusion Inclusion whose dependencies we are looking for
          * @return The set of inclusions that depend on @p inclusion
          */
-        std::vector<Predicate> get_dependent_inclusions(const Predicate &inclusion) {
-            std::vector<Predicate> dependent_inclusions;
-            auto left_vars_set = inclusion.get_left_set();
-            for (const Predicate &other_inclusion : inclusions) {
-                if (is_dependent(left_vars_set, other_inclusion.get_right_set())) {
-                    dependent_inclusions.push_back(other_inclusion);
+        std::vector<Predicate> get_dependent_inclusions(const Predicate &inclusion) const {
+            std::set<Predicate> dependent_inclusions;
+            for (const BasicTerm& var : inclusion.get_left_set()) {
+                auto it = right_side_occurrences->find(var);
+                if (it != right_side_occurrences->end()) {
+                    dependent_inclusions.insert(it->second.begin(), it->second.end());
                 }
             }
-            return dependent_inclusions;
+            return std::vector<Predicate>(dependent_inclusions.begin(), dependent_inclusions.end());
         }
 
         /**
@@ -239,15 +349,19 @@ namespace smt::noodler {
         // substitutes vars and merge same nodes + delete copies of the merged nodes from the inclusions_to_process (and also nodes that have same sides are deleted)
         void substitute_vars(std::unordered_map<BasicTerm, std::vector<BasicTerm>> &substitution_map);
 
+        // rebuilds inclusions_to_process_set and right_side_occurrences from inclusions_to_process and inclusions
+        void reindex();
+
         /**
          * @brief Get the length constraints for variable @p var
          * 
          * If @p var is substituted by x1x2x3... then it creates
          * |var| = |x1| + |x2| + |x3| + ... otherwise, if @p var
          * has an automaton assigned, it creates length constraint
-         * representing all possible lengths of words in the automaton.
+         * representing all possible lengths of words in the automaton
+         * (taken from @p memo if it is not nullptr).
          */
-        LenNode get_lengths(const BasicTerm& var) const;
+        LenNode get_lengths(const BasicTerm& var, AutAssignment::WordLengthsMemo* memo = nullptr) const;
 
         /**
          * @brief Flattens substitution_map so that each var maps only to vars in aut_assignment
@@ -276,10 +390,426 @@ namespace smt::noodler {
         }
     };
 
+    /**
+     * @brief Statistics of one run of DecisionProcedure.
+     */
+    struct DecisionProcedureStats {
+        unsigned num_noodlifications = 0;
+        unsigned num_noodles = 0;
+        // solving states created from noodles
+        unsigned num_solving_states = 0;
+        unsigned num_inclusion_checks = 0;
+        // inclusion checks decided by InclusionCache without computing the inclusion
+        unsigned num_inclusion_cache_hits = 0;
+        // maximal number of states of automata that were noodlified or obtained from noodlification
+        unsigned max_aut_states = 0;
+        // sum of the numbers of states of automata obtained from noodlifications
+        unsigned total_aut_states = 0;
+        // preprocessing passes skipped by PreprocessScheduler
+        unsigned num_preprocess_passes_skipped = 0;
+        // calls of preprocess() whose passes were taken from PreprocessMemo
+        unsigned num_preprocess_memo_hits = 0;
+        // automata operations skipped in preprocessing by the cost model (see FormulaPreprocessor::allow_aut_operation())
+        unsigned num_preprocess_ops_gated = 0;
+        // maximal approximate size of the worklist in kilobytes (computed only if its memory is limited)
+        unsigned max_worklist_kb = 0;
+        // states dropped from the worklist because its memory limit was exceeded
+        unsigned num_evicted_states = 0;
+        // inclusions satisfied by shortest words without noodlification (see DecisionProcedure::get_shortest_witness_state())
+        unsigned num_witness_inclusions = 0;
+        // noodle segments replaced by a structurally identical shared automaton (see SegmentPool)
+        unsigned num_shared_segments = 0;
+        // concatenations of right sides taken from SegmentPool
+        unsigned num_concatenation_memo_hits = 0;
+        // learned nogoods and the solving states pruned by them (see NogoodStore)
+        unsigned num_nogoods = 0;
+        unsigned num_nogood_pruned_states = 0;
+        // solving states pruned by the lengths of the arithmetic assignment (see DecisionProcedure::set_length_assignment())
+        unsigned num_length_pruned_states = 0;
+        // solving states explored later as they are incompatible with the lengths of the arithmetic assignment
+        unsigned num_model_deferred_states = 0;
+    };
+
+    /**
+     * @brief Limits of the computation of DecisionProcedure started by DecisionProcedure::set_budget() (0 means no limit).
+     */
+    struct DecisionProcedureBudget {
+        unsigned time_ms = 0;
+        unsigned solving_states = 0;
+        unsigned aut_states = 0;
+        // approximate memory of the worklist in megabytes, see DecisionProcedure::explore_worklist()
+        unsigned memory_mb = 0;
+    };
+
+    /**
+     * @brief Policy (given by m_params.m_reduction_policy) deciding how automata are reduced at the points of the
+     * decision procedure where they grow: concatenations of automata of non-length variables on the right side
+     * of an inclusion and noodlifications.
+     */
+    class ReductionPolicy {
+    public:
+        enum struct Site {
+            CONCATENATION,
+            NOODLE,
+        };
+
+        // ordered by strength, a stronger reduction includes the weaker ones
+        enum struct Reduction {
+            NONE,
+            TRIM,
+            SIMULATION,
+            MINIMIZE,
+        };
+
+    private:
+        reduction_policy policy;
+        unsigned minimize_states;
+        unsigned simulation_states;
+
+    public:
+        explicit ReductionPolicy(const theory_str_noodler_params& par)
+            : policy(par.m_reduction_policy), minimize_states(par.m_reduction_minimize_states),
+              simulation_states(par.m_reduction_simulation_states) {}
+
+        /**
+         * @brief Decide the reduction at @p site of an automaton with @p num_of_states states.
+         */
+        Reduction decide(Site site, size_t num_of_states) const;
+
+        /**
+         * @brief Get the parameters of noodlification of automata whose product has at most @p product_states states.
+         *
+         * @param[out] done Reduction of the product done by the noodlification (noodles are always trimmed)
+         */
+        std::unordered_map<std::string, std::string> noodlify_params(size_t product_states, Reduction& done) const;
+
+        /**
+         * @brief Reduce @p aut at @p site, @p aut is returned if the decided reduction is not stronger than @p done.
+         */
+        std::shared_ptr<mata::nfa::Nfa> reduce(Site site, const std::shared_ptr<mata::nfa::Nfa>& aut, Reduction done = Reduction::NONE) const;
+    };
+
+    /**
+     * @brief Bounded cache of inclusion checks L(left_1...left_n) ⊆ L(right) done in the decision procedure.
+     *
+     * The entries are keyed by identities of the shared automata, so the check is reused by solving states
+     * that branched from the same parent (they share the automata of the variables untouched by noodlification).
+     * Each entry keeps its automata alive, so their addresses cannot be reused by other automata. For each
+     * right automaton, the counterexample of the last inclusion that did not hold is kept, and it is tried
+     * before computing a new inclusion with the same right automaton.
+     */
+    class InclusionCache {
+    private:
+        struct Entry {
+            // left automata followed by the right automaton
+            std::vector<std::shared_ptr<mata::nfa::Nfa>> automata;
+            bool result;
+            std::optional<mata::nfa::Run> counterexample;
+        };
+
+        std::map<std::vector<const mata::nfa::Nfa*>, Entry> cache;
+        // counterexamples for right automata (the automata are kept alive by the entries of cache)
+        std::unordered_map<const mata::nfa::Nfa*, mata::nfa::Run> counterexamples;
+        // the cache is dropped after reaching this number of entries
+        size_t max_size;
+        // the cache can be used by more threads (see explore_worklist_parallel)
+        std::mutex lock;
+
+    public:
+        explicit InclusionCache(size_t max_size = 1000) : max_size(max_size) {}
+
+        /**
+         * @brief Check whether L(@p left_automata[0] ... @p left_automata[n]) is included L(@p right_automaton).
+         *
+         * @param[out] cache_hit Set to true if the result was obtained without computing the inclusion
+         */
+        bool is_included(const std::vector<std::shared_ptr<mata::nfa::Nfa>>& left_automata,
+                         const std::shared_ptr<mata::nfa::Nfa>& right_automaton, bool& cache_hit);
+
+        void clear() {
+            std::lock_guard<std::mutex> guard(lock);
+            cache.clear();
+            counterexamples.clear();
+        }
+    };
+
+    /**
+     * @brief Hash-consed automata of noodle segments shared by the noodles (and solving states) of one decision
+     * procedure, with memoized concatenations of right sides.
+     *
+     * Sibling noodles are often identical up to their last segments, so the structurally identical segments are
+     * represented by one automaton and the products computed from them (concatenations for right sides of later
+     * inclusions, inclusion checks by InclusionCache) are keyed by the same identities. Each memoized concatenation
+     * keeps its operands alive, so their addresses cannot be reused by other automata. The pool can be used by
+     * more threads (see explore_worklist_parallel).
+     */
+    class SegmentPool {
+    private:
+        struct NfaHash {
+            size_t operator()(const std::shared_ptr<mata::nfa::Nfa>& nfa) const { return AutomataPool::structural_hash(*nfa); }
+        };
+        struct NfaEqual {
+            bool operator()(const std::shared_ptr<mata::nfa::Nfa>& a, const std::shared_ptr<mata::nfa::Nfa>& b) const {
+                return AutomataPool::structurally_equal(*a, *b);
+            }
+        };
+        struct Concatenation {
+            std::shared_ptr<mata::nfa::Nfa> left, right, result;
+        };
+
+        std::unordered_set<std::shared_ptr<mata::nfa::Nfa>, NfaHash, NfaEqual> segments;
+        std::map<std::pair<const mata::nfa::Nfa*, const mata::nfa::Nfa*>, Concatenation> concatenations;
+        // the pool (or the memo) is dropped after reaching this number of entries (already shared automata stay valid)
+        size_t max_size;
+        std::mutex lock;
+
+    public:
+        explicit SegmentPool(size_t max_size = 5000) : max_size(max_size) {}
+
+        /**
+         * @brief Get the shared automaton structurally identical to @p nfa (adding @p nfa if there is none yet).
+         *
+         * @param[out] shared Set to true if an identical automaton was already in the pool
+         */
+        std::shared_ptr<mata::nfa::Nfa> intern(const std::shared_ptr<mata::nfa::Nfa>& nfa, bool& shared);
+
+        /**
+         * @brief Get the (shared) concatenation of @p left and @p right reduced by @p reduce, computing it only if
+         * it is not memoized for the identities of @p left and @p right.
+         *
+         * @param[out] memo_hit Set to true if the concatenation was memoized
+         */
+        std::shared_ptr<mata::nfa::Nfa> get_concatenation(const std::shared_ptr<mata::nfa::Nfa>& left, const std::shared_ptr<mata::nfa::Nfa>& right,
+                                                          const std::function<std::shared_ptr<mata::nfa::Nfa>(std::shared_ptr<mata::nfa::Nfa>)>& reduce,
+                                                          bool& memo_hit);
+    };
+
+    /**
+     * @brief Nogoods learned from the solving states of one decision procedure that failed during noodlification.
+     *
+     * A nogood is an inclusion together with the automata of its terms for which the noodlification produced
+     * no noodle, i.e. no words of the automata satisfy the inclusion. Each solving state whose inclusion graph
+     * contains the same inclusion with the same automata (sibling noodles share the automata of their segments,
+     * see SegmentPool) has no solution either and is pruned before it is pushed to the worklist. The automata are
+     * kept alive by the store, so their addresses cannot be reused by other automata. The store can be used by
+     * more threads (see explore_worklist_parallel).
+     */
+    class NogoodStore {
+    private:
+        struct Nogood {
+            Predicate inclusion;
+            // automata of the terms of the left and then the right side of the inclusion (nullptr for terms without automaton)
+            std::vector<std::shared_ptr<mata::nfa::Nfa>> automata;
+        };
+
+        std::unordered_map<size_t, std::vector<Nogood>> nogoods;
+        size_t num_nogoods = 0;
+        // the store is dropped after reaching this number of nogoods
+        size_t max_size;
+        mutable std::mutex lock;
+
+        static std::vector<std::shared_ptr<mata::nfa::Nfa>> get_automata(const Predicate& inclusion, const AutAssignment& aut_ass);
+        static size_t hash(const Predicate& inclusion, const std::vector<std::shared_ptr<mata::nfa::Nfa>>& automata);
+
+    public:
+        explicit NogoodStore(size_t max_size = 5000) : max_size(max_size) {}
+
+        /**
+         * @brief Learn that @p inclusion cannot hold for the automata of its terms in @p aut_ass.
+         */
+        void add(const Predicate& inclusion, const AutAssignment& aut_ass);
+
+        /**
+         * @brief Check whether some inclusion of the inclusion graph of @p state is a learned nogood.
+         */
+        bool contains_nogood(const SolvingState& state) const;
+    };
+
+    /**
+     * @brief Memo of the results of preprocessing passes of DecisionProcedure::preprocess(), shared by the decision
+     * procedures of one solver session (successive final checks often preprocess the same instance). The key is the
+     * input of the passes: the formula, the not-contains predicates, the automata assignment (automata are compared
+     * by their addresses and kept alive by the memo, equal automata from different final checks are the same objects
+     * thanks to AutomataPool), the length variables, the length equivalence classes, the string variables in
+     * conversions and the type of preprocessing. The value is the preprocessor after the passes.
+     *
+     * Besides that, the memo keeps the instances after the passes that all procedures preprocessing an instance start
+     * with (see get_shared()), so that e.g. the length-based procedure and DecisionProcedure run them only once.
+     */
+    class PreprocessMemo {
+    public:
+        struct Key {
+            PreprocessType opt;
+            Formula formula;
+            Formula not_contains;
+            // sorted by terms
+            std::vector<std::pair<BasicTerm, std::shared_ptr<mata::nfa::Nfa>>> automata;
+            // sorted
+            std::vector<BasicTerm> length_vars;
+            BasicTermEqiv len_eq_vars;
+            std::vector<BasicTerm> conversion_vars;
+
+            Key(PreprocessType opt, const Formula& formula, const Formula& not_contains, const AutAssignment& aut_ass,
+                const std::unordered_set<BasicTerm>& length_vars, const BasicTermEqiv& len_eq_vars,
+                const std::vector<TermConversion>& conversions);
+
+            bool operator==(const Key& other) const;
+            size_t hash() const;
+        };
+
+    private:
+        using Table = std::unordered_map<size_t, std::vector<std::pair<Key, std::shared_ptr<const FormulaPreprocessor>>>>;
+        Table memo;
+        // preprocessors after the shared passes, keys contain only the formula, automata and length variables
+        Table shared;
+        size_t num_entries = 0;
+        // approximate memory of the entries (the automata are mostly shared with AutomataPool and not counted)
+        size_t bytes = 0;
+        // the memo is dropped after reaching this number of entries
+        size_t max_size;
+
+    public:
+        explicit PreprocessMemo(size_t max_size = 64) : max_size(max_size) {}
+
+        /**
+         * @brief Get the preprocessor memoized for @p key (nullptr if there is none).
+         */
+        std::shared_ptr<const FormulaPreprocessor> find(const Key& key) const;
+        void insert(Key key, std::shared_ptr<const FormulaPreprocessor> prep);
+
+        /**
+         * @brief Get a preprocessor of the instance given by @p formula, @p aut_ass and @p length_vars after the
+         * shared passes (remove_trivial and reduce_diseqalities, which start the passes of all procedures). If @p memo
+         * is not nullptr, the passes are run only if they were not run on the same instance before; the caller
+         * continues with its own passes on the returned copy.
+         */
+        static FormulaPreprocessor get_shared(PreprocessMemo* memo, Formula formula, AutAssignment aut_ass,
+                                              std::unordered_set<BasicTerm> length_vars, const theory_str_noodler_params& par,
+                                              PreprocessProfile* profile, LiteralStore* store);
+
+        size_t get_bytes() const { return bytes; }
+
+        void clear() {
+            memo.clear();
+            shared.clear();
+            num_entries = 0;
+            bytes = 0;
+        }
+
+    private:
+        static std::shared_ptr<const FormulaPreprocessor> find(const Table& table, const Key& key);
+        void insert(Table& table, Key key, std::shared_ptr<const FormulaPreprocessor> prep);
+    };
+
+    /**
+     * @brief Parts of the automaton of a to_int/from_int substituting variable needed to encode the conversions
+     * (see DecisionProcedure::get_formula_for_int_subst_vars()), memoized for each automaton of the solutions.
+     */
+    struct DigitDecomposition {
+        struct OfLength {
+            // minimized automaton of the digit words of one length (with empty language if there are none)
+            mata::nfa::Nfa aut;
+            // interval words of aut if they are encoded explicitly (see DecisionProcedure::get_explicit_interval_words())
+            std::optional<std::vector<interval_word>> interval_words;
+        };
+
+        // the automaton is kept alive, so that its address is not reused by another automaton
+        std::shared_ptr<mata::nfa::Nfa> aut;
+        // words containing only digits and words containing some non-digit
+        mata::nfa::Nfa valid_part;
+        mata::nfa::Nfa non_valid_part;
+        // computed on demand, as the length of underapproximation can grow (see DecisionProcedure::set_underapprox_length())
+        std::map<unsigned, OfLength> of_length;
+    };
+
     class DecisionProcedure : public AbstractDecisionProcedure {
     protected:
-        // counter of noodlifications
-        unsigned noodlification_no = 0;
+        DecisionProcedureStats stats;
+
+        // memoized inclusion checks of inclusions on cycle
+        InclusionCache inclusion_cache;
+        // shared automata of noodle segments and memoized concatenations of right sides
+        SegmentPool segment_pool;
+        // inclusions (with automata) that could not be noodlified in failed solving states
+        NogoodStore nogoods;
+
+        // lengths of length variables in the current arithmetic assignment (see set_length_assignment())
+        std::map<BasicTerm, unsigned> length_assignment;
+        // length bounds of the solving states pruned by length_assignment
+        std::vector<LenNode> pruned_length_bounds;
+        // memo of the bounds of lengths of words of automata (the automata are kept alive by the memo)
+        std::unordered_map<const mata::nfa::Nfa*, std::pair<std::shared_ptr<mata::nfa::Nfa>, std::pair<unsigned, std::optional<unsigned>>>> length_bounds_memo;
+        std::mutex length_pruning_lock;
+
+        // memo of preprocessing results shared with other decision procedures (not used if nullptr)
+        PreprocessMemo* preprocess_memo = nullptr;
+        // profile of preprocessing passes (not recorded if nullptr)
+        PreprocessProfile* preprocess_profile = nullptr;
+        // literal store of the session used by preprocessing (not used if nullptr)
+        LiteralStore* literal_store = nullptr;
+        // memo of lengths of automata used by get_initial_lengths() (not used if nullptr)
+        LengthAbstractionCache* length_abstraction_cache = nullptr;
+        // decompositions of automata of to_int/from_int substituting variables, keyed by the identity of automata
+        std::unordered_map<const mata::nfa::Nfa*, DigitDecomposition> digit_decompositions;
+
+        // the current budget, the statistics and the time when it was set (see set_budget())
+        DecisionProcedureBudget budget;
+        DecisionProcedureStats budget_start_stats;
+        stopwatch budget_watch;
+        bool budget_exceeded = false;
+        // some states were evicted from the worklist, so its exhaustion does not mean unsatisfiability
+        bool states_evicted = false;
+
+        /**
+         * @brief Get the heuristic (given by m_params.m_inclusion_order) ordering the inclusions of @p state
+         * (empty function for the order given only by the inclusion graph). The order refers to @p state, so it
+         * can be used only while @p state exists.
+         */
+        Graph::PredicateOrder get_inclusion_order(const SolvingState& state) const;
+
+        /**
+         * @brief Try to satisfy the inclusions of acyclic @p state (without length variables) by words, going through
+         * them in the order of inclusions_to_process. The terms get shortest words of their automata, only the last
+         * left term without a word (if it occurs there once) gets the rest of the word of the right side.
+         *
+         * @return Copy of @p state in which the variables of the satisfied inclusions are restricted to their words
+         * and only the other inclusions are left to process, std::nullopt if no inclusion is satisfied.
+         */
+        std::optional<SolvingState> get_shortest_witness_state(const SolvingState& state);
+
+        /**
+         * @brief Run the preprocessing passes of preprocess() that follow the shared ones (see
+         * PreprocessMemo::get_shared()) on @p prep_handler.
+         */
+        void run_preprocess_passes(FormulaPreprocessor& prep_handler, PreprocessType opt, const BasicTermEqiv &len_eq_vars);
+
+        /**
+         * @brief Check whether the computation exceeded the budget set by set_budget().
+         */
+        bool is_over_budget();
+
+        /**
+         * @brief Approximate number of bytes owned by @p state, the automata and the containers shared with other
+         * states are divided between the sharing states.
+         */
+        static size_t estimate_state_bytes(const SolvingState& state);
+
+        /**
+         * @brief Account the memory of @p state pushed to a worklist of @p worklist_bytes bytes if the memory of the
+         * worklist is limited by @p memory_limit bytes (budget.memory_mb, 0 means no limit).
+         *
+         * @return true -> the state has to be pushed to the front, as above half of the limit the exploration is
+         * depth-first (see explore_worklist())
+         */
+        bool account_pushed_state(SolvingState& state, std::atomic<size_t>& worklist_bytes, size_t memory_limit);
+
+        /**
+         * @brief Evict the last states of @p states (keeping at least one) until @p worklist_bytes falls below three
+         * quarters of @p memory_limit.
+         *
+         * @return The number of evicted states (also added to stats.num_evicted_states).
+         */
+        unsigned evict_states(std::deque<SolvingState>& states, std::atomic<size_t>& worklist_bytes, size_t memory_limit);
 
         // a deque containing states of decision procedure, each of them can lead to a solution
         std::deque<SolvingState> worklist;
@@ -301,6 +831,8 @@ namespace smt::noodler {
         std::vector<LenNode> disequations_len_formula_conjuncts;
 
         const theory_str_noodler_params& m_params;
+        // maximum length of digit words used in underapproximating conversions (see set_underapprox_length())
+        unsigned underapprox_length;
 
         /**
          * @brief Replace disequality L != R with equalities and a length constraint saved in disequations_len_formula_conjuncts.
@@ -351,6 +883,44 @@ namespace smt::noodler {
          */
         LenNode encode_interval_words(const BasicTerm& var, const std::vector<interval_word>& interval_words);
 
+        /**
+         * @brief Get the formula encoding that arithmetic variable @p var is any of the numbers encoded by the words of @p aut
+         *
+         * The states of @p aut are encoded by auxiliary variables holding the numbers encoded by the rest of the word (shared
+         * suffixes of words are therefore encoded only once), so the size of the formula is linear in the number of transitions
+         * of @p aut (instead of the number of interval words).
+         *
+         * Assumes that @p aut is minimized and accepts a non-empty language of digit words of one length.
+         */
+        LenNode encode_interval_automaton(const BasicTerm& var, const mata::nfa::Nfa& aut);
+
+        /**
+         * @brief Get the interval words of @p aut if encode_interval_words() creates at most m_params.m_interval_cases_limit
+         * disjuncts for them, std::nullopt otherwise. Assumptions on @p aut are the same as for encode_interval_automaton().
+         */
+        std::optional<std::vector<interval_word>> get_explicit_interval_words(const mata::nfa::Nfa& aut);
+
+        /**
+         * @brief Get the formula encoding that arithmetic variable @p var is any of the numbers encoded by the words of @p words
+         *
+         * Uses encode_interval_words() if the interval words are encoded explicitly, otherwise encode_interval_automaton().
+         */
+        LenNode encode_digit_automaton(const BasicTerm& var, const DigitDecomposition::OfLength& words) {
+            return words.interval_words.has_value() ? encode_interval_words(var, *words.interval_words) : encode_interval_automaton(var, words.aut);
+        }
+
+        /**
+         * @brief Get the (memoized) decomposition of @p aut into words with only digits and with some non-digit.
+         *
+         * @param contain_non_digit automaton of words containing some non-digit
+         */
+        DigitDecomposition& get_digit_decomposition(const std::shared_ptr<mata::nfa::Nfa>& aut, const mata::nfa::Nfa& contain_non_digit);
+
+        /**
+         * @brief Get the (memoized) digit words of length @p length from @p decomposition.
+         */
+        const DigitDecomposition::OfLength& get_digit_words_of_length(DigitDecomposition& decomposition, unsigned length);
+
         /**
          * @brief Get the formula for to_int/from_int substituting variables
          * 
@@ -384,12 +954,33 @@ namespace smt::noodler {
          */
         Formula not_contains{};
 
+        /**
+         * @brief not_contains predicate not contains(@p haystack, @p needle) where @p needle has finitely many @p words,
+         * it is solved by a case split on the word of @p needle (see split_not_contains()).
+         */
+        struct NotContainsSplit {
+            BasicTerm needle;
+            BasicTerm haystack;
+            std::vector<std::vector<mata::Symbol>> words;
+        };
+        std::vector<NotContainsSplit> not_contains_splits;
+        // the needles with more words (or more combinations of words of all needles) are left in not_contains
+        static const size_t NOT_CONTAINS_MAX_WORDS = 16;
+        static const size_t NOT_CONTAINS_MAX_BRANCHES = 64;
+
         /**
          * @brief Construct constraints to get rid of not_contains predicates.
          * @return l_false -> unsatisfiable constaint; l_undef if it is not evident
          */
         lbool replace_not_contains();
 
+        /**
+         * @brief Create the initial states for the combinations of the words of needles of not_contains_splits from
+         * @p state: the needle is restricted to its word w and the haystack to the words not containing w. The states
+         * with an empty language of some term are dropped.
+         */
+        std::vector<SolvingState> split_not_contains(const SolvingState& state) const;
+
         /**
          * @brief Check if it is possible to syntactically unify not contains terms. If they are included (in the sense of vectors) the 
          * not(contain) is unsatisfiable.
@@ -399,6 +990,96 @@ namespace smt::noodler {
          */
         lbool can_unify_not_contains(const FormulaPreprocessor& prep);
 
+        /**
+         * @brief Process one inclusion of @p element_to_process (if it is not already a solution). The
+         * states obtained from processing are passed to @p push_to_worklist together with a flag telling
+         * whether they should be processed as the next ones (DFS, true) or at the end (BFS, false).
+         *
+         * @return true -> @p element_to_process is a solution (there is nothing to process)
+         */
+        bool process_solving_state(SolvingState& element_to_process, const std::function<void(SolvingState&&, bool)>& push_to_worklist);
+
+        /**
+         * @brief Process states from the worklist until some solution is found and stored in @p solution.
+         *
+         * If the memory of the worklist is limited (budget.memory_mb), the approximate sizes of the states are
+         * accounted: above half of the limit, the new states are explored depth-first (which bounds the
+         * frontier), above the limit, the last states of the worklist are evicted. After an eviction, the exhausted
+         * worklist is reported as an exceeded budget, as the evicted states could lead to a solution.
+         * @return l_true -> solution was found; l_false -> worklist was exhausted; l_undef -> budget was exceeded
+         * (the unprocessed states are kept in the worklist)
+         */
+        lbool explore_worklist();
+
+        /**
+         * @brief Same as explore_worklist(), but the state with the lowest cost (get_state_cost()) is processed first.
+         *
+         * The priority of a state is its cost plus the number of states processed before it was pushed divided by
+         * m_params.m_worklist_aging, so the states pushed long ago are eventually processed even if their cost is
+         * high. Above the memory limit of the worklist, the states with the worst priority are evicted. The
+         * unprocessed states are moved back to @p worklist (in the order of their priorities).
+         */
+        lbool explore_worklist_best_first();
+
+        /**
+         * @brief Cost of @p state for the best-first exploration given by m_params.m_worklist_order (lower cost is
+         * processed first). The numbers of states of automata are taken logarithmically, so that they are comparable
+         * with the aging of the states.
+         */
+        double get_state_cost(const SolvingState& state) const;
+
+        /**
+         * @brief Bounds of lengths of words of @p var in @p state, i.e. the sums of the bounds of the automata of the variables
+         * which substitute @p var (the upper bound is std::nullopt if some of the languages is infinite, the lower bound is
+         * greater than the upper one if some of them is empty). Requires length_pruning_lock.
+         */
+        std::pair<unsigned, std::optional<unsigned>> get_length_bounds(const SolvingState& state, const BasicTerm& var);
+
+        /**
+         * @brief Check whether the new solving @p state can be pruned, i.e. it contains a nogood or the bounds of lengths
+         * of a variable exclude its length in length_assignment if m_params.m_length_pruning is set (the bounds are then
+         * added to pruned_length_bounds).
+         */
+        bool is_pruned(const SolvingState& state);
+
+        /**
+         * @brief Get the bounds of lengths of the first variable of length_assignment whose bounds in @p state
+         * (see get_length_bounds()) exclude its length, std::nullopt if there is no such variable.
+         */
+        std::optional<LenNode> get_length_conflict(const SolvingState& state);
+
+        /**
+         * @brief Check whether the new solving @p state is compatible with length_assignment (always true if
+         * m_params.m_model_guided_noodles is not set). The incompatible states are explored after the others.
+         */
+        bool is_length_compatible(const SolvingState& state);
+
+        /**
+         * @brief Same as explore_worklist(), but states are processed by @p num_threads threads.
+         *
+         * Each thread has its own deque of states, it processes states from its front (so the order given by
+         * push_unique and by pushing to the front/back is kept for the states it created) and when it has
+         * nothing to process, it steals states from the back of deques of other threads. When some thread
+         * finds a solution, the other threads stop after finishing the state they are processing. The
+         * remaining states are moved back to @p worklist, so the next call continues from them. The memory of
+         * all the deques is limited as in explore_worklist(), the threads evict the last states of the deques.
+         */
+#ifndef SINGLE_THREAD
+        lbool explore_worklist_parallel(unsigned num_threads);
+
+        /**
+         * @brief Deterministic version of explore_worklist_parallel() (m_params.m_deterministic).
+         *
+         * The states are processed in rounds: each round takes up to @p num_threads states from the front of
+         * @p worklist, the i-th of them is processed by the worker of rank i, and after all the workers finish,
+         * their new states are pushed to @p worklist by rank (the states that the worker of the lowest rank pushes
+         * to the front end up at the front). The solution is the one of the lowest rank, the solutions of the other
+         * workers are kept for the next call. The result depends only on the order of states in @p worklist.
+         * The memory of @p worklist is limited as in explore_worklist(), the states are evicted between the rounds.
+         */
+        lbool explore_worklist_rounds(unsigned num_threads);
+#endif
+
     public:
 
         /**
@@ -423,7 +1104,8 @@ namespace smt::noodler {
             formula(formula),
             init_aut_ass(init_aut_ass),
             conversions(conversions),
-            m_params(par) {
+            m_params(par),
+            underapprox_length(par.m_underapprox_length) {
             
             // we extract from the input formula all not_contains predicates and add them to not_contains formula
             this->formula.extract_predicates(PredicateType::NotContains, this->not_contains);
@@ -446,6 +1128,82 @@ namespace smt::noodler {
         LenNode get_initial_lengths() override;
 
         std::pair<LenNode, LenNodePrecision> get_lengths() override;
+
+        /**
+         * @brief Get the solving state of the last solution (see compute_next_solution()).
+         */
+        const SolvingState& get_solution() const { return solution; }
+
+        const DecisionProcedureStats& get_stats() const { return stats; }
+
+        /**
+         * @brief Set the memo used by preprocess() to reuse results of preprocessing of the same instance.
+         */
+        void set_preprocess_memo(PreprocessMemo* memo) { preprocess_memo = memo; }
+
+        /**
+         * @brief Set the profile to which preprocess() records its passes.
+         */
+        void set_preprocess_profile(PreprocessProfile* profile) { preprocess_profile = profile; }
+
+        /**
+         * @brief Set the literal store of the session used by preprocess() to compare literals.
+         */
+        void set_literal_store(LiteralStore* store) { literal_store = store; }
+
+        /**
+         * @brief Set the memo of lengths of automata used by get_initial_lengths().
+         */
+        void set_length_abstraction_cache(LengthAbstractionCache* cache) { length_abstraction_cache = cache; }
+
+        /**
+         * @brief Set the lengths of (some of) the initial length variables in the current arithmetic assignment.
+         * The solving states created by noodlification in which the bounds of lengths of some of these variables
+         * exclude its length are pruned if m_params.m_length_pruning is set (the pruned states are not lost for
+         * other assignments, their bounds are collected in get_pruned_length_bounds()), otherwise they are explored
+         * after the other states if m_params.m_model_guided_noodles is set.
+         */
+        void set_length_assignment(std::map<BasicTerm, unsigned> lengths) { length_assignment = std::move(lengths); }
+
+        /**
+         * @brief Disjunction of the length bounds of the solving states pruned by the length assignment, it
+         * overapproximates the lengths of their solutions (false if no state was pruned).
+         */
+        LenNode get_pruned_length_bounds();
+
+        /**
+         * @brief Was some solving state pruned by the length assignment (see set_length_assignment())?
+         */
+        bool was_length_pruned() {
+            std::lock_guard<std::mutex> guard(length_pruning_lock);
+            return !pruned_length_bounds.empty();
+        }
+
+        /**
+         * @brief Set the budget for the following calls of compute_next_solution(). When it is exceeded,
+         * compute_next_solution() returns l_undef and was_budget_exceeded() is true. The computation can be
+         * continued after setting a new budget.
+         */
+        void set_budget(const DecisionProcedureBudget& new_budget) {
+            budget = new_budget;
+            budget_start_stats = stats;
+            budget_exceeded = false;
+            budget_watch.reset();
+            budget_watch.start();
+        }
+
+        /**
+         * @brief Did the last call of compute_next_solution() return l_undef because the budget was exceeded?
+         */
+        bool was_budget_exceeded() const { return budget_exceeded; }
+
+        /**
+         * @brief Set the maximum length of digit words used in underapproximating conversions by the following calls
+         * of get_lengths() (initially m_params.m_underapprox_length). The current solution is kept, so get_lengths()
+         * can be called again for it with a larger length.
+         */
+        void set_underapprox_length(unsigned length) { underapprox_length = length; }
+        unsigned get_underapprox_length() const { return underapprox_length; }
     };
 }
 
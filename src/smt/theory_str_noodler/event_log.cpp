@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+
+#include "event_log.h"
+
+namespace smt::noodler {
+
+    EventLog::EventLog(unsigned capacity) : m_start(std::chrono::steady_clock::now()) {
+        uint64_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_events = std::make_unique<Event[]>(size);
+        m_mask = size - 1;
+    }
+
+    uint32_t EventLog::get_thread_id() {
+        // small consecutive numbers of threads in the order in which they recorded their first event
+        static std::atomic<uint32_t> next_id{0};
+        thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    const char* EventLog::get_event_name(EventType type) {
+        switch (type) {
+        case EventType::FINAL_CHECK_BEGIN:
+        case EventType::FINAL_CHECK_END:
+            return "final check";
+        case EventType::PROCEDURE_SELECTED:
+            return "procedure selected";
+        case EventType::NOODLES_GENERATED:
+            return "noodles generated";
+        case EventType::LENGTH_CHECK:
+            return "length check";
+        case EventType::BLOCK_LEMMA:
+            return "block lemma";
+        }
+        return "unknown";
+    }
+
+    void EventLog::dump_chrome_trace(std::ostream& out) const {
+        const uint64_t num_recorded = get_num_recorded();
+        const uint64_t size = m_mask + 1;
+        const uint64_t first = num_recorded > size ? num_recorded - size : 0;
+
+        out << "{\"traceEvents\":[";
+        bool first_event = true;
+        for (uint64_t i = first; i < num_recorded; ++i) {
+            const Event& event = m_events[i & m_mask];
+            if (!event.valid.load(std::memory_order_acquire)) {
+                continue;
+            }
+            out << (first_event ? "\n" : ",\n");
+            first_event = false;
+            out << "{\"name\":\"" << get_event_name(event.type) << "\",\"pid\":0,\"tid\":" << event.thread;
+            switch (event.type) {
+            case EventType::FINAL_CHECK_BEGIN:
+                // final checks are durations (begin/end pairs)
+                out << ",\"ph\":\"B\",\"ts\":" << event.time << ",\"args\":{\"number\":" << event.value << "}";
+                break;
+            case EventType::FINAL_CHECK_END:
+                out << ",\"ph\":\"E\",\"ts\":" << event.time << ",\"args\":{\"number\":" << event.value << ",\"status\":" << event.value2 << "}";
+                break;
+            case EventType::LENGTH_CHECK:
+                // the check ended at the time of the event, it is a complete event with its duration
+                out << ",\"ph\":\"X\",\"ts\":" << (event.time - std::min(event.time, event.value2)) << ",\"dur\":" << event.value2
+                    << ",\"args\":{\"result\":" << static_cast<int64_t>(event.value) << "}";
+                break;
+            case EventType::PROCEDURE_SELECTED:
+                out << ",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << event.time << ",\"args\":{\"procedure\":";
+                if (event.value == PROCEDURE_MAIN) {
+                    out << "\"main\"";
+                } else {
+                    out << event.value;
+                }
+                out << "}";
+                break;
+            default:
+                out << ",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << event.time << ",\"args\":{\"value\":" << event.value << "}";
+                break;
+            }
+            out << "}";
+        }
+        out << "\n]}\n";
+    }
+
+    bool EventLog::dump_chrome_trace(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+        dump_chrome_trace(out);
+        return static_cast<bool>(out);
+    }
+}
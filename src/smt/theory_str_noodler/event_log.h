@@ -0,0 +1,98 @@
+#ifndef _NOODLER_EVENT_LOG_H_
+#define _NOODLER_EVENT_LOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace smt::noodler {
+
+    /**
+     * @brief Types of events recorded in EventLog (the meaning of the values of an event is given for each type).
+     */
+    enum struct EventType : uint8_t {
+        FINAL_CHECK_BEGIN,      // value: number of the final check
+        FINAL_CHECK_END,        // value: number of the final check, value2: the returned final_check_status
+        PROCEDURE_SELECTED,     // value: SolverProcedure (or PROCEDURE_MAIN for the main decision procedure)
+        NOODLES_GENERATED,      // value: number of noodles of one noodlification
+        LENGTH_CHECK,           // value: lbool result (as an integer), value2: time of the check in microseconds
+        BLOCK_LEMMA,            // value: number of constraints in the blocked refinement
+    };
+
+    /**
+     * @brief Event of the string solver, a plain structure so that recording it does not allocate.
+     */
+    struct Event {
+        // microseconds since the creation of the log
+        uint64_t time = 0;
+        uint64_t value = 0;
+        uint64_t value2 = 0;
+        uint32_t thread = 0;
+        EventType type = EventType::FINAL_CHECK_BEGIN;
+        // the slot was written completely (the events are read only after the writers finished)
+        std::atomic<bool> valid{false};
+    };
+
+    /**
+     * @brief Lock-free ring buffer of the last events of the string solver.
+     *
+     * Unlike STRACE, recording an event only stores a few numbers into a preallocated slot (the slot is reserved by an
+     * atomic increment), so the log can be kept enabled in production. When the buffer is full, the oldest events are
+     * overwritten. The log can be dumped (for example after a timeout) as a Chrome trace (chrome://tracing, Perfetto).
+     */
+    class EventLog {
+    public:
+        // value of PROCEDURE_SELECTED for the main decision procedure
+        static constexpr uint64_t PROCEDURE_MAIN = UINT64_MAX;
+
+        /**
+         * @brief Create the log keeping the last @p capacity events (rounded up to a power of two).
+         */
+        explicit EventLog(unsigned capacity);
+
+        void record(EventType type, uint64_t value = 0, uint64_t value2 = 0) {
+            const uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+            Event& event = m_events[index & m_mask];
+            event.valid.store(false, std::memory_order_relaxed);
+            event.time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+            event.value = value;
+            event.value2 = value2;
+            event.thread = get_thread_id();
+            event.type = type;
+            event.valid.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Number of events recorded so far (including the overwritten ones).
+         */
+        uint64_t get_num_recorded() const { return m_next.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Write the events that are still in the buffer (from the oldest one) in the Chrome trace JSON format.
+         */
+        void dump_chrome_trace(std::ostream& out) const;
+
+        /**
+         * @brief Write the Chrome trace to the file @p path.
+         *
+         * @return True if the file could be written
+         */
+        bool dump_chrome_trace(const std::string& path) const;
+
+        static const char* get_event_name(EventType type);
+
+    private:
+        static uint32_t get_thread_id();
+
+        std::unique_ptr<Event[]> m_events;
+        uint64_t m_mask;
+        std::atomic<uint64_t> m_next{0};
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
+
+#endif
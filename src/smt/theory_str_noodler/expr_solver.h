@@ -114,6 +114,234 @@ namespace smt::noodler {
             }
         }
     };
+
+    /**
+     * @brief Long-lived length solver used by check_len_sat.
+     *
+     * Instead of building a new kernel (and internalizing the whole context again) for each length
+     * formula, the session keeps the asserted formulas of the context at the base level of its kernel
+     * and the relevant assignments in a single scope above it. Each checked length formula is asserted
+     * in its own scope that is popped right after the check. The asserted formulas (resp. assignments)
+     * are compared with the ones stored in the session and the corresponding part is rebuilt only if
+     * they differ.
+     *
+     * Unsat cores are computed by check_sat_core(), which assumes the assignments and the conjuncts of the checked
+     * formula instead of asserting them. Each assumed formula gets an indicator (a fresh propositional variable p
+     * with p -> formula asserted at the base level of the kernel), which is kept as long as the kernel.
+     */
+    class int_expr_session {
+        ast_manager& m;
+        // the kernel keeps a reference to the params, so they have to live as long as the kernel
+        smt_params m_fparams;
+        scoped_ptr<kernel> m_kernel;
+        // asserted formulas of the context currently kept at the base level of m_kernel
+        expr_ref_vector m_asserted;
+        // relevant assignments of the context currently kept in the first scope of m_kernel
+        expr_ref_vector m_assigns;
+        bool m_assigns_scope;
+        // incremented each time the stored formulas change (results of checks are valid only within one generation)
+        unsigned m_generation;
+        // indicators of the formulas assumed by check_sat_core() and the formulas of the indicators
+        obj_map<expr, expr*> m_indicator_of;
+        obj_map<expr, expr*> m_formula_of;
+        // keeps the assumed formulas and their indicators alive
+        expr_ref_vector m_indicator_pins;
+
+        static bool same_exprs(const expr_ref_vector& v1, const expr_ref_vector& v2) {
+            if(v1.size() != v2.size()) {
+                return false;
+            }
+            for(unsigned i = 0; i < v1.size(); ++i) {
+                // expressions are hash-consed, pointer comparison is sufficient
+                if(v1.get(i) != v2.get(i)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Get the indicator of @p e, it is created (at the base level of the kernel) if it does not exist yet.
+         */
+        expr* get_indicator(expr* e) {
+            expr* ind = nullptr;
+            if (m_indicator_of.find(e, ind)) {
+                return ind;
+            }
+            SASSERT(!m_assigns_scope);
+            expr_ref fresh(m.mk_fresh_const("len_ind", m.mk_bool_sort()), m);
+            m_kernel->assert_expr(m.mk_implies(fresh, e));
+            m_indicator_of.insert(e, fresh);
+            m_formula_of.insert(fresh, e);
+            m_indicator_pins.push_back(e);
+            m_indicator_pins.push_back(fresh);
+            return fresh;
+        }
+
+    public:
+        int_expr_session(ast_manager& m) : m(m), m_kernel(nullptr), m_asserted(m), m_assigns(m), m_assigns_scope(false), m_generation(0), m_indicator_pins(m) { }
+
+        /**
+         * @brief Drop the kernel together with all stored formulas.
+         */
+        void reset() {
+            m_kernel = nullptr;
+            m_asserted.reset();
+            m_assigns.reset();
+            m_assigns_scope = false;
+            m_indicator_of.reset();
+            m_formula_of.reset();
+            m_indicator_pins.reset();
+            ++m_generation;
+        }
+
+        /**
+         * @brief Get the current generation of the session. Two checks of the same formula in the
+         * same generation have the same result.
+         */
+        unsigned get_generation() const { return m_generation; }
+
+        /**
+         * @brief Synchronize the stored formulas with the asserted formulas of @p ctx
+         * (and relevant assignments of @p ctx if @p include_ass).
+         *
+         * @return Generation of the session after the synchronization
+         */
+        unsigned sync(context& ctx, bool include_ass = true) {
+            expr_ref_vector asserted(m), assigns(m);
+            for (unsigned i = 0; i < ctx.get_num_asserted_formulas(); ++i) {
+                asserted.push_back(ctx.get_asserted_formula(i));
+            }
+            if (include_ass) {
+                expr_ref_vector all_assigns(m);
+                ctx.get_assignments(all_assigns);
+                for (auto & a : all_assigns) {
+                    if(ctx.is_relevant(a)) {
+                        assigns.push_back(a);
+                    }
+                }
+            }
+
+            if(!m_kernel || !same_exprs(asserted, m_asserted)) {
+                STRACE("str-lia", tout << "length session: rebuilding kernel from " << asserted.size() << " asserted formulas" << std::endl);
+                reset();
+                m_fparams = ctx.get_fparams();
+                m_kernel = alloc(kernel, m, m_fparams);
+                for (expr* a : asserted) {
+                    m_kernel->assert_expr(a);
+                }
+                m_asserted.swap(asserted);
+            }
+
+            if(!m_assigns_scope || !same_exprs(assigns, m_assigns)) {
+                STRACE("str-lia", tout << "length session: replacing assignments by " << assigns.size() << " relevant assignments" << std::endl);
+                if(m_assigns_scope) {
+                    m_kernel->pop(1);
+                }
+                m_kernel->push();
+                for (expr* a : assigns) {
+                    m_kernel->assert_expr(a);
+                }
+                m_assigns.swap(assigns);
+                m_assigns_scope = true;
+                ++m_generation;
+            }
+            return m_generation;
+        }
+
+        /**
+         * @brief Check satisfiability of @p e together with the formulas of the last sync().
+         */
+        lbool check_sat(expr* e) {
+            SASSERT(m_kernel);
+            m_kernel->push();
+            m_kernel->assert_expr(e);
+            lbool r = m_kernel->check();
+            m_kernel->pop(1);
+            STRACE("str-lia", tout << "length session: " << mk_pp(e, m) << " is " << r << std::endl);
+            return r;
+        }
+
+        /**
+         * @brief Check satisfiability of @p e together with the formulas of the last sync(), if it is
+         * satisfiable, its model is stored to @p mdl.
+         */
+        lbool check_sat(expr* e, model_ref& mdl) {
+            SASSERT(m_kernel);
+            m_kernel->push();
+            m_kernel->assert_expr(e);
+            lbool r = m_kernel->check();
+            if (r == l_true) {
+                m_kernel->get_model(mdl);
+            }
+            m_kernel->pop(1);
+            STRACE("str-lia", tout << "length session: " << mk_pp(e, m) << " is " << r << std::endl);
+            return r;
+        }
+
+        /**
+         * @brief Check satisfiability of @p e together with the asserted formulas of @p ctx
+         * (and relevant assignments of @p ctx if @p include_ass).
+         */
+        lbool check_sat(context& ctx, expr* e, bool include_ass = true) {
+            sync(ctx, include_ass);
+            return check_sat(e);
+        }
+
+        /**
+         * @brief Check satisfiability of @p e together with the formulas of the last sync(), where the assignments
+         * and the conjuncts of @p e are assumed. If it is unsatisfiable, the assumed formulas of the unsat core are
+         * appended to @p core (the asserted formulas hold anyway, so they are never in the core).
+         */
+        lbool check_sat_core(expr* e, expr_ref_vector& core) {
+            SASSERT(m_kernel);
+            // the indicators are created at the base level, the assignments are assumed instead of asserted
+            if (m_assigns_scope) {
+                m_kernel->pop(1);
+                m_assigns_scope = false;
+            }
+            expr_ref_vector assumptions(m);
+            for (expr* a : m_assigns) {
+                assumptions.push_back(get_indicator(a));
+            }
+            ptr_vector<expr> todo;
+            todo.push_back(e);
+            while (!todo.empty()) {
+                expr* conj = todo.back();
+                todo.pop_back();
+                if (m.is_and(conj)) {
+                    todo.append(to_app(conj)->get_num_args(), to_app(conj)->get_args());
+                } else if (!m.is_true(conj)) {
+                    assumptions.push_back(get_indicator(conj));
+                }
+            }
+
+            lbool r = m_kernel->check(assumptions);
+            if (r == l_false) {
+                for (unsigned i = 0; i < m_kernel->get_unsat_core_size(); ++i) {
+                    core.push_back(m_formula_of.find(m_kernel->get_unsat_core_expr(i)));
+                }
+            }
+            STRACE("str-lia", tout << "length session: " << mk_pp(e, m) << " is " << r << " with unsat core " << core << std::endl);
+
+            m_kernel->push();
+            for (expr* a : m_assigns) {
+                m_kernel->assert_expr(a);
+            }
+            m_assigns_scope = true;
+            return r;
+        }
+
+        /**
+         * @brief Check satisfiability of @p e together with the asserted formulas of @p ctx (and relevant
+         * assignments of @p ctx if @p include_ass), see check_sat_core(expr*, expr_ref_vector&).
+         */
+        lbool check_sat_core(context& ctx, expr* e, expr_ref_vector& core, bool include_ass = true) {
+            sync(ctx, include_ass);
+            return check_sat_core(e, core);
+        }
+    };
 }
 
 #endif
\ No newline at end of file
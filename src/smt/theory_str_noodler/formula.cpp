@@ -1,7 +1,155 @@
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
 #include "formula.h"
 
 namespace smt::noodler {
+    namespace {
+        struct InternedTermHash {
+            size_t operator() (const std::pair<BasicTermType, zstring>& term) const {
+                return std::hash<BasicTermType>()(term.first) ^ (term.second.hash() << 1);
+            }
+        };
+
+        using InternTable = std::unordered_map<std::pair<BasicTermType, zstring>, unsigned, InternedTermHash>;
+
+        struct InternedTerms {
+            // basic terms can be created by more threads of the decision procedure, the table is locked only when
+            // a thread does not find a term in its own cache (see LocalInternedTerms)
+            std::mutex lock;
+            InternTable ids;
+            // the ids are shared by the interned terms and the fresh variables (which are not interned), they are
+            // never reused, so a term of a released table never equals a term created later
+            std::atomic<unsigned> next_id{0};
+            // number of the live scopes (guarded by lock)
+            unsigned num_scopes = 0;
+            // incremented by each release of the table, it invalidates the caches of the threads
+            std::atomic<unsigned> generation{0};
+        };
+
+        /**
+         * @brief Cache of the interned terms of one thread, valid for the generation of the table it was filled from.
+         */
+        struct LocalInternedTerms {
+            unsigned generation = 0;
+            InternTable ids;
+        };
+
+        struct FreshPrefixes {
+            std::mutex lock;
+            std::map<std::string, std::unique_ptr<BasicTerm::FreshPrefix>> prefixes;
+        };
+
+        FreshPrefixes& get_fresh_prefixes() {
+            static FreshPrefixes fresh_prefixes;
+            return fresh_prefixes;
+        }
+
+        // function-local static, so that it is initialized before any (possibly static) basic term is created
+        InternedTerms& get_interned_terms() {
+            static InternedTerms interned_terms;
+            return interned_terms;
+        }
+
+        LocalInternedTerms& get_local_interned_terms() {
+            thread_local LocalInternedTerms local_interned_terms;
+            return local_interned_terms;
+        }
+    }
+
+    unsigned BasicTerm::intern(BasicTermType type, const zstring& name) {
+        InternedTerms& interned = get_interned_terms();
+        LocalInternedTerms& local = get_local_interned_terms();
+        const unsigned generation = interned.generation.load(std::memory_order_acquire);
+        if (local.generation != generation) {
+            InternTable().swap(local.ids);
+            local.generation = generation;
+        }
+        auto key = std::make_pair(type, name);
+        if (auto it = local.ids.find(key); it != local.ids.end()) {
+            return it->second;
+        }
+
+        unsigned id;
+        {
+            std::lock_guard<std::mutex> lock(interned.lock);
+            auto [it, inserted] = interned.ids.try_emplace(key, 0);
+            if (inserted) {
+                it->second = interned.next_id.fetch_add(1);
+            }
+            id = it->second;
+        }
+        local.ids.emplace(std::move(key), id);
+        return id;
+    }
+
+    BasicTerm::InternScope::InternScope() {
+        InternedTerms& interned = get_interned_terms();
+        std::lock_guard<std::mutex> lock(interned.lock);
+        ++interned.num_scopes;
+    }
+
+    BasicTerm::InternScope::~InternScope() {
+        InternedTerms& interned = get_interned_terms();
+        {
+            std::lock_guard<std::mutex> lock(interned.lock);
+            if (--interned.num_scopes > 0) {
+                return;
+            }
+            InternTable().swap(interned.ids);
+            interned.generation.fetch_add(1, std::memory_order_release);
+        }
+        // the caches of the other threads are released when they intern a term again (or when they end)
+        InternTable().swap(get_local_interned_terms().ids);
+    }
+
+    unsigned BasicTerm::get_number_of_ids() {
+        return get_interned_terms().next_id.load();
+    }
+
+    struct BasicTerm::FreshPrefix {
+        std::string name;
+        std::atomic<unsigned> next_number{0};
+    };
+
+    BasicTerm BasicTerm::mk_fresh_variable(const std::string& prefix) {
+        // the prefixes are never removed, so the pointers can be cached by each thread without locking
+        thread_local std::unordered_map<std::string, FreshPrefix*> local_prefixes;
+        FreshPrefix*& fresh_prefix = local_prefixes[prefix];
+        if (fresh_prefix == nullptr) {
+            FreshPrefixes& prefixes = get_fresh_prefixes();
+            std::lock_guard<std::mutex> lock(prefixes.lock);
+            std::unique_ptr<FreshPrefix>& stored = prefixes.prefixes[prefix];
+            if (stored == nullptr) {
+                stored = std::make_unique<FreshPrefix>();
+                stored->name = prefix;
+            }
+            fresh_prefix = stored.get();
+        }
+        const unsigned number = fresh_prefix->next_number.fetch_add(1, std::memory_order_relaxed);
+        return BasicTerm(fresh_prefix, number, get_interned_terms().next_id.fetch_add(1));
+    }
+
+    zstring BasicTerm::render_fresh_name() const {
+        return zstring((fresh_prefix->name + "!n" + std::to_string(fresh_number)).c_str());
+    }
+
+    bool BasicTerm::name_less(const BasicTerm& other) const {
+        if (fresh_prefix == nullptr || other.fresh_prefix == nullptr) {
+            if (fresh_prefix != nullptr || other.fresh_prefix != nullptr) {
+                return other.fresh_prefix != nullptr;
+            }
+            return name < other.name;
+        }
+        if (fresh_prefix != other.fresh_prefix) {
+            return fresh_prefix->name < other.fresh_prefix->name;
+        }
+        return fresh_number < other.fresh_number;
+    }
+
     std::set<BasicTerm> Predicate::get_vars() const {
         std::set<BasicTerm> vars;
         for (const auto& side: params) {
@@ -17,19 +165,7 @@ namespace smt::noodler {
     std::set<BasicTerm> Predicate::get_side_vars(const Predicate::EquationSideType side) const {
         assert(is_eq_or_ineq());
         std::set<BasicTerm> vars;
-        std::vector<BasicTerm> side_terms;
-        switch (side) {
-            case EquationSideType::Left:
-                side_terms = get_left_side();
-                break;
-            case EquationSideType::Right:
-                side_terms = get_right_side();
-                break;
-            default:
-                throw std::runtime_error("unhandled equation side_terms type");
-                break;
-        }
-
+        const std::vector<BasicTerm>& side_terms = get_side(side);
         for (const auto &term: side_terms) {
             if (term.is_variable()) {
                 bool found{false};
@@ -64,8 +200,13 @@ namespace smt::noodler {
     }
 
     Predicate Predicate::split_literals() const {
+        const auto is_long_literal = [](const BasicTerm& bt) { return bt.is_literal() && bt.get_name().length() > 1; };
+        if(std::none_of(this->params.begin(), this->params.end(), [&](const std::vector<BasicTerm>& con) { return std::any_of(con.begin(), con.end(), is_long_literal); })) {
+            return *this;
+        }
         const auto& split_concat = [&](const std::vector<BasicTerm>& con) {
             std::vector<BasicTerm> ret;
+            ret.reserve(con.size());
             for(const BasicTerm& bt : con) {
                 if(bt.is_literal()) {
                     zstring name = bt.get_name();
@@ -80,10 +221,11 @@ namespace smt::noodler {
         };
 
         std::vector<std::vector<BasicTerm>> new_pars;
+        new_pars.reserve(this->params.size());
         for(const auto& par : this->params) {
             new_pars.push_back(split_concat(par));
         }
-        return Predicate(this->get_type(), new_pars);
+        return Predicate(this->get_type(), std::move(new_pars));
     }
 
     std::string Predicate::to_string() const {
@@ -189,9 +331,9 @@ namespace smt::noodler {
                 return ("\"" + name.encode() + "\"");
             }
             case BasicTermType::Variable:
-                return name.encode();
+                return get_name().encode();
             case BasicTermType::Length:
-                return name.encode() + " (" + noodler::to_string(type) + ")";
+                return get_name().encode() + " (" + noodler::to_string(type) + ")";
                 // TODO: Decide what will have names and when to use them.
         }
 
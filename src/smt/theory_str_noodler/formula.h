@@ -12,6 +12,7 @@
 #ifndef Z3_NOODLER_FORMULA_H
 #define Z3_NOODLER_FORMULA_H
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <stdexcept>
@@ -66,37 +67,97 @@ namespace smt::noodler {
         throw std::runtime_error("Unhandled basic term type passed to to_string().");
     }
 
+    /**
+     * @brief Basic term (variable, literal, length) of the formula.
+     *
+     * Each pair (type, name) is interned and gets a unique dense id, so that equality checks and hashing
+     * of basic terms are just integer operations. The id can be also used to index vectors instead of
+     * using maps with basic terms as keys. Each thread looks the pairs up in its own cache first, so the
+     * shared table is locked only for pairs new to the thread. The table lives as long as some InternScope.
+     */
     class BasicTerm {
     public:
-        explicit BasicTerm(BasicTermType type): type(type) {}
-        BasicTerm(BasicTermType type, zstring name): type(type), name(std::move(name)) {}
+        explicit BasicTerm(BasicTermType type): type(type), id(intern(type, name)) {}
+        BasicTerm(BasicTermType type, zstring name): type(type), name(std::move(name)), id(intern(this->type, this->name)) {}
 
         [[nodiscard]] BasicTermType get_type() const { return type; }
         [[nodiscard]] bool is_variable() const { return type == BasicTermType::Variable; }
         [[nodiscard]] bool is_literal() const { return type == BasicTermType::Literal; }
         [[nodiscard]] bool is(BasicTermType term_type) const { return type == term_type; }
 
-        [[nodiscard]] zstring get_name() const { return name; }
-        void set_name(zstring new_name) { name = std::move(new_name); }
+        /**
+         * @brief Create a fresh variable, which differs from all other terms (including the variables created with
+         * its name). It has a numeric id and its name @p prefix!n<number> is rendered only when it is needed (see
+         * get_name()), so fresh variables are cheap to create, also from more threads.
+         */
+        [[nodiscard]] static BasicTerm mk_fresh_variable(const std::string& prefix);
+
+        [[nodiscard]] bool is_fresh() const { return fresh_prefix != nullptr; }
+
+        [[nodiscard]] zstring get_name() const { return fresh_prefix == nullptr ? name : render_fresh_name(); }
+        void set_name(zstring new_name) { name = std::move(new_name); fresh_prefix = nullptr; id = intern(type, name); }
+
+        /**
+         * @brief Get the unique id of this term, terms are equal iff they have the same id.
+         */
+        [[nodiscard]] unsigned get_id() const { return id; }
+
+        /**
+         * @brief Get the number of ids given to the terms so far (all ids are smaller than this number).
+         */
+        [[nodiscard]] static unsigned get_number_of_ids();
 
         [[nodiscard]] bool equals(const BasicTerm& other) const {
-            return type == other.get_type() && name == other.get_name();
+            return id == other.id;
         }
 
+        /**
+         * @brief Compare the names of this and @p other (of the same type) without rendering or copying them, fresh
+         * variables are ordered after the other terms by their prefixes and numbers.
+         */
+        [[nodiscard]] bool name_less(const BasicTerm& other) const;
+
         [[nodiscard]] std::string to_string() const;
 
         struct HashFunction {
             size_t operator() (const BasicTerm& basic_term) const {
-                size_t row_hash = std::hash<BasicTermType>()(basic_term.type);
-                size_t col_hash = basic_term.name.hash() << 1;
-                return row_hash ^ col_hash;
+                return std::hash<unsigned>()(basic_term.id);
             }
         };
 
+        struct FreshPrefix;
+
+        /**
+         * @brief Scope of the table of interned terms (e.g. of a session of the string solver). The table and the
+         * cache of the current thread are released when the last live scope ends. Terms created before must not
+         * be compared with the terms created after the release, which get new ids.
+         */
+        class InternScope {
+        public:
+            InternScope();
+            ~InternScope();
+            InternScope(const InternScope&) = delete;
+            InternScope& operator=(const InternScope&) = delete;
+        };
+
     private:
         BasicTermType type;
-        // name of the variable, or the given literal
+        // name of the variable, or the given literal (empty for fresh variables)
         zstring name;
+        // interned id of the pair (type, name), or the id given to a fresh variable
+        unsigned id;
+        // prefix of the name of a fresh variable (nullptr for other terms) and the number of the variable
+        const FreshPrefix* fresh_prefix = nullptr;
+        unsigned fresh_number = 0;
+
+        BasicTerm(const FreshPrefix* prefix, unsigned number, unsigned id) : type(BasicTermType::Variable), id(id), fresh_prefix(prefix), fresh_number(number) {}
+
+        zstring render_fresh_name() const;
+
+        /**
+         * @brief Get the id of the pair (@p type, @p name), a new one is created if the pair was not seen yet.
+         */
+        static unsigned intern(BasicTermType type, const zstring& name);
     }; // Class BasicTerm.
 
     [[nodiscard]] static std::string to_string(const BasicTerm& basic_term) {
@@ -112,16 +173,17 @@ namespace smt::noodler {
     static bool operator==(const BasicTerm& lhs, const BasicTerm& rhs) { return lhs.equals(rhs); }
     static bool operator!=(const BasicTerm& lhs, const BasicTerm& rhs) { return !(lhs == rhs); }
     static bool operator<(const BasicTerm& lhs, const BasicTerm& rhs) {
+        // the order is given by names (not ids), so it does not depend on the order in which terms were created
+        if (lhs.get_id() == rhs.get_id()) {
+            return false;
+        }
         if (lhs.get_type() < rhs.get_type()) {
             return true;
         } else if (lhs.get_type() > rhs.get_type()) {
             return false;
         }
         // Types are equal. Compare names.
-        if (lhs.get_name() < rhs.get_name()) {
-            return true;
-        }
-        return false;
+        return lhs.name_less(rhs);
     }
     static bool operator>(const BasicTerm& lhs, const BasicTerm& rhs) { return !(lhs < rhs); }
 
@@ -130,6 +192,7 @@ namespace smt::noodler {
     enum struct LenFormulaType {
         PLUS,
         TIMES,
+        MOD, // (mod term divisor), the divisor is a positive integer literal
         EQ,
         NEQ, // not equal
         NOT,
@@ -150,7 +213,7 @@ namespace smt::noodler {
         LenNode(rational k) : type(LenFormulaType::LEAF), atom_val(BasicTermType::Length, zstring(k)), succ() { };
         LenNode(int k) : LenNode(rational(k)) { };
         LenNode(BasicTerm val) : type(LenFormulaType::LEAF), atom_val(val), succ() { };
-        LenNode(LenFormulaType tp, std::vector<struct LenNode> s = {}) : type(tp), atom_val(BasicTerm(BasicTermType::Length)), succ(s) { };
+        LenNode(LenFormulaType tp, std::vector<struct LenNode> s = {}) : type(tp), atom_val(BasicTerm(BasicTermType::Length)), succ(std::move(s)) { };
     };
 
     static std::ostream& operator<<(std::ostream& os, const LenNode& node) {
@@ -178,6 +241,9 @@ namespace smt::noodler {
         case LenFormulaType::TIMES:
             os << "(*";
             break;
+        case LenFormulaType::MOD:
+            os << "(mod";
+            break;
         case LenFormulaType::AND:
             os << "(and";
             break;
@@ -209,14 +275,12 @@ namespace smt::noodler {
         explicit Predicate(const PredicateType type): type(type) {
             if (is_equation() || is_inequation()) {
                 params.resize(2);
-                params.emplace_back();
-                params.emplace_back();
             }
         }
 
         explicit Predicate(const PredicateType type, std::vector<std::vector<BasicTerm>> par):
             type(type),
-            params(par)
+            params(std::move(par))
             { }
 
         [[nodiscard]] PredicateType get_type() const { return type; }
@@ -347,6 +411,22 @@ namespace smt::noodler {
             return Predicate{ type, { get_right_side(), get_left_side() } };
         }
 
+        /**
+         * @brief Switch the sides of the (in)equation in place (without copying the sides).
+         */
+        void switch_sides() {
+            assert(is_eq_or_ineq());
+            std::swap(params[0], params[1]);
+        }
+
+        /**
+         * @brief Does @p concat contain @p find (as a continuous subsequence)? An empty @p find is contained in
+         * every concatenation.
+         */
+        static bool contains_concat(const std::vector<BasicTerm>& concat, const std::vector<BasicTerm>& find) {
+            return std::search(concat.begin(), concat.end(), find.begin(), find.end()) != concat.end() || find.empty();
+        }
+
         /**
          * @brief Replace BasicTerm @p find in the given concatenation
          *
@@ -362,8 +442,9 @@ namespace smt::noodler {
                 const std::vector<BasicTerm>& replace,
                 std::vector<BasicTerm>& res) {
             bool modif = false;
+            res.reserve(res.size() + concat.size());
             for(auto it = concat.begin(); it != concat.end(); ) {
-                if(std::equal(it, it+find.size(), find.begin(), find.end())) {
+                if(!find.empty() && static_cast<size_t>(concat.end() - it) >= find.size() && std::equal(it, it+find.size(), find.begin(), find.end())) {
                     res.insert(res.end(), replace.begin(), replace.end());
                     modif = true;
                     it += find.size();
@@ -384,16 +465,20 @@ namespace smt::noodler {
          * @return Does the predicate contain at least one occurrence of @p find ?
          */
         bool replace(const std::vector<BasicTerm>& find, const std::vector<BasicTerm>& replace, Predicate& res) const {
+            // the predicates are scanned first, so that no sides are built for predicates without an occurrence
+            if(find.empty() || std::none_of(this->params.begin(), this->params.end(), [&](const std::vector<BasicTerm>& p) { return contains_concat(p, find); })) {
+                res = *this;
+                return false;
+            }
             std::vector<std::vector<BasicTerm>> new_params;
-            bool modif = false;
+            new_params.reserve(this->params.size());
             for(const std::vector<BasicTerm>& p : this->params) {
                 std::vector<BasicTerm> res_vec;
-                bool r = Predicate::replace_concat(p, find, replace, res_vec);
-                new_params.push_back(res_vec);
-                modif = modif || r;
+                Predicate::replace_concat(p, find, replace, res_vec);
+                new_params.push_back(std::move(res_vec));
             }
-            res = Predicate(this->type, new_params);
-            return modif;
+            res = Predicate(this->type, std::move(new_params));
+            return true;
         }
 
         /**
@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "formula_preprocess.h"
 #include "util.h"
 
@@ -28,14 +30,89 @@ namespace smt::noodler {
      * @param index Index of the given equation @p pred.
      */
     void FormulaVar::update_varmap(const Predicate& pred, size_t index) {
+        if(this->generations.size() <= index) {
+            this->generations.resize(index + 1, 0);
+        }
         for(const VarNode& vr : get_var_positions(pred, index, true)) {
-            VarMap::iterator iter = this->varmap.find(vr.term);
-            if(iter != this->varmap.end()) {
-                iter->second.insert(vr);
-            } else {
-                this->varmap[vr.term] = std::set<VarNode>({vr});
+            VarOccurr& occurr = this->varmap[vr.term];
+            occurr.compact = occurr.compact && (occurr.nodes.empty() || occurr.nodes.back() < vr);
+            occurr.nodes.push_back(vr);
+            occurr.generations.push_back(this->generations[index]);
+        }
+    }
+
+    /**
+     * @brief Remove tombstones from @p occurr and sort its occurrences.
+     *
+     * @param occurr Occurrences of a single term
+     */
+    void FormulaVar::compact(VarOccurr& occurr) const {
+        if(occurr.compact) {
+            return;
+        }
+        size_t live = 0;
+        for(size_t i = 0; i < occurr.nodes.size(); i++) {
+            if(occurr.generations[i] == this->generations[occurr.nodes[i].eq_index]) {
+                occurr.nodes[live] = occurr.nodes[i];
+                live++;
             }
         }
+        occurr.nodes.erase(occurr.nodes.begin() + live, occurr.nodes.end());
+        std::sort(occurr.nodes.begin(), occurr.nodes.end());
+        // live occurrences have the current generation of their predicate index
+        occurr.generations.resize(live);
+        for(size_t i = 0; i < live; i++) {
+            occurr.generations[i] = this->generations[occurr.nodes[i].eq_index];
+        }
+        occurr.dead = 0;
+        occurr.compact = true;
+    }
+
+    /**
+     * @brief Get occurrences of @p var in the formula sorted w.r.t. VarNode ordering.
+     *
+     * @param var Variable (or literal) occurring in the formula (it has to be present in the formula
+     * sometime before, otherwise std::out_of_range is thrown)
+     * @return Occurrences of @p var
+     */
+    const std::vector<VarNode>& FormulaVar::get_var_occurr(const BasicTerm& var) const {
+        VarOccurr& occurr = this->varmap.at(var);
+        compact(occurr);
+        return occurr.nodes;
+    }
+
+    /**
+     * @brief Get the number of occurrences of @p var in the formula (0 if it does not occur).
+     */
+    size_t FormulaVar::get_num_occurr(const BasicTerm& var) const {
+        auto iter = this->varmap.find(var);
+        return iter == this->varmap.end() ? 0 : iter->second.size();
+    }
+
+    /**
+     * @brief Get a snapshot of the occurrences of all terms (including terms without occurrences, which were not
+     * removed by clean_varmap()).
+     */
+    VarMap FormulaVar::get_varmap() const {
+        VarMap ret;
+        for(auto& [term, occurr] : this->varmap) {
+            compact(occurr);
+            ret[term] = occurr.nodes;
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Get all terms (variables and literals) occurring in the formula.
+     */
+    std::vector<BasicTerm> FormulaVar::get_vars() const {
+        std::vector<BasicTerm> ret;
+        for(const auto& [term, occurr] : this->varmap) {
+            if(occurr.size() > 0) {
+                ret.push_back(term);
+            }
+        }
+        return ret;
     }
 
     /**
@@ -86,7 +163,7 @@ namespace smt::noodler {
         for(const auto& item : this->predicates) {
             ret += std::to_string(item.first) + ": " + item.second.to_string() + "\n";
         }
-        for(const auto& item : this->varmap) {
+        for(const auto& item : get_varmap()) {
             std::string st;
             if(!item.second.empty()) {
                 st = item.second.begin()->to_string();
@@ -175,7 +252,13 @@ namespace smt::noodler {
      * In other words remove items from varmap s.t. (x, {}).
      */
     void FormulaVar::clean_varmap() {
-        remove_if(this->varmap, [](const auto& n) { return n.second.size() == 0; });
+        for(auto it = this->varmap.begin(); it != this->varmap.end(); ) {
+            if(it->second.size() == 0) {
+                it = this->varmap.erase(it);
+            } else {
+                ++it;
+            }
+        }
     };
 
     /**
@@ -185,15 +268,23 @@ namespace smt::noodler {
      * @param index Index of the predicate to be removed.
      */
     void FormulaVar::remove_predicate(size_t index) {
-        std::set<BasicTerm> items = this->predicates[index].get_set();
-
-        const auto& filter = [&index](const VarNode& n) { return n.eq_index == index; };
-        for(const BasicTerm& v : items) {
-            std::set<VarNode>& occurr = this->varmap[v];
-            remove_if(occurr, filter);
+        // occurrences of the predicate become tombstones (by changing the generation of the index), which are erased
+        // during the compaction, either on access or when they form the majority of the occurrences
+        if(this->generations.size() <= index) {
+            this->generations.resize(index + 1, 0);
+        }
+        this->generations[index]++;
+        for(const VarNode& vr : get_var_positions(this->predicates[index], index, true)) {
+            VarOccurr& occurr = this->varmap[vr.term];
+            occurr.dead++;
+            occurr.compact = false;
+            if(2*occurr.dead > occurr.nodes.size()) {
+                compact(occurr);
+            }
         }
         this->allpreds.erase(this->predicates[index]);
         this->predicates.erase(index);
+        ++this->version;
     }
 
     /**
@@ -223,6 +314,7 @@ namespace smt::noodler {
         this->predicates[index] = pred;
         this->allpreds.insert(pred);
         update_varmap(pred, size_t(index));
+        ++this->version;
         return index;
     }
 
@@ -245,11 +337,29 @@ namespace smt::noodler {
      */
     void FormulaVar::replace(const Concat& find, const Concat& replace) {
         std::vector<std::pair<size_t, Predicate>> replace_map;
-        for(const auto& pr : this->predicates) {
+        const auto& replace_in = [&](size_t index) {
+            const Predicate& pred = this->predicates.at(index);
             Predicate rpl;
-            if(pr.second.replace(find, replace, rpl)) { // changed, result is stored in rpl
-                assert(rpl != pr.second);
-                replace_map.push_back({pr.first, std::move(rpl)});
+            if(pred.replace(find, replace, rpl)) { // changed, result is stored in rpl
+                assert(rpl != pred);
+                replace_map.push_back({index, std::move(rpl)});
+            }
+        };
+        if(find.empty()) {
+            for(const auto& pr : this->predicates) {
+                replace_in(pr.first);
+            }
+        } else {
+            // only predicates containing the first term of find can be changed
+            if(this->varmap.find(find[0]) == this->varmap.end()) {
+                return;
+            }
+            std::set<size_t> indices;
+            for(const VarNode& vr : get_var_occurr(find[0])) {
+                indices.insert(vr.eq_index);
+            }
+            for(size_t index : indices) {
+                replace_in(index);
             }
         }
         for(const auto& pr : replace_map) {
@@ -285,8 +395,7 @@ namespace smt::noodler {
         mata::nfa::Nfa concat = this->aut_ass.get_automaton_concat(upd);
         auto iter = this->aut_ass.find(var);
         if(iter != this->aut_ass.end()) {
-            mata::nfa::Nfa inters = mata::nfa::intersection(*(iter->second), concat);
-            inters.trim();
+            mata::nfa::Nfa inters = intersect(*(iter->second), concat);
             if(this->m_params.m_preprocess_red) {
                 this->aut_ass[var] = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(inters));
             } else {
@@ -297,6 +406,50 @@ namespace smt::noodler {
         }
     }
 
+    /**
+     * @brief Get the (upper bound of) size of the automaton for the concatenation @p concat.
+     */
+    FormulaPreprocessor::AutSize FormulaPreprocessor::get_concat_size(const Concat& concat) const {
+        AutSize res{ 1, 0 };
+        for(const BasicTerm& t : concat) {
+            AutSize size = get_aut_size(*this->aut_ass.at(t));
+            res.first += size.first;
+            res.second += size.second + size.first; // epsilon-free concatenation may add transitions
+        }
+        return res;
+    }
+
+    /**
+     * @brief Predict the size of the complement of @p aut. The complement of a deterministic automaton has at
+     * most one more state, for nondeterministic automata the subset construction is estimated to be quadratic
+     * (the worst case is exponential, but it is rare in practice).
+     */
+    FormulaPreprocessor::AutSize FormulaPreprocessor::predict_complement(const mata::nfa::Nfa& aut) {
+        AutSize size = get_aut_size(aut);
+        if(aut.is_deterministic()) {
+            // completion adds a sink state with transitions to it
+            return { size.first + 1, size.second + size.first + 1 };
+        }
+        return { size.first * size.first, size.second * size.first };
+    }
+
+    /**
+     * @brief Decide whether an optional automata operation with the result of predicted size @p predicted_size
+     * should be done, i.e., whether the predicted number of states and transitions is at most m_params.m_prep_size_limit
+     * (0 means no limit).
+     *
+     * @param pass Name of the pass for logging
+     * @return true -> the operation can be done
+     */
+    bool FormulaPreprocessor::allow_aut_operation(const AutSize& predicted_size, const char* pass) {
+        if(this->m_params.m_prep_size_limit == 0 || predicted_size.first + predicted_size.second <= this->m_params.m_prep_size_limit) {
+            return true;
+        }
+        STRACE("str-prep", tout << pass << ": skipping operation with predicted size (" << predicted_size.first << ", " << predicted_size.second << ")" << std::endl;);
+        this->num_gated_ops++;
+        return false;
+    }
+
     /**
      * Iteratively remove regular predicates. A regular predicate is of the form X = X_1 X_2 ... X_n where
      * X_1 ... X_n does not occurr elsewhere in the system. Formally, L = R is regular if |L| = 1 and each variable
@@ -346,7 +499,7 @@ namespace smt::noodler {
             // check if by removing the regular equation, some other equations did not become regular
             // we only need to check this for left_var, as the variables from the right side do not occur
             // in the formula anymore (they occured only in pr)
-            std::set<VarNode> occurrs = this->formula.get_var_occurr(left_var);
+            const std::vector<VarNode>& occurrs = this->formula.get_var_occurr(left_var);
             if(occurrs.size() == 1) {
                 Predicate reg_pred;
                 if(this->formula.is_side_regular(this->formula.get_predicate(occurrs.begin()->eq_index), reg_pred)) {
@@ -383,7 +536,7 @@ namespace smt::noodler {
             }
 
             if(!eq.get_left_side()[0].is_variable()) {
-                eq = eq.get_switched_sides_predicate();
+                eq.switch_sides();
             }
             if(!eq.get_left_side()[0].is_variable()) {
                 continue;
@@ -503,44 +656,58 @@ namespace smt::noodler {
         std::set<size_t> rem_ids;
         size_t index = this->formula.get_max_index() + 1;
 
-        for(const auto& pr1 : this->formula.get_predicates()) {
-            if(!pr1.second.is_equation())
+        // only pairs of equations sharing a side (and single equations) can generate an identity, so we index
+        // equations by their sides instead of checking all pairs; the pairs are processed in the lexicographic order
+        std::map<Concat, std::vector<size_t>> side_index;
+        std::set<std::pair<size_t, size_t>> pairs;
+        for(const auto& pr : this->formula.get_predicates()) {
+            if(!pr.second.is_equation())
                 continue;
-            for(const auto& pr2 : this->formula.get_predicates()) {
-                if(!pr2.second.is_equation())
-                    continue;
-                if(pr1.first > pr2.first)
-                    continue;
-
-                VarNodeSymDiff diff;
-                if(pr1.first == pr2.first) { // two equations are the same
-                    diff = get_eq_sym_diff(pr1.second.get_left_side(), pr1.second.get_right_side());
-                // L1 = R1 and L2 = R2 and L1 = L2 => R1 = R2
-                } else if(pr1.second.get_left_side() == pr2.second.get_left_side()) {
-                    diff = get_eq_sym_diff(pr1.second.get_right_side(), pr2.second.get_right_side());
-                // L1 = R1 and L2 = R2 and L1 = R2 => R1 = L2
-                } else if(pr1.second.get_left_side() == pr2.second.get_right_side()) {
-                    diff = get_eq_sym_diff(pr1.second.get_right_side(), pr2.second.get_left_side());
-                // L1 = R1 and L2 = R2 and R1 = L2 => L2 = R1
-                } else if(pr1.second.get_right_side() == pr2.second.get_left_side()) {
-                    diff = get_eq_sym_diff(pr1.second.get_left_side(), pr2.second.get_right_side());
-                // L1 = R1 and L2 = R2 and R1 = R2 => L1 = L2
-                } else if(pr1.second.get_right_side() == pr2.second.get_right_side()) {
-                    diff = get_eq_sym_diff(pr1.second.get_left_side(), pr2.second.get_left_side());
+            pairs.insert({pr.first, pr.first});
+            side_index[pr.second.get_left_side()].push_back(pr.first);
+            if(pr.second.get_right_side() != pr.second.get_left_side()) {
+                side_index[pr.second.get_right_side()].push_back(pr.first);
+            }
+        }
+        for(const auto& [side, indices] : side_index) {
+            for(size_t i = 0; i < indices.size(); i++) {
+                for(size_t j = i + 1; j < indices.size(); j++) {
+                    pairs.insert(std::minmax(indices[i], indices[j]));
                 }
+            }
+        }
 
-                Predicate new_pred;
-                if(generate_identities_suit(diff, new_pred) && new_pred != pr1.second && new_pred != pr2.second) {
-                    new_preds.insert({index, new_pred});
-                    /// It assumes L = A B X; L = A B Y1 Y2 ... 
-                    /// diff.first should contain X; diff.second Y1 Y2
-                    if(diff.first.size() == 1) { // if a new predicate is of the form X = Y1 Y2 ... 
-                        rem_ids.insert(pr2.first); // remove L = A B Y1 Y2
-                    } else {
-                        rem_ids.insert(pr1.first);
-                    }
-                    index++;
+        for(const auto& [index1, index2] : pairs) {
+            const Predicate& pred1 = this->formula.get_predicate(index1);
+            const Predicate& pred2 = this->formula.get_predicate(index2);
+            VarNodeSymDiff diff;
+            if(index1 == index2) { // two equations are the same
+                diff = get_eq_sym_diff(pred1.get_left_side(), pred1.get_right_side());
+            // L1 = R1 and L2 = R2 and L1 = L2 => R1 = R2
+            } else if(pred1.get_left_side() == pred2.get_left_side()) {
+                diff = get_eq_sym_diff(pred1.get_right_side(), pred2.get_right_side());
+            // L1 = R1 and L2 = R2 and L1 = R2 => R1 = L2
+            } else if(pred1.get_left_side() == pred2.get_right_side()) {
+                diff = get_eq_sym_diff(pred1.get_right_side(), pred2.get_left_side());
+            // L1 = R1 and L2 = R2 and R1 = L2 => L2 = R1
+            } else if(pred1.get_right_side() == pred2.get_left_side()) {
+                diff = get_eq_sym_diff(pred1.get_left_side(), pred2.get_right_side());
+            // L1 = R1 and L2 = R2 and R1 = R2 => L1 = L2
+            } else if(pred1.get_right_side() == pred2.get_right_side()) {
+                diff = get_eq_sym_diff(pred1.get_left_side(), pred2.get_left_side());
+            }
+
+            Predicate new_pred;
+            if(generate_identities_suit(diff, new_pred) && new_pred != pred1 && new_pred != pred2) {
+                new_preds.insert({index, new_pred});
+                /// It assumes L = A B X; L = A B Y1 Y2 ... 
+                /// diff.first should contain X; diff.second Y1 Y2
+                if(diff.first.size() == 1) { // if a new predicate is of the form X = Y1 Y2 ... 
+                    rem_ids.insert(index2); // remove L = A B Y1 Y2
+                } else {
+                    rem_ids.insert(index1);
                 }
+                index++;
             }
         }
         for(const size_t & i : rem_ids) {
@@ -593,24 +760,25 @@ namespace smt::noodler {
         for(const BasicTerm& t : graph.get_init_vars()) {
             Concat sub;
             // Get all occurrences of t
-            std::set<VarNode> occurrs = this->formula.get_var_occurr(t);
+            const std::vector<VarNode>& occurrs = this->formula.get_var_occurr(t);
             // Get predicate of a first equation containing t; and side containing t
             Predicate act_pred = this->formula.get_predicate(occurrs.begin()->eq_index);
             Concat side = occurrs.begin()->position > 0 ? act_pred.get_right_side() : act_pred.get_left_side();
 
             int start = std::abs(occurrs.begin()->position) - 1;
             for(int i = start; i < side.size(); i++) {
-                std::set<VarNode> vns;
-                // Construct the set of supposed occurences of the symbol side[i]
+                std::vector<VarNode> vns;
+                // Construct the (sorted) set of supposed occurences of the symbol side[i]
                 for(const VarNode& vn : occurrs) {
-                    vns.insert({
+                    vns.emplace_back(
                         side[i],
                         vn.eq_index,
                         FormulaVar::increment_side_index(vn.position, i-start)
-                    });
+                    );
                 }
+                std::sort(vns.begin(), vns.end());
                 // Compare the supposed occurrences with real occurrences.
-                std::set<VarNode> occurs_act = this->formula.get_var_occurr(side[i]);
+                const std::vector<VarNode>& occurs_act = this->formula.get_var_occurr(side[i]);
 
                 // do not include length variables
                 if(false && this->len_variables.find(side[i]) != this->len_variables.end()) {
@@ -667,15 +835,15 @@ namespace smt::noodler {
      * @param res All terms with epsilon semantics.
      */
     void FormulaPreprocessor::get_eps_terms(std::set<BasicTerm>& res) const {
-        for(const auto& pr : get_formula().get_varmap()) {
-            if(pr.first.is_variable() && is_var_eps(pr.first)) {
-                res.insert(pr.first);
+        for(const BasicTerm& t : get_formula().get_vars()) {
+            if(t.is_variable() && is_var_eps(t)) {
+                res.insert(t);
             }
-            if(pr.first.is_literal() && pr.first.get_name() == "") {
-                res.insert(pr.first);
+            if(t.is_literal() && t.get_name() == "") {
+                res.insert(t);
             }
-            if(pr.first.is_literal() && this->aut_ass.is_epsilon(pr.first) ) {
-                res.insert(pr.first);
+            if(t.is_literal() && this->aut_ass.is_epsilon(t) ) {
+                res.insert(t);
             }
 
         }
@@ -693,7 +861,7 @@ namespace smt::noodler {
 
         // get indices of equations containing at least one eps term
         for(const BasicTerm& t : eps_set) {
-            std::set<VarNode> nds = get_formula().get_var_occurr(t);
+            const std::vector<VarNode>& nds = get_formula().get_var_occurr(t);
             std::transform(nds.begin(), nds.end(), std::back_inserter(worklist),
                 [](const VarNode& n){ return n.eq_index ; });
         }
@@ -722,7 +890,7 @@ namespace smt::noodler {
 
             for(const BasicTerm& t : new_eps) {
                 eps_set.insert(t);
-                std::set<VarNode> nds = get_formula().get_var_occurr(t);
+                const std::vector<VarNode>& nds = get_formula().get_var_occurr(t);
                 std::transform(nds.begin(), nds.end(), std::back_inserter(worklist),
                     [](const VarNode& n){ return n.eq_index ; });
             }
@@ -853,17 +1021,15 @@ namespace smt::noodler {
      */
     void FormulaPreprocessor::gather_extended_vars(Predicate::EquationSideType side, std::set<BasicTerm>& res) {
         mata::nfa::Nfa sigma_star = this->aut_ass.sigma_star_automaton();
-        for(const auto& pr : this->formula.get_varmap()) {
-            if(pr.second.size() > 0) {
-                mata::nfa::Nfa concat;
-                if(side == Predicate::EquationSideType::Left)
-                    concat = mata::nfa::concatenate(sigma_star, *(this->aut_ass.at(pr.first)));
-                else
-                    concat = mata::nfa::concatenate(*(this->aut_ass.at(pr.first)), sigma_star);
-
-                if(mata::nfa::are_equivalent(*(this->aut_ass.at(pr.first)), concat)) {
-                    res.insert(pr.first);
-                }
+        for(const BasicTerm& t : this->formula.get_vars()) {
+            mata::nfa::Nfa concat;
+            if(side == Predicate::EquationSideType::Left)
+                concat = mata::nfa::concatenate(sigma_star, *(this->aut_ass.at(t)));
+            else
+                concat = mata::nfa::concatenate(*(this->aut_ass.at(t)), sigma_star);
+
+            if(mata::nfa::are_equivalent(*(this->aut_ass.at(t)), concat)) {
+                res.insert(t);
             }
         }
     }
@@ -881,13 +1047,13 @@ namespace smt::noodler {
 
         using ExtVarMap = std::map<BasicTerm, std::vector<BasicTerm>>;
         ExtVarMap b_map, e_map;
-        VarMap varmap = this->formula.get_varmap();
+        const FormulaVar& formula = this->formula;
 
-        auto flt = [&varmap](ExtVarMap& mp) {
+        auto flt = [&formula](ExtVarMap& mp) {
             std::map<BasicTerm,BasicTerm> ret;
             for(const auto& pr : mp) {
                 std::set<BasicTerm> sing(pr.second.begin(), pr.second.end());
-                if(varmap[pr.first].size() == pr.second.size() && sing.size() == 1) {
+                if(formula.get_num_occurr(pr.first) == pr.second.size() && sing.size() == 1) {
                     ret.insert({pr.first, *sing.begin()});
                 }
             }
@@ -905,7 +1071,7 @@ namespace smt::noodler {
             if(left.size() == 1 && right.size() > 1) {
                 if(right[0].is_variable() && left[0].is_variable()
                     && right[1].is_variable() && begin_star.find(right[1]) != begin_star.end()
-                    && varmap[right[1]].size() == 1
+                    && this->formula.get_num_occurr(right[1]) == 1
                     && this->len_variables.find(right[0]) == this->len_variables.end()
                     && this->len_variables.find(right[1]) == this->len_variables.end() ) {
                     b_map.insert({right[0], {}});
@@ -913,7 +1079,7 @@ namespace smt::noodler {
                 }
                 if(right[right.size()-1].is_variable() && left[0].is_variable()
                     && right[right.size()-2].is_variable() && end_star.find(right[right.size()-2]) != end_star.end()
-                    && varmap[right[right.size()-2]].size() == 1
+                    && this->formula.get_num_occurr(right[right.size()-2]) == 1
                     && this->len_variables.find(right[right.size()-1]) == this->len_variables.end()
                     && this->len_variables.find(right[right.size()-2]) == this->len_variables.end() ) {
                     e_map.insert({right[right.size()-1], {}});
@@ -1022,6 +1188,83 @@ namespace smt::noodler {
         return ret;
     }
 
+    /**
+     * @brief Fingerprint of the preprocessed instance (see the declaration).
+     *
+     * @return Versions of the formula, the automata assignment, the length variables and the length formula.
+     */
+    std::array<size_t, 4> FormulaPreprocessor::get_fingerprint() const {
+        // automata and length variables are in unordered containers, so their hashes are combined commutatively
+        size_t aut_hash = this->aut_ass.size();
+        for (const auto& [var, aut] : this->aut_ass) {
+            aut_hash += BasicTerm::HashFunction()(var) ^ (std::hash<const mata::nfa::Nfa*>()(aut.get()) * 0x9e3779b97f4a7c15ULL);
+        }
+        size_t len_hash = this->len_variables.size();
+        for (const BasicTerm& var : this->len_variables) {
+            len_hash += BasicTerm::HashFunction()(var) * 0x9e3779b97f4a7c15ULL;
+        }
+        return { this->formula.get_version(), aut_hash, len_hash, this->len_formula.succ.size() };
+    }
+
+    /**
+     * @brief Get the sum of the numbers of states of automata in the automata assignment.
+     */
+    size_t FormulaPreprocessor::get_num_aut_states() const {
+        size_t res = 0;
+        for(const auto& pr : this->aut_ass) {
+            res += pr.second->num_of_states();
+        }
+        return res;
+    }
+
+    PreprocessProfile::PassProfile& PreprocessProfile::get(const std::string& name) {
+        auto [it, inserted] = this->passes.try_emplace(name);
+        if(inserted) {
+            this->order.push_back(name);
+            it->second.runs_key = "str prep " + name + " runs";
+            it->second.time_key = "str prep " + name + " time";
+            it->second.predicates_key = "str prep " + name + " predicates delta";
+            it->second.states_key = "str prep " + name + " states delta";
+        }
+        return it->second;
+    }
+
+    std::string PreprocessProfile::summary() const {
+        std::stringstream res;
+        for(const std::string& name : this->order) {
+            const PassProfile& pass = this->passes.at(name);
+            res << (&name == &this->order.front() ? "" : "; ") << name << ": runs " << pass.runs << ", skipped " << pass.skipped
+                << ", time " << pass.time << "s, predicates " << pass.predicates_delta << ", vars " << pass.vars_delta
+                << ", states " << pass.states_delta;
+        }
+        return res.str();
+    }
+
+    /**
+     * @brief Run the pass @p pass named @p name and record its profile (time and changes of the instance).
+     */
+    void PreprocessScheduler::run_profiled(const std::string& name, const std::function<void(FormulaPreprocessor&)>& pass) {
+        auto count_vars = [this]() {
+            auto terms = this->prep.get_formula().get_vars();
+            return std::count_if(terms.begin(), terms.end(), [](const BasicTerm& t) { return t.is_variable(); });
+        };
+        double predicates_before = this->prep.get_formula().get_predicates().size();
+        double vars_before = count_vars();
+        double states_before = this->prep.get_num_aut_states();
+
+        stopwatch watch;
+        watch.start();
+        pass(this->prep);
+        watch.stop();
+
+        PreprocessProfile::PassProfile& pass_profile = this->profile->get(name);
+        ++pass_profile.runs;
+        pass_profile.time += watch.get_seconds();
+        pass_profile.predicates_delta += this->prep.get_formula().get_predicates().size() - predicates_before;
+        pass_profile.vars_delta += count_vars() - vars_before;
+        pass_profile.states_delta += this->prep.get_num_aut_states() - states_before;
+    }
+
     /**
      * @brief Refine languages for equations of the form X = R (|X|=1) to the L(X) = L(X) \cap L(R).
      * Moreover, for the literal terms l from the current automata assignments, restrict its 
@@ -1029,6 +1272,11 @@ namespace smt::noodler {
      * variables but also literals.
      */
     void FormulaPreprocessor::refine_languages() {
+        // the refinement is optional, it is skipped if the intersection is predicted to be too big
+        auto allow_refinement = [this](const BasicTerm& var, const Concat& side) {
+            AutSize var_size = this->aut_ass.find(var) != this->aut_ass.end() ? get_aut_size(*this->aut_ass.at(var)) : AutSize{ 1, 0 };
+            return allow_aut_operation(predict_intersection(var_size, get_concat_size(side)), "refine_languages");
+        };
         std::set<BasicTerm> ineq_vars;
         for(const auto& pr : this->formula.get_predicates()) {
             if(!pr.second.is_inequation())
@@ -1048,17 +1296,13 @@ namespace smt::noodler {
 
             if(pr.second.get_left_side().size() == 1) {
                 BasicTerm var = pr.second.get_left_side()[0];
-                if(ineq_vars.find(var) != ineq_vars.end()) {
-                    update_reg_constr(var, pr.second.get_right_side());
-                } else if(pr.second.get_right_side().size() == 1) {
+                if((ineq_vars.find(var) != ineq_vars.end() || pr.second.get_right_side().size() == 1) && allow_refinement(var, pr.second.get_right_side())) {
                     update_reg_constr(var, pr.second.get_right_side());
                 }
             }
             if(pr.second.get_right_side().size() == 1) {
                 BasicTerm var = pr.second.get_right_side()[0];
-                if(ineq_vars.find(var) != ineq_vars.end()) {
-                    update_reg_constr(var, pr.second.get_left_side());
-                } else if(pr.second.get_left_side().size() == 1) {
+                if((ineq_vars.find(var) != ineq_vars.end() || pr.second.get_left_side().size() == 1) && allow_refinement(var, pr.second.get_left_side())) {
                     update_reg_constr(var, pr.second.get_left_side());
                 }
             }
@@ -1070,8 +1314,7 @@ namespace smt::noodler {
         for(const auto& pr : this->aut_ass) {
             if(pr.first.is_literal()) {
                 mata::nfa::Nfa word_aut = AutAssignment::create_word_nfa(pr.first.get_name());
-                mata::nfa::Nfa inters = mata::nfa::intersection(*(pr.second), word_aut);
-                inters.trim();
+                mata::nfa::Nfa inters = intersect(*(pr.second), word_aut);
                 this->aut_ass[pr.first] = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(inters));
             }
         }
@@ -1125,6 +1368,8 @@ namespace smt::noodler {
     void FormulaPreprocessor::generate_equiv(const BasicTermEqiv& ec) {
         std::set<Predicate> new_preds;
         size_t index = this->formula.get_max_index() + 1;
+        // the classes are indexed once, so that same_length does not search them
+        const BasicTermEqivIndex ec_index = ec_get_index(ec);
 
         for(const auto& pr1 : this->formula.get_predicates()) {
             if(!pr1.second.is_equation())
@@ -1138,12 +1383,12 @@ namespace smt::noodler {
                 Predicate pc1 = pr1.second;
                 Predicate pc2 = pr2.second;
                 if(pc1.get_left_side() == pc2.get_right_side()) {
-                    pc2 = pc2.get_switched_sides_predicate();
+                    pc2.switch_sides();
                 } else if(pc1.get_right_side() == pc2.get_left_side()) {
-                    pc1 = pc1.get_switched_sides_predicate();
+                    pc1.switch_sides();
                 } else if(pc1.get_right_side() == pc2.get_right_side()) {
-                    pc1 = pc1.get_switched_sides_predicate();
-                    pc2 = pc2.get_switched_sides_predicate();
+                    pc1.switch_sides();
+                    pc2.switch_sides();
                 } else if(pc1.get_left_side() == pc2.get_left_side()) {
                     // already set
                 } else {
@@ -1157,7 +1402,7 @@ namespace smt::noodler {
                     BasicTerm t2 = pc2.get_right_side()[i];
                     if(t1 == t2) {
                         continue;
-                    } else if(same_length(ec, t1, t2)) {
+                    } else if(same_length(ec_index, t1, t2)) {
                         Predicate new_pred(PredicateType::Equation, {Concat({t1}), Concat({t2})});
                         new_preds.insert(new_pred);
                     } else {
@@ -1171,7 +1416,7 @@ namespace smt::noodler {
                     BasicTerm t2 = pc2.get_right_side()[j];
                     if(t1 == t2) {
                         continue;
-                    } else if(same_length(ec, t1, t2)) {
+                    } else if(same_length(ec_index, t1, t2)) {
                         Predicate new_pred(PredicateType::Equation, {Concat({t1}), Concat({t2})});
                         new_preds.insert(new_pred);
                     } else {
@@ -1188,12 +1433,12 @@ namespace smt::noodler {
     /**
      * @brief Check if two languages of two terms have the same length.
      * 
-     * @param ec Equivalence class containing length-equivalent variables.
+     * @param ec Index of equivalence classes containing length-equivalent variables (see ec_get_index).
      * @param t1 Term1
      * @param t2 Term2
      * @return Equal length -> true
      */
-    bool FormulaPreprocessor::same_length(const BasicTermEqiv& ec, const BasicTerm&t1, const BasicTerm& t2) const {
+    bool FormulaPreprocessor::same_length(const BasicTermEqivIndex& ec, const BasicTerm&t1, const BasicTerm& t2) const {
         if(ec_are_equal(ec, t1, t2)) {
             return true;
         }
@@ -1474,6 +1719,10 @@ namespace smt::noodler {
     void FormulaPreprocessor::underapprox_languages() {
         for(const Predicate& pred : this->formula.get_predicates_set()) {
             for(const BasicTerm& var : pred.get_vars()) {
+                // checking co-finiteness needs the complement
+                if(!allow_aut_operation(predict_complement(*this->aut_ass.at(var)), "underapprox_languages")) {
+                    continue;
+                }
                 if(this->aut_ass.is_co_finite(var)) {
                     mata::nfa::Nfa aut_compl = this->aut_ass.complement_lang(var);
                     LenNode lengths = AutAssignment::get_lengths(aut_compl, var);
@@ -1495,9 +1744,13 @@ namespace smt::noodler {
             if(!pr.second.is_inequation())
                 continue;
 
+            // keeping the disequation is always sound, so it is kept if the reduction is predicted to be too expensive
+            if(!allow_aut_operation(predict_intersection(get_concat_size(pr.second.get_left_side()), get_concat_size(pr.second.get_right_side())), "reduce_diseqalities")) {
+                continue;
+            }
             mata::nfa::Nfa aut_left = this->aut_ass.get_automaton_concat(pr.second.get_left_side());
             mata::nfa::Nfa aut_right = this->aut_ass.get_automaton_concat(pr.second.get_right_side());
-            if(mata::nfa::intersection(aut_left, aut_right).is_lang_empty()) { // L(left) \cap L(right) == empty
+            if(intersect(aut_left, aut_right).is_lang_empty()) { // L(left) \cap L(right) == empty
                 rem_ids.insert(pr.first);
                 continue;
             }
@@ -1505,12 +1758,13 @@ namespace smt::noodler {
             if(pr.second.get_left_side().size() == 1 && pr.second.get_left_side()[0].is_variable()) {
                 BasicTerm var = pr.second.get_left_side()[0];
                 mata::nfa::Nfa other = this->aut_ass.get_automaton_concat(pr.second.get_right_side());
-                if(mata::nfa::intersection(*this->aut_ass.at(var), other).is_lang_empty()) {
+                if(intersect(*this->aut_ass.at(var), other).is_lang_empty()) {
                     rem_ids.insert(pr.first);
                     continue;
                 }
-                if(pr.second.get_right_side().size() < 1 || (pr.second.get_right_side().size() == 1 && pr.second.get_right_side()[0].is_literal())) {
-                    this->aut_ass[var] = std::make_shared<mata::nfa::Nfa>(mata::nfa::intersection(*this->aut_ass.at(var), this->aut_ass.complement_aut(other)));
+                if((pr.second.get_right_side().size() < 1 || (pr.second.get_right_side().size() == 1 && pr.second.get_right_side()[0].is_literal()))
+                    && allow_aut_operation(predict_intersection(get_aut_size(*this->aut_ass.at(var)), predict_complement(other)), "reduce_diseqalities")) {
+                    this->aut_ass[var] = std::make_shared<mata::nfa::Nfa>(intersect(*this->aut_ass.at(var), this->aut_ass.complement_aut(other)));
                     rem_ids.insert(pr.first);
                     continue;
                 }
@@ -1518,12 +1772,13 @@ namespace smt::noodler {
             if(pr.second.get_right_side().size() == 1 && pr.second.get_right_side()[0].is_variable()) {
                 BasicTerm var = pr.second.get_right_side()[0];
                 mata::nfa::Nfa other = this->aut_ass.get_automaton_concat(pr.second.get_left_side());
-                if(mata::nfa::intersection(*this->aut_ass.at(var), other).is_lang_empty()) {
+                if(intersect(*this->aut_ass.at(var), other).is_lang_empty()) {
                     rem_ids.insert(pr.first);
                     continue;
                 }
-                if(pr.second.get_left_side().size() < 1 || (pr.second.get_left_side().size() == 1 && pr.second.get_left_side()[0].is_literal())) {
-                    this->aut_ass[var] = std::make_shared<mata::nfa::Nfa>(mata::nfa::intersection(*this->aut_ass.at(var), this->aut_ass.complement_aut(other)));
+                if((pr.second.get_left_side().size() < 1 || (pr.second.get_left_side().size() == 1 && pr.second.get_left_side()[0].is_literal()))
+                    && allow_aut_operation(predict_intersection(get_aut_size(*this->aut_ass.at(var)), predict_complement(other)), "reduce_diseqalities")) {
+                    this->aut_ass[var] = std::make_shared<mata::nfa::Nfa>(intersect(*this->aut_ass.at(var), this->aut_ass.complement_aut(other)));
                     rem_ids.insert(pr.first);
                     continue;
                 }
@@ -1564,9 +1819,33 @@ namespace smt::noodler {
         return false;
     }
 
+    /**
+     * @brief Check if the literals @p lit1 and @p lit2 agree on their first (if @p from_start) or last
+     * min(|lit1|, |lit2|) symbols, i.e., if one of them can be a prefix (suffix) of the other one.
+     */
+    bool FormulaPreprocessor::literals_compatible(const BasicTerm& lit1, const BasicTerm& lit2, bool from_start) const {
+        if(this->literal_store != nullptr) {
+            // the hashes of the literals are computed once for the session
+            auto l1 = this->literal_store->get(lit1.get_name());
+            auto l2 = this->literal_store->get(lit2.get_name());
+            return from_start ? LiteralStore::prefix_compatible(*l1, *l2) : LiteralStore::suffix_compatible(*l1, *l2);
+        }
+        const zstring& val1 = lit1.get_name();
+        const zstring& val2 = lit2.get_name();
+        const unsigned n = std::min(val1.length(), val2.length());
+        for(unsigned i = 0; i < n; i++) {
+            if(from_start ? val1[i] != val2[i] : val1[val1.length() - 1 - i] != val2[val2.length() - 1 - i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /**
      * @brief Check if the instance is clearly unsatisfiable. It checks trivial (dis)equations
-     * of the form x != x, ab = cd (x is term, a,b,c,d are constants).
+     * of the form x != x, ab = cd (x is term, a,b,c,d are constants) and equations whose sides
+     * (or the right sides of two equations with the same variable on the left side) start (end)
+     * with literals none of which is a prefix (suffix) of the other one, e.g., "GET" x = "POST" y.
      * 
      * @return True --> unsat for sure.
      */
@@ -1574,6 +1853,17 @@ namespace smt::noodler {
         auto check = [](const Concat& c1, const Concat& c2) -> bool {
             return c1 == c2;
         };
+        // are the words of c1 and c2 clearly different because of their first or last literals?
+        auto literals_clash = [&](const Concat& c1, const Concat& c2) -> bool {
+            if(c1.empty() || c2.empty()) {
+                return false;
+            }
+            if(c1.front().is_literal() && c2.front().is_literal() && !literals_compatible(c1.front(), c2.front(), true)) {
+                return true;
+            }
+            return c1.back().is_literal() && c2.back().is_literal() && !literals_compatible(c1.back(), c2.back(), false);
+        };
+        std::map<BasicTerm, std::vector<const Concat*>> right_sides_of_var;
         for(const auto& pr : this->formula.get_predicates()) {            
             if(pr.second.is_inequation() && can_unify(pr.second.get_left_side(), pr.second.get_right_side(), check)) {
                 return true;
@@ -1588,6 +1878,22 @@ namespace smt::noodler {
                     right = right + t.get_name();
                 }
                 if(left != right) return true;
+            } else if(pr.second.is_equation()) {
+                if(literals_clash(pr.second.get_left_side(), pr.second.get_right_side())) {
+                    return true;
+                }
+                if(pr.second.get_left_side().size() == 1 && pr.second.get_left_side()[0].is_variable()) {
+                    right_sides_of_var[pr.second.get_left_side()[0]].push_back(&pr.second.get_right_side());
+                }
+            }
+        }
+        for(const auto& [var, right_sides] : right_sides_of_var) {
+            for(size_t i = 0; i < right_sides.size(); i++) {
+                for(size_t j = i + 1; j < right_sides.size(); j++) {
+                    if(literals_clash(*right_sides[i], *right_sides[j])) {
+                        return true;
+                    }
+                }
             }
         }
         return false;
@@ -1624,11 +1930,11 @@ namespace smt::noodler {
      */
     void FormulaPreprocessor::conversions_validity(std::vector<TermConversion>& conversions) {
         mata::nfa::Nfa sigma_aut = aut_ass.sigma_automaton();
-        mata::nfa::Nfa only_digits_aut = AutAssignment::digit_automaton();
+        const mata::nfa::Nfa& only_digits_aut = AutAssignment::digit_automaton();
 
         for (const auto& conv : conversions) {
-            if ((conv.type == ConversionType::TO_CODE && mata::nfa::reduce(mata::nfa::intersection(sigma_aut,       *aut_ass.at(conv.string_var))).is_lang_empty()) ||
-                (conv.type == ConversionType::TO_INT  && mata::nfa::reduce(mata::nfa::intersection(only_digits_aut, *aut_ass.at(conv.string_var))).is_lang_empty()))
+            if ((conv.type == ConversionType::TO_CODE && mata::nfa::reduce(intersect(sigma_aut,       *aut_ass.at(conv.string_var))).is_lang_empty()) ||
+                (conv.type == ConversionType::TO_INT  && mata::nfa::reduce(intersect(only_digits_aut, *aut_ass.at(conv.string_var))).is_lang_empty()))
                 {
                     len_formula.succ.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{conv.int_var, -1});
                 }
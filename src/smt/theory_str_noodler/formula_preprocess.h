@@ -7,14 +7,18 @@
 #include <set>
 #include <queue>
 #include <string>
+#include <array>
+#include <functional>
 
 #include <mata/nfa/nfa.hh>
 
 #include "util/trace.h"
+#include "util/stopwatch.h"
 #include "smt/params/theory_str_noodler_params.h"
 
 #include "formula.h"
 #include "aut_assignment.h"
+#include "literal_store.h"
 #include "var_union_find.h"
 #include "util.h"
 
@@ -228,7 +232,25 @@ namespace smt::noodler {
 
     //----------------------------------------------------------------------------------------------------------------------------------
 
-    using VarMap = std::map<BasicTerm, std::set<VarNode>>;
+    /**
+     * @brief Occurrences of a single term in FormulaVar stored contiguously. Occurrences in removed predicates
+     * are not erased immediately, they stay in @p nodes as tombstones (their generation differs from the current
+     * generation of the predicate index) and they are erased by FormulaVar::compact().
+     */
+    struct VarOccurr {
+        std::vector<VarNode> nodes;
+        // generation of the predicate index at the time the corresponding occurrence from nodes was added
+        std::vector<unsigned> generations;
+        // number of tombstones in nodes
+        size_t dead = 0;
+        // are nodes sorted (and free of tombstones)?
+        bool compact = true;
+
+        size_t size() const { return this->nodes.size() - this->dead; }
+    };
+
+    using OccurrIndex = std::unordered_map<BasicTerm, VarOccurr>;
+    using VarMap = std::map<BasicTerm, std::vector<VarNode>>;
     using VarNodeSymDiff = std::pair<std::set<VarNode>, std::set<VarNode>>;
     using Concat = std::vector<BasicTerm>;
     using SepEqsGather = std::vector<std::pair<std::map<BasicTerm, unsigned>, unsigned>>;
@@ -242,12 +264,16 @@ namespace smt::noodler {
     private:
         std::map<size_t, Predicate> predicates; // formula
         std::set<Predicate> allpreds; // all predicates in a set
-        VarMap varmap; // mapping of a variable name to a set of its occurrences in the formula
+        // mapping of a variable name to its occurrences in the formula (compacted lazily on access, hence mutable)
+        mutable OccurrIndex varmap;
+        std::vector<unsigned> generations; // generations of predicate indices (incremented when a predicate is removed)
         size_t input_size; // number of equations in the input formula
         size_t max_index; // maximum occupied index
+        unsigned version = 0; // incremented whenever a predicate is added or removed
 
     protected:
         void update_varmap(const Predicate& pred, size_t index);
+        void compact(VarOccurr& occurr) const;
 
     public:
 
@@ -255,14 +281,20 @@ namespace smt::noodler {
 
         std::string to_string() const;
 
-        const std::set<VarNode>& get_var_occurr(const BasicTerm& var) const { return this->varmap.at(var); };
+        const std::vector<VarNode>& get_var_occurr(const BasicTerm& var) const;
+        size_t get_num_occurr(const BasicTerm& var) const;
+        std::vector<BasicTerm> get_vars() const;
+        VarMap get_varmap() const;
         const Predicate& get_predicate(size_t index) const { return this->predicates.at(index); };
         const std::map<size_t, Predicate>& get_predicates() const { return this->predicates; };
         const std::set<Predicate>& get_predicates_set() const { return this->allpreds; };
-        const VarMap& get_varmap() const { return this->varmap; };
         void get_side_regulars(std::vector<std::pair<size_t, Predicate>>& out) const;
         void get_simple_eqs(std::vector<std::pair<size_t, Predicate>>& out) const;
         size_t get_max_index() const { return this->max_index; }
+        /**
+         * @brief Get the version of the formula, which changes whenever the formula changes.
+         */
+        unsigned get_version() const { return this->version; }
         bool contains_simple_eqs() const { std::vector<std::pair<size_t, Predicate>> out; get_simple_eqs(out); return out.size() > 0;  }
 
         std::set<VarNode> get_var_positions(const Predicate& pred, size_t index, bool incl_lit=false) const;
@@ -317,8 +349,28 @@ namespace smt::noodler {
 
         Dependency dependency;
 
+        // number of automata operations skipped by allow_aut_operation()
+        unsigned num_gated_ops = 0;
+        // literal store of the session used to compare literals (not used if nullptr)
+        LiteralStore* literal_store = nullptr;
+
     protected:
         void update_reg_constr(const BasicTerm& var, const std::vector<BasicTerm>& upd);
+
+        /**
+         * @brief Cost model of automata operations of optional passes (refine_languages, underapprox_languages,
+         * reduce_diseqalities): size of an automaton is the pair (number of states, number of transitions) and
+         * the size of a result of an operation is predicted from the sizes of the arguments. An operation whose
+         * predicted size exceeds m_params.m_prep_size_limit is skipped (see allow_aut_operation()).
+         */
+        using AutSize = std::pair<size_t, size_t>;
+        static AutSize get_aut_size(const mata::nfa::Nfa& aut) { return { aut.num_of_states(), aut.delta.num_of_transitions() }; }
+        AutSize get_concat_size(const Concat& concat) const;
+        static AutSize predict_intersection(const AutSize& size1, const AutSize& size2) {
+            return { size1.first * size2.first, size1.second * size2.second };
+        }
+        static AutSize predict_complement(const mata::nfa::Nfa& aut);
+        bool allow_aut_operation(const AutSize& predicted_size, const char* pass);
         bool propagate_regular_eqs(const std::set<VarNode>& diff1, const std::set<VarNode>& diff2, Predicate& new_pred) const;
         VarNodeSymDiff get_eq_sym_diff(const Concat& cat1, const Concat& cat2) const;
         bool generate_identities_suit(const VarNodeSymDiff& diff, Predicate& new_pred) const;
@@ -331,12 +383,13 @@ namespace smt::noodler {
 
         void gather_extended_vars(Predicate::EquationSideType side, std::set<BasicTerm>& res);
 
-        bool same_length(const BasicTermEqiv& ec, const BasicTerm&t1, const BasicTerm& t2) const;
+        bool same_length(const BasicTermEqivIndex& ec, const BasicTerm&t1, const BasicTerm& t2) const;
         
         bool add_var_separator(const Concat& side, std::map<BasicTerm, std::set<BasicTerm>>& container);
         bool propagate_var_separators(const BasicTerm& dest, const BasicTerm& src, std::map<BasicTerm, std::map<BasicTerm, std::set<BasicTerm>>>& separators);
         Concat flatten_concat(const Concat& con, std::map<BasicTerm, std::set<Concat>>& replace_map) const;
         bool can_unify(const Concat& con1, const Concat& con2, const std::function<bool(const Concat&, const Concat&)> &check) const;
+        bool literals_compatible(const BasicTerm& lit1, const BasicTerm& lit2, bool from_start) const;
         TermReplaceMap construct_replace_map() const;
 
 
@@ -357,11 +410,22 @@ namespace smt::noodler {
         const AutAssignment& get_aut_assignment() const { return this->aut_ass; }
         const Dependency& get_dependency() const { return this->dependency; }
         Dependency get_flat_dependency() const;
+        void set_literal_store(LiteralStore* store) { literal_store = store; }
         void add_to_len_formula(LenNode len_to_add) { len_formula.succ.push_back(std::move(len_to_add)); }
         const LenNode& get_len_formula() const { return this->len_formula; }
         const std::unordered_set<BasicTerm>& get_len_variables() const { return this->len_variables; }
 
         Formula get_modified_formula() const;
+        unsigned get_num_gated_ops() const { return this->num_gated_ops; }
+        size_t get_num_aut_states() const;
+
+        /**
+         * @brief Fingerprint of the preprocessed instance: versions of the formula, the automata, the length variables and
+         * the length formula (in this order). If a part changes, its fingerprint changes. The automata are compared by their
+         * pointers (automata are never changed in place), so an unchanged fingerprint could be caused by reusing the address
+         * of a freed automaton, which is acceptable for skipping preprocessing passes (see PreprocessScheduler).
+         */
+        std::array<size_t, 4> get_fingerprint() const;
 
         void remove_regular(const std::unordered_set<BasicTerm>& disallowed_vars);
         void propagate_variables();
@@ -407,6 +471,105 @@ namespace smt::noodler {
     };
 
 
+    /**
+     * @brief Parts of the preprocessed instance read by a preprocessing pass (bit mask for PreprocessScheduler::run()).
+     */
+    enum PreprocessParts : unsigned {
+        PREP_FORMULA = 1,
+        PREP_AUTOMATA = 2,
+        PREP_LENGTHS = 4,
+        PREP_ALL = PREP_FORMULA | PREP_AUTOMATA | PREP_LENGTHS,
+    };
+
+    /**
+     * @brief Profile of preprocessing passes (run through PreprocessScheduler) summed over all their runs. It tells
+     * which passes do useful work: how much time they take and how they change the instance.
+     */
+    struct PreprocessProfile {
+        struct PassProfile {
+            unsigned runs = 0;
+            // runs skipped by PreprocessScheduler
+            unsigned skipped = 0;
+            double time = 0;
+            // sums of changes (after - before) of the number of predicates, variables and automata states
+            double predicates_delta = 0;
+            double vars_delta = 0;
+            double states_delta = 0;
+            // keys of the statistics of the pass (statistics keep only pointers to the keys)
+            std::string runs_key, time_key, predicates_key, states_key;
+        };
+
+        // passes by their names, entries are never removed (their keys may be referenced)
+        std::map<std::string, PassProfile> passes;
+        // names of the passes in the order of their first runs
+        std::vector<std::string> order;
+
+        PassProfile& get(const std::string& name);
+        /**
+         * @brief Summary of the profile as a single line.
+         */
+        std::string summary() const;
+    };
+
+    /**
+     * @brief Runs preprocessing passes of FormulaPreprocessor, skipping the passes that cannot change anything.
+     *
+     * Each pass declares which parts of the instance it reads. If the last run of a pass did not change anything
+     * and the parts it reads did not change since then, the pass is skipped, as passes are deterministic. Hence,
+     * a repeated pass is rerun only when its inputs changed and a sequence of passes stops doing work once it
+     * reaches a fixpoint. Skipping a pass is always sound, as the passes only simplify the instance.
+     */
+    class PreprocessScheduler {
+    private:
+        FormulaPreprocessor& prep;
+        // fingerprints at which the pass (given by name) did not change anything
+        std::map<std::string, std::array<size_t, 4>> noop_fingerprints;
+        unsigned num_skipped = 0;
+        // profile of the passes (not recorded if nullptr)
+        PreprocessProfile* profile;
+
+        static bool same_parts(const std::array<size_t, 4>& fp1, const std::array<size_t, 4>& fp2, unsigned parts) {
+            return (!(parts & PREP_FORMULA) || fp1[0] == fp2[0])
+                && (!(parts & PREP_AUTOMATA) || fp1[1] == fp2[1])
+                && (!(parts & PREP_LENGTHS) || (fp1[2] == fp2[2] && fp1[3] == fp2[3]));
+        }
+
+    public:
+        explicit PreprocessScheduler(FormulaPreprocessor& prep, PreprocessProfile* profile = nullptr) : prep(prep), profile(profile) {}
+
+        /**
+         * @brief Run the pass @p pass named @p name (the name identifies the pass together with its arguments)
+         * reading the parts @p reads (see PreprocessParts), unless it surely does not change anything.
+         */
+        void run(const std::string& name, unsigned reads, const std::function<void(FormulaPreprocessor&)>& pass) {
+            std::array<size_t, 4> before = prep.get_fingerprint();
+            auto it = noop_fingerprints.find(name);
+            if (it != noop_fingerprints.end() && same_parts(it->second, before, reads)) {
+                STRACE("str-prep", tout << "Skipping preprocessing pass " << name << std::endl;);
+                ++num_skipped;
+                if (profile != nullptr) {
+                    ++profile->get(name).skipped;
+                }
+                return;
+            }
+            if (profile != nullptr) {
+                run_profiled(name, pass);
+            } else {
+                pass(prep);
+            }
+            if (prep.get_fingerprint() == before) {
+                noop_fingerprints[name] = before;
+            } else {
+                noop_fingerprints.erase(name);
+            }
+        }
+
+        unsigned get_num_skipped() const { return num_skipped; }
+
+    private:
+        void run_profiled(const std::string& name, const std::function<void(FormulaPreprocessor&)>& pass);
+    };
+
     static std::string concat_to_string(const Concat& cat) {
         std::string ret;
         for(const BasicTerm& t : cat) {
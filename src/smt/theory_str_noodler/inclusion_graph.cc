@@ -4,17 +4,43 @@
 namespace {
     using namespace smt::noodler;
 
-    bool have_same_var(const std::vector<BasicTerm>& first_side, const std::vector<BasicTerm>& second_side) {
-        for (const auto& first_side_term: first_side) {
-            for (const auto& second_side_term: second_side) {
-                if (first_side_term == second_side_term) {
-                    if (first_side_term.is_variable()) {
-                        return true;
-                    }
+    using VarOccurrences = std::unordered_map<BasicTerm, std::vector<std::shared_ptr<GraphNode>>>;
+
+    /**
+     * Index nodes by the variables occurring on the right sides of their predicates.
+     * @param nodes Nodes to index.
+     * @return Mapping of each variable to the nodes (each at most once) having this variable on the right side.
+     */
+    VarOccurrences index_right_side_vars(const Graph::Nodes& nodes) {
+        VarOccurrences occurrences;
+        for (const auto& node : nodes) {
+            std::unordered_set<BasicTerm> vars;
+            for (const auto& term : node->get_predicate().get_right_side()) {
+                if (term.is_variable() && vars.insert(term).second) {
+                    occurrences[term].push_back(node);
                 }
             }
         }
-        return false;
+        return occurrences;
+    }
+
+    /**
+     * Get nodes whose right side shares a variable with @p side.
+     * @param side Side whose variables are looked up.
+     * @param occurrences Index created by index_right_side_vars().
+     */
+    Graph::Nodes get_nodes_sharing_var(const std::vector<BasicTerm>& side, const VarOccurrences& occurrences) {
+        Graph::Nodes result;
+        for (const auto& term : side) {
+            if (!term.is_variable()) {
+                continue;
+            }
+            auto it = occurrences.find(term);
+            if (it != occurrences.end()) {
+                result.insert(it->second.begin(), it->second.end());
+            }
+        }
+        return result;
     }
 
     /**
@@ -88,21 +114,14 @@ Graph smt::noodler::Graph::deep_copy(std::unordered_map<std::shared_ptr<GraphNod
 }
 
 void smt::noodler::Graph::add_inclusion_graph_edges() {
+    const VarOccurrences right_side_occurrences{ index_right_side_vars(get_nodes()) };
     for (auto& source_node: get_nodes() ) {
-        for (auto& target_node: get_nodes()) {
+        // nodes whose right side has same var as the left side of source node, each gets a new edge
+        for (auto& target_node: get_nodes_sharing_var(source_node->get_predicate().get_left_side(), right_side_occurrences)) {
             if (source_node == target_node) { // we do not want self-loops (difference from FM'23)
                 continue;
             }
-
-            auto& source_predicate{ source_node->get_predicate() };
-            auto& target_predicate{ target_node->get_predicate() };
-            auto& source_left_side{ source_predicate.get_left_side() };
-            auto& target_right_side{ target_predicate.get_right_side() };
-
-            if (have_same_var(source_left_side, target_right_side)) {
-                // Have same var, automatically add a new edge.
-                add_edge(source_node, target_node);
-            }
+            add_edge(source_node, target_node);
         }
     }
 }
@@ -147,9 +166,9 @@ void smt::noodler::Graph::substitute_vars(const std::unordered_map<BasicTerm, st
     }
 }
 
-Graph smt::noodler::Graph::create_inclusion_graph(const Formula& formula, std::deque<std::shared_ptr<GraphNode>> &out_node_order) {
+Graph smt::noodler::Graph::create_inclusion_graph(const Formula& formula, std::deque<std::shared_ptr<GraphNode>> &out_node_order, const PredicateOrder& order) {
     Graph splitting_graph{ create_simplified_splitting_graph(formula) };
-    return create_inclusion_graph(splitting_graph, out_node_order);
+    return create_inclusion_graph(splitting_graph, out_node_order, order);
 }
 
 Graph smt::noodler::Graph::create_simplified_splitting_graph(const Formula& formula) {
@@ -169,8 +188,10 @@ Graph smt::noodler::Graph::create_simplified_splitting_graph(const Formula& form
         return Graph{};
     }
 
+    // only nodes whose right side has same var as the left side of the source node can be targets
+    const VarOccurrences right_side_occurrences{ index_right_side_vars(graph.get_nodes()) };
     for (auto &source_node: graph.get_nodes() ) {
-        for (auto &target_node: graph.get_nodes()) {
+        for (auto &target_node: get_nodes_sharing_var(source_node->get_predicate().get_left_side(), right_side_occurrences)) {
             auto& source_predicate{ source_node->get_predicate() };
             auto& target_predicate{ target_node->get_predicate() };
             auto& source_left_side{ source_predicate.get_left_side() };
@@ -178,9 +199,7 @@ Graph smt::noodler::Graph::create_simplified_splitting_graph(const Formula& form
             auto& target_left_side{ target_predicate.get_left_side() };
             auto& target_right_side{ target_predicate.get_right_side() };
 
-            if (!have_same_var(source_left_side, target_right_side)) {
-                continue;
-            } else if (source_left_side == target_right_side) {
+            if (source_left_side == target_right_side) {
                 // Have same var and sides are equal.
 
                 if (source_right_side == target_left_side) { // In the same equation.
@@ -207,39 +226,88 @@ Graph smt::noodler::Graph::create_inclusion_graph(const Formula& formula) {
     return create_inclusion_graph(formula, out_node_order);
 }
 
-Graph smt::noodler::Graph::create_inclusion_graph(Graph& simplified_splitting_graph, std::deque<std::shared_ptr<GraphNode>> &out_node_order) {
+Graph smt::noodler::Graph::create_inclusion_graph(Graph& simplified_splitting_graph, std::deque<std::shared_ptr<GraphNode>> &out_node_order, const PredicateOrder& order) {
     Graph inclusion_graph{};
 
-    bool splitting_graph_changed{ true };
-    while(splitting_graph_changed) {
-        splitting_graph_changed = false;
+    // Nodes are compared by the given order and then by their predicates, so the resulting order does not depend on
+    // the hashes of pointers. Pointers are compared only to distinguish nodes with the same predicate.
+    auto node_less = [&order](const std::shared_ptr<GraphNode>& lhs, const std::shared_ptr<GraphNode>& rhs) {
+        const Predicate& lhs_pred{ lhs->get_predicate() };
+        const Predicate& rhs_pred{ rhs->get_predicate() };
+        if (order) {
+            if (order(lhs_pred, rhs_pred)) {
+                return true;
+            } else if (order(rhs_pred, lhs_pred)) {
+                return false;
+            }
+        }
+        if (lhs_pred < rhs_pred) {
+            return true;
+        } else if (rhs_pred < lhs_pred) {
+            return false;
+        }
+        return lhs.get() < rhs.get();
+    };
+
+    // switched nodes are looked up in a map instead of get_node() (which is linear in the number of nodes)
+    std::unordered_map<Predicate, std::shared_ptr<GraphNode>, Predicate::HashFunction> predicate_to_node;
+    for (const auto& node: simplified_splitting_graph.get_nodes()) {
+        predicate_to_node.emplace(node->get_predicate(), node);
+    }
+
+    // Nodes without incoming edges are processed incrementally: only the targets of edges removed together with
+    // a processed node can lose all their incoming edges, so only they become new candidates. The least candidate
+    // (w.r.t. node_less) is processed first.
+    std::set<std::shared_ptr<GraphNode>, decltype(node_less)> candidates(node_less);
+    for (const auto& node: simplified_splitting_graph.get_nodes()) {
+        if (simplified_splitting_graph.inverse_edges.count(node) == 0) {
+            candidates.insert(node);
+        }
+    }
 
-        for (auto& node: simplified_splitting_graph.get_nodes()) {
-            if (simplified_splitting_graph.inverse_edges.count(node) == 0) {
-                inclusion_graph.nodes.insert(node);
-                STRACE("str", tout << "Added node " << node->get_predicate() << " to the graph without the reversed inclusion." << std::endl;);
-                inclusion_graph.nodes_not_on_cycle.insert(node); // the inserted node cannot be on the cycle, because it is either initial or all nodes leading to it were not on cycle
+    while (!candidates.empty()) {
+        std::shared_ptr<GraphNode> node = *candidates.begin();
+        candidates.erase(candidates.begin());
+        if (simplified_splitting_graph.nodes.count(node) == 0) {
+            // was already removed as a switched node
+            continue;
+        }
+        assert(simplified_splitting_graph.inverse_edges.count(node) == 0); // edges are only removed, so node still has no incoming edge
 
-                out_node_order.push_back(node);
+        inclusion_graph.nodes.insert(node);
+        STRACE("str", tout << "Added node " << node->get_predicate() << " to the graph without the reversed inclusion." << std::endl;);
+        inclusion_graph.nodes_not_on_cycle.insert(node); // the inserted node cannot be on the cycle, because it is either initial or all nodes leading to it were not on cycle
 
-                auto switched_node{ simplified_splitting_graph.get_node(node->get_predicate().get_switched_sides_predicate()) };
+        out_node_order.push_back(node);
 
-                // Remove edges of node and switched node.
-                simplified_splitting_graph.remove_edges_with(node);
-                simplified_splitting_graph.remove_edges_with(switched_node);
+        auto switched_node_it{ predicate_to_node.find(node->get_predicate().get_switched_sides_predicate()) };
+        std::shared_ptr<GraphNode> switched_node = (switched_node_it == predicate_to_node.end()) ? nullptr : switched_node_it->second;
 
-                // we can erase nodes, because we are breaking from the for loop (so no problem with invalidating iterators)
-                simplified_splitting_graph.nodes.erase(node);
-                simplified_splitting_graph.nodes.erase(switched_node);
+        // targets of the removed edges are the only nodes that can lose all incoming edges
+        Nodes affected_nodes{ simplified_splitting_graph.get_edges_from(node) };
+        if (switched_node != nullptr) {
+            const Nodes& switched_targets{ simplified_splitting_graph.get_edges_from(switched_node) };
+            affected_nodes.insert(switched_targets.begin(), switched_targets.end());
+        }
 
-                splitting_graph_changed = true;
-                break;
+        // Remove edges of node and switched node.
+        simplified_splitting_graph.remove_edges_with(node);
+        simplified_splitting_graph.remove_edges_with(switched_node);
+
+        simplified_splitting_graph.nodes.erase(node);
+        simplified_splitting_graph.nodes.erase(switched_node);
+
+        for (const auto& affected_node: affected_nodes) {
+            if (simplified_splitting_graph.nodes.count(affected_node) > 0 && simplified_splitting_graph.inverse_edges.count(affected_node) == 0) {
+                candidates.insert(affected_node);
             }
         }
     }
 
     // we add rest of the nodes (the ones on the cycle) to the inclusion graph
-    for (auto& node: simplified_splitting_graph.get_nodes()) {
+    std::vector<std::shared_ptr<GraphNode>> nodes_on_cycle(simplified_splitting_graph.get_nodes().begin(), simplified_splitting_graph.get_nodes().end());
+    std::sort(nodes_on_cycle.begin(), nodes_on_cycle.end(), node_less);
+    for (auto& node: nodes_on_cycle) {
         out_node_order.push_back(node);
         STRACE("str", tout << "Added node " << node->get_predicate() << " to the graph with its reversed inclusion." << std::endl;);
     }
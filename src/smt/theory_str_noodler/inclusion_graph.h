@@ -5,6 +5,8 @@
 #include <optional>
 #include <deque>
 #include <algorithm>
+#include <functional>
+#include <set>
 
 #include "formula.h"
 
@@ -53,6 +55,8 @@ namespace smt::noodler {
     class Graph {
     public:
         using Nodes = std::unordered_set<std::shared_ptr<GraphNode>>;
+        /// strict weak order of predicates, e.g. a heuristic of which inclusion should be processed first
+        using PredicateOrder = std::function<bool(const Predicate&, const Predicate&)>;
         using Edges = std::unordered_map<std::shared_ptr<GraphNode>, Nodes>;
     private:
         Nodes nodes;
@@ -218,10 +222,12 @@ namespace smt::noodler {
         void substitute_vars(const std::unordered_map<BasicTerm, std::vector<BasicTerm>> &substitution_map, std::unordered_set<std::shared_ptr<GraphNode>> &out_deleted_nodes);
 
         // all these assume that formula does not contain same equalities
+        // out_node_order is deterministic: among the nodes that can be processed next (and among the nodes on cycle), the nodes
+        // are ordered by order (if given) and then by their predicates
         static Graph create_inclusion_graph(const Formula& formula);
-        static Graph create_inclusion_graph(const Formula& formula, std::deque<std::shared_ptr<GraphNode>> &out_node_order);
+        static Graph create_inclusion_graph(const Formula& formula, std::deque<std::shared_ptr<GraphNode>> &out_node_order, const PredicateOrder& order = {});
         static Graph create_simplified_splitting_graph(const Formula& formula);
-        static Graph create_inclusion_graph(Graph& simplified_splitting_graph, std::deque<std::shared_ptr<GraphNode>> &out_node_order);
+        static Graph create_inclusion_graph(Graph& simplified_splitting_graph, std::deque<std::shared_ptr<GraphNode>> &out_node_order, const PredicateOrder& order = {});
 
         /**
          * Print the inclusion graph in a DOT format.
@@ -0,0 +1,260 @@
+#include <istream>
+#include <ostream>
+
+#include "util/util.h"
+#include "instance_record.h"
+#include "util.h"
+
+namespace smt::noodler {
+
+    namespace {
+        const char* const INSTANCE_HEADER = "noodler-instance";
+        const unsigned INSTANCE_VERSION = 1;
+
+        void write_string(std::ostream& out, const std::string& str) {
+            out << str.size() << ':' << str;
+        }
+
+        void write_term(std::ostream& out, const BasicTerm& term) {
+            out << static_cast<unsigned>(term.get_type()) << ' ';
+            write_string(out, term.get_name().encode());
+        }
+
+        void write_terms(std::ostream& out, const std::vector<BasicTerm>& terms) {
+            out << terms.size();
+            for (const BasicTerm& term : terms) {
+                out << ' ';
+                write_term(out, term);
+            }
+        }
+
+        void write_nfa(std::ostream& out, const mata::nfa::Nfa& nfa) {
+            out << nfa.num_of_states() << ' ' << nfa.initial.size();
+            for (mata::nfa::State s : nfa.initial) {
+                out << ' ' << s;
+            }
+            out << ' ' << nfa.final.size();
+            for (mata::nfa::State s : nfa.final) {
+                out << ' ' << s;
+            }
+            std::vector<std::tuple<mata::nfa::State, mata::Symbol, mata::nfa::State>> transitions;
+            for (mata::nfa::State s = 0; s < nfa.num_of_states(); ++s) {
+                for (const auto& symbol_post : nfa.delta[s]) {
+                    for (mata::nfa::State t : symbol_post.targets) {
+                        transitions.emplace_back(s, symbol_post.symbol, t);
+                    }
+                }
+            }
+            out << ' ' << transitions.size();
+            for (const auto& [s, symbol, t] : transitions) {
+                out << ' ' << s << ' ' << symbol << ' ' << t;
+            }
+        }
+
+        /**
+         * @brief Reader of the tokens of a recorded instance, reports malformed input by exceptions.
+         */
+        class InstanceReader {
+            std::istream& in;
+
+        public:
+            explicit InstanceReader(std::istream& in) : in(in) {}
+
+            [[noreturn]] void fail(const std::string& what) {
+                util::throw_error("malformed recorded instance: " + what);
+                UNREACHABLE();
+            }
+
+            template<typename T>
+            T read_number(const char* what) {
+                T res;
+                if (!(in >> res)) {
+                    fail(std::string("expected ") + what);
+                }
+                return res;
+            }
+
+            void expect(const std::string& keyword) {
+                std::string token;
+                if (!(in >> token) || token != keyword) {
+                    fail("expected '" + keyword + "'");
+                }
+            }
+
+            std::string read_string() {
+                size_t size = read_number<size_t>("string length");
+                if (in.get() != ':') {
+                    fail("expected ':' after string length");
+                }
+                std::string res(size, '\0');
+                if (!in.read(res.data(), size)) {
+                    fail("string is shorter than its length");
+                }
+                return res;
+            }
+
+            BasicTerm read_term() {
+                unsigned type = read_number<unsigned>("term type");
+                if (type > static_cast<unsigned>(BasicTermType::Length)) {
+                    fail("unknown term type");
+                }
+                return BasicTerm(static_cast<BasicTermType>(type), zstring(read_string().c_str()));
+            }
+
+            std::vector<BasicTerm> read_terms() {
+                std::vector<BasicTerm> res;
+                size_t size = read_number<size_t>("number of terms");
+                for (size_t i = 0; i < size; ++i) {
+                    res.push_back(read_term());
+                }
+                return res;
+            }
+
+            mata::nfa::Nfa read_nfa() {
+                size_t num_states = read_number<size_t>("number of states");
+                mata::nfa::Nfa nfa(num_states, {}, {});
+                auto read_state = [&]() {
+                    mata::nfa::State s = read_number<mata::nfa::State>("state");
+                    if (s >= num_states) {
+                        fail("state out of range");
+                    }
+                    return s;
+                };
+                size_t num_initial = read_number<size_t>("number of initial states");
+                for (size_t i = 0; i < num_initial; ++i) {
+                    nfa.initial.insert(read_state());
+                }
+                size_t num_final = read_number<size_t>("number of final states");
+                for (size_t i = 0; i < num_final; ++i) {
+                    nfa.final.insert(read_state());
+                }
+                size_t num_transitions = read_number<size_t>("number of transitions");
+                for (size_t i = 0; i < num_transitions; ++i) {
+                    mata::nfa::State s = read_state();
+                    mata::Symbol symbol = read_number<mata::Symbol>("symbol");
+                    mata::nfa::State t = read_state();
+                    nfa.delta.add(s, symbol, t);
+                }
+                return nfa;
+            }
+        };
+    }
+
+    void write_instance(std::ostream& out, const RecordedInstance& instance) {
+        out << INSTANCE_HEADER << ' ' << INSTANCE_VERSION << '\n';
+
+        out << "symbols " << instance.symbols.size();
+        for (mata::Symbol s : instance.symbols) {
+            out << ' ' << s;
+        }
+        out << '\n';
+
+        out << "predicates " << instance.formula.get_predicates().size() << '\n';
+        for (const Predicate& pred : instance.formula.get_predicates()) {
+            out << static_cast<unsigned>(pred.get_type()) << ' ' << pred.get_params().size();
+            for (const auto& side : pred.get_params()) {
+                out << ' ';
+                write_terms(out, side);
+            }
+            out << '\n';
+        }
+
+        out << "automata " << instance.aut_assignment.size() << '\n';
+        for (const auto& [term, nfa] : instance.aut_assignment) {
+            write_term(out, term);
+            out << ' ';
+            write_nfa(out, *nfa);
+            out << '\n';
+        }
+
+        out << "length_vars ";
+        write_terms(out, std::vector<BasicTerm>(instance.length_sensitive_vars.begin(), instance.length_sensitive_vars.end()));
+        out << '\n';
+
+        out << "len_eq_vars " << instance.len_eq_vars.size() << '\n';
+        for (const auto& eq_class : instance.len_eq_vars) {
+            write_terms(out, std::vector<BasicTerm>(eq_class.begin(), eq_class.end()));
+            out << '\n';
+        }
+
+        out << "conversions " << instance.conversions.size() << '\n';
+        for (const TermConversion& conv : instance.conversions) {
+            out << static_cast<unsigned>(conv.type) << ' ';
+            write_term(out, conv.string_var);
+            out << ' ';
+            write_term(out, conv.int_var);
+            out << '\n';
+        }
+
+        out << "arith_context ";
+        write_string(out, instance.arith_context);
+        out << '\n';
+    }
+
+    RecordedInstance read_instance(std::istream& in) {
+        InstanceReader reader(in);
+        RecordedInstance instance;
+
+        reader.expect(INSTANCE_HEADER);
+        if (reader.read_number<unsigned>("version") != INSTANCE_VERSION) {
+            reader.fail("unsupported version");
+        }
+
+        reader.expect("symbols");
+        size_t num_symbols = reader.read_number<size_t>("number of symbols");
+        for (size_t i = 0; i < num_symbols; ++i) {
+            instance.symbols.insert(reader.read_number<mata::Symbol>("symbol"));
+        }
+
+        reader.expect("predicates");
+        size_t num_predicates = reader.read_number<size_t>("number of predicates");
+        for (size_t i = 0; i < num_predicates; ++i) {
+            unsigned type = reader.read_number<unsigned>("predicate type");
+            if (type > static_cast<unsigned>(PredicateType::NotContains)) {
+                reader.fail("unknown predicate type");
+            }
+            std::vector<std::vector<BasicTerm>> params;
+            size_t num_sides = reader.read_number<size_t>("number of sides");
+            for (size_t j = 0; j < num_sides; ++j) {
+                params.push_back(reader.read_terms());
+            }
+            instance.formula.add_predicate(Predicate(static_cast<PredicateType>(type), std::move(params)));
+        }
+
+        reader.expect("automata");
+        size_t num_automata = reader.read_number<size_t>("number of automata");
+        for (size_t i = 0; i < num_automata; ++i) {
+            BasicTerm term = reader.read_term();
+            instance.aut_assignment[term] = std::make_shared<mata::nfa::Nfa>(reader.read_nfa());
+        }
+        instance.aut_assignment.set_alphabet(instance.symbols);
+
+        reader.expect("length_vars");
+        for (const BasicTerm& var : reader.read_terms()) {
+            instance.length_sensitive_vars.insert(var);
+        }
+
+        reader.expect("len_eq_vars");
+        size_t num_classes = reader.read_number<size_t>("number of length equivalence classes");
+        for (size_t i = 0; i < num_classes; ++i) {
+            std::vector<BasicTerm> eq_class = reader.read_terms();
+            instance.len_eq_vars.emplace_back(eq_class.begin(), eq_class.end());
+        }
+
+        reader.expect("conversions");
+        size_t num_conversions = reader.read_number<size_t>("number of conversions");
+        for (size_t i = 0; i < num_conversions; ++i) {
+            unsigned type = reader.read_number<unsigned>("conversion type");
+            if (type > static_cast<unsigned>(ConversionType::FROM_INT)) {
+                reader.fail("unknown conversion type");
+            }
+            BasicTerm string_var = reader.read_term();
+            BasicTerm int_var = reader.read_term();
+            instance.conversions.emplace_back(static_cast<ConversionType>(type), std::move(string_var), std::move(int_var));
+        }
+
+        reader.expect("arith_context");
+        instance.arith_context = reader.read_string();
+        return instance;
+    }
+}
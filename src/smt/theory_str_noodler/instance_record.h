@@ -0,0 +1,49 @@
+#ifndef _NOODLER_INSTANCE_RECORD_H_
+#define _NOODLER_INSTANCE_RECORD_H_
+
+#include <iosfwd>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "formula.h"
+#include "aut_assignment.h"
+#include "var_union_find.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Input of the decision procedure of one final check, recorded so that it can be replayed offline
+     * (see m_params.m_record_dir and replay-noodler in src/test/noodler).
+     */
+    struct RecordedInstance {
+        Formula formula;
+        // symbols of the formula (the alphabet of the automata, including the dummy symbol)
+        std::set<mata::Symbol> symbols;
+        AutAssignment aut_assignment;
+        std::unordered_set<BasicTerm> length_sensitive_vars;
+        BasicTermEqiv len_eq_vars;
+        std::vector<TermConversion> conversions;
+        // asserted formulas (and relevant assignments) of the context in SMT-LIB, the length formulas of solutions
+        // are checked against them
+        std::string arith_context;
+    };
+
+    /**
+     * @brief Write @p instance to @p out in a self-contained text format readable by read_instance().
+     *
+     * Names and literals are length-prefixed, so any name can be stored. The automata are stored as explicit lists
+     * of transitions over the numeric symbols of the instance (so that the symbols are not renamed on reading).
+     */
+    void write_instance(std::ostream& out, const RecordedInstance& instance);
+
+    /**
+     * @brief Read an instance written by write_instance() from @p in.
+     *
+     * @throws default_exception if the input is malformed
+     */
+    RecordedInstance read_instance(std::istream& in);
+}
+
+#endif
@@ -14,16 +14,54 @@ namespace smt::noodler {
         return BasicTerm(BasicTermType::Variable, "B!" + of.encode() + "_IN_" + from.encode());
     }
 
+    void LiteralTable::add(const BasicTerm& alias, const BasicTerm& value) {
+        const zstring& val = value.get_name();
+        while (powers.size() <= val.length()) {
+            powers.push_back(powers.back() * LiteralStore::BASE);
+        }
+        entries.emplace(alias, Entry{value, store != nullptr ? store->get(val) : LiteralStore::make_literal(val)});
+    }
+
+    uint64_t LiteralTable::get_hash(const BasicTerm& alias, unsigned from, unsigned n) const {
+        const std::vector<uint64_t>& prefix = entries.at(alias).literal->prefix_hashes;
+        return prefix[from + n] - prefix[from] * powers[n];
+    }
+
+    std::string LiteralTable::to_string() const {
+        std::string ret;
+        for (const auto& [alias, entry] : entries) {
+            ret += alias.to_string() + " : " + entry.value.to_string() + "\n";
+        }
+        return ret;
+    }
+
+    VarConstraint& VarConstraintPool::get_or_create(const BasicTerm& var) {
+        auto [it, inserted] = index.emplace(var.get_id(), constraints.size());
+        if (inserted) {
+            constraints.emplace_back(var);
+        }
+        return constraints[it->second];
+    }
+
+    VarConstraint* VarConstraintPool::find(const BasicTerm& var) {
+        auto it = index.find(var.get_id());
+        return it == index.end() ? nullptr : &constraints[it->second];
+    }
+
+    const VarConstraint* VarConstraintPool::find(const BasicTerm& var) const {
+        auto it = index.find(var.get_id());
+        return it == index.end() ? nullptr : &constraints[it->second];
+    }
+
     bool VarConstraint::check_side(const Concat& side) {
-        return side.size() == 1 && side[0].get_name() == _name;
+        return side.size() == 1 && side[0] == _var;
     }
 
-    void VarConstraint::emplace(const Concat& c, std::map<zstring, BasicTerm>& lit_conversion) {
+    void VarConstraint::emplace(const Concat& c, LiteralTable& lit_conversion) {
         Concat n {};
         for (const BasicTerm& t : c) {
             if (BasicTermType::Literal == t.get_type()) {
-                BasicTerm lit(BasicTermType::Literal, LengthDecisionProcedure::generate_lit_alias(t, lit_conversion));
-                n.emplace_back(lit);
+                n.emplace_back(LengthDecisionProcedure::generate_lit_alias(t, lit_conversion));
             } else {
                 n.emplace_back(t);
             }
@@ -32,7 +70,7 @@ namespace smt::noodler {
         _constr_eqs.emplace_back(n);
     }
 
-    bool VarConstraint::add(const Predicate& pred, std::map<zstring, BasicTerm>& lit_conversion) {
+    bool VarConstraint::add(const Predicate& pred, LiteralTable& lit_conversion) {
         if (check_side(pred.get_left_side())) {
             emplace(pred.get_right_side(), lit_conversion);
             return true;
@@ -49,12 +87,12 @@ namespace smt::noodler {
         return false;
     }
 
-    const std::vector<zstring>& VarConstraint::get_lits() const {
+    const std::vector<BasicTerm>& VarConstraint::get_lits() const {
         return _lits;
     }
 
     LenNode VarConstraint::generate_side_eq(const std::vector<LenNode>& side_len) {
-        LenNode left = BasicTerm(BasicTermType::Variable, this->_name);
+        LenNode left = this->_var;
         // if there is no variable: length is 0, for one variable the length of the right side is its length, for more the length is their sum
         LenNode right = (side_len.size() == 0) ? LenNode(0)
             : ((side_len.size() == 1) ? LenNode(side_len[0]) : LenNode(LenFormulaType::PLUS, side_len));
@@ -63,10 +101,14 @@ namespace smt::noodler {
 
     /**
      * @brief Compare first n characters of l1 with last n characters of l2 (e.g. l1=banana, l2=ababa, n=2 -> [ba]nana, aba[ba] -> true)
+     *
+     * Substrings are first compared by their hashes from @p conv, characters are compared only if the hashes are equal.
      * 
      * @return bool match of substrings
      */
-    bool VarConstraint::zstr_comp(const zstring& l1_val, const zstring& l2_val, unsigned n) {
+    bool VarConstraint::zstr_comp(const BasicTerm& l1, const BasicTerm& l2, unsigned n, const LiteralTable& conv) {
+        const zstring& l1_val = conv.get_value(l1).get_name();
+        const zstring& l2_val = conv.get_value(l2).get_name();
         int s1 = 0;
         int s2 = l2_val.length() - n;
 
@@ -79,6 +121,10 @@ namespace smt::noodler {
             n = l1_val.length() - s1;
         }
 
+        if (conv.get_hash(l1, s1, n) != conv.get_hash(l2, s2, n)) {
+            return false;
+        }
+
         for (unsigned i = 0; i < n; i++) {
             if (l1_val[s1+i] != l2_val[s2+i]) {
                 return false;
@@ -88,16 +134,16 @@ namespace smt::noodler {
         return true;
     }
 
-    LenNode VarConstraint::align_literals(const zstring& l1, const zstring& l2, const std::map<zstring, BasicTerm>& conv) {
-        zstring l1_val = conv.at(l1).get_name();
-        zstring l2_val = conv.at(l2).get_name();
+    LenNode VarConstraint::align_literals(const BasicTerm& l1, const BasicTerm& l2, const LiteralTable& conv) {
+        const zstring& l1_val = conv.get_value(l1).get_name();
+        const zstring& l2_val = conv.get_value(l2).get_name();
 
         if (l1_val.length() == 1) {
             if (l2_val.length() == 1) {
                 if (l1_val[0] == l2_val[0]) {
                     return LenNode(LenFormulaType::TRUE, {});
                 } else {
-                    return LenNode(LenFormulaType::NOT, {LenNode(LenFormulaType::EQ, {begin_of(l1, this->_name), begin_of(l2, this->_name)})});
+                    return LenNode(LenFormulaType::NOT, {LenNode(LenFormulaType::EQ, {begin_of(l1.get_name(), this->_var.get_name()), begin_of(l2.get_name(), this->_var.get_name())})});
                 }
             }
         }
@@ -105,26 +151,26 @@ namespace smt::noodler {
         std::vector<unsigned> overlays{};
 
         for (unsigned n = 1; n <= l2_val.length() + l1_val.length() - 1; ++n) {
-            if (zstr_comp(l1_val, l2_val, n)) {
+            if (zstr_comp(l1, l2, n, conv)) {
                 overlays.emplace_back(n);
             }
         }
 
-        LenNode before (LenFormulaType::LEQ, {LenNode(LenFormulaType::PLUS, {begin_of(l1, this->_name), rational(l1_val.length())}), begin_of(l2, this->_name)});
-        LenNode after (LenFormulaType::LEQ, {LenNode(LenFormulaType::PLUS, {begin_of(l2, this->_name), rational(l2_val.length())}), begin_of(l1, this->_name)});
+        LenNode before (LenFormulaType::LEQ, {LenNode(LenFormulaType::PLUS, {begin_of(l1.get_name(), this->_var.get_name()), rational(l1_val.length())}), begin_of(l2.get_name(), this->_var.get_name())});
+        LenNode after (LenFormulaType::LEQ, {LenNode(LenFormulaType::PLUS, {begin_of(l2.get_name(), this->_var.get_name()), rational(l2_val.length())}), begin_of(l1.get_name(), this->_var.get_name())});
         std::vector<LenNode> align{before, after};
         for (unsigned i : overlays) {
             // b(l1) = b(l2) + |l2| - i
             align.emplace_back(LenNode(LenFormulaType::EQ, {
-                LenNode(LenFormulaType::PLUS, {begin_of(l1, this->_name), rational(i)}),
-                LenNode(LenFormulaType::PLUS, {begin_of(l2, this->_name), rational(l2_val.length())})
+                LenNode(LenFormulaType::PLUS, {begin_of(l1.get_name(), this->_var.get_name()), rational(i)}),
+                LenNode(LenFormulaType::PLUS, {begin_of(l2.get_name(), this->_var.get_name()), rational(l2_val.length())})
             }));
         }
 
         return LenNode(LenFormulaType::OR, align);
     }
 
-    LenNode VarConstraint::get_lengths(const std::map<zstring,VarConstraint>& pool, const std::map<zstring,BasicTerm>& conv) {
+    LenNode VarConstraint::get_lengths(const VarConstraintPool& pool, const LiteralTable& conv) {
         std::vector<LenNode> form{};
 
         // lits alignment
@@ -140,7 +186,7 @@ namespace smt::noodler {
 
             for (const BasicTerm& t : side) {
                 if (t.get_type() == BasicTermType::Literal) {
-                    side_len.emplace_back(conv.at(t.get_name()));
+                    side_len.emplace_back(conv.get_value(t));
                 } else {
                     side_len.emplace_back(t);
                 }
@@ -155,9 +201,10 @@ namespace smt::noodler {
 
             for (const BasicTerm& t : side) {
                 form.emplace_back(generate_begin(t.get_name(), last));
-                if (t.get_type() == BasicTermType::Variable && pool.count(t.get_name())) {
-                    for (const zstring& lit : pool.at(t.get_name()).get_lits()) {
-                        form.emplace_back(generate_begin(lit, t.get_name()));
+                const VarConstraint* constr = (t.get_type() == BasicTermType::Variable) ? pool.find(t) : nullptr;
+                if (constr != nullptr) {
+                    for (const BasicTerm& lit : constr->get_lits()) {
+                        form.emplace_back(generate_begin(lit.get_name(), t.get_name()));
                     }
                 }
                 last = t;
@@ -165,7 +212,7 @@ namespace smt::noodler {
         }
 
         STRACE("str",
-            tout << "Length constraints on variable " << this->_name << "\n-----\n";
+            tout << "Length constraints on variable " << this->_var << "\n-----\n";
             for (LenNode c : form) {
                 tout << c << std::endl;
             }
@@ -179,20 +226,20 @@ namespace smt::noodler {
     LenNode VarConstraint::generate_begin(const zstring& var_name, const BasicTerm& last, bool precise) {
         LenNode end_of_last = (last.get_type() == BasicTermType::Length)
             ? LenNode(0)
-            : LenNode(LenFormulaType::PLUS, {begin_of(last.get_name(), this->_name), last});
+            : LenNode(LenFormulaType::PLUS, {begin_of(last.get_name(), this->_var.get_name()), last});
 
         LenFormulaType ftype = precise ? LenFormulaType::EQ : LenFormulaType::LEQ;
-        LenNode out = LenNode(ftype, {end_of_last, begin_of(var_name, this->_name)});
+        LenNode out = LenNode(ftype, {end_of_last, begin_of(var_name, this->_var.get_name())});
         
         return out;
     }
 
     LenNode VarConstraint::generate_begin(const zstring& lit, const zstring& from) {
-        LenNode out (LenFormulaType::EQ, {begin_of(lit, this->_name), LenNode(LenFormulaType::PLUS, {begin_of(lit, from), begin_of(from, this->_name)})});
+        LenNode out (LenFormulaType::EQ, {begin_of(lit, this->_var.get_name()), LenNode(LenFormulaType::PLUS, {begin_of(lit, from), begin_of(from, this->_var.get_name())})});
         return out;
     }
 
-    bool VarConstraint::parse(std::map<zstring,VarConstraint>& pool, std::map<zstring,BasicTerm>& conv) {
+    bool VarConstraint::parse(VarConstraintPool& pool, LiteralTable& conv) {
         if (is_parsed == l_true) {
             return true;	// Already parsed
         }
@@ -205,32 +252,33 @@ namespace smt::noodler {
 
         // parse derived
         for (const Concat& side : _constr_eqs) {
-            std::vector<zstring> lits_in_side {};
+            std::vector<BasicTerm> lits_in_side {};
             for (const BasicTerm& t : side) {
                 if (t.get_type() == BasicTermType::Literal) {
-                    lits_in_side.emplace_back(t.get_name());
+                    lits_in_side.emplace_back(t);
                 }
                 if (t.get_type() == BasicTermType::Variable) {
-                    // parse constrained variables
-                    if (pool.count(t.get_name())) {
-                        if (pool[t.get_name()].parse(pool, conv) == false) {
+                    // parse constrained variables (the pool does not grow while parsing, so the pointer stays valid)
+                    VarConstraint* constr = pool.find(t);
+                    if (constr != nullptr) {
+                        if (constr->parse(pool, conv) == false) {
                             return false;	// There is a cycle
                         }
 
-                        for (const zstring& lit : pool[t.get_name()].get_lits()) {
+                        for (const BasicTerm& lit : constr->get_lits()) {
                             lits_in_side.emplace_back(lit);
                         }
                     }
                 }
             }
 
-            for (const zstring& l1 : _lits) {
-                for (const zstring& l2 : lits_in_side) {
+            for (const BasicTerm& l1 : _lits) {
+                for (const BasicTerm& l2 : lits_in_side) {
                     _alignments.emplace_back(l1, l2);
                 }
             }
 
-            for (const zstring& l : lits_in_side) {
+            for (const BasicTerm& l : lits_in_side) {
                 _lits.emplace_back(l);
             }
         }
@@ -242,7 +290,7 @@ namespace smt::noodler {
     }
 
     std::string VarConstraint::to_string() const {
-        std::string ret = "#####\n# VarConstraint: " + _name.encode() + "\n###\n#";
+        std::string ret = "#####\n# VarConstraint: " + _var.get_name().encode() + "\n###\n#";
         bool first = true;
         for (const Concat& side : _constr_eqs) {
             if (!first) {
@@ -258,9 +306,9 @@ namespace smt::noodler {
 
         ret += "\n###\n# lits:";
 
-        for (const zstring& t :_lits) {
+        for (const BasicTerm& t :_lits) {
             // for explicit: ... lname ...
-            ret += " " + t.encode(); // + ((t.parent_var == "") ? "" : ("("+t.parent_var.encode()+")"));
+            ret += " " + t.get_name().encode(); // + ((t.parent_var == "") ? "" : ("("+t.parent_var.encode()+")"));
         }
 
         ret += "\n#####\n";
@@ -274,32 +322,25 @@ namespace smt::noodler {
         return os;
     }
 
-    zstring LengthDecisionProcedure::generate_lit_alias(const BasicTerm& lit, std::map<zstring, BasicTerm>& lit_conversion) {
-        zstring new_lit_name = util::mk_noodler_var_fresh("lit").get_name();
-        // lit_conversion[new_lit_name] = lit;
-        lit_conversion.emplace(std::make_pair(new_lit_name, lit));
-        return new_lit_name;
+    BasicTerm LengthDecisionProcedure::generate_lit_alias(const BasicTerm& lit, LiteralTable& lit_conversion) {
+        BasicTerm alias(BasicTermType::Literal, util::mk_noodler_var_fresh("lit").get_name());
+        lit_conversion.add(alias, lit);
+        return alias;
     }
 
-    void LengthDecisionProcedure::add_to_pool(std::map<zstring, VarConstraint>& pool, const Predicate& pred) {
+    void LengthDecisionProcedure::add_to_pool(VarConstraintPool& pool, const Predicate& pred) {
         bool in_pool = false;
 
         for (const Concat& side : pred.get_params()) {
             if (side.size() == 1 && side[0].get_type() == BasicTermType::Variable) {
-                zstring var_name = side[0].get_name();
-                if (pool.count(var_name) == 0) {
-                    pool[var_name] = VarConstraint(var_name);
-                }
-                pool[var_name].add(pred, lit_conversion);
+                pool.get_or_create(side[0]).add(pred, lit_conversion);
 
                 in_pool = true;
             }
         }
 
         if (!in_pool) {
-            zstring fresh = util::mk_noodler_var_fresh("f").get_name();
-            pool[fresh] = VarConstraint(fresh);
-            pool[fresh].add(pred, lit_conversion);
+            pool.get_or_create(util::mk_noodler_var_fresh("f")).add(pred, lit_conversion);
         }
     }
 
@@ -354,7 +395,7 @@ namespace smt::noodler {
 
         STRACE("str", tout << "True\n"; );
 
-        std::map<zstring, VarConstraint> pool{};
+        VarConstraintPool pool{};
 
         for (const Predicate& pred : this->formula.get_predicates()) {
             add_to_pool(pool, pred);
@@ -362,14 +403,12 @@ namespace smt::noodler {
 
         STRACE("str",
             tout << "Conversions:\n-----\n";
-            for (auto c : lit_conversion) {
-                tout << c.first << " : " << c.second << std::endl;
-            }
+            tout << lit_conversion.to_string();
             tout << "-----\n";
         );  
 
-        for (std::pair<zstring, VarConstraint> it : pool) {
-            if (pool[it.first].parse(pool, lit_conversion) == false) {
+        for (VarConstraint& constr : pool) {
+            if (constr.parse(pool, lit_conversion) == false) {
                 // There is a cycle
                 STRACE("str", tout << "len: Cyclic dependecy.\n";);
                 return l_undef;	// We cannot solve this formula
@@ -381,8 +420,8 @@ namespace smt::noodler {
             implicit_len_formula.emplace_back(LenNode(LenFormulaType::LEQ, {0, v}));
         }
 
-        for (std::pair<zstring, VarConstraint> it : pool) {
-            computed_len_formula.emplace_back(pool[it.first].get_lengths(pool, lit_conversion));
+        for (VarConstraint& constr : pool) {
+            computed_len_formula.emplace_back(constr.get_lengths(pool, lit_conversion));
         }
 
         STRACE("str", tout << "len: Finished computing.\n");
@@ -415,28 +454,28 @@ namespace smt::noodler {
 
     lbool LengthDecisionProcedure::preprocess(PreprocessType opt, const BasicTermEqiv &len_eq_vars) {
 
-        FormulaPreprocessor prep_handler(this->formula, this->init_aut_ass, this->init_length_sensitive_vars, m_params);
-
         STRACE("str", tout << "len: Preprocessing\n");
 
-        prep_handler.remove_trivial();
-        prep_handler.reduce_diseqalities(); // only makes variable a literal or removes the disequation 
+        // remove_trivial and reduce_diseqalities are shared with DecisionProcedure preprocessing the same instance
+        FormulaPreprocessor prep_handler = PreprocessMemo::get_shared(preprocess_memo, this->formula, this->init_aut_ass,
+                                                                      this->init_length_sensitive_vars, m_params, preprocess_profile, literal_store);
+        PreprocessScheduler sched(prep_handler, preprocess_profile);
 
         // Underapproximate if it contains inequations
         for (const BasicTerm& t : this->formula.get_vars()) {
             if (prep_handler.get_aut_assignment().is_co_finite(t)) {
-                prep_handler.underapprox_languages();
+                sched.run("underapprox_languages", PREP_ALL, [&](FormulaPreprocessor& p) { p.underapprox_languages(); });
                 this->precision = LenNodePrecision::UNDERAPPROX;
                 STRACE("str", tout << " - UNDERAPPROXIMATE languages\n";);
                 break;
             }
         }
 
-        prep_handler.propagate_eps();
-        prep_handler.propagate_variables();
-        prep_handler.generate_identities();
-        prep_handler.propagate_variables();
-        prep_handler.remove_trivial();
+        sched.run("propagate_eps", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_eps(); });
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
+        sched.run("generate_identities", PREP_ALL, [&](FormulaPreprocessor& p) { p.generate_identities(); });
+        sched.run("propagate_variables", PREP_ALL, [&](FormulaPreprocessor& p) { p.propagate_variables(); });
+        sched.run("remove_trivial", PREP_FORMULA, [&](FormulaPreprocessor& p) { p.remove_trivial(); });
         
         // Refresh the instance
         this->formula = prep_handler.get_modified_formula();
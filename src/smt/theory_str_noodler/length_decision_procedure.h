@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <deque>
+#include <unordered_map>
 #include <algorithm>
 
 #include "smt/params/theory_str_noodler_params.h"
@@ -12,16 +13,54 @@
 #include "aut_assignment.h"
 #include "formula_preprocess.h"
 #include "decision_procedure.h"
+#include "literal_store.h"
 
 namespace smt::noodler {
 
+    /**
+     * @brief Literals of the length-based procedure named by their aliases (literal terms with fresh names).
+     *
+     * Hashes of all prefixes of the values of literals are precomputed (by the literal store of the session if it is
+     * set, see LiteralStore), so that the hash of any substring of a value is obtained in constant time (e.g., for an
+     * alignment of a prefix and a suffix of two literals).
+     */
+    class LiteralTable {
+    private:
+        struct Entry {
+            BasicTerm value;
+            std::shared_ptr<const LiteralStore::Literal> literal;
+        };
+
+        std::unordered_map<BasicTerm, Entry> entries;
+        // powers[i] = BASE^i, for i up to the length of the longest literal
+        std::vector<uint64_t> powers{1};
+        // store of the session providing the hashes (not used if nullptr)
+        LiteralStore* store = nullptr;
+
+    public:
+        void set_store(LiteralStore* literal_store) { store = literal_store; }
+
+        void add(const BasicTerm& alias, const BasicTerm& value);
+
+        const BasicTerm& get_value(const BasicTerm& alias) const { return entries.at(alias).value; }
+
+        /**
+         * @brief Get the hash of the @p n symbols of the value of @p alias starting at @p from.
+         */
+        uint64_t get_hash(const BasicTerm& alias, unsigned from, unsigned n) const;
+
+        std::string to_string() const;
+    };
+
+    class VarConstraintPool;
+
     class VarConstraint
     {
     private:
-        zstring _name;
+        BasicTerm _var;
         std::vector<Concat> _constr_eqs;	// All sides of equations on the opposite side of this variable
-        std::vector<zstring> _lits; // Literals occuring explicitly and in contained variables
-        std::vector<std::pair<zstring, zstring>> _alignments;   // All literals, that should be aligned
+        std::vector<BasicTerm> _lits; // Literals (aliases) occuring explicitly and in contained variables
+        std::vector<std::pair<BasicTerm, BasicTerm>> _alignments;   // All literals, that should be aligned
 
         /**
          * @brief 
@@ -31,21 +70,21 @@ namespace smt::noodler {
          * @return false 
          */
         bool check_side(const Concat& side);
-        void emplace(const Concat& c, std::map<zstring, BasicTerm>& lit_conversion);
+        void emplace(const Concat& c, LiteralTable& lit_conversion);
         LenNode generate_begin(const zstring& var_name, const BasicTerm& last, bool precise=true);
         LenNode generate_begin(const zstring& lit, const zstring& from);
         LenNode generate_side_eq(const std::vector<LenNode>& side_len);
-        LenNode align_literals(const zstring& l1, const zstring& l2, const std::map<zstring, BasicTerm>& conv);
+        LenNode align_literals(const BasicTerm& l1, const BasicTerm& l2, const LiteralTable& conv);
         lbool is_parsed;
-        static bool zstr_comp(const zstring& l1_val, const zstring& l2_val, unsigned n);
+        static bool zstr_comp(const BasicTerm& l1, const BasicTerm& l2, unsigned n, const LiteralTable& conv);
     public:
-        VarConstraint() : _name(), is_parsed (l_false) {};
-        VarConstraint(zstring name) : _name(std::move(name)), is_parsed (l_false) {};
-        bool add(const Predicate& pred, std::map<zstring, BasicTerm>& lit_conversion);
+        VarConstraint() : _var(BasicTermType::Variable), is_parsed (l_false) {};
+        VarConstraint(BasicTerm var) : _var(std::move(var)), is_parsed (l_false) {};
+        bool add(const Predicate& pred, LiteralTable& lit_conversion);
         std::string to_string() const;
 
         // !!! Must be called after parse !!!
-        const std::vector<zstring>& get_lits() const;
+        const std::vector<BasicTerm>& get_lits() const;
 
 
         // TODO: already generate here
@@ -56,9 +95,33 @@ namespace smt::noodler {
          * @param conv conversions for literals
          * @return bool success
          */
-        bool parse(std::map<zstring,VarConstraint>& pool, std::map<zstring,BasicTerm>& conv);
+        bool parse(VarConstraintPool& pool, LiteralTable& conv);
 
-        LenNode get_lengths(const std::map<zstring,VarConstraint>& pool, const std::map<zstring,BasicTerm>& conv);
+        LenNode get_lengths(const VarConstraintPool& pool, const LiteralTable& conv);
+    };
+
+    /**
+     * @brief Constraints of variables of the length-based procedure, stored densely and indexed by the ids of the variables.
+     */
+    class VarConstraintPool {
+    private:
+        std::vector<VarConstraint> constraints;
+        // index to constraints for each id of variable (see BasicTerm::get_id)
+        std::unordered_map<unsigned, size_t> index;
+
+    public:
+        /**
+         * @brief Get the constraint of @p var, a new one is created if there is none.
+         */
+        VarConstraint& get_or_create(const BasicTerm& var);
+        /**
+         * @brief Get the constraint of @p var (nullptr if there is none).
+         */
+        VarConstraint* find(const BasicTerm& var);
+        const VarConstraint* find(const BasicTerm& var) const;
+
+        std::vector<VarConstraint>::iterator begin() { return constraints.begin(); }
+        std::vector<VarConstraint>::iterator end() { return constraints.end(); }
     };
 
     /**
@@ -72,15 +135,22 @@ namespace smt::noodler {
         AutAssignment init_aut_ass;
         const theory_str_noodler_params& m_params;
 
-        std::map<zstring, BasicTerm> lit_conversion {};	// Naming literals differently from their value
+        LiteralTable lit_conversion {};	// Naming literals differently from their value
 
         // the length formula from preprocessing, get_lengths should create conjunct with it
         LenNode preprocessing_len_formula = LenNode(LenFormulaType::TRUE,{});
         std::vector<LenNode> computed_len_formula = {};
         std::vector<LenNode> implicit_len_formula = {};
+
+        // profile of preprocessing passes (not recorded if nullptr)
+        PreprocessProfile* preprocess_profile = nullptr;
+        // literal store of the session (not used if nullptr)
+        LiteralStore* literal_store = nullptr;
+        // memo of the shared preprocessing passes (not used if nullptr)
+        PreprocessMemo* preprocess_memo = nullptr;
     public:
         LenNodePrecision precision = LenNodePrecision::PRECISE;
-        static zstring generate_lit_alias(const BasicTerm& lit, std::map<zstring, BasicTerm>& lit_conversion);
+        static BasicTerm generate_lit_alias(const BasicTerm& lit, LiteralTable& lit_conversion);
 
         /**
          * Initialize a new decision procedure that can solve language (dis)equality constraints.
@@ -112,9 +182,27 @@ namespace smt::noodler {
 
         lbool preprocess(PreprocessType opt = PreprocessType::PLAIN, const BasicTermEqiv &len_eq_vars = {}) override;
 
+        /**
+         * @brief Set the profile to which preprocess() records its passes.
+         */
+        void set_preprocess_profile(PreprocessProfile* profile) { preprocess_profile = profile; }
+
+        /**
+         * @brief Set the memo of the session from which preprocess() takes the instance after the shared passes.
+         */
+        void set_preprocess_memo(PreprocessMemo* memo) { preprocess_memo = memo; }
+
+        /**
+         * @brief Set the literal store of the session used for the literals of the formula.
+         */
+        void set_literal_store(LiteralStore* store) {
+            literal_store = store;
+            lit_conversion.set_store(store);
+        }
+
         static bool is_suitable(const Formula &form, const AutAssignment& init_aut_ass);
 
-        void add_to_pool(std::map<zstring, VarConstraint>& pool, const Predicate& pred);
+        void add_to_pool(VarConstraintPool& pool, const Predicate& pred);
     };
 }
 
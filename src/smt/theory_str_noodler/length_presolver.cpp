@@ -0,0 +1,277 @@
+#include "length_presolver.h"
+
+namespace smt::noodler {
+
+    unsigned LengthPresolver::get_var(expr* e) {
+        unsigned idx;
+        if (m_var2idx.find(e, idx)) {
+            return idx;
+        }
+        idx = m_vars.size();
+        m_vars.push_back(e);
+        m_var2idx.insert(e, idx);
+        return idx;
+    }
+
+    /**
+     * @brief Add @p coeff * @p e to @p lc.
+     *
+     * @return false if @p e is not a linear integer term
+     */
+    bool LengthPresolver::linearize(expr* e, const rational& coeff, LinearConstraint& lc) {
+        rational val;
+        bool is_int;
+        if (m_util_a.is_numeral(e, val, is_int)) {
+            if (!is_int) {
+                return false;
+            }
+            lc.constant += coeff * val;
+            return true;
+        }
+        if (!m_util_a.is_int(e)) {
+            return false;
+        }
+        if (m_util_a.is_add(e)) {
+            for (expr* arg : *to_app(e)) {
+                if (!linearize(arg, coeff, lc)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (m_util_a.is_sub(e)) {
+            app* a = to_app(e);
+            for (unsigned i = 0; i < a->get_num_args(); ++i) {
+                if (!linearize(a->get_arg(i), i == 0 ? coeff : -coeff, lc)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        expr* arg;
+        if (m_util_a.is_uminus(e, arg)) {
+            return linearize(arg, -coeff, lc);
+        }
+        if (m_util_a.is_mul(e)) {
+            // product of numerals and at most one other term
+            rational factor(1);
+            expr* term = nullptr;
+            for (expr* a : *to_app(e)) {
+                if (m_util_a.is_numeral(a, val, is_int) && is_int) {
+                    factor *= val;
+                } else if (term == nullptr) {
+                    term = a;
+                } else {
+                    return false;
+                }
+            }
+            if (term == nullptr) {
+                lc.constant += coeff * factor;
+                return true;
+            }
+            return linearize(term, coeff * factor, lc);
+        }
+        expr* dividend, *divisor;
+        if (m_util_a.is_mod(e, dividend, divisor) && m_util_a.is_numeral(divisor, val, is_int) && is_int && val.is_pos()) {
+            // (mod x d) = x - d*q where the quotient q is an integer variable represented by the mod term
+            // (length constraints of automata with loops are of this form)
+            lc.coeffs[get_var(e)] -= coeff * val;
+            return linearize(dividend, coeff, lc);
+        }
+        if (is_app(e) && to_app(e)->get_family_id() == m_util_a.get_family_id()) {
+            // div, mod, to_int, ... are not in the fragment
+            return false;
+        }
+        if (m.is_ite(e)) {
+            return false;
+        }
+        // uninterpreted integer term (variable, str.len(x), ...)
+        lc.coeffs[get_var(e)] += coeff;
+        return true;
+    }
+
+    /**
+     * @brief Add the (negated if @p sign) atom @p atom to the constraints, atoms outside of the fragment are ignored.
+     *
+     * @return false if the atom is trivially unsatisfiable
+     */
+    bool LengthPresolver::add_atom(expr* atom, bool sign) {
+        if (m.is_true(atom)) {
+            return !sign;
+        }
+        if (m.is_false(atom)) {
+            return sign;
+        }
+
+        expr *lhs, *rhs;
+        // lhs - rhs <= 0 (resp. < 0, == 0) after moving everything to the left
+        bool strict = false;
+        bool is_eq = false;
+        bool swap = false;
+        if (m_util_a.is_le(atom, lhs, rhs)) {
+            // x <= y, negated y < x
+            swap = sign; strict = sign;
+        } else if (m_util_a.is_ge(atom, lhs, rhs)) {
+            // y <= x, negated x < y
+            swap = !sign; strict = sign;
+        } else if (m_util_a.is_lt(atom, lhs, rhs)) {
+            // x < y, negated y <= x
+            swap = sign; strict = !sign;
+        } else if (m_util_a.is_gt(atom, lhs, rhs)) {
+            // y < x, negated x <= y
+            swap = !sign; strict = !sign;
+        } else if (m.is_eq(atom, lhs, rhs) && m_util_a.is_int(lhs)) {
+            if (sign) {
+                // disequalities are not in the fragment
+                return true;
+            }
+            is_eq = true;
+        } else {
+            return true;
+        }
+        if (swap) {
+            std::swap(lhs, rhs);
+        }
+
+        LinearConstraint lc;
+        lc.is_eq = is_eq;
+        if (!linearize(lhs, rational(1), lc) || !linearize(rhs, rational(-1), lc)) {
+            return true;
+        }
+        if (strict) {
+            // integers: lhs - rhs < 0 iff lhs - rhs + 1 <= 0
+            lc.constant += rational(1);
+        }
+        m_constraints.push_back(std::move(lc));
+        return true;
+    }
+
+    /**
+     * @brief Remove zero coefficients of @p lc and normalize it by the gcd of its coefficients.
+     *
+     * @return false if @p lc is unsatisfiable on its own
+     */
+    bool LengthPresolver::check_constraint(LinearConstraint& lc) {
+        rational g(0);
+        for (auto it = lc.coeffs.begin(); it != lc.coeffs.end(); ) {
+            if (it->second.is_zero()) {
+                it = lc.coeffs.erase(it);
+            } else {
+                g = gcd(g, abs(it->second));
+                ++it;
+            }
+        }
+        if (lc.coeffs.empty()) {
+            return lc.is_eq ? lc.constant.is_zero() : !lc.constant.is_pos();
+        }
+        if (lc.is_eq) {
+            if (!(lc.constant / g).is_int()) {
+                return false;
+            }
+            lc.constant /= g;
+        } else {
+            // sum c*x <= -k iff sum (c/g)*x <= floor(-k/g) = -ceil(k/g)
+            lc.constant = ceil(lc.constant / g);
+        }
+        for (auto& [var, coeff] : lc.coeffs) {
+            coeff /= g;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check the difference constraints among m_constraints for a negative cycle (Bellman-Ford).
+     */
+    bool LengthPresolver::has_negative_cycle() {
+        // edge (from, to, w) stands for to - from <= w, node 0 is the constant zero
+        struct Edge { unsigned from; unsigned to; rational w; };
+        std::vector<Edge> edges;
+        auto add_diff = [&](unsigned x, unsigned y, const rational& k) {
+            // x - y <= k
+            edges.push_back({ y, x, k });
+        };
+        for (const LinearConstraint& lc : m_constraints) {
+            unsigned pos = 0, neg = 0;
+            unsigned num_pos = 0, num_neg = 0;
+            bool unit = true;
+            for (const auto& [var, coeff] : lc.coeffs) {
+                if (coeff.is_one()) {
+                    pos = var + 1; ++num_pos;
+                } else if (coeff.is_minus_one()) {
+                    neg = var + 1; ++num_neg;
+                } else {
+                    unit = false;
+                }
+            }
+            if (!unit || num_pos > 1 || num_neg > 1) {
+                continue;
+            }
+            // pos - neg + constant <= 0 (resp. == 0), where a missing variable is the node 0
+            add_diff(pos, neg, -lc.constant);
+            if (lc.is_eq) {
+                add_diff(neg, pos, lc.constant);
+            }
+        }
+        if (edges.empty()) {
+            return false;
+        }
+
+        const unsigned num_nodes = m_vars.size() + 1;
+        if (static_cast<uint64_t>(num_nodes) * edges.size() > 10000000) {
+            return false;
+        }
+        // all distances start at 0 (virtual source connected to all nodes)
+        std::vector<rational> dist(num_nodes, rational(0));
+        // with the virtual source there are num_nodes + 1 nodes, a change in the last round means a negative cycle
+        for (unsigned round = 0; round <= num_nodes; ++round) {
+            bool changed = false;
+            for (const Edge& e : edges) {
+                rational d = dist[e.from] + e.w;
+                if (d < dist[e.to]) {
+                    dist[e.to] = d;
+                    changed = true;
+                }
+            }
+            if (!changed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    lbool LengthPresolver::check(expr* formula) {
+        m_vars.reset();
+        m_var2idx.reset();
+        m_constraints.clear();
+
+        // flatten the conjunction, (e, sign) stands for e if !sign and (not e) otherwise
+        std::vector<std::pair<expr*, bool>> todo{ { formula, false } };
+        unsigned num_conjuncts = 0;
+        while (!todo.empty()) {
+            auto [e, sign] = todo.back();
+            todo.pop_back();
+            expr* arg;
+            if (m.is_not(e, arg)) {
+                todo.push_back({ arg, !sign });
+            } else if ((!sign && m.is_and(e)) || (sign && m.is_or(e))) {
+                for (expr* a : *to_app(e)) {
+                    todo.push_back({ a, sign });
+                }
+            } else {
+                if (++num_conjuncts > m_max_conjuncts) {
+                    return l_undef;
+                }
+                if (!add_atom(e, sign)) {
+                    return l_false;
+                }
+            }
+        }
+
+        for (LinearConstraint& lc : m_constraints) {
+            if (!check_constraint(lc)) {
+                return l_false;
+            }
+        }
+        return has_negative_cycle() ? l_false : l_undef;
+    }
+}
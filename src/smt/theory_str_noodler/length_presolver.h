@@ -0,0 +1,65 @@
+#ifndef _NOODLER_LENGTH_PRESOLVER_H_
+#define _NOODLER_LENGTH_PRESOLVER_H_
+
+#include <map>
+#include <vector>
+
+#include "ast/ast.h"
+#include "ast/arith_decl_plugin.h"
+#include "util/rational.h"
+#include "util/lbool.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Cheap refutation of length formulas before they are checked by the arithmetic solver.
+     *
+     * The length formulas of the decision procedures are mostly conjunctions of difference constraints (x - y <= k),
+     * bounds, sums of lengths and periodic constraints (x = a + k*n). The presolver takes the conjuncts of a formula
+     * that are linear integer (in)equalities and checks
+     *   - constant conjuncts,
+     *   - divisibility of equalities (the gcd of the coefficients must divide the constant, this refutes
+     *     periodic constraints with incompatible periods),
+     *   - negative cycles in the graph of the difference constraints and bounds (after normalizing each
+     *     inequality by the gcd of its coefficients).
+     * The other conjuncts are ignored, so the presolver checks a relaxation of the formula: it returns l_false
+     * only if the formula is unsatisfiable, and l_undef otherwise (the formula has to be checked by the full
+     * solver, together with the context it depends on).
+     */
+    class LengthPresolver {
+        // linear constraint sum coeffs[x]*x + constant <= 0 (or == 0 if is_eq)
+        struct LinearConstraint {
+            std::map<unsigned, rational> coeffs;
+            rational constant;
+            bool is_eq = false;
+        };
+
+        ast_manager& m;
+        arith_util m_util_a;
+        // maximal number of conjuncts, bigger formulas are left to the full solver
+        unsigned m_max_conjuncts;
+
+        // variables of the constraints, indexed by their numbers used in LinearConstraint::coeffs
+        ptr_vector<expr> m_vars;
+        obj_map<expr, unsigned> m_var2idx;
+        std::vector<LinearConstraint> m_constraints;
+
+        unsigned get_var(expr* e);
+        bool linearize(expr* e, const rational& coeff, LinearConstraint& lc);
+        bool add_atom(expr* atom, bool sign);
+        bool check_constraint(LinearConstraint& lc);
+        bool has_negative_cycle();
+
+    public:
+        LengthPresolver(ast_manager& m, unsigned max_conjuncts = 2000) : m(m), m_util_a(m), m_max_conjuncts(max_conjuncts) {}
+
+        /**
+         * @brief Try to refute @p formula.
+         *
+         * @return l_false if @p formula is unsatisfiable, l_undef if it could not be decided
+         */
+        lbool check(expr* formula);
+    };
+}
+
+#endif
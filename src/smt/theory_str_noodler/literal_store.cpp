@@ -0,0 +1,39 @@
+#include "literal_store.h"
+
+namespace smt::noodler {
+
+    std::shared_ptr<const LiteralStore::Literal> LiteralStore::get(const zstring& value) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = literals.find(value);
+            if (it != literals.end()) {
+                return it->second;
+            }
+        }
+        // the hashes are computed outside of the lock, a literal stored meanwhile by another thread is kept
+        std::shared_ptr<const Literal> literal = make_literal(value);
+        std::lock_guard<std::mutex> guard(lock);
+        auto [it, inserted] = literals.emplace(value, std::move(literal));
+        if (inserted) {
+            // the value is kept twice (as the key and in the literal) and two hashes are kept for each symbol
+            bytes += sizeof(Literal) + 2 * value.length() * (sizeof(unsigned) + sizeof(uint64_t)) + 4 * sizeof(void*);
+        }
+        return it->second;
+    }
+
+    std::shared_ptr<const LiteralStore::Literal> LiteralStore::make_literal(const zstring& value) {
+        auto literal = std::make_shared<Literal>();
+        literal->value = value;
+        const unsigned length = value.length();
+        literal->prefix_hashes.reserve(length + 1);
+        literal->suffix_hashes.reserve(length + 1);
+        literal->prefix_hashes.push_back(0);
+        literal->suffix_hashes.push_back(0);
+        for (unsigned i = 0; i < length; ++i) {
+            // unsigned overflow gives the hash modulo 2^64
+            literal->prefix_hashes.push_back(literal->prefix_hashes.back() * BASE + value[i] + 1);
+            literal->suffix_hashes.push_back(literal->suffix_hashes.back() * BASE + value[length - 1 - i] + 1);
+        }
+        return literal;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef _NOODLER_LITERAL_STORE_H_
+#define _NOODLER_LITERAL_STORE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "util/zstring.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Values of string literals with precomputed hashes of their prefixes and suffixes.
+     *
+     * The store keeps each value once (indexed by its hash) for the whole session (see NoodlerSession), so the hashes
+     * of literals occurring in successive final checks are computed only once. Whether two literals agree on their
+     * first (last) min(|l1|, |l2|) symbols, i.e., whether one of them can be a prefix (suffix) of the other, is then
+     * decided by comparing two hashes. A collision of hashes only makes two different literals look compatible, so
+     * the answer "incompatible" is always exact. The literals are never changed, get() can be called concurrently.
+     */
+    class LiteralStore {
+    public:
+        struct Literal {
+            zstring value;
+            // prefix_hashes[i] is the polynomial hash of the first i symbols of value
+            std::vector<uint64_t> prefix_hashes;
+            // suffix_hashes[i] is the polynomial hash of the last i symbols of value read backwards
+            std::vector<uint64_t> suffix_hashes;
+        };
+
+        static constexpr uint64_t BASE = 1000003;
+
+        /**
+         * @brief Get the stored literal with the value @p value (storing it if there is none yet).
+         */
+        std::shared_ptr<const Literal> get(const zstring& value);
+
+        /**
+         * @brief Create a literal with the value @p value that is not stored.
+         */
+        static std::shared_ptr<const Literal> make_literal(const zstring& value);
+
+        /**
+         * @brief Is one of @p l1 and @p l2 a prefix of the other one? (Can return true also for a collision of hashes.)
+         */
+        static bool prefix_compatible(const Literal& l1, const Literal& l2) {
+            const unsigned n = std::min(l1.value.length(), l2.value.length());
+            return l1.prefix_hashes[n] == l2.prefix_hashes[n];
+        }
+
+        /**
+         * @brief Is one of @p l1 and @p l2 a suffix of the other one? (Can return true also for a collision of hashes.)
+         */
+        static bool suffix_compatible(const Literal& l1, const Literal& l2) {
+            const unsigned n = std::min(l1.value.length(), l2.value.length());
+            return l1.suffix_hashes[n] == l2.suffix_hashes[n];
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return literals.size();
+        }
+
+        /**
+         * @brief Get the approximate memory of the stored literals in bytes.
+         */
+        size_t get_bytes() const {
+            std::lock_guard<std::mutex> guard(lock);
+            return bytes;
+        }
+
+        void reset() {
+            std::lock_guard<std::mutex> guard(lock);
+            literals.clear();
+            bytes = 0;
+        }
+
+    private:
+        struct ZstringHash {
+            size_t operator()(const zstring& s) const { return s.hash(); }
+        };
+
+        std::unordered_map<zstring, std::shared_ptr<const Literal>, ZstringHash> literals;
+        size_t bytes = 0;
+        mutable std::mutex lock;
+    };
+}
+
+#endif
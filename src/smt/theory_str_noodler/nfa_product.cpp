@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "nfa_product.h"
+
+namespace smt::noodler {
+
+    namespace {
+        using mata::Symbol;
+        using mata::nfa::State;
+
+        constexpr State NO_STATE = std::numeric_limits<State>::max();
+
+        /**
+         * @brief Transitions of an automaton in arrays: the transitions of a state s over symbols[i] lead to
+         * targets[target_begin[i]], ..., targets[target_begin[i + 1] - 1] for post_begin[s] <= i < post_begin[s + 1].
+         */
+        struct FlatDelta {
+            std::vector<size_t> post_begin;
+            std::vector<Symbol> symbols;
+            std::vector<size_t> target_begin;
+            std::vector<State> targets;
+            std::vector<bool> is_final;
+            bool has_epsilon = false;
+
+            explicit FlatDelta(const mata::nfa::Nfa& nfa) : is_final(nfa.num_of_states(), false) {
+                const size_t num_of_states = nfa.num_of_states();
+                post_begin.reserve(num_of_states + 1);
+                for (State s = 0; s < num_of_states; ++s) {
+                    post_begin.push_back(symbols.size());
+                    for (const auto& symbol_post : nfa.delta[s]) {
+                        has_epsilon = has_epsilon || symbol_post.symbol >= mata::nfa::EPSILON;
+                        symbols.push_back(symbol_post.symbol);
+                        target_begin.push_back(targets.size());
+                        targets.insert(targets.end(), symbol_post.targets.begin(), symbol_post.targets.end());
+                    }
+                }
+                post_begin.push_back(symbols.size());
+                target_begin.push_back(targets.size());
+                for (State s : nfa.final) {
+                    is_final[s] = true;
+                }
+            }
+        };
+
+        /**
+         * @brief Get the first index in [@p from, @p to) whose symbol is at least @p symbol (@p to if there is none),
+         * the symbol at @p from is smaller than @p symbol.
+         */
+        size_t skip_to(const std::vector<Symbol>& symbols, size_t from, size_t to, Symbol symbol) {
+            size_t step = 1;
+            while (from + step < to && symbols[from + step] < symbol) {
+                from += step;
+                step *= 2;
+            }
+            return std::lower_bound(symbols.begin() + from, symbols.begin() + std::min(from + step, to), symbol) - symbols.begin();
+        }
+
+        struct Transition {
+            State source;
+            Symbol symbol;
+            State target;
+        };
+    }
+
+    mata::nfa::Nfa intersect(const mata::nfa::Nfa& lhs, const mata::nfa::Nfa& rhs) {
+        const FlatDelta left(lhs);
+        const FlatDelta right(rhs);
+        if (left.has_epsilon || right.has_epsilon) {
+            return mata::nfa::intersection(lhs, rhs);
+        }
+
+        const size_t num_right = rhs.num_of_states();
+        const bool dense = lhs.num_of_states() * num_right <= DENSE_PRODUCT_LIMIT;
+        std::vector<State> dense_index(dense ? lhs.num_of_states() * num_right : 0, NO_STATE);
+        std::unordered_map<size_t, State> sparse_index;
+        // pairs of the product states (also the queue of the exploration, the states are explored in their order)
+        std::vector<std::pair<State, State>> pairs;
+        auto get_state = [&](State l, State r) {
+            const size_t key = static_cast<size_t>(l) * num_right + r;
+            State* state = dense ? &dense_index[key] : &sparse_index.try_emplace(key, NO_STATE).first->second;
+            if (*state == NO_STATE) {
+                *state = static_cast<State>(pairs.size());
+                pairs.emplace_back(l, r);
+            }
+            return *state;
+        };
+
+        for (State l : lhs.initial) {
+            for (State r : rhs.initial) {
+                get_state(l, r);
+            }
+        }
+        const size_t num_initial = pairs.size();
+
+        // the transitions are created sorted by their sources and symbols
+        std::vector<Transition> transitions;
+        for (State state = 0; state < pairs.size(); ++state) {
+            const auto [l, r] = pairs[state];
+            size_t i = left.post_begin[l];
+            const size_t i_end = left.post_begin[l + 1];
+            size_t j = right.post_begin[r];
+            const size_t j_end = right.post_begin[r + 1];
+            while (i < i_end && j < j_end) {
+                if (left.symbols[i] < right.symbols[j]) {
+                    i = skip_to(left.symbols, i, i_end, right.symbols[j]);
+                } else if (right.symbols[j] < left.symbols[i]) {
+                    j = skip_to(right.symbols, j, j_end, left.symbols[i]);
+                } else {
+                    for (size_t ti = left.target_begin[i]; ti < left.target_begin[i + 1]; ++ti) {
+                        for (size_t tj = right.target_begin[j]; tj < right.target_begin[j + 1]; ++tj) {
+                            // get_state can extend pairs, so the pair is not referenced here
+                            transitions.push_back({ state, left.symbols[i], get_state(left.targets[ti], right.targets[tj]) });
+                        }
+                    }
+                    ++i;
+                    ++j;
+                }
+            }
+        }
+
+        // all states are reachable, the useful ones are those from which a final state is reachable (predecessors
+        // are found in the transitions sorted by their targets)
+        std::vector<size_t> pred_begin(pairs.size() + 1, 0);
+        for (const Transition& trans : transitions) {
+            ++pred_begin[trans.target + 1];
+        }
+        for (size_t s = 0; s < pairs.size(); ++s) {
+            pred_begin[s + 1] += pred_begin[s];
+        }
+        std::vector<State> preds(transitions.size());
+        {
+            std::vector<size_t> next = pred_begin;
+            for (const Transition& trans : transitions) {
+                preds[next[trans.target]++] = trans.source;
+            }
+        }
+        std::vector<bool> useful(pairs.size(), false);
+        std::vector<State> worklist;
+        for (State state = 0; state < pairs.size(); ++state) {
+            if (left.is_final[pairs[state].first] && right.is_final[pairs[state].second]) {
+                useful[state] = true;
+                worklist.push_back(state);
+            }
+        }
+        while (!worklist.empty()) {
+            const State state = worklist.back();
+            worklist.pop_back();
+            for (size_t k = pred_begin[state]; k < pred_begin[state + 1]; ++k) {
+                if (!useful[preds[k]]) {
+                    useful[preds[k]] = true;
+                    worklist.push_back(preds[k]);
+                }
+            }
+        }
+
+        std::vector<State> renaming(pairs.size(), NO_STATE);
+        State num_useful = 0;
+        for (State state = 0; state < pairs.size(); ++state) {
+            if (useful[state]) {
+                renaming[state] = num_useful++;
+            }
+        }
+        mata::nfa::Nfa result(num_useful, {}, {});
+        for (State state = 0; state < num_initial; ++state) {
+            if (useful[state]) {
+                result.initial.insert(renaming[state]);
+            }
+        }
+        for (State state = 0; state < pairs.size(); ++state) {
+            if (useful[state] && left.is_final[pairs[state].first] && right.is_final[pairs[state].second]) {
+                result.final.insert(renaming[state]);
+            }
+        }
+        for (const Transition& trans : transitions) {
+            if (useful[trans.source] && useful[trans.target]) {
+                result.delta.add(renaming[trans.source], trans.symbol, renaming[trans.target]);
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef _NOODLER_NFA_PRODUCT_H_
+#define _NOODLER_NFA_PRODUCT_H_
+
+#include <mata/nfa/nfa.hh>
+
+namespace smt::noodler {
+
+    /**
+     * @brief Get the trimmed product (intersection) of @p lhs and @p rhs, all intersections of the noodler go
+     * through it.
+     *
+     * The transitions of both automata are first flattened to arrays sorted by states and symbols, so the
+     * transitions of a pair of states are matched by a merge of two contiguous arrays of symbols (a long run of
+     * smaller symbols, e.g. of sigma star against a word, is skipped by galloping). The pairs of states are indexed
+     * by a dense table if the product has at most DENSE_PRODUCT_LIMIT pairs, by a hash map otherwise. Only the pairs
+     * reachable from the initial ones are created and the result contains only those from which a final pair is
+     * reachable. Automata with epsilon transitions are intersected by mata::nfa::intersection().
+     */
+    mata::nfa::Nfa intersect(const mata::nfa::Nfa& lhs, const mata::nfa::Nfa& rhs);
+
+    // the maximal number of pairs of states indexed by a dense table (4 bytes per pair)
+    constexpr size_t DENSE_PRODUCT_LIMIT = 1 << 22;
+}
+
+#endif
@@ -0,0 +1,446 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <random>
+
+#if !defined(_WINDOWS) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "util/util.h"
+#include "nfa_store.h"
+#include "util.h"
+
+namespace smt::noodler {
+
+    namespace {
+        const char STORE_MAGIC[8] = { 'N', 'O', 'O', 'D', 'N', 'F', 'A', '\0' };
+        const uint32_t STORE_VERSION = 1;
+        // written in the native byte order, a store written on a machine with another byte order is rejected
+        const uint32_t STORE_BYTE_ORDER = 0x01020304;
+
+        struct StoreHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t byte_order;
+            uint64_t num_entries;
+        };
+
+        struct StoreIndexEntry {
+            uint64_t lo;
+            uint64_t hi;
+            // offset of the entry (in bytes from the start of the file) and its number of 32-bit words
+            uint64_t offset;
+            uint64_t num_words;
+        };
+
+        // number of words of an entry before the arrays of states and transitions
+        const uint64_t ENTRY_HEADER_WORDS = 4;
+
+        uint64_t mix(uint64_t x) {
+            // finalizer of splitmix64
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+
+        /**
+         * @brief Incremental 128-bit hash (two independent 64-bit lanes), stable across processes and platforms.
+         */
+        struct FingerprintHasher {
+            uint64_t lo = 0x9e3779b97f4a7c15ULL;
+            uint64_t hi = 0xc2b2ae3d27d4eb4fULL;
+
+            void add(uint64_t value) {
+                lo = mix(lo ^ value);
+                hi = mix(hi + value * 0xff51afd7ed558ccdULL);
+            }
+
+            void add(const std::string& str) {
+                add(str.size());
+                for (unsigned char c : str) {
+                    add(c);
+                }
+            }
+
+            void add(const NfaFingerprint& fingerprint) {
+                add(fingerprint.lo);
+                add(fingerprint.hi);
+            }
+        };
+
+        void add_parameter(FingerprintHasher& hasher, const parameter& param) {
+            if (param.is_int()) {
+                hasher.add(static_cast<uint64_t>(param.get_int()));
+            } else if (param.is_zstring()) {
+                hasher.add(param.get_zstring().encode());
+            } else if (param.is_symbol()) {
+                hasher.add(param.get_symbol().str());
+            } else if (param.is_rational()) {
+                hasher.add(param.get_rational().to_string());
+            } else if (param.is_ast() && is_sort(param.get_ast())) {
+                hasher.add(to_sort(param.get_ast())->get_name().str());
+            } else {
+                hasher.add(static_cast<uint64_t>(param.get_kind()));
+            }
+        }
+
+        /**
+         * @brief Encode @p nfa as an entry of the store (see NfaStore).
+         */
+        std::vector<uint32_t> encode_nfa(const mata::nfa::Nfa& nfa) {
+            std::vector<uint32_t> words;
+            words.push_back(static_cast<uint32_t>(nfa.num_of_states()));
+            words.push_back(static_cast<uint32_t>(nfa.initial.size()));
+            words.push_back(static_cast<uint32_t>(nfa.final.size()));
+            words.push_back(0);
+            for (mata::nfa::State s : nfa.initial) {
+                words.push_back(static_cast<uint32_t>(s));
+            }
+            for (mata::nfa::State s : nfa.final) {
+                words.push_back(static_cast<uint32_t>(s));
+            }
+            uint32_t num_transitions = 0;
+            for (mata::nfa::State s = 0; s < nfa.num_of_states(); ++s) {
+                for (const auto& symbol_post : nfa.delta[s]) {
+                    for (mata::nfa::State t : symbol_post.targets) {
+                        words.push_back(static_cast<uint32_t>(s));
+                        words.push_back(static_cast<uint32_t>(symbol_post.symbol));
+                        words.push_back(static_cast<uint32_t>(t));
+                        ++num_transitions;
+                    }
+                }
+            }
+            words[3] = num_transitions;
+            return words;
+        }
+
+        /**
+         * @brief View of the entry @p words, checking that it is well-formed.
+         */
+        bool decode_entry(const uint32_t* words, uint64_t num_words, NfaView& view) {
+            if (num_words < ENTRY_HEADER_WORDS) {
+                return false;
+            }
+            view.num_states = words[0];
+            view.num_initial = words[1];
+            view.num_final = words[2];
+            view.num_transitions = words[3];
+            if (num_words != ENTRY_HEADER_WORDS + uint64_t(view.num_initial) + view.num_final + 3 * uint64_t(view.num_transitions)) {
+                return false;
+            }
+            view.initial = words + ENTRY_HEADER_WORDS;
+            view.final = view.initial + view.num_initial;
+            view.transitions = view.final + view.num_final;
+            return true;
+        }
+
+        void write_word(std::ostream& out, uint32_t word) {
+            out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+        }
+
+        void write_words(std::ostream& out, const std::vector<uint32_t>& words) {
+            write_word(out, static_cast<uint32_t>(words.size()));
+            out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+        }
+
+        void write_name(std::ostream& out, const std::string& name) {
+            write_word(out, static_cast<uint32_t>(name.size()));
+            out.write(name.data(), name.size());
+        }
+
+        [[noreturn]] void fail_assignment(const std::string& what) {
+            util::throw_error("malformed automata assignment: " + what);
+            UNREACHABLE();
+        }
+
+        uint32_t read_word(std::istream& in) {
+            uint32_t word;
+            if (!in.read(reinterpret_cast<char*>(&word), sizeof(word))) {
+                fail_assignment("unexpected end of input");
+            }
+            return word;
+        }
+    }
+
+    NfaFingerprint fingerprint_regex(const app* regex, const std::set<uint32_t>& alphabet, bool determinize, bool complement) {
+        // structural hash of the regex DAG (each subregex is hashed once)
+        obj_map<app, NfaFingerprint> hashes;
+        std::vector<std::pair<app*, bool>> stack{ { const_cast<app*>(regex), false } };
+        while (!stack.empty()) {
+            auto [node, children_done] = stack.back();
+            if (hashes.contains(node)) {
+                stack.pop_back();
+                continue;
+            }
+            if (!children_done) {
+                stack.back().second = true;
+                for (expr* arg : *node) {
+                    if (is_app(arg) && !hashes.contains(to_app(arg))) {
+                        stack.push_back({ to_app(arg), false });
+                    }
+                }
+                continue;
+            }
+            stack.pop_back();
+            FingerprintHasher hasher;
+            func_decl* decl = node->get_decl();
+            hasher.add(decl->get_name().str());
+            hasher.add(decl->get_range()->get_name().str());
+            hasher.add(decl->get_num_parameters());
+            for (unsigned i = 0; i < decl->get_num_parameters(); ++i) {
+                add_parameter(hasher, decl->get_parameter(i));
+            }
+            hasher.add(node->get_num_args());
+            for (expr* arg : *node) {
+                if (is_app(arg)) {
+                    hasher.add(hashes[to_app(arg)]);
+                } else {
+                    // not a regex that can be converted, only its kind is taken into account
+                    hasher.add(static_cast<uint64_t>(arg->get_kind()));
+                }
+            }
+            hashes.insert(node, { hasher.lo, hasher.hi });
+        }
+
+        FingerprintHasher hasher;
+        hasher.add(hashes[const_cast<app*>(regex)]);
+        hasher.add(alphabet.size());
+        for (uint32_t symbol : alphabet) {
+            hasher.add(symbol);
+        }
+        hasher.add(determinize);
+        hasher.add(complement);
+        return { hasher.lo, hasher.hi };
+    }
+
+    mata::nfa::Nfa NfaView::to_nfa() const {
+        mata::nfa::Nfa nfa(num_states, {}, {});
+        for (uint32_t i = 0; i < num_initial; ++i) {
+            nfa.initial.insert(initial[i]);
+        }
+        for (uint32_t i = 0; i < num_final; ++i) {
+            nfa.final.insert(final[i]);
+        }
+        // the transitions are sorted, so they can be appended to the posts of the states
+        for (uint32_t i = 0; i < num_transitions; ++i) {
+            const uint32_t* transition = transitions + 3 * size_t(i);
+            nfa.delta.add(transition[0], transition[1], transition[2]);
+        }
+        return nfa;
+    }
+
+    std::unique_ptr<NfaStore> NfaStore::open(const std::string& path) {
+        std::unique_ptr<NfaStore> store(new NfaStore());
+#if !defined(_WINDOWS) && !defined(_WIN32)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            util::throw_error("cannot read the automata store " + path);
+        }
+        store->m_size = static_cast<size_t>(file_stat.st_size);
+        if (store->m_size > 0) {
+            void* data = mmap(nullptr, store->m_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                util::throw_error("cannot map the automata store " + path);
+            }
+            store->m_data = static_cast<const unsigned char*>(data);
+            store->m_mapped = true;
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return nullptr;
+        }
+        store->m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        store->m_data = store->m_buffer.data();
+        store->m_size = store->m_buffer.size();
+#endif
+
+        StoreHeader header;
+        if (store->m_size < sizeof(header)) {
+            util::throw_error("automata store " + path + " is truncated");
+        }
+        std::memcpy(&header, store->m_data, sizeof(header));
+        if (std::memcmp(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 || header.version != STORE_VERSION || header.byte_order != STORE_BYTE_ORDER) {
+            util::throw_error("file " + path + " is not an automata store of this version");
+        }
+        if (header.num_entries > (store->m_size - sizeof(header)) / sizeof(StoreIndexEntry)) {
+            util::throw_error("automata store " + path + " is truncated");
+        }
+        store->m_num_entries = static_cast<size_t>(header.num_entries);
+        // all entries are checked once, so that later lookups cannot read out of the file
+        for (size_t i = 0; i < store->m_num_entries; ++i) {
+            const StoreIndexEntry* entry = reinterpret_cast<const StoreIndexEntry*>(store->m_data + sizeof(header)) + i;
+            NfaView view;
+            if (entry->offset % sizeof(uint32_t) != 0 || entry->offset > store->m_size || entry->num_words > (store->m_size - entry->offset) / sizeof(uint32_t)
+                    || !decode_entry(reinterpret_cast<const uint32_t*>(store->m_data + entry->offset), entry->num_words, view)) {
+                util::throw_error("automata store " + path + " has a malformed entry");
+            }
+        }
+        return store;
+    }
+
+    NfaStore::~NfaStore() {
+#if !defined(_WINDOWS) && !defined(_WIN32)
+        if (m_mapped) {
+            munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+#endif
+    }
+
+    NfaFingerprint NfaStore::get_fingerprint(size_t i) const {
+        const StoreIndexEntry* entry = reinterpret_cast<const StoreIndexEntry*>(m_data + sizeof(StoreHeader)) + i;
+        return { entry->lo, entry->hi };
+    }
+
+    NfaView NfaStore::get_view(size_t i) const {
+        const StoreIndexEntry* entry = reinterpret_cast<const StoreIndexEntry*>(m_data + sizeof(StoreHeader)) + i;
+        NfaView view;
+        VERIFY(decode_entry(reinterpret_cast<const uint32_t*>(m_data + entry->offset), entry->num_words, view));
+        return view;
+    }
+
+    bool NfaStore::find(const NfaFingerprint& fingerprint, NfaView& view) const {
+        size_t begin = 0, end = m_num_entries;
+        while (begin < end) {
+            size_t middle = begin + (end - begin) / 2;
+            NfaFingerprint middle_fingerprint = get_fingerprint(middle);
+            if (middle_fingerprint == fingerprint) {
+                view = get_view(middle);
+                return true;
+            }
+            if (middle_fingerprint < fingerprint) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+        return false;
+    }
+
+    void NfaStoreWriter::add(const NfaFingerprint& fingerprint, const mata::nfa::Nfa& nfa) {
+        if (m_entries.find(fingerprint) == m_entries.end()) {
+            m_entries.emplace(fingerprint, encode_nfa(nfa));
+        }
+    }
+
+    void NfaStoreWriter::add(const NfaFingerprint& fingerprint, const NfaView& view) {
+        if (m_entries.find(fingerprint) != m_entries.end()) {
+            return;
+        }
+        std::vector<uint32_t> words{ view.num_states, view.num_initial, view.num_final, view.num_transitions };
+        words.insert(words.end(), view.initial, view.initial + view.num_initial);
+        words.insert(words.end(), view.final, view.final + view.num_final);
+        words.insert(words.end(), view.transitions, view.transitions + 3 * size_t(view.num_transitions));
+        m_entries.emplace(fingerprint, std::move(words));
+    }
+
+    void NfaStoreWriter::add_all(const NfaStore& store) {
+        store.for_each([this](const NfaFingerprint& fingerprint, const NfaView& view) { add(fingerprint, view); });
+    }
+
+    bool NfaStoreWriter::write(const std::string& path) const {
+        const std::string tmp_path = path + ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            StoreHeader header;
+            std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+            header.version = STORE_VERSION;
+            header.byte_order = STORE_BYTE_ORDER;
+            header.num_entries = m_entries.size();
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            uint64_t offset = sizeof(StoreHeader) + m_entries.size() * sizeof(StoreIndexEntry);
+            for (const auto& [fingerprint, words] : m_entries) {
+                StoreIndexEntry entry{ fingerprint.lo, fingerprint.hi, offset, words.size() };
+                out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+                offset += words.size() * sizeof(uint32_t);
+            }
+            for (const auto& [fingerprint, words] : m_entries) {
+                out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+            }
+            if (!out.flush()) {
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void write_aut_assignment(std::ostream& out, const AutAssignment& aut_ass) {
+        out.write(STORE_MAGIC, sizeof(STORE_MAGIC));
+        write_word(out, STORE_VERSION);
+        write_word(out, STORE_BYTE_ORDER);
+        const std::set<mata::Symbol> alphabet = const_cast<AutAssignment&>(aut_ass).get_alphabet();
+        write_words(out, std::vector<uint32_t>(alphabet.begin(), alphabet.end()));
+        write_word(out, static_cast<uint32_t>(aut_ass.size()));
+        for (const auto& [term, nfa] : aut_ass) {
+            write_word(out, static_cast<uint32_t>(term.get_type()));
+            write_name(out, term.get_name().encode());
+            write_words(out, encode_nfa(*nfa));
+        }
+    }
+
+    AutAssignment read_aut_assignment(std::istream& in) {
+        char magic[sizeof(STORE_MAGIC)];
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0) {
+            fail_assignment("missing header");
+        }
+        if (read_word(in) != STORE_VERSION || read_word(in) != STORE_BYTE_ORDER) {
+            fail_assignment("unsupported version or byte order");
+        }
+        auto read_words = [&]() {
+            std::vector<uint32_t> words(read_word(in));
+            if (!in.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(uint32_t))) {
+                fail_assignment("unexpected end of input");
+            }
+            return words;
+        };
+
+        AutAssignment aut_ass;
+        std::vector<uint32_t> alphabet = read_words();
+        uint32_t num_automata = read_word(in);
+        for (uint32_t i = 0; i < num_automata; ++i) {
+            uint32_t type = read_word(in);
+            if (type > static_cast<uint32_t>(BasicTermType::Length)) {
+                fail_assignment("unknown term type");
+            }
+            std::string name(read_word(in), '\0');
+            if (!in.read(name.data(), name.size())) {
+                fail_assignment("unexpected end of input");
+            }
+            std::vector<uint32_t> words = read_words();
+            NfaView view;
+            if (!decode_entry(words.data(), words.size(), view)) {
+                fail_assignment("malformed automaton");
+            }
+            aut_ass[BasicTerm(static_cast<BasicTermType>(type), zstring(name.c_str()))] = std::make_shared<mata::nfa::Nfa>(view.to_nfa());
+        }
+        aut_ass.set_alphabet(std::set<uint32_t>(alphabet.begin(), alphabet.end()));
+        return aut_ass;
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef _NOODLER_NFA_STORE_H_
+#define _NOODLER_NFA_STORE_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <mata/nfa/nfa.hh>
+
+#include "ast/ast.h"
+#include "aut_assignment.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief 128-bit fingerprint of a regex together with the alphabet and the flags of its conversion to NFA.
+     *
+     * Unlike the pointer of a (hash-consed) regex, the fingerprint is computed from the structure of the regex only,
+     * so it is the same in all processes (and runs) solving a formula with the same regex.
+     */
+    struct NfaFingerprint {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+
+        bool operator==(const NfaFingerprint& other) const { return lo == other.lo && hi == other.hi; }
+        bool operator<(const NfaFingerprint& other) const { return hi < other.hi || (hi == other.hi && lo < other.lo); }
+    };
+
+    /**
+     * @brief Fingerprint of the conversion of @p regex over @p alphabet (see regex::conv_to_nfa).
+     */
+    NfaFingerprint fingerprint_regex(const app* regex, const std::set<uint32_t>& alphabet, bool determinize, bool complement);
+
+    /**
+     * @brief Automaton stored in an NfaStore, the arrays point directly into the mapped file.
+     */
+    struct NfaView {
+        uint32_t num_states = 0;
+        uint32_t num_initial = 0;
+        uint32_t num_final = 0;
+        uint32_t num_transitions = 0;
+        const uint32_t* initial = nullptr;
+        const uint32_t* final = nullptr;
+        // triples (source, symbol, target) sorted by the source and the symbol
+        const uint32_t* transitions = nullptr;
+
+        mata::nfa::Nfa to_nfa() const;
+    };
+
+    /**
+     * @brief Read-only file of automata keyed by fingerprints of regexes, used to warm-start regex::NfaCache.
+     *
+     * The file is mapped to memory (POSIX mmap, it is read into memory where mmap is not available), so the pages are
+     * shared by all processes using the same file, and it is never modified once written (NfaStoreWriter replaces the
+     * file atomically). The layout (in the native byte order, which is checked on opening) is
+     *   header:  magic "NOODNFA", version, byte order mark, number of entries,
+     *   index:   (fingerprint, offset, number of words) for each entry, sorted by the fingerprint,
+     *   entries: 32-bit words num_states, num_initial, num_final, num_transitions, initial states, final states and
+     *            the transitions as triples (source, symbol, target).
+     * A lookup is a binary search in the mapped index and the arrays of an entry are used in place (see NfaView).
+     */
+    class NfaStore {
+    public:
+        /**
+         * @brief Open the store in the file @p path.
+         *
+         * @return The store or nullptr if the file does not exist
+         * @throws default_exception if the file is not a valid store
+         */
+        static std::unique_ptr<NfaStore> open(const std::string& path);
+
+        ~NfaStore();
+        NfaStore(const NfaStore&) = delete;
+        NfaStore& operator=(const NfaStore&) = delete;
+
+        /**
+         * @brief Find the automaton with @p fingerprint.
+         *
+         * @param[out] view The automaton (set only if it is found)
+         */
+        bool find(const NfaFingerprint& fingerprint, NfaView& view) const;
+
+        size_t size() const { return m_num_entries; }
+
+        /**
+         * @brief Call @p fnc for each stored automaton (used to merge stores).
+         */
+        template<typename Fnc>
+        void for_each(Fnc&& fnc) const {
+            for (size_t i = 0; i < m_num_entries; ++i) {
+                fnc(get_fingerprint(i), get_view(i));
+            }
+        }
+
+    private:
+        NfaStore() = default;
+
+        NfaFingerprint get_fingerprint(size_t i) const;
+        NfaView get_view(size_t i) const;
+
+        const unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_num_entries = 0;
+        // the content of the file if it is not mapped
+        std::vector<unsigned char> m_buffer;
+        bool m_mapped = false;
+    };
+
+    /**
+     * @brief Writer of the files read by NfaStore.
+     */
+    class NfaStoreWriter {
+    public:
+        void add(const NfaFingerprint& fingerprint, const mata::nfa::Nfa& nfa);
+        void add(const NfaFingerprint& fingerprint, const NfaView& view);
+
+        /**
+         * @brief Add all automata of @p store (the automata added before are kept for equal fingerprints).
+         */
+        void add_all(const NfaStore& store);
+
+        size_t size() const { return m_entries.size(); }
+
+        /**
+         * @brief Write the store to a temporary file which then replaces @p path, so that the processes which have
+         * the old file mapped are not affected.
+         *
+         * @return True if the file could be written
+         */
+        bool write(const std::string& path) const;
+
+    private:
+        std::map<NfaFingerprint, std::vector<uint32_t>> m_entries;
+    };
+
+    /**
+     * @brief Write @p aut_ass to @p out in the binary format of automata of NfaStore (prefixed by its terms).
+     */
+    void write_aut_assignment(std::ostream& out, const AutAssignment& aut_ass);
+
+    /**
+     * @brief Read an assignment written by write_aut_assignment() from @p in.
+     *
+     * @throws default_exception if the input is malformed
+     */
+    AutAssignment read_aut_assignment(std::istream& in);
+}
+
+#endif
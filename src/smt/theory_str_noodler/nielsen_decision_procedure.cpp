@@ -1,6 +1,13 @@
 #include <queue>
 #include <utility>
 #include <algorithm>
+#include <optional>
+#ifndef SINGLE_THREAD
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#endif
 
 #include <mata/nfa/strings.hh>
 
@@ -56,12 +63,15 @@ namespace smt::noodler {
 
             std::vector<Formula> instances = divide_independent_formula(this->formula);
             for(const Formula& fle : instances) {
-                bool is_sat;
+                bool is_sat, is_complete;
                 // create Nielsen graph and trim it
-                NielsenGraph graph = generate_from_formula(fle, this->init_length_sensitive_vars.empty(), is_sat);
+                NielsenGraph graph = generate_graph(fle, this->init_length_sensitive_vars.empty(), is_sat, is_complete);
+                if (is_cancelled()) {
+                    return l_undef;
+                }
                 if (!is_sat) {
-                    // if some Nielsen graph is unsat --> unsat
-                    return l_false;
+                    // if some Nielsen graph is unsat --> unsat (unless it was cut by the depth bound)
+                    return is_complete ? l_false : l_undef;
                 }
                 graph = graph.trim();
                 this->graphs.push_back(graph);
@@ -70,21 +80,9 @@ namespace smt::noodler {
                 if(this->init_length_sensitive_vars.size() == 0) {
                     continue;
                 }
-                // create a counter system from the Nielsen graph a condensate it
-                CounterSystem counter_system;
-                if (!create_counter_system(graph, counter_system)) {
-                    return l_undef;
-                }
-                condensate_counter_system(counter_system);
-                condensate_counter_system(counter_system);
                 this->length_paths.push_back({});
-                // create paths with self-loops containing the desired length variables
-                for(const auto& c : find_self_loops(counter_system)) {
-                    Path<CounterLabel> path;
-                    if (!get_length_path(counter_system, c, path)) {
-                        return l_undef;
-                    }
-                    this->length_paths[this->length_paths.size() - 1].push_back(path);
+                if (!get_graph_length_paths(graph, this->length_paths.back())) {
+                    return l_undef;
                 }
             }
         } else {
@@ -212,29 +210,82 @@ namespace smt::noodler {
      * @param[out] is_sat Contains the Nielsen graph an accepting node?
      * @return NielsenGraph 
      */
-    NielsenGraph NielsenDecisionProcedure::generate_from_formula(const Formula& init, bool early_termination, bool & is_sat) const {
+    namespace {
+        // item of the worklist of the Nielsen graph generation: the formula, the index of its first
+        // predicate that may not be satisfied, the depth of the formula in the graph and its cost
+        struct NielsenItem {
+            size_t index;
+            unsigned depth;
+            unsigned cost;
+            Formula formula;
+        };
+
+        // the priority queue prefers smaller formulae (higher probability to reach a final node)
+        struct NielsenItemCmp {
+            bool operator()(const NielsenItem& it1, const NielsenItem& it2) const {
+                return it1.cost > it2.cost;
+            }
+        };
+
+        using NielsenWorklist = std::priority_queue<NielsenItem, std::vector<NielsenItem>, NielsenItemCmp>;
+    }
+
+    NielsenGraph NielsenDecisionProcedure::generate_graph(const Formula& init, bool early_termination, bool & is_sat, bool & is_complete) const {
+        const unsigned max_depth = m_params.m_nielsen_max_depth;
+        // iterative deepening: the depth bound is doubled until the graph is complete or max_depth is reached
+        unsigned depth = (max_depth == 0) ? 0 : std::min(max_depth, 8u);
+        while(true) {
+            bool depth_reached = false;
+            NielsenGraph graph;
+#ifndef SINGLE_THREAD
+            if(early_termination && m_params.m_nielsen_threads > 1 && m_params.m_deterministic) {
+                graph = generate_from_formula_rounds(init, is_sat, depth, depth_reached, m_params.m_nielsen_threads);
+            } else if(early_termination && m_params.m_nielsen_threads > 1) {
+                graph = generate_from_formula_parallel(init, is_sat, depth, depth_reached, m_params.m_nielsen_threads);
+            } else
+#endif
+            {
+                graph = generate_from_formula(init, early_termination, is_sat, depth, depth_reached);
+            }
+            is_complete = !depth_reached;
+            if(is_sat && early_termination) {
+                return graph;
+            }
+            if(!depth_reached || depth >= max_depth || is_cancelled()) {
+                STRACE("str-nielsen", tout << "Nielsen graph generated with depth bound " << depth << (is_complete ? "" : " (incomplete)") << std::endl;);
+                return graph;
+            }
+            depth = (depth > max_depth / 2) ? max_depth : 2 * depth;
+        }
+    }
+
+    NielsenGraph NielsenDecisionProcedure::generate_from_formula(const Formula& init, bool early_termination, bool & is_sat,
+                                                                 unsigned max_depth, bool & depth_reached) const {
         NielsenGraph graph;
-        std::set<Formula> generated;
+        // variables can be renamed only if we do not need the graph (for lengths)
+        NielsenVisitedSet generated(early_termination);
 
-        // use priority queue to prefer smaller formulae (higher probability to reach a final node)
-        auto cmp = [](const auto& pr1, const auto& pr2) { return NielsenDecisionProcedure::get_formula_cost(pr1.second) > NielsenDecisionProcedure::get_formula_cost(pr2.second); };
-        // priority queue sorted by the cost of formula
-        std::priority_queue<std::pair<size_t, Formula>, std::vector<std::pair<size_t, Formula>>, decltype(cmp)> worklist(cmp);
-        worklist.push({0, trim_formula(init)}); 
+        NielsenWorklist worklist;
+        Formula trimmed = trim_formula(init);
+        worklist.push({0, 0, get_formula_cost(trimmed), trimmed}); 
         graph.set_init(init);
 
         is_sat = false;
+        depth_reached = false;
         while(!worklist.empty()) {
-            std::pair<size_t, Formula> pr = worklist.top();
-            size_t index = pr.first;
-            if(generated.find(pr.second) != generated.end()) {
-                worklist.pop();
-                continue;
+            if(is_cancelled()) {
+                // the graph is not complete
+                depth_reached = true;
+                break;
             }
-            generated.insert(pr.second);
+            NielsenItem item = worklist.top();
             worklist.pop();
+            size_t index = item.index;
+            if(!generated.insert(item.formula).second) {
+                continue;
+            }
 
-            std::vector<Predicate> predicates = pr.second.get_predicates();
+            std::vector<Predicate> predicates = item.formula.get_predicates();
             if(is_pred_unsat(predicates[index]) || is_length_unsat(predicates[index])) {
                 continue;
             }
@@ -245,27 +296,369 @@ namespace smt::noodler {
             }
             if(index >= predicates.size()) {
                 is_sat = true;
-                graph.add_fin(pr.second);
+                graph.add_fin(item.formula);
                 if(early_termination) {
                     return graph;
                 }
                 continue;
             }
 
+            if(max_depth != 0 && item.depth >= max_depth) {
+                depth_reached = true;
+                continue;
+            }
+
             std::set<NielsenLabel> rules = get_rules_from_pred(predicates[index]);
             for(const auto& label : rules) {
-                Formula rpl = trim_formula(pr.second.replace(Concat({label.first}), label.second));
-                if(!early_termination) {
-                    graph.add_edge(pr.second, rpl, label);
+                Formula rpl = trim_formula(item.formula.replace(Concat({label.first}), label.second));
+                size_t repr;
+                if(generated.find(rpl, repr)) {
+                    if(!early_termination) {
+                        graph.add_edge(item.formula, generated.get(repr), label);
+                    }
+                } else {
+                    if(!early_termination) {
+                        graph.add_edge(item.formula, rpl, label);
+                    }
+                    worklist.push({index, item.depth + 1, get_formula_cost(rpl), rpl});
+                }
+            }
+        }
+
+        return graph;
+    }
+
+#ifndef SINGLE_THREAD
+    NielsenGraph NielsenDecisionProcedure::generate_from_formula_parallel(const Formula& init, bool & is_sat, unsigned max_depth,
+                                                                          bool & depth_reached, unsigned num_threads) const {
+        NielsenGraph graph;
+        graph.set_init(init);
+
+        // the worklist and the visited set are shared by all workers
+        std::mutex lock;
+        NielsenVisitedSet generated(true);
+        NielsenWorklist worklist;
+        Formula trimmed = trim_formula(init);
+        worklist.push({0, 0, get_formula_cost(trimmed), trimmed});
+        // number of items in the worklist or being expanded
+        std::atomic<unsigned> pending = 1;
+        std::atomic<bool> found = false;
+        std::atomic<bool> cut = false;
+        std::optional<Formula> fin;
+        std::exception_ptr worker_exception = nullptr;
+
+        auto worker_thread = [&]() {
+            try {
+                while(!found && pending > 0) {
+                    if(is_cancelled()) {
+                        cut = true;
+                        break;
+                    }
+                    NielsenItem item;
+                    bool has_item = false, inserted = false;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if(!worklist.empty()) {
+                            item = worklist.top();
+                            worklist.pop();
+                            has_item = true;
+                            inserted = generated.insert(item.formula).second;
+                        }
+                    }
+                    if(!has_item) {
+                        // some other worker is expanding the last items, wait for new ones
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    const std::vector<Predicate>& predicates = item.formula.get_predicates();
+                    size_t index = item.index;
+                    if(!inserted || is_pred_unsat(predicates[index]) || is_length_unsat(predicates[index])) {
+                        --pending;
+                        continue;
+                    }
+                    for(; index < predicates.size(); index++) {
+                        if(!is_pred_sat(predicates[index])) {
+                            break;
+                        }
+                    }
+                    if(index >= predicates.size()) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if(!found) {
+                            found = true;
+                            fin = item.formula;
+                        }
+                        --pending;
+                        continue;
+                    }
+                    if(max_depth != 0 && item.depth >= max_depth) {
+                        cut = true;
+                        --pending;
+                        continue;
+                    }
+
+                    std::vector<NielsenItem> successors;
+                    for(const auto& label : get_rules_from_pred(predicates[index])) {
+                        Formula rpl = trim_formula(item.formula.replace(Concat({label.first}), label.second));
+                        successors.push_back({index, item.depth + 1, get_formula_cost(rpl), std::move(rpl)});
+                    }
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        for(NielsenItem& succ : successors) {
+                            size_t repr;
+                            if(!generated.find(succ.formula, repr)) {
+                                ++pending;
+                                worklist.push(std::move(succ));
+                            }
+                        }
+                    }
+                    --pending;
                 }
-                if(generated.find(rpl) == generated.end()) {
-                    worklist.push({index, rpl});
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if(worker_exception == nullptr) {
+                    worker_exception = std::current_exception();
                 }
+                found = true;
             }
+        };
+
+        std::vector<std::thread> threads;
+        for(unsigned i = 0; i < num_threads; ++i) {
+            threads.emplace_back(worker_thread);
         }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        if(worker_exception != nullptr) {
+            std::rethrow_exception(worker_exception);
+        }
+
+        is_sat = fin.has_value();
+        depth_reached = cut;
+        if(is_sat) {
+            graph.add_fin(*fin);
+        }
+        return graph;
+    }
+
+    NielsenGraph NielsenDecisionProcedure::generate_from_formula_rounds(const Formula& init, bool & is_sat, unsigned max_depth,
+                                                                        bool & depth_reached, unsigned num_threads) const {
+        NielsenGraph graph;
+        graph.set_init(init);
+
+        NielsenVisitedSet generated(true);
+        NielsenWorklist worklist;
+        Formula trimmed = trim_formula(init);
+        worklist.push({0, 0, get_formula_cost(trimmed), trimmed});
+
+        // result of the expansion of one item of a round
+        struct Expansion {
+            bool is_final = false;
+            bool cut = false;
+            std::vector<NielsenItem> successors;
+        };
+        std::vector<NielsenItem> round;
+
+        is_sat = false;
+        depth_reached = false;
+        while(!worklist.empty()) {
+            if(is_cancelled()) {
+                depth_reached = true;
+                break;
+            }
+            round.clear();
+            while(round.size() < num_threads && !worklist.empty()) {
+                NielsenItem item = worklist.top();
+                worklist.pop();
+                if(generated.insert(item.formula).second) {
+                    round.push_back(std::move(item));
+                }
+            }
+
+            std::vector<Expansion> expansions(round.size());
+            std::vector<std::exception_ptr> exceptions(round.size(), nullptr);
+            auto expand = [&](size_t rank) {
+                try {
+                    const NielsenItem& item = round[rank];
+                    Expansion& expansion = expansions[rank];
+                    const std::vector<Predicate>& predicates = item.formula.get_predicates();
+                    size_t index = item.index;
+                    if(is_pred_unsat(predicates[index]) || is_length_unsat(predicates[index])) {
+                        return;
+                    }
+                    for(; index < predicates.size(); index++) {
+                        if(!is_pred_sat(predicates[index])) {
+                            break;
+                        }
+                    }
+                    if(index >= predicates.size()) {
+                        expansion.is_final = true;
+                        return;
+                    }
+                    if(max_depth != 0 && item.depth >= max_depth) {
+                        expansion.cut = true;
+                        return;
+                    }
+                    for(const auto& label : get_rules_from_pred(predicates[index])) {
+                        Formula rpl = trim_formula(item.formula.replace(Concat({label.first}), label.second));
+                        expansion.successors.push_back({index, item.depth + 1, get_formula_cost(rpl), std::move(rpl)});
+                    }
+                } catch (...) {
+                    exceptions[rank] = std::current_exception();
+                }
+            };
+            std::vector<std::thread> threads;
+            for(size_t rank = 1; rank < round.size(); ++rank) {
+                threads.emplace_back(expand, rank);
+            }
+            if(!round.empty()) {
+                expand(0);
+            }
+            for(auto& thread : threads) {
+                thread.join();
+            }
+            for(const std::exception_ptr& ex : exceptions) {
+                if(ex != nullptr) {
+                    std::rethrow_exception(ex);
+                }
+            }
 
+            for(size_t rank = 0; rank < round.size(); ++rank) {
+                Expansion& expansion = expansions[rank];
+                if(expansion.is_final) {
+                    is_sat = true;
+                    graph.add_fin(round[rank].formula);
+                    return graph;
+                }
+                depth_reached |= expansion.cut;
+                for(NielsenItem& succ : expansion.successors) {
+                    size_t repr;
+                    if(!generated.find(succ.formula, repr)) {
+                        worklist.push(std::move(succ));
+                    }
+                }
+            }
+        }
         return graph;
     }
+#endif
+
+    /**
+     * @brief Get the canonical form of @p formula. If @p rename_vars, variables are renamed in the order of their
+     * first occurrence in the predicates sorted by their shape (the predicate with variables replaced by a placeholder)
+     * and then the predicates are sorted. Otherwise, the formula is its own canonical form.
+     */
+    Formula NielsenVisitedSet::canonize(const Formula& formula, bool rename_vars) {
+        if(!rename_vars) {
+            return formula;
+        }
+        std::vector<Predicate> preds = formula.get_predicates();
+        static const BasicTerm placeholder(BasicTermType::Variable, "#v");
+        auto shape = [](const Predicate& pred) {
+            std::vector<Concat> sides = pred.get_params();
+            for(Concat& side : sides) {
+                for(BasicTerm& t : side) {
+                    if(t.is_variable()) {
+                        t = placeholder;
+                    }
+                }
+            }
+            return Predicate(pred.get_type(), sides);
+        };
+        std::vector<std::pair<Predicate, Predicate>> shaped;
+        for(const Predicate& pred : preds) {
+            shaped.emplace_back(shape(pred), pred);
+        }
+        std::sort(shaped.begin(), shaped.end());
+
+        std::map<BasicTerm, BasicTerm> renaming;
+        preds.clear();
+        for(const auto& pr : shaped) {
+            std::vector<Concat> sides = pr.second.get_params();
+            for(Concat& side : sides) {
+                for(BasicTerm& t : side) {
+                    if(t.is_variable()) {
+                        auto [it, inserted] = renaming.try_emplace(t, BasicTermType::Variable, ("#v" + std::to_string(renaming.size())).c_str());
+                        t = it->second;
+                    }
+                }
+            }
+            preds.emplace_back(pr.second.get_type(), sides);
+        }
+        std::sort(preds.begin(), preds.end());
+
+        Formula ret;
+        for(Predicate& pred : preds) {
+            ret.add_predicate(std::move(pred));
+        }
+        return ret;
+    }
+
+    uint64_t NielsenVisitedSet::hash(const Formula& canon) {
+        // FNV-1a over the structure of the formula
+        uint64_t res = 14695981039346656037ULL;
+        auto combine = [&res](uint64_t val) {
+            res ^= val;
+            res *= 1099511628211ULL;
+        };
+        for(const Predicate& pred : canon.get_predicates()) {
+            combine(static_cast<uint64_t>(pred.get_type()));
+            for(const Concat& side : pred.get_params()) {
+                combine(side.size());
+                for(const BasicTerm& t : side) {
+                    combine(std::hash<BasicTerm>()(t));
+                }
+            }
+        }
+        return res;
+    }
+
+    size_t NielsenVisitedSet::find_slot(uint64_t hash, const Formula& canon) const {
+        // linear probing, the table is never full (see insert)
+        size_t pos = hash & (slots.size() - 1);
+        while(slots[pos].index != 0 && (slots[pos].hash != hash || !(canonical[slots[pos].index - 1] == canon))) {
+            pos = (pos + 1) & (slots.size() - 1);
+        }
+        return pos;
+    }
+
+    std::pair<size_t, bool> NielsenVisitedSet::insert(const Formula& formula) {
+        Formula canon = canonize(formula, rename_vars);
+        uint64_t h = hash(canon);
+        size_t pos = find_slot(h, canon);
+        if(slots[pos].index != 0) {
+            return {slots[pos].index - 1, false};
+        }
+
+        canonical.push_back(std::move(canon));
+        representatives.push_back(formula);
+        slots[pos] = Slot{h, canonical.size()};
+        // keep the load factor at most 1/2
+        if(2 * canonical.size() > slots.size()) {
+            std::vector<Slot> old_slots = std::move(slots);
+            slots = std::vector<Slot>(2 * old_slots.size());
+            for(const Slot& slot : old_slots) {
+                if(slot.index != 0) {
+                    size_t new_pos = slot.hash & (slots.size() - 1);
+                    while(slots[new_pos].index != 0) {
+                        new_pos = (new_pos + 1) & (slots.size() - 1);
+                    }
+                    slots[new_pos] = slot;
+                }
+            }
+        }
+        return {canonical.size() - 1, true};
+    }
+
+    bool NielsenVisitedSet::find(const Formula& formula, size_t& index) const {
+        Formula canon = canonize(formula, rename_vars);
+        size_t pos = find_slot(hash(canon), canon);
+        if(slots[pos].index == 0) {
+            return false;
+        }
+        index = slots[pos].index - 1;
+        return true;
+    }
 
     /**
      * @brief Trim formula. Trim each predicate in the formula. A predicate is trimmed 
@@ -426,17 +819,18 @@ namespace smt::noodler {
      * where x is a lenght sensitive variable.
      * 
      * @param cs Counter system
+     * @param length_vars Length sensitive variables (named as in @p cs)
      * @return std::set<Formula> Set of nodes containing a suitable self-loop. 
      */
-    std::set<SelfLoop<CounterLabel>> NielsenDecisionProcedure::find_self_loops(const CounterSystem& cs) const {
+    std::set<SelfLoop<CounterLabel>> NielsenDecisionProcedure::find_self_loops(const CounterSystem& cs, const std::set<BasicTerm>& length_vars) const {
         std::set<SelfLoop<CounterLabel>> self_loops;
         for(const Formula& node : cs.get_nodes()) {
             auto it = cs.edges.find(node);
             if(it != cs.edges.end()) {
                 for(const auto& pr : it->second) {
-                    auto lab_it = this->init_length_sensitive_vars.find(pr.second.left);
+                    auto lab_it = length_vars.find(pr.second.left);
                     if(pr.first == node && pr.second.sum[1].get_type() == BasicTermType::Length && 
-                        lab_it != this->init_length_sensitive_vars.end()) {
+                        lab_it != length_vars.end()) {
                         self_loops.insert({node, pr.second});
                     }
                 }
@@ -465,7 +859,111 @@ namespace smt::noodler {
         }
         result = first_opt.value();
         result.append(last_opt.value());
-        result.self_loops.insert(sl);
+        result.self_loops.insert({cs.get_node_id(sl.first), sl.second});
+        return true;
+    }
+
+    bool NielsenDecisionProcedure::get_graph_length_paths(const NielsenGraph& graph, std::vector<Path<CounterLabel>>& result) {
+        // rename variables in the order of their first occurrence in the init node (all variables of the graph occur there)
+        std::map<BasicTerm, BasicTerm> renaming;
+        std::map<BasicTerm, BasicTerm> inverse;
+        for(const Predicate& pred : graph.get_init().get_predicates()) {
+            for(const Concat& side : pred.get_params()) {
+                for(const BasicTerm& t : side) {
+                    if(t.is_variable() && !renaming.contains(t)) {
+                        BasicTerm canon(BasicTermType::Variable, ("#c" + std::to_string(renaming.size())).c_str());
+                        renaming.emplace(t, canon);
+                        inverse.emplace(canon, t);
+                    }
+                }
+            }
+        }
+        auto rename_term = [](const std::map<BasicTerm, BasicTerm>& ren, const BasicTerm& t) {
+            auto it = ren.find(t);
+            return it == ren.end() ? t : it->second;
+        };
+        auto rename_concat = [&](const Concat& con) {
+            Concat ret;
+            for(const BasicTerm& t : con) {
+                ret.push_back(rename_term(renaming, t));
+            }
+            return ret;
+        };
+        auto rename_formula = [&](const Formula& fl) {
+            Formula ret;
+            for(const Predicate& pred : fl.get_predicates()) {
+                ret.add_predicate(Predicate(pred.get_type(), {rename_concat(pred.get_left_side()), rename_concat(pred.get_right_side())}));
+            }
+            return ret;
+        };
+
+        NielsenGraph canon_graph;
+        canon_graph.set_init(rename_formula(graph.get_init()));
+        for(const Formula& fin : graph.get_fins()) {
+            canon_graph.add_fin(rename_formula(fin));
+        }
+        for(const auto& pr : graph.edges) {
+            Formula source = rename_formula(pr.first);
+            for(const auto& trans : pr.second) {
+                canon_graph.add_edge(source, rename_formula(trans.first), {rename_term(renaming, trans.second.first), rename_concat(trans.second.second)});
+            }
+        }
+        std::set<BasicTerm> canon_length_vars;
+        for(const BasicTerm& t : this->init_length_sensitive_vars) {
+            if(renaming.contains(t)) {
+                canon_length_vars.insert(renaming.at(t));
+            }
+        }
+
+        CanonicalGraphKey key{canon_graph.get_init(), canon_graph.get_fins(), canon_graph.edges, canon_length_vars};
+        auto it = this->length_paths_cache.find(key);
+        if(it == this->length_paths_cache.end()) {
+            std::optional<std::vector<Path<CounterLabel>>> paths = std::vector<Path<CounterLabel>>();
+            // create a counter system from the Nielsen graph a condensate it
+            CounterSystem counter_system;
+            if (!create_counter_system(canon_graph, counter_system)) {
+                paths = std::nullopt;
+            } else {
+                condensate_counter_system(counter_system);
+                condensate_counter_system(counter_system);
+                // create paths with self-loops containing the desired length variables
+                for(const auto& c : find_self_loops(counter_system, canon_length_vars)) {
+                    Path<CounterLabel> path;
+                    if (!get_length_path(counter_system, c, path)) {
+                        paths = std::nullopt;
+                        break;
+                    }
+                    paths->push_back(std::move(path));
+                }
+            }
+            it = this->length_paths_cache.emplace(std::move(key), std::move(paths)).first;
+        } else {
+            STRACE("str-nielsen", tout << "Length paths of an isomorphic Nielsen graph reused" << std::endl;);
+        }
+        if(!it->second.has_value()) {
+            return false;
+        }
+
+        // rename the variables of the labels back
+        auto rename_label = [&](const CounterLabel& lab) {
+            CounterLabel ret{rename_term(inverse, lab.left), {}};
+            for(const BasicTerm& t : lab.sum) {
+                ret.sum.push_back(rename_term(inverse, t));
+            }
+            return ret;
+        };
+        result.clear();
+        for(const Path<CounterLabel>& canon_path : *it->second) {
+            Path<CounterLabel> path;
+            path.nodes = canon_path.nodes;
+            for(const CounterLabel& lab : canon_path.labels) {
+                path.labels.push_back(rename_label(lab));
+            }
+            for(const auto& [node, lab] : canon_path.self_loops) {
+                path.self_loops.emplace(node, rename_label(lab));
+            }
+            result.push_back(std::move(path));
+        }
         return true;
     }
 
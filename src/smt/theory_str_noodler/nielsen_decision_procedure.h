@@ -54,15 +54,16 @@ namespace smt::noodler {
 
     /**
      * @brief Path with self-loops in the transition graph. 
-     * Represents part of a transition graph.
+     * Represents part of a transition graph. Nodes are given by their indices to the node
+     * table of the graph (see TransitionGraph::get_node_id), so paths do not copy formulae.
      * 
      * @tparam Label Label type
      */
     template<typename Label>
     struct Path {
-        std::vector<Formula> nodes;
+        std::vector<size_t> nodes;
         std::vector<Label> labels;
-        std::map<Formula, Label> self_loops;
+        std::map<size_t, Label> self_loops;
 
         /**
          * @brief Append path @p path to the current path.
@@ -91,13 +92,34 @@ namespace smt::noodler {
         Formula init;
         std::set<Formula> fins {}; // zero or more final nodes
 
+    private:
+        // indices of the nodes (including the init and the final ones) to node_table
+        std::map<Formula, size_t> node_ids;
+        std::vector<Formula> node_table;
+
+        size_t add_node_id(const Formula& node) {
+            auto [it, inserted] = this->node_ids.try_emplace(node, this->node_table.size());
+            if(inserted) {
+                this->node_table.push_back(node);
+            }
+            return it->second;
+        }
+
     public:
 
         const Nodes& get_nodes() const { return nodes; }
 
+        /**
+         * @brief Get the index of @p node in the node table of the graph (@p node must be in the graph).
+         */
+        size_t get_node_id(const Formula& node) const { return this->node_ids.at(node); }
+        const Formula& get_node(size_t id) const { return this->node_table[id]; }
+
         void add_edge(const Formula& source, const Formula& target, const Label& lbl) {
             this->nodes.insert(source);
             this->nodes.insert(target);
+            add_node_id(source);
+            add_node_id(target);
             this->edges[source].emplace(target, lbl);
         }
 
@@ -107,6 +129,7 @@ namespace smt::noodler {
 
         void set_init(const Formula& in) {
             this->init = in;
+            add_node_id(in);
         }
 
         const Formula& get_init() const {
@@ -115,6 +138,7 @@ namespace smt::noodler {
 
         void add_fin(const Formula& fin) {
             this->fins.insert(fin);
+            add_node_id(fin);
         }
 
         const std::set<Formula>& get_fins() const {
@@ -150,7 +174,7 @@ namespace smt::noodler {
             if(this->fins.size() != 0) {
                 ret.set_init(*this->fins.begin());
             }
-            ret.fins = {this->init};
+            ret.add_fin(this->init);
 
             for(const auto& pr: this->edges) {
                 for(const auto& tgt_symb : pr.second) {
@@ -199,30 +223,37 @@ namespace smt::noodler {
          * @return std::optional<Path<Label>> Visited nodes and labels on the shortest path.
          */
         std::optional<Path<Label>> shortest_path(const Formula& start, const Formula& end) const {
-            std::set<Formula> visited;
-            std::deque<std::pair<Formula, Path<Label>>> worklist;
-            worklist.emplace_back(std::pair<Formula, Path<Label>>(start, {{start},{}}));
+            const size_t start_id = get_node_id(start);
+            const size_t end_id = get_node_id(end);
+            // BFS over node indices, each visited node remembers its predecessor and the label of the edge from it
+            std::vector<bool> visited(this->node_table.size(), false);
+            std::vector<std::optional<std::pair<size_t, Label>>> pred(this->node_table.size());
+            std::deque<size_t> worklist{start_id};
+            visited[start_id] = true;
 
             while(!worklist.empty()) {
-                auto elem = worklist.front();
+                size_t id = worklist.front();
                 worklist.pop_front();
-                if(visited.find(elem.first) != visited.end()) {
-                    continue;
-                }
-                visited.insert(elem.first);
-                if(elem.first == end) {
-                    return elem.second;
+                if(id == end_id) {
+                    Path<Label> path;
+                    for(size_t act = id; act != start_id; act = pred[act]->first) {
+                        path.nodes.push_back(act);
+                        path.labels.push_back(pred[act]->second);
+                    }
+                    path.nodes.push_back(start_id);
+                    std::reverse(path.nodes.begin(), path.nodes.end());
+                    std::reverse(path.labels.begin(), path.labels.end());
+                    return path;
                 }
 
-                auto it = this->edges.find(elem.first);
+                auto it = this->edges.find(this->node_table[id]);
                 if(it == this->edges.end()) continue;
                 for(const auto& tgt_symb : it->second) {
-                    if(visited.find(tgt_symb.first) == visited.end()) {
-                        std::vector<Label> path(elem.second.labels.begin(), elem.second.labels.end());
-                        path.push_back(tgt_symb.second);
-                        std::vector<Formula> nodes(elem.second.nodes.begin(), elem.second.nodes.end());
-                        nodes.push_back(tgt_symb.first);
-                        worklist.emplace_back(std::pair<Formula, Path<Label>>(tgt_symb.first, {nodes, path}));
+                    size_t tgt_id = get_node_id(tgt_symb.first);
+                    if(!visited[tgt_id]) {
+                        visited[tgt_id] = true;
+                        pred[tgt_id] = std::make_pair(id, tgt_symb.second);
+                        worklist.push_back(tgt_id);
                     }
                 }
             }
@@ -255,6 +286,56 @@ namespace smt::noodler {
     template<typename Label>
     using SelfLoop = typename std::pair<Formula, Label>;
 
+    /**
+     * @brief Set of formulae visited by the generation of a Nielsen graph.
+     *
+     * Formulae are stored in an open-addressing table of 64-bit structural hashes. If @p rename_vars, they are
+     * compared by their canonical form (sorted predicates with variables renamed in the order of their first
+     * occurrence), so formulae differing only by the order of predicates and by names of variables are visited
+     * once. That is sound only if the graph is not used for lengths (nodes of the counter system and its labels
+     * refer to the formulae and the variables), otherwise the formulae are compared as they are.
+     */
+    class NielsenVisitedSet {
+    private:
+        // index + 1 of the formula in canonical (0 means an empty slot)
+        struct Slot {
+            uint64_t hash = 0;
+            size_t index = 0;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<Formula> canonical;
+        // the first formula inserted for each canonical form
+        std::vector<Formula> representatives;
+        bool rename_vars;
+
+        size_t find_slot(uint64_t hash, const Formula& canon) const;
+
+    public:
+        // init_size has to be a power of two
+        explicit NielsenVisitedSet(bool rename_vars, size_t init_size = 64) : slots(init_size), rename_vars(rename_vars) {}
+
+        static Formula canonize(const Formula& formula, bool rename_vars);
+        static uint64_t hash(const Formula& canon);
+
+        /**
+         * @brief Insert @p formula (if there is no formula with the same canonical form).
+         *
+         * @return The index of the representative of @p formula and whether @p formula was inserted
+         */
+        std::pair<size_t, bool> insert(const Formula& formula);
+
+        /**
+         * @brief Find the representative of @p formula.
+         *
+         * @param[out] index The index of the representative (if found)
+         */
+        bool find(const Formula& formula, size_t& index) const;
+
+        const Formula& get(size_t index) const { return representatives[index]; }
+        size_t size() const { return canonical.size(); }
+    };
+
     /**
      * @brief Decision procedure for quadratic equations using the Nielsen transformation.
      * 
@@ -270,6 +351,13 @@ namespace smt::noodler {
         std::vector<std::vector<Path<CounterLabel>>> length_paths;
         size_t length_paths_index = 0;
 
+        // Nielsen graph with variables renamed in the order of their first occurrence in the init node:
+        // init, finals, edges and the (renamed) length variables
+        using CanonicalGraphKey = std::tuple<Formula, std::set<Formula>, NielsenGraph::Edges, std::set<BasicTerm>>;
+        // length paths of canonical Nielsen graphs (nullopt if they cannot be constructed), isomorphic graphs
+        // of independent parts of the formula share them
+        std::map<CanonicalGraphKey, std::optional<std::vector<Path<CounterLabel>>>> length_paths_cache;
+
         LenNode length_formula_for_solution = LenNode(LenFormulaType::TRUE);
 
     protected:
@@ -279,7 +367,39 @@ namespace smt::noodler {
             return pred.get_left_side().size() == 0 && pred.get_right_side().size() == 0;
         }
         std::set<NielsenLabel> get_rules_from_pred(const Predicate& pred) const;
-        NielsenGraph generate_from_formula(const Formula& formula, bool early_termination, bool & is_sat) const;
+        /**
+         * @brief Generate the Nielsen graph of @p formula, formulae deeper than @p max_depth (0 means no limit)
+         * are not expanded.
+         *
+         * @param early_termination Stop when a final node is found (the graph then contains only the init and the final node)
+         * @param[out] is_sat Whether a final node was found
+         * @param[out] depth_reached Whether some formula was not expanded because of @p max_depth
+         */
+        NielsenGraph generate_from_formula(const Formula& formula, bool early_termination, bool & is_sat,
+                                           unsigned max_depth, bool & depth_reached) const;
+#ifndef SINGLE_THREAD
+        /**
+         * @brief Parallel version of generate_from_formula with early termination. @p num_threads workers expand
+         * the shared priority queue with a shared visited set, the first found final node stops all of them.
+         */
+        NielsenGraph generate_from_formula_parallel(const Formula& formula, bool & is_sat, unsigned max_depth,
+                                                    bool & depth_reached, unsigned num_threads) const;
+        /**
+         * @brief Deterministic version of generate_from_formula_parallel (m_params.m_deterministic). The items are
+         * expanded in rounds of @p num_threads items taken from the priority queue, the visited set and the queue
+         * are updated by the calling thread in the order of the items, so the final node is the same for any timing.
+         */
+        NielsenGraph generate_from_formula_rounds(const Formula& formula, bool & is_sat, unsigned max_depth,
+                                                  bool & depth_reached, unsigned num_threads) const;
+#endif
+        /**
+         * @brief Generate the Nielsen graph of @p formula according to m_params: the depth is bounded by iterative
+         * deepening up to m_params.m_nielsen_max_depth (if it is set) and the graph is generated in parallel by
+         * m_params.m_nielsen_threads workers if only satisfiability is needed (@p early_termination).
+         *
+         * @param[out] is_complete Whether the whole graph was generated (i.e., unsat is not caused by the depth bound)
+         */
+        NielsenGraph generate_graph(const Formula& formula, bool early_termination, bool & is_sat, bool & is_complete) const;
         Formula trim_formula(const Formula& formula) const;
         std::vector<Formula> divide_independent_formula(const Formula& formula) const;
 
@@ -307,9 +427,19 @@ namespace smt::noodler {
         static bool join_counter_label(const CounterLabel& l1, const CounterLabel& l2, CounterLabel & res);
 
         // extraction of a promising part of the condensated counter graph
-        std::set<SelfLoop<CounterLabel>> find_self_loops(const CounterSystem& cs) const;
+        std::set<SelfLoop<CounterLabel>> find_self_loops(const CounterSystem& cs, const std::set<BasicTerm>& length_vars) const;
         bool get_length_path(const CounterSystem& cs, const SelfLoop<CounterLabel>& sl, Path<CounterLabel>& result);
 
+        /**
+         * @brief Get the length paths of the Nielsen graph @p graph: the counter system of the graph is created and
+         * condensated and for each suitable self-loop, a path containing it is constructed. The paths are memoized
+         * for the canonical form of the graph (see length_paths_cache).
+         *
+         * @param[out] result Length paths of @p graph
+         * @return bool True if the paths were successfully constructed
+         */
+        bool get_graph_length_paths(const NielsenGraph& graph, std::vector<Path<CounterLabel>>& result);
+
         // construct length formula
         bool length_formula_path(const Path<CounterLabel>& path, std::map<BasicTerm, BasicTerm>& actual_var_map, std::vector<LenNode>& conjuncts);
         bool get_label_formula(const CounterLabel& lab, std::map<BasicTerm, BasicTerm>& in_vars, BasicTerm& out_var, std::vector<LenNode>& conjuncts);
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+#include "inclusion_graph.h"
+#include "procedure_selector.h"
+
+namespace smt::noodler {
+
+    bool InstanceFeatures::is_length_proc_suitable() const {
+        return first_other_predicate == SIZE_MAX && num_regular_vars == 0;
+    }
+
+    bool InstanceFeatures::is_nielsen_suitable() const {
+        if (num_memberships > 0 || num_not_contains > 0 || num_conversions > 0 || num_disequations > 0) {
+            return false;
+        }
+        if (num_length_vars > 0 && !is_quadratic) {
+            return false;
+        }
+        return is_cyclic;
+    }
+
+    bool InstanceFeatures::is_underapprox_suitable() const {
+        // (dis)equations only, languages of all variables are sigma star, co-finite or singletons
+        return num_conversions == 0 && first_other_predicate == SIZE_MAX && num_regular_vars == 0;
+    }
+
+    bool InstanceFeatures::is_bounded_suitable() const {
+        // only (dis)equations and memberships of variables with short words
+        return length_bound > 0 && first_other_predicate == SIZE_MAX && num_lang_eqs_diseqs == 0 && num_conversions == 0
+            && max_word_length <= length_bound;
+    }
+
+    InstanceFeatures InstanceFeatures::compute(const Formula& formula, const AutAssignment& aut_ass,
+                                               const std::unordered_set<BasicTerm>& init_length_sensitive_vars, bool nielsen_candidate) {
+        InstanceFeatures features;
+        features.num_length_vars = init_length_sensitive_vars.size();
+        // is the language of the variable other than sigma star, co-finite or a singleton (computed once for each variable)
+        std::unordered_map<BasicTerm, bool> is_regular;
+        auto check_regular = [&](const BasicTerm& var) {
+            auto [it, inserted] = is_regular.try_emplace(var, false);
+            if (inserted) {
+                const unsigned num_states = aut_ass.at(var)->num_of_states();
+                features.max_aut_states = std::max(features.max_aut_states, num_states);
+                features.total_aut_states += num_states;
+                it->second = !(num_states <= 1 || aut_ass.is_co_finite(var) || aut_ass.is_singleton(var));
+                if (it->second) {
+                    ++features.num_regular_vars;
+                }
+            }
+            return it->second;
+        };
+
+        std::unordered_map<BasicTerm, unsigned> occurrences;
+        const std::vector<Predicate>& predicates = formula.get_predicates();
+        for (size_t i = 0; i < predicates.size(); ++i) {
+            const Predicate& pred = predicates[i];
+            if (pred.is_equation()) {
+                ++features.num_equations;
+            } else if (pred.is_inequation()) {
+                ++features.num_disequations;
+                features.is_quadratic = false;
+            } else {
+                if (pred.get_type() == PredicateType::NotContains) {
+                    ++features.num_not_contains;
+                }
+                features.is_quadratic = false;
+                features.first_other_predicate = std::min(features.first_other_predicate, i);
+            }
+
+            for (const Concat& side : pred.get_params()) {
+                for (const BasicTerm& term : side) {
+                    ++features.num_term_occurrences;
+                    if (term.is_literal()) {
+                        ++features.num_literal_occurrences;
+                    } else if (term.is_variable()) {
+                        if (++occurrences[term] > 2) {
+                            features.is_quadratic = false;
+                        }
+                        check_regular(term);
+                    }
+                }
+            }
+        }
+        features.num_vars = occurrences.size();
+
+        // the inclusion graph is the only expensive feature, it is needed only for Nielsen
+        if (nielsen_candidate && features.num_disequations == 0 && features.num_not_contains == 0
+            && (features.num_length_vars == 0 || features.is_quadratic)) {
+            features.is_cyclic = Graph::create_inclusion_graph(formula).is_cyclic();
+        }
+        return features;
+    }
+
+    std::string InstanceFeatures::to_string() const {
+        std::stringstream res;
+        res << "eqs: " << num_equations << ", diseqs: " << num_disequations << ", not contains: " << num_not_contains
+            << ", memberships: " << num_memberships << ", lang (dis)eqs: " << num_lang_eqs_diseqs << ", conversions: " << num_conversions
+            << ", vars: " << num_vars << " (length: " << num_length_vars << ", regular: " << num_regular_vars << ")"
+            << ", literal density: " << literal_density() << ", max/total states: " << max_aut_states << "/" << total_aut_states
+            << ", quadratic: " << is_quadratic << ", cyclic: " << is_cyclic;
+        return res.str();
+    }
+
+    std::unique_ptr<ProcedureSelector> ProcedureSelector::create(procedure_selector sel) {
+        switch (sel) {
+        case PS_FIXED:
+            return std::make_unique<FixedProcedureSelector>();
+        case PS_TABLE:
+            return std::make_unique<TableProcedureSelector>();
+        }
+        UNREACHABLE();
+        return nullptr;
+    }
+
+    std::vector<SolverProcedure> ProcedureSelector::filter_suitable(const std::vector<SolverProcedure>& order, const InstanceFeatures& features) {
+        std::vector<SolverProcedure> res;
+        for (SolverProcedure proc : order) {
+            bool suitable = false;
+            switch (proc) {
+            case SolverProcedure::LENGTH:
+                suitable = features.is_length_proc_suitable();
+                break;
+            case SolverProcedure::NIELSEN:
+                suitable = features.is_nielsen_suitable();
+                break;
+            case SolverProcedure::UNDERAPPROX:
+                suitable = features.is_underapprox_suitable();
+                break;
+            case SolverProcedure::BOUNDED:
+                suitable = features.is_bounded_suitable();
+                break;
+            }
+            if (suitable) {
+                res.push_back(proc);
+            }
+        }
+        return res;
+    }
+
+    std::vector<SolverProcedure> FixedProcedureSelector::select(const InstanceFeatures& features) const {
+        // the length-based procedure is tried again after Nielsen only if it was not tried before (the result would be the same)
+        if (features.has_equations_only()) {
+            return filter_suitable({SolverProcedure::LENGTH, SolverProcedure::BOUNDED, SolverProcedure::NIELSEN, SolverProcedure::UNDERAPPROX}, features);
+        }
+        return filter_suitable({SolverProcedure::NIELSEN, SolverProcedure::LENGTH, SolverProcedure::UNDERAPPROX}, features);
+    }
+
+    bool TableProcedureSelector::Row::matches(const InstanceFeatures& features) const {
+        if (quadratic.has_value() && *quadratic != features.is_quadratic) {
+            return false;
+        }
+        if (length_vars.has_value() && *length_vars != (features.num_length_vars > 0)) {
+            return false;
+        }
+        return features.literal_density() >= min_literal_density && features.max_aut_states >= min_aut_states;
+    }
+
+    std::vector<SolverProcedure> TableProcedureSelector::select(const InstanceFeatures& features) const {
+        for (const Row& row : table) {
+            if (row.matches(features)) {
+                return filter_suitable(row.order, features);
+            }
+        }
+        return {};
+    }
+
+    std::vector<TableProcedureSelector::Row> TableProcedureSelector::get_builtin_table() {
+        using P = SolverProcedure;
+        return {
+            // quadratic equations without lengths: Nielsen only searches for a final node, which is cheap
+            {true, false, 0.0, 0, {P::NIELSEN, P::LENGTH, P::BOUNDED, P::UNDERAPPROX}},
+            // large automata: the underapproximation does not need to build the noodles of the whole languages
+            {std::nullopt, std::nullopt, 0.0, 1000, {P::UNDERAPPROX, P::LENGTH, P::BOUNDED, P::NIELSEN}},
+            // mostly literals: the length-based procedure aligns the literals directly
+            {std::nullopt, std::nullopt, 0.5, 0, {P::LENGTH, P::BOUNDED, P::NIELSEN, P::UNDERAPPROX}},
+            // the bounded procedure is suitable only for short words, its encoding is then small and complete
+            {std::nullopt, std::nullopt, 0.0, 0, {P::BOUNDED, P::NIELSEN, P::LENGTH, P::UNDERAPPROX}},
+        };
+    }
+}
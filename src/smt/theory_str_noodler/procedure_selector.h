@@ -0,0 +1,161 @@
+#ifndef _NOODLER_PROCEDURE_SELECTOR_H_
+#define _NOODLER_PROCEDURE_SELECTOR_H_
+
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "smt/params/theory_str_noodler_params.h"
+
+#include "formula.h"
+#include "aut_assignment.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Features of an instance (formula with automata assignment) used to choose the procedures solving it.
+     *
+     * The features are computed in one pass over the instance (see InstanceFeatures::compute()), the numbers of
+     * constraints that are not in the formula (memberships, language (dis)equations, conversions) are set by the caller.
+     */
+    struct InstanceFeatures {
+        unsigned num_equations = 0;
+        unsigned num_disequations = 0;
+        unsigned num_not_contains = 0;
+        unsigned num_memberships = 0;
+        unsigned num_lang_eqs_diseqs = 0;
+        unsigned num_conversions = 0;
+
+        unsigned num_vars = 0;
+        // all length-sensitive variables (also those not occurring in the formula)
+        unsigned num_length_vars = 0;
+        // variables whose language is not sigma star, co-finite or a singleton
+        unsigned num_regular_vars = 0;
+        // occurrences of terms (and of literals among them) in the predicates
+        unsigned num_term_occurrences = 0;
+        unsigned num_literal_occurrences = 0;
+        unsigned max_aut_states = 0;
+        unsigned total_aut_states = 0;
+        // length of the longest word of the languages of variables (UINT_MAX if some language is infinite),
+        // computed by the caller only if the bounded procedure can be used (length_bound > 0)
+        unsigned max_word_length = UINT_MAX;
+        unsigned length_bound = 0;
+
+        // all predicates are equations and each variable occurs at most twice
+        bool is_quadratic = true;
+        // the inclusion graph of the formula is cyclic (computed only if the instance can be suitable for Nielsen)
+        bool is_cyclic = false;
+        // index of the first predicate that is not a (dis)equation
+        size_t first_other_predicate = SIZE_MAX;
+
+        /**
+         * @brief Ratio of occurrences of literals to occurrences of all terms in the predicates.
+         */
+        double literal_density() const {
+            return num_term_occurrences == 0 ? 0.0 : static_cast<double>(num_literal_occurrences) / num_term_occurrences;
+        }
+
+        /**
+         * @brief There are only word (dis)equations and regular memberships.
+         */
+        bool has_equations_only() const {
+            return num_not_contains == 0 && num_lang_eqs_diseqs == 0 && num_conversions == 0;
+        }
+
+        bool is_length_proc_suitable() const;
+        bool is_nielsen_suitable() const;
+        bool is_underapprox_suitable() const;
+        bool is_bounded_suitable() const;
+
+        /**
+         * @brief Compute the features of @p formula with @p aut_ass. The inclusion graph is built only if
+         * @p nielsen_candidate is true (the caller knows that there are no other constraints preventing Nielsen).
+         */
+        static InstanceFeatures compute(const Formula& formula, const AutAssignment& aut_ass,
+                                        const std::unordered_set<BasicTerm>& init_length_sensitive_vars, bool nielsen_candidate);
+
+        std::string to_string() const;
+    };
+
+    /**
+     * @brief Procedures that can be tried before the main decision procedure.
+     */
+    enum struct SolverProcedure {
+        LENGTH,         // length-based decision procedure
+        NIELSEN,        // Nielsen transformation
+        UNDERAPPROX,    // underapproximating decision procedure (only sat is definitive)
+        BOUNDED,        // SAT encoding of words of bounded length
+    };
+
+    /**
+     * @brief Selector of the order in which the procedures are tried for an instance.
+     */
+    class ProcedureSelector {
+    public:
+        /**
+         * @brief Get the procedures suitable for the instance with @p features in the order in which they should be tried.
+         */
+        virtual std::vector<SolverProcedure> select(const InstanceFeatures& features) const = 0;
+
+        /**
+         * @brief Create the selector given by @p sel.
+         */
+        static std::unique_ptr<ProcedureSelector> create(procedure_selector sel);
+
+        virtual ~ProcedureSelector() = default;
+
+    protected:
+        /**
+         * @brief Keep only procedures from @p order that are suitable for the instance with @p features.
+         */
+        static std::vector<SolverProcedure> filter_suitable(const std::vector<SolverProcedure>& order, const InstanceFeatures& features);
+    };
+
+    /**
+     * @brief The fixed order: length-based procedure (if there are only equations), bounded procedure, Nielsen,
+     * length-based procedure, underapproximation.
+     */
+    class FixedProcedureSelector : public ProcedureSelector {
+    public:
+        std::vector<SolverProcedure> select(const InstanceFeatures& features) const override;
+    };
+
+    /**
+     * @brief Order given by a table, the first row matching the features of the instance is used.
+     *
+     * The rows are meant to be obtained offline from the benchmark results (which procedure decided instances with
+     * given features the fastest), so a row only states bounds on the features that are cheap to compute.
+     */
+    class TableProcedureSelector : public ProcedureSelector {
+    public:
+        struct Row {
+            // required values of features (std::nullopt means any value)
+            std::optional<bool> quadratic;
+            std::optional<bool> length_vars;
+            // lower bounds of features
+            double min_literal_density = 0.0;
+            unsigned min_aut_states = 0;
+            std::vector<SolverProcedure> order;
+
+            bool matches(const InstanceFeatures& features) const;
+        };
+
+        explicit TableProcedureSelector(std::vector<Row> table = get_builtin_table()) : table(std::move(table)) {}
+
+        std::vector<SolverProcedure> select(const InstanceFeatures& features) const override;
+
+        /**
+         * @brief The built-in table (its last row matches every instance).
+         */
+        static std::vector<Row> get_builtin_table();
+
+    private:
+        std::vector<Row> table;
+    };
+}
+
+#endif
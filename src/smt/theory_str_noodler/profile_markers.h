@@ -0,0 +1,69 @@
+#ifndef _NOODLER_PROFILE_MARKERS_H_
+#define _NOODLER_PROFILE_MARKERS_H_
+
+/**
+ * Annotations of the phases of the final check for sampling profilers, selected by the CMake option
+ * Z3_NOODLER_PROFILE_MARKERS:
+ *  - ITT (NOODLER_PROFILE_ITT): each phase is an ITT task of the domain "noodler" (shown by Intel VTune),
+ *  - USDT (NOODLER_PROFILE_USDT): each phase fires the static probes noodler:phase_begin and noodler:phase_end
+ *    with the name of the phase (usable by perf probe, bpftrace, ...).
+ * Without the option, NOODLER_PHASE does nothing.
+ *
+ * NOODLER_PHASE(name) marks the rest of the enclosing scope as the phase @p name (a string literal), phases can be
+ * nested (e.g., inclusion checks inside of noodlification).
+ */
+
+#define NOODLER_PHASE_CONCAT_(a, b) a##b
+#define NOODLER_PHASE_CONCAT(a, b) NOODLER_PHASE_CONCAT_(a, b)
+
+#if defined(NOODLER_PROFILE_ITT)
+
+#include <ittnotify.h>
+
+namespace smt::noodler {
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(__itt_string_handle* name) { __itt_task_begin(domain(), __itt_null, __itt_null, name); }
+        ~ScopedPhase() { __itt_task_end(domain()); }
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        static __itt_domain* domain() {
+            static __itt_domain* d = __itt_domain_create("noodler");
+            return d;
+        }
+    };
+}
+
+// the string handle is created once for each place of the annotation
+#define NOODLER_PHASE(name)                                                                                 \
+    static __itt_string_handle* NOODLER_PHASE_CONCAT(noodler_phase_name_, __LINE__) = __itt_string_handle_create(name); \
+    smt::noodler::ScopedPhase NOODLER_PHASE_CONCAT(noodler_phase_, __LINE__)(NOODLER_PHASE_CONCAT(noodler_phase_name_, __LINE__))
+
+#elif defined(NOODLER_PROFILE_USDT)
+
+#include <sys/sdt.h>
+
+namespace smt::noodler {
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(const char* name) : name(name) { DTRACE_PROBE1(noodler, phase_begin, name); }
+        ~ScopedPhase() { DTRACE_PROBE1(noodler, phase_end, name); }
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        const char* name;
+    };
+}
+
+#define NOODLER_PHASE(name) smt::noodler::ScopedPhase NOODLER_PHASE_CONCAT(noodler_phase_, __LINE__)(name)
+
+#else
+
+#define NOODLER_PHASE(name) ((void)0)
+
+#endif
+
+#endif
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 
 #include "util/z3_exception.h"
@@ -9,255 +10,748 @@
 
 namespace {
     using mata::nfa::Nfa;
-}
 
-namespace smt::noodler::regex {
+    // maximal number of transitions of Glushkov automata (bigger regexes are converted compositionally)
+    const size_t GLUSHKOV_TRANSITIONS_BOUND = 100000;
 
-    [[nodiscard]] Nfa conv_to_nfa(const app *expression, const seq_util& m_util_s, const ast_manager& m,
-                                  const Alphabet& alphabet, bool determinize, bool make_complement) {
-        Nfa nfa{};
+    /**
+     * @brief Positions of a regex for the Glushkov construction: symbols of each position and
+     * positions that can follow each position.
+     */
+    struct GlushkovPositions {
+        std::vector<std::vector<mata::Symbol>> symbols;
+        std::vector<std::set<unsigned>> follow;
 
-        if (m_util_s.re.is_to_re(expression)) { // Handle conversion of to regex function call.
+        unsigned add_position(std::vector<mata::Symbol> position_symbols) {
+            symbols.push_back(std::move(position_symbols));
+            follow.emplace_back();
+            return symbols.size() - 1;
+        }
+    };
+
+    /**
+     * @brief Glushkov info of a subregex: whether it accepts the empty word and positions that can
+     * start/end its words.
+     */
+    struct GlushkovInfo {
+        bool nullable = false;
+        std::set<unsigned> first;
+        std::set<unsigned> last;
+    };
+
+    /**
+     * @brief Concatenate @p info with @p right (whose positions already are in @p positions).
+     */
+    void glushkov_concat(GlushkovInfo& info, const GlushkovInfo& right, GlushkovPositions& positions) {
+        for (unsigned pos : info.last) {
+            positions.follow[pos].insert(right.first.begin(), right.first.end());
+        }
+        if (info.nullable) {
+            info.first.insert(right.first.begin(), right.first.end());
+        }
+        if (right.nullable) {
+            info.last.insert(right.last.begin(), right.last.end());
+        } else {
+            info.last = right.last;
+        }
+        info.nullable = info.nullable && right.nullable;
+    }
+
+    /**
+     * @brief Iterate @p info (positions ending words can be followed by positions starting words).
+     */
+    void glushkov_iterate(const GlushkovInfo& info, GlushkovPositions& positions) {
+        for (unsigned pos : info.last) {
+            positions.follow[pos].insert(info.first.begin(), info.first.end());
+        }
+    }
+
+    /**
+     * @brief Glushkov info of a word, each symbol of @p word gets a new position.
+     */
+    GlushkovInfo glushkov_word(const zstring& word, GlushkovPositions& positions) {
+        GlushkovInfo info;
+        info.nullable = word.length() == 0;
+        for (unsigned i = 0; i < word.length(); ++i) {
+            unsigned pos = positions.add_position({ word[i] });
+            if (i == 0) {
+                info.first.insert(pos);
+            } else {
+                positions.follow[pos - 1].insert(pos);
+            }
+            if (i == word.length() - 1) {
+                info.last.insert(pos);
+            }
+        }
+        return info;
+    }
+
+    /**
+     * @brief Compute Glushkov info of regex @p expression, adding its positions to @p positions.
+     * @return false if the regex contains an operation unsupported by the construction (complement,
+     * intersection, loop, ...) or if it has too many positions or is too deep (@p depth is the depth of @p expression).
+     */
+    bool collect_glushkov(const app* expression, const seq_util& m_util_s, const smt::noodler::Alphabet& alphabet,
+                          GlushkovPositions& positions, GlushkovInfo& info, unsigned depth = 0) {
+        if (positions.symbols.size() > smt::noodler::regex::RED_BOUND || depth > smt::noodler::regex::RED_BOUND) {
+            return false;
+        }
+
+        if (m_util_s.re.is_to_re(expression)) {
             SASSERT(expression->get_num_args() == 1);
-            const auto arg{ expression->get_arg(0) };
-            // Assume that expression inside re.to_re() function is a string of characters.
-            if (!m_util_s.str.is_string(arg)) { // if to_re has something other than string literal
-                util::throw_error("we support only string literals in str.to_re");
+            zstring word;
+            if (!m_util_s.str.is_string(expression->get_arg(0), word)) {
+                return false;
             }
-            nfa = conv_to_nfa(to_app(arg), m_util_s, m, alphabet, determinize);
-        } else if (m_util_s.re.is_concat(expression)) { // Handle regex concatenation.
+            info = glushkov_word(word, positions);
+        } else if (m_util_s.str.is_string(expression)) {
+            info = glushkov_word(expression->get_parameter(0).get_zstring(), positions);
+        } else if (m_util_s.re.is_concat(expression)) {
             SASSERT(expression->get_num_args() > 0);
-            nfa = conv_to_nfa(to_app(expression->get_arg(0)), m_util_s, m, alphabet);
-            for (unsigned int i = 1; i < expression->get_num_args(); ++i) {
-                nfa.concatenate(conv_to_nfa(to_app(expression->get_arg(i)), m_util_s, m, alphabet, determinize));
-                nfa.trim();
+            if (!collect_glushkov(to_app(expression->get_arg(0)), m_util_s, alphabet, positions, info, depth + 1)) {
+                return false;
             }
-        } else if (m_util_s.re.is_antimirov_union(expression)) { // Handle Antimirov union.
-            util::throw_error("antimirov union is unsupported");
-        } else if (m_util_s.re.is_complement(expression)) { // Handle complement.
+            for (unsigned i = 1; i < expression->get_num_args(); ++i) {
+                GlushkovInfo right;
+                if (!collect_glushkov(to_app(expression->get_arg(i)), m_util_s, alphabet, positions, right, depth + 1)) {
+                    return false;
+                }
+                glushkov_concat(info, right, positions);
+            }
+        } else if (m_util_s.re.is_union(expression)) {
+            SASSERT(expression->get_num_args() > 0);
+            info = GlushkovInfo{};
+            for (unsigned i = 0; i < expression->get_num_args(); ++i) {
+                GlushkovInfo alternative;
+                if (!collect_glushkov(to_app(expression->get_arg(i)), m_util_s, alphabet, positions, alternative, depth + 1)) {
+                    return false;
+                }
+                info.nullable = info.nullable || alternative.nullable;
+                info.first.insert(alternative.first.begin(), alternative.first.end());
+                info.last.insert(alternative.last.begin(), alternative.last.end());
+            }
+        } else if (m_util_s.re.is_star(expression) || m_util_s.re.is_plus(expression) || m_util_s.re.is_opt(expression)) {
             SASSERT(expression->get_num_args() == 1);
-            const auto child{ expression->get_arg(0) };
-            SASSERT(is_app(child));
-            nfa = conv_to_nfa(to_app(child), m_util_s, m, alphabet, determinize);
-            // According to make_complement, we do complement at the end, so we just invert it
-            make_complement = !make_complement;
-        } else if (m_util_s.re.is_derivative(expression)) { // Handle derivative.
-            util::throw_error("derivative is unsupported");
-        } else if (m_util_s.re.is_diff(expression)) { // Handle diff.
-            util::throw_error("regex difference is unsupported");
-        } else if (m_util_s.re.is_dot_plus(expression)) { // Handle dot plus.
-            nfa.initial.insert(0);
-            nfa.final.insert(1);
-            for (const auto& symbol : alphabet.get_alphabet()) {
-                nfa.delta.add(0, symbol, 1);
-                nfa.delta.add(1, symbol, 1);
+            if (!collect_glushkov(to_app(expression->get_arg(0)), m_util_s, alphabet, positions, info, depth + 1)) {
+                return false;
             }
-        } else if (m_util_s.re.is_empty(expression)) { // Handle empty language.
-            // Do nothing, as nfa is initialized empty
-        } else if (m_util_s.re.is_epsilon(expression)) { // Handle epsilon.
-            nfa = mata::nfa::builder::create_empty_string_nfa();
-        } else if (m_util_s.re.is_full_char(expression)) { // Handle full char (single occurrence of any string symbol, '.').
-            nfa.initial.insert(0);
-            nfa.final.insert(1);
-            for (const auto& symbol : alphabet.get_alphabet()) {
-                nfa.delta.add(0, symbol, 1);
+            if (!m_util_s.re.is_opt(expression)) {
+                glushkov_iterate(info, positions);
             }
-        } else if (m_util_s.re.is_full_seq(expression)) {
-            nfa.initial.insert(0);
-            nfa.final.insert(0);
-            for (const auto& symbol : alphabet.get_alphabet()) {
-                nfa.delta.add(0, symbol, 0);
+            info.nullable = info.nullable || !m_util_s.re.is_plus(expression);
+        } else if (m_util_s.re.is_range(expression)) {
+            SASSERT(expression->get_num_args() == 2);
+            const auto range_begin_value{ to_app(expression->get_arg(0))->get_parameter(0).get_zstring()[0] };
+            const auto range_end_value{ to_app(expression->get_arg(1))->get_parameter(0).get_zstring()[0] };
+            // only symbols of the alphabet (the same as in conv_to_nfa)
+            const std::set<uint32_t>& symbols = alphabet.get_alphabet();
+            std::vector<mata::Symbol> range_symbols;
+            for (auto symbol_it = symbols.lower_bound(range_begin_value); symbol_it != symbols.end() && *symbol_it <= range_end_value; ++symbol_it) {
+                range_symbols.push_back(*symbol_it);
             }
-        } else if (m_util_s.re.is_intersection(expression)) { // Handle intersection.
-            SASSERT(expression->get_num_args() > 0);
-            nfa = conv_to_nfa(to_app(expression->get_arg(0)), m_util_s, m, alphabet, determinize);
-            for (unsigned int i = 1; i < expression->get_num_args(); ++i) {
-                nfa = mata::nfa::intersection(nfa, conv_to_nfa(to_app(expression->get_arg(i)), m_util_s, m, alphabet, determinize));
+            info = GlushkovInfo{};
+            unsigned pos = positions.add_position(std::move(range_symbols));
+            info.first = { pos };
+            info.last = { pos };
+        } else if (m_util_s.re.is_full_char(expression) || m_util_s.re.is_full_seq(expression) || m_util_s.re.is_dot_plus(expression)) {
+            const std::set<uint32_t>& symbols = alphabet.get_alphabet();
+            info = GlushkovInfo{};
+            unsigned pos = positions.add_position(std::vector<mata::Symbol>(symbols.begin(), symbols.end()));
+            info.first = { pos };
+            info.last = { pos };
+            if (!m_util_s.re.is_full_char(expression)) {
+                glushkov_iterate(info, positions);
+                info.nullable = m_util_s.re.is_full_seq(expression);
             }
-        } else if (m_util_s.re.is_loop(expression)) { // Handle loop.
-            unsigned low, high;
-            expr *body;
-            bool is_high_set = false;
-            if (m_util_s.re.is_loop(expression, body, low, high)) {
-                is_high_set = true;
-            } else if (m_util_s.re.is_loop(expression, body, low)) {
-                is_high_set = false;
-            } else {
-                util::throw_error("loop should contain at least lower bound");
+        } else if (m_util_s.re.is_epsilon(expression)) {
+            info = GlushkovInfo{};
+            info.nullable = true;
+        } else if (m_util_s.re.is_empty(expression)) {
+            info = GlushkovInfo{};
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
+
+namespace smt::noodler::regex {
+
+    bool create_glushkov_nfa(const app *expression, const seq_util& m_util_s, const Alphabet& alphabet, Nfa& nfa) {
+        GlushkovPositions positions;
+        GlushkovInfo info;
+        if (!collect_glushkov(expression, m_util_s, alphabet, positions, info)) {
+            return false;
+        }
+
+        const unsigned num_of_positions = positions.symbols.size();
+        size_t num_of_transitions = 0;
+        for (unsigned pos : info.first) {
+            num_of_transitions += positions.symbols[pos].size();
+        }
+        for (unsigned pos = 0; pos < num_of_positions; ++pos) {
+            for (unsigned next : positions.follow[pos]) {
+                num_of_transitions += positions.symbols[next].size();
             }
+        }
+        if (num_of_transitions > GLUSHKOV_TRANSITIONS_BOUND) {
+            return false;
+        }
 
-            Nfa body_nfa = conv_to_nfa(to_app(body), m_util_s, m, alphabet, determinize);
+        // state 0 is the initial state, position i corresponds to the state i+1 (entered by reading the symbol of the position)
+        nfa = Nfa(num_of_positions + 1, {0}, {});
+        if (info.nullable) {
+            nfa.final.insert(0);
+        }
+        for (unsigned pos : info.last) {
+            nfa.final.insert(pos + 1);
+        }
+        for (unsigned pos : info.first) {
+            for (mata::Symbol symbol : positions.symbols[pos]) {
+                nfa.delta.add(0, symbol, pos + 1);
+            }
+        }
+        for (unsigned pos = 0; pos < num_of_positions; ++pos) {
+            for (unsigned next : positions.follow[pos]) {
+                for (mata::Symbol symbol : positions.symbols[next]) {
+                    nfa.delta.add(pos + 1, symbol, next + 1);
+                }
+            }
+        }
+        return true;
+    }
 
-            if (body_nfa.is_lang_empty()) {
-                // for the case that body of the loop represents empty language...
-                if (low == 0) {
-                    // ...we either return empty string if we have \emptyset{0,h}
-                    nfa = mata::nfa::builder::create_empty_string_nfa();
-                } else {
-                    // ... or empty language
-                    nfa = std::move(body_nfa);
+    namespace {
+        /**
+         * @brief Get the regexes whose NFAs are needed to convert @p expression to NFA (see convert_regex_node).
+         * Chains of nested concatenations/unions are flattened, i.e., the children of a concatenation are its
+         * maximal subregexes that are not concatenations.
+         */
+        std::vector<const app*> get_regex_children(const app *expression, const seq_util& m_util_s) {
+            std::vector<const app*> children;
+            if (m_util_s.re.is_concat(expression) || m_util_s.re.is_union(expression)) {
+                const bool is_concat = m_util_s.re.is_concat(expression);
+                // explicit stack, the arguments are pushed in the reversed order to keep their order
+                std::vector<const app*> to_flatten{ expression };
+                while (!to_flatten.empty()) {
+                    const app* node = to_flatten.back();
+                    to_flatten.pop_back();
+                    if (is_concat ? m_util_s.re.is_concat(node) : m_util_s.re.is_union(node)) {
+                        for (unsigned i = node->get_num_args(); i-- > 0;) {
+                            to_flatten.push_back(to_app(node->get_arg(i)));
+                        }
+                    } else {
+                        children.push_back(node);
+                    }
                 }
-            } else if(body_nfa.is_universal(alphabet.get_mata_alphabet())) {
-                nfa = std::move(body_nfa);
-            } else {
-                body_nfa.unify_final();
-                body_nfa.unify_initial();
+            } else if (m_util_s.re.is_to_re(expression)) {
+                if (m_util_s.str.is_string(expression->get_arg(0))) {
+                    children.push_back(to_app(expression->get_arg(0)));
+                }
+            } else if (m_util_s.re.is_complement(expression) || m_util_s.re.is_opt(expression) ||
+                       m_util_s.re.is_star(expression) || m_util_s.re.is_plus(expression) || m_util_s.re.is_loop(expression)) {
+                children.push_back(to_app(expression->get_arg(0)));
+            } else if (m_util_s.re.is_intersection(expression)) {
+                for (unsigned i = 0; i < expression->get_num_args(); ++i) {
+                    children.push_back(to_app(expression->get_arg(i)));
+                }
+            }
+            return children;
+        }
 
-                body_nfa = mata::nfa::reduce(body_nfa);
+        /**
+         * @brief Convert the node @p expression of a regex to NFA, given the (postprocessed) NFAs @p children of
+         * its children (see get_regex_children). Complement is not done here, but in postprocess_regex_nfa.
+         */
+        Nfa convert_regex_node(const app *expression, const std::vector<const Nfa*>& children, const seq_util& m_util_s,
+                               const Alphabet& alphabet) {
+            Nfa nfa{};
+
+            if (m_util_s.re.is_to_re(expression)) { // Handle conversion of to regex function call.
+                SASSERT(expression->get_num_args() == 1);
+                const auto arg{ expression->get_arg(0) };
+                // Assume that expression inside re.to_re() function is a string of characters.
+                if (!m_util_s.str.is_string(arg)) { // if to_re has something other than string literal
+                    util::throw_error("we support only string literals in str.to_re");
+                }
+                nfa = *children[0];
+            } else if (m_util_s.re.is_concat(expression)) { // Handle regex concatenation (flattened).
+                SASSERT(!children.empty());
+                nfa = *children[0];
+                for (unsigned int i = 1; i < children.size(); ++i) {
+                    nfa.concatenate(*children[i]);
+                }
+                // trimming once at the end is enough
+                nfa.trim();
+            } else if (m_util_s.re.is_antimirov_union(expression)) { // Handle Antimirov union.
+                util::throw_error("antimirov union is unsupported");
+            } else if (m_util_s.re.is_complement(expression)) { // Handle complement.
+                SASSERT(expression->get_num_args() == 1);
+                // the complement is done in postprocess_regex_nfa
+                nfa = *children[0];
+            } else if (m_util_s.re.is_derivative(expression)) { // Handle derivative.
+                util::throw_error("derivative is unsupported");
+            } else if (m_util_s.re.is_diff(expression)) { // Handle diff.
+                util::throw_error("regex difference is unsupported");
+            } else if (m_util_s.re.is_dot_plus(expression)) { // Handle dot plus.
+                nfa.initial.insert(0);
+                nfa.final.insert(1);
+                for (const auto& symbol : alphabet.get_alphabet()) {
+                    nfa.delta.add(0, symbol, 1);
+                    nfa.delta.add(1, symbol, 1);
+                }
+            } else if (m_util_s.re.is_empty(expression)) { // Handle empty language.
+                // Do nothing, as nfa is initialized empty
+            } else if (m_util_s.re.is_epsilon(expression)) { // Handle epsilon.
                 nfa = mata::nfa::builder::create_empty_string_nfa();
-             
-                if(low >= LOOP_BOUND) {
-                    nfa = create_large_concat(body_nfa, low);
+            } else if (m_util_s.re.is_full_char(expression)) { // Handle full char (single occurrence of any string symbol, '.').
+                nfa.initial.insert(0);
+                nfa.final.insert(1);
+                for (const auto& symbol : alphabet.get_alphabet()) {
+                    nfa.delta.add(0, symbol, 1);
+                }
+            } else if (m_util_s.re.is_full_seq(expression)) {
+                nfa.initial.insert(0);
+                nfa.final.insert(0);
+                for (const auto& symbol : alphabet.get_alphabet()) {
+                    nfa.delta.add(0, symbol, 0);
+                }
+            } else if (m_util_s.re.is_intersection(expression)) { // Handle intersection.
+                SASSERT(!children.empty());
+                nfa = *children[0];
+                for (unsigned int i = 1; i < children.size(); ++i) {
+                    nfa = intersect(nfa, *children[i]);
+                }
+            } else if (m_util_s.re.is_loop(expression)) { // Handle loop.
+                unsigned low, high;
+                expr *body;
+                bool is_high_set = false;
+                if (m_util_s.re.is_loop(expression, body, low, high)) {
+                    is_high_set = true;
+                } else if (m_util_s.re.is_loop(expression, body, low)) {
+                    is_high_set = false;
                 } else {
-                    // we need to repeat body_nfa at least low times
-                    for (unsigned i = 0; i < low; ++i) {
-                        nfa.concatenate(body_nfa);
-                        nfa.trim();
-                    }
+                    util::throw_error("loop should contain at least lower bound");
                 }
 
-                // we will now either repeat body_nfa high-low times (if is_high_set) or
-                // unlimited times (if it is not set), but we have to accept after each loop,
-                // so we add an empty word into body_nfa
-                mata::nfa::State new_state = body_nfa.add_state();
-                body_nfa.initial.insert(new_state);
-                body_nfa.final.insert(new_state);
-
-                body_nfa.unify_initial();
-                body_nfa = mata::nfa::reduce(body_nfa);
-
-                if (is_high_set) {
-                    // if high is set, we repeat body_nfa another high-low times
-                    for (unsigned i = 0; i < high - low; ++i) {
-                        nfa.concatenate(body_nfa);
-                        nfa.trim();
+                Nfa body_nfa = *children[0];
+
+                if (body_nfa.is_lang_empty()) {
+                    // for the case that body of the loop represents empty language...
+                    if (low == 0) {
+                        // ...we either return empty string if we have \emptyset{0,h}
+                        nfa = mata::nfa::builder::create_empty_string_nfa();
+                    } else {
+                        // ... or empty language
+                        nfa = std::move(body_nfa);
                     }
+                } else if(body_nfa.is_universal(alphabet.get_mata_alphabet())) {
+                    nfa = std::move(body_nfa);
                 } else {
-                    // if high is not set, we can repeat body_nfa unlimited more times
-                    // so we do star operation on body_nfa and add it to end of nfa
-                    for (const auto& final : body_nfa.final) {
-                        for (const auto& initial : body_nfa.initial) {
-                            body_nfa.delta.add(final, mata::nfa::EPSILON, initial);
+                    body_nfa.unify_final();
+                    body_nfa.unify_initial();
+
+                    body_nfa = mata::nfa::reduce(body_nfa);
+                    nfa = mata::nfa::builder::create_empty_string_nfa();
+                 
+                    if(low >= LOOP_BOUND) {
+                        nfa = create_large_concat(body_nfa, low);
+                    } else {
+                        // we need to repeat body_nfa at least low times
+                        for (unsigned i = 0; i < low; ++i) {
+                            nfa.concatenate(body_nfa);
+                            nfa.trim();
+                        }
+                    }
+
+                    // we will now either repeat body_nfa high-low times (if is_high_set) or
+                    // unlimited times (if it is not set), but we have to accept after each loop,
+                    // so we add an empty word into body_nfa
+                    mata::nfa::State new_state = body_nfa.add_state();
+                    body_nfa.initial.insert(new_state);
+                    body_nfa.final.insert(new_state);
+
+                    body_nfa.unify_initial();
+                    body_nfa = mata::nfa::reduce(body_nfa);
+
+                    if (is_high_set) {
+                        // if high is set, we repeat body_nfa another high-low times
+                        if (high - low >= LOOP_BOUND) {
+                            nfa.concatenate(create_large_concat(body_nfa, high - low));
+                            nfa.trim();
+                        } else {
+                            for (unsigned i = 0; i < high - low; ++i) {
+                                nfa.concatenate(body_nfa);
+                                nfa.trim();
+                            }
+                        }
+                    } else {
+                        // if high is not set, we can repeat body_nfa unlimited more times
+                        // so we do star operation on body_nfa and add it to end of nfa
+                        for (const auto& final : body_nfa.final) {
+                            for (const auto& initial : body_nfa.initial) {
+                                body_nfa.delta.add(final, mata::nfa::EPSILON, initial);
+                            }
                         }
+                        nfa = mata::nfa::concatenate(nfa, body_nfa, true);
+                        nfa = mata::nfa::remove_epsilon(nfa);
                     }
-                    nfa = mata::nfa::concatenate(nfa, body_nfa, true);
-                    nfa = mata::nfa::remove_epsilon(nfa);
                 }
+
+            } else if (m_util_s.re.is_of_pred(expression)) { // Handle of predicate.
+                util::throw_error("of predicate is unsupported");
+            } else if (m_util_s.re.is_opt(expression)) { // Handle optional.
+                SASSERT(expression->get_num_args() == 1);
+                nfa = *children[0];
+                nfa.unify_initial();
+                for (const auto& initial : nfa.initial) {
+                    nfa.final.insert(initial);
+                }
+            } else if (m_util_s.re.is_range(expression)) { // Handle range.
+                SASSERT(expression->get_num_args() == 2);
+                const auto range_begin{ expression->get_arg(0) };
+                const auto range_end{ expression->get_arg(1) };
+                SASSERT(is_app(range_begin));
+                SASSERT(is_app(range_end));
+                const auto range_begin_value{ to_app(range_begin)->get_parameter(0).get_zstring()[0] };
+                const auto range_end_value{ to_app(range_end)->get_parameter(0).get_zstring()[0] };
+
+                nfa.initial.insert(0);
+                nfa.final.insert(1);
+                // only symbols of the alphabet, the alphabet can contain just one representative for symbols of the
+                // range that are not distinguished in the formula (see theory_str_noodler::add_range_class_representatives)
+                const std::set<uint32_t>& symbols = alphabet.get_alphabet();
+                for (auto symbol_it = symbols.lower_bound(range_begin_value); symbol_it != symbols.end() && *symbol_it <= range_end_value; ++symbol_it) {
+                    nfa.delta.add(0, *symbol_it, 1);
+                }
+            } else if (m_util_s.re.is_reverse(expression)) { // Handle reverse.
+                util::throw_error("reverse is unsupported");
+            } else if (m_util_s.re.is_union(expression)) { // Handle union (= or; A|B), flattened.
+                SASSERT(!children.empty());
+                // unite the children in a balanced way, so that the automata are not copied over and over
+                std::vector<Nfa> united;
+                for (const Nfa* child : children) {
+                    united.push_back(*child);
+                }
+                while (united.size() > 1) {
+                    std::vector<Nfa> next;
+                    for (size_t i = 0; i + 1 < united.size(); i += 2) {
+                        next.push_back(mata::nfa::uni(united[i], united[i + 1]));
+                    }
+                    if (united.size() % 2 == 1) {
+                        next.push_back(std::move(united.back()));
+                    }
+                    united = std::move(next);
+                }
+                nfa = std::move(united[0]);
+            } else if (m_util_s.re.is_star(expression)) { // Handle star iteration.
+                SASSERT(expression->get_num_args() == 1);
+                nfa = *children[0];
+                for (const auto& final : nfa.final) {
+                    for (const auto& initial : nfa.initial) {
+                        nfa.delta.add(final, mata::nfa::EPSILON, initial);
+                    }
+                }
+                nfa.remove_epsilon();
+
+                // Make new initial final in order to accept empty string as is required by kleene-star.
+                mata::nfa::State new_state = nfa.add_state();
+                nfa.initial.insert(new_state);
+                nfa.final.insert(new_state);
+
+            } else if (m_util_s.re.is_plus(expression)) { // Handle positive iteration.
+                SASSERT(expression->get_num_args() == 1);
+                nfa = *children[0];
+                for (const auto& final : nfa.final) {
+                    for (const auto& initial : nfa.initial) {
+                        nfa.delta.add(final, mata::nfa::EPSILON, initial);
+                    }
+                }
+                nfa.remove_epsilon();
+            } else if(m_util_s.str.is_string(expression)) { // Handle string literal.
+                SASSERT(expression->get_num_parameters() == 1);
+                nfa = AutAssignment::create_word_nfa(expression->get_parameter(0).get_zstring());
+            } else if(util::is_variable(expression)) { // Handle variable.
+                util::throw_error("variable in regexes are unsupported");
+            } else {
+                util::throw_error("unsupported operation in regex");
             }
 
-        } else if (m_util_s.re.is_of_pred(expression)) { // Handle of predicate.
-            util::throw_error("of predicate is unsupported");
-        } else if (m_util_s.re.is_opt(expression)) { // Handle optional.
-            SASSERT(expression->get_num_args() == 1);
-            const auto child{ expression->get_arg(0) };
-            SASSERT(is_app(child));
-            nfa = conv_to_nfa(to_app(child), m_util_s, m, alphabet, determinize);
-            nfa.unify_initial();
-            for (const auto& initial : nfa.initial) {
-                nfa.final.insert(initial);
+            return nfa;
+        }
+
+        /**
+         * @brief Reduce (and determinize/complement if requested) NFA @p nfa obtained for the regex @p expression.
+         */
+        Nfa postprocess_regex_nfa(Nfa nfa, const app *expression, const ast_manager& m, const Alphabet& alphabet,
+                                  bool determinize, bool make_complement) {
+            // intermediate automata reduction
+            // if the automaton is too big --> skip it. The computation of the simulation would be too expensive.
+            if(nfa.num_of_states() < RED_BOUND) {
+                STRACE("str-create_nfa-reduce", 
+                    tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " that is going to be reduced" << "---------------" << std::endl;
+                    nfa.print_to_DOT(tout);
+                );
+                nfa = mata::nfa::reduce(nfa);
+            }
+            if(determinize) {
+                STRACE("str-create_nfa-reduce", 
+                    tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " that is going to be minimized" << "---------------" << std::endl;
+                    nfa.print_to_DOT(tout);
+                );
+                nfa = mata::nfa::minimize(nfa);
             }
-        } else if (m_util_s.re.is_range(expression)) { // Handle range.
-            SASSERT(expression->get_num_args() == 2);
-            const auto range_begin{ expression->get_arg(0) };
-            const auto range_end{ expression->get_arg(1) };
-            SASSERT(is_app(range_begin));
-            SASSERT(is_app(range_end));
-            const auto range_begin_value{ to_app(range_begin)->get_parameter(0).get_zstring()[0] };
-            const auto range_end_value{ to_app(range_end)->get_parameter(0).get_zstring()[0] };
 
-            nfa.initial.insert(0);
-            nfa.final.insert(1);
-            auto current_value{ range_begin_value };
-            while (current_value <= range_end_value) {
-                nfa.delta.add(0, current_value, 1);
-                ++current_value;
+            STRACE("str-create_nfa",
+                tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << "---------------" << std::endl;
+                nfa.print_to_DOT(tout);
+            );
+
+            // Whether to create complement of the final automaton.
+            // Warning: is_complement assumes we do the following, so if you to change this, go check is_complement first
+            if (make_complement) {
+                STRACE("str-create_nfa", tout << "Complemented NFA:" << std::endl;);
+                nfa = mata::nfa::complement(nfa, alphabet.get_mata_alphabet(), { 
+                    {"algorithm", "classical"}, 
+                    //{"minimize", "true"} // it seems that minimizing during complement causes more TOs in benchmarks
+                    });
+                STRACE("str-create_nfa", nfa.print_to_DOT(tout););
             }
-        } else if (m_util_s.re.is_reverse(expression)) { // Handle reverse.
-            util::throw_error("reverse is unsupported");
-        } else if (m_util_s.re.is_union(expression)) { // Handle union (= or; A|B).
-            SASSERT(expression->get_num_args() == 2);
-            const auto left{ expression->get_arg(0) };
-            const auto right{ expression->get_arg(1) };
-            SASSERT(is_app(left));
-            SASSERT(is_app(right));
-            
-            mata::nfa::Nfa aut1 {conv_to_nfa(to_app(left), m_util_s, m, alphabet, determinize)};
-            mata::nfa::Nfa aut2 {conv_to_nfa(to_app(right), m_util_s, m, alphabet, determinize)};
-            nfa = mata::nfa::uni(aut1, aut2);
-            
-        } else if (m_util_s.re.is_star(expression)) { // Handle star iteration.
-            SASSERT(expression->get_num_args() == 1);
-            const auto child{ expression->get_arg(0) };
-            SASSERT(is_app(child));
-            nfa = conv_to_nfa(to_app(child), m_util_s, m, alphabet, determinize);
-            for (const auto& final : nfa.final) {
-                for (const auto& initial : nfa.initial) {
-                    nfa.delta.add(final, mata::nfa::EPSILON, initial);
+            return nfa;
+        }
+    }
+
+    [[nodiscard]] Nfa conv_to_nfa(const app *expression, const seq_util& m_util_s, const ast_manager& m,
+                                  const Alphabet& alphabet, bool determinize, bool make_complement) {
+        // complements at the top just change whether the result is complemented
+        while (m_util_s.re.is_complement(expression)) {
+            expression = to_app(expression->get_arg(0));
+            make_complement = !make_complement;
+        }
+
+        // post-order traversal of the regex DAG with an explicit stack, each subregex is converted only once
+        struct Frame {
+            const app* expression;
+            bool expanded;
+            std::vector<const app*> children;
+        };
+        std::unordered_map<const app*, Nfa> converted;
+        std::vector<Frame> stack{ {expression, false, {}} };
+        while (!stack.empty()) {
+            const app* node = stack.back().expression;
+            if (converted.contains(node)) {
+                stack.pop_back();
+                continue;
+            }
+            const bool complement = (node == expression) ? make_complement : m_util_s.re.is_complement(node);
+
+            if (!stack.back().expanded) {
+                stack.back().expanded = true;
+                Nfa nfa{};
+                // star-free and simple-star regexes are converted directly
+                if (create_glushkov_nfa(node, m_util_s, alphabet, nfa)) {
+                    stack.pop_back();
+                    converted.emplace(node, postprocess_regex_nfa(std::move(nfa), node, m, alphabet, determinize, complement));
+                    continue;
+                }
+                std::vector<const app*> children = get_regex_children(node, m_util_s);
+                stack.back().children = children;
+                for (auto child_it = children.rbegin(); child_it != children.rend(); ++child_it) {
+                    if (!converted.contains(*child_it)) {
+                        stack.push_back({*child_it, false, {}});
+                    }
                 }
+                continue;
             }
-            nfa.remove_epsilon();
 
-            // Make new initial final in order to accept empty string as is required by kleene-star.
-            mata::nfa::State new_state = nfa.add_state();
-            nfa.initial.insert(new_state);
-            nfa.final.insert(new_state);
+            std::vector<const Nfa*> children_nfas;
+            for (const app* child : stack.back().children) {
+                children_nfas.push_back(&converted.at(child));
+            }
+            Nfa nfa = convert_regex_node(node, children_nfas, m_util_s, alphabet);
+            stack.pop_back();
+            converted.emplace(node, postprocess_regex_nfa(std::move(nfa), node, m, alphabet, determinize, complement));
+        }
+        return std::move(converted.at(expression));
+    }
 
-        } else if (m_util_s.re.is_plus(expression)) { // Handle positive iteration.
-            SASSERT(expression->get_num_args() == 1);
-            const auto child{ expression->get_arg(0) };
-            SASSERT(is_app(child));
-            nfa = conv_to_nfa(to_app(child), m_util_s, m, alphabet);
-            for (const auto& final : nfa.final) {
-                for (const auto& initial : nfa.initial) {
-                    nfa.delta.add(final, mata::nfa::EPSILON, initial);
+    unsigned NfaCache::get_alphabet_id(const Alphabet& alphabet) {
+        auto alph_it = this->alphabet_ids.find(alphabet.get_alphabet());
+        if(alph_it == this->alphabet_ids.end()) {
+            alph_it = this->alphabet_ids.insert({alphabet.get_alphabet(), this->alphabet_ids.size()}).first;
+        }
+        return alph_it->second;
+    }
+
+    bool NfaCache::are_equivalent(const app *left, const app *right, const seq_util& m_util_s, const ast_manager& m,
+                                  const Alphabet& alphabet, std::vector<mata::Symbol>* witness) {
+        if(left == right) {
+            return true;
+        }
+        if(left->get_id() > right->get_id()) {
+            std::swap(left, right);
+        }
+        std::tuple<const app*, const app*, unsigned> key{left, right, get_alphabet_id(alphabet)};
+        auto it = this->equivalences.find(key);
+        if(it == this->equivalences.end()) {
+            std::shared_ptr<const mata::nfa::Nfa> nfa1 = get_nfa(left, m_util_s, m, alphabet);
+            std::shared_ptr<const mata::nfa::Nfa> nfa2 = get_nfa(right, m_util_s, m, alphabet);
+            // the inclusions stop at the first word in one language and not in the other
+            mata::nfa::Run counterexample;
+            bool equivalent = mata::nfa::is_included(*nfa1, *nfa2, &counterexample, &alphabet.get_mata_alphabet())
+                           && mata::nfa::is_included(*nfa2, *nfa1, &counterexample, &alphabet.get_mata_alphabet());
+            ast_manager& mng = const_cast<ast_manager&>(m);
+            it = this->equivalences.emplace(key, EquivalenceEntry{ equivalent, equivalent ? std::vector<mata::Symbol>() : std::move(counterexample.word),
+                                                                   app_ref(const_cast<app*>(left), mng), app_ref(const_cast<app*>(right), mng) }).first;
+        } else {
+            ++this->equivalence_hits;
+        }
+        if(witness != nullptr && !it->second.equivalent) {
+            *witness = it->second.witness;
+        }
+        return it->second.equivalent;
+    }
+
+    std::shared_ptr<const mata::nfa::Nfa> NfaCache::get_nfa(const app *expression, const seq_util& m_util_s, const ast_manager& m,
+                                                            const Alphabet& alphabet, bool determinize, bool make_complement) {
+        key_type key{expression, get_alphabet_id(alphabet), determinize, make_complement};
+        auto it = this->cache.find(key);
+        if(it != this->cache.end()) {
+            STRACE("str-create_nfa", tout << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " found in the cache" << std::endl;);
+            this->lru.splice(this->lru.begin(), this->lru, it->second.lru_it);
+            return it->second.nfa;
+        }
+        std::shared_ptr<const mata::nfa::Nfa> nfa;
+        if(this->store != nullptr || this->collect_computed) {
+            NfaFingerprint fingerprint = fingerprint_regex(expression, alphabet.get_alphabet(), determinize, make_complement);
+            NfaView view;
+            if(this->store != nullptr && this->store->find(fingerprint, view)) {
+                STRACE("str-create_nfa", tout << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " found in the store" << std::endl;);
+                nfa = std::make_shared<const mata::nfa::Nfa>(view.to_nfa());
+                ++this->store_hits;
+            } else {
+                nfa = std::make_shared<const mata::nfa::Nfa>(conv_to_nfa(expression, m_util_s, m, alphabet, determinize, make_complement));
+                if(this->collect_computed) {
+                    this->computed_nfas.emplace_back(fingerprint, nfa);
                 }
             }
-            nfa.remove_epsilon();
-        } else if(m_util_s.str.is_string(expression)) { // Handle string literal.
-            SASSERT(expression->get_num_parameters() == 1);
-            nfa = AutAssignment::create_word_nfa(expression->get_parameter(0).get_zstring());
-        } else if(util::is_variable(expression)) { // Handle variable.
-            util::throw_error("variable in regexes are unsupported");
         } else {
-            util::throw_error("unsupported operation in regex");
+            nfa = std::make_shared<const mata::nfa::Nfa>(conv_to_nfa(expression, m_util_s, m, alphabet, determinize, make_complement));
         }
+        size_t bytes = AutomataPool::approx_bytes(*nfa);
+        this->lru.push_front(key);
+        this->cache.emplace(key, Entry{ nfa, app_ref(const_cast<app*>(expression), const_cast<ast_manager&>(m)), bytes, this->lru.begin() });
+        this->cached_bytes += bytes;
+        set_memory_limit(this->memory_limit);
+        return nfa;
+    }
 
-        // intermediate automata reduction
-        // if the automaton is too big --> skip it. The computation of the simulation would be too expensive.
-        if(nfa.num_of_states() < RED_BOUND) {
-            STRACE("str-create_nfa-reduce", 
-                tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " that is going to be reduced" << "---------------" << std::endl;
-                nfa.print_to_DOT(tout);
-            );
-            nfa = mata::nfa::reduce(nfa);
+    void NfaCache::set_memory_limit(size_t bytes) {
+        this->memory_limit = bytes;
+        if(this->memory_limit != 0) {
+            shrink(this->memory_limit);
         }
-        if(determinize) {
-            STRACE("str-create_nfa-reduce", 
-                tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << " that is going to be minimized" << "---------------" << std::endl;
-                nfa.print_to_DOT(tout);
-            );
-            nfa = mata::nfa::minimize(nfa);
+    }
+
+    void NfaCache::shrink(size_t bytes) {
+        // the most recently used NFA is kept even if it exceeds the limit alone
+        while(this->cached_bytes > bytes && this->lru.size() > 1) {
+            auto it = this->cache.find(this->lru.back());
+            this->cached_bytes -= it->second.bytes;
+            this->cache.erase(it);
+            this->lru.pop_back();
+            ++this->num_evicted;
+        }
+    }
+
+    RegexInfo RegexInfoCache::get(const app* regex, const seq_util& m_util_s, ast_manager& m) {
+        RegexInfo res;
+        if(this->infos.find(const_cast<app*>(regex), res)) {
+            ++this->hits;
+            return res;
         }
+        // the subregexes are memoized too, they are kept alive by the cached root regex (which is kept alive
+        // before the computation, as it can throw after memoizing some subregexes)
+        this->regexes.push_back(app_ref(const_cast<app*>(regex), m));
+        return get_regex_info(regex, m_util_s, m, this->infos);
+    }
 
-        STRACE("str-create_nfa",
-            tout << "--------------" << "NFA for: " << mk_pp(const_cast<app*>(expression), const_cast<ast_manager&>(m)) << "---------------" << std::endl;
-            nfa.print_to_DOT(tout);
-        );
+    lbool MembershipCache::is_member(const zstring& word, const app* regex, seq_util& m_util_s, ast_manager& m, th_rewriter& rewriter) {
+        auto key = std::make_pair(word, regex);
+        auto it = this->cache.find(key);
+        if(it != this->cache.end()) {
+            ++this->hits;
+            return it->second;
+        }
+        if(this->cache.size() >= MAX_MEMOIZED) {
+            reset();
+        }
 
-        // Whether to create complement of the final automaton.
-        // Warning: is_complement assumes we do the following, so if you to change this, go check is_complement first
-        if (make_complement) {
-            STRACE("str-create_nfa", tout << "Complemented NFA:" << std::endl;);
-            nfa = mata::nfa::complement(nfa, alphabet.get_mata_alphabet(), { 
-                {"algorithm", "classical"}, 
-                //{"minimize", "true"} // it seems that minimizing during complement causes more TOs in benchmarks
-                });
-            STRACE("str-create_nfa", nfa.print_to_DOT(tout););
+        expr_ref membership(m_util_s.re.mk_in_re(m_util_s.str.mk_string(word), const_cast<app*>(regex)), m);
+        rewriter(membership);
+        lbool res = l_undef;
+        if(m.is_true(membership)) {
+            res = l_true;
+        } else if(m.is_false(membership)) {
+            res = l_false;
         }
-        return nfa;
+        STRACE("str-create_nfa", tout << "membership of \"" << word << "\" in " << mk_pp(const_cast<app*>(regex), m) << " rewritten to " << mk_pp(membership, m) << std::endl;);
+
+        this->regexes.push_back(app_ref(const_cast<app*>(regex), m));
+        this->cache.insert({key, res});
+        return res;
+    }
+
+    bool NfaCache::save_store(const std::string& path) const {
+        if(this->computed_nfas.empty()) {
+            return true;
+        }
+        NfaStoreWriter writer;
+        for(const auto& [fingerprint, nfa] : this->computed_nfas) {
+            writer.add(fingerprint, *nfa);
+        }
+        // the file is opened again, as it could have been replaced by another process in the meantime
+        std::shared_ptr<const NfaStore> current;
+        try {
+            current = NfaStore::open(path);
+        } catch(const default_exception&) {
+            current = this->store;
+        }
+        if(current != nullptr) {
+            writer.add_all(*current);
+        }
+        return writer.write(path);
+    }
+
+    void NfaCache::notify_alphabet(const std::set<uint32_t>& alphabet) {
+        // with a memory limit, the NFAs for smaller alphabets are dropped only if they are not used
+        if(this->memory_limit != 0 || std::includes(this->known_symbols.begin(), this->known_symbols.end(), alphabet.begin(), alphabet.end())) {
+            return;
+        }
+        STRACE("str-create_nfa", tout << "alphabet grew, dropping " << this->cache.size() << " cached NFAs" << std::endl;);
+        std::set<uint32_t> symbols = this->known_symbols;
+        symbols.insert(alphabet.begin(), alphabet.end());
+        reset();
+        this->known_symbols = std::move(symbols);
     }
 
     [[nodiscard]] RegexInfo get_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m) {
+        obj_map<app, RegexInfo> memo;
+        return get_regex_info(expression, m_util_s, m, memo);
+    }
+
+    RegexInfo get_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m, obj_map<app, RegexInfo>& memo) {
+        // shared subregexes are evaluated only once (regexes are hash-consed DAGs)
+        RegexInfo res;
+        if (memo.find(const_cast<app*>(expression), res)) {
+            return res;
+        }
+        res = compute_regex_info(expression, m_util_s, m, memo);
+        memo.insert(const_cast<app*>(expression), res);
+        return res;
+    }
+
+    RegexInfo compute_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m, obj_map<app, RegexInfo>& memo) {
         if (m_util_s.re.is_to_re(expression)) { // Handle conversion of to regex function call.
             SASSERT(expression->get_num_args() == 1);
             const auto arg{ expression->get_arg(0) };
@@ -265,15 +759,15 @@ namespace smt::noodler::regex {
             if (!m_util_s.str.is_string(arg)) { // if to_re has something other than string literal
                 util::throw_error("we support only string literals in str.to_re");
             }
-            return get_regex_info(to_app(arg), m_util_s, m);
+            return get_regex_info(to_app(arg), m_util_s, m, memo);
         } else if (m_util_s.re.is_concat(expression)) { // Handle regex concatenation.
             SASSERT(expression->get_num_args() > 0);
-            RegexInfo res = get_regex_info(to_app(expression->get_arg(0)), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(expression->get_arg(0)), m_util_s, m, memo);
             // min_length: sum of min_lengths of concats
             // empty: one of them is undef --> undef
             // universal: if min_length > 0 --> not universal
             for (unsigned int i = 1; i < expression->get_num_args(); ++i) {
-                RegexInfo con = get_regex_info(to_app(expression->get_arg(i)), m_util_s, m);
+                RegexInfo con = get_regex_info(to_app(expression->get_arg(i)), m_util_s, m, memo);
                 res.min_length += con.min_length;
                 if(res.empty == l_undef || con.empty == l_undef) {
                     res.empty = l_undef;
@@ -297,7 +791,7 @@ namespace smt::noodler::regex {
             // min_length: 0
             // empty: universal --> true; empty --> false; min_length > 0 and !empty --> false
             // universal: empty --> true< universal --> false
-            RegexInfo res = get_regex_info(to_app(child), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(child), m_util_s, m, memo);
             res.min_length = 0;
             if(res.empty == l_true) {
                 res.empty = l_false;
@@ -332,9 +826,9 @@ namespace smt::noodler::regex {
             // min_length: maximum of each regex from intersection
             // empty: if one of them is empty --> true; otherwise undef
             // universal: min_length > 0 --> false; otherwise undef
-            RegexInfo res = get_regex_info(to_app(expression->get_arg(0)), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(expression->get_arg(0)), m_util_s, m, memo);
             for (unsigned int i = 1; i < expression->get_num_args(); ++i) {
-                RegexInfo prod = get_regex_info(to_app(expression->get_arg(i)), m_util_s, m);
+                RegexInfo prod = get_regex_info(to_app(expression->get_arg(i)), m_util_s, m, memo);
                 res.min_length = std::max(res.min_length, prod.min_length);
                 if(prod.empty == l_true) {
                     res.empty = l_true;
@@ -360,7 +854,7 @@ namespace smt::noodler::regex {
             // min_length: low == 0 --> 0; otherwise min_length * low
             // empty: low == 0 --> false; otherwise the same as the original empty
             // universal: min_length > 0 --> false; empty && low == 0 --> false
-            RegexInfo res = get_regex_info(to_app(body), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(body), m_util_s, m, memo);
             if(res.empty == l_true && low == 0) {
                 return RegexInfo{.min_length = 0, .universal = l_false, .empty = l_false};
             }
@@ -377,7 +871,7 @@ namespace smt::noodler::regex {
             const auto child{ expression->get_arg(0) };
             SASSERT(is_app(child));
             // min_length: 0 (epsilon)
-            RegexInfo res = get_regex_info(to_app(child), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(child), m_util_s, m, memo);
             res.min_length = 0;
             res.empty = l_false;
             return res;
@@ -410,8 +904,8 @@ namespace smt::noodler::regex {
             // min_length: minimum of min_length of both guys
             // empty: if one of them is not empty --> false; otherwise undef
             // universal: if min_length > 0 --> false; if both are universal --> true; otherwise undef
-            RegexInfo res = get_regex_info(to_app(left), m_util_s, m);
-            RegexInfo uni = get_regex_info(to_app(right), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(left), m_util_s, m, memo);
+            RegexInfo uni = get_regex_info(to_app(right), m_util_s, m, memo);
             res.min_length = std::min(uni.min_length, res.min_length);
             if(uni.empty == l_false || res.empty == l_false) {
                 res.empty = l_false;
@@ -435,7 +929,7 @@ namespace smt::noodler::regex {
             SASSERT(expression->get_num_args() == 1);
             const auto child{ expression->get_arg(0) };
             SASSERT(is_app(child));
-            RegexInfo res = get_regex_info(to_app(child), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(child), m_util_s, m, memo);
             return RegexInfo{.min_length = 0, .universal = res.universal == l_true ? l_true : l_undef, .empty = l_false};
 
         } else if (m_util_s.re.is_plus(expression)) { // Handle positive iteration.
@@ -444,7 +938,7 @@ namespace smt::noodler::regex {
             SASSERT(is_app(child));
 
             // empty: the original guy is empty <--> true
-            RegexInfo res = get_regex_info(to_app(child), m_util_s, m);
+            RegexInfo res = get_regex_info(to_app(child), m_util_s, m, memo);
             res.universal = l_undef;
             return res;
         } else if(m_util_s.str.is_string(expression)) { // Handle string literal.
@@ -459,23 +953,27 @@ namespace smt::noodler::regex {
     }
 
     mata::nfa::Nfa create_large_concat(const mata::nfa::Nfa& body_nfa, unsigned count) {
-        mata::nfa::Nfa nfa_part = mata::nfa::builder::create_empty_string_nfa();
-        mata::nfa::Nfa nfa = mata::nfa::builder::create_empty_string_nfa();
-        const unsigned CONCAT = 100;
+        // intermediate automata are reduced (if they are not too big), so that the following concatenations are smaller
+        auto reduce_part = [](mata::nfa::Nfa& aut) {
+            aut.trim();
+            if (aut.num_of_states() < RED_BOUND) {
+                aut = mata::nfa::reduce(aut);
+            }
+        };
 
-        for(unsigned i = 0; i < CONCAT; i++) {
-            nfa_part.concatenate(body_nfa);
-            nfa_part.trim();
-        }
-        unsigned cnt = 0;
-        for(unsigned i = 0; i < count / CONCAT; i++) {
-            nfa.concatenate(nfa_part);
-            nfa.trim();
-            cnt += CONCAT;
-        }
-        for(; cnt <= count; cnt++) {
-            nfa.concatenate(body_nfa);
-            nfa.trim();
+        // body_nfa^count is the concatenation of body_nfa^(2^i) for all bits i set in count
+        mata::nfa::Nfa nfa = mata::nfa::builder::create_empty_string_nfa();
+        mata::nfa::Nfa power = body_nfa; // body_nfa^(2^i)
+        while (count > 0) {
+            if (count & 1) {
+                nfa.concatenate(power);
+                reduce_part(nfa);
+            }
+            count >>= 1;
+            if (count > 0) {
+                power = mata::nfa::concatenate(power, power);
+                reduce_part(power);
+            }
         }
 
         return nfa;
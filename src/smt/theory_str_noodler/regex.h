@@ -8,6 +8,7 @@
 #include <map>
 #include <memory>
 #include <queue>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "formula.h"
 #include "util.h"
 #include "aut_assignment.h"
+#include "nfa_store.h"
 
 // FIXME most if not all these functions should probably be in theory_str_noodler
 
@@ -34,8 +36,8 @@ namespace smt::noodler::regex {
     using expr_pair = std::pair<expr_ref, expr_ref>;
     using expr_pair_flag = std::tuple<expr_ref, expr_ref, bool>;
 
-    // bound for loop (above this number an optimized construction is used)
-    const unsigned LOOP_BOUND = 5000;
+    // bound for loop (above this number an optimized construction is used, see create_large_concat)
+    const unsigned LOOP_BOUND = 100;
     // simulation reduction bound in states (bigger automata are not reduced)
     const unsigned RED_BOUND = 1000;
 
@@ -91,6 +93,175 @@ namespace smt::noodler::regex {
     [[nodiscard]] mata::nfa::Nfa conv_to_nfa(const app *expression, const seq_util& m_util_s, const ast_manager& m,
                                              const Alphabet& alphabet, bool determinize = false, bool make_complement = false);
 
+    /**
+     * @brief Create the Glushkov (position) automaton of regex @p expression in one pass over the regex.
+     *
+     * The automaton is epsilon-free and has n+1 states for n symbol positions of the regex. Only concatenations,
+     * unions, iterations (star, plus, opt), string literals, ranges, full char/seq, dot plus, epsilon and empty
+     * language are supported, the other regexes (complement, intersection, loop, ...) are left to the compositional
+     * construction of conv_to_nfa.
+     * @param[in] alphabet Alphabet used for re.allchar and ranges.
+     * @param[out] nfa The resulting automaton (set only if the construction succeeds).
+     * @return Whether the construction succeeded.
+     */
+    bool create_glushkov_nfa(const app *expression, const seq_util& m_util_s, const Alphabet& alphabet, mata::nfa::Nfa& nfa);
+
+    /**
+     * @brief Cache of NFAs obtained by conv_to_nfa. Regexes are hash-consed, so the NFA is determined by
+     * the regex, the alphabet and the flags of conv_to_nfa. The cache keeps references to the cached
+     * regexes, so the pointers used as keys stay valid.
+     *
+     * Entries are dropped when the alphabet of the formula grows (see notify_alphabet()), as the
+     * automata for smaller alphabets are not likely to be needed anymore. If the cache has a memory limit
+     * (see set_memory_limit()), the least recently used entries are dropped instead, when the limit is exceeded.
+     *
+     * The cache can be warm-started from an NfaStore (see set_store()), the missing NFAs are then looked up in the
+     * store by the fingerprint of the regex before they are computed; the computed ones can be saved to a new store
+     * (see save_store()).
+     */
+    class NfaCache {
+    private:
+        using key_type = std::tuple<const app*, unsigned, bool, bool>; // regex, alphabet id, determinize, complement
+
+        struct Entry {
+            std::shared_ptr<const mata::nfa::Nfa> nfa;
+            app_ref regex; // keeps the cached regex alive
+            // approximate size of the NFA and the position of the entry in lru
+            size_t bytes;
+            std::list<key_type>::iterator lru_it;
+        };
+
+        std::map<key_type, Entry> cache;
+        // results of are_equivalent() for (regex, regex, alphabet id), the regexes ordered by their ids
+        struct EquivalenceEntry {
+            bool equivalent;
+            // a word in exactly one of the languages if they are not equivalent
+            std::vector<mata::Symbol> witness;
+            app_ref left, right; // keep the regexes alive
+        };
+        std::map<std::tuple<const app*, const app*, unsigned>, EquivalenceEntry> equivalences;
+        // keys from the most recently used one
+        std::list<key_type> lru;
+        size_t cached_bytes = 0;
+        size_t memory_limit = 0;
+        unsigned num_evicted = 0;
+        std::map<std::set<uint32_t>, unsigned> alphabet_ids;
+        std::set<uint32_t> known_symbols; // union of all alphabets passed to notify_alphabet
+        std::shared_ptr<const NfaStore> store;
+        // NFAs computed since the store was set (they are kept by reset(), as they are saved by save_store())
+        std::vector<std::pair<NfaFingerprint, std::shared_ptr<const mata::nfa::Nfa>>> computed_nfas;
+        bool collect_computed = false;
+        unsigned store_hits = 0;
+        unsigned equivalence_hits = 0;
+
+        unsigned get_alphabet_id(const Alphabet& alphabet);
+
+    public:
+        NfaCache() = default;
+
+        /**
+         * @brief Get NFA for the regex @p expression (see conv_to_nfa), computing it only if it is not cached.
+         */
+        std::shared_ptr<const mata::nfa::Nfa> get_nfa(const app *expression, const seq_util& m_util_s, const ast_manager& m,
+                                                      const Alphabet& alphabet, bool determinize = false, bool make_complement = false);
+
+        /**
+         * @brief Check whether the regexes @p left and @p right represent the same language over @p alphabet.
+         *
+         * The result is cached for the pair of regexes (in any order) and the alphabet. The inclusions of the NFAs
+         * (see get_nfa()) are checked by antichains, the second direction only if the first one holds.
+         * @param[out] witness If not nullptr and the languages differ, set to a word in exactly one of them.
+         */
+        bool are_equivalent(const app *left, const app *right, const seq_util& m_util_s, const ast_manager& m,
+                            const Alphabet& alphabet, std::vector<mata::Symbol>* witness = nullptr);
+
+        unsigned get_equivalence_hits() const { return equivalence_hits; }
+
+        /**
+         * @brief Notify the cache about the alphabet of the current formula. If @p alphabet contains
+         * a symbol that was not seen before, the cache is cleared.
+         */
+        void notify_alphabet(const std::set<uint32_t>& alphabet);
+
+        /**
+         * @brief Use @p store (can be nullptr) for the NFAs that are not cached. If @p collect is true, the NFAs that
+         * are computed afterwards are kept for save_store().
+         */
+        void set_store(std::shared_ptr<const NfaStore> store, bool collect) {
+            this->store = std::move(store);
+            this->collect_computed = collect;
+        }
+
+        /**
+         * @brief Write the computed NFAs together with the NFAs of the store in @p path (if it exists) to @p path,
+         * nothing is written if no new NFA was computed.
+         *
+         * @return False if the file could not be written
+         */
+        bool save_store(const std::string& path) const;
+
+        unsigned get_store_hits() const { return store_hits; }
+
+        /**
+         * @brief Limit the approximate memory of the cached NFAs to @p bytes (0 means no limit), the least recently
+         * used NFAs are dropped when it is exceeded.
+         */
+        void set_memory_limit(size_t bytes);
+
+        /**
+         * @brief Drop the least recently used NFAs until their approximate memory is at most @p bytes.
+         */
+        void shrink(size_t bytes);
+
+        size_t get_cached_bytes() const { return cached_bytes; }
+        unsigned get_num_evicted() const { return num_evicted; }
+
+        void reset() {
+            cache.clear();
+            lru.clear();
+            cached_bytes = 0;
+            equivalences.clear();
+            alphabet_ids.clear();
+            known_symbols.clear();
+        }
+
+        size_t size() const { return cache.size(); }
+    };
+
+    /**
+     * @brief Cache of memberships of concrete words in regexes decided without automata.
+     *
+     * The membership is rewritten by the sequence rewriter, which decides memberships of string literals in
+     * ground regexes by (Antimirov) derivatives of the regex, one symbol of the word after another. The cache keeps
+     * references to the cached regexes, so the pointers used as keys stay valid.
+     */
+    class MembershipCache {
+    private:
+        std::map<std::pair<zstring, const app*>, lbool> cache;
+        std::vector<app_ref> regexes; // keeps the cached regexes alive
+        unsigned hits = 0;
+
+        static const size_t MAX_MEMOIZED = 10000;
+
+    public:
+        /**
+         * @brief Decide whether @p word is in the language of @p regex, l_undef if the rewriter could not decide it.
+         */
+        lbool is_member(const zstring& word, const app* regex, seq_util& m_util_s, ast_manager& m, th_rewriter& rewriter);
+
+        unsigned get_hits() const { return hits; }
+
+        size_t get_bytes() const {
+            // nodes of the map with the words and the references to the regexes
+            return cache.size() * (sizeof(std::pair<zstring, const app*>) + sizeof(lbool) + 4 * sizeof(void*)) + regexes.size() * sizeof(app_ref);
+        }
+
+        void reset() {
+            cache.clear();
+            regexes.clear();
+        }
+    };
+
     /**
      * @brief Get basic information about the regular expression in the form of RegexInfo (see the description above). 
      * RegexInfo gathers information about emptiness; universality; length of shortest words
@@ -102,9 +273,49 @@ namespace smt::noodler::regex {
      */
     RegexInfo get_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m);
 
+    /**
+     * @brief Get RegexInfo of @p expression, using and extending @p memo of RegexInfos of (sub)regexes, so each
+     * node of the regex DAG is evaluated only once.
+     */
+    RegexInfo get_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m, obj_map<app, RegexInfo>& memo);
+
+    /**
+     * @brief Compute RegexInfo of @p expression from RegexInfos of its children (obtained from @p memo).
+     */
+    RegexInfo compute_regex_info(const app *expression, const seq_util& m_util_s, const ast_manager& m, obj_map<app, RegexInfo>& memo);
+
+    /**
+     * @brief Cache of RegexInfos of regexes (see get_regex_info()), regexes are hash-consed, so the info is
+     * determined by the regex. The cache keeps references to the cached regexes (and so to their subregexes),
+     * so the pointers used as keys stay valid.
+     */
+    class RegexInfoCache {
+    private:
+        obj_map<app, RegexInfo> infos;
+        std::vector<app_ref> regexes; // keeps the cached regexes alive
+        unsigned hits = 0;
+
+    public:
+        RegexInfo get(const app* regex, const seq_util& m_util_s, ast_manager& m);
+
+        unsigned get_hits() const { return hits; }
+
+        size_t get_bytes() const {
+            return infos.size() * (sizeof(app*) + sizeof(RegexInfo) + sizeof(void*)) + regexes.size() * sizeof(app_ref);
+        }
+
+        void reset() {
+            infos.reset();
+            regexes.clear();
+        }
+    };
+
     /**
      * @brief Create bounded iteration of a given automaton. 
      * 
+     * The iteration is computed by repeated squaring, i.e., only O(log count) concatenations of
+     * (reduced) automata are needed.
+     * 
      * @param body_nfa Core NFA
      * @param count Number of concatenations
      * @return mata::nfa::Nfa NFA
@@ -0,0 +1,65 @@
+#include <memory>
+
+#include "session.h"
+
+namespace smt::noodler {
+
+    namespace {
+        /**
+         * @brief Holder of the session of a manager, it is registered to the manager as a plugin (without any sorts
+         * and declarations), so that the session is released while the cached terms can still be released.
+         */
+        class noodler_session_plugin : public decl_plugin {
+        public:
+            NoodlerSession session;
+
+            void finalize() override {
+                session.reset();
+            }
+
+            decl_plugin* mk_fresh() override {
+                // the caches refer to the terms of this manager, a new manager gets an empty session
+                return alloc(noodler_session_plugin);
+            }
+
+            sort* mk_sort(decl_kind k, unsigned num_parameters, parameter const* parameters) override {
+                UNREACHABLE();
+                return nullptr;
+            }
+
+            func_decl* mk_func_decl(decl_kind k, unsigned num_parameters, parameter const* parameters,
+                                    unsigned arity, sort* const* domain, sort* range) override {
+                UNREACHABLE();
+                return nullptr;
+            }
+        };
+    }
+
+    NoodlerSession::NoodlerSession() {
+        // the NFA cache keeps the order of its entries and drops only the least recently used ones, the other caches
+        // cannot be shrunk partially, so they are dropped as a whole
+        governor.register_cache("str nfa cache evictions", [this]() { return nfa_cache.get_cached_bytes(); },
+                                [this](size_t bytes) { nfa_cache.shrink(bytes); });
+        governor.register_cache("str membership cache evictions", [this]() { return membership_cache.get_bytes(); },
+                                [this](size_t) { membership_cache.reset(); }, [this]() { return membership_cache.get_hits(); });
+        governor.register_cache("str regex info cache evictions", [this]() { return regex_info_cache.get_bytes(); },
+                                [this](size_t) { regex_info_cache.reset(); }, [this]() { return regex_info_cache.get_hits(); });
+        governor.register_cache("str automata pool evictions", [this]() { return aut_pool.get_bytes(); },
+                                [this](size_t) { aut_pool.reset(); });
+        governor.register_cache("str preprocess memo evictions", [this]() { return preprocess_memo.get_bytes(); },
+                                [this](size_t) { preprocess_memo.clear(); });
+        governor.register_cache("str length abstraction evictions", [this]() { return len_abstraction_cache.get_bytes(); },
+                                [this](size_t) { len_abstraction_cache.reset(); }, [this]() { return len_abstraction_cache.get_hits(); });
+        governor.register_cache("str literal store evictions", [this]() { return literal_store.get_bytes(); },
+                                [this](size_t) { literal_store.reset(); });
+    }
+
+    NoodlerSession& NoodlerSession::get(ast_manager& m) {
+        const symbol name("noodler_session");
+        family_id fid = m.mk_family_id(name);
+        if (!m.has_plugin(fid)) {
+            m.register_plugin(name, alloc(noodler_session_plugin));
+        }
+        return static_cast<noodler_session_plugin*>(m.get_plugin(fid))->session;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef _NOODLER_SESSION_H_
+#define _NOODLER_SESSION_H_
+
+#include "ast/ast.h"
+#include "aut_assignment.h"
+#include "cache_governor.h"
+#include "decision_procedure.h"
+#include "literal_store.h"
+#include "regex.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Caches of the string solver kept for the whole life of an ast manager.
+     *
+     * All of them are keyed by hash-consed terms (or automata interned in the pool), so they stay valid as long as
+     * the manager exists. The session of a manager (see get()) is shared by all instances of theory_str_noodler
+     * created for it (e.g. by the contexts of successive check-sat calls of one solver), so that the automata and
+     * preprocessing of an incremental session are not recomputed. The session is destroyed together with the
+     * manager. A copy of the manager (e.g. for a worker of smt.threads) gets a new empty session, so the sessions are
+     * never shared between the contexts of different threads. The interned basic terms are released when the last
+     * session ends.
+     */
+    struct NoodlerSession {
+        // keeps the interned basic terms (of the caches below) while the session lives, so it is the first member
+        BasicTerm::InternScope intern_scope;
+        // NFAs of regexes from memberships
+        regex::NfaCache nfa_cache;
+        // memberships of string literals in regexes decided by derivatives
+        regex::MembershipCache membership_cache;
+        // RegexInfos of regexes from memberships
+        regex::RegexInfoCache regex_info_cache;
+        // shared sigma star, word and interned automata used in aut assignments
+        AutomataPool aut_pool;
+        // results of preprocessing of instances
+        PreprocessMemo preprocess_memo;
+        // lengths of automata (mostly interned in aut_pool) used for the initial length formulae
+        LengthAbstractionCache len_abstraction_cache;
+        // values of string literals with precomputed hashes of prefixes and suffixes
+        LiteralStore literal_store;
+        // bounds the total memory of the caches above (they are registered by the constructor)
+        CacheGovernor governor;
+
+        NoodlerSession();
+        // the governor refers to the caches of this session
+        NoodlerSession(const NoodlerSession&) = delete;
+        NoodlerSession& operator=(const NoodlerSession&) = delete;
+
+        void reset() {
+            nfa_cache.reset();
+            membership_cache.reset();
+            regex_info_cache.reset();
+            aut_pool.reset();
+            preprocess_memo.clear();
+            len_abstraction_cache.reset();
+            literal_store.reset();
+        }
+
+        /**
+         * @brief Get the session of @p m, it is created by the first call for @p m.
+         */
+        static NoodlerSession& get(ast_manager& m);
+    };
+}
+
+#endif
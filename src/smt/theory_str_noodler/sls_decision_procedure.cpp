@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <climits>
+
+#include "sls_decision_procedure.h"
+
+namespace smt::noodler {
+
+    namespace {
+        // moves without improvement after which the search restarts from random words
+        constexpr unsigned RESTART_INTERVAL = 1000;
+        // number of candidate moves compared in one step
+        constexpr unsigned NUM_CANDIDATES = 8;
+        // probability (in percents) of a random candidate move instead of the best one
+        constexpr unsigned NOISE = 10;
+    }
+
+    SlsDecisionProcedure::SlsDecisionProcedure(const Formula& form, const AutAssignment& aut_ass,
+                                               const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                               const std::map<BasicTerm, unsigned>& fixed_lengths,
+                                               const std::set<mata::Symbol>& symbols,
+                                               const theory_str_noodler_params& par, unsigned seed)
+        : max_flips(par.m_sls_max_flips), rand(seed) {
+        for (const Predicate& pred : form.get_predicates()) {
+            if (!pred.is_eq_or_ineq()) {
+                // not supported, the search gives up
+                failed = true;
+                return;
+            }
+            Constraint c{ pred.is_equation(), {}, {} };
+            for (const BasicTerm& term : pred.get_left_side()) {
+                c.left.push_back(mk_term(term));
+            }
+            for (const BasicTerm& term : pred.get_right_side()) {
+                c.right.push_back(mk_term(term));
+            }
+            constraints.push_back(std::move(c));
+        }
+        for (const auto& [var, aut] : aut_ass) {
+            if (var.is_variable()) {
+                add_var(var);
+            }
+        }
+        occurrences.resize(vars.size());
+        for (size_t i = 0; i < constraints.size(); ++i) {
+            for (const auto* side : { &constraints[i].left, &constraints[i].right }) {
+                for (const Term& t : *side) {
+                    if (t.is_var && (occurrences[t.idx].empty() || occurrences[t.idx].back() != i)) {
+                        occurrences[t.idx].push_back(i);
+                    }
+                }
+            }
+        }
+        for (size_t v = 0; v < vars.size(); ++v) {
+            auto it = aut_ass.find(vars[v]);
+            if (it != aut_ass.end()) {
+                auts[v] = it->second;
+            }
+            auto len_it = fixed_lengths.find(vars[v]);
+            if (len_it != fixed_lengths.end()) {
+                fixed_len[v] = len_it->second;
+            }
+            length_sensitive[v] = init_length_sensitive_vars.contains(vars[v]);
+        }
+        alphabet.assign(symbols.begin(), symbols.end());
+        if (alphabet.empty()) {
+            alphabet.push_back(get_dummy_symbol());
+        }
+    }
+
+    size_t SlsDecisionProcedure::add_var(const BasicTerm& var) {
+        auto [it, inserted] = var_index.try_emplace(var, vars.size());
+        if (inserted) {
+            vars.push_back(var);
+            auts.push_back(nullptr);
+            fixed_len.push_back(std::nullopt);
+            length_sensitive.push_back(false);
+        }
+        return it->second;
+    }
+
+    SlsDecisionProcedure::Term SlsDecisionProcedure::mk_term(const BasicTerm& term) {
+        if (term.is_variable()) {
+            return Term{ true, add_var(term) };
+        }
+        const zstring& lit = term.get_name();
+        Word word;
+        word.reserve(lit.length());
+        for (unsigned i = 0; i < lit.length(); ++i) {
+            word.push_back(lit[i]);
+        }
+        literals.push_back(std::move(word));
+        return Term{ false, literals.size() - 1 };
+    }
+
+    SlsDecisionProcedure::Word SlsDecisionProcedure::get_side(const std::vector<Term>& side) const {
+        Word result;
+        for (const Term& t : side) {
+            const Word& w = t.is_var ? words[t.idx] : literals[t.idx];
+            result.insert(result.end(), w.begin(), w.end());
+        }
+        return result;
+    }
+
+    unsigned SlsDecisionProcedure::edit_distance(const Word& a, const Word& b) {
+        if (a.size() < b.size()) {
+            return edit_distance(b, a);
+        }
+        // the quadratic distance is too expensive for long words, then only the aligned symbols are compared
+        if (static_cast<uint64_t>(a.size()) * b.size() > 1000000) {
+            unsigned dist = a.size() - b.size();
+            for (size_t i = 0; i < b.size(); ++i) {
+                dist += a[i] != b[i];
+            }
+            return dist;
+        }
+        std::vector<unsigned> row(b.size() + 1), prev(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) {
+            prev[j] = j;
+        }
+        for (size_t i = 1; i <= a.size(); ++i) {
+            row[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                row[j] = std::min({ prev[j] + 1, row[j - 1] + 1, prev[j - 1] + (a[i - 1] != b[j - 1]) });
+            }
+            std::swap(row, prev);
+        }
+        return prev[b.size()];
+    }
+
+    unsigned SlsDecisionProcedure::aut_distance(const mata::nfa::Nfa& aut, const Word& w) {
+        std::vector<mata::nfa::State> current(aut.initial.begin(), aut.initial.end()), next;
+        for (size_t i = 0; i < w.size(); ++i) {
+            next.clear();
+            for (mata::nfa::State q : current) {
+                for (const auto& symbol_post : aut.delta[q]) {
+                    if (symbol_post.symbol == w[i]) {
+                        next.insert(next.end(), symbol_post.targets.begin(), symbol_post.targets.end());
+                    }
+                }
+            }
+            if (next.empty()) {
+                return w.size() - i + 1;
+            }
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            std::swap(current, next);
+        }
+        for (mata::nfa::State q : current) {
+            if (aut.final.contains(q)) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    unsigned SlsDecisionProcedure::eval_constraint(size_t i) const {
+        const Constraint& c = constraints[i];
+        const Word left = get_side(c.left);
+        const Word right = get_side(c.right);
+        if (c.is_equation) {
+            return edit_distance(left, right);
+        }
+        return left == right ? 1 : 0;
+    }
+
+    unsigned SlsDecisionProcedure::eval_membership(size_t v) const {
+        return auts[v] == nullptr ? 0 : aut_distance(*auts[v], words[v]);
+    }
+
+    unsigned SlsDecisionProcedure::local_cost(size_t v) const {
+        unsigned cost = eval_membership(v);
+        for (size_t i : occurrences[v]) {
+            cost += eval_constraint(i);
+        }
+        return cost;
+    }
+
+    void SlsDecisionProcedure::set_word(size_t v, Word w) {
+        words[v] = std::move(w);
+        total_cost -= membership_cost[v];
+        membership_cost[v] = eval_membership(v);
+        total_cost += membership_cost[v];
+        for (size_t i : occurrences[v]) {
+            total_cost -= constraint_cost[i];
+            constraint_cost[i] = eval_constraint(i);
+            total_cost += constraint_cost[i];
+        }
+    }
+
+    bool SlsDecisionProcedure::restart() {
+        const bool first = words.empty();
+        words.assign(vars.size(), Word{});
+        for (size_t v = 0; v < vars.size(); ++v) {
+            if (auts[v] != nullptr && (first || rand() % 2 == 0)) {
+                std::optional<Word> word = AutAssignment::get_word(*auts[v], fixed_len[v]);
+                if (!word.has_value()) {
+                    return false;
+                }
+                words[v] = std::move(*word);
+            } else {
+                unsigned len = fixed_len[v].has_value() ? *fixed_len[v] : (first ? 0 : rand() % 4);
+                for (unsigned k = 0; k < len; ++k) {
+                    words[v].push_back(alphabet[rand() % alphabet.size()]);
+                }
+            }
+        }
+        constraint_cost.assign(constraints.size(), 0);
+        membership_cost.assign(vars.size(), 0);
+        total_cost = 0;
+        for (size_t i = 0; i < constraints.size(); ++i) {
+            constraint_cost[i] = eval_constraint(i);
+            total_cost += constraint_cost[i];
+        }
+        for (size_t v = 0; v < vars.size(); ++v) {
+            membership_cost[v] = eval_membership(v);
+            total_cost += membership_cost[v];
+        }
+        return true;
+    }
+
+    void SlsDecisionProcedure::init_computation() {
+        if (!failed && !restart()) {
+            // some language has no word of the fixed length
+            failed = true;
+        }
+    }
+
+    void SlsDecisionProcedure::candidate_moves(size_t v, std::vector<Word>& candidates) {
+        candidates.clear();
+        const Word& w = words[v];
+        const bool fixed = fixed_len[v].has_value();
+        auto random_symbol = [&]() { return alphabet[rand() % alphabet.size()]; };
+
+        // align the variable with the other side of an equation in which it occurs
+        if (!occurrences[v].empty()) {
+            const Constraint& c = constraints[occurrences[v][rand() % occurrences[v].size()]];
+            if (c.is_equation) {
+                for (const auto& [side, other] : { std::pair(&c.left, &c.right), std::pair(&c.right, &c.left) }) {
+                    for (size_t pos = 0; pos < side->size(); ++pos) {
+                        if (!(*side)[pos].is_var || (*side)[pos].idx != v) {
+                            continue;
+                        }
+                        const Word other_word = get_side(*other);
+                        const Word prefix = get_side(std::vector<Term>(side->begin(), side->begin() + pos));
+                        const Word suffix = get_side(std::vector<Term>(side->begin() + pos + 1, side->end()));
+                        // the word between the prefix and the suffix, or of length as given
+                        size_t len = other_word.size() >= prefix.size() + suffix.size() ? other_word.size() - prefix.size() - suffix.size() : 0;
+                        if (fixed) {
+                            len = *fixed_len[v];
+                        }
+                        if (prefix.size() <= other_word.size()) {
+                            Word from_left(other_word.begin() + prefix.size(), other_word.begin() + std::min(other_word.size(), prefix.size() + len));
+                            while (from_left.size() < len) {
+                                from_left.push_back(random_symbol());
+                            }
+                            candidates.push_back(std::move(from_left));
+                        }
+                        if (suffix.size() <= other_word.size()) {
+                            const size_t end = other_word.size() - suffix.size();
+                            Word from_right(other_word.begin() + (end >= len ? end - len : 0), other_word.begin() + end);
+                            while (from_right.size() < len) {
+                                from_right.insert(from_right.begin(), random_symbol());
+                            }
+                            candidates.push_back(std::move(from_right));
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        // a word of the language of the variable
+        if (auts[v] != nullptr && membership_cost[v] > 0) {
+            std::optional<Word> word = AutAssignment::get_word(*auts[v], fixed_len[v]);
+            if (word.has_value()) {
+                candidates.push_back(std::move(*word));
+            }
+        }
+        // random edits
+        while (candidates.size() < NUM_CANDIDATES) {
+            Word cand = w;
+            const unsigned kind = fixed ? 0 : rand() % 3;
+            if (kind == 0 && !cand.empty()) {
+                cand[rand() % cand.size()] = random_symbol();
+            } else if (kind == 1 || (kind == 0 && !fixed)) {
+                cand.insert(cand.begin() + rand() % (cand.size() + 1), random_symbol());
+            } else if (!cand.empty()) {
+                cand.erase(cand.begin() + rand() % cand.size());
+            } else if (fixed) {
+                // nothing to change in the empty word of fixed length
+                break;
+            }
+            candidates.push_back(std::move(cand));
+        }
+    }
+
+    lbool SlsDecisionProcedure::compute_next_solution() {
+        if (failed) {
+            return l_undef;
+        }
+        if (found && !restart()) {
+            return l_undef;
+        }
+        // the previous solution was not accepted, look for another one
+        found = false;
+        unsigned best = total_cost, since_best = 0;
+        std::vector<size_t> violated_vars;
+        std::vector<Word> candidates;
+        while (total_cost > 0) {
+            if (num_flips >= max_flips || is_cancelled()) {
+                return l_undef;
+            }
+            ++num_flips;
+
+            // a random variable of a random violated constraint or membership
+            size_t num_violated = 0;
+            for (unsigned c : constraint_cost) {
+                num_violated += c > 0;
+            }
+            for (unsigned c : membership_cost) {
+                num_violated += c > 0;
+            }
+            size_t pick = rand() % num_violated;
+            violated_vars.clear();
+            for (size_t i = 0; i < constraints.size() && violated_vars.empty(); ++i) {
+                if (constraint_cost[i] > 0 && pick-- == 0) {
+                    for (const auto* side : { &constraints[i].left, &constraints[i].right }) {
+                        for (const Term& t : *side) {
+                            if (t.is_var) {
+                                violated_vars.push_back(t.idx);
+                            }
+                        }
+                    }
+                    if (violated_vars.empty()) {
+                        // a predicate of literals only, it cannot be satisfied
+                        failed = true;
+                        return l_undef;
+                    }
+                }
+            }
+            for (size_t v = 0; v < vars.size() && violated_vars.empty(); ++v) {
+                if (membership_cost[v] > 0 && pick-- == 0) {
+                    violated_vars.push_back(v);
+                }
+            }
+            SASSERT(!violated_vars.empty());
+            const size_t v = violated_vars[rand() % violated_vars.size()];
+
+            candidate_moves(v, candidates);
+            if (candidates.empty()) {
+                continue;
+            }
+            size_t chosen = 0;
+            if (rand() % 100 < NOISE) {
+                chosen = rand() % candidates.size();
+            } else {
+                Word old = words[v];
+                unsigned best_cost = UINT_MAX, num_best = 0;
+                for (size_t k = 0; k < candidates.size(); ++k) {
+                    words[v] = candidates[k];
+                    const unsigned cost = local_cost(v);
+                    // ties are broken uniformly
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        chosen = k;
+                        num_best = 1;
+                    } else if (cost == best_cost && rand() % ++num_best == 0) {
+                        chosen = k;
+                    }
+                }
+                words[v] = std::move(old);
+            }
+            set_word(v, std::move(candidates[chosen]));
+
+            if (total_cost < best) {
+                best = total_cost;
+                since_best = 0;
+            } else if (++since_best > RESTART_INTERVAL) {
+                if (!restart()) {
+                    return l_undef;
+                }
+                best = total_cost;
+                since_best = 0;
+            }
+        }
+        found = true;
+        return l_true;
+    }
+
+    std::pair<LenNode, LenNodePrecision> SlsDecisionProcedure::get_lengths() {
+        LenNode conj(LenFormulaType::AND);
+        for (size_t v = 0; v < vars.size(); ++v) {
+            if (length_sensitive[v]) {
+                conj.succ.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{ LenNode(vars[v]), LenNode(static_cast<int>(words[v].size())) });
+            }
+        }
+        if (conj.succ.empty()) {
+            return { LenNode(LenFormulaType::TRUE), LenNodePrecision::PRECISE };
+        }
+        return { conj, LenNodePrecision::PRECISE };
+    }
+
+    std::vector<std::pair<BasicTerm, SlsDecisionProcedure::Word>> SlsDecisionProcedure::get_words() const {
+        std::vector<std::pair<BasicTerm, Word>> result;
+        for (size_t v = 0; v < vars.size(); ++v) {
+            result.emplace_back(vars[v], words[v]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef _NOODLER_SLS_DECISION_PROCEDURE_H_
+#define _NOODLER_SLS_DECISION_PROCEDURE_H_
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "smt/params/theory_str_noodler_params.h"
+
+#include "formula.h"
+#include "aut_assignment.h"
+#include "decision_procedure.h"
+
+namespace smt::noodler {
+
+    /**
+     * @brief Stochastic local search for concrete words of the variables of word (dis)equations with regular memberships.
+     *
+     * The search starts from the shortest words of the languages of the variables and repeatedly picks a violated
+     * constraint and changes the word of one of its variables (substitution, insertion or deletion of a symbol,
+     * alignment with the other side of an equation, shortest word of its language), choosing the best of a few
+     * random candidate moves. The cost of an assignment is the sum of the edit distances of the sides of equations,
+     * the number of violated disequations and the distances of words to the languages of their variables (the number
+     * of symbols of the word not read by the automaton, plus one if the rest is not accepted).
+     *
+     * The lengths of the variables for which the arithmetic of the context has values are fixed to these values,
+     * so a solution never contradicts the current length assignment. The procedure is incomplete: it gives up
+     * (l_undef) after str.sls_max_flips moves, it never reports unsat.
+     */
+    class SlsDecisionProcedure : public AbstractDecisionProcedure {
+    public:
+        using Word = std::vector<mata::Symbol>;
+
+        /**
+         * @param form word (dis)equations, other predicates are not supported
+         * @param aut_ass languages of the variables (variables without an automaton are unrestricted)
+         * @param init_length_sensitive_vars variables whose lengths are given by get_lengths()
+         * @param fixed_lengths lengths of variables fixed by the arithmetic of the context
+         * @param symbols symbols from which the words are built
+         * @param seed seed of the random moves
+         */
+        SlsDecisionProcedure(const Formula& form, const AutAssignment& aut_ass,
+                             const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                             const std::map<BasicTerm, unsigned>& fixed_lengths, const std::set<mata::Symbol>& symbols,
+                             const theory_str_noodler_params& par, unsigned seed = 0);
+
+        lbool preprocess(PreprocessType opt = PreprocessType::PLAIN, const BasicTermEqiv &len_eq_vars = {}) override { return l_undef; }
+        void init_computation() override;
+        lbool compute_next_solution() override;
+        LenNode get_initial_lengths() override { return LenNode(LenFormulaType::TRUE); }
+        std::pair<LenNode, LenNodePrecision> get_lengths() override;
+
+        /**
+         * @brief The words of all variables of the solution found by compute_next_solution().
+         */
+        std::vector<std::pair<BasicTerm, Word>> get_words() const;
+
+        unsigned get_num_flips() const { return num_flips; }
+
+    private:
+        // a term of a side of a predicate: a variable (index into vars) or a literal (index into literals)
+        struct Term {
+            bool is_var;
+            size_t idx;
+        };
+        struct Constraint {
+            bool is_equation;
+            std::vector<Term> left, right;
+        };
+
+        std::vector<BasicTerm> vars;
+        std::unordered_map<BasicTerm, size_t> var_index;
+        std::vector<std::shared_ptr<mata::nfa::Nfa>> auts;      // nullptr for unrestricted variables
+        std::vector<std::optional<unsigned>> fixed_len;
+        std::vector<bool> length_sensitive;
+        std::vector<Word> literals;
+        std::vector<Constraint> constraints;
+        // constraints in which each variable occurs
+        std::vector<std::vector<size_t>> occurrences;
+        Word alphabet;
+        unsigned max_flips;
+        unsigned num_flips = 0;
+        bool failed = false;
+        // compute_next_solution() returned the current words
+        bool found = false;
+
+        std::vector<Word> words;
+        std::vector<unsigned> constraint_cost;
+        std::vector<unsigned> membership_cost;
+        unsigned total_cost = 0;
+        std::mt19937 rand;
+
+        size_t add_var(const BasicTerm& var);
+        Term mk_term(const BasicTerm& term);
+        Word get_side(const std::vector<Term>& side) const;
+        unsigned eval_constraint(size_t i) const;
+        unsigned eval_membership(size_t v) const;
+        // cost of the membership of variable v and of the constraints in which it occurs
+        unsigned local_cost(size_t v) const;
+        void set_word(size_t v, Word w);
+        void candidate_moves(size_t v, std::vector<Word>& candidates);
+        bool restart();
+
+        static unsigned edit_distance(const Word& a, const Word& b);
+        static unsigned aut_distance(const mata::nfa::Nfa& aut, const Word& w);
+    };
+}
+
+#endif
@@ -43,50 +43,76 @@ namespace smt::noodler {
         return true;
     } 
 
+    /**
+     * @brief Order-independent hash of a set of expressions (sum and xor of the ids of the expressions and its size).
+     */
+    inline size_t obj_hashtable_hash(const obj_hashtable<expr>& ht) {
+        size_t sum = 0, xr = 0;
+        for(expr* const e : ht) {
+            sum += e->get_id();
+            xr ^= std::hash<unsigned>{}(e->get_id());
+        }
+        return std::hash<size_t>{}(sum) ^ (xr << 1) ^ (static_cast<size_t>(ht.size()) << 32);
+    }
+
     /**
      * @brief Class representing the map Set(expr) -> T. Used for storing sets of processed 
      * conjunctions of string atoms. It can be used for storing the current state of computation 
      * for a given instance (set of string atoms). 
      * 
+     * The states are indexed by their hashes (obj_hashtable_hash), the sets are compared only
+     * if their hashes are equal.
+     * 
      * @tparam T Type of values for storing along with an instance
      */
     template<typename T>
     class StateLen {
     private:
         vector<std::pair<obj_hashtable<expr>, T>> state_visited;
+        // hash of a state -> indices of the states with this hash in state_visited
+        std::unordered_map<size_t, std::vector<unsigned>> state_index;
+
+        /**
+         * @brief Get the index of @p state in state_visited or -1 if it is not stored.
+         */
+        int find(const obj_hashtable<expr>& state) const {
+            auto it = this->state_index.find(obj_hashtable_hash(state));
+            if(it == this->state_index.end()) {
+                return -1;
+            }
+            for(unsigned i : it->second) {
+                if(obj_hashtable_equal(this->state_visited[i].first, state))
+                    return i;
+            }
+            return -1;
+        }
 
     public:
-        StateLen() : state_visited() { }
+        StateLen() : state_visited(), state_index() { }
 
-        bool contains(const obj_hashtable<expr>& state) {
-            for(const auto& st : this->state_visited) {
-                if(obj_hashtable_equal(st.first, state))
-                    return true;
-            }            
-            return false;
+        bool contains(const obj_hashtable<expr>& state) const {
+            return find(state) != -1;
         }
 
         void add(const obj_hashtable<expr>& state, const T& def) {
             if(!contains(state)){
+                this->state_index[obj_hashtable_hash(state)].push_back(this->state_visited.size());
                 this->state_visited.push_back({state, def});
             }
         }
 
         const T& get_val(const Instance& inst) const {
-            for(const auto& st : this->state_visited) {
-                if(obj_hashtable_equal(st.first, inst))
-                    return st.second;
-            }            
+            int i = find(inst);
+            if(i != -1)
+                return this->state_visited[i].second;
             UNREACHABLE();
         }
 
         void update_val(const Instance& inst, const T& val) {
-            for(auto& st : this->state_visited) {
-                if(obj_hashtable_equal(st.first, inst)) {
-                    st.second = val;   
-                    return;
-                }
-            } 
+            int i = find(inst);
+            if(i != -1) {
+                this->state_visited[i].second = val;
+            }
         }
     };
 }
@@ -9,6 +9,7 @@ Eternal glory to Yu-Fang.
 #include <cmath>
 
 #include "ast/ast_pp.h"
+#include "ast/for_each_expr.h"
 #include "smt/smt_context.h"
 #include "smt/smt_model_generator.h"
 #include "smt/theory_lra.h"
@@ -19,6 +20,7 @@ Eternal glory to Yu-Fang.
 
 #include "decision_procedure.h"
 #include "theory_str_noodler.h"
+#include "profile_markers.h"
 
 namespace smt::noodler {
 
@@ -29,14 +31,120 @@ namespace smt::noodler {
         m_util_a(m),
         m_util_s(m),
         var_eqs(m_util_a),
+        m_literal_cache(m),
         m_length(m),
-        axiomatized_instances()  {
+        axiomatized_instances(),
+        m_len_session(m),
+        m_own_session(params.m_session_caches ? nullptr : std::make_unique<NoodlerSession>()),
+        m_session(params.m_session_caches ? NoodlerSession::get(m) : *m_own_session),
+        m_nfa_cache(m_session.nfa_cache),
+        m_membership_cache(m_session.membership_cache),
+        m_regex_info_cache(m_session.regex_info_cache),
+        m_aut_pool(m_session.aut_pool),
+        m_preprocess_memo(m_session.preprocess_memo),
+        m_literal_store(m_session.literal_store),
+        m_len_abstraction_cache(m_session.len_abstraction_cache),
+        m_model_values(m)  {
+        m_nfa_cache.set_memory_limit(static_cast<size_t>(m_params.m_nfa_cache_memory) << 20);
+        m_session.governor.set_budget(static_cast<size_t>(m_params.m_cache_memory) << 20);
+        if (m_params.m_event_log_capacity > 0) {
+            m_event_log = std::make_unique<EventLog>(m_params.m_event_log_capacity);
+        }
+        if (!m_params.m_nfa_cache_file.empty()) {
+            std::shared_ptr<const NfaStore> store;
+            try {
+                store = NfaStore::open(m_params.m_nfa_cache_file);
+            } catch (const default_exception& ex) {
+                // an invalid file is replaced by the automata computed in this run
+                STRACE("str", tout << ex.msg() << std::endl;);
+            }
+            m_nfa_cache.set_store(std::move(store), true);
+        }
+    }
+
+    theory_str_noodler::~theory_str_noodler() {
+        if (m_event_log && !m_params.m_event_log_file.empty() && !m_event_log->dump_chrome_trace(m_params.m_event_log_file)) {
+            STRACE("str", tout << "event log could not be written to " << m_params.m_event_log_file << std::endl;);
+        }
+        if (!m_params.m_nfa_cache_file.empty() && !m_nfa_cache.save_store(m_params.m_nfa_cache_file)) {
+            STRACE("str", tout << "automata store could not be written to " << m_params.m_nfa_cache_file << std::endl;);
+        }
     }
 
     void theory_str_noodler::display(std::ostream &os) const {
         os << "theory_str display" << std::endl;
     }
 
+    void theory_str_noodler::collect_statistics(::statistics & st) const {
+        st.update("str final checks", m_stats.m_num_final_checks);
+        st.update("str final check time", m_final_check_watch.get_seconds());
+        st.update("str solved by loop protection", m_stats.m_solved_loop_protection);
+        st.update("str solved by repeated final check", m_stats.m_solved_repeated_final_check);
+        st.update("str solved by membership heur", m_stats.m_solved_membership_heur);
+        st.update("str solved by mult membership heur", m_stats.m_solved_mult_membership_heur);
+        st.update("str solved by length sat", m_stats.m_solved_length_sat);
+        st.update("str solved by nielsen", m_stats.m_solved_nielsen);
+        st.update("str solved by length proc", m_stats.m_solved_length_proc);
+        st.update("str solved by underapprox", m_stats.m_solved_underapprox);
+        st.update("str solved by sls", m_stats.m_solved_sls);
+        st.update("str solved by bounded", m_stats.m_solved_bounded);
+        st.update("str solved by components", m_stats.m_solved_components);
+        st.update("str components solved", m_stats.m_num_components_solved);
+        st.update("str preprocess time", m_preprocess_watch.get_seconds());
+        st.update("str noodlifications", m_stats.m_num_noodlifications);
+        st.update("str noodles", m_stats.m_num_noodles);
+        st.update("str solving states", m_stats.m_num_solving_states);
+        st.update("str inclusion checks", m_stats.m_num_inclusion_checks);
+        st.update("str inclusion cache hits", m_stats.m_num_inclusion_cache_hits);
+        st.update("str preprocess passes skipped", m_stats.m_num_preprocess_passes_skipped);
+        st.update("str preprocess memo hits", m_stats.m_num_preprocess_memo_hits);
+        st.update("str length abstraction hits", m_len_abstraction_cache.get_hits());
+        st.update("str literal membership hits", m_membership_cache.get_hits());
+        st.update("str regex info hits", m_regex_info_cache.get_hits());
+        st.update("str cache max kb", static_cast<unsigned>(m_session.governor.get_max_bytes() >> 10));
+        st.update("str cache evictions", m_session.governor.get_num_evictions());
+        for (const CacheGovernor::Cache& cache : m_session.governor.get_caches()) {
+            if (cache.num_evictions > 0) {
+                st.update(cache.stat_name, cache.num_evictions);
+            }
+        }
+        st.update("str preprocess ops gated", m_stats.m_num_preprocess_ops_gated);
+        st.update("str max aut states", m_stats.m_max_aut_states);
+        st.update("str max worklist kb", m_stats.m_max_worklist_kb);
+        st.update("str evicted states", m_stats.m_num_evicted_states);
+        st.update("str witness inclusions", m_stats.m_num_witness_inclusions);
+        st.update("str shared segments", m_stats.m_num_shared_segments);
+        st.update("str concatenation memo hits", m_stats.m_num_concatenation_memo_hits);
+        st.update("str nogoods", m_stats.m_num_nogoods);
+        st.update("str nogood pruned states", m_stats.m_num_nogood_pruned_states);
+        st.update("str length pruned states", m_stats.m_num_length_pruned_states);
+        st.update("str model deferred states", m_stats.m_num_model_deferred_states);
+        st.update("str check len sat", m_stats.m_num_check_len_sat);
+        st.update("str len presolve unsat", m_stats.m_num_len_presolve_unsat);
+        st.update("str len block weakened", m_stats.m_num_len_block_weakened);
+        st.update("str len block dropped", m_stats.m_num_len_block_dropped);
+        st.update("str budget exceeded", m_stats.m_num_budget_exceeded);
+        st.update("str underapprox rounds", m_stats.m_num_underapprox_rounds);
+        st.update("str lazy axiomatized terms", m_stats.m_num_lazy_axiomatized);
+        st.update("str search conflicts", m_stats.m_num_search_conflicts);
+        st.update("str core shrink removed", m_stats.m_num_core_shrink_removed);
+        st.update("str length bound axioms", m_stats.m_num_length_bound_axioms);
+        st.update("str nfa store hits", m_nfa_cache.get_store_hits());
+        st.update("str lang eq cache hits", m_nfa_cache.get_equivalence_hits());
+        st.update("str nfa cache kb", static_cast<unsigned>(m_nfa_cache.get_cached_bytes() >> 10));
+        st.update("str nfa cache evicted", m_nfa_cache.get_num_evicted());
+        st.update("str check len sat time", m_check_len_sat_watch.get_seconds());
+        // keys of the per-pass statistics are owned by m_prep_profile (its entries are never removed)
+        for (const std::string& name : m_prep_profile.order) {
+            const PreprocessProfile::PassProfile& pass = m_prep_profile.passes.at(name);
+            st.update(pass.runs_key.c_str(), pass.runs);
+            st.update(pass.time_key.c_str(), pass.time);
+            st.update(pass.predicates_key.c_str(), pass.predicates_delta);
+            st.update(pass.states_key.c_str(), pass.states_delta);
+        }
+        IF_VERBOSE(2, if (!m_prep_profile.order.empty()) verbose_stream() << "(str.preprocess-profile " << m_prep_profile.summary() << ")" << std::endl;);
+    }
+
     void theory_str_noodler::init() {
         theory::init();
         STRACE("str", tout << "init" << std::endl;);
@@ -146,7 +254,7 @@ namespace smt::noodler {
 
     }
 
-    void theory_str_noodler::string_theory_propagation(expr *expr, bool init, bool neg, bool var_lengths) {
+    void theory_str_noodler::string_theory_propagation(expr *expr, bool init, bool neg, bool var_lengths, bool inner_concat) {
         STRACE("str", tout << __LINE__ << " enter " << __FUNCTION__ << std::endl;);
         STRACE("str", tout << mk_pp(expr, get_manager()) << std::endl;);
 
@@ -169,6 +277,13 @@ namespace smt::noodler {
             ctx.mark_as_relevant(m.mk_not(expr));
         }
 
+        // the length of a nested concatenation is covered by the length axiom of the outermost one, it needs its own
+        // axiom only if it also occurs outside of concatenations
+        const bool is_concat = is_app(expr) && m_util_s.str.is_concat(to_app(expr));
+        if (is_concat && !inner_concat) {
+            propagate_concat_axiom(ctx.get_enode(expr));
+        }
+
         // Check if we already axiomatized the expr
         if (propagated_string_theory.contains(expr)) {
             return;
@@ -181,16 +296,13 @@ namespace smt::noodler {
         if (expr_sort == str_sort) {
             enode *n = ctx.get_enode(expr);
             propagate_basic_string_axioms(n, var_lengths);
-            if (is_app(expr) && m_util_s.str.is_concat(to_app(expr))) {
-                propagate_concat_axiom(n);
-            }
         }
         // if expr is an application, recursively inspect all arguments
         if (is_app(expr) && !m_util_s.str.is_length(expr)) {
             app *term = to_app(expr);
             unsigned num_args = term->get_num_args();
             for (unsigned i = 0; i < num_args; i++) {
-                string_theory_propagation(term->get_arg(i), init, neg, var_lengths);
+                string_theory_propagation(term->get_arg(i), init, neg, var_lengths, is_concat);
             }
         }
 
@@ -198,7 +310,8 @@ namespace smt::noodler {
 
     }
 
-    // for concatenation xy create axiom |xy| = |x| + |y| where x, y are some string expressions
+    // for concatenation x_1...x_n create axiom |x_1...x_n| = |x_1| + ... + |x_n| where x_i are some string expressions
+    // that are not concatenations
     void theory_str_noodler::propagate_concat_axiom(enode *cat) {
         STRACE("str", tout << __LINE__ << " enter " << __FUNCTION__ << std::endl;);
 
@@ -207,31 +320,38 @@ namespace smt::noodler {
         SASSERT(m_util_s.str.is_concat(a_cat));
         ast_manager &m = get_manager();
 
+        if (concat_length_axiomatized.contains(a_cat)) {
+            return;
+        }
+        concat_length_axiomatized.insert(a_cat);
+
         // build LHS
         expr_ref len_xy(m);
         len_xy = m_util_s.str.mk_length(a_cat);
         SASSERT(len_xy);
 
-        // build RHS: start by extracting x and y from Concat(x, y)
-        SASSERT(a_cat->get_num_args() == 2);
-        app *a_x = to_app(a_cat->get_arg(0));
-        app *a_y = to_app(a_cat->get_arg(1));
-        expr_ref len_x(m);
-        len_x = m_util_s.str.mk_length(a_x);
-        SASSERT(len_x);
-
-        expr_ref len_y(m);
-        len_y = m_util_s.str.mk_length(a_y);
-        SASSERT(len_y);
-
-        // now build len_x + len_y
+        // build RHS: the lengths of the arguments of the nested concatenations (from left to right)
+        expr_ref_vector len_args(m);
+        ptr_vector<expr> todo;
+        todo.push_back(a_cat);
+        while (!todo.empty()) {
+            expr* e = todo.back();
+            todo.pop_back();
+            if (m_util_s.str.is_concat(e)) {
+                app* a_e = to_app(e);
+                for (unsigned i = a_e->get_num_args(); i-- > 0; ) {
+                    todo.push_back(a_e->get_arg(i));
+                }
+            } else {
+                len_args.push_back(m_util_s.str.mk_length(e));
+            }
+        }
         expr_ref len_x_plus_len_y(m);
-        len_x_plus_len_y = m_util_a.mk_add(len_x, len_y);
+        len_x_plus_len_y = m_util_a.mk_add(len_args.size(), len_args.data());
         SASSERT(len_x_plus_len_y);
 
         STRACE("str-concat",
-            tout << "[Concat Axiom] " << mk_pp(len_xy, m) << " = " << mk_pp(len_x, m) << " + " << mk_pp(len_y, m)
-                 << std::endl;
+            tout << "[Concat Axiom] " << mk_pp(len_xy, m) << " = " << mk_pp(len_x_plus_len_y, m) << std::endl;
         );
 
         // finally assert equality between the two subexpressions
@@ -239,6 +359,7 @@ namespace smt::noodler {
         //ctx.internalize(eq, false);
         SASSERT(eq);
         add_axiom(eq);
+        set_branching_priority(mk_literal(eq), BRANCHING_PRIORITY_HIGH);
         // std::cout << mk_pp(eq, m) << std::endl;
         this->axiomatized_len_axioms.push_back(eq);
         STRACE("str", tout << __LINE__ << " leave " << __FUNCTION__ << std::endl;);
@@ -376,27 +497,23 @@ namespace smt::noodler {
             if (m_util_s.str.is_length(n, arg) && !has_length(arg) && get_context().e_internalized(arg)) {
                 enforce_length(arg);
             }
+            // the length of a concatenation occurring only inside other concatenations has no axiom yet
+            if (m_util_s.str.is_length(n, arg) && m_util_s.str.is_concat(arg) && get_context().e_internalized(arg)) {
+                propagate_concat_axiom(get_context().get_enode(arg));
+            }
         } else if(m_util_s.str.is_lt(n)) { // str.<
             handle_lex_lt(n);
         } else if(m_util_s.str.is_le(n)) { // str.<=
             handle_lex_leq(n);
-        } else if (m_util_s.str.is_at(n)) { // str.at
-            handle_char_at(n);
-        } else if (m_util_s.str.is_extract(n)) { // str.substr
-            handle_substr(n);
-        } else if(m_util_s.str.is_prefix(n)) { // str.prefixof
-            handle_prefix(n);
-            handle_not_prefix(n);
-        } else if(m_util_s.str.is_suffix(n)) { // str.suffixof
-            handle_suffix(n);
-            handle_not_suffix(n);
+        } else if (is_lazily_axiomatized(n)) { // str.at, str.substr, str.prefixof, str.suffixof, str.indexof, str.replace
+            if (m_params.m_lazy_axioms) {
+                m_lazy_axiom_todo.push_back(expr_ref(n, m));
+            } else {
+                axiomatize_term(n);
+            }
         } else if(m_util_s.str.is_contains(n)) { // str.contains
             handle_contains(n);
             handle_not_contains(n);
-        } else if (m_util_s.str.is_index(n)) { // str.indexof
-            handle_index_of(n);
-        } else if (m_util_s.str.is_replace(n)) { // str.replace
-            handle_replace(n);
         } else if(m_util_s.str.is_replace_all(n)) { // str.replace_all
             util::throw_error("str.replace_all is not supported");
         } else if(m_util_s.str.is_replace_re(n)) { // str.replace_re
@@ -412,6 +529,13 @@ namespace smt::noodler {
             m_util_s.str.is_from_code(n) // str.from_code
         ) {
             handle_conversion(n);
+        } else if (m_util_s.str.is_in_re(n)) { // str.in_re
+            // memberships are handled during final_check_eh, the small ones are decided first
+            expr *s = nullptr, *re = nullptr;
+            VERIFY(m_util_s.str.is_in_re(n, s, re));
+            if (ctx.b_internalized(n) && get_num_exprs(re) <= BRANCHING_SMALL_REGEX) {
+                set_branching_priority(literal(ctx.get_bool_var(n)), BRANCHING_PRIORITY_HIGH);
+            }
         } else if (
             m_util_s.str.is_concat(n) || // str.++
             m_util_s.re.is_to_re(n) || // str.to_re
@@ -431,6 +555,52 @@ namespace smt::noodler {
 
     }
 
+    void theory_str_noodler::relevant_batch_eh(unsigned num, app * const * ns) {
+        STRACE("str", tout << "relevant batch of " << num << " terms" << std::endl;);
+        for (unsigned i = 0; i < num; ++i) {
+            app* n = ns[i];
+            // the most frequent relevant terms need no handling, skip them before the dispatch in relevant_eh
+            if (m_util_s.str.is_concat(n) || m_util_s.str.is_string(n) || util::is_str_variable(n, m_util_s)) {
+                continue;
+            }
+            relevant_eh(n);
+        }
+    }
+
+    void theory_str_noodler::axiomatize_term(app *n) {
+        if (m_util_s.str.is_at(n)) { // str.at
+            handle_char_at(n);
+        } else if (m_util_s.str.is_extract(n)) { // str.substr
+            handle_substr(n);
+        } else if(m_util_s.str.is_prefix(n)) { // str.prefixof
+            handle_prefix(n);
+            handle_not_prefix(n);
+        } else if(m_util_s.str.is_suffix(n)) { // str.suffixof
+            handle_suffix(n);
+            handle_not_suffix(n);
+        } else if (m_util_s.str.is_index(n)) { // str.indexof
+            handle_index_of(n);
+        } else if (m_util_s.str.is_replace(n)) { // str.replace
+            handle_replace(n);
+        } else {
+            UNREACHABLE();
+        }
+    }
+
+    bool theory_str_noodler::axiomatize_lazy_terms() {
+        // the handlers add the terms (or their negations) to axiomatized_persist_terms, so the size tells us
+        // whether some new axioms were added
+        const unsigned axiomatized_before = axiomatized_persist_terms.size();
+        for (const expr_ref& term : m_lazy_axiom_todo) {
+            if (ctx.is_relevant(term)) {
+                axiomatize_term(to_app(term));
+            }
+        }
+        const unsigned newly_axiomatized = axiomatized_persist_terms.size() - axiomatized_before;
+        m_stats.m_num_lazy_axiomatized += newly_axiomatized;
+        return newly_axiomatized > 0;
+    }
+
     /*
     ensure that all elements in equivalence class occur under an application of 'length'
     */
@@ -582,14 +752,144 @@ namespace smt::noodler {
     }
 
     bool theory_str_noodler::can_propagate() {
-        return false;
+        return m_params.m_search_propagation && m_membership_prop_head < m_membership_todo.size();
     }
 
     void theory_str_noodler::propagate() {
-        // STRACE("str", out << "o propagate" << '\n';);
+        if (!m_params.m_search_propagation) {
+            return;
+        }
+        // the added clauses can assign new memberships, they are checked in the same loop
+        while (m_membership_prop_head < m_membership_todo.size()) {
+            const expr_pair_flag membership = m_membership_todo[m_membership_prop_head++];
+            propagate_membership(membership);
+        }
+    }
+
+    void theory_str_noodler::propagate_membership(const expr_pair_flag& membership) {
+        // maximal number of memberships of one variable and states of their automata checked during the search
+        const unsigned MAX_MEMBERSHIPS = 16;
+        const unsigned MAX_STATES = regex::RED_BOUND;
+
+        const expr_ref& var = std::get<0>(membership);
+        const expr_ref& re = std::get<1>(membership);
+        if (!util::is_str_variable(var, m_util_s)) {
+            return;
+        }
+        literal memb_lit = mk_literal(m_util_s.re.mk_in_re(var, re));
+
+        if (std::get<2>(membership)) {
+            regex::RegexInfo info = m_regex_info_cache.get(to_app(re), m_util_s, m);
+            if (info.empty == l_true) {
+                ++m_stats.m_num_search_conflicts;
+                add_axiom({~memb_lit});
+                return;
+            }
+            // the length term is added only for length-sensitive variables, otherwise it would make the variable length-sensitive
+            if (info.empty == l_false && info.min_length > 0 && len_vars.contains(var)) {
+                add_axiom({~memb_lit, mk_literal(m_util_a.mk_ge(m_util_s.str.mk_length(var), m_util_a.mk_int(info.min_length)))});
+            }
+            if (info.empty == l_false && info.universal != l_true && len_vars.contains(var)) {
+                propagate_membership_lengths(var, to_app(re), memb_lit);
+            }
+        }
+
+        // memberships of the same variable that are assigned so far (tuples of complement flag, regex and the literal)
+        std::vector<std::tuple<bool,app*,unsigned>> list_of_regexes;
+        std::vector<literal> literals;
+        std::set<mata::Symbol> symbols{ get_dummy_symbol() };
+        // the emptiness of the intersection is preserved by the classes of symbols of ranges
+        std::vector<std::pair<uint32_t,uint32_t>> ranges;
+        for (unsigned i = 0; i < m_membership_prop_head; ++i) {
+            const auto& [other_var, other_re, other_is_true] = m_membership_todo[i];
+            if (other_var.get() != var.get()) {
+                continue;
+            }
+            literal other_lit = mk_literal(m_util_s.re.mk_in_re(other_var, other_re));
+            if (ctx.get_assignment(other_lit) != (other_is_true ? l_true : l_false)) {
+                continue;
+            }
+            if (list_of_regexes.size() == MAX_MEMBERSHIPS) {
+                return;
+            }
+            list_of_regexes.emplace_back(!other_is_true, to_app(other_re), literals.size());
+            literals.push_back(other_is_true ? ~other_lit : other_lit);
+            extract_regex_symbols(other_re, symbols, ranges);
+        }
+        if (list_of_regexes.size() < 2) {
+            return;
+        }
+        add_range_class_representatives(symbols, ranges);
 
-        // for(const expr_ref& ex : this->len_state_axioms)
-        //     add_axiom(ex);
+        regex::Alphabet alph(symbols);
+        std::vector<std::shared_ptr<const mata::nfa::Nfa>> nfas;
+        try {
+            for (const auto& [is_complement, reg, lit_index] : list_of_regexes) {
+                nfas.push_back(m_nfa_cache.get_nfa(reg, m_util_s, m, alph, false, false));
+                if (nfas.back()->num_of_states() > MAX_STATES) {
+                    return;
+                }
+            }
+        } catch (const default_exception&) {
+            // unsupported regexes are reported in the final check
+            return;
+        }
+        std::vector<unsigned> empty_intersection = get_empty_membership_intersection(list_of_regexes, nfas, alph);
+        if (empty_intersection.empty()) {
+            return;
+        }
+        STRACE("str", tout << "conflict of memberships of " << mk_pp(var, m) << " found during the search" << std::endl;);
+        ++m_stats.m_num_search_conflicts;
+        std::vector<literal> conflict;
+        for (unsigned i : empty_intersection) {
+            conflict.push_back(literals[std::get<2>(list_of_regexes[i])]);
+        }
+        add_axiom(conflict);
+    }
+
+    void theory_str_noodler::propagate_membership_lengths(const expr_ref& var, app* re, literal memb_lit) {
+        // maximal number of states of the automaton and of the disjuncts (c1 + k*c2) of its lengths
+        const unsigned MAX_STATES = regex::RED_BOUND;
+        const unsigned MAX_DISJUNCTS = 8;
+
+        std::set<mata::Symbol> symbols{ get_dummy_symbol() };
+        // the lengths of words are preserved by the classes of symbols of ranges
+        std::vector<std::pair<uint32_t,uint32_t>> ranges;
+        extract_regex_symbols(re, symbols, ranges);
+        add_range_class_representatives(symbols, ranges);
+        regex::Alphabet alph(symbols);
+        std::set<std::pair<int, int>> lengths;
+        try {
+            std::shared_ptr<const mata::nfa::Nfa> nfa = m_nfa_cache.get_nfa(re, m_util_s, m, alph, false, false);
+            if (nfa->num_of_states() > MAX_STATES) {
+                return;
+            }
+            lengths = mata::strings::get_word_lengths(*nfa);
+        } catch (const default_exception&) {
+            // unsupported regexes are reported in the final check
+            return;
+        }
+        // lengths (c, 1) are only the lower bound, which was already added from the regex info
+        if (lengths.empty() || lengths.size() > MAX_DISJUNCTS || (lengths.size() == 1 && lengths.begin()->second == 1)) {
+            return;
+        }
+
+        expr_ref len(m_util_s.str.mk_length(var), m);
+        expr_ref_vector disjuncts(m);
+        for (const auto& [c1, c2] : lengths) {
+            if (c2 == 0) {
+                disjuncts.push_back(m.mk_eq(len, m_util_a.mk_int(c1)));
+            } else if (c2 == 1) {
+                disjuncts.push_back(m_util_a.mk_ge(len, m_util_a.mk_int(c1)));
+            } else {
+                // len = c1 + k*c2 for some k >= 0
+                disjuncts.push_back(m.mk_and(m_util_a.mk_ge(len, m_util_a.mk_int(c1)),
+                                             m.mk_eq(m_util_a.mk_mod(m_util_a.mk_sub(len, m_util_a.mk_int(c1)), m_util_a.mk_int(c2)), m_util_a.mk_int(0))));
+            }
+        }
+        STRACE("str", tout << "lengths of " << mk_pp(var, m) << " from " << mk_pp(re, m) << ": " << mk_pp(m.mk_or(disjuncts), m) << std::endl;);
+        ++m_stats.m_num_length_bound_axioms;
+        add_axiom({~memb_lit, mk_literal(m.mk_or(disjuncts))});
     }
 
     void theory_str_noodler::push_scope_eh() {
@@ -601,13 +901,21 @@ namespace smt::noodler {
         m_membership_todo.push_scope();
         m_not_contains_todo.push_scope();
         m_conversion_todo.push_scope();
+        m_lazy_axiom_todo.push_scope();
+        axiomatized_terms.push_scope();
+        propagated_string_theory.push_scope();
+        concat_length_axiomatized.push_scope();
+        m_literal_cache.push_scope();
+        var_eqs.push_scope();
         STRACE("str", tout << "push_scope: " << m_scope_level << '\n';);
     }
 
     void theory_str_noodler::pop_scope_eh(const unsigned num_scopes) {
-        // remove all axiomatized terms
-        axiomatized_terms.reset();
-        propagated_string_theory.reset();
+        // remove the terms axiomatized in the popped scopes (the axioms from the remaining scopes are still in the context)
+        axiomatized_terms.pop_scope(num_scopes);
+        propagated_string_theory.pop_scope(num_scopes);
+        concat_length_axiomatized.pop_scope(num_scopes);
+        m_literal_cache.pop_scope(num_scopes);
         m_scope_level -= num_scopes;
         m_word_eq_todo.pop_scope(num_scopes);
         m_lang_eq_todo.pop_scope(num_scopes);
@@ -616,7 +924,14 @@ namespace smt::noodler {
         m_membership_todo.pop_scope(num_scopes);
         m_not_contains_todo.pop_scope(num_scopes);
         m_conversion_todo.pop_scope(num_scopes);
-        m_rewrite.reset();
+        m_lazy_axiom_todo.pop_scope(num_scopes);
+        m_membership_prop_head = std::min(m_membership_prop_head, m_membership_todo.size());
+        var_eqs.pop_scope(num_scopes);
+        // rewriting does not depend on the scope (terms are hash-consed and the cache keeps them alive),
+        // the cache is only cleared to bound its memory
+        if (m_rewrite.get_cache_size() > m_params.m_rewrite_cache_size) {
+            m_rewrite.reset();
+        }
         STRACE("str",
             tout << "pop_scope: " << num_scopes << " (back to level " << m_scope_level << ")\n";);
     }
@@ -624,9 +939,26 @@ namespace smt::noodler {
     void theory_str_noodler::reset_eh() {
         // FIXME should here be something?
         STRACE("str", tout << "reset" << '\n';);
+        m_len_session.reset();
+        // the shared caches stay valid (they are keyed by hash-consed terms), they are kept for other instances
+        if (m_own_session) {
+            m_session.reset();
+        }
+        m_axiom_fresh_vars.clear();
+        axiomatized_terms.reset();
+        propagated_string_theory.reset();
+        concat_length_axiomatized.reset();
+        m_literal_cache.reset();
+        m_pred_conv_index.reset();
+        m_pred_convs.clear();
+        m_last_dec_proc = nullptr;
+        m_model_solution = nullptr;
+        m_curr_fingerprint = nullptr;
+        m_last_done_fingerprint = nullptr;
     }
 
     void theory_str_noodler::remove_irrelevant_constr() {
+        NOODLER_PHASE("relevance");
         STRACE("str", tout << "Remove irrevelant" << std::endl);
 
         this->m_word_eq_todo_rel.clear();
@@ -635,6 +967,14 @@ namespace smt::noodler {
         this->m_lang_eq_or_diseq_todo_rel.clear();
         this->m_not_contains_todo_rel.clear();
 
+        // constraints that were already saved as relevant, (dis)equations are stored with the side with smaller id
+        // first, so that an equation and its reverse are the same; memberships are stored separately for each flag
+        obj_pair_hashtable<expr, expr> rel_word_eqs, rel_word_diseqs, rel_not_contains;
+        obj_pair_hashtable<expr, expr> rel_membs[2];
+        auto unordered_pair = [](expr* l, expr* r) {
+            return l->get_id() <= r->get_id() ? std::make_pair(l, r) : std::make_pair(r, l);
+        };
+
         for (const auto& we : m_word_eq_todo) {
             app_ref eq(m.mk_eq(we.first, we.second), m);
             app_ref eq_rev(m.mk_eq(we.second, we.first), m);
@@ -648,9 +988,10 @@ namespace smt::noodler {
             // check if equation or its reverse are relevant (we check reverse to be safe) and...
             if((ctx.is_relevant(eq.get()) || ctx.is_relevant(eq_rev.get())) &&
                // ...neither equation nor its reverse are saved as relevant yet
-               !this->m_word_eq_todo_rel.contains(we) && !this->m_word_eq_todo_rel.contains({we.second, we.first})
+               !rel_word_eqs.contains(unordered_pair(we.first, we.second))
                ) {
                 // save it as relevant
+                rel_word_eqs.insert(unordered_pair(we.first, we.second));
                 this->m_word_eq_todo_rel.push_back(we);
             }
         }
@@ -668,9 +1009,10 @@ namespace smt::noodler {
             // check if disequation or its reverse are relevant (we check reverse to be safe) and...
             if((ctx.is_relevant(dis.get()) || ctx.is_relevant(dis_rev.get())) &&
                // ...neither disequation nor its reverse are saved as relevant yet
-               !this->m_word_diseq_todo_rel.contains(wd) && !this->m_word_diseq_todo_rel.contains({wd.second, wd.first})
+               !rel_word_diseqs.contains(unordered_pair(wd.first, wd.second))
                ) {
                 // save it as relevant
+                rel_word_diseqs.insert(unordered_pair(wd.first, wd.second));
                 this->m_word_diseq_todo_rel.push_back(wd);
             }
         }
@@ -693,8 +1035,9 @@ namespace smt::noodler {
             // check if membership (or if we have negation, its negated form) is relevant and...
             if((ctx.is_relevant(memb_app.get()) || ctx.is_relevant(memb_app_orig.get())) &&
                // this membership constraint is not added to relevant yet
-               !this->m_membership_todo_rel.contains(memb)
+               !rel_membs[std::get<2>(memb)].contains(std::make_pair(std::get<0>(memb).get(), std::get<1>(memb).get()))
                ) {
+                rel_membs[std::get<2>(memb)].insert(std::make_pair(std::get<0>(memb).get(), std::get<1>(memb).get()));
                 this->m_membership_todo_rel.push_back(memb);
             }
         }
@@ -712,7 +1055,8 @@ namespace smt::noodler {
             );
 
             if((ctx.is_relevant(con_expr.get()) || ctx.is_relevant(not_con_expr.get())) && 
-                !this->m_not_contains_todo_rel.contains(not_con_pair)) {
+                !rel_not_contains.contains(std::make_pair(not_con_pair.first.get(), not_con_pair.second.get()))) {
+                rel_not_contains.insert(std::make_pair(not_con_pair.first.get(), not_con_pair.second.get()));
                 this->m_not_contains_todo_rel.push_back(not_con_pair);
             }
         }
@@ -743,10 +1087,43 @@ namespace smt::noodler {
      *          it finishes wihtout result
      */
     final_check_status theory_str_noodler::final_check_eh() {
+        record_event(EventType::FINAL_CHECK_BEGIN, m_stats.m_num_final_checks + 1);
+        final_check_status status = final_check_main();
+        record_event(EventType::FINAL_CHECK_END, m_stats.m_num_final_checks, status);
+        // the caches are not used between final checks, so they can be evicted here
+        m_session.governor.enforce();
+        return status;
+    }
+
+    final_check_status theory_str_noodler::final_check_main() {
         TRACE("str", tout << "final_check starts" << std::endl;);
+        ++m_stats.m_num_final_checks;
+        scoped_watch final_check_sw(m_final_check_watch);
+        // the solution of the previous final check is not a model anymore (unless the final check is repeated)
+        std::unique_ptr<model_solution> last_model_solution = std::move(m_model_solution);
+        m_sls_words.reset();
+        m_curr_fingerprint = nullptr;
+
+        if (m_params.m_lazy_axioms && axiomatize_lazy_terms()) {
+            // the new axioms have to be propagated first
+            m_last_done_fingerprint = nullptr;
+            return FC_CONTINUE;
+        }
 
         remove_irrelevant_constr();
 
+        // if the relevant constraints did not change since the last final check that returned FC_DONE, it is enough
+        // to check that its length formula still holds
+        if (m_params.m_loop_protect) {
+            m_curr_fingerprint = get_relevant_fingerprint();
+            if (run_repeated_final_check() == l_true) {
+                ++m_stats.m_solved_repeated_final_check;
+                m_model_solution = std::move(last_model_solution);
+                return FC_DONE;
+            }
+        }
+        m_last_done_fingerprint = nullptr;
+
         STRACE("str",
             tout << "Relevant predicates:" << std::endl;
             tout << "  eqs(" << this->m_word_eq_todo_rel.size() << "):" << std::endl;
@@ -788,6 +1165,9 @@ namespace smt::noodler {
         // we get the same formula up to alpha reduction).
         if(m_params.m_loop_protect) {
             lbool result = run_loop_protection();
+            if (result != l_undef) {
+                ++m_stats.m_solved_loop_protection;
+            }
             if(result == l_true) {
                 return FC_DONE;
             } else if (result == l_false) {
@@ -799,14 +1179,14 @@ namespace smt::noodler {
         bool contains_word_disequations = !this->m_word_diseq_todo_rel.empty();
         bool contains_conversions = !this->m_conversion_todo.empty();
 
-        // Change name
-        bool contains_equations_only = this->m_lang_eq_or_diseq_todo_rel.empty() && this->m_not_contains_todo_rel.empty() && this->m_conversion_todo.empty();
-
         // As a heuristic, for the case we have exactly one constraint, which is of type 'x notin RE', we use universality
         // checking instead of constructing the automaton for complement of RE. The complement can sometimes blow up, so
         // universality checking should be faster.
         if(this->m_membership_todo_rel.size() == 1 && !contains_word_equations && !contains_word_disequations && !contains_conversions && this->m_not_contains_todo_rel.size() == 0) {
             lbool result = run_membership_heur();
+            if (result != l_undef) {
+                ++m_stats.m_solved_membership_heur;
+            }
             if(result == l_true) {
                 return FC_DONE;
             } else if(result == l_false) {
@@ -816,6 +1196,9 @@ namespace smt::noodler {
 
         if (is_mult_membership_suitable()) {
             lbool result = run_mult_membership_heur();
+            if (result != l_undef) {
+                ++m_stats.m_solved_mult_membership_heur;
+            }
             if(result == l_true) {
                 return FC_DONE;
             } else if(result == l_false) {
@@ -823,6 +1206,21 @@ namespace smt::noodler {
             }
         }
 
+        // solve components of the constraints that are independent of the rest (of the constraints and of the arithmetic)
+        // on their own, the rest of the final check works with the remaining constraints only
+        if (m_params.m_split_components) {
+            lbool result = solve_independent_components();
+            if (result == l_true) {
+                ++m_stats.m_solved_components;
+                return FC_DONE;
+            } else if (result == l_false) {
+                // *_todo_rel were restricted to the unsatisfiable component
+                block_curr_len(expr_ref(m.mk_false(), m), false, true);
+                return FC_CONTINUE;
+            }
+            contains_word_disequations = !this->m_word_diseq_todo_rel.empty();
+        }
+
         // Gather relevant word (dis)equations to noodler formula
         Formula instance = get_word_formula_from_relevant();
         STRACE("str",
@@ -834,7 +1232,12 @@ namespace smt::noodler {
         // Gather symbols from relevant (dis)equations and from regular expressions of relevant memberships
         std::set<mata::Symbol> symbols_in_formula = get_symbols_from_relevant();
         // For the case that it is possible we have to_int/from_int, we keep digits (0-9) as explicit symbols, so that they are not represented by dummy_symbol and it is easier to handle to_int/from_int
-        if (!m_conversion_todo.empty()) {
+        // (to_code/from_code work with any symbols, so the digits widen the alphabet only if some relevant conversion is to_int/from_int)
+        bool has_int_conversion = false;
+        for (const auto& conv : m_conversion_todo) {
+            has_int_conversion |= std::get<2>(conv) == ConversionType::TO_INT || std::get<2>(conv) == ConversionType::FROM_INT;
+        }
+        if (has_int_conversion) {
             for (mata::Symbol s = 48; s <= 57; ++s) {
                 symbols_in_formula.insert(s);
             }
@@ -848,10 +1251,17 @@ namespace smt::noodler {
         // Get the initial length vars that are needed here (i.e they are in aut_assignment)
         std::unordered_set<BasicTerm> init_length_sensitive_vars{ get_init_length_vars(aut_assignment) };
 
+        if (!m_params.m_record_dir.empty()) {
+            record_instance(instance, aut_assignment, symbols_in_formula, init_length_sensitive_vars, conversions);
+        }
+
 
         // There is only one symbol in the equation. The system is SAT iff lengths are SAT
         if(symbols_in_formula.size() == 2 && !contains_word_disequations && !contains_conversions && this->m_not_contains_todo_rel.size() == 0 && this->m_membership_todo_rel.empty()) { // dummy symbol + 1
             lbool result = run_length_sat(instance, aut_assignment, init_length_sensitive_vars, conversions);
+            if (result != l_undef) {
+                ++m_stats.m_solved_length_sat;
+            }
             if(result == l_true) {
                 return FC_DONE;
             } else if(result == l_false) {
@@ -859,29 +1269,64 @@ namespace smt::noodler {
             }
         }
 
-        // try the length decision procedure (if enabled) to solve
-        if(m_params.m_try_length_proc && LengthDecisionProcedure::is_suitable(instance, aut_assignment) && contains_equations_only) {
-            lbool result = run_length_proc(instance, aut_assignment, init_length_sensitive_vars);
-            if(result == l_true) {
+        // the features of the instance choose the procedures tried before the main decision procedure (and their order)
+        InstanceFeatures features = get_instance_features(instance, aut_assignment, init_length_sensitive_vars);
+        STRACE("str", tout << "Instance features: " << features.to_string() << std::endl);
+
+        // the stochastic local search may quickly find words with the current lengths (in the portfolio it is one of the members)
+#ifndef SINGLE_THREAD
+        const bool sls_in_portfolio = m_params.m_portfolio;
+#else
+        const bool sls_in_portfolio = false;
+#endif
+        if (m_params.m_sls && !sls_in_portfolio && features.has_equations_only()) {
+            if (run_sls(instance, aut_assignment, init_length_sensitive_vars, symbols_in_formula) == l_true) {
+                ++m_stats.m_solved_sls;
                 return FC_DONE;
-            } else if(result == l_false) {
-                return FC_CONTINUE;
             }
         }
 
-        // try Nielsen transformation (if enabled) to solve
-        if(m_params.m_try_nielsen && is_nielsen_suitable(instance, init_length_sensitive_vars)) {
-            lbool result = run_nielsen(instance, aut_assignment, init_length_sensitive_vars);
+        // the procedures are tried one by one, unless they are run concurrently as a portfolio
+#ifndef SINGLE_THREAD
+        if(m_params.m_portfolio) {
+            lbool result = run_portfolio(instance, aut_assignment, init_length_sensitive_vars, conversions, symbols_in_formula, features);
             if(result == l_true) {
                 return FC_DONE;
             } else if(result == l_false) {
                 return FC_CONTINUE;
             }
-        }
-
-        // try length-based decision procedure (if enabled) to solve
-        if(m_params.m_try_length_proc && LengthDecisionProcedure::is_suitable(instance, aut_assignment)) {
-            lbool result = run_length_proc(instance, aut_assignment, init_length_sensitive_vars);
+        } else
+#endif
+        for(SolverProcedure proc : ProcedureSelector::create(m_params.m_procedure_selector)->select(features)) {
+            record_event(EventType::PROCEDURE_SELECTED, static_cast<uint64_t>(proc));
+            lbool result = l_undef;
+            if(proc == SolverProcedure::LENGTH && m_params.m_try_length_proc) {
+                // try length-based decision procedure (if enabled) to solve
+                result = run_length_proc(instance, aut_assignment, init_length_sensitive_vars);
+                if (result != l_undef) {
+                    ++m_stats.m_solved_length_proc;
+                }
+            } else if(proc == SolverProcedure::NIELSEN && m_params.m_try_nielsen) {
+                // try Nielsen transformation (if enabled) to solve
+                result = run_nielsen(instance, aut_assignment, init_length_sensitive_vars);
+                if (result != l_undef) {
+                    ++m_stats.m_solved_nielsen;
+                }
+            } else if(proc == SolverProcedure::UNDERAPPROX && m_params.m_underapproximation) {
+                // try underapproximation (if enabled) to solve, only sat is definitive
+                STRACE("str", tout << "Try underapproximation" << std::endl);
+                if (solve_underapprox(instance, aut_assignment, init_length_sensitive_vars, conversions) == l_true) {
+                    STRACE("str", tout << "Sat from underapproximation" << std::endl;);
+                    ++m_stats.m_solved_underapprox;
+                    result = l_true;
+                }
+            } else if(proc == SolverProcedure::BOUNDED) {
+                // the bounded procedure is suitable only if it is enabled
+                result = run_bounded(instance, aut_assignment, init_length_sensitive_vars);
+                if (result != l_undef) {
+                    ++m_stats.m_solved_bounded;
+                }
+            }
             if(result == l_true) {
                 return FC_DONE;
             } else if(result == l_false) {
@@ -889,20 +1334,13 @@ namespace smt::noodler {
             }
         }
 
-        // try underapproximation (if enabled) to solve
-        if(m_params.m_underapproximation && is_underapprox_suitable(instance, aut_assignment, conversions)) {
-            STRACE("str", tout << "Try underapproximation" << std::endl);
-            if (solve_underapprox(instance, aut_assignment, init_length_sensitive_vars, conversions) == l_true) {
-                STRACE("str", tout << "Sat from underapproximation" << std::endl;);
-                return FC_DONE;
-            }
-        }
-
-        DecisionProcedure dec_proc = DecisionProcedure{ instance, aut_assignment, init_length_sensitive_vars, m_params, conversions };
+        resumable_dec_proc& rdp = get_resumable_dec_proc(instance, aut_assignment, symbols_in_formula, init_length_sensitive_vars, conversions);
+        on_scope_exit collect_dec_proc_stats([&]() {
+            add_dec_proc_stats(rdp.dec_proc->get_stats(), rdp.reported_stats);
+            rdp.reported_stats = rdp.dec_proc->get_stats();
+        });
 
-        STRACE("str", tout << "Starting preprocessing" << std::endl);
-        lbool result = dec_proc.preprocess(PreprocessType::PLAIN, this->var_eqs.get_equivalence_bt(aut_assignment));
-        if (result == l_false) {
+        if (rdp.preprocess_result == l_false) {
             STRACE("str", tout << "Unsat from preprocessing" << std::endl);
             block_curr_len(expr_ref(m.mk_false(), m), false, true); // we do not store for loop protection
             return FC_CONTINUE;
@@ -910,7 +1348,7 @@ namespace smt::noodler {
 
         // it is possible that the arithmetic formula becomes unsatisfiable already by adding the (underapproximating)
         // length constraints from initial assignment
-        expr_ref lengths = len_node_to_z3_formula(dec_proc.get_initial_lengths());
+        expr_ref lengths = len_node_to_z3_formula(rdp.initial_lengths);
         if(check_len_sat(lengths) == l_false) {
             STRACE("str", tout << "Unsat from initial lengths" << std::endl);
             block_curr_len(lengths, true, true);
@@ -918,26 +1356,70 @@ namespace smt::noodler {
         }
 
         STRACE("str", tout << "Starting main decision procedure" << std::endl);
-        dec_proc.init_computation();
+        record_event(EventType::PROCEDURE_SELECTED, EventLog::PROCEDURE_MAIN);
+        // the budget is renewed in each final check, if it is exceeded, the next final check with the same input continues from where this one stopped
+        rdp.dec_proc->set_budget(get_fc_budget());
+        if (m_params.m_length_pruning || m_params.m_model_guided_noodles) {
+            // the states that cannot be consistent with the current lengths of length variables are not explored (or later)
+            std::map<BasicTerm, unsigned> lengths = get_ctx_lengths(aut_assignment);
+            std::erase_if(lengths, [&init_length_sensitive_vars](const auto& var_len) { return !init_length_sensitive_vars.contains(var_len.first); });
+            rdp.dec_proc->set_length_assignment(std::move(lengths));
+        }
 
         expr_ref block_len(m.mk_false(), m);
         bool was_something_approximated = false;
+        // the solutions found in previous final checks (with the same input) are tried first, then we continue with the procedure
+        unsigned next_solution = 0;
         while (true) {
-            result = dec_proc.compute_next_solution();
+            // the final check may take long, the progress is reported between the solutions
+            get_context().sample_progress();
+            lbool result = l_undef;
+            if (next_solution < rdp.solutions.size()) {
+                result = l_true;
+            } else if (rdp.exhausted) {
+                result = l_false;
+            } else {
+                const unsigned num_noodles = rdp.dec_proc->get_stats().num_noodles;
+                result = rdp.dec_proc->compute_next_solution();
+                record_event(EventType::NOODLES_GENERATED, rdp.dec_proc->get_stats().num_noodles - num_noodles);
+                if (result == l_true) {
+                    rdp.solutions.push_back(rdp.dec_proc->get_lengths());
+                    rdp.solution_states.push_back(rdp.dec_proc->get_solution());
+                } else if (result == l_false) {
+                    rdp.exhausted = true;
+                    rdp.length_pruned = rdp.dec_proc->was_length_pruned();
+                }
+            }
+
             if (result == l_true) {
-                auto [noodler_lengths, precision] = dec_proc.get_lengths();
+                auto [noodler_lengths, precision] = rdp.solutions[next_solution++];
                 lengths = len_node_to_z3_formula(noodler_lengths);
                 lbool is_lengths_sat = check_len_sat(lengths);
+                // the underapproximation can be deepened only for the current solution of the decision procedure
+                if (is_lengths_sat == l_false && precision == LenNodePrecision::UNDERAPPROX && next_solution == rdp.solutions.size()
+                    && rdp.dec_proc->get_underapprox_length() < m_params.m_underapprox_length_max) {
+                    is_lengths_sat = deepen_underapprox(*rdp.dec_proc, rdp.solutions.back(), lengths);
+                    precision = rdp.solutions.back().second;
+                }
                 
                 if (is_lengths_sat == l_true && precision != LenNodePrecision::OVERAPPROX) {
                     STRACE("str", tout << "len sat " << mk_pp(lengths, m) << std::endl;);
                     // save the current assignment to catch it during the loop protection
                     block_curr_len(lengths, true, false);
+                    // concrete string values are computed only from solutions without conversions
+                    if (rdp.conversions.empty()) {
+                        m_model_solution = std::make_unique<model_solution>(model_solution{
+                            instance, aut_assignment, rdp.solution_states[next_solution - 1], lengths, symbols_in_formula, var_name });
+                    }
+                    if (m_curr_fingerprint != nullptr) {
+                        m_curr_fingerprint->lengths = lengths;
+                        m_last_done_fingerprint = std::move(m_curr_fingerprint);
+                    }
                     return FC_DONE;
                 } else if (is_lengths_sat == l_false /*&& precision != LenNodePrecision::UNDERAPPROX*/) {
                     // TODO is handling underapprox correct here? is it even safe to underapproximate? we do not have a case where we underapproximate, but for the future
                     STRACE("str", tout << "len unsat " <<  mk_pp(lengths, m) << std::endl;);
-                    block_len = m.mk_or(block_len, lengths);
+                    block_len = m.mk_or(block_len, m_params.m_len_block_core ? weaken_blocked_len(lengths) : lengths);
 
                     if(precision == LenNodePrecision::UNDERAPPROX) {
                         ctx.get_fparams().is_underapprox = true;
@@ -948,6 +1430,11 @@ namespace smt::noodler {
                 // we need to block current assignment
                 STRACE("str", tout << "assignment unsat " << mk_pp(block_len, m) << std::endl;);
 
+                if (rdp.length_pruned) {
+                    // the pruned states can have solutions only with the lengths in their bounds
+                    block_len = m.mk_or(block_len, len_node_to_z3_formula(rdp.dec_proc->get_pruned_length_bounds()));
+                }
+
                 if (was_something_approximated) {
                     // if some length formula was an approximation and it did not lead to solution, we have to give up
                     STRACE("str", tout << "there was approximating - giving up" << std::endl);
@@ -961,6 +1448,18 @@ namespace smt::noodler {
                 }
                 return FC_CONTINUE;
             } else {
+                if (rdp.dec_proc->was_budget_exceeded()) {
+                    ++m_stats.m_num_budget_exceeded;
+                    // fall back to the (cheaper) underapproximation, if it was not already tried
+                    if (!m_params.m_underapproximation && features.is_underapprox_suitable()) {
+                        STRACE("str", tout << "Budget exceeded, try underapproximation" << std::endl);
+                        if (solve_underapprox(instance, aut_assignment, init_length_sensitive_vars, conversions) == l_true) {
+                            STRACE("str", tout << "Sat from underapproximation" << std::endl;);
+                            ++m_stats.m_solved_underapprox;
+                            return FC_DONE;
+                        }
+                    }
+                }
                 // we could not decide if there is solution, let's just give up
                 STRACE("str", tout << "giving up" << std::endl);
                 return FC_GIVEUP;
@@ -973,11 +1472,208 @@ namespace smt::noodler {
         (void) m;
         STRACE("str", tout << "mk_value: sort is " << mk_pp(tgt->get_sort(), m) << ", "
                            << mk_pp(tgt, m) << '\n';);
+        if (!m_model_words.empty() && m_util_s.is_string(tgt->get_sort())) {
+            // the value of some term of the equivalence class of n is computed from the solution
+            enode* curr = n;
+            do {
+                zstring word;
+                if (m_model_words.find(curr->get_expr(), word)) {
+                    app* value = m_util_s.str.mk_string(word);
+                    m_model_values.push_back(value);
+                    STRACE("str", tout << "mk_value: " << mk_pp(tgt, m) << " := " << mk_pp(value, m) << '\n';);
+                    return alloc(expr_wrapper_proc, value);
+                }
+                curr = curr->get_next();
+            } while (curr != n);
+        }
         return alloc(expr_wrapper_proc, tgt);
     }
 
     void theory_str_noodler::init_model(model_generator &mg) {
         STRACE("str", tout << "init_model\n";);
+        m_model_words.reset();
+        m_model_values.reset();
+        if (!m_sls_words.empty()) {
+            for (auto const& kv : m_sls_words) {
+                m_model_words.insert(kv.m_key, kv.m_value);
+            }
+        } else if (m_model_solution != nullptr && !compute_model_words()) {
+            STRACE("str", tout << "init_model: no concrete values of string variables" << std::endl;);
+            m_model_words.reset();
+        }
+    }
+
+    bool theory_str_noodler::compute_model_words() {
+        context& ctx = get_context();
+        const model_solution& sol = *m_model_solution;
+        using Word = std::vector<mata::Symbol>;
+
+        // the lengths of string variables are fixed to their values in the arithmetic of the context
+        arith_value av(m);
+        av.init(&ctx);
+        std::map<BasicTerm, rational> ctx_lengths;
+        expr_ref length_formula(sol.lengths, m);
+        for (const auto& [var, var_expr] : sol.var_name) {
+            if (!m_util_s.is_string(var_expr->get_sort())) {
+                continue;
+            }
+            expr_ref len_expr(m_util_s.str.mk_length(var_expr), m);
+            rational val;
+            if (ctx.e_internalized(len_expr) && av.get_value(len_expr, val)) {
+                ctx_lengths[var] = val;
+                length_formula = m.mk_and(length_formula, m.mk_eq(len_expr, m_util_a.mk_int(val)));
+            }
+        }
+
+        model_ref len_model;
+        m_len_session.sync(ctx, len_check_needs_assignments());
+        if (m_len_session.check_sat(length_formula, len_model) != l_true || !len_model) {
+            return false;
+        }
+
+        std::unordered_map<BasicTerm, Word> words;
+        for (const auto& [var, aut] : sol.state.aut_ass) {
+            if (!var.is_variable()) {
+                continue;
+            }
+            std::optional<unsigned> length;
+            if (sol.state.length_sensitive_vars.contains(var)) {
+                rational val;
+                expr_ref len_expr = util::len_to_expr(LenNode(var), sol.var_name, m, m_util_s, m_util_a);
+                if (!m_util_a.is_numeral((*len_model)(len_expr), val) || !val.is_unsigned()) {
+                    return false;
+                }
+                length = val.get_unsigned();
+            }
+            std::optional<Word> word = AutAssignment::get_word(*aut, length);
+            if (!word.has_value()) {
+                return false;
+            }
+            words[var] = std::move(*word);
+        }
+
+        // the word of a term (std::nullopt if it is a variable without a word yet)
+        auto get_term_word = [&](const BasicTerm& term) -> std::optional<Word> {
+            if (term.is_literal()) {
+                const zstring& lit = term.get_name();
+                Word word;
+                for (unsigned i = 0; i < lit.length(); ++i) {
+                    word.push_back(lit[i]);
+                }
+                return word;
+            }
+            auto it = words.find(term);
+            if (it == words.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        };
+        auto get_side_word = [&](const std::vector<BasicTerm>& side) -> std::optional<Word> {
+            Word word;
+            for (const BasicTerm& term : side) {
+                std::optional<Word> term_word = get_term_word(term);
+                if (!term_word.has_value()) {
+                    return std::nullopt;
+                }
+                word.insert(word.end(), term_word->begin(), term_word->end());
+            }
+            return word;
+        };
+
+        // substituted variables are concatenations of the variables they are substituted by
+        SolvingState state = sol.state;
+        state.flatten_substition_map();
+        for (const auto& [var, subst] : state.substitution_map) {
+            std::optional<Word> word = get_side_word(subst);
+            if (!word.has_value()) {
+                return false;
+            }
+            words[var] = std::move(*word);
+        }
+
+        // variables eliminated by the preprocessing get their words from the equations with only one unassigned side
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const Predicate& pred : sol.instance.get_predicates()) {
+                if (!pred.is_equation()) {
+                    continue;
+                }
+                for (const auto& [side, other_side] : { std::pair(pred.get_left_side(), pred.get_right_side()), std::pair(pred.get_right_side(), pred.get_left_side()) }) {
+                    if (side.size() != 1 || !side[0].is_variable() || words.contains(side[0])) {
+                        continue;
+                    }
+                    std::optional<Word> word = get_side_word(other_side);
+                    if (word.has_value()) {
+                        words[side[0]] = std::move(*word);
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // the remaining variables are restricted only by their memberships
+        for (const auto& [var, aut] : sol.aut_assignment) {
+            if (!var.is_variable() || words.contains(var)) {
+                continue;
+            }
+            std::optional<unsigned> length;
+            auto len_it = ctx_lengths.find(var);
+            if (len_it != ctx_lengths.end()) {
+                if (!len_it->second.is_unsigned()) {
+                    return false;
+                }
+                length = len_it->second.get_unsigned();
+            }
+            std::optional<Word> word = AutAssignment::get_word(*aut, length);
+            if (!word.has_value()) {
+                return false;
+            }
+            words[var] = std::move(*word);
+        }
+
+        // the words have to satisfy the instance, the memberships and the lengths from the context
+        for (const Predicate& pred : sol.instance.get_predicates()) {
+            if (!pred.is_equation() && !pred.is_inequation()) {
+                // not contains is not checked, we do not compute values for it
+                return false;
+            }
+            std::optional<Word> left = get_side_word(pred.get_left_side());
+            std::optional<Word> right = get_side_word(pred.get_right_side());
+            if (!left.has_value() || !right.has_value() || ((*left == *right) != pred.is_equation())) {
+                return false;
+            }
+        }
+        for (const auto& [var, aut] : sol.aut_assignment) {
+            if (var.is_variable() && !aut->is_in_lang(mata::nfa::Run{ words.at(var), {} })) {
+                return false;
+            }
+        }
+        for (const auto& [var, len] : ctx_lengths) {
+            auto it = words.find(var);
+            if (it != words.end() && rational(it->second.size()) != len) {
+                return false;
+            }
+        }
+
+        // the dummy symbol stands for any symbol not occurring in the formula, we take the first such symbol from 'a'
+        mata::Symbol dummy_replacement = 'a';
+        while (sol.symbols.contains(dummy_replacement)) {
+            ++dummy_replacement;
+        }
+        for (const auto& [var, word] : words) {
+            auto it = sol.var_name.find(var);
+            if (it == sol.var_name.end() || !m_util_s.is_string(it->second->get_sort())) {
+                continue;
+            }
+            std::vector<unsigned> chars;
+            for (mata::Symbol s : word) {
+                chars.push_back(is_dummy_symbol(s) ? dummy_replacement : s);
+            }
+            m_model_words.insert(it->second, zstring(chars.size(), chars.data()));
+        }
+        STRACE("str", tout << "init_model: computed values of " << m_model_words.size() << " string variables" << std::endl;);
+        return true;
     }
 
     void theory_str_noodler::finalize_model(model_generator &mg) {
@@ -985,7 +1681,13 @@ namespace smt::noodler {
     }
 
     lbool theory_str_noodler::validate_unsat_core(expr_ref_vector &unsat_core) {
-        return l_undef;
+        // the blocking clauses are implied by the string constraints, i.e., the core is valid, unless some of them
+        // came from an underapproximation (then unsat is not trusted, see smt_tactic_core)
+        if (get_context().get_fparams().is_underapprox) {
+            STRACE("str", tout << "unsat core is not validated, an underapproximation was used" << std::endl;);
+            return l_undef;
+        }
+        return l_false;
     }
 
     expr_ref theory_str_noodler::mk_sub(expr *a, expr *b) {
@@ -999,6 +1701,12 @@ namespace smt::noodler {
     literal theory_str_noodler::mk_literal(expr *const e) {
         ast_manager &m = get_manager();
         context &ctx = get_context();
+        literal cached;
+        if (m_literal_cache.find(e, cached)) {
+            // the expression was already rewritten, propagated and internalized in this scope, only relevancy is scoped by decisions
+            ctx.mark_as_relevant(cached);
+            return cached;
+        }
         expr_ref ex{e, m};
         // simplify the expression. This was commented before and it caused 
         // problems at some point, I am not pretty sure of what kind.
@@ -1012,7 +1720,9 @@ namespace smt::noodler {
         }
         enode *const n = ctx.get_enode(ex);
         ctx.mark_as_relevant(n);
-        return ctx.get_literal(ex);
+        literal lit = ctx.get_literal(ex);
+        m_literal_cache.insert(e, lit);
+        return lit;
     }
 
     bool_var theory_str_noodler::mk_bool_var(expr *const e) {
@@ -1052,6 +1762,13 @@ namespace smt::noodler {
         }
     }
 
+    void theory_str_noodler::set_branching_priority(literal l, double priority) {
+        if (l == null_literal || l == true_literal || l == false_literal) {
+            return;
+        }
+        ctx.add_theory_aware_branching_info(l.var(), priority, l_undef);
+    }
+
     void theory_str_noodler::add_axiom(std::vector<literal> ls) {
         STRACE("str", tout << __LINE__ << " enter " << __FUNCTION__ << std::endl;);
         context &ctx = get_context();
@@ -1060,6 +1777,10 @@ namespace smt::noodler {
             if (l != null_literal && l != false_literal) {
                 ctx.mark_as_relevant(l);
                 lv.push_back(l);
+                // equations of axioms of extended functions (mostly with fresh variables) are decided last
+                if (m_axiom_term != nullptr && l != true_literal && m.is_eq(ctx.bool_var2expr(l.var()))) {
+                    set_branching_priority(l, BRANCHING_PRIORITY_LOW);
+                }
             }
         }
         ctx.mk_th_axiom(get_id(), lv, lv.size());
@@ -1088,6 +1809,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         ast_manager &m = get_manager();
         expr *s = nullptr, *i = nullptr, *res = nullptr;
         VERIFY(m_util_s.str.is_at(e, s, i));
@@ -1360,6 +2082,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
 
         ast_manager &m = get_manager();
         expr *s = nullptr, *i = nullptr, *l = nullptr;
@@ -1526,6 +2249,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(r);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, r);
         context& ctx = get_context();
         expr* a = nullptr, *s = nullptr, *t = nullptr;
         VERIFY(m_util_s.str.is_replace(r, a, s, t));
@@ -1657,6 +2381,7 @@ namespace smt::noodler {
         if(axiomatized_persist_terms.contains(e))
             return;
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
 
         context& ctx = get_context();
         expr *s = nullptr, *R = nullptr, *t = nullptr;
@@ -1711,6 +2436,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(i);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, i);
         ast_manager &m = get_manager();
         expr *s = nullptr, *t = nullptr, *offset = nullptr;
         rational r;
@@ -1820,6 +2546,7 @@ namespace smt::noodler {
             expr_ref s1s2 = mk_concat(s1, s2);
             neg_assumptions.push_back(mk_literal(m.mk_eq(s, s1s2)));
             add_axiom(neg_assumptions);
+            set_branching_priority(neg_assumptions.back(), BRANCHING_PRIORITY_HIGH);
 
             // not(s = eps) -> neg_assumptions || s2 in re.allchar (is a single character)
             expr_ref re(m_util_s.re.mk_in_re(s2, m_util_s.re.mk_full_char(nullptr)), m);
@@ -1861,7 +2588,12 @@ namespace smt::noodler {
             }
         }
 
-        literal lit = mk_eq(e, m_util_s.str.mk_empty(e->get_sort()), false);
+        expr_ref eq(m.mk_eq(e, m_util_s.str.mk_empty(e->get_sort())), m);
+        literal lit;
+        if (!m_literal_cache.find(eq, lit)) {
+            lit = mk_eq(e, m_util_s.str.mk_empty(e->get_sort()), false);
+            m_literal_cache.insert(eq, lit);
+        }
         ctx.mark_as_relevant(lit);
         return lit;
     }
@@ -1879,6 +2611,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         ast_manager &m = get_manager();
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_prefix(e, x, y));
@@ -1917,6 +2650,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(m.mk_not(e));
+        axiom_fresh_vars_scope fresh_vars_scope(*this, m.mk_not(e));
         ast_manager &m = get_manager();
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_prefix(e, x, y));
@@ -2004,6 +2738,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         ast_manager &m = get_manager();
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_suffix(e, x, y));
@@ -2031,6 +2766,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(m.mk_not(e));
+        axiom_fresh_vars_scope fresh_vars_scope(*this, m.mk_not(e));
         ast_manager &m = get_manager();
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_suffix(e, x, y));
@@ -2113,6 +2849,7 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         STRACE("str", tout  << "handle contains " << mk_pp(e, m) << std::endl;);
         ast_manager &m = get_manager();
         expr *x = nullptr, *y = nullptr;
@@ -2212,11 +2949,15 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         STRACE("str", tout  << "handle str.<= " << mk_pp(e, m) << std::endl;);
 
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_le(e, x, y));
-      
+        if(handle_lex_literal(e, x, y, false)) {
+            return;
+        }
+
         expr_ref e_lt(m_util_s.str.mk_lex_lt(x, y), m);
         expr_ref x_y(m.mk_eq(x,y), m);
         literal lit_e_lt = mk_literal(e_lt);
@@ -2247,10 +2988,14 @@ namespace smt::noodler {
             return;
 
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
         STRACE("str", tout  << "handle str.< " << mk_pp(e, m) << std::endl;);
 
         expr *x = nullptr, *y = nullptr;
         VERIFY(m_util_s.str.is_lt(e, x, y));
+        if(handle_lex_literal(e, x, y, true)) {
+            return;
+        }
         expr_ref eps(m_util_s.str.mk_string(""), m);
         expr_ref x_eps(m.mk_eq(x, eps), m);
         expr_ref y_eps(m.mk_eq(y, eps), m);
@@ -2304,6 +3049,75 @@ namespace smt::noodler {
         add_axiom({~lit_e, lit_x_eps,  mk_literal(to_code_lt)});
     }
 
+    /**
+     * @brief Handle str.< (if @p strict) or str.<= @p e of @p x and @p y where one of them is a string literal c.
+     * The words that are (strictly) smaller than c are
+     *
+     *     the proper prefixes of c  |  c[0..i) [0-(c[i]-1)] Σ*  (for each i)
+     *
+     * and the words that are (strictly) larger than c are
+     *
+     *     c Σ+  |  c[0..i) [(c[i]+1)-max] Σ*  (for each i)
+     *
+     * (both together with c if not @p strict), so the following axioms are added for the other side z of @p e:
+     *
+     * e <-> z in R   where R is the regex of the words in the relation with c
+     *
+     * @return Whether @p e was axiomatized (i.e., one of its sides is a literal)
+     */
+    bool theory_str_noodler::handle_lex_literal(expr *e, expr *x, expr *y, bool strict) {
+        zstring c;
+        expr* other = nullptr;
+        bool other_is_smaller; // the relation requires other < c (otherwise c < other)
+        if(m_util_s.str.is_string(y, c)) {
+            other = x;
+            other_is_smaller = true;
+        } else if(m_util_s.str.is_string(x, c)) {
+            other = y;
+            other_is_smaller = false;
+        } else {
+            return false;
+        }
+        STRACE("str", tout << "str.<" << (strict ? "" : "=") << " with a literal is axiomatized by a membership" << std::endl;);
+
+        sort* re_sort = m_util_s.re.mk_re(m_util_s.str.mk_string_sort());
+        expr_ref sigma_star(m_util_s.re.mk_full_seq(re_sort), m);
+        expr_ref regex(m_util_s.re.mk_empty(re_sort), m);
+        auto add_alternative = [&](expr* alternative) {
+            regex = m_util_s.re.mk_union(regex, alternative);
+        };
+        auto mk_char = [this](unsigned ch) {
+            return m_util_s.str.mk_string(zstring(1, &ch));
+        };
+
+        if(!strict) {
+            add_alternative(m_util_s.re.mk_to_re(m_util_s.str.mk_string(c)));
+        }
+        if(!other_is_smaller) {
+            // c Σ+
+            add_alternative(m_util_s.re.mk_concat(m_util_s.re.mk_to_re(m_util_s.str.mk_string(c)), m_util_s.re.mk_plus(m_util_s.re.mk_full_char(re_sort))));
+        }
+        for(unsigned i = 0; i < c.length(); ++i) {
+            expr_ref prefix(m_util_s.re.mk_to_re(m_util_s.str.mk_string(c.extract(0, i))), m);
+            if(other_is_smaller) {
+                // proper prefix of c
+                add_alternative(prefix);
+            }
+            // the first different symbol is smaller/larger than c[i]
+            if(other_is_smaller && c[i] > 0) {
+                add_alternative(m_util_s.re.mk_concat(prefix, m_util_s.re.mk_concat(m_util_s.re.mk_range(mk_char(0), mk_char(c[i] - 1)), sigma_star)));
+            } else if(!other_is_smaller && c[i] < zstring::max_char()) {
+                add_alternative(m_util_s.re.mk_concat(prefix, m_util_s.re.mk_concat(m_util_s.re.mk_range(mk_char(c[i] + 1), mk_char(zstring::max_char())), sigma_star)));
+            }
+        }
+
+        literal lit_e = mk_literal(e);
+        literal lit_in_re = mk_literal(m_util_s.re.mk_in_re(other, regex));
+        add_axiom({~lit_e, lit_in_re});
+        add_axiom({lit_e, ~lit_in_re});
+        return true;
+    }
+
     void theory_str_noodler::handle_in_re(expr *const e, const bool is_true) {
         expr *s = nullptr, *re = nullptr;
         VERIFY(m_util_s.str.is_in_re(e, s, re));
@@ -2359,6 +3173,7 @@ namespace smt::noodler {
         if(axiomatized_persist_terms.contains(e))
             return;
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
 
         expr *s = nullptr;
         VERIFY(m_util_s.str.is_is_digit(e, s));
@@ -2433,6 +3248,7 @@ namespace smt::noodler {
         if(axiomatized_persist_terms.contains(e))
             return;
         axiomatized_persist_terms.insert(e);
+        axiom_fresh_vars_scope fresh_vars_scope(*this, e);
 
         expr *s = nullptr;
 
@@ -2625,7 +3441,19 @@ namespace smt::noodler {
 
     expr_ref theory_str_noodler::mk_str_var_fresh(const std::string& name) {
         // TODO move the function from util completely here?
-        return util::mk_str_var_fresh(name, m, m_util_s);
+        if (m_axiom_term == nullptr) {
+            return util::mk_str_var_fresh(name, m, m_util_s);
+        }
+        // reuse the variables created when the term was axiomatized before (see axiom_fresh_vars_scope)
+        auto it = m_axiom_fresh_vars.find(m_axiom_term);
+        if (it == m_axiom_fresh_vars.end()) {
+            it = m_axiom_fresh_vars.emplace(m_axiom_term, std::make_pair(expr_ref(m_axiom_term, m), std::vector<expr_ref>())).first;
+        }
+        std::vector<expr_ref>& fresh_vars = it->second.second;
+        if (m_axiom_fresh_idx == fresh_vars.size()) {
+            fresh_vars.push_back(util::mk_str_var_fresh(name, m, m_util_s));
+        }
+        return fresh_vars[m_axiom_fresh_idx++];
     }
 
     expr_ref theory_str_noodler::mk_int_var_fresh(const std::string& name) {
@@ -2634,9 +3462,12 @@ namespace smt::noodler {
     }
 
     expr_ref theory_str_noodler::len_node_to_z3_formula(const LenNode& len_formula) {
-        return util::len_to_expr(
+        expr_ref result = util::len_to_expr(
                 len_formula,
                 this->var_name,
                 this->m, this->m_util_s, this->m_util_a );
+        // the length formulas of successive solutions share most of their subterms, which stay in the cache of m_rewrite
+        m_rewrite(result);
+        return result;
     }
 }
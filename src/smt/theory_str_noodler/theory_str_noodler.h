@@ -25,7 +25,9 @@ Eternal glory to Yu-Fang.
 #include "smt/smt_theory.h"
 #include "smt/smt_arith_value.h"
 #include "util/scoped_vector.h"
+#include "util/obj_pair_hashtable.h"
 #include "util/union_find.h"
+#include "util/stopwatch.h"
 #include "ast/rewriter/seq_rewriter.h"
 #include "ast/rewriter/th_rewriter.h"
 
@@ -39,6 +41,13 @@ Eternal glory to Yu-Fang.
 #include "var_union_find.h"
 #include "nielsen_decision_procedure.h"
 #include "length_decision_procedure.h"
+#include "sls_decision_procedure.h"
+#include "bounded_decision_procedure.h"
+#include "length_presolver.h"
+#include "procedure_selector.h"
+#include "event_log.h"
+#include "instance_record.h"
+#include "session.h"
 
 namespace smt::noodler {
 
@@ -53,10 +62,150 @@ namespace smt::noodler {
         struct stored_instance {
             expr_ref lengths; // length formula 
             bool initial_length; // was the length formula obtained from the initial length checking?
+            lbool len_result = l_undef; // last result of checking lengths in the length session
+            unsigned len_generation = 0; // generation of the length session in which len_result was obtained
+        };
+
+        /**
+         * Set of expressions whose elements are tagged by the scope in which they were inserted. Popping a scope
+         * removes only the expressions inserted in it, so the expressions inserted in the base scope (and in the
+         * scopes that are kept) survive pops.
+         */
+        class scoped_expr_set {
+            obj_hashtable<expr> m_set;
+            // inserted expressions in the order of insertion, m_lim[i] is the size of m_trail when the scope i+1 was pushed
+            ptr_vector<expr> m_trail;
+            unsigned_vector m_lim;
+        public:
+            bool contains(expr* e) const { return m_set.contains(e); }
+            void insert(expr* e) {
+                if (!m_set.contains(e)) {
+                    m_set.insert(e);
+                    m_trail.push_back(e);
+                }
+            }
+            void push_scope() { m_lim.push_back(m_trail.size()); }
+            void pop_scope(unsigned num_scopes) {
+                if (num_scopes == 0 || m_lim.empty()) {
+                    return;
+                }
+                const unsigned new_lvl = m_lim.size() - std::min<unsigned>(num_scopes, m_lim.size());
+                const unsigned old_size = m_lim[new_lvl];
+                for (unsigned i = old_size; i < m_trail.size(); ++i) {
+                    m_set.remove(m_trail[i]);
+                }
+                m_trail.shrink(old_size);
+                m_lim.shrink(new_lvl);
+            }
+            void reset() {
+                m_set.reset();
+                m_trail.reset();
+                m_lim.reset();
+            }
+        };
+
+        /**
+         * Cache of literals created for expressions (see mk_literal()), scoped in the same way as scoped_expr_set,
+         * i.e., popping a scope removes the literals created in it (they are not internalized anymore).
+         */
+        class scoped_literal_cache {
+            obj_map<expr, literal> m_map;
+            // keeps the keys alive
+            expr_ref_vector m_trail;
+            unsigned_vector m_lim;
+        public:
+            scoped_literal_cache(ast_manager& m) : m_trail(m) {}
+            bool find(expr* e, literal& lit) const { return m_map.find(e, lit); }
+            void insert(expr* e, literal lit) {
+                if (!m_map.contains(e)) {
+                    m_map.insert(e, lit);
+                    m_trail.push_back(e);
+                }
+            }
+            void push_scope() { m_lim.push_back(m_trail.size()); }
+            void pop_scope(unsigned num_scopes) {
+                if (num_scopes == 0 || m_lim.empty()) {
+                    return;
+                }
+                const unsigned new_lvl = m_lim.size() - std::min<unsigned>(num_scopes, m_lim.size());
+                const unsigned old_size = m_lim[new_lvl];
+                for (unsigned i = old_size; i < m_trail.size(); ++i) {
+                    m_map.remove(m_trail.get(i));
+                }
+                m_trail.shrink(old_size);
+                m_lim.shrink(new_lvl);
+            }
+            void reset() {
+                m_map.reset();
+                m_trail.reset();
+                m_lim.reset();
+            }
+        };
+
+        struct stats {
+            stats() { reset(); }
+            void reset() { memset(this, 0, sizeof(stats)); }
+            unsigned m_num_final_checks;
+            // number of final checks decided by the given fast path
+            unsigned m_solved_loop_protection;
+            unsigned m_solved_repeated_final_check;
+            unsigned m_solved_membership_heur;
+            unsigned m_solved_mult_membership_heur;
+            unsigned m_solved_length_sat;
+            unsigned m_solved_nielsen;
+            unsigned m_solved_length_proc;
+            unsigned m_solved_underapprox;
+            unsigned m_solved_sls;
+            unsigned m_solved_bounded;
+            unsigned m_solved_components;
+            // number of independent components solved separately by solve_independent_components
+            unsigned m_num_components_solved;
+            // collected from the runs of DecisionProcedure
+            unsigned m_num_noodlifications;
+            unsigned m_num_noodles;
+            unsigned m_num_solving_states;
+            unsigned m_num_inclusion_checks;
+            unsigned m_num_inclusion_cache_hits;
+            unsigned m_num_preprocess_passes_skipped;
+            unsigned m_num_preprocess_memo_hits;
+            unsigned m_num_preprocess_ops_gated;
+            unsigned m_max_aut_states;
+            // maximal approximate memory of the worklist and the states evicted from it (see m_params.m_fc_max_memory)
+            unsigned m_max_worklist_kb;
+            unsigned m_num_evicted_states;
+            unsigned m_num_witness_inclusions;
+            unsigned m_num_shared_segments;
+            unsigned m_num_concatenation_memo_hits;
+            unsigned m_num_nogoods;
+            unsigned m_num_nogood_pruned_states;
+            unsigned m_num_length_pruned_states;
+            unsigned m_num_model_deferred_states;
+            unsigned m_num_check_len_sat;
+            // number of length formulas refuted by the presolver (see m_params.m_len_presolve)
+            unsigned m_num_len_presolve_unsat;
+            // number of blocked length formulas weakened by their unsat cores and the number of their dropped conjuncts (see m_params.m_len_block_core)
+            unsigned m_num_len_block_weakened;
+            unsigned m_num_len_block_dropped;
+            // number of final checks in which the decision procedure exceeded its budget
+            unsigned m_num_budget_exceeded;
+            // number of rounds of the iterative deepening of the underapproximation of conversions
+            unsigned m_num_underapprox_rounds;
+            // number of terms axiomatized in final checks (see m_params.m_lazy_axioms)
+            unsigned m_num_lazy_axiomatized;
+            // number of conflicts of memberships found during the search (see propagate_membership)
+            unsigned m_num_search_conflicts;
+            // number of constraints removed from string conflicts (see shrink_relevant_unsat_core())
+            unsigned m_num_core_shrink_removed;
+            // number of length axioms of memberships added during the search (see propagate_membership_lengths())
+            unsigned m_num_length_bound_axioms;
         };
 
         int m_scope_level = 0;
         const theory_str_noodler_params& m_params;
+        stats m_stats;
+        stopwatch m_final_check_watch;
+        stopwatch m_preprocess_watch;
+        stopwatch m_check_len_sat_watch;
         th_rewriter m_rewrite;
         arith_util m_util_a;
         seq_util m_util_s;
@@ -74,14 +223,59 @@ namespace smt::noodler {
         // mapping predicates and function to variables that they substitute to
         obj_map<expr, expr*> predicate_replace;
 
+        /**
+         * Conversion of a word (dis)equation to a predicate (see conv_eq_pred_cached()), it is reused by the next
+         * final checks as long as the terms of predicate_replace used by it have the same replacements.
+         */
+        struct pred_conversion {
+            Predicate pred;
+            // terms of predicate_replace used by the conversion and their replacements
+            std::vector<std::pair<expr*, expr*>> replaced;
+            // keeps the sides of the (dis)equation and the terms in replaced alive
+            expr_ref_vector pinned;
+        };
+        // maps sides of word (dis)equations to their conversions in m_pred_convs
+        obj_pair_map<expr, expr, unsigned> m_pred_conv_index;
+        std::vector<pred_conversion> m_pred_convs;
+        static const unsigned MAX_PRED_CONVERSIONS = 10000;
+
         // TODO what are these?
         std::vector<app_ref> axiomatized_len_axioms;
-        obj_hashtable<expr> axiomatized_terms;
+        // axioms and terms whose axioms were added, kept as long as the scope in which they were added (the
+        // clauses of the axioms are removed by the context when popping this scope)
+        scoped_expr_set axiomatized_terms;
         obj_hashtable<expr> axiomatized_persist_terms;
-        obj_hashtable<expr> propagated_string_theory;
+        // fresh string variables created when axiomatizing terms (see axiom_fresh_vars_scope), kept across
+        // backtracking; the first element of the pair keeps the term alive
+        std::unordered_map<const expr*, std::pair<expr_ref, std::vector<expr_ref>>> m_axiom_fresh_vars;
+        // the term that is being axiomatized and the number of its fresh variables used so far
+        expr* m_axiom_term = nullptr;
+        unsigned m_axiom_fresh_idx = 0;
+        scoped_expr_set propagated_string_theory;
+        // concatenations whose (flattened) length axiom was added (see propagate_concat_axiom)
+        scoped_expr_set concat_length_axiomatized;
+        // literals created by mk_literal() and mk_eq_empty() for (not rewritten) expressions
+        scoped_literal_cache m_literal_cache;
         obj_hashtable<expr> m_has_length;          // is length applied
         expr_ref_vector     m_length;             // length applications themselves
         std::vector<std::pair<expr_ref, stored_instance>> axiomatized_instances;
+        // maps (hash-consed) refinement to the indices of its instances in axiomatized_instances
+        obj_map<expr, std::vector<unsigned>> axiomatized_instances_index;
+        // length solver kept alive between calls of check_len_sat (see int_expr_session)
+        int_expr_session m_len_session;
+        // caches kept between final checks, they are shared with the other instances of the theory for the same
+        // manager (see NoodlerSession), or owned by this instance if m_params.m_session_caches is not set
+        std::unique_ptr<NoodlerSession> m_own_session;
+        NoodlerSession& m_session;
+        regex::NfaCache& m_nfa_cache;
+        regex::MembershipCache& m_membership_cache;
+        regex::RegexInfoCache& m_regex_info_cache;
+        AutomataPool& m_aut_pool;
+        PreprocessMemo& m_preprocess_memo;
+        LiteralStore& m_literal_store;
+        LengthAbstractionCache& m_len_abstraction_cache;
+        // profile of preprocessing passes over the whole session (reported in collect_statistics)
+        PreprocessProfile m_prep_profile;
 
         // TODO what are these?
         vector<std::pair<obj_hashtable<expr>,std::vector<app_ref>>> len_state;
@@ -102,6 +296,10 @@ namespace smt::noodler {
         // contains pair of variables (e,s), where we have one of e = str.to_code(s), e = str.from_code(s),
         // e = str.to_int(s), or e = str.from_int(s), based on the conversion type
         scoped_vector<std::tuple<expr_ref,expr_ref,ConversionType>> m_conversion_todo;
+        // relevant terms whose axiomatization is postponed to final_check_eh (see m_params.m_lazy_axioms)
+        scoped_vector<expr_ref> m_lazy_axiom_todo;
+        // number of memberships at the beginning of m_membership_todo that were already checked in propagate()
+        unsigned m_membership_prop_head = 0;
 
         // during final_check_eh, we call remove_irrelevant_constr which chooses from previous sets of
         // todo constraints and check if they are relevant for current SAT assignment => if they are
@@ -113,11 +311,99 @@ namespace smt::noodler {
         vector<expr_pair_flag> m_membership_todo_rel; // contains the variable and reg. lang. + flag telling us if it is negated (false -> negated)
         // we cannot decide relevancy of to_code, from_code, to_int and from_int, so we assume everything in m_conversion_todo is relevant => no _todo_rel version
 
+        /**
+         * Decision procedure kept from the previous final check together with its input. If the next final
+         * check has the same input, the procedure is not created (and preprocessed) again. Instead, the length
+         * formulas of the solutions it already found are checked again and then it continues from its worklist.
+         */
+        struct resumable_dec_proc {
+            // input of the decision procedure
+            Formula instance;
+            vector<expr_pair_flag> memberships;
+            vector<std::tuple<expr_ref,expr_ref,ConversionType>> conversions;
+            std::set<mata::Symbol> symbols;
+            std::unordered_set<BasicTerm> init_length_sensitive_vars;
+            BasicTermEqiv len_eq_vars;
+
+            scoped_ptr<DecisionProcedure> dec_proc;
+            lbool preprocess_result = l_undef;
+            LenNode initial_lengths = LenNode(LenFormulaType::TRUE);
+            // length formulas of solutions found so far (in the order in which they were found)
+            std::vector<std::pair<LenNode, LenNodePrecision>> solutions;
+            // solving states of the solutions (in the same order as solutions)
+            std::vector<SolvingState> solution_states;
+            // is the worklist of dec_proc exhausted (i.e. there are no other solutions)?
+            bool exhausted = false;
+            // were some states of dec_proc pruned by the lengths of the arithmetic assignment when it was exhausted?
+            bool length_pruned = false;
+            // statistics of dec_proc that were already added to m_stats
+            DecisionProcedureStats reported_stats;
+        };
+        std::unique_ptr<resumable_dec_proc> m_last_dec_proc;
+
+        /**
+         * Solution of the main decision procedure with which the last final check returned FC_DONE. The concrete
+         * values of string variables in the model are computed from it (see compute_model_words()).
+         */
+        struct model_solution {
+            Formula instance;
+            // automata of the instance before preprocessing (they contain the memberships)
+            AutAssignment aut_assignment;
+            SolvingState state;
+            // length formula of the solution
+            expr_ref lengths;
+            std::set<mata::Symbol> symbols;
+            std::map<BasicTerm, expr_ref> var_name;
+        };
+        std::unique_ptr<model_solution> m_model_solution;
+        // words of string variables found by the stochastic local search with which the last final check returned FC_DONE
+        obj_map<expr, zstring> m_sls_words;
+        // concrete values of string variables in the model (computed in init_model)
+        obj_map<expr, zstring> m_model_words;
+        // string literals returned by mk_value (expr_wrapper_proc does not keep them alive)
+        expr_ref_vector m_model_values;
+
+        /**
+         * Relevant constraints of a final check (see get_relevant_fingerprint()). For the last final check that
+         * returned FC_DONE with a solution of the main decision procedure, also the length formula of the solution.
+         */
+        struct relevant_fingerprint {
+            // ids of the relevant constraints together with the sizes of their lists and their flags
+            std::vector<unsigned> ids;
+            // keeps the constraints alive, so their ids are not reused
+            expr_ref_vector exprs;
+            expr_ref lengths;
+            relevant_fingerprint(ast_manager& m) : ids(), exprs(m), lengths(m) {}
+        };
+        // fingerprint of the current final check (only if m_params.m_loop_protect is set)
+        std::unique_ptr<relevant_fingerprint> m_curr_fingerprint;
+        // fingerprint of the last final check that returned FC_DONE from the main decision procedure
+        std::unique_ptr<relevant_fingerprint> m_last_done_fingerprint;
+
+        // log of events of the solver (nullptr if it is disabled, see m_params.m_event_log_capacity)
+        std::unique_ptr<EventLog> m_event_log;
+        void record_event(EventType type, uint64_t value = 0, uint64_t value2 = 0) {
+            if (m_event_log) {
+                m_event_log->record(type, value, value2);
+            }
+        }
+
+        /**
+         * Relevant constraints that do not share variables with other relevant constraints (see get_relevant_components()).
+         */
+        struct relevant_component {
+            // indices of constraints (equations, then disequations and then memberships)
+            std::vector<unsigned> constraints;
+            // names of variables occurring in the constraints
+            std::unordered_set<std::string> vars;
+        };
+
     public:
         char const * get_name() const override { return "noodler"; }
         theory_str_noodler(context& ctx, ast_manager & m, theory_str_noodler_params const & params);
         void display(std::ostream& os) const override;
-        theory *mk_fresh(context * newctx) override { return alloc(theory_str_noodler, *newctx, get_manager(), m_params); }
+        // the copy lives in the manager and parameters of newctx (e.g. of a worker of smt.threads), it shares no state with this instance
+        theory *mk_fresh(context * newctx) override { return alloc(theory_str_noodler, *newctx, newctx->get_manager(), newctx->get_fparams()); }
         void init() override;
         theory_var mk_var(enode *n) override;
         void apply_sort_cnstr(enode* n, sort* s) override;
@@ -125,6 +411,8 @@ namespace smt::noodler {
         bool internalize_term(app *term) override;
         void init_search_eh() override;
         void relevant_eh(app *n) override;
+        bool use_relevant_batch() const override { return true; }
+        void relevant_batch_eh(unsigned num, app * const * ns) override;
         void assign_eh(bool_var v, bool is_true) override;
         void new_eq_eh(theory_var, theory_var) override;
         void new_diseq_eh(theory_var, theory_var) override;
@@ -135,10 +423,28 @@ namespace smt::noodler {
         void reset_eh() override;
         final_check_status final_check_eh() override;
         model_value_proc *mk_value(enode *n, model_generator& mg) override;
+        /**
+         * @brief The final check itself, final_check_eh() only records its events (see m_event_log).
+         */
+        final_check_status final_check_main();
         void init_model(model_generator& m) override;
         void finalize_model(model_generator& mg) override;
         lbool validate_unsat_core(expr_ref_vector& unsat_core) override;
 
+        /**
+         * @brief Compute the concrete values of string variables (m_model_words) from m_model_solution.
+         *
+         * The lengths of string variables are fixed to their values in the arithmetic of the context, a model of the
+         * length formula of the solution gives the lengths of the words of length-sensitive variables. Variables
+         * eliminated by the preprocessing are assigned from the equations of the instance. The words are checked
+         * against the instance, if some predicate does not hold, no values are computed (and mk_value falls back
+         * to the terms themselves).
+         *
+         * @return True if the values were computed
+         */
+        bool compute_model_words();
+        void collect_statistics(::statistics & st) const override;
+
         // FIXME ensure_enode is non-virtual function of theory, why are we redegfining it?
         enode* ensure_enode(expr* e);
 
@@ -165,11 +471,22 @@ namespace smt::noodler {
         bool has_length(expr *e) const { return m_has_length.contains(e); }
         void enforce_length(expr* n);
 
-        ~theory_str_noodler() {}
+        ~theory_str_noodler();
 
     protected:
         expr_ref mk_sub(expr *a, expr *b);
 
+        // priorities of literals in theory-aware case splits (see set_branching_priority)
+        static constexpr double BRANCHING_PRIORITY_HIGH = 1.0;
+        static constexpr double BRANCHING_PRIORITY_LOW = -1.0;
+        // memberships with regexes of at most this number of subterms are decided with high priority
+        static const unsigned BRANCHING_SMALL_REGEX = 20;
+        /**
+         * @brief Set the priority of deciding the literal @p l (literals with higher priority are decided first).
+         * Used only by the theory-aware case split queue (smt.case_split=6).
+         */
+        void set_branching_priority(literal l, double priority);
+
         literal mk_literal(expr *e);
         bool_var mk_bool_var(expr *e);
         /**
@@ -179,6 +496,28 @@ namespace smt::noodler {
          * FIXME same function is in theory_str_noodler, decide which to keep
          */
         expr_ref mk_str_var_fresh(const std::string& name);
+
+        /**
+         * @brief While alive, mk_str_var_fresh returns the fresh variables that were created for axiomatizing
+         * @p term before (in the order of their creation), so axiomatizing the same term again (e.g., after
+         * backtracking) does not introduce new variables.
+         */
+        class axiom_fresh_vars_scope {
+        private:
+            theory_str_noodler& th;
+            expr* prev_term;
+            unsigned prev_idx;
+
+        public:
+            axiom_fresh_vars_scope(theory_str_noodler& th, expr* term) : th(th), prev_term(th.m_axiom_term), prev_idx(th.m_axiom_fresh_idx) {
+                th.m_axiom_term = term;
+                th.m_axiom_fresh_idx = 0;
+            }
+            ~axiom_fresh_vars_scope() {
+                th.m_axiom_term = prev_term;
+                th.m_axiom_fresh_idx = prev_idx;
+            }
+        };
         /**
          * @brief Create a fresh Z3 int variable with a given @p name followed by a unique suffix.
          *
@@ -193,6 +532,7 @@ namespace smt::noodler {
          * Uses mapping var_name, those variables v that are mapped are assumed to be string variables
          * and will be transformed into (str.len v) while other variables (which are probably created
          * during preprocessing/decision procedure) are taken as int variables.
+         * The formula is simplified by m_rewrite, whose cache is kept across scopes.
          */
         expr_ref len_node_to_z3_formula(const LenNode& len_formula);
 
@@ -212,6 +552,40 @@ namespace smt::noodler {
         void add_axiom(std::vector<literal> ls);
 
         // methods for rewriting different predicates into something simpler that we can handle
+        /**
+         * @brief Is @p n a term whose axiomatization can be postponed to final_check_eh (see m_params.m_lazy_axioms)?
+         */
+        bool is_lazily_axiomatized(app *n) const {
+            return m_util_s.str.is_at(n) || m_util_s.str.is_extract(n) || m_util_s.str.is_prefix(n) || m_util_s.str.is_suffix(n) ||
+                   m_util_s.str.is_index(n) || m_util_s.str.is_replace(n);
+        }
+        /**
+         * @brief Add the axioms of term @p n (see is_lazily_axiomatized).
+         */
+        void axiomatize_term(app *n);
+        /**
+         * @brief Axiomatize the postponed terms that are still relevant (see m_params.m_lazy_axioms).
+         * @return Whether some new term was axiomatized.
+         */
+        bool axiomatize_lazy_terms();
+        /**
+         * @brief Cheap check of the membership @p membership of m_membership_todo during the search (see
+         * m_params.m_search_propagation).
+         *
+         * If the membership is positive and its regex is empty, or the intersection of the memberships of its variable
+         * assigned so far is empty, a conflict clause is added. If the variable is length-sensitive, the length of its
+         * words is bounded from below by the shortest words of the regex (and restricted by its lengths, see
+         * propagate_membership_lengths()).
+         */
+        void propagate_membership(const expr_pair_flag& membership);
+        /**
+         * @brief Add the axiom that the positive membership (literal @p memb_lit) of @p var in @p re implies that the
+         * length of @p var is one of the lengths of words of @p re (a disjunction of c1 + k*c2, k >= 0).
+         *
+         * The axiom is added only if the automaton of @p re is small and its lengths are given by few disjuncts, so that
+         * the arithmetic solver gets them before the final check.
+         */
+        void propagate_membership_lengths(const expr_ref& var, app* re, literal memb_lit);
         void handle_char_at(expr *e);
         void handle_substr(expr *e);
         void handle_substr_int(expr *e);
@@ -229,6 +603,7 @@ namespace smt::noodler {
         void handle_conversion(expr *e);
         void handle_lex_leq(expr *e);
         void handle_lex_lt(expr *e);
+        bool handle_lex_literal(expr *e, expr *x, expr *y, bool strict);
 
         // methods for assigning boolean values to predicates
         void assign_not_contains(expr *e);
@@ -243,8 +618,13 @@ namespace smt::noodler {
          * @param init Is it an initial string formula (formula from input)?
          * @param neg Is the formula under negation?
          * @param var_lengths Introduce lengths axioms for variables of the form x = eps -> |x| = 0? 
+         * @param inner_concat Is @p ex an argument of a concatenation (whose length axiom covers the length of @p ex)?
+         */
+        void string_theory_propagation(expr * ex, bool init = false, bool neg = false, bool var_lengths = false, bool inner_concat = false);
+        /**
+         * Creates axiom |x_1...x_n| = |x_1| + ... + |x_n| for concatenation @p cat, where x_1, ..., x_n are the
+         * arguments of the nested concatenations of @p cat, if it was not created yet.
          */
-        void string_theory_propagation(expr * ex, bool init = false, bool neg = false, bool var_lengths = false);
         void propagate_concat_axiom(enode * cat);
         void propagate_basic_string_axioms(enode * str, bool var_lengths = false);
 
@@ -278,16 +658,60 @@ namespace smt::noodler {
          * Extract symbols from a given expression @p ex. Append to the output parameter @p alphabet.
          * @param[in] ex Expression to be checked for symbols.
          * @param[out] alphabet A set of symbols with where found symbols are appended to.
+         * @param[out] ranges If not nullptr, symbols of regex ranges are not added to @p alphabet, but the ranges
+         * (pairs of the first and the last symbol) are appended to @p ranges.
          */
-        void extract_symbols(expr * ex, std::set<uint32_t>& alphabet);
+        void extract_symbols(expr * ex, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>* ranges = nullptr);
+
+        /**
+         * Recursive part of extract_symbols(), the ranges are always appended to @p ranges.
+         */
+        void collect_symbols(expr * ex, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>& ranges);
+
+        /**
+         * Sorts @p ranges and merges the overlapping and adjacent ones, i.e. returns the sorted interval set
+         * of the symbols of @p ranges.
+         */
+        static std::vector<std::pair<uint32_t,uint32_t>> normalize_ranges(std::vector<std::pair<uint32_t,uint32_t>> ranges);
+
+        /**
+         * Adds all symbols of @p ranges to @p alphabet, each symbol of overlapping ranges is inserted only once.
+         */
+        static void add_range_symbols(std::set<uint32_t>& alphabet, const std::vector<std::pair<uint32_t,uint32_t>>& ranges);
+
+        /**
+         * Adds to @p alphabet @p num_representatives symbols (or all symbols of smaller classes) for each class
+         * of symbols from @p ranges that cannot be distinguished by the formula (the minterms of the ranges), i.e.
+         * the symbols of the class are not in @p alphabet and occur in the same ranges. Replacing each symbol
+         * by a representative of its class preserves the languages of the regexes and literals, which is enough if
+         * there are no not contains and conversions. For n disequations, n+1 representatives are enough
+         * (the symbols distinguishing the sides of the disequations can be chosen to be different).
+         * @param[in,out] alphabet Symbols that occur explicitly in the formula.
+         * @param[in] ranges Ranges of symbols occuring in regexes.
+         */
+        static void add_range_class_representatives(std::set<uint32_t>& alphabet, const std::vector<std::pair<uint32_t,uint32_t>>& ranges,
+                                                    unsigned num_representatives = 1);
+
+        /**
+         * Extract symbols of the regex @p re to @p alphabet for the computations with its automaton during the
+         * search (only the languages of the regexes are needed, so the symbols of ranges are represented by
+         * the classes of add_range_class_representatives() if m_params.m_alphabet_classes is set).
+         */
+        void extract_regex_symbols(expr* re, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>& ranges);
 
         /**
         Convert (dis)equation @p ex to the instance of Predicate. As a side effect updates mapping of
         variables (BasicTerm) to the corresponding z3 expr.
         @param ex Z3 expression to be converted to Predicate.
+        @param replaced If not nullptr, the terms of predicate_replace used by the conversion (with their replacements) are appended to it.
         @return Instance of predicate
         */
-        Predicate conv_eq_pred(app* expr);
+        Predicate conv_eq_pred(app* ex, std::vector<std::pair<expr*, expr*>>* replaced = nullptr);
+        /**
+         * @brief Convert the word equation (if @p is_equation) or disequation of @p lhs and @p rhs to the instance of
+         * Predicate, the conversions are memoized in m_pred_convs.
+         */
+        Predicate conv_eq_pred_cached(expr* lhs, expr* rhs, bool is_equation);
         /**
          * @brief Creates noodler formula containing relevant word equations and disequations
          */
@@ -325,7 +749,8 @@ namespace smt::noodler {
         bool solve_lang_eqs_diseqs();
         /**
          * Solve the problem using underapproximating decision procedure, if it returns l_true,
-         * the original formula is SAT, otherwise we need to run normal decision procedure.
+         * the original formula is SAT, otherwise we need to run normal decision procedure. Returns l_undef if
+         * the budget or the resource limit stopped the procedure (or a length check was undecided).
          */
         lbool solve_underapprox(const Formula& instance, const AutAssignment& aut_ass,
                                 const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
@@ -334,10 +759,43 @@ namespace smt::noodler {
         /**
          * @brief Check if the length formula @p len_formula is satisfiable with the existing length constraints.
          * 
-         * @param[out] unsat_core If this parameter is NOT nullptr, the LIA solver stores here unsat core of 
-         * the current @p len_formula. If the parameter is nullptr, the unsat core is not computed.
+         * @param[out] unsat_core If this parameter is NOT nullptr, the conjunction of the relevant assignments and
+         * conjuncts of @p len_formula in the unsat core (computed via assumptions in @p m_len_session) is conjoined
+         * to it. If the parameter is nullptr, the unsat core is not computed.
          */
         lbool check_len_sat(expr_ref len_formula, expr_ref* unsat_core=nullptr);
+        /**
+         * @brief Weaken the length formula @p len_formula of a solution, which is unsatisfiable with the existing
+         * length constraints, before it is blocked.
+         *
+         * The result is the conjunction of the (top-level) conjuncts of @p len_formula in its unsat core. It is
+         * implied by @p len_formula, so the blocking lemma (the string constraints imply one of the blocked formulas)
+         * stays valid, and it is still unsatisfiable with the conflicting constraints. If the unsat core cannot be
+         * computed or it does not contain any conjunct of @p len_formula, @p len_formula is returned.
+         */
+        expr_ref weaken_blocked_len(expr_ref len_formula);
+        /**
+         * @brief Do the length checks need relevant assignments of the context? They are not needed
+         * if we solve only regular constraints.
+         */
+        bool len_check_needs_assignments() const;
+        /**
+         * @brief Get the budget for the decision procedure in one final check (given by parameters str.fc_*).
+         */
+        DecisionProcedureBudget get_fc_budget() const;
+        /**
+         * @brief Add statistics @p dp_stats of one run of the decision procedure to m_stats.
+         */
+        void add_dec_proc_stats(const DecisionProcedureStats& dp_stats, const DecisionProcedureStats& already_added = {});
+
+        /**
+         * @brief Get the decision procedure for the given input, either the one from the previous final check
+         * (if it has the same input, see resumable_dec_proc) or a new preprocessed and initialized one.
+         */
+        resumable_dec_proc& get_resumable_dec_proc(const Formula& instance, const AutAssignment& aut_assignment,
+                                                   const std::set<mata::Symbol>& symbols_in_formula,
+                                                   const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                                   const std::vector<TermConversion>& conversions);
 
         /**
          * @brief Blocks current SAT assignment for given @p len_formula
@@ -351,23 +809,78 @@ namespace smt::noodler {
         void block_curr_len(expr_ref len_formula, bool add_axiomatized = true, bool init_lengths = false);
 
         /**
-         * @brief Checks if the current instance is suitable for Nielsen decision procedure.
-         * 
-         * @param instance Current instance converted to Formula
-         * @param init_length_sensitive_vars Length variables
-         * @return true <-> suitable for Nielsen-based decision procedure
+         * @brief Try to restrict the relevant constraints to a smaller part that is unsatisfiable on its own.
+         *
+         * The relevant word (dis)equations and memberships are split into independent components (components
+         * do not share variables) and at most @p max_checks smallest components are checked by the decision
+         * procedure. If some of them is unsatisfiable, *_todo_rel are restricted to it, so that block_curr_len
+         * blocks only the constraints that are needed for the (string) conflict.
+         *
+         * @return true -> *_todo_rel were restricted to an unsatisfiable component
+         */
+        bool restrict_relevant_to_unsat_component(unsigned max_checks = 4);
+        /**
+         * @brief Write the input of the decision procedure of the current final check to a new file in
+         * m_params.m_record_dir (see RecordedInstance), so that it can be replayed offline.
+         */
+        void record_instance(const Formula& instance, const AutAssignment& aut_assignment, const std::set<mata::Symbol>& symbols,
+                             const std::unordered_set<BasicTerm>& init_length_sensitive_vars, const std::vector<TermConversion>& conversions);
+        /**
+         * @brief Remove constraints from the unsatisfiable relevant constraints while they stay unsatisfiable.
+         *
+         * The relevant word (dis)equations and memberships are unsatisfiable (ignoring the lengths). Each of them
+         * is removed if the remaining ones are still unsatisfiable, at most @p max_checks removals are tried. The
+         * blocking clause of the remaining constraints then contains fewer literals (and unsat cores are smaller).
+         * If a check exceeds the budget of the final check or the resource limit, the unshrunk constraints are kept.
+         *
+         * @return Number of removed constraints
          */
-        bool is_nielsen_suitable(const Formula& instance, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) const;
+        unsigned shrink_relevant_unsat_core(unsigned max_checks);
+        /**
+         * @brief Solve the independent components of the relevant constraints separately.
+         *
+         * The relevant word (dis)equations and memberships are split into components that do not share variables.
+         * Components containing a variable whose length occurs in the arithmetic are linked through the lengths, so
+         * they are kept together. Each other component is solved by the decision procedure on its own, a component
+         * is solved only by a solution whose length formula holds (see solve_relevant_strings()). The solved
+         * components are removed from *_todo_rel, the remaining ones are left for the rest of the final check.
+         *
+         * @return l_false -> some component is unsatisfiable (*_todo_rel are restricted to it, so that it can be
+         * blocked), l_true -> all constraints were solved, l_undef -> *_todo_rel contain the remaining constraints
+         */
+        lbool solve_independent_components();
+        /**
+         * @brief Components of the relevant word (dis)equations and memberships (numbered as equations, then
+         * disequations and then memberships) that do not share variables, sorted from the smallest one.
+         */
+        std::vector<relevant_component> get_relevant_components() const;
+        /**
+         * @brief Set *_todo_rel to the constraints @p constraints (numbered as in get_relevant_components())
+         * from @p word_eqs, @p word_diseqs and @p memberships.
+         */
+        void set_relevant_constraints(const std::vector<unsigned>& constraints, const vector<expr_pair>& word_eqs,
+                                      const vector<expr_pair>& word_diseqs, const vector<expr_pair_flag>& memberships);
+        /**
+         * @brief Check if relevant word (dis)equations and memberships have a solution, ignoring the lengths.
+         *
+         * If @p check_lengths is true, l_true is returned only for a solution whose length formula is satisfiable
+         * (see check_len_sat), if the length formulas of all solutions are refuted, the result is l_undef.
+         * The decision procedure gets the budget of the final check (see get_fc_budget()), if it is exceeded, the
+         * result is l_undef and @p budget_exceeded (if not nullptr) is set.
+         */
+        lbool solve_relevant_strings(bool check_lengths = false, bool* budget_exceeded = nullptr);
 
         /**
-         * @brief Check if the current instance is suitable for underapproximation.
+         * @brief Get the features of the current instance deciding which procedures are suitable for it
+         * (see ProcedureSelector).
          * 
          * @param instance Current instance converted to Formula
          * @param aut_ass Current automata assignment
-         * @param convs String-Int conversions
-         * @return true <-> suitable for underapproximation
+         * @param init_length_sensitive_vars Length variables
+         * @return Features of the instance together with the relevant constraints that are not in @p instance
          */
-        bool is_underapprox_suitable(const Formula& instance, const AutAssignment& aut_ass, const std::vector<TermConversion>& convs) const;
+        InstanceFeatures get_instance_features(const Formula& instance, const AutAssignment& aut_ass,
+                                               const std::unordered_set<BasicTerm>& init_length_sensitive_vars) const;
 
         /**
          * @brief Checks if the relevant predicates are suitable for multiple membership heuristic
@@ -389,6 +902,37 @@ namespace smt::noodler {
          */
         lbool run_nielsen(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars);
 
+        /**
+         * @brief Wrapper for running the bounded-length SAT encoding (see BoundedStringProcedure).
+         *
+         * @param instance Formula instance
+         * @param aut_assignment Current automata assignment
+         * @param init_length_sensitive_vars Length sensitive variables
+         * @return lbool Outcome of the procedure
+         */
+        lbool run_bounded(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars);
+
+        /**
+         * @brief Wrapper for running the stochastic local search (see SlsDecisionProcedure). The lengths of the
+         * variables are fixed to their values in the arithmetic of the context.
+         *
+         * @param instance Formula instance
+         * @param aut_assignment Current automata assignment
+         * @param init_length_sensitive_vars Length sensitive variables
+         * @param symbols Symbols of the formula
+         * @return lbool l_true if words of all variables were found (they are kept in m_sls_words), l_undef otherwise
+         */
+        lbool run_sls(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                      const std::set<mata::Symbol>& symbols);
+        /**
+         * @brief Lengths of the string variables of @p aut_assignment fixed by the arithmetic of the context.
+         */
+        std::map<BasicTerm, unsigned> get_ctx_lengths(const AutAssignment& aut_assignment);
+        /**
+         * @brief Store the words of the solution of @p sls to m_sls_words.
+         */
+        void set_sls_words(const SlsDecisionProcedure& sls, const std::set<mata::Symbol>& symbols);
+
         /**
          * @brief Wrapper for running the length-based decision procedure.
          * 
@@ -414,6 +958,42 @@ namespace smt::noodler {
          * @return lbool Outcome of the heuristic procedure.
          */
         lbool run_mult_membership_heur();
+
+        /**
+         * @brief Check whether the intersection of the language of @p positive (sigma star if nullptr) with the complement
+         * of the language of @p negative_union (sigma star if nullptr) over @p alph is empty.
+         *
+         * The complement is never constructed explicitly, the check is an inclusion (or universality) check of @p positive
+         * in @p negative_union, which determinizes @p negative_union on the fly with antichain pruning.
+         * At least one of the automata must not be nullptr.
+         */
+        static bool is_difference_empty(const std::shared_ptr<const mata::nfa::Nfa>& positive,
+                                        const std::shared_ptr<const mata::nfa::Nfa>& negative_union, const regex::Alphabet& alph);
+
+        /**
+         * @brief Get a small subset of the regexes of one variable whose intersection is empty.
+         *
+         * The intersection of the regexes @p conflict (indices to @p list_of_regexes, tuples of complement flag, regex
+         * and the number of the constraint, see set_relevant_constraints()) is empty. The regexes are then removed one
+         * by one while the intersection of the rest stays empty (only if there are at most @p max_size of them,
+         * otherwise all of them are kept).
+         *
+         * @return Sorted numbers of the constraints of the remaining regexes
+         */
+        std::vector<unsigned> get_mult_membership_conflict(const std::vector<std::tuple<bool,app*,unsigned>>& list_of_regexes,
+                                                           std::vector<unsigned> conflict, const regex::Alphabet& alph, unsigned max_size = 16);
+
+        /**
+         * @brief Get regexes of one variable whose intersection is empty (indices to @p list_of_regexes, see
+         * get_mult_membership_conflict()), or no regexes if the intersection of all of them is not empty.
+         *
+         * The positive regexes (automata @p nfas) are intersected and the negative ones united in balanced trees,
+         * the complements are not constructed (see is_difference_empty()). Does not use the state of the theory,
+         * so it can be run for more variables concurrently.
+         */
+        static std::vector<unsigned> get_empty_membership_intersection(const std::vector<std::tuple<bool,app*,unsigned>>& list_of_regexes,
+                                                                       const std::vector<std::shared_ptr<const mata::nfa::Nfa>>& nfas,
+                                                                       const regex::Alphabet& alph);
         
         /**
          * @brief Wrapper for running the length-based decision procedure.
@@ -425,6 +1005,41 @@ namespace smt::noodler {
          */
         lbool run_length_proc(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars);
 
+        /**
+         * @brief Iterative deepening of the underapproximation of conversions for the current solution of @p dec_proc,
+         * whose lengths were unsat: the maximum length of digit words is doubled up to m_params.m_underapprox_length_max
+         * (one round for each length) while the lengths stay unsat. The automata of the solution are reused in all rounds.
+         * A round longer than m_params.m_underapprox_round_time stops the deepening and the following solutions then
+         * use the previous length.
+         * 
+         * @param dec_proc The decision procedure, the length is kept for its following solutions
+         * @param[in,out] solution_lengths The lengths of the current solution (replaced by the lengths from the last round)
+         * @param[out] lengths The lengths from the last round converted to a formula
+         * @return lbool Satisfiability of the lengths from the last round (l_false if there was no round)
+         */
+        lbool deepen_underapprox(DecisionProcedure& dec_proc, std::pair<LenNode, LenNodePrecision>& solution_lengths, expr_ref& lengths);
+
+#ifndef SINGLE_THREAD
+        /**
+         * @brief Run the suitable procedures tried before the main decision procedure (length-based procedure, Nielsen
+         * transformation and underapproximation) concurrently, each on its own thread with its own copy of the automata.
+         *
+         * The procedures only compute solutions, their length constraints are checked (by the length solver of the
+         * context) on the calling thread as they come. The first definitive answer is used and the other procedures
+         * are cancelled.
+         * 
+         * @param instance Formula instance
+         * @param aut_assignment Current automata assignment
+         * @param init_length_sensitive_vars Length sensitive variables
+         * @param conversions String-Int conversions
+         * @param features Features of the instance (the procedures suitable for them are run)
+         * @return lbool Outcome of the portfolio (l_undef if no procedure decided the instance)
+         */
+        lbool run_portfolio(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                            const std::vector<TermConversion>& conversions, const std::set<mata::Symbol>& symbols,
+                            const InstanceFeatures& features);
+#endif
+
         /**
          * @brief Wrapper for running the loop protection.
          * 
@@ -432,6 +1047,20 @@ namespace smt::noodler {
          */
         lbool run_loop_protection();
 
+        /**
+         * @brief Get the fingerprint of the relevant constraints (*_todo_rel and conversions).
+         */
+        std::unique_ptr<relevant_fingerprint> get_relevant_fingerprint();
+
+        /**
+         * @brief If the relevant constraints are the same as in the last final check that returned FC_DONE
+         * (m_last_done_fingerprint), only the arithmetic might have changed, so the stored length formula is
+         * checked against the current arithmetic in the length session.
+         *
+         * @return l_true if the stored length formula is still satisfied, l_undef otherwise
+         */
+        lbool run_repeated_final_check();
+
         /**
          * @brief Run length-based satisfiability checking.
          * 
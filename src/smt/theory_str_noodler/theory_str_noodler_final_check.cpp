@@ -1,8 +1,22 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#ifndef SINGLE_THREAD
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
 #include <mata/nfa/builder.hh>
+#include "ast/ast_pp_util.h"
 #include "smt/theory_str_noodler/theory_str_noodler.h"
+#include "smt/theory_str_noodler/profile_markers.h"
 
 namespace smt::noodler {
-    Predicate theory_str_noodler::conv_eq_pred(app* const ex) {
+    Predicate theory_str_noodler::conv_eq_pred(app* const ex, std::vector<std::pair<expr*, expr*>>* replaced) {
         STRACE("str-conv-eq", tout << "conv_eq_pred: " << mk_pp(ex, m) << std::endl);
         const app* eq = ex;
         PredicateType ptype = PredicateType::Equation;
@@ -25,23 +39,64 @@ namespace smt::noodler {
         }
 
         std::vector<BasicTerm> left, right;
-        util::collect_terms(to_app(eq->get_arg(0)), m, this->m_util_s, this->predicate_replace, this->var_name, left);
-        util::collect_terms(to_app(eq->get_arg(1)), m, this->m_util_s, this->predicate_replace, this->var_name, right);
+        util::collect_terms(to_app(eq->get_arg(0)), m, this->m_util_s, this->predicate_replace, this->var_name, left, replaced);
+        util::collect_terms(to_app(eq->get_arg(1)), m, this->m_util_s, this->predicate_replace, this->var_name, right, replaced);
 
         return Predicate(ptype, std::vector<std::vector<BasicTerm>>{left, right});
     }
 
+    Predicate theory_str_noodler::conv_eq_pred_cached(expr* lhs, expr* rhs, bool is_equation) {
+        const PredicateType ptype = is_equation ? PredicateType::Equation : PredicateType::Inequation;
+        unsigned idx;
+        const bool found = m_pred_conv_index.find(lhs, rhs, idx);
+        if (found) {
+            // the variables of the conversion are already in var_name (which is never cleared), but the replaced
+            // terms could have been axiomatized again with other variables
+            const pred_conversion& conv = m_pred_convs[idx];
+            const bool valid = std::all_of(conv.replaced.begin(), conv.replaced.end(), [&](const std::pair<expr*, expr*>& r) {
+                expr* rpl = nullptr;
+                return predicate_replace.find(r.first, rpl) && rpl == r.second;
+            });
+            if (valid) {
+                return conv.pred.get_type() == ptype ? conv.pred : Predicate(ptype, conv.pred.get_params());
+            }
+        }
+
+        app_ref atom(ctx.mk_eq_atom(lhs, rhs), m);
+        if (!is_equation) {
+            atom = m.mk_not(atom);
+        }
+        pred_conversion conv{ Predicate(), {}, expr_ref_vector(m) };
+        conv.pred = conv_eq_pred(atom, &conv.replaced);
+        conv.pinned.push_back(lhs);
+        conv.pinned.push_back(rhs);
+        for (const auto& [replaced_term, replacement] : conv.replaced) {
+            conv.pinned.push_back(replaced_term);
+            conv.pinned.push_back(replacement);
+        }
+        Predicate res = conv.pred;
+        if (found) {
+            m_pred_convs[idx] = std::move(conv);
+        } else {
+            if (m_pred_convs.size() >= MAX_PRED_CONVERSIONS) {
+                m_pred_conv_index.reset();
+                m_pred_convs.clear();
+            }
+            m_pred_conv_index.insert(lhs, rhs, m_pred_convs.size());
+            m_pred_convs.push_back(std::move(conv));
+        }
+        return res;
+    }
+
     Formula theory_str_noodler::get_word_formula_from_relevant() {
         Formula instance;
 
         for (const auto &we: this->m_word_eq_todo_rel) {
-            Predicate inst = this->conv_eq_pred(ctx.mk_eq_atom(we.first, we.second));
-            instance.add_predicate(inst);
+            instance.add_predicate(this->conv_eq_pred_cached(we.first, we.second, true));
         }
 
         for (const auto& wd : this->m_word_diseq_todo_rel) {
-            Predicate inst = this->conv_eq_pred(m.mk_not(ctx.mk_eq_atom(wd.first, wd.second)));
-            instance.add_predicate(inst);
+            instance.add_predicate(this->conv_eq_pred_cached(wd.first, wd.second, false));
         }
 
         // construct not contains predicates
@@ -60,25 +115,38 @@ namespace smt::noodler {
         // start with symbol representing everything not in formula
         std::set<mata::Symbol> symbols_in_formula{get_dummy_symbol()};
 
+        // symbols of ranges that cannot be distinguished can be represented by a few symbols (see add_range_class_representatives),
+        // but not contains and conversions need the exact symbols (ranges of all constraints are collected first, so that
+        // the symbols of a range occurring many times are added only once)
+        std::vector<std::pair<uint32_t,uint32_t>> ranges;
+        const bool use_range_classes = m_params.m_alphabet_classes && m_not_contains_todo_rel.empty() && m_conversion_todo.empty();
+
         for (const auto &word_equation: m_word_eq_todo_rel) {
-            extract_symbols(word_equation.first, symbols_in_formula);
-            extract_symbols(word_equation.second, symbols_in_formula);
+            extract_symbols(word_equation.first, symbols_in_formula, &ranges);
+            extract_symbols(word_equation.second, symbols_in_formula, &ranges);
         }
 
         for (const auto &word_disequation: m_word_diseq_todo_rel) {
-            extract_symbols(word_disequation.first, symbols_in_formula);
-            extract_symbols(word_disequation.second, symbols_in_formula);
+            extract_symbols(word_disequation.first, symbols_in_formula, &ranges);
+            extract_symbols(word_disequation.second, symbols_in_formula, &ranges);
         }
 
         for (const auto &membership: m_membership_todo_rel) {
-            extract_symbols(std::get<1>(membership), symbols_in_formula);
+            extract_symbols(std::get<1>(membership), symbols_in_formula, &ranges);
         }
         // extract from not contains
         for(const auto& not_contains : m_not_contains_todo_rel) {
-            extract_symbols(not_contains.first, symbols_in_formula);
-            extract_symbols(not_contains.second, symbols_in_formula);
+            extract_symbols(not_contains.first, symbols_in_formula, &ranges);
+            extract_symbols(not_contains.second, symbols_in_formula, &ranges);
+        }
+
+        if (use_range_classes) {
+            add_range_class_representatives(symbols_in_formula, ranges, m_word_diseq_todo_rel.size() + 1);
+        } else {
+            add_range_symbols(symbols_in_formula, ranges);
         }
 
+        m_nfa_cache.notify_alphabet(symbols_in_formula);
         return symbols_in_formula;
     }
 
@@ -86,9 +154,12 @@ namespace smt::noodler {
             const Formula& instance,
             const std::set<mata::Symbol>& noodler_alphabet
     ) {
+        NOODLER_PHASE("aut-assignment");
         AutAssignment aut_assignment{};
         aut_assignment.set_alphabet(noodler_alphabet);
         regex::Alphabet alph(noodler_alphabet);
+        // memberships with the same regex (and polarity) share one interned automaton, it is created only once
+        std::map<std::pair<const app*, bool>, std::shared_ptr<mata::nfa::Nfa>> membership_auts;
         for (const auto &word_equation: m_membership_todo_rel) {
             const expr_ref& var_expr{ std::get<0>(word_equation) };
             assert(is_app(var_expr));
@@ -100,29 +171,41 @@ namespace smt::noodler {
             BasicTerm term{ BasicTermType::Variable, variable_name };
             if(m_util_s.str.is_string(var_app, s)) {
                 term = BasicTerm(BasicTermType::Literal, s.encode());
+                // the membership of a literal is decided without building the automaton if possible
+                lbool is_member = m_membership_cache.is_member(s, to_app(std::get<1>(word_equation)), m_util_s, m, m_rewrite);
+                if (is_member != l_undef) {
+                    if ((is_member == l_true) != std::get<2>(word_equation)) {
+                        // the literal violates the membership, it gets the empty language
+                        aut_assignment[term] = m_aut_pool.intern(mata::nfa::Nfa());
+                        this->var_name.insert({term, var_expr});
+                    }
+                    // otherwise the literal gets the automaton accepting only itself below
+                    continue;
+                }
             }
             // If the regular constraint is in a negative form, create a complement of the regular expression instead.
             const bool make_complement{ !std::get<2>(word_equation) };
-            mata::nfa::Nfa nfa{ regex::conv_to_nfa(to_app(std::get<1>(word_equation)), m_util_s, m, alph, make_complement, make_complement) };
+            const app* regex = to_app(std::get<1>(word_equation));
+            std::shared_ptr<mata::nfa::Nfa>& nfa = membership_auts[{regex, make_complement}];
+            if (!nfa) {
+                // the cached NFA is const, the assignment gets the interned copy
+                nfa = m_aut_pool.intern(*m_nfa_cache.get_nfa(regex, m_util_s, m, alph, make_complement, make_complement));
+            }
             auto aut_ass_it{ aut_assignment.find(term) };
             if (aut_ass_it != aut_assignment.end()) {
                 // This variable already has some regular constraints. Hence, we create an intersection of the new one
                 //  with the previously existing.
-                aut_ass_it->second = std::make_shared<mata::nfa::Nfa>(
-                        mata::nfa::reduce(mata::nfa::intersection(nfa, *aut_ass_it->second)));
+                aut_ass_it->second = m_aut_pool.get_intersection(nfa, aut_ass_it->second);
 
             } else { // We create a regular constraint for the current variable for the first time.
-                aut_assignment[term] = std::make_shared<mata::nfa::Nfa>(std::forward<mata::nfa::Nfa>(std::move(nfa)));
+                aut_assignment[term] = nfa;
                 // TODO explain after this function is moved to theory_str_noodler, we do this because var_name contains only variables occuring in instance and not those that occur only in str.in_re
                 this->var_name.insert({term, var_expr});
             }
         }
 
-        // create sigma star automaton for our alphabet
-        mata::EnumAlphabet mata_alphabet(noodler_alphabet.begin(), noodler_alphabet.end());
-        auto nfa_sigma_star = std::make_shared<mata::nfa::Nfa>(mata::nfa::builder::create_sigma_star_nfa(&mata_alphabet));
-        // remove the pointer to alphabet in the automaton, as it points to local variable (and we have the alphabet in aut_assignment)
-        nfa_sigma_star->alphabet = nullptr;
+        // sigma star automaton for our alphabet (shared, without the pointer to alphabet, as we have the alphabet in aut_assignment)
+        auto nfa_sigma_star = m_aut_pool.get_sigma_star(noodler_alphabet);
 
         // some variables/literals are not assigned to anything yet, we need to fix that
         for (const auto &pred : instance.get_predicates()) {
@@ -134,8 +217,7 @@ namespace smt::noodler {
                     } else if (var_or_literal.is_literal()) {
                         // to string literals. assign automaton accepting the word denoted by the literal
                         // TODO if Z3 can give us `string literal in RE` then we should check if aut_assignment does not contain this literal already (if yes, do intersection)
-                        mata::nfa::Nfa nfa{ AutAssignment::create_word_nfa(var_or_literal.get_name()) };
-                        aut_assignment.emplace(var_or_literal, std::make_shared<mata::nfa::Nfa>(std::move(nfa)));
+                        aut_assignment.emplace(var_or_literal, m_aut_pool.get_word(var_or_literal.get_name()));
                     }
                 }
             }
@@ -163,9 +245,8 @@ namespace smt::noodler {
     }
 
     std::vector<TermConversion> theory_str_noodler::get_conversions_as_basicterms(AutAssignment& ass, const std::set<mata::Symbol>& noodler_alphabet) {
-        mata::EnumAlphabet mata_alphabet(noodler_alphabet.begin(), noodler_alphabet.end());
-        auto nfa_sigma_star = std::make_shared<mata::nfa::Nfa>(mata::nfa::builder::create_sigma_star_nfa(&mata_alphabet));
-        
+        auto nfa_sigma_star = m_aut_pool.get_sigma_star(noodler_alphabet);
+
         std::vector<TermConversion> conversions;
         for (const auto& transf : m_conversion_todo) {
             BasicTerm result(BasicTermType::Variable, to_app(std::get<0>(transf))->get_decl()->get_name().str());
@@ -198,17 +279,27 @@ namespace smt::noodler {
             );
 
             // get symbols from both sides
+            // (only the languages are compared, so the symbols of ranges can be represented by their classes)
             std::set<uint32_t> alphabet;
-            extract_symbols(left_side, alphabet);
-            extract_symbols(right_side, alphabet);
+            std::vector<std::pair<uint32_t,uint32_t>> ranges;
+            extract_regex_symbols(left_side, alphabet, ranges);
+            extract_regex_symbols(right_side, alphabet, ranges);
+            add_range_class_representatives(alphabet, ranges);
             regex::Alphabet alph(alphabet);
 
-            // construct NFAs for both sides
-            mata::nfa::Nfa nfa1 = regex::conv_to_nfa(to_app(left_side), m_util_s, m, alph, false );
-            mata::nfa::Nfa nfa2 = regex::conv_to_nfa(to_app(right_side), m_util_s, m, alph, false );
-
-            // check if NFAs are equivalent (if we have equation) or not (if we have disequation)
-            bool are_equiv = mata::nfa::are_equivalent(nfa1, nfa2);
+            // check if the languages are equivalent (if we have equation) or not (if we have disequation),
+            // the result for the same regexes and alphabet is cached
+            std::vector<mata::Symbol> witness;
+            bool are_equiv = m_nfa_cache.are_equivalent(to_app(left_side), to_app(right_side), m_util_s, m, alph, &witness);
+            STRACE("str",
+                if (!are_equiv) {
+                    tout << "word in exactly one of the languages:";
+                    for (mata::Symbol s : witness) {
+                        tout << " " << s;
+                    }
+                    tout << std::endl;
+                }
+            );
             if ((is_equation && !are_equiv) || (!is_equation && are_equiv)) {
                 // the language (dis)equation does not hold => block it and return
                 app_ref lang_eq(m.mk_eq(left_side, right_side), m);
@@ -231,18 +322,153 @@ namespace smt::noodler {
                                                 const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
                                                 std::vector<TermConversion> conversions) {
         DecisionProcedure dec_proc = DecisionProcedure{ instance, aut_assignment, init_length_sensitive_vars, m_params, conversions };
-        if (dec_proc.preprocess(PreprocessType::UNDERAPPROX, this->var_eqs.get_equivalence_bt(aut_assignment)) == l_false) {
+        on_scope_exit collect_dec_proc_stats([&]() { add_dec_proc_stats(dec_proc.get_stats()); });
+        dec_proc.set_preprocess_memo(&m_preprocess_memo);
+        dec_proc.set_preprocess_profile(&m_prep_profile);
+        dec_proc.set_literal_store(&m_literal_store);
+        lbool preprocess_result;
+        {
+            scoped_watch preprocess_sw(m_preprocess_watch);
+            NOODLER_PHASE("preprocessing");
+            preprocess_result = dec_proc.preprocess(PreprocessType::UNDERAPPROX, this->var_eqs.get_equivalence_bt(aut_assignment));
+        }
+        if (preprocess_result == l_false) {
             return l_false;
         }
 
         dec_proc.init_computation();
-        while(dec_proc.compute_next_solution() == l_true) {
+        dec_proc.set_budget(get_fc_budget());
+        // l_false only if all solutions were explored and their lengths were refuted
+        lbool result = l_false;
+        lbool solution;
+        while((solution = dec_proc.compute_next_solution()) == l_true) {
             expr_ref lengths = len_node_to_z3_formula(dec_proc.get_lengths().first);
-            if(check_len_sat(lengths) == l_true) {
+            lbool len_result = check_len_sat(lengths);
+            if(len_result == l_true) {
                 return l_true;
             }
+            if(len_result == l_undef) {
+                result = l_undef;
+            }
+        }
+        // the budget or the resource limit stopped the procedure
+        return solution == l_undef ? l_undef : result;
+    }
+
+    lbool theory_str_noodler::deepen_underapprox(DecisionProcedure& dec_proc, std::pair<LenNode, LenNodePrecision>& solution_lengths, expr_ref& lengths) {
+        lbool result = l_false;
+        unsigned length = dec_proc.get_underapprox_length();
+        while (result == l_false && solution_lengths.second == LenNodePrecision::UNDERAPPROX && length < m_params.m_underapprox_length_max) {
+            const unsigned prev_length = length;
+            length = (length == 0) ? 1 : std::min(2 * length, m_params.m_underapprox_length_max);
+            STRACE("str", tout << "Deepening underapproximation of conversions to length " << length << std::endl);
+            ++m_stats.m_num_underapprox_rounds;
+            stopwatch round_watch;
+            round_watch.start();
+            dec_proc.set_underapprox_length(length);
+            solution_lengths = dec_proc.get_lengths();
+            lengths = len_node_to_z3_formula(solution_lengths.first);
+            result = check_len_sat(lengths);
+            if (m_params.m_underapprox_round_time != 0 && round_watch.get_current_seconds() * 1000 > m_params.m_underapprox_round_time) {
+                // the round took too long, the complete procedure should get the time for the following solutions
+                dec_proc.set_underapprox_length(prev_length);
+                break;
+            }
+        }
+        return result;
+    }
+
+    DecisionProcedureBudget theory_str_noodler::get_fc_budget() const {
+        return DecisionProcedureBudget{ m_params.m_fc_time_budget, m_params.m_fc_max_solving_states, m_params.m_fc_max_aut_states, m_params.m_fc_max_memory };
+    }
+
+    bool theory_str_noodler::len_check_needs_assignments() const {
+        // do we solve only regular constraints? If yes, skip other temporary length constraints (they are not necessary)
+        return !(this->m_word_diseq_todo_rel.size() == 0 && this->m_word_eq_todo_rel.size() == 0 && this->m_not_contains_todo.size() == 0 && this->m_conversion_todo.size() == 0);
+    }
+
+    void theory_str_noodler::add_dec_proc_stats(const DecisionProcedureStats& dp_stats, const DecisionProcedureStats& already_added) {
+        m_stats.m_num_noodlifications += dp_stats.num_noodlifications - already_added.num_noodlifications;
+        m_stats.m_num_noodles += dp_stats.num_noodles - already_added.num_noodles;
+        m_stats.m_num_solving_states += dp_stats.num_solving_states - already_added.num_solving_states;
+        m_stats.m_num_inclusion_checks += dp_stats.num_inclusion_checks - already_added.num_inclusion_checks;
+        m_stats.m_num_inclusion_cache_hits += dp_stats.num_inclusion_cache_hits - already_added.num_inclusion_cache_hits;
+        m_stats.m_num_preprocess_passes_skipped += dp_stats.num_preprocess_passes_skipped - already_added.num_preprocess_passes_skipped;
+        m_stats.m_num_preprocess_memo_hits += dp_stats.num_preprocess_memo_hits - already_added.num_preprocess_memo_hits;
+        m_stats.m_num_preprocess_ops_gated += dp_stats.num_preprocess_ops_gated - already_added.num_preprocess_ops_gated;
+        m_stats.m_max_aut_states = std::max(m_stats.m_max_aut_states, dp_stats.max_aut_states);
+        m_stats.m_max_worklist_kb = std::max(m_stats.m_max_worklist_kb, dp_stats.max_worklist_kb);
+        m_stats.m_num_evicted_states += dp_stats.num_evicted_states - already_added.num_evicted_states;
+        m_stats.m_num_witness_inclusions += dp_stats.num_witness_inclusions - already_added.num_witness_inclusions;
+        m_stats.m_num_shared_segments += dp_stats.num_shared_segments - already_added.num_shared_segments;
+        m_stats.m_num_concatenation_memo_hits += dp_stats.num_concatenation_memo_hits - already_added.num_concatenation_memo_hits;
+        m_stats.m_num_nogoods += dp_stats.num_nogoods - already_added.num_nogoods;
+        m_stats.m_num_nogood_pruned_states += dp_stats.num_nogood_pruned_states - already_added.num_nogood_pruned_states;
+        m_stats.m_num_length_pruned_states += dp_stats.num_length_pruned_states - already_added.num_length_pruned_states;
+        m_stats.m_num_model_deferred_states += dp_stats.num_model_deferred_states - already_added.num_model_deferred_states;
+    }
+
+    theory_str_noodler::resumable_dec_proc& theory_str_noodler::get_resumable_dec_proc(const Formula& instance, const AutAssignment& aut_assignment,
+                                                                                       const std::set<mata::Symbol>& symbols_in_formula,
+                                                                                       const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                                                                       const std::vector<TermConversion>& conversions) {
+        BasicTermEqiv len_eq_vars = this->var_eqs.get_equivalence_bt(aut_assignment);
+        auto same_exprs = [](const auto& v1, const auto& v2) {
+            if (v1.size() != v2.size()) {
+                return false;
+            }
+            for (unsigned i = 0; i < v1.size(); ++i) {
+                if (v1[i] != v2[i]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        if (m_last_dec_proc != nullptr
+            && m_last_dec_proc->instance == instance
+            && same_exprs(m_last_dec_proc->memberships, this->m_membership_todo_rel)
+            && same_exprs(m_last_dec_proc->conversions, this->m_conversion_todo)
+            && m_last_dec_proc->symbols == symbols_in_formula
+            && m_last_dec_proc->init_length_sensitive_vars == init_length_sensitive_vars
+            && m_last_dec_proc->len_eq_vars == len_eq_vars
+            // states pruned by the lengths of a previous assignment have to be explored again
+            && !m_last_dec_proc->length_pruned) {
+            STRACE("str", tout << "Resuming decision procedure from the previous final check" << std::endl);
+            return *m_last_dec_proc;
+        }
+
+        auto rdp = std::make_unique<resumable_dec_proc>();
+        rdp->instance = instance;
+        rdp->memberships = this->m_membership_todo_rel;
+        for (const auto& conv : this->m_conversion_todo) {
+            rdp->conversions.push_back(conv);
         }
-        return l_false;
+        rdp->symbols = symbols_in_formula;
+        rdp->init_length_sensitive_vars = init_length_sensitive_vars;
+        rdp->len_eq_vars = len_eq_vars;
+        rdp->dec_proc = alloc(DecisionProcedure, instance, aut_assignment, init_length_sensitive_vars, m_params, conversions);
+        rdp->dec_proc->set_preprocess_memo(&m_preprocess_memo);
+        rdp->dec_proc->set_preprocess_profile(&m_prep_profile);
+        rdp->dec_proc->set_literal_store(&m_literal_store);
+        rdp->dec_proc->set_length_abstraction_cache(&m_len_abstraction_cache);
+
+        STRACE("str", tout << "Starting preprocessing" << std::endl);
+        {
+            scoped_watch preprocess_sw(m_preprocess_watch);
+            NOODLER_PHASE("preprocessing");
+            rdp->preprocess_result = rdp->dec_proc->preprocess(PreprocessType::PLAIN, len_eq_vars);
+        }
+        if (rdp->preprocess_result != l_false) {
+            rdp->initial_lengths = rdp->dec_proc->get_initial_lengths();
+            rdp->dec_proc->init_computation();
+        }
+
+        if (m_last_dec_proc != nullptr) {
+            add_dec_proc_stats(m_last_dec_proc->dec_proc->get_stats(), m_last_dec_proc->reported_stats);
+        }
+        m_last_dec_proc = std::move(rdp);
+        return *m_last_dec_proc;
     }
 
     lbool theory_str_noodler::check_len_sat(expr_ref len_formula, expr_ref* unsat_core) {
@@ -250,31 +476,100 @@ namespace smt::noodler {
             // we assume here that existing length constraints are satisfiable, so adding true will do nothing
             return l_true;
         }
+        ++m_stats.m_num_check_len_sat;
+        scoped_watch check_len_sat_sw(m_check_len_sat_watch);
+        NOODLER_PHASE("length-check");
+        stopwatch event_watch;
+        event_watch.start();
+        auto record_len_check = [&](lbool r) {
+            record_event(EventType::LENGTH_CHECK, static_cast<uint64_t>(static_cast<int64_t>(r)), static_cast<uint64_t>(event_watch.get_current_seconds() * 1000000));
+            return r;
+        };
+
+        bool include_ass = len_check_needs_assignments();
+
+        if(unsat_core == nullptr && m_params.m_len_presolve) {
+            // a refutation of the length formula alone is a refutation together with the context
+            if(LengthPresolver(m).check(len_formula) == l_false) {
+                ++m_stats.m_num_len_presolve_unsat;
+                STRACE("str-lia", tout << "length presolver refuted " << mk_pp(len_formula, m) << std::endl);
+                return record_len_check(l_false);
+            }
+        }
 
-        int_expr_solver m_int_solver(get_manager(), get_context().get_fparams());
-        // do we solve only regular constraints? If yes, skip other temporary length constraints (they are not necessary)
-        bool include_ass = true;
-        if(this->m_word_diseq_todo_rel.size() == 0 && this->m_word_eq_todo_rel.size() == 0 && this->m_not_contains_todo.size() == 0 && this->m_conversion_todo.size() == 0) {
-            include_ass = false;
+        if(unsat_core == nullptr) {
+            // no unsat core needed --> use the persistent session, which keeps the context internalized between calls
+            return record_len_check(m_len_session.check_sat(get_context(), len_formula, include_ass));
         }
-        m_int_solver.initialize(get_context(), include_ass);
-        auto ret = m_int_solver.check_sat(len_formula);
-        // construct an unsat core --> might be expensive
-        // TODO: better interface of m_int_solver
-        if(unsat_core != nullptr) {
-            for(unsigned i=0;i<m_int_solver.m_kernel.get_unsat_core_size();i++){
-                *unsat_core = m.mk_and(*unsat_core, m_int_solver.m_kernel.get_unsat_core_expr(i));
+
+        // the unsat core consists of the assignments and the conjuncts of len_formula assumed by the session
+        expr_ref_vector core(m);
+        lbool ret = m_len_session.check_sat_core(get_context(), len_formula, core, include_ass);
+        if (ret == l_false) {
+            if (!m.is_true(*unsat_core)) {
+                core.push_back(*unsat_core);
             }
+            *unsat_core = m.mk_and(core);
         }
-        return ret;
+        return record_len_check(ret);
+    }
+
+    expr_ref theory_str_noodler::weaken_blocked_len(expr_ref len_formula) {
+        // the conjuncts are flattened in the same way as the session assumes them
+        obj_hashtable<expr> conjuncts;
+        ptr_vector<expr> todo;
+        todo.push_back(len_formula);
+        while (!todo.empty()) {
+            expr* conj = todo.back();
+            todo.pop_back();
+            if (m.is_and(conj)) {
+                todo.append(to_app(conj)->get_num_args(), to_app(conj)->get_args());
+            } else if (!m.is_true(conj)) {
+                conjuncts.insert(conj);
+            }
+        }
+        if (conjuncts.size() <= 1) {
+            return len_formula;
+        }
+
+        expr_ref_vector core(m);
+        if (m_len_session.check_sat_core(get_context(), len_formula, core, len_check_needs_assignments()) != l_false) {
+            return len_formula;
+        }
+        // the core contains also the assignments of the context, only the conjuncts of len_formula are kept
+        expr_ref_vector kept(m);
+        obj_hashtable<expr> seen;
+        for (expr* e : core) {
+            if (conjuncts.contains(e) && !seen.contains(e)) {
+                seen.insert(e);
+                kept.push_back(e);
+            }
+        }
+        if (kept.empty() || kept.size() == conjuncts.size()) {
+            // with no conjunct, the conflict is only in the assignments and true would not block anything
+            return len_formula;
+        }
+        ++m_stats.m_num_len_block_weakened;
+        m_stats.m_num_len_block_dropped += conjuncts.size() - kept.size();
+        STRACE("str-block", tout << "weakened " << mk_pp(len_formula, m) << " to " << kept << std::endl;);
+        return expr_ref(m.mk_and(kept), m);
     }
 
     void theory_str_noodler::block_curr_len(expr_ref len_formula, bool add_axiomatized, bool init_lengths) {
+        NOODLER_PHASE("blocking");
         STRACE("str-block", tout << __LINE__ << " enter " << __FUNCTION__ << std::endl;);
 
         context& ctx = get_context();
 
         ast_manager& m = get_manager();
+        if (m.is_false(len_formula)) {
+            // the conflict is only in the string constraints, maybe some part of them is enough for it
+            restrict_relevant_to_unsat_component();
+            if (m_params.m_core_shrink_checks > 0) {
+                m_stats.m_num_core_shrink_removed += shrink_relevant_unsat_core(m_params.m_core_shrink_checks);
+            }
+        }
+
         expr *refinement = nullptr;
         for (const auto& we : this->m_word_eq_todo_rel) {
             // we create the equation according to we
@@ -305,7 +600,12 @@ namespace smt::noodler {
             refinement = refinement == nullptr ? nc_app : m.mk_and(refinement, nc_app);
         }
         
+        record_event(EventType::BLOCK_LEMMA, this->m_word_eq_todo_rel.size() + this->m_word_diseq_todo_rel.size()
+                                             + this->m_membership_todo_rel.size() + this->m_not_contains_todo_rel.size());
         if(m_params.m_loop_protect && add_axiomatized) {
+            if(refinement != nullptr) {
+                this->axiomatized_instances_index.insert_if_not_there(refinement, {}).push_back(this->axiomatized_instances.size());
+            }
             this->axiomatized_instances.push_back({expr_ref(refinement, this->m), stored_instance{ .lengths = len_formula, .initial_length = init_lengths}});
         }
         if (refinement != nullptr) {
@@ -314,7 +614,280 @@ namespace smt::noodler {
         STRACE("str-block", tout << __LINE__ << " leave " << __FUNCTION__ << std::endl;);
     }
 
-    void theory_str_noodler::extract_symbols(expr* const ex, std::set<uint32_t>& alphabet) {
+    std::vector<theory_str_noodler::relevant_component> theory_str_noodler::get_relevant_components() const {
+        // we number the constraints as equations, then disequations and then memberships
+        const unsigned num_eqs = this->m_word_eq_todo_rel.size();
+        const unsigned num_diseqs = this->m_word_diseq_todo_rel.size();
+        const unsigned num_constraints = num_eqs + num_diseqs + this->m_membership_todo_rel.size();
+
+        // constraints with a common variable are in the same component
+        basic_union_find components;
+        std::map<std::string, unsigned> var_to_constraint;
+        for (unsigned i = 0; i < num_constraints; ++i) {
+            components.mk_var();
+            std::unordered_set<std::string> vars;
+            if (i < num_eqs) {
+                util::get_variable_names(this->m_word_eq_todo_rel[i].first, m_util_s, m, vars);
+                util::get_variable_names(this->m_word_eq_todo_rel[i].second, m_util_s, m, vars);
+            } else if (i < num_eqs + num_diseqs) {
+                util::get_variable_names(this->m_word_diseq_todo_rel[i - num_eqs].first, m_util_s, m, vars);
+                util::get_variable_names(this->m_word_diseq_todo_rel[i - num_eqs].second, m_util_s, m, vars);
+            } else {
+                util::get_variable_names(std::get<0>(this->m_membership_todo_rel[i - num_eqs - num_diseqs]), m_util_s, m, vars);
+            }
+            for (const std::string& var : vars) {
+                auto [it, inserted] = var_to_constraint.insert({var, i});
+                if (!inserted) {
+                    components.merge(it->second, i);
+                }
+            }
+        }
+
+        std::map<unsigned, relevant_component> components_by_root;
+        for (const auto& [var, constraint] : var_to_constraint) {
+            components_by_root[components.find(constraint)].vars.insert(var);
+        }
+        for (unsigned i = 0; i < num_constraints; ++i) {
+            components_by_root[components.find(i)].constraints.push_back(i);
+        }
+        std::vector<relevant_component> sorted_components;
+        for (auto& [root, component] : components_by_root) {
+            sorted_components.push_back(std::move(component));
+        }
+        std::stable_sort(sorted_components.begin(), sorted_components.end(),
+                         [](const auto& c1, const auto& c2) { return c1.constraints.size() < c2.constraints.size(); });
+        return sorted_components;
+    }
+
+    void theory_str_noodler::set_relevant_constraints(const std::vector<unsigned>& constraints, const vector<expr_pair>& word_eqs,
+                                                      const vector<expr_pair>& word_diseqs, const vector<expr_pair_flag>& memberships) {
+        this->m_word_eq_todo_rel.clear();
+        this->m_word_diseq_todo_rel.clear();
+        this->m_membership_todo_rel.clear();
+        for (unsigned i : constraints) {
+            if (i < word_eqs.size()) {
+                this->m_word_eq_todo_rel.push_back(word_eqs[i]);
+            } else if (i < word_eqs.size() + word_diseqs.size()) {
+                this->m_word_diseq_todo_rel.push_back(word_diseqs[i - word_eqs.size()]);
+            } else {
+                this->m_membership_todo_rel.push_back(memberships[i - word_eqs.size() - word_diseqs.size()]);
+            }
+        }
+    }
+
+    bool theory_str_noodler::restrict_relevant_to_unsat_component(unsigned max_checks) {
+        if (!this->m_not_contains_todo_rel.empty() || !this->m_conversion_todo.empty()) {
+            // the decision procedure does not decide not contains and conversions connect string and int variables
+            return false;
+        }
+
+        std::vector<relevant_component> sorted_components = get_relevant_components();
+        if (sorted_components.size() <= 1) {
+            return false;
+        }
+
+        const vector<expr_pair> word_eqs = this->m_word_eq_todo_rel;
+        const vector<expr_pair> word_diseqs = this->m_word_diseq_todo_rel;
+        const vector<expr_pair_flag> memberships = this->m_membership_todo_rel;
+        const unsigned num_constraints = word_eqs.size() + word_diseqs.size() + memberships.size();
+        for (unsigned c = 0; c < sorted_components.size() && c < max_checks && m.inc(); ++c) {
+            set_relevant_constraints(sorted_components[c].constraints, word_eqs, word_diseqs, memberships);
+            bool budget_exceeded = false;
+            if (solve_relevant_strings(false, &budget_exceeded) == l_false) {
+                STRACE("str", tout << "conflict restricted to " << sorted_components[c].constraints.size() << " of " << num_constraints << " constraints" << std::endl;);
+                return true;
+            }
+            if (budget_exceeded) {
+                // the other components are not smaller, so they would likely exceed it too
+                break;
+            }
+        }
+
+        // no smaller conflict was found, we keep all constraints
+        this->m_word_eq_todo_rel = word_eqs;
+        this->m_word_diseq_todo_rel = word_diseqs;
+        this->m_membership_todo_rel = memberships;
+        return false;
+    }
+
+    void theory_str_noodler::record_instance(const Formula& instance, const AutAssignment& aut_assignment, const std::set<mata::Symbol>& symbols,
+                                             const std::unordered_set<BasicTerm>& init_length_sensitive_vars, const std::vector<TermConversion>& conversions) {
+        // instances of all solvers of the process are numbered together, so that they do not overwrite each other
+        static std::atomic<unsigned> num_recorded{0};
+        context& ctx = get_context();
+
+        RecordedInstance record{ instance, symbols, aut_assignment, init_length_sensitive_vars,
+                                 this->var_eqs.get_equivalence_bt(aut_assignment), conversions, "" };
+
+        // the same formulas as are used for checking lengths (see int_expr_session::sync)
+        expr_ref_vector context_fmls(m);
+        for (unsigned i = 0; i < ctx.get_num_asserted_formulas(); ++i) {
+            context_fmls.push_back(ctx.get_asserted_formula(i));
+        }
+        if (len_check_needs_assignments()) {
+            expr_ref_vector assigns(m);
+            ctx.get_assignments(assigns);
+            for (expr* a : assigns) {
+                if (ctx.is_relevant(a)) {
+                    context_fmls.push_back(a);
+                }
+            }
+        }
+        ast_pp_util pp(m);
+        pp.collect(context_fmls);
+        std::ostringstream context_out;
+        pp.display_decls(context_out);
+        pp.display_asserts(context_out, context_fmls, false);
+        record.arith_context = context_out.str();
+
+        const std::string path = m_params.m_record_dir + "/fc-" + std::to_string(num_recorded++) + ".noodler";
+        std::ofstream out(path);
+        if (out) {
+            write_instance(out, record);
+        }
+        STRACE("str", tout << "instance " << (out ? "recorded to " : "could not be recorded to ") << path << std::endl;);
+    }
+
+    unsigned theory_str_noodler::shrink_relevant_unsat_core(unsigned max_checks) {
+        if (!this->m_not_contains_todo_rel.empty() || !this->m_conversion_todo.empty()) {
+            // the decision procedure does not decide not contains and conversions connect string and int variables
+            return 0;
+        }
+
+        const vector<expr_pair> word_eqs = this->m_word_eq_todo_rel;
+        const vector<expr_pair> word_diseqs = this->m_word_diseq_todo_rel;
+        const vector<expr_pair_flag> memberships = this->m_membership_todo_rel;
+        std::vector<unsigned> kept(word_eqs.size() + word_diseqs.size() + memberships.size());
+        std::iota(kept.begin(), kept.end(), 0);
+
+        // memberships are tried first, they are usually the cheapest to remove (and to check)
+        std::vector<unsigned> candidates(kept.rbegin(), kept.rend());
+        unsigned removed = 0;
+        for (unsigned c = 0; c < candidates.size() && c < max_checks && kept.size() > 1; ++c) {
+            std::vector<unsigned> without;
+            std::copy_if(kept.begin(), kept.end(), std::back_inserter(without), [&](unsigned i) { return i != candidates[c]; });
+            set_relevant_constraints(without, word_eqs, word_diseqs, memberships);
+            bool budget_exceeded = false;
+            lbool result = m.inc() ? solve_relevant_strings(false, &budget_exceeded) : l_undef;
+            if (budget_exceeded || !m.inc()) {
+                // the shrinking is not worth more time than the conflict itself, the unshrunk conflict is kept
+                STRACE("str", tout << "shrinking of conflict stopped by the budget" << std::endl;);
+                this->m_word_eq_todo_rel = word_eqs;
+                this->m_word_diseq_todo_rel = word_diseqs;
+                this->m_membership_todo_rel = memberships;
+                return 0;
+            }
+            if (result == l_false) {
+                kept = std::move(without);
+                ++removed;
+            }
+        }
+        set_relevant_constraints(kept, word_eqs, word_diseqs, memberships);
+        STRACE("str", tout << "conflict shrinked by " << removed << " constraints to " << kept.size() << " constraints" << std::endl;);
+        return removed;
+    }
+
+    lbool theory_str_noodler::solve_independent_components() {
+        if (!this->m_not_contains_todo_rel.empty() || !this->m_conversion_todo.empty()) {
+            // the decision procedure does not decide not contains and conversions connect string and int variables
+            return l_undef;
+        }
+
+        std::vector<relevant_component> sorted_components = get_relevant_components();
+        if (sorted_components.size() <= 1) {
+            return l_undef;
+        }
+
+        // variables whose lengths occur in the arithmetic, components containing them are linked through the lengths
+        std::unordered_set<std::string> length_vars;
+        for (expr* len_var : this->len_vars) {
+            length_vars.insert(std::to_string(to_app(len_var)->get_name()));
+        }
+
+        const vector<expr_pair> word_eqs = this->m_word_eq_todo_rel;
+        const vector<expr_pair> word_diseqs = this->m_word_diseq_todo_rel;
+        const vector<expr_pair_flag> memberships = this->m_membership_todo_rel;
+        // constraints of the linked components and of the components that were not decided
+        std::vector<unsigned> remaining;
+        for (const relevant_component& component : sorted_components) {
+            bool is_linked = std::any_of(component.vars.begin(), component.vars.end(),
+                                         [&length_vars](const std::string& var) { return length_vars.find(var) != length_vars.end(); });
+            if (is_linked) {
+                remaining.insert(remaining.end(), component.constraints.begin(), component.constraints.end());
+                continue;
+            }
+            // the component does not share variables with other constraints and the lengths of its variables do
+            // not occur in the arithmetic, it is solved by a solution whose length formula (e.g., of translated
+            // disequations and of preprocessing) is satisfiable
+            set_relevant_constraints(component.constraints, word_eqs, word_diseqs, memberships);
+            lbool result = solve_relevant_strings(true);
+            if (result == l_false) {
+                STRACE("str", tout << "unsat independent component with " << component.constraints.size() << " constraints" << std::endl;);
+                return l_false;
+            } else if (result == l_true) {
+                ++m_stats.m_num_components_solved;
+            } else {
+                remaining.insert(remaining.end(), component.constraints.begin(), component.constraints.end());
+            }
+        }
+
+        // the remaining constraints are kept in the original order
+        std::sort(remaining.begin(), remaining.end());
+        set_relevant_constraints(remaining, word_eqs, word_diseqs, memberships);
+        STRACE("str", tout << "independent components solved, " << remaining.size() << " constraints remain" << std::endl;);
+        return remaining.empty() ? l_true : l_undef;
+    }
+
+    lbool theory_str_noodler::solve_relevant_strings(bool check_lengths, bool* budget_exceeded) {
+        Formula instance = get_word_formula_from_relevant();
+        std::set<mata::Symbol> symbols_in_formula = get_symbols_from_relevant();
+        AutAssignment aut_assignment{create_aut_assignment_for_formula(instance, symbols_in_formula)};
+        std::unordered_set<BasicTerm> init_length_sensitive_vars{ get_init_length_vars(aut_assignment) };
+
+        DecisionProcedure dec_proc{ instance, aut_assignment, init_length_sensitive_vars, m_params, {} };
+        on_scope_exit collect_dec_proc_stats([&]() { add_dec_proc_stats(dec_proc.get_stats()); });
+        dec_proc.set_preprocess_memo(&m_preprocess_memo);
+        dec_proc.set_preprocess_profile(&m_prep_profile);
+        dec_proc.set_literal_store(&m_literal_store);
+        if (dec_proc.preprocess(PreprocessType::PLAIN, this->var_eqs.get_equivalence_bt(aut_assignment)) == l_false) {
+            return l_false;
+        }
+        dec_proc.init_computation();
+        // the same budget as for the decision procedure of the final check
+        dec_proc.set_budget(get_fc_budget());
+        on_scope_exit report_budget([&]() {
+            if (budget_exceeded != nullptr) {
+                *budget_exceeded = dec_proc.was_budget_exceeded();
+            }
+        });
+        if (!check_lengths) {
+            return dec_proc.compute_next_solution();
+        }
+
+        lbool result = dec_proc.compute_next_solution();
+        while (result == l_true) {
+            auto [len_formula, precision] = dec_proc.get_lengths();
+            // an overapproximated length formula does not give a solution
+            if (precision != LenNodePrecision::OVERAPPROX && check_len_sat(len_node_to_z3_formula(len_formula)) == l_true) {
+                return l_true;
+            }
+            result = dec_proc.compute_next_solution();
+        }
+        // the lengths of the solutions were refuted, the length formulas would have to be blocked
+        return result == l_false ? l_undef : result;
+    }
+
+    void theory_str_noodler::extract_symbols(expr* const ex, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>* ranges) {
+        if (ranges != nullptr) {
+            collect_symbols(ex, alphabet, *ranges);
+            return;
+        }
+        std::vector<std::pair<uint32_t,uint32_t>> expr_ranges;
+        collect_symbols(ex, alphabet, expr_ranges);
+        add_range_symbols(alphabet, expr_ranges);
+    }
+
+    void theory_str_noodler::collect_symbols(expr* const ex, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>& ranges) {
         if (m_util_s.str.is_string(ex)) {
             auto ex_app{ to_app(ex) };
             SASSERT(ex_app->get_num_parameters() == 1);
@@ -339,14 +912,14 @@ namespace smt::noodler {
             if (!m_util_s.str.is_string(arg)) { // if to_re has something other than string literal
                 util::throw_error("we support only string literals in str.to_re");
             }
-            extract_symbols(to_app(arg), alphabet);
+            collect_symbols(to_app(arg), alphabet, ranges);
             return;
         } else if (m_util_s.re.is_concat(ex_app) // Handle regex concatenation.
                 || m_util_s.str.is_concat(ex_app) // Handle string concatenation.
                 || m_util_s.re.is_intersection(ex_app) // Handle intersection.
             ) {
             for (unsigned int i = 0; i < ex_app->get_num_args(); ++i) {
-                extract_symbols(to_app(ex_app->get_arg(i)), alphabet);
+                collect_symbols(to_app(ex_app->get_arg(i)), alphabet, ranges);
             }
             return;
         } else if (m_util_s.re.is_antimirov_union(ex_app)) { // Handle Antimirov union.
@@ -355,7 +928,7 @@ namespace smt::noodler {
             SASSERT(ex_app->get_num_args() == 1);
             const auto child{ ex_app->get_arg(0) };
             SASSERT(is_app(child));
-            extract_symbols(to_app(child), alphabet);
+            collect_symbols(to_app(child), alphabet, ranges);
             return;
         } else if (m_util_s.re.is_derivative(ex_app)) { // Handle derivative.
             util::throw_error("derivative is unsupported");
@@ -384,7 +957,7 @@ namespace smt::noodler {
             SASSERT(ex_app->get_num_args() == 1);
             const auto child{ ex_app->get_arg(0) };
             SASSERT(is_app(child));
-            extract_symbols(to_app(child), alphabet);
+            collect_symbols(to_app(child), alphabet, ranges);
             return;
         } else if (m_util_s.re.is_range(ex_app)) { // Handle range.
             SASSERT(ex_app->get_num_args() == 2);
@@ -395,11 +968,11 @@ namespace smt::noodler {
             const auto range_begin_value{ to_app(range_begin)->get_parameter(0).get_zstring()[0] };
             const auto range_end_value{ to_app(range_end)->get_parameter(0).get_zstring()[0] };
 
-            auto current_value{ range_begin_value };
-            while (current_value <= range_end_value) {
-                alphabet.insert(current_value);
-                ++current_value;
+            // ranges are kept symbolic, their symbols are added at most once by add_range_symbols()
+            if (range_begin_value <= range_end_value) {
+                ranges.push_back({range_begin_value, range_end_value});
             }
+            return;
         } else if (m_util_s.re.is_reverse(ex_app)) { // Handle reverse.
             util::throw_error("reverse is unsupported");
         } else if (m_util_s.re.is_union(ex_app)) { // Handle union (= or; A|B).
@@ -408,8 +981,8 @@ namespace smt::noodler {
             const auto right{ ex_app->get_arg(1) };
             SASSERT(is_app(left));
             SASSERT(is_app(right));
-            extract_symbols(to_app(left), alphabet);
-            extract_symbols(to_app(right), alphabet);
+            collect_symbols(to_app(left), alphabet, ranges);
+            collect_symbols(to_app(right), alphabet, ranges);
             return;
         } else if(util::is_variable(ex_app)) { // Handle variable.
             util::throw_error("variable should not occur here");
@@ -419,53 +992,105 @@ namespace smt::noodler {
             for(unsigned i = 0; i < ex_app->get_num_args(); i++) {
                 SASSERT(is_app(ex_app->get_arg(i)));
                 app *arg = to_app(ex_app->get_arg(i));
-                extract_symbols(arg, alphabet);
+                collect_symbols(arg, alphabet, ranges);
             }
         }
     }
 
-    bool theory_str_noodler::is_nielsen_suitable(const Formula& instance, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) const {
-        if(!this->m_membership_todo_rel.empty() || !this->m_not_contains_todo_rel.empty() || !this->m_conversion_todo.empty() || !this->m_word_diseq_todo_rel.empty()) {
-            return false;
-        }
+    void theory_str_noodler::extract_regex_symbols(expr* re, std::set<uint32_t>& alphabet, std::vector<std::pair<uint32_t,uint32_t>>& ranges) {
+        extract_symbols(re, alphabet, m_params.m_alphabet_classes ? &ranges : nullptr);
+    }
 
-        if(init_length_sensitive_vars.size() > 0 && !instance.is_quadratic()) {
-            return false;
+    std::vector<std::pair<uint32_t,uint32_t>> theory_str_noodler::normalize_ranges(std::vector<std::pair<uint32_t,uint32_t>> ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<uint32_t,uint32_t>> normalized;
+        for (const auto& [first, last] : ranges) {
+            // overlapping or adjacent ranges are merged
+            if (!normalized.empty() && first <= normalized.back().second + 1) {
+                normalized.back().second = std::max(normalized.back().second, last);
+            } else {
+                normalized.emplace_back(first, last);
+            }
         }
+        return normalized;
+    }
 
-        Graph incl = Graph::create_inclusion_graph(instance);
-        return incl.is_cyclic();
+    void theory_str_noodler::add_range_symbols(std::set<uint32_t>& alphabet, const std::vector<std::pair<uint32_t,uint32_t>>& ranges) {
+        for (const auto& [first, last] : normalize_ranges(ranges)) {
+            // the symbols of the range are greater than the ones inserted before, so the insertion at the end is constant
+            auto hint = alphabet.lower_bound(first);
+            for (uint32_t symbol = first; symbol <= last; ++symbol) {
+                hint = std::next(alphabet.insert(hint, symbol));
+            }
+        }
     }
 
-    bool theory_str_noodler::is_underapprox_suitable(const Formula& instance, const AutAssignment& aut_ass, const std::vector<TermConversion>& convs) const {
-        if(!convs.empty()) {
-            return false;
+    void theory_str_noodler::add_range_class_representatives(std::set<uint32_t>& alphabet, const std::vector<std::pair<uint32_t,uint32_t>>& ranges,
+                                                             unsigned num_representatives) {
+        // the same range often occurs in many regexes, it is enough to consider it once
+        std::vector<std::pair<uint32_t,uint32_t>> distinct_ranges(ranges);
+        std::sort(distinct_ranges.begin(), distinct_ranges.end());
+        distinct_ranges.erase(std::unique(distinct_ranges.begin(), distinct_ranges.end()), distinct_ranges.end());
+
+        // borders of ranges split the symbols into segments, where all symbols are in the same ranges,
+        // the ranges starting (resp. ending before) at each border are kept so that the ranges of each
+        // segment are obtained by a sweep over the borders
+        std::map<uint32_t, std::pair<std::vector<unsigned>, std::vector<unsigned>>> borders;
+        for (unsigned i = 0; i < distinct_ranges.size(); ++i) {
+            borders[distinct_ranges[i].first].first.push_back(i);
+            borders[distinct_ranges[i].second + 1].second.push_back(i);
         }
-        /**
-         * Check each variable occurring within the instance. The instance is suitable for underapproximation if 
-         * 1) predicates are (dis)equations only and 2) language of the variable is a) sigma star (approximated by 
-         * the first condition) b) co-finite (complement is a finite language), or c) singleton meaning that the 
-         * variable is string literal. 
-         */
-        for(const Predicate& pred : instance.get_predicates()) {
-            if(!pred.is_eq_or_ineq()) {
-                return false;
+
+        // for each set of ranges (given by their indices), we keep the number of its representatives
+        std::map<std::vector<unsigned>, unsigned> represented;
+        std::set<unsigned> active_ranges;
+        for (auto it = borders.begin(); it != borders.end() && std::next(it) != borders.end(); ++it) {
+            for (unsigned i : it->second.second) {
+                active_ranges.erase(i);
             }
-            for(const BasicTerm& var : pred.get_vars()) {
-                
-                if(aut_ass.at(var)->num_of_states() <= 1) {
-                    continue;
+            for (unsigned i : it->second.first) {
+                active_ranges.insert(i);
+            }
+            if (active_ranges.empty()) {
+                continue;
+            }
+            const uint32_t segment_first = it->first;
+            const uint32_t segment_last = std::next(it)->first - 1;
+            unsigned& num_represented = represented[std::vector<unsigned>(active_ranges.begin(), active_ranges.end())];
+            // the representatives must not occur in the formula explicitly (such symbols are distinguished)
+            for (uint32_t symbol = segment_first; symbol <= segment_last && num_represented < num_representatives; ++symbol) {
+                if (!alphabet.contains(symbol)) {
+                    alphabet.insert(symbol);
+                    ++num_represented;
                 }
-                if(aut_ass.is_co_finite(var)) {
+            }
+        }
+    }
+
+    InstanceFeatures theory_str_noodler::get_instance_features(const Formula& instance, const AutAssignment& aut_ass,
+                                                               const std::unordered_set<BasicTerm>& init_length_sensitive_vars) const {
+        // Nielsen transformation cannot handle memberships and conversions, the inclusion graph is then not needed
+        bool nielsen_candidate = this->m_membership_todo_rel.empty() && this->m_conversion_todo.empty();
+        InstanceFeatures features = InstanceFeatures::compute(instance, aut_ass, init_length_sensitive_vars, nielsen_candidate);
+        features.num_memberships = this->m_membership_todo_rel.size();
+        features.num_lang_eqs_diseqs = this->m_lang_eq_or_diseq_todo_rel.size();
+        features.num_conversions = this->m_conversion_todo.size();
+        if (m_params.m_bounded_length > 0) {
+            features.length_bound = m_params.m_bounded_length;
+            features.max_word_length = 0;
+            for (const auto& [var, aut] : aut_ass) {
+                if (!var.is_variable()) {
                     continue;
                 }
-                if(aut_ass.is_singleton(var)) {
-                    continue;
+                std::optional<unsigned> max_len = aut_ass.get_max_length(var);
+                if (!max_len.has_value() || *max_len > features.length_bound) {
+                    features.max_word_length = UINT_MAX;
+                    break;
                 }
-                return false;
+                features.max_word_length = std::max(features.max_word_length, *max_len);
             }
         }
-        return true;
+        return features;
     }
 
     lbool theory_str_noodler::run_nielsen(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) {
@@ -482,7 +1107,7 @@ namespace smt::noodler {
                     return l_true;
                 } else {
                     STRACE("str", tout << "nielsen len unsat" <<  mk_pp(lengths, m) << std::endl;);
-                    block_len = m.mk_or(block_len, lengths);
+                    block_len = m.mk_or(block_len, m_params.m_len_block_core ? weaken_blocked_len(lengths) : lengths);
                 }
             } else if (result == l_false) {
                 // we did not find a solution (with satisfiable length constraints)
@@ -497,48 +1122,107 @@ namespace smt::noodler {
         return l_undef;
     }
 
-    lbool theory_str_noodler::run_length_proc(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) {
-        STRACE("str", tout << "Trying length-based procedure" << std::endl);
-        LengthDecisionProcedure nproc(instance, aut_assignment, init_length_sensitive_vars, m_params);
+    lbool theory_str_noodler::run_bounded(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) {
+        STRACE("str", tout << "Trying bounded" << std::endl);
+        BoundedStringProcedure bproc(instance, aut_assignment, init_length_sensitive_vars, m_params);
         expr_ref block_len(m.mk_false(), m);
-        if (nproc.preprocess() == l_false) {
-            STRACE("str", tout << "len: unsat from preprocessing\n");
-            block_curr_len(block_len);
-            return l_false;
-        }
-        nproc.init_computation();
+        bproc.init_computation();
         while (true) {
-            lbool result = nproc.compute_next_solution();
+            lbool result = bproc.compute_next_solution();
             if (result == l_true) {
-                expr_ref lengths = len_node_to_z3_formula(nproc.get_lengths().first);
+                expr_ref lengths = len_node_to_z3_formula(bproc.get_lengths().first);
                 if (check_len_sat(lengths) == l_true) {
                     return l_true;
-                } else {
-                    STRACE("str", tout << "len: unsat from lengths:" <<  mk_pp(lengths, m) << std::endl;);
-                    if (nproc.precision != LenNodePrecision::UNDERAPPROX) {
-                        block_curr_len(lengths);
-                        return l_false;
-                    } else {
-                        return l_undef;
-                    }
                 }
-            } else if (result == l_false) { // never happens
+                STRACE("str", tout << "bounded len unsat" << mk_pp(lengths, m) << std::endl;);
+                block_len = m.mk_or(block_len, m_params.m_len_block_core ? weaken_blocked_len(lengths) : lengths);
+            } else if (result == l_false) {
+                // all solutions have the blocked lengths
                 block_curr_len(block_len);
                 return l_false;
             } else {
-                // we could not decide if there is solution, continue with other decision procedure
                 break;
             }
         }
         return l_undef;
     }
 
+    std::map<BasicTerm, unsigned> theory_str_noodler::get_ctx_lengths(const AutAssignment& aut_assignment) {
+        context& ctx = get_context();
+        arith_value av(m);
+        av.init(&ctx);
+        std::map<BasicTerm, unsigned> lengths;
+        for (const auto& [var, aut] : aut_assignment) {
+            auto it = var_name.find(var);
+            if (!var.is_variable() || it == var_name.end() || !m_util_s.is_string(it->second->get_sort())) {
+                continue;
+            }
+            expr_ref len_expr(m_util_s.str.mk_length(it->second), m);
+            rational val;
+            if (ctx.e_internalized(len_expr) && av.get_value(len_expr, val) && val.is_unsigned()) {
+                lengths[var] = val.get_unsigned();
+            }
+        }
+        return lengths;
+    }
+
+    void theory_str_noodler::set_sls_words(const SlsDecisionProcedure& sls, const std::set<mata::Symbol>& symbols) {
+        // the dummy symbol stands for any symbol not occurring in the formula (as in compute_model_words())
+        mata::Symbol dummy_replacement = 'a';
+        while (symbols.contains(dummy_replacement)) {
+            ++dummy_replacement;
+        }
+        m_sls_words.reset();
+        for (const auto& [var, word] : sls.get_words()) {
+            auto it = var_name.find(var);
+            if (it == var_name.end() || !m_util_s.is_string(it->second->get_sort())) {
+                continue;
+            }
+            std::vector<unsigned> chars;
+            for (mata::Symbol s : word) {
+                chars.push_back(is_dummy_symbol(s) ? dummy_replacement : s);
+            }
+            m_sls_words.insert(it->second, zstring(chars.size(), chars.data()));
+        }
+    }
+
+    lbool theory_str_noodler::run_sls(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                      const std::set<mata::Symbol>& symbols) {
+        STRACE("str", tout << "Trying sls" << std::endl);
+        SlsDecisionProcedure sls(instance, aut_assignment, init_length_sensitive_vars, get_ctx_lengths(aut_assignment), symbols, m_params,
+                                 get_context().get_fparams().m_random_seed + m_stats.m_num_final_checks);
+        sls.init_computation();
+        // a solution whose lengths are not satisfiable is not blocked, the search is incomplete
+        while (sls.compute_next_solution() == l_true) {
+            expr_ref lengths = len_node_to_z3_formula(sls.get_lengths().first);
+            if (check_len_sat(lengths) == l_true) {
+                STRACE("str", tout << "sls: solution after " << sls.get_num_flips() << " moves" << std::endl);
+                set_sls_words(sls, symbols);
+                return l_true;
+            }
+            STRACE("str", tout << "sls len unsat " << mk_pp(lengths, m) << std::endl;);
+        }
+        return l_undef;
+    }
+
     lbool theory_str_noodler::run_membership_heur() {
         STRACE("str", tout << "Trying heuristic for the case we only have 'x (not)in RE'" << std::endl);
         const auto& reg_data = this->m_membership_todo_rel[0];
+        zstring word;
+        if(m_util_s.str.is_string(std::get<0>(reg_data), word)) {
+            // membership of a literal is decided by derivatives
+            lbool is_member = m_membership_cache.is_member(word, to_app(std::get<1>(reg_data)), m_util_s, m, m_rewrite);
+            if(is_member != l_undef) {
+                if((is_member == l_true) == std::get<2>(reg_data)) {
+                    return l_true;
+                }
+                block_curr_len(expr_ref(this->m.mk_false(), this->m));
+                return l_false;
+            }
+        }
         // Heuristic: Get info about the regular expression. If the membership is negated and the regex is not universal for sure --> return FC_DONE.
         // If the membership is in the positive form and the regex is not empty --> regurn FC_DONE.
-        regex::RegexInfo regInfo = regex::get_regex_info(to_app(std::get<1>(reg_data)), m_util_s, m);
+        regex::RegexInfo regInfo = m_regex_info_cache.get(to_app(std::get<1>(reg_data)), m_util_s, m);
         if(!std::get<2>(reg_data) && !this->len_vars.contains(std::get<0>(reg_data)) && regInfo.universal == l_false) {
             return l_true;
         }
@@ -553,12 +1237,12 @@ namespace smt::noodler {
             extract_symbols(std::get<1>(reg_data), symbols_in_regex);
             regex::Alphabet reg_alph(symbols_in_regex);
 
-            mata::nfa::Nfa nfa{ regex::conv_to_nfa(to_app(std::get<1>(reg_data)), m_util_s, m, reg_alph, false, false) };
+            std::shared_ptr<const mata::nfa::Nfa> nfa = m_nfa_cache.get_nfa(to_app(std::get<1>(reg_data)), m_util_s, m, reg_alph, false, false);
 
             mata::EnumAlphabet alph(symbols_in_regex.begin(), symbols_in_regex.end());
             mata::nfa::Nfa sigma_star = mata::nfa::builder::create_sigma_star_nfa(&alph);
 
-            if(mata::nfa::are_equivalent(nfa, sigma_star)) {
+            if(mata::nfa::are_equivalent(*nfa, sigma_star)) {
                 // x should not belong in sigma*, so it is unsat
                 block_curr_len(expr_ref(this->m.mk_false(), this->m));
                 STRACE("str", tout << "Membership " << mk_pp(std::get<0>(reg_data), m) << " not in " << mk_pp(std::get<1>(reg_data), m) << " is unsat" << std::endl;);
@@ -571,6 +1255,7 @@ namespace smt::noodler {
         return l_undef;
     }
 
+
     bool theory_str_noodler::is_mult_membership_suitable() {
         if (!this->m_conversion_todo.empty() || !this->m_not_contains_todo_rel.empty()) {
             return false;
@@ -611,75 +1296,255 @@ namespace smt::noodler {
 
         regex::Alphabet alph(get_symbols_from_relevant());
         // to each var x we map all the regexes RE where we have (x in RE) + bool that is true if it is (x not in RE)
-        std::map<BasicTerm, std::vector<std::pair<bool,app*>>> var_to_list_of_regexes_and_complement_flag;
+        // + the number of the constraint it comes from (equations, then disequations and then memberships, see set_relevant_constraints())
+        std::map<BasicTerm, std::vector<std::tuple<bool,app*,unsigned>>> var_to_list_of_regexes_and_complement_flag;
+        const unsigned num_eqs = m_word_eq_todo_rel.size();
+        const unsigned num_diseqs = m_word_diseq_todo_rel.size();
 
         // collect from relevant memberships
-        for (const auto &membership: m_membership_todo_rel) {
+        for (unsigned i = 0; i < m_membership_todo_rel.size(); ++i) {
+            const auto& membership = m_membership_todo_rel[i];
             BasicTerm var(BasicTermType::Variable, to_app(std::get<0>(membership))->get_decl()->get_name().str());
             app* reg = to_app(std::get<1>(membership));
-            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_pair(!std::get<2>(membership), reg));
+            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_tuple(!std::get<2>(membership), reg, num_eqs + num_diseqs + i));
         }
 
         // we assume that is_mult_membership_heur was run before, therefore we have only disequations
         //   x != str_literal
         // i.e., one var on left and some string literal on right, we can replace this with (x not in {str_literal})
-        for (const auto& diseq : m_word_diseq_todo_rel) {
+        for (unsigned i = 0; i < num_diseqs; ++i) {
+            const auto& diseq = m_word_diseq_todo_rel[i];
             BasicTerm var(BasicTermType::Variable, to_app(diseq.first)->get_decl()->get_name().str());
             app* reg = to_app(diseq.second);
-            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_pair(true, reg));
+            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_tuple(true, reg, num_eqs + i));
         }
 
         // we assume that is_mult_membership_heur was run before, therefore we have only equations
         //   x == str_literal
         // i.e., one var on left and some string literal on right, we can replace this with (x in {str_literal})
-        for (const auto& eq : m_word_eq_todo_rel) {
+        for (unsigned i = 0; i < num_eqs; ++i) {
+            const auto& eq = m_word_eq_todo_rel[i];
             BasicTerm var(BasicTermType::Variable, to_app(eq.first)->get_decl()->get_name().str());
             app* reg = to_app(eq.second);
-            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_pair(false, reg));
+            var_to_list_of_regexes_and_complement_flag[var].push_back(std::make_tuple(false, reg, i));
         }
 
+        // the automata are obtained (from the cache shared with the rest of the theory) before the intersections of
+        // different variables are computed, possibly concurrently, as they are independent
+        std::vector<std::vector<std::tuple<bool,app*,unsigned>>*> lists_of_regexes;
+        std::vector<std::vector<std::shared_ptr<const mata::nfa::Nfa>>> nfas_of_vars;
         for (auto& [var, list_of_regexes] : var_to_list_of_regexes_and_complement_flag) {
-            // sort the regexes using get_loop_sum, where those regexes that needs to be complemented should all be at the end
-            std::sort(list_of_regexes.begin(), list_of_regexes.end(), [this](const std::pair<bool,app*>& l, const std::pair<bool,app*>& r) {
-                return ((!l.first && r.first) | (regex::get_loop_sum(l.second, m_util_s) < regex::get_loop_sum(r.second, m_util_s)));
+            // sort the regexes using get_loop_sum (computed once for each regex), where those regexes that needs to be complemented should all be at the end
+            std::vector<std::pair<unsigned, std::tuple<bool,app*,unsigned>>> regexes_with_loop_sums;
+            for (const auto& regex : list_of_regexes) {
+                regexes_with_loop_sums.emplace_back(regex::get_loop_sum(std::get<1>(regex), m_util_s), regex);
+            }
+            std::stable_sort(regexes_with_loop_sums.begin(), regexes_with_loop_sums.end(), [](const auto& l, const auto& r) {
+                return std::make_pair(std::get<0>(l.second), l.first) < std::make_pair(std::get<0>(r.second), r.first);
             });
+            for (unsigned i = 0; i < list_of_regexes.size(); ++i) {
+                list_of_regexes[i] = regexes_with_loop_sums[i].second;
+            }
             STRACE("str-mult-memb-heur",
                 tout << "Sorted NFAs for var " << var << std::endl;
                 unsigned i = 0;
-                for (const auto & [is_complement, nfa] : list_of_regexes) {
+                for (const auto & [is_complement, nfa, constraint] : list_of_regexes) {
                     tout << i << " (" << (is_complement ? "" : "not ") <<"complemented):" << std::endl;
                     tout << nfa << std::endl;
                 }
             );
 
-            std::shared_ptr<mata::nfa::Nfa> intersection = nullptr; // we save the intersected automata here
-            for (auto& [is_complement, reg] : list_of_regexes) {
-                STRACE("str", tout << "building intersection for var " << var << " and regex " << mk_pp(reg, m) << (is_complement ? " that needs to be first complemented" : " that does not need to be first complemented") << std::endl;);
-
-                std::shared_ptr<mata::nfa::Nfa> nfa = std::make_shared<mata::nfa::Nfa>(regex::conv_to_nfa(reg, m_util_s, m, alph, is_complement, is_complement));
+            // the complements are not constructed (see get_empty_membership_intersection())
+            std::vector<std::shared_ptr<const mata::nfa::Nfa>> nfas;
+            for (const auto& [is_complement, reg, constraint] : list_of_regexes) {
+                nfas.push_back(m_nfa_cache.get_nfa(reg, m_util_s, m, alph, false, false));
+            }
+            lists_of_regexes.push_back(&list_of_regexes);
+            nfas_of_vars.push_back(std::move(nfas));
+        }
 
-                if (intersection == nullptr) {
-                    intersection = nfa; // this is first nfa
-                } else {
-                    intersection = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(mata::nfa::intersection(*nfa, *intersection)));
+        // for each variable, the regexes (indices to its list) whose intersection is empty (no regexes if it is not empty)
+        std::vector<std::vector<unsigned>> empty_intersections(lists_of_regexes.size());
+        bool computed = false;
+#ifndef SINGLE_THREAD
+        const unsigned num_of_threads = std::min<size_t>(m_params.m_dp_threads, lists_of_regexes.size());
+        if (num_of_threads > 1) {
+            std::atomic<size_t> next_var{0};
+            // the smallest variable with an empty intersection found so far, the variables before it are
+            // still computed, so the conflict is the same as the one of the sequential computation
+            std::atomic<size_t> first_empty{lists_of_regexes.size()};
+            std::mutex exception_mutex;
+            std::exception_ptr worker_exception = nullptr;
+            auto worker = [&]() {
+                try {
+                    for (size_t i = next_var++; i < first_empty; i = next_var++) {
+                        empty_intersections[i] = get_empty_membership_intersection(*lists_of_regexes[i], nfas_of_vars[i], alph);
+                        if (!empty_intersections[i].empty()) {
+                            size_t first = first_empty;
+                            while (i < first && !first_empty.compare_exchange_weak(first, i)) {}
+                        }
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(exception_mutex);
+                    if (worker_exception == nullptr) {
+                        worker_exception = std::current_exception();
+                    }
+                    first_empty = 0;
                 }
-                nfa = nullptr;
-                
-                if (intersection->is_lang_empty()) {
-                    STRACE("str", tout << "intersection is empty => UNSAT" << std::endl;);
-                    block_curr_len(expr_ref(this->m.mk_false(), this->m));
-                    return l_false;
+            };
+            std::vector<std::thread> threads;
+            for (unsigned i = 0; i < num_of_threads; ++i) {
+                threads.emplace_back(worker);
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            if (worker_exception != nullptr) {
+                std::rethrow_exception(worker_exception);
+            }
+            computed = true;
+        }
+#endif
+        if (!computed) {
+            for (size_t i = 0; i < lists_of_regexes.size(); ++i) {
+                empty_intersections[i] = get_empty_membership_intersection(*lists_of_regexes[i], nfas_of_vars[i], alph);
+                if (!empty_intersections[i].empty()) {
+                    break;
                 }
             }
         }
 
+        // the first variable with an empty intersection is used (the same as for the sequential computation)
+        for (size_t i = 0; i < lists_of_regexes.size(); ++i) {
+            if (!empty_intersections[i].empty()) {
+                STRACE("str", tout << "intersection is empty => UNSAT" << std::endl;);
+                // only the constraints of the conflicting regexes are blocked, so that the SAT solver learns a small clause
+                const vector<expr_pair> word_eqs = this->m_word_eq_todo_rel;
+                const vector<expr_pair> word_diseqs = this->m_word_diseq_todo_rel;
+                const vector<expr_pair_flag> memberships = this->m_membership_todo_rel;
+                set_relevant_constraints(get_mult_membership_conflict(*lists_of_regexes[i], empty_intersections[i], alph), word_eqs, word_diseqs, memberships);
+                block_curr_len(expr_ref(this->m.mk_false(), this->m));
+                return l_false;
+            }
+        }
+
         STRACE("str", tout << "intersection is not empty => SAT" << std::endl;);
         return l_true;
     }
+
+    std::vector<unsigned> theory_str_noodler::get_empty_membership_intersection(const std::vector<std::tuple<bool,app*,unsigned>>& list_of_regexes,
+                                                                              const std::vector<std::shared_ptr<const mata::nfa::Nfa>>& nfas,
+                                                                              const regex::Alphabet& alph) {
+        // automata of the (intersected or united) regexes with the indices of the regexes
+        using Part = std::pair<std::shared_ptr<const mata::nfa::Nfa>, std::vector<unsigned>>;
+        std::vector<Part> positive_parts, negative_parts;
+        for (unsigned i = 0; i < list_of_regexes.size(); ++i) {
+            (std::get<0>(list_of_regexes[i]) ? negative_parts : positive_parts).push_back({nfas[i], {i}});
+        }
+
+        // the parts are combined pairwise in a balanced tree, so that the intermediate products are smaller than for a left fold,
+        // an empty intersection of positive regexes is returned immediately
+        auto combine = [](std::vector<Part>& parts, bool intersect) -> const Part* {
+            while (parts.size() > 1) {
+                std::vector<Part> next_parts;
+                for (size_t i = 0; i + 1 < parts.size(); i += 2) {
+                    Part& left = parts[i];
+                    Part& right = parts[i+1];
+                    mata::nfa::Nfa combined = intersect ? noodler::intersect(*left.first, *right.first) : mata::nfa::uni(*left.first, *right.first);
+                    left.second.insert(left.second.end(), right.second.begin(), right.second.end());
+                    next_parts.emplace_back(std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(combined)), std::move(left.second));
+                    if (intersect && next_parts.back().first->is_lang_empty()) {
+                        parts = { std::move(next_parts.back()) };
+                        return &parts[0];
+                    }
+                }
+                if (parts.size() % 2 == 1) {
+                    next_parts.push_back(std::move(parts.back()));
+                }
+                parts = std::move(next_parts);
+            }
+            return parts.empty() ? nullptr : &parts[0];
+        };
+
+        const Part* positive = combine(positive_parts, true);
+        if (positive != nullptr && positive->first->is_lang_empty()) {
+            return positive->second;
+        }
+        const Part* negative = combine(negative_parts, false);
+        if (is_difference_empty(positive ? positive->first : nullptr, negative ? negative->first : nullptr, alph)) {
+            std::vector<unsigned> res(list_of_regexes.size());
+            std::iota(res.begin(), res.end(), 0);
+            return res;
+        }
+        return {};
+    }
+
+    bool theory_str_noodler::is_difference_empty(const std::shared_ptr<const mata::nfa::Nfa>& positive,
+                                                 const std::shared_ptr<const mata::nfa::Nfa>& negative_union, const regex::Alphabet& alph) {
+        if (negative_union == nullptr) {
+            return positive->is_lang_empty();
+        }
+        if (positive == nullptr) {
+            // the complement of negative_union is empty iff negative_union is universal
+            return negative_union->is_universal(alph.get_mata_alphabet());
+        }
+        // both inclusion and universality are checked by antichains, i.e., the complement is explored only lazily
+        return mata::nfa::is_included(*positive, *negative_union, nullptr, &alph.get_mata_alphabet());
+    }
+
+    std::vector<unsigned> theory_str_noodler::get_mult_membership_conflict(const std::vector<std::tuple<bool,app*,unsigned>>& list_of_regexes,
+                                                                        std::vector<unsigned> conflict, const regex::Alphabet& alph, unsigned max_size) {
+
+        // the same check as in run_mult_membership_heur() (without constructing complements)
+        auto is_intersection_empty = [&](const std::vector<unsigned>& regexes) {
+            std::shared_ptr<const mata::nfa::Nfa> intersection = nullptr;
+            std::shared_ptr<const mata::nfa::Nfa> complemented_union = nullptr;
+            for (unsigned i : regexes) {
+                const auto& [is_complement, reg, constraint] = list_of_regexes[i];
+                std::shared_ptr<const mata::nfa::Nfa> nfa = m_nfa_cache.get_nfa(reg, m_util_s, m, alph, false, false);
+                std::shared_ptr<const mata::nfa::Nfa>& combined = is_complement ? complemented_union : intersection;
+                if (combined == nullptr) {
+                    combined = nfa;
+                } else if (is_complement) {
+                    combined = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(mata::nfa::uni(*nfa, *combined)));
+                } else {
+                    combined = std::make_shared<mata::nfa::Nfa>(mata::nfa::reduce(intersect(*nfa, *combined)));
+                }
+                if (is_difference_empty(intersection, complemented_union, alph)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // deletion-based minimization: a regex is removed if the intersection of the remaining ones is still empty
+        if (conflict.size() <= max_size) {
+            for (unsigned pos = 0; pos < conflict.size() && conflict.size() > 1;) {
+                std::vector<unsigned> smaller = conflict;
+                smaller.erase(smaller.begin() + pos);
+                if (is_intersection_empty(smaller)) {
+                    conflict = std::move(smaller);
+                } else {
+                    ++pos;
+                }
+            }
+        }
+        STRACE("str", tout << "conflict of memberships restricted to " << conflict.size() << " of " << list_of_regexes.size() << " regexes" << std::endl;);
+
+        std::vector<unsigned> res;
+        for (unsigned i : conflict) {
+            res.push_back(std::get<2>(list_of_regexes[i]));
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
     
     lbool theory_str_noodler::run_length_proc(const Formula& instance, const AutAssignment& aut_assignment, const std::unordered_set<BasicTerm>& init_length_sensitive_vars) {
         STRACE("str", tout << "Trying length-based procedure" << std::endl);
         LengthDecisionProcedure nproc(instance, aut_assignment, init_length_sensitive_vars, m_params);
+        nproc.set_preprocess_profile(&m_prep_profile);
+        nproc.set_preprocess_memo(&m_preprocess_memo);
+        nproc.set_literal_store(&m_literal_store);
         nproc.preprocess();
         expr_ref block_len(m.mk_false(), m);
         nproc.init_computation();
@@ -691,7 +1556,7 @@ namespace smt::noodler {
                     return l_true;
                 } else {
                     STRACE("str", tout << "length-based procedure len unsat" <<  mk_pp(lengths, m) << std::endl;);
-                    block_len = m.mk_or(block_len, lengths);
+                    block_len = m.mk_or(block_len, m_params.m_len_block_core ? weaken_blocked_len(lengths) : lengths);
                 }
             } else if (result == l_false) {
                 // we did not find a solution (with satisfiable length constraints)
@@ -718,19 +1583,31 @@ namespace smt::noodler {
             bool init_only = true;
             expr_ref len_formula(this->m);
 
-            for (const auto &pr : this->axiomatized_instances) {
-                if (pr.first == refine) {
-                    len_formula = pr.second.lengths;
-                    init_only = init_only && pr.second.initial_length;
+            auto* instances = this->axiomatized_instances_index.find_core(refine);
+            if (instances != nullptr) {
+                // instances are checked in the length session first, the expensive unsat core is computed only for unsat ones
+                unsigned generation = m_len_session.sync(get_context(), len_check_needs_assignments());
+                for (unsigned index : instances->get_data().m_value) {
+                    stored_instance& inst = this->axiomatized_instances[index].second;
+                    len_formula = inst.lengths;
+                    init_only = init_only && inst.initial_length;
                     found = true;
 
+                    STRACE("str", tout << "loop-protection: found " << std::endl;);
+                    if (inst.len_result != l_true || inst.len_generation != generation) {
+                        inst.len_result = len_formula == m.mk_true() ? l_true : m_len_session.check_sat(len_formula);
+                        inst.len_generation = generation;
+                    }
+                    if (inst.len_result == l_true) {
+                        continue;
+                    }
+
                     /**
                      * We need to force the SAT solver to find another solution, because adding block_curr_len(len_formula);
                      * is not sufficient for SAT solver to get another solution. We hence find unsat core of
                      * the current assignment with the len_formula and add this unsat core as
                      * a theory lemma.
                      */
-                    STRACE("str", tout << "loop-protection: found " << std::endl;);
                     expr_ref unsat_core(m.mk_true(), m);
                     if (check_len_sat(len_formula, &unsat_core) == l_false) {
                         unsat_core = m.mk_not(unsat_core);
@@ -754,11 +1631,56 @@ namespace smt::noodler {
         return l_undef;
     }
 
+    std::unique_ptr<theory_str_noodler::relevant_fingerprint> theory_str_noodler::get_relevant_fingerprint() {
+        auto fingerprint = std::make_unique<relevant_fingerprint>(m);
+        auto add_expr = [&fingerprint](expr* e) {
+            fingerprint->ids.push_back(e->get_id());
+            fingerprint->exprs.push_back(e);
+        };
+        for (const auto* pairs : { &m_word_eq_todo_rel, &m_word_diseq_todo_rel, &m_not_contains_todo_rel }) {
+            fingerprint->ids.push_back(pairs->size());
+            for (const auto& [left, right] : *pairs) {
+                add_expr(left);
+                add_expr(right);
+            }
+        }
+        for (const auto* flagged : { &m_membership_todo_rel, &m_lang_eq_or_diseq_todo_rel }) {
+            fingerprint->ids.push_back(flagged->size());
+            for (const auto& [left, right, flag] : *flagged) {
+                add_expr(left);
+                add_expr(right);
+                fingerprint->ids.push_back(flag);
+            }
+        }
+        fingerprint->ids.push_back(m_conversion_todo.size());
+        for (const auto& [result, arg, type] : m_conversion_todo) {
+            add_expr(result);
+            add_expr(arg);
+            fingerprint->ids.push_back(static_cast<unsigned>(type));
+        }
+        return fingerprint;
+    }
+
+    lbool theory_str_noodler::run_repeated_final_check() {
+        if (m_last_done_fingerprint == nullptr || m_curr_fingerprint == nullptr
+            || m_last_done_fingerprint->ids != m_curr_fingerprint->ids) {
+            return l_undef;
+        }
+        STRACE("str", tout << "repeated final check: " << mk_pp(m_last_done_fingerprint->lengths, m) << std::endl;);
+        const expr_ref& lengths = m_last_done_fingerprint->lengths;
+        if (m.is_true(lengths)) {
+            return l_true;
+        }
+        m_len_session.sync(get_context(), len_check_needs_assignments());
+        return m_len_session.check_sat(lengths) == l_true ? l_true : l_undef;
+    }
+
     lbool theory_str_noodler::run_length_sat(const Formula& instance, const AutAssignment& aut_ass,
                                 const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
                                 std::vector<TermConversion> conversions) {
 
         DecisionProcedure dec_proc = DecisionProcedure{ instance, aut_ass, init_length_sensitive_vars, m_params, conversions };
+        dec_proc.set_length_abstraction_cache(&m_len_abstraction_cache);
         expr_ref lengths = len_node_to_z3_formula(dec_proc.get_initial_lengths());
         if(check_len_sat(lengths) == l_false) {
             STRACE("str", tout << "Unsat from initial lengths (one symbol)" << std::endl);
@@ -768,4 +1690,246 @@ namespace smt::noodler {
             return l_true;
         }
     }
+
+#ifndef SINGLE_THREAD
+    namespace {
+        // procedure of the portfolio (see theory_str_noodler::run_portfolio) with the thread it runs on
+        struct PortfolioMember {
+            enum struct Kind {
+                LENGTH,
+                NIELSEN,
+                UNDERAPPROX,
+                SLS,
+                BOUNDED,
+            };
+
+            Kind kind;
+            std::unique_ptr<AbstractDecisionProcedure> proc;
+            std::thread thread;
+            // the calling thread allows the member to compute the next solution
+            bool resume = false;
+        };
+
+        // candidate solution (result l_true with its lengths) or the final result of a member of the portfolio
+        struct PortfolioMessage {
+            size_t member;
+            lbool result;
+            std::pair<LenNode, LenNodePrecision> lengths;
+        };
+
+        // copy of @p aut_ass with copied automata, so that the automata are not shared by more threads
+        AutAssignment clone_aut_assignment(const AutAssignment& aut_ass) {
+            AutAssignment clone = aut_ass;
+            for (auto& [var, nfa] : clone) {
+                nfa = std::make_shared<mata::nfa::Nfa>(*nfa);
+            }
+            return clone;
+        }
+    }
+
+    lbool theory_str_noodler::run_portfolio(const Formula& instance, const AutAssignment& aut_assignment,
+                                            const std::unordered_set<BasicTerm>& init_length_sensitive_vars,
+                                            const std::vector<TermConversion>& conversions, const std::set<mata::Symbol>& symbols,
+                                            const InstanceFeatures& features) {
+        using Kind = PortfolioMember::Kind;
+        STRACE("str", tout << "Trying portfolio" << std::endl);
+
+        // the equivalence of lengths is computed here, var_eqs cannot be accessed from the members
+        const BasicTermEqiv len_eq_vars = this->var_eqs.get_equivalence_bt(aut_assignment);
+        std::vector<PortfolioMember> members;
+        DecisionProcedure* underapprox_proc = nullptr;
+        // the order of members does not matter, the selector only gives the suitable procedures
+        for (SolverProcedure proc : ProcedureSelector::create(m_params.m_procedure_selector)->select(features)) {
+            if (proc == SolverProcedure::LENGTH && m_params.m_try_length_proc) {
+                members.push_back({Kind::LENGTH, std::make_unique<LengthDecisionProcedure>(instance, clone_aut_assignment(aut_assignment), init_length_sensitive_vars, m_params)});
+            } else if (proc == SolverProcedure::NIELSEN && m_params.m_try_nielsen) {
+                members.push_back({Kind::NIELSEN, std::make_unique<NielsenDecisionProcedure>(instance, clone_aut_assignment(aut_assignment), init_length_sensitive_vars, m_params)});
+            } else if (proc == SolverProcedure::UNDERAPPROX && m_params.m_underapproximation) {
+                auto dec_proc = std::make_unique<DecisionProcedure>(instance, clone_aut_assignment(aut_assignment), init_length_sensitive_vars, m_params, conversions);
+                dec_proc->set_budget(get_fc_budget());
+                underapprox_proc = dec_proc.get();
+                members.push_back({Kind::UNDERAPPROX, std::move(dec_proc)});
+            } else if (proc == SolverProcedure::BOUNDED) {
+                members.push_back({Kind::BOUNDED, std::make_unique<BoundedStringProcedure>(instance, clone_aut_assignment(aut_assignment), init_length_sensitive_vars, m_params)});
+            }
+        }
+        SlsDecisionProcedure* sls_proc = nullptr;
+        if (m_params.m_sls && features.has_equations_only()) {
+            auto sls = std::make_unique<SlsDecisionProcedure>(instance, clone_aut_assignment(aut_assignment), init_length_sensitive_vars,
+                                                              get_ctx_lengths(aut_assignment), symbols, m_params,
+                                                              get_context().get_fparams().m_random_seed + m_stats.m_num_final_checks);
+            sls_proc = sls.get();
+            members.push_back({Kind::SLS, std::move(sls)});
+        }
+        if (members.empty()) {
+            return l_undef;
+        }
+
+        std::mutex lock;
+        std::condition_variable messages_cv;
+        std::condition_variable resume_cv;
+        std::deque<PortfolioMessage> messages;
+        std::atomic<bool> cancel = false;
+        std::exception_ptr member_exception = nullptr;
+
+        auto member_thread = [&](size_t i) {
+            PortfolioMember& member = members[i];
+            auto post = [&](lbool result, std::pair<LenNode, LenNodePrecision> lengths) {
+                std::lock_guard<std::mutex> guard(lock);
+                messages.push_back({i, result, std::move(lengths)});
+                messages_cv.notify_one();
+            };
+            const std::pair<LenNode, LenNodePrecision> no_lengths{LenNode(LenFormulaType::TRUE), LenNodePrecision::PRECISE};
+            try {
+                lbool preprocess_result = member.proc->preprocess(member.kind == Kind::UNDERAPPROX ? PreprocessType::UNDERAPPROX : PreprocessType::PLAIN, len_eq_vars);
+                // the result of the preprocessing of Nielsen transformation is not used (see run_nielsen)
+                if (preprocess_result == l_false && member.kind != Kind::NIELSEN) {
+                    post(l_false, no_lengths);
+                    return;
+                }
+                member.proc->init_computation();
+                while (true) {
+                    lbool result = member.proc->compute_next_solution();
+                    if (result != l_true) {
+                        post(result, no_lengths);
+                        return;
+                    }
+                    post(l_true, member.proc->get_lengths());
+
+                    std::unique_lock<std::mutex> guard(lock);
+                    resume_cv.wait(guard, [&]() { return member.resume || cancel; });
+                    if (cancel) {
+                        return;
+                    }
+                    member.resume = false;
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (member_exception == nullptr) {
+                        member_exception = std::current_exception();
+                    }
+                }
+                post(l_undef, no_lengths);
+            }
+        };
+
+        for (size_t i = 0; i < members.size(); ++i) {
+            members[i].proc->set_cancel_flag(&cancel);
+            members[i].thread = std::thread(member_thread, i);
+        }
+
+        lbool answer = l_undef;
+        Kind decided_by = Kind::LENGTH;
+        size_t running = members.size();
+        // with m_params.m_deterministic, the messages are processed in turns of the running members by rank
+        std::vector<bool> stopped(members.size(), false);
+        size_t turn = 0;
+        // disjunction of the unsatisfiable lengths of the solutions of each member (blocked if it has no other solution)
+        expr_ref_vector block_lens(m);
+        for (size_t i = 0; i < members.size(); ++i) {
+            block_lens.push_back(m.mk_false());
+        }
+        while (answer == l_undef && running > 0) {
+            PortfolioMessage msg{0, l_undef, {LenNode(LenFormulaType::TRUE), LenNodePrecision::PRECISE}};
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                if (m_params.m_deterministic) {
+                    // each member posts at most one message before it is resumed
+                    auto of_turn = [&]() {
+                        return std::find_if(messages.begin(), messages.end(), [&](const PortfolioMessage& msg) { return msg.member == turn; });
+                    };
+                    messages_cv.wait(guard, [&]() { return of_turn() != messages.end(); });
+                    auto it = of_turn();
+                    msg = std::move(*it);
+                    messages.erase(it);
+                } else {
+                    messages_cv.wait(guard, [&]() { return !messages.empty(); });
+                    msg = std::move(messages.front());
+                    messages.pop_front();
+                }
+            }
+            PortfolioMember& member = members[msg.member];
+            decided_by = member.kind;
+
+            if (msg.result == l_true) {
+                expr_ref lengths = len_node_to_z3_formula(msg.lengths.first);
+                if (check_len_sat(lengths) == l_true) {
+                    answer = l_true;
+                } else if (member.kind == Kind::LENGTH) {
+                    STRACE("str", tout << "portfolio: unsat lengths from member " << msg.member << ": " << mk_pp(lengths, m) << std::endl);
+                    // the length-based procedure has only one solution
+                    --running;
+                    stopped[msg.member] = true;
+                    if (msg.lengths.second != LenNodePrecision::UNDERAPPROX) {
+                        block_curr_len(lengths);
+                        answer = l_false;
+                    }
+                } else {
+                    STRACE("str", tout << "portfolio: unsat lengths from member " << msg.member << ": " << mk_pp(lengths, m) << std::endl);
+                    block_lens.set(msg.member, m.mk_or(block_lens.get(msg.member), lengths));
+                    std::lock_guard<std::mutex> guard(lock);
+                    member.resume = true;
+                    resume_cv.notify_all();
+                }
+            } else {
+                --running;
+                stopped[msg.member] = true;
+                // unsat from underapproximation does not mean anything
+                if (msg.result == l_false && member.kind == Kind::LENGTH) {
+                    block_curr_len(expr_ref(m.mk_false(), m));
+                    answer = l_false;
+                } else if (msg.result == l_false && (member.kind == Kind::NIELSEN || member.kind == Kind::BOUNDED)) {
+                    block_curr_len(expr_ref(block_lens.get(msg.member), m));
+                    answer = l_false;
+                }
+            }
+
+            STRACE("str", if (answer != l_undef) { tout << "portfolio: " << answer << " from member " << msg.member << std::endl; });
+            if (running > 0) {
+                do {
+                    turn = (turn + 1) % members.size();
+                } while (stopped[turn]);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            cancel = true;
+            resume_cv.notify_all();
+        }
+        for (PortfolioMember& member : members) {
+            member.thread.join();
+        }
+        if (underapprox_proc != nullptr) {
+            add_dec_proc_stats(underapprox_proc->get_stats());
+        }
+        if (member_exception != nullptr) {
+            std::rethrow_exception(member_exception);
+        }
+
+        if (answer != l_undef) {
+            switch (decided_by) {
+            case Kind::LENGTH:
+                ++m_stats.m_solved_length_proc;
+                break;
+            case Kind::NIELSEN:
+                ++m_stats.m_solved_nielsen;
+                break;
+            case Kind::UNDERAPPROX:
+                ++m_stats.m_solved_underapprox;
+                break;
+            case Kind::BOUNDED:
+                ++m_stats.m_solved_bounded;
+                break;
+            case Kind::SLS:
+                ++m_stats.m_solved_sls;
+                // the member does not run anymore and its words are the ones of the accepted solution
+                set_sls_words(*sls_proc, symbols);
+                break;
+            }
+        }
+        return answer;
+    }
+#endif
 }
@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include "util/z3_exception.h"
+#include "ast/ast_util.h"
 
 #include "util.h"
 #include "theory_str_noodler.h"
@@ -100,7 +101,8 @@ namespace smt::noodler::util {
     }
 
     void collect_terms(app* const ex, ast_manager& m, const seq_util& m_util_s, obj_map<expr, expr*>& pred_replace,
-                       std::map<BasicTerm, expr_ref>& var_name, std::vector<BasicTerm>& terms) {
+                       std::map<BasicTerm, expr_ref>& var_name, std::vector<BasicTerm>& terms,
+                       std::vector<std::pair<expr*, expr*>>* replaced) {
 
         if(m_util_s.str.is_string(ex)) { // Handle string literals.
             terms.emplace_back(BasicTermType::Literal, ex->get_parameter(0).get_zstring());
@@ -117,15 +119,18 @@ namespace smt::noodler::util {
 
         if(!m_util_s.str.is_concat(ex)) {
             expr* rpl = pred_replace.find(ex); // dies if it is not found
-            collect_terms(to_app(rpl), m, m_util_s, pred_replace, var_name, terms);
+            if (replaced != nullptr) {
+                replaced->emplace_back(ex, rpl);
+            }
+            collect_terms(to_app(rpl), m, m_util_s, pred_replace, var_name, terms, replaced);
             return;
         }
 
         SASSERT(ex->get_num_args() == 2);
         app *a_x = to_app(ex->get_arg(0));
         app *a_y = to_app(ex->get_arg(1));
-        collect_terms(a_x, m, m_util_s, pred_replace, var_name, terms);
-        collect_terms(a_y, m, m_util_s, pred_replace, var_name, terms);
+        collect_terms(a_x, m, m_util_s, pred_replace, var_name, terms, replaced);
+        collect_terms(a_y, m, m_util_s, pred_replace, var_name, terms, replaced);
     }
 
     BasicTerm get_variable_basic_term(expr *const variable) {
@@ -169,6 +174,16 @@ namespace smt::noodler::util {
     }
 
     expr_ref len_to_expr(const LenNode &node, const std::map<BasicTerm, expr_ref>& variable_map, ast_manager &m, seq_util& m_util_s, arith_util& m_util_a) {
+        // n-ary operators are created directly from all successors (instead of nesting binary ones), so the size
+        // of the result is linear in the size of the formula (and equal subterms are shared by the ast manager)
+        auto succ_to_expr = [&]() {
+            expr_ref_vector res(m);
+            for (const LenNode& succ_node : node.succ) {
+                res.push_back(len_to_expr(succ_node, variable_map, m, m_util_s, m_util_a));
+            }
+            return res;
+        };
+
         switch(node.type) {
         case LenFormulaType::LEAF:
             if(node.atom_val.get_type() == BasicTermType::Length)
@@ -198,21 +213,22 @@ namespace smt::noodler::util {
         case LenFormulaType::PLUS: {
             if (node.succ.size() == 0)
                 return expr_ref(m_util_a.mk_int(0), m);
-            expr_ref plus = len_to_expr(node.succ[0], variable_map, m, m_util_s, m_util_a);
-            for(size_t i = 1; i < node.succ.size(); i++) {
-                plus = m_util_a.mk_add(plus, len_to_expr(node.succ[i], variable_map, m, m_util_s, m_util_a));
-            }
-            return plus;
+            expr_ref_vector summands = succ_to_expr();
+            return expr_ref(m_util_a.mk_add(summands.size(), summands.data()), m);
         }
 
         case LenFormulaType::TIMES: {
             if (node.succ.size() == 0)
                 return expr_ref(m_util_a.mk_int(1), m);
-            expr_ref times = len_to_expr(node.succ[0], variable_map, m, m_util_s, m_util_a);
-            for(size_t i = 1; i < node.succ.size(); i++) {
-                times = m_util_a.mk_mul(times, len_to_expr(node.succ[i], variable_map, m, m_util_s, m_util_a));
-            }
-            return times;
+            expr_ref_vector factors = succ_to_expr();
+            return expr_ref(m_util_a.mk_mul(factors.size(), factors.data()), m);
+        }
+
+        case LenFormulaType::MOD: {
+            assert(node.succ.size() == 2);
+            expr_ref left = len_to_expr(node.succ[0], variable_map, m, m_util_s, m_util_a);
+            expr_ref right = len_to_expr(node.succ[1], variable_map, m, m_util_s, m_util_a);
+            return expr_ref(m_util_a.mk_mod(left, right), m);
         }
 
         case LenFormulaType::EQ: {
@@ -253,21 +269,13 @@ namespace smt::noodler::util {
         case LenFormulaType::AND: {
             if(node.succ.size() == 0)
                 return expr_ref(m.mk_true(), m);
-            expr_ref andref = len_to_expr(node.succ[0], variable_map, m, m_util_s, m_util_a);
-            for(size_t i = 1; i < node.succ.size(); i++) {
-                andref = m.mk_and(andref, len_to_expr(node.succ[i], variable_map, m, m_util_s, m_util_a));
-            }
-            return andref;
+            return ::mk_and(succ_to_expr());
         }
 
         case LenFormulaType::OR: {
             if(node.succ.size() == 0)
                 return expr_ref(m.mk_false(), m);
-            expr_ref orref = len_to_expr(node.succ[0], variable_map, m, m_util_s, m_util_a);
-            for(size_t i = 1; i < node.succ.size(); i++) {
-                orref = m.mk_or(orref, len_to_expr(node.succ[i], variable_map, m, m_util_s, m_util_a));
-            }
-            return orref;
+            return ::mk_or(succ_to_expr());
         }
 
         case LenFormulaType::TRUE: {
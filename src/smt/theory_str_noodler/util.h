@@ -96,11 +96,13 @@ namespace smt::noodler::util {
      * @param m_util_s Seq util for AST
      * @param pred_replace Replacement of predicate and functions
      * @param[out] terms Vector of found BasicTerm (in right order).
+     * @param[out] replaced If not nullptr, the terms replaced using @p pred_replace (with their replacements) are appended to it.
      *
      * TODO: Test.
      */
     void collect_terms(app* ex, ast_manager& m, const seq_util& m_util_s, obj_map<expr, expr*>& pred_replace,
-                       std::map<BasicTerm, expr_ref>& var_name, std::vector<BasicTerm>& terms
+                       std::map<BasicTerm, expr_ref>& var_name, std::vector<BasicTerm>& terms,
+                       std::vector<std::pair<expr*, expr*>>* replaced = nullptr
     );
 
     /**
@@ -161,15 +163,13 @@ namespace smt::noodler::util {
     /**
      * @brief Create a fresh noodler (BasicTerm) variable with a given @p name followed by a unique suffix.
      * 
-     * The suffix contains a number which is incremented for each use of this function for a given @p name
-     * 
+     * The suffix contains a number which is incremented for each use of this function for a given @p name, the name
+     * is rendered only when it is needed (see BasicTerm::mk_fresh_variable()).
+     *
      * @param name Infix of the name (rest is added to get a unique name)
      */
     inline BasicTerm mk_noodler_var_fresh(const std::string& name) {
-        // TODO kinda ugly, function is defined in header and have static variable
-        // so it needs to be inline, maybe we should define some variable handler class
-        static std::map<std::string,unsigned> next_id_of_name;
-        return BasicTerm{BasicTermType::Variable, name + std::string("!n") + std::to_string((next_id_of_name[name])++)};
+        return BasicTerm::mk_fresh_variable(name);
     }
 
     /**
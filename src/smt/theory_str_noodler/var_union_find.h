@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <optional>
 
 #include "smt/params/smt_params.h"
 #include "ast/arith_decl_plugin.h"
@@ -27,19 +28,53 @@
 namespace smt::noodler {
 
     typedef std::vector<std::set<BasicTerm>> BasicTermEqiv;
+    // representative of the class of each term of BasicTermEqiv (classes sharing a term are merged)
+    typedef std::unordered_map<BasicTerm, BasicTerm> BasicTermEqivIndex;
 
-    static bool ec_are_equal(const BasicTermEqiv& ec, const BasicTerm& t1, const BasicTerm& t2) {
-        for(const auto& st: ec) {
-            if(st.find(t1) != st.end() && st.find(t2) != st.end()) {
-                return true;
+    /**
+     * @brief Get the index of the equivalence classes @p ec, so that ec_are_equal() is answered in constant time.
+     */
+    static BasicTermEqivIndex ec_get_index(const BasicTermEqiv& ec) {
+        BasicTermEqivIndex index;
+        std::function<BasicTerm(const BasicTerm&)> find = [&](const BasicTerm& t) -> BasicTerm {
+            auto it = index.find(t);
+            if(it == index.end() || it->second == t) {
+                return t;
+            }
+            BasicTerm repr = find(it->second);
+            index.at(t) = repr;
+            return repr;
+        };
+        for(const auto& st : ec) {
+            if(st.empty()) {
+                continue;
+            }
+            BasicTerm repr = find(*st.begin());
+            index.try_emplace(repr, repr);
+            for(const BasicTerm& t : st) {
+                BasicTerm t_repr = find(t);
+                if(t_repr != repr) {
+                    index.insert_or_assign(t_repr, repr);
+                }
             }
         }
-        return false;
+        // compress all paths, so that the representative is obtained by one lookup
+        for(auto& pr : index) {
+            pr.second = find(pr.second);
+        }
+        return index;
+    }
+
+    static bool ec_are_equal(const BasicTermEqivIndex& index, const BasicTerm& t1, const BasicTerm& t2) {
+        auto it1 = index.find(t1);
+        auto it2 = index.find(t2);
+        return it1 != index.end() && it2 != index.end() && it1->second == it2->second;
     }
 
     /**
      * @brief Class for union-find like data structure. Allows to handle equivalence classes of 
-     * z3 expressions. It is implemented naively so-far.
+     * z3 expressions. The classes are backtrackable: items added after push_scope() are removed
+     * by the corresponding pop_scope().
      * 
      */
     class var_union_find {
@@ -47,6 +82,33 @@ namespace smt::noodler {
         obj_map<expr, obj_hashtable<expr>> un_find;
         arith_util& m_util_a;
 
+        // items (key, value) newly added to un_find, in the order of addition
+        std::vector<std::pair<expr*, expr*>> trail;
+        // sizes of trail at the pushed scopes
+        std::vector<size_t> scopes;
+
+        // classes of BasicTerms (without filtering by lengths of automata) computed from un_find, together with
+        // the fixed lengths given by numeral keys (-1 if the key is not a numeral); empty if un_find changed
+        mutable std::optional<std::vector<std::pair<int, std::set<BasicTerm>>>> bt_classes;
+        // word lengths of automata (the automata are kept alive, so their addresses cannot be reused)
+        mutable std::unordered_map<const mata::nfa::Nfa*, std::pair<std::shared_ptr<mata::nfa::Nfa>, std::set<std::pair<int, int>>>> word_lengths;
+        // the memo of word lengths is dropped after reaching this number of entries
+        static constexpr size_t max_word_lengths = 10000;
+
+        /**
+         * @brief Get the memoized word lengths of the automaton @p aut (see mata::strings::get_word_lengths).
+         */
+        const std::set<std::pair<int, int>>& get_word_lengths(const std::shared_ptr<mata::nfa::Nfa>& aut) const {
+            auto it = this->word_lengths.find(aut.get());
+            if(it == this->word_lengths.end()) {
+                if(this->word_lengths.size() >= max_word_lengths) {
+                    this->word_lengths.clear();
+                }
+                it = this->word_lengths.emplace(aut.get(), std::make_pair(aut, mata::strings::get_word_lengths(*aut))).first;
+            }
+            return it->second.second;
+        }
+
     public:
         var_union_find(arith_util& m_util_a) : un_find(), m_util_a(m_util_a) { }
 
@@ -58,15 +120,40 @@ namespace smt::noodler {
          * @param val Value (variable) associated with the key.
          */
         void add(const expr_ref& key, const expr_ref& val) {
-            obj_hashtable<expr> found;
-            if(this->un_find.find(key, found)) {
-                this->un_find[key].insert(val);
-            } else {
-                found.insert(val);
-                this->un_find.insert(key, found);
+            auto* entry = this->un_find.insert_if_not_there3(key, obj_hashtable<expr>());
+            if(!entry->get_data().m_value.contains(val)) {
+                entry->get_data().m_value.insert(val);
+                this->trail.emplace_back(key.get(), val.get());
+                this->bt_classes.reset();
             }
         }
 
+        void push_scope() {
+            this->scopes.push_back(this->trail.size());
+        }
+
+        /**
+         * @brief Remove the items added after the last @p num_scopes calls of push_scope().
+         */
+        void pop_scope(unsigned num_scopes) {
+            SASSERT(num_scopes <= this->scopes.size());
+            size_t old_size = this->scopes[this->scopes.size() - num_scopes];
+            this->scopes.resize(this->scopes.size() - num_scopes);
+            if(old_size == this->trail.size()) {
+                return;
+            }
+            while(this->trail.size() > old_size) {
+                auto [key, val] = this->trail.back();
+                this->trail.pop_back();
+                obj_hashtable<expr>& vals = this->un_find[key];
+                vals.remove(val);
+                if(vals.empty()) {
+                    this->un_find.remove(key);
+                }
+            }
+            this->bt_classes.reset();
+        }
+
         /**
          * @brief Get the equivalence classes
          */
@@ -81,26 +168,37 @@ namespace smt::noodler {
          * @return Equivalence classes consisting of BasicTerms
          */
         BasicTermEqiv get_equivalence_bt(const AutAssignment& aut_ass) const {
+            if(!this->bt_classes.has_value()) {
+                this->bt_classes.emplace();
+                for(const auto& t : this->un_find) {
+                    int len = -1;
+                    rational val;
+                    if(this->m_util_a.is_numeral(t.m_key, val)) {
+                        len = val.get_int32();
+                    }
+                    std::set<BasicTerm> st;
+                    for (const auto& s : t.m_value) {
+                        std::string var = to_app(s)->get_decl()->get_name().str();
+                        st.insert(BasicTerm(BasicTermType::Variable, var));
+                    }
+                    this->bt_classes->emplace_back(len, std::move(st));
+                }
+            }
+
             std::vector<std::set<BasicTerm>> ret;
-            for(const auto& t : this->un_find) {
-                std::set<BasicTerm> st;
-                int len = -1;
-                rational val;
-                if(this->m_util_a.is_numeral(t.m_key, val)) {
-                    len = val.get_int32();
+            for(const auto& [len, cls] : *this->bt_classes) {
+                if(len <= 1) {
+                    ret.push_back(cls);
+                    continue;
                 }
-                for (const auto& s : t.m_value) {
-                    std::string var = to_app(s)->get_decl()->get_name().str();
-                    BasicTerm bvar(BasicTermType::Variable, var);
-                    
-                    if(len != -1 && len > 1) {
-                        std::set<std::pair<int, int>> aut_constr = mata::strings::get_word_lengths(*aut_ass.at(bvar));
-                        if(aut_constr.size() > 1 || !aut_constr.contains({len, 0})) {
-                            continue;
-                        }
+                // only variables whose automata have the fixed length len remain in the class
+                std::set<BasicTerm> st;
+                for (const BasicTerm& bvar : cls) {
+                    const std::set<std::pair<int, int>>& aut_constr = get_word_lengths(aut_ass.at(bvar));
+                    if(aut_constr.size() > 1 || !aut_constr.contains({len, 0})) {
+                        continue;
                     }
-                    
-                    st.insert(bvar);  
+                    st.insert(bvar);
                 }
                 ret.push_back(st);
             }
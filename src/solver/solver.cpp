@@ -27,6 +27,12 @@ Notes:
 #include "params/solver_params.hpp"
 #include "model/model_evaluator.h"
 #include "model/model_params.hpp"
+#ifndef SINGLE_THREAD
+#include <atomic>
+#include <thread>
+#include "util/scoped_ptr_vector.h"
+#include "ast/ast_translation.h"
+#endif
 
 
 unsigned solver::get_num_assertions() const {
@@ -329,6 +335,92 @@ lbool solver::check_sat(unsigned num_assumptions, expr * const * assumptions) {
     return r;
 }
 
+void solver::check_sat_batch(vector<expr_ref_vector> const& sets, unsigned num_threads, svector<lbool>& results, vector<expr_ref_vector>* cores) {
+    ast_manager& m = get_manager();
+    unsigned n = sets.size();
+    results.reset();
+    results.resize(n, l_undef);
+    if (cores) {
+        cores->reset();
+        for (unsigned i = 0; i < n; ++i)
+            cores->push_back(expr_ref_vector(m));
+    }
+    num_threads = std::min(num_threads, n);
+#ifndef SINGLE_THREAD
+    if (num_threads > 1 && !m.has_trace_stream()) {
+        // the managers outlive the solvers and expressions that live in them
+        scoped_ptr_vector<ast_manager> managers;
+        scoped_limits scl(m.limit());
+        sref_vector<solver> solvers;
+        vector<vector<expr_ref_vector>> local_sets;
+        bool translated = true;
+        try {
+            for (unsigned t = 0; t < num_threads; ++t) {
+                ast_manager* wm = alloc(ast_manager, m, !m.proof_mode());
+                managers.push_back(wm);
+                scl.push_child(&wm->limit());
+                solvers.push_back(translate(*wm, get_params()));
+                ast_translation tr(m, *wm);
+                local_sets.push_back(vector<expr_ref_vector>());
+                for (expr_ref_vector const& s : sets)
+                    local_sets.back().push_back(tr(s));
+            }
+        }
+        catch (z3_exception&) {
+            // the solver cannot be copied, check the sets on this solver
+            translated = false;
+        }
+        if (translated) {
+            std::atomic<unsigned> next(0);
+            unsigned_vector owner(n, UINT_MAX);
+            auto worker = [&](unsigned t) {
+                solver& s = *solvers.get(t);
+                unsigned i;
+                while ((i = next++) < n && managers[t]->inc()) {
+                    owner[i] = t;
+                    try {
+                        results[i] = s.check_sat(local_sets[t][i]);
+                    }
+                    catch (z3_exception&) {
+                        results[i] = l_undef;
+                    }
+                    if (results[i] == l_false && cores) {
+                        expr_ref_vector core(*managers[t]);
+                        s.get_unsat_core(core);
+                        local_sets[t][i].reset();
+                        local_sets[t][i].append(core);
+                    }
+                }
+            };
+            vector<std::thread> threads(num_threads);
+            for (unsigned t = 0; t < num_threads; ++t)
+                threads[t] = std::thread([&, t]() { worker(t); });
+            for (unsigned t = 0; t < num_threads; ++t)
+                threads[t].join();
+            if (cores) {
+                for (unsigned i = 0; i < n; ++i) {
+                    if (results[i] != l_false)
+                        continue;
+                    ast_translation tr(*managers[owner[i]], m, false);
+                    (*cores)[i].append(tr(local_sets[owner[i]][i]));
+                }
+            }
+            return;
+        }
+    }
+#endif
+    for (unsigned i = 0; i < n && m.inc(); ++i) {
+        try {
+            results[i] = check_sat(sets[i]);
+        }
+        catch (z3_exception&) {
+            results[i] = l_undef;
+        }
+        if (results[i] == l_false && cores)
+            get_unsat_core((*cores)[i]);
+    }
+}
+
 void solver::dump_state(unsigned sz, expr* const* assumptions) {
     if ((symbol::null != m_cancel_backup_file) &&
         !m_cancel_backup_file.is_numerical() && 
@@ -163,6 +163,18 @@ public:
 
     lbool check_sat() { return check_sat(0, nullptr); }
 
+    /**
+       \brief Check the assertions modulo each of the given sets of assumptions.
+
+       results[i] is the outcome for sets[i], and if cores is not null, (*cores)[i] is an unsat-core
+       for sets[i] (empty if the set is not unsatisfiable).
+       With num_threads <= 1 the sets are checked one after another on this solver, so that lemmas
+       learned for one set are reused for the next ones. Otherwise, the sets are distributed over
+       num_threads translated copies of this solver. A set whose check raised an exception
+       gets l_undef.
+    */
+    void check_sat_batch(vector<expr_ref_vector> const& sets, unsigned num_threads, svector<lbool>& results, vector<expr_ref_vector>* cores);
+
     /**
        \brief Check satisfiability modulo a cube and a clause.
 
@@ -350,12 +350,15 @@ ptr_vector<solver> solver_pool::get_base_solvers() const {
             solvers.push_back(s->base_solver());
         }
     }
+    for (warm_solver const& w : m_warm)
+        solvers.push_back(w.m_solver.get());
     return solvers;
 }
 
 void solver_pool::updt_params(const params_ref &p) {
     m_base_solver->updt_params(p);
     for (solver *s : m_solvers) s->updt_params(p);
+    for (warm_solver& w : m_warm) w.m_solver->updt_params(p);
 }
 void solver_pool::collect_statistics(statistics &st) const {
     ptr_vector<solver> solvers = get_base_solvers();
@@ -367,6 +370,9 @@ void solver_pool::collect_statistics(statistics &st) const {
     st.update("pool_solver.checks", m_stats.m_num_checks);
     st.update("pool_solver.checks.sat", m_stats.m_num_sat_checks);
     st.update("pool_solver.checks.undef", m_stats.m_num_undef_checks);
+    st.update("pool_solver.warm.acquired", m_stats.m_num_acquired);
+    st.update("pool_solver.warm.created", m_stats.m_num_warm_created);
+    st.update("pool_solver.warm.evicted", m_stats.m_num_warm_evicted);
 }
 
 void solver_pool::reset_statistics() {
@@ -424,3 +430,58 @@ void solver_pool::refresh(solver* base_solver) {
         }
     }
 }
+
+/**
+   \brief Check out a warm copy of the base solver for one query.
+   Unlike the solvers of mk_solver, the copies are not shared between queries
+   at the same time: a copy internalizes the base assertions once and keeps the
+   lemmas and theory caches it gathers at the base level for the following
+   queries. The query is asserted in a fresh scope that release_solver pops.
+   The memory retained by a copy is measured as the growth of the allocation
+   size while it is checked out, so the pool should be used by one thread.
+*/
+solver* solver_pool::acquire_solver() {
+    m_stats.m_num_acquired++;
+    unsigned idx = m_warm.size();
+    for (unsigned i = 0; i < m_warm.size(); ++i) {
+        if (!m_warm[i].m_busy) {
+            idx = i;
+            break;
+        }
+    }
+    if (idx == m_warm.size()) {
+        ast_manager& m = m_base_solver->get_manager();
+        m_warm.push_back(warm_solver());
+        m_warm.back().m_solver = m_base_solver->translate(m, m_base_solver->get_params());
+        m_stats.m_num_warm_created++;
+    }
+    warm_solver& w = m_warm[idx];
+    w.m_busy = true;
+    w.m_start = memory::get_allocation_size();
+    w.m_solver->push();
+    return w.m_solver.get();
+}
+
+/**
+   \brief Return a solver checked out by acquire_solver to the pool.
+*/
+void solver_pool::release_solver(solver* s) {
+    unsigned idx = 0;
+    while (idx < m_warm.size() && m_warm[idx].m_solver.get() != s)
+        ++idx;
+    SASSERT(idx < m_warm.size() && m_warm[idx].m_busy);
+    if (idx == m_warm.size())
+        return;
+    warm_solver& w = m_warm[idx];
+    s->pop(s->get_scope_level());
+    unsigned long long size = memory::get_allocation_size();
+    if (size > w.m_start)
+        w.m_memory += size - w.m_start;
+    w.m_busy = false;
+    if (m_max_warm_memory != 0 && w.m_memory > m_max_warm_memory) {
+        IF_VERBOSE(2, verbose_stream() << "(solver-pool :evict-solver " << (w.m_memory >> 20) << "MB)\n");
+        m_stats.m_num_warm_evicted++;
+        m_warm[idx] = m_warm.back();
+        m_warm.pop_back();
+    }
+}
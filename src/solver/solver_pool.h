@@ -37,14 +37,27 @@ class solver_pool {
         unsigned m_num_checks;
         unsigned m_num_sat_checks;
         unsigned m_num_undef_checks;
+        unsigned m_num_acquired;
+        unsigned m_num_warm_created;
+        unsigned m_num_warm_evicted;
         stats() { reset(); }
         void reset() { memset(this, 0, sizeof(*this)); }
     };
 
+    // copy of the base solver that is reused for many queries
+    struct warm_solver {
+        ref<solver>        m_solver;
+        unsigned long long m_memory = 0; // memory retained by the queries the solver answered
+        unsigned long long m_start = 0;  // allocation size when the solver was acquired
+        bool               m_busy = false;
+    };
+
     ref<solver>         m_base_solver;
     unsigned            m_num_pools;
     unsigned            m_current_pool;
     sref_vector<solver> m_solvers;
+    vector<warm_solver> m_warm;
+    unsigned long long  m_max_warm_memory = 0;
     stats               m_stats;
 
     stopwatch m_check_watch;
@@ -67,6 +80,15 @@ public:
     void reset_solver(solver* s);
     void updt_params(const params_ref &p);
 
+    solver* acquire_solver();
+    void release_solver(solver* s);
+
+    /**
+       \brief Evict a warm solver on release once the queries it answered retained more
+       than max_memory_mb megabytes. A limit of 0 keeps the solvers regardless of memory.
+    */
+    void set_max_warm_memory(unsigned max_memory_mb) { m_max_warm_memory = static_cast<unsigned long long>(max_memory_mb) << 20; }
+
 };
 
 
@@ -0,0 +1,55 @@
+/*++
+
+Module Name:
+
+    seq_eqs_tactic.h
+
+Tactic Documentation:
+
+## Tactic seq-eqs
+
+### Short Description
+
+Simplifies top-level string equations.
+
+### Long Description
+
+The tactic strips common prefixes and suffixes of the two sides of string
+equations, splits equations with an empty side into equations of the
+remaining atoms with the empty string, and replaces variables that are
+equal to other variables or to the empty string. Replaced variables are
+reconstructed in models.
+
+### Example
+
+```z3
+(declare-const x String)
+(declare-const y String)
+(declare-const z String)
+(assert (= (str.++ "ab" x y) (str.++ "ab" z y)))
+(assert (= (str.++ x z) ""))
+(apply seq-eqs)
+```
+
+### Notes
+
+* supports unsat cores
+* does not support proofs
+
+--*/
+#pragma once
+
+#include "util/params.h"
+#include "tactic/tactic.h"
+#include "tactic/dependent_expr_state_tactic.h"
+#include "ast/simplifiers/seq_eq_simplifier.h"
+
+inline tactic * mk_seq_eqs_tactic(ast_manager & m, params_ref const & p = params_ref()) {
+    return alloc(dependent_expr_state_tactic, m, p,
+                 [](auto& m, auto& p, auto &s) -> dependent_expr_simplifier* { return alloc(seq_eq_simplifier, m, p, s); });
+}
+
+/*
+  ADD_TACTIC("seq-eqs", "simplify top-level string equations.", "mk_seq_eqs_tactic(m, p)")
+  ADD_SIMPLIFIER("seq-eqs", "simplify top-level string equations.", "alloc(seq_eq_simplifier, m, p, s)")
+*/
@@ -56,6 +56,8 @@ protected:
     dependency_converter_ref m_dc;
     unsigned              m_ref_count;
     std::string           m_reason_unknown;
+    // persistent arrays: copying a goal shares them, and only updated positions are duplicated.
+    // m_proofs is empty if proofs are disabled, m_dependencies is empty if cores are disabled.
     expr_array            m_forms;
     expr_array            m_proofs;
     expr_dependency_array m_dependencies;
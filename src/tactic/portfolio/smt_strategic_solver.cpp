@@ -31,6 +31,7 @@ Notes:
 #include "tactic/smtlogics/qfaufbv_tactic.h"
 #include "tactic/smtlogics/qfufbv_tactic.h"
 #include "tactic/smtlogics/qfidl_tactic.h"
+#include "tactic/smtlogics/qfs_tactic.h"
 #include "tactic/smtlogics/nra_tactic.h"
 #include "tactic/portfolio/default_tactic.h"
 #include "tactic/fd_solver/fd_solver.h"
@@ -46,6 +47,7 @@ Notes:
 #include "solver/parallel_tactical.h"
 #include "solver/parallel_params.hpp"
 #include "params/tactic_params.hpp"
+#include "smt/params/smt_params_helper.hpp"
 #include "parsers/smt2/smt2parser.h"
 #include "sat/sat_params.hpp"
 
@@ -100,6 +102,8 @@ tactic * mk_tactic_for_logic(ast_manager & m, params_ref const & p, symbol const
         return mk_qffpbv_tactic(m, p);
     else if (logic=="HORN")
         return mk_horn_tactic(m, p);
+    else if ((logic=="QF_S" || logic=="QF_SLIA") && smt_params_helper(p).string_solver() == "portfolio")
+        return mk_qfs_tactic(m, p);
     else if ((logic == "QF_FD" || logic == "SAT") && !m.proofs_enabled())
         return mk_fd_tactic(m, p);
     else 
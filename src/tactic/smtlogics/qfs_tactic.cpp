@@ -0,0 +1,51 @@
+/*++
+
+Module Name:
+
+    qfs_tactic.cpp
+
+Abstract:
+
+    Tactic for QF_S and QF_SLIA benchmarks.
+
+--*/
+#ifndef SINGLE_THREAD
+#include <thread>
+#endif
+#include "tactic/tactical.h"
+#include "tactic/core/simplify_tactic.h"
+#include "tactic/core/seq_eqs_tactic.h"
+#include "tactic/smtlogics/qflia_tactic.h"
+#include "tactic/smtlogics/smt_tactic.h"
+#include "tactic/smtlogics/qfs_tactic.h"
+#include "solver/parallel_params.hpp"
+
+static tactic * mk_string_solver_tactic(ast_manager & m, params_ref const & p, char const * string_solver) {
+    params_ref solver_p;
+    solver_p.set_sym("string_solver", symbol(string_solver));
+    // the translated copies of par do not inherit the logic set by set_logic
+    solver_p.set_sym("logic", symbol("QF_SLIA"));
+    return using_params(mk_smt_tactic(m, p), solver_p);
+}
+
+tactic * mk_qfs_tactic(ast_manager & m, params_ref const & p) {
+    unsigned num_threads = 1;
+#ifndef SINGLE_THREAD
+    parallel_params pp(p);
+    num_threads = std::min(std::thread::hardware_concurrency(), pp.threads_max());
+#endif
+    tactic * st;
+    if (num_threads < 2) {
+        params_ref static_p;
+        static_p.set_sym("string_solver", symbol("portfolio"));
+        st = using_params(mk_smt_tactic(m, p), static_p);
+    }
+    else {
+        st = par(mk_string_solver_tactic(m, p, "noodler"),
+                 mk_string_solver_tactic(m, p, "seq"));
+    }
+    return and_then(mk_simplify_tactic(m, p),
+                    mk_preamble_tactic(m),
+                    mk_seq_eqs_tactic(m, p),
+                    st);
+}
@@ -0,0 +1,30 @@
+/*++
+
+Module Name:
+
+    qfs_tactic.h
+
+Abstract:
+
+    Tactic for QF_S and QF_SLIA benchmarks.
+
+Notes:
+
+    With more than one available core, the noodler and the seq string
+    solver are raced on translated copies of the goal, the first answer
+    wins and the other solver is canceled. Otherwise the smt tactic runs
+    with smt.string_solver=portfolio, which makes smt::setup choose one
+    of the solvers from the features of the assertions.
+
+--*/
+#pragma once
+
+#include "util/params.h"
+class ast_manager;
+class tactic;
+
+tactic * mk_qfs_tactic(ast_manager & m, params_ref const & p = params_ref());
+
+/*
+  ADD_TACTIC("qfs", "builtin strategy for solving QF_S and QF_SLIA problems.", "mk_qfs_tactic(m, p)")
+*/
@@ -0,0 +1,103 @@
+/*++
+
+Module Name:
+
+    ast_serialize.cpp
+
+Abstract:
+
+    Test the binary serialization of expressions.
+
+--*/
+#include <sstream>
+#include "ast/ast_serialize.h"
+#include "ast/ast_pp.h"
+#include "ast/arith_decl_plugin.h"
+#include "ast/bv_decl_plugin.h"
+#include "ast/seq_decl_plugin.h"
+#include "ast/reg_decl_plugins.h"
+
+static void mk_exprs(ast_manager & m, expr_ref_vector & es) {
+    arith_util a(m);
+    bv_util bv(m);
+    seq_util su(m);
+    sort_ref u(m.mk_uninterpreted_sort(symbol("U")), m);
+    sort * dom[2] = { u, a.mk_int() };
+    func_decl_ref f(m.mk_func_decl(symbol("f"), 2, dom, a.mk_real()), m);
+    expr_ref c(m.mk_const(symbol("c"), u), m);
+    expr_ref x(m.mk_const(symbol("x"), a.mk_int()), m);
+    expr_ref s(m.mk_const(symbol("s"), su.str.mk_string_sort()), m);
+    expr_ref y(m.mk_const(symbol(3), bv.mk_sort(8)), m);
+
+    es.push_back(a.mk_le(m.mk_app(f.get(), c.get(), a.mk_add(x, a.mk_int(-7))), a.mk_numeral(rational(5, 3), false)));
+    es.push_back(m.mk_eq(su.str.mk_concat(s, su.str.mk_string(zstring("ab\\u{1F600}"))), s));
+    expr * ys[3] = { y, bv.mk_numeral(rational(200), 8), bv.mk_bv_add(y, y) };
+    es.push_back(m.mk_distinct(3, ys));
+    // forall v : U . f(v, x) >= 0 with the pattern f(v, x)
+    expr_ref body(a.mk_ge(m.mk_app(f.get(), m.mk_var(0, u), x.get()), a.mk_real(0)), m);
+    expr * pat_arg = to_app(body)->get_arg(0);
+    app_ref pat(m.mk_pattern(1, reinterpret_cast<app * const *>(&pat_arg)), m);
+    symbol v("v");
+    sort * us = u;
+    expr * pats[1] = { pat };
+    es.push_back(m.mk_forall(1, &us, &v, body, 0, symbol("q1"), symbol::null, 1, pats));
+    es.push_back(es.get(0));
+}
+
+static void tst_round_trip() {
+    ast_manager m;
+    reg_decl_plugins(m);
+    expr_ref_vector es(m);
+    mk_exprs(m, es);
+    std::stringstream out;
+    serialize_exprs(m, es.size(), es.data(), out);
+    std::string data = out.str();
+
+    // the same manager gets back the same nodes
+    expr_ref_vector es1(m);
+    deserialize_exprs(m, data.data(), data.size(), es1);
+    ENSURE(es1.size() == es.size());
+    for (unsigned i = 0; i < es.size(); ++i)
+        ENSURE(es1.get(i) == es.get(i));
+
+    // a fresh manager gets structurally equal expressions
+    ast_manager m2;
+    reg_decl_plugins(m2);
+    expr_ref_vector es2(m2);
+    deserialize_exprs(m2, data.data(), data.size(), es2);
+    ENSURE(es2.size() == es.size());
+    for (unsigned i = 0; i < es.size(); ++i) {
+        std::ostringstream s1, s2;
+        s1 << mk_pp(es.get(i), m);
+        s2 << mk_pp(es2.get(i), m2);
+        ENSURE(s1.str() == s2.str());
+    }
+    ENSURE(es2.get(0) == es2.get(4));
+}
+
+static void tst_malformed() {
+    ast_manager m;
+    reg_decl_plugins(m);
+    expr_ref_vector es(m);
+    mk_exprs(m, es);
+    std::stringstream out;
+    serialize_exprs(m, es.size(), es.data(), out);
+    std::string data = out.str();
+    // every truncation is rejected
+    for (size_t len = 0; len < data.size(); ++len) {
+        expr_ref_vector r(m);
+        bool failed = false;
+        try {
+            deserialize_exprs(m, data.data(), len, r);
+        }
+        catch (z3_exception &) {
+            failed = true;
+        }
+        ENSURE(failed);
+    }
+}
+
+void tst_ast_serialize() {
+    tst_round_trip();
+    tst_malformed();
+}
@@ -506,6 +506,18 @@ public:
         }        
     }
 
+    static void test_translate() {
+        std::cout << "test_translate\n";
+        bdd_manager m1(4), m2(2);
+        bdd v0 = m1.mk_var(0), v1 = m1.mk_var(1), v3 = m1.mk_var(3);
+        bdd c = (v0 && !v1) || (v1 ^ v3);
+        bdd d = m2.translate(c);
+        bdd w0 = m2.mk_var(0), w1 = m2.mk_var(1), w3 = m2.mk_var(3);
+        VERIFY(d == ((w0 && !w1) || (w1 ^ w3)));
+        VERIFY(m1.translate(d) == c);
+        VERIFY(m2.translate(m1.mk_true()).is_true());
+    }
+
 
 
 };
@@ -532,4 +544,5 @@ void tst_bdd() {
     dd::test_bdd::test_cofactor();
     dd::test_bdd::test_inf();
     dd::test_bdd::test_sup();
+    dd::test_bdd::test_translate();
 }
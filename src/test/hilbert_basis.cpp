@@ -596,11 +596,37 @@ static void test_A_5_5_3() {
     saturate_basis(hb);
 }
 
+// the basis computed with several threads is the same as the sequential one
+static void tst_threads() {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        unsigned sizes[2];
+        for (unsigned t = 0; t < 2; ++t) {
+            random_gen rand(seed);
+            reslimit rl;
+            hilbert_basis hb(rl);
+            hb.set_use_ordered_support(true);
+            hb.set_num_threads(t == 0 ? 1 : 4);
+            for (unsigned i = 0; i < 4; ++i) {
+                vector<rational> nv;
+                for (unsigned j = 0; j < 5; ++j) 
+                    nv.push_back(rational(3 - static_cast<int>(rand(7))));
+                hb.add_ge(nv, rational(2 - static_cast<int>(rand(5))));
+            }
+            lbool is_sat = hb.saturate();
+            sizes[t] = is_sat == l_true ? hb.get_basis_size() : 0;
+        }
+        std::cout << "basis size " << sizes[0] << " " << sizes[1] << "\n";
+        ENSURE(sizes[0] == sizes[1]);
+    }
+}
+
 void tst_hilbert_basis() {
     std::cout << "hilbert basis test\n";
 //    tst3();
 //    return;
 
+    tst_threads();
+
     g_use_ordered_support = true;
 
     test_A_5_5_3();
@@ -156,6 +156,7 @@ int main(int argc, char ** argv) {
     TST(rational);
     TST(inf_rational);
     TST(ast);
+    TST(ast_serialize);
     TST(optional);
     TST(bit_vector);
     TST(fixed_bit_vector);
@@ -2,11 +2,53 @@
 #include "model/model_evaluator.h"
 #include "model/model_pp.h"
 #include "ast/arith_decl_plugin.h"
+#include "ast/seq_decl_plugin.h"
 #include "ast/reg_decl_plugins.h"
 #include "ast/ast_pp.h"
 #include <iostream>
 
+static void tst_incremental() {
+    ast_manager m;
+    reg_decl_plugins(m);
+    arith_util a(m);
+    seq_util su(m);
+    expr_ref x(m.mk_const(symbol("x"), a.mk_int()), m);
+    expr_ref y(m.mk_const(symbol("y"), a.mk_int()), m);
+    expr_ref s(m.mk_const(symbol("s"), su.str.mk_string_sort()), m);
+    func_decl* fx = to_app(x)->get_decl(), * fy = to_app(y)->get_decl(), * fs = to_app(s)->get_decl();
+    // x*x + (if y > 0 then y else -y) + len(s ++ s)
+    expr_ref t(a.mk_add(a.mk_mul(x, x),
+                        m.mk_ite(a.mk_gt(y, a.mk_int(0)), y, a.mk_uminus(y)),
+                        su.str.mk_length(su.str.mk_concat(s, s))), m);
+    model mdl(m);
+    mdl.register_decl(fx, a.mk_int(2));
+    mdl.register_decl(fy, a.mk_int(3));
+    mdl.register_decl(fs, su.str.mk_string(zstring("ab")));
+    model_evaluator eval(mdl);
+    eval.set_model_completion(true);
+    eval.set_incremental(true);
+    auto check = [&](int expected) {
+        expr_ref v = eval(t);
+        rational r;
+        ENSURE(a.is_numeral(v, r) && r == rational(expected));
+        model_evaluator full(mdl);
+        full.set_model_completion(true);
+        ENSURE(full(t) == v);
+    };
+    check(11);
+    mdl.register_decl(fy, a.mk_int(-5));
+    eval.invalidate(fy);
+    check(13);
+    mdl.register_decl(fs, su.str.mk_string(zstring("abc")));
+    eval.invalidate(fs);
+    check(15);
+    mdl.register_decl(fx, a.mk_int(0));
+    eval.invalidate(fx);
+    check(11);
+}
+
 void tst_model_evaluator() {
+    tst_incremental();
     ast_manager m;
     reg_decl_plugins(m);
     arith_util a(m);
@@ -0,0 +1,224 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "smt/theory_str_noodler/decision_procedure.h"
+#include "smt/theory_str_noodler/formula_preprocess.h"
+#include "smt/theory_str_noodler/inclusion_graph.h"
+#include "smt/theory_str_noodler/regex.h"
+#include "smt/theory_str_noodler/theory_str_noodler.h"
+#include "ast/reg_decl_plugins.h"
+#include "test_utils.h"
+
+// Micro-benchmarks of the kernels of the noodler. Each kernel is first run once to report its throughput and the
+// allocations of one run (all allocations through operator new are counted, including those of mata), then it is
+// measured by Catch2 BENCHMARK. Run by 'bench-noodler-kernels', filtered by the tags, e.g. "[noodlification]".
+
+namespace {
+    std::atomic<unsigned long long> num_allocations{0};
+    std::atomic<unsigned long long> allocated_bytes{0};
+}
+
+void* operator new(std::size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    /**
+     * @brief Run @p kernel once and report its throughput (@p items processed items per second) and allocations.
+     */
+    template<typename Kernel>
+    void report_kernel(const std::string& name, unsigned items, Kernel&& kernel) {
+        const unsigned long long allocations_before = num_allocations.load();
+        const unsigned long long bytes_before = allocated_bytes.load();
+        const auto start = std::chrono::steady_clock::now();
+        kernel();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const unsigned long long allocations = num_allocations.load() - allocations_before;
+        const unsigned long long bytes = allocated_bytes.load() - bytes_before;
+        std::cout << name << ": " << (seconds > 0 ? items / seconds : 0) << " items/s, "
+                  << allocations << " allocations (" << bytes << " bytes) per run of " << items << " items" << std::endl;
+    }
+
+    BasicTerm var(const std::string& prefix, unsigned i) {
+        return { BasicTermType::Variable, prefix + std::to_string(i) };
+    }
+
+    /**
+     * @brief Equations x_i x_{i+1} = y_i y_{i+1} for i < @p n (each one shares variables with the next one).
+     */
+    Formula create_chain_equations(unsigned n) {
+        Formula formula;
+        for (unsigned i = 0; i < n; ++i) {
+            formula.add_predicate(Predicate(PredicateType::Equation, { { var("x", i), var("x", i + 1) }, { var("y", i), var("y", i + 1) } }));
+        }
+        return formula;
+    }
+
+    AutAssignment create_assignment(const Formula& formula, const std::string& regex) {
+        AutAssignment aut_ass;
+        auto aut = regex_to_nfa(regex);
+        for (const Predicate& pred : formula.get_predicates()) {
+            for (const auto& side : pred.get_params()) {
+                for (const BasicTerm& term : side) {
+                    aut_ass[term] = aut;
+                }
+            }
+        }
+        return aut_ass;
+    }
+}
+
+TEST_CASE("Noodler kernels", "[noodler-bench]") {
+    smt_params params;
+    ast_manager ast_m;
+    reg_decl_plugins(ast_m);
+    smt::context ctx{ast_m, params };
+    theory_str_noodler_params noodler_params{};
+    TheoryStrNoodlerCUT noodler{ ctx, ast_m, noodler_params };
+    auto& m_util_s{ noodler.m_util_s };
+    auto& m_util_a{ noodler.m_util_a };
+    auto& m{ noodler.m };
+
+    SECTION("noodlification", "[noodlification]") {
+        for (unsigned n : { 2, 4, 8 }) {
+            Formula formula = create_chain_equations(n);
+            AutAssignment aut_ass = create_assignment(formula, "(a|b)*c(a|b)*");
+            auto kernel = [&]() {
+                DecisionProcedureCUT proc(formula, aut_ass, {}, m, m_util_s, m_util_a, {}, noodler_params);
+                proc.init_computation();
+                return proc.compute_next_solution();
+            };
+            const std::string name = "noodlification of " + std::to_string(n) + " chained equations";
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+
+    SECTION("inclusion graph", "[inclusion-graph]") {
+        for (unsigned n : { 16, 64, 256 }) {
+            Formula formula = create_chain_equations(n);
+            auto kernel = [&]() {
+                return Graph::create_inclusion_graph(formula).get_nodes().size();
+            };
+            const std::string name = "inclusion graph of " + std::to_string(n) + " chained equations";
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+
+    SECTION("preprocessing", "[preprocess]") {
+        for (unsigned n : { 16, 64, 256 }) {
+            Formula formula = create_chain_equations(n);
+            AutAssignment aut_ass = create_assignment(formula, "(a|b)*");
+            auto kernel = [&]() {
+                FormulaPreprocessor prep(formula, aut_ass, {}, noodler_params);
+                prep.propagate_variables();
+                prep.propagate_eps();
+                prep.remove_regular({});
+                prep.generate_identities();
+                prep.reduce_regular_sequence(1);
+                prep.remove_trivial();
+                return prep.get_modified_formula().get_predicates().size();
+            };
+            const std::string name = "preprocessing of " + std::to_string(n) + " chained equations";
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+
+    SECTION("intersection", "[intersection]") {
+        for (unsigned n : { 4, 16, 64 }) {
+            // words containing an a at each position divisible by n and their intersection with words containing
+            // ab at least n times (the products of the preprocessing of memberships)
+            std::string regex_left = "(a(a|b){" + std::to_string(n - 1) + "})*";
+            std::string regex_right;
+            for (unsigned i = 0; i < n; ++i) {
+                regex_right += "(a|b)*ab";
+            }
+            regex_right += "(a|b)*";
+            mata::nfa::Nfa left = *regex_to_nfa(regex_left);
+            mata::nfa::Nfa right = *regex_to_nfa(regex_right);
+            auto kernel = [&]() {
+                return intersect(left, right).num_of_states();
+            };
+            const std::string name = "intersection of automata of sizes " + std::to_string(left.num_of_states())
+                + " and " + std::to_string(right.num_of_states());
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+            BENCHMARK((name + " (mata)").c_str()) { return mata::nfa::intersection(left, right).num_of_states(); };
+        }
+    }
+
+    SECTION("interval words", "[interval-words]") {
+        for (unsigned n : { 4, 8, 16 }) {
+            // all words of digits of length n
+            std::string regex;
+            for (unsigned i = 0; i < n; ++i) {
+                regex += "[0-9]";
+            }
+            mata::nfa::Nfa aut = mata::nfa::minimize(*regex_to_nfa(regex));
+            auto kernel = [&]() {
+                return AutAssignment::get_interval_words(aut).size();
+            };
+            const std::string name = "interval words of digit words of length " + std::to_string(n);
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+
+    SECTION("regex to nfa", "[conv-to-nfa]") {
+        std::set<uint32_t> symbols;
+        for (uint32_t s = 0; s < 1000; ++s) {
+            symbols.insert(s);
+        }
+        regex::Alphabet alph(symbols);
+        for (unsigned n : { 5, 20, 50 }) {
+            // loop of a large character class
+            expr_ref range(m_util_s.re.mk_range(m_util_s.str.mk_string(zstring(0u)), m_util_s.str.mk_string(zstring(999u))), m);
+            expr_ref loop(m_util_s.re.mk_loop(range, 1, n), m);
+            expr_ref re(m_util_s.re.mk_concat(m_util_s.re.mk_star(range), loop), m);
+            auto kernel = [&]() {
+                return regex::conv_to_nfa(to_app(re), m_util_s, m, alph, false, false).num_of_states();
+            };
+            const std::string name = "regex to nfa of a loop of length " + std::to_string(n) + " of a range of 1000 symbols";
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+
+    SECTION("length formula", "[len-formula]") {
+        for (unsigned n : { 100, 1000, 10000 }) {
+            std::vector<LenNode> conjuncts;
+            for (unsigned i = 0; i < n; ++i) {
+                conjuncts.emplace_back(LenFormulaType::EQ, std::vector<LenNode>{ var("x", i), LenNode(LenFormulaType::PLUS, { var("y", i), var("y", i + 1) }) });
+            }
+            LenNode formula(LenFormulaType::AND, conjuncts);
+            auto kernel = [&]() {
+                return noodler.len_node_to_z3_formula(formula).get() != nullptr;
+            };
+            const std::string name = "length formula with " + std::to_string(n) + " equations";
+            report_kernel(name, n, kernel);
+            BENCHMARK(name.c_str()) { return kernel(); };
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Benchmark harness for Z3-Noodler.
+
+Usage:
+    bench-noodler.py run --z3 <z3 binary> --out <results.jsonl> [--timeout SECONDS] <dir or file>...
+    bench-noodler.py compare <old results.jsonl> <new results.jsonl>
+
+The 'run' command solves each .smt2 file (directories are searched recursively) with
+'smt.string_solver=noodler' and statistics enabled. Each file gets one JSON line in the
+output with its wall time, peak RSS, result and the statistics printed by Z3 (including
+the 'str ...' statistics of the noodler theory, e.g. which heuristic solved the final checks).
+
+The 'compare' command compares two such outputs: it lists files whose result changed, files
+that got much slower/faster and the sums of the noodler statistics, so that a regression can be
+attributed to a specific heuristic of final_check_eh.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+STAT_RE = re.compile(r"^\s*\(?\s*:([\w\-.]+)\s+([0-9.eE+\-]+)\)?\s*$")
+RESULTS = ("sat", "unsat", "unknown")
+
+
+def collect_files(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _, names in os.walk(path):
+                files.extend(os.path.join(root, name) for name in names if name.endswith(".smt2"))
+        else:
+            files.append(path)
+    return sorted(files)
+
+
+def parse_output(output):
+    result = "error"
+    stats = {}
+    for line in output.splitlines():
+        stripped = line.strip()
+        if result == "error" and stripped in RESULTS:
+            result = stripped
+            continue
+        match = STAT_RE.match(line)
+        if match:
+            value = float(match.group(2))
+            stats[match.group(1)] = int(value) if value.is_integer() else value
+    return result, stats
+
+
+def run_file(z3, path, timeout):
+    cmd = [z3, "smt.string_solver=noodler", "-st", "-T:{}".format(timeout), path]
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    output = proc.stdout.read()
+    proc.stdout.close()
+    # the process is reaped by wait4 (instead of proc.wait()) to get its own peak RSS (kilobytes on Linux)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall_time = time.monotonic() - start
+    returncode = proc.returncode = os.waitstatus_to_exitcode(status)
+    peak_rss = rusage.ru_maxrss
+
+    result, stats = parse_output(output)
+    if result == "error" and wall_time >= timeout:
+        result = "timeout"
+    return {
+        "file": path,
+        "result": result,
+        "wall_time": round(wall_time, 3),
+        "peak_rss_kb": peak_rss,
+        "returncode": returncode,
+        "stats": stats,
+    }
+
+
+def cmd_run(args):
+    files = collect_files(args.paths)
+    with open(args.out, "w") as out:
+        for path in files:
+            record = run_file(args.z3, path, args.timeout)
+            out.write(json.dumps(record) + "\n")
+            out.flush()
+            print("{:8} {:8.3f}s {}".format(record["result"], record["wall_time"], path))
+    return 0
+
+
+def load(path):
+    with open(path) as f:
+        return {record["file"]: record for record in map(json.loads, filter(str.strip, f))}
+
+
+def cmd_compare(args):
+    old, new = load(args.old), load(args.new)
+    common = sorted(set(old) & set(new))
+
+    print("Changed results:")
+    for path in common:
+        if old[path]["result"] != new[path]["result"]:
+            print("  {}: {} -> {}".format(path, old[path]["result"], new[path]["result"]))
+
+    print("Time changes over {:.0f}% (and {:.2f}s):".format(args.threshold * 100, args.min_diff))
+    for path in common:
+        t_old, t_new = old[path]["wall_time"], new[path]["wall_time"]
+        if abs(t_new - t_old) >= args.min_diff and abs(t_new - t_old) >= args.threshold * max(t_old, 1e-3):
+            print("  {}: {:.3f}s -> {:.3f}s".format(path, t_old, t_new))
+
+    print("Statistics (sums over common files):")
+    keys = sorted({key for path in common for record in (old[path], new[path]) for key in record["stats"]
+                   if key.startswith("str")} | {"wall_time"})
+    for key in keys:
+        get = (lambda r: r["wall_time"]) if key == "wall_time" else (lambda r: r["stats"].get(key, 0))
+        sum_old = sum(get(old[path]) for path in common)
+        sum_new = sum(get(new[path]) for path in common)
+        if sum_old != sum_new:
+            print("  {:40} {:>14} -> {:<14}".format(key, round(sum_old, 3), round(sum_new, 3)))
+
+    for name, missing in (("old", set(new) - set(old)), ("new", set(old) - set(new))):
+        if missing:
+            print("{} files missing in the {} run".format(len(missing), name))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark harness for Z3-Noodler.")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    run = sub.add_parser("run", help="run benchmarks")
+    run.add_argument("--z3", required=True, help="path to the z3 binary")
+    run.add_argument("--out", required=True, help="output file (JSON lines)")
+    run.add_argument("--timeout", type=int, default=60, help="timeout for one file in seconds")
+    run.add_argument("paths", nargs="+", help="benchmark files or directories")
+
+    compare = sub.add_parser("compare", help="compare two runs")
+    compare.add_argument("old")
+    compare.add_argument("new")
+    compare.add_argument("--threshold", type=float, default=0.2, help="relative time change to report")
+    compare.add_argument("--min-diff", type=float, default=0.1, help="absolute time change (s) to report")
+
+    args = parser.parse_args()
+    return cmd_run(args) if args.command == "run" else cmd_compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
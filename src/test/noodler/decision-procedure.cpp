@@ -267,4 +267,232 @@ TEST_CASE("Decision Procedure", "[noodler]") {
         proc.init_computation();
         CHECK(proc.compute_next_solution());
     }
+
+    SECTION("sat-shortest-witnesses", "[nooodler]") {
+        Formula equalities;
+        equalities.add_predicate(create_equality("xy", "zu"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("a+");
+        init_ass[get_var('y')] = regex_to_nfa("b*");
+        init_ass[get_var('z')] = regex_to_nfa("a");
+        init_ass[get_var('u')] = regex_to_nfa("b*");
+        // the right side gets shortest words and the last variable of the left side the rest of its word
+        DecisionProcedureCUT proc(equalities, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+        proc.init_computation();
+        CHECK(proc.compute_next_solution() == lbool::l_true);
+        CHECK(proc.get_stats().num_witness_inclusions == 1);
+        CHECK(proc.get_stats().num_noodlifications == 0);
+
+        noodler_params.m_shortest_witnesses = false;
+        DecisionProcedureCUT noodle_proc(equalities, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+        noodle_proc.init_computation();
+        CHECK(noodle_proc.compute_next_solution() == lbool::l_true);
+        CHECK(noodle_proc.get_stats().num_witness_inclusions == 0);
+    }
+
+    SECTION("best-first-worklist", "[nooodler]") {
+        Formula equalities;
+        equalities.add_predicate(create_equality("xy", "zu"));
+        equalities.add_predicate(create_equality("zx", "xz"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("(a|b)*");
+        init_ass[get_var('y')] = regex_to_nfa("b+");
+        init_ass[get_var('z')] = regex_to_nfa("a*");
+        init_ass[get_var('u')] = regex_to_nfa("a*b");
+        noodler_params.m_shortest_witnesses = false;
+        for (worklist_order order : { WO_INCLUSIONS, WO_SMALLEST_AUT, WO_LENGTH_VARS, WO_FEWEST_NOODLES }) {
+            noodler_params.m_worklist_order = order;
+            DecisionProcedureCUT proc(equalities, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+            proc.init_computation();
+            CHECK(proc.compute_next_solution() == lbool::l_true);
+        }
+
+        // z ends with a, while u ends with b
+        Formula unsat_equalities;
+        unsat_equalities.add_predicate(create_equality("z", "u"));
+        noodler_params.m_worklist_order = WO_FEWEST_NOODLES;
+        DecisionProcedureCUT unsat_proc(unsat_equalities, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+        unsat_proc.init_computation();
+        CHECK(unsat_proc.compute_next_solution() == lbool::l_false);
+    }
+
+    SECTION("length-pruning", "[nooodler]") {
+        Formula equalities;
+        equalities.add_predicate(create_equality("x", "yz"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("a*");
+        init_ass[get_var('y')] = regex_to_nfa("a+");
+        init_ass[get_var('z')] = regex_to_nfa("a+");
+        // x has at least two symbols, so the length 1 of the arithmetic assignment prunes all noodles
+        noodler_params.m_length_pruning = true;
+        DecisionProcedureCUT proc(equalities, init_ass, { get_var('x') }, m, m_util_s, m_util_a, {}, noodler_params);
+        proc.set_length_assignment({ { get_var('x'), 1 } });
+        proc.init_computation();
+        CHECK(proc.compute_next_solution() == lbool::l_false);
+        CHECK(proc.was_length_pruned());
+        CHECK(proc.get_stats().num_length_pruned_states > 0);
+
+        DecisionProcedureCUT sat_proc(equalities, init_ass, { get_var('x') }, m, m_util_s, m_util_a, {}, noodler_params);
+        sat_proc.set_length_assignment({ { get_var('x'), 2 } });
+        sat_proc.init_computation();
+        CHECK(sat_proc.compute_next_solution() == lbool::l_true);
+        CHECK(!sat_proc.was_length_pruned());
+    }
+
+    SECTION("solving-state-index", "[nooodler]") {
+        SolvingState state;
+        Predicate first = create_equality("x", "yz");
+        Predicate second = create_equality("u", "xy");
+        state.add_inclusion(first);
+        state.add_inclusion(second);
+        state.add_inclusion(create_equality("y", "u"));
+        // the dependent inclusions are ordered as in state.inclusions
+        std::set<Predicate> dependent{ first, second };
+        CHECK(state.get_dependent_inclusions(create_equality("y", "x")) == std::vector<Predicate>(dependent.begin(), dependent.end()));
+
+        state.push_back_unique(first);
+        state.push_front_unique(first);
+        CHECK(state.inclusions_to_process->size() == 1);
+        CHECK(state.pop_front_inclusion_to_process() == first);
+        state.push_back_unique(first);
+        CHECK(state.inclusions_to_process->size() == 1);
+
+        state.remove_inclusion(second);
+        CHECK(state.get_dependent_inclusions(create_equality("y", "x")) == std::vector<Predicate>{ first });
+
+        std::unordered_map<BasicTerm, std::vector<BasicTerm>> substitution{ { get_var('y'), { get_var('v') } } };
+        state.substitute_vars(substitution);
+        CHECK(state.get_dependent_inclusions(create_equality("y", "x")).empty());
+        CHECK(state.get_dependent_inclusions(create_equality("v", "x")) == std::vector<Predicate>{ create_equality("x", "vz") });
+        state.push_back_unique(create_equality("x", "vz"));
+        CHECK(state.inclusions_to_process->size() == 1);
+    }
+
+    SECTION("not-contains-finite-needle", "[nooodler]") {
+        Formula not_contains;
+        not_contains.add_predicate(Predicate(PredicateType::NotContains, { { get_var('x') }, { get_var('y') } }));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("(a|b)*");
+        init_ass[get_var('y')] = regex_to_nfa("a|b");
+        DecisionProcedureCUT proc(not_contains, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+        REQUIRE(proc.preprocess() == lbool::l_undef);
+        proc.init_computation();
+        CHECK(proc.compute_next_solution() == lbool::l_true);
+
+        // x contains both a and b
+        init_ass[get_var('x')] = regex_to_nfa("a+b");
+        DecisionProcedureCUT unsat_proc(not_contains, init_ass, { }, m, m_util_s, m_util_a, {}, noodler_params);
+        REQUIRE(unsat_proc.preprocess() == lbool::l_undef);
+        unsat_proc.init_computation();
+        CHECK(unsat_proc.compute_next_solution() == lbool::l_false);
+    }
+
+    SECTION("reduction-policy", "[nooodler]") {
+        theory_str_noodler_params adaptive_params{};
+        adaptive_params.m_reduction_policy = RP_ADAPTIVE;
+        ReductionPolicy policy(adaptive_params);
+        CHECK(policy.decide(ReductionPolicy::Site::CONCATENATION, adaptive_params.m_reduction_minimize_states) == ReductionPolicy::Reduction::MINIMIZE);
+        CHECK(policy.decide(ReductionPolicy::Site::NOODLE, adaptive_params.m_reduction_simulation_states) == ReductionPolicy::Reduction::SIMULATION);
+        CHECK(policy.decide(ReductionPolicy::Site::NOODLE, adaptive_params.m_reduction_simulation_states + 1) == ReductionPolicy::Reduction::TRIM);
+        CHECK(ReductionPolicy(noodler_params).decide(ReductionPolicy::Site::CONCATENATION, 1) == ReductionPolicy::Reduction::NONE);
+
+        for (reduction_policy rp : { RP_NONE, RP_TRIM, RP_MINIMIZE, RP_ADAPTIVE }) {
+            theory_str_noodler_params rp_params{};
+            rp_params.m_reduction_policy = rp;
+            Formula equalities;
+            equalities.add_predicate(create_equality("x", "yz"));
+            AutAssignment init_ass;
+            init_ass[get_var('x')] = regex_to_nfa("a*b");
+            init_ass[get_var('y')] = regex_to_nfa("a*");
+            init_ass[get_var('z')] = regex_to_nfa("(a|b)");
+            DecisionProcedureCUT proc(equalities, init_ass, { }, m, m_util_s, m_util_a, {}, rp_params);
+            proc.init_computation();
+            CHECK(proc.compute_next_solution() == lbool::l_true);
+        }
+    }
+
+    SECTION("procedure-selector", "[nooodler]") {
+        Formula equalities;
+        equalities.add_predicate(create_equality("xy", "yx"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("a*");
+        init_ass[get_var('y')] = regex_to_nfa("a*");
+        InstanceFeatures features = InstanceFeatures::compute(equalities, init_ass, { get_var('x') }, false);
+        CHECK(features.num_equations == 1);
+        CHECK(features.num_vars == 2);
+        CHECK(features.num_length_vars == 1);
+        CHECK(features.num_term_occurrences == 4);
+        CHECK(features.literal_density() == 0.0);
+        CHECK(features.is_quadratic);
+        CHECK(!features.is_cyclic);
+
+        equalities.add_predicate(create_equality("x", "y"));
+        CHECK(!InstanceFeatures::compute(equalities, init_ass, { }, false).is_quadratic);
+
+        InstanceFeatures nielsen_features;
+        nielsen_features.is_cyclic = true;
+        nielsen_features.num_regular_vars = 1;
+        // the underapproximation needs (dis)equations of variables with sigma star, co-finite or singleton languages
+        CHECK(!nielsen_features.is_underapprox_suitable());
+        CHECK(FixedProcedureSelector().select(nielsen_features) == std::vector<SolverProcedure>{ SolverProcedure::NIELSEN });
+        nielsen_features.num_lang_eqs_diseqs = 1;
+        nielsen_features.num_regular_vars = 0;
+        CHECK(nielsen_features.is_underapprox_suitable());
+        CHECK(FixedProcedureSelector().select(nielsen_features) == std::vector<SolverProcedure>{ SolverProcedure::NIELSEN, SolverProcedure::LENGTH, SolverProcedure::UNDERAPPROX });
+        nielsen_features.num_lang_eqs_diseqs = 0;
+        CHECK(FixedProcedureSelector().select(nielsen_features) == std::vector<SolverProcedure>{ SolverProcedure::LENGTH, SolverProcedure::NIELSEN, SolverProcedure::UNDERAPPROX });
+        nielsen_features.first_other_predicate = 0;
+        CHECK(!nielsen_features.is_underapprox_suitable());
+        nielsen_features.first_other_predicate = SIZE_MAX;
+        // quadratic without length variables
+        CHECK(TableProcedureSelector().select(nielsen_features) == std::vector<SolverProcedure>{ SolverProcedure::NIELSEN, SolverProcedure::LENGTH, SolverProcedure::UNDERAPPROX });
+    }
+
+    SECTION("sls", "[nooodler]") {
+        Formula equalities;
+        equalities.add_predicate(create_equality("xy", "z"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("a+");
+        init_ass[get_var('y')] = regex_to_nfa("b+");
+        init_ass[get_var('z')] = regex_to_nfa("(a|b)*");
+        SlsDecisionProcedure proc(equalities, init_ass, { get_var('z') }, { { get_var('z'), 5 } }, { 'a', 'b' }, noodler_params);
+        proc.init_computation();
+        REQUIRE(proc.compute_next_solution() == lbool::l_true);
+        std::map<BasicTerm, SlsDecisionProcedure::Word> words;
+        for (const auto& [var, word] : proc.get_words()) {
+            words[var] = word;
+        }
+        CHECK(words[get_var('z')].size() == 5);
+        SlsDecisionProcedure::Word xy = words[get_var('x')];
+        xy.insert(xy.end(), words[get_var('y')].begin(), words[get_var('y')].end());
+        CHECK(xy == words[get_var('z')]);
+        CHECK(proc.get_lengths().first.type == LenFormulaType::AND);
+
+        // no word of the fixed length
+        SlsDecisionProcedure no_word(equalities, init_ass, { }, { { get_var('x'), 0 } }, { 'a', 'b' }, noodler_params);
+        no_word.init_computation();
+        CHECK(no_word.compute_next_solution() == lbool::l_undef);
+    }
+
+    SECTION("bounded", "[nooodler]") {
+        noodler_params.m_bounded_length = 8;
+        Formula equalities;
+        equalities.add_predicate(create_equality("xy", "z"));
+        AutAssignment init_ass;
+        init_ass[get_var('x')] = regex_to_nfa("a|aa");
+        init_ass[get_var('y')] = regex_to_nfa("b");
+        init_ass[get_var('z')] = regex_to_nfa("aab|ab");
+        BoundedStringProcedure proc(equalities, init_ass, { get_var('z') }, noodler_params);
+        proc.init_computation();
+        // the lengths of z are 2 and 3, each solution blocks one of them
+        CHECK(proc.compute_next_solution() == lbool::l_true);
+        CHECK(proc.get_lengths().first.type == LenFormulaType::AND);
+        CHECK(proc.compute_next_solution() == lbool::l_true);
+        CHECK(proc.compute_next_solution() == lbool::l_false);
+
+        init_ass[get_var('z')] = regex_to_nfa("ba");
+        BoundedStringProcedure unsat_proc(equalities, init_ass, { }, noodler_params);
+        unsat_proc.init_computation();
+        CHECK(unsat_proc.compute_next_solution() == lbool::l_false);
+    }
 }
@@ -185,6 +185,14 @@ TEST_CASE( "Replace", "[noodler]" ) {
     CHECK(res == Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({a, x3, x4}), std::vector<BasicTerm>({b, x1, x1}) })  ));
     CHECK(ieq1.replace(Concat({x2}), std::vector<BasicTerm>({x1}), res));
     CHECK(res == Predicate(PredicateType::Inequation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({a, x3, x4}), std::vector<BasicTerm>({b, x1, x1}) })  ));
+    // find longer than the sides
+    CHECK(!eq2.replace(Concat({x1, x2, b}), std::vector<BasicTerm>(), res));
+    CHECK(res == eq2);
+
+    Predicate switched = eq4;
+    switched.switch_sides();
+    CHECK(switched == eq4.get_switched_sides_predicate());
+    CHECK(eq4.split_literals() == eq4);
 
     Formula conj;
     conj.add_predicate(eq1);
@@ -751,3 +759,48 @@ TEST_CASE( "Remove extension", "[noodler]" ) {
         CHECK(prep.get_dependency().empty());
     }
 }
+
+TEST_CASE( "Literal clashes", "[noodler]" ) {
+    BasicTerm x1{ BasicTermType::Variable, "x_1"};
+    BasicTerm x2{ BasicTermType::Variable, "x_2"};
+    BasicTerm x3{ BasicTermType::Variable, "x_3"};
+    BasicTerm get{ BasicTermType::Literal, "GET /"};
+    BasicTerm post{ BasicTermType::Literal, "POST /"};
+    BasicTerm ge{ BasicTermType::Literal, "GE"};
+    BasicTerm end1{ BasicTermType::Literal, " HTTP/1.1"};
+    BasicTerm end2{ BasicTermType::Literal, " HTTP/2"};
+    AutAssignment aut_ass = AutAssignment({
+        {x1, regex_to_nfa(".*")},
+        {x2, regex_to_nfa(".*")},
+        {x3, regex_to_nfa(".*")},
+    });
+    LiteralStore store;
+
+    for (bool use_store : { false, true }) {
+        SECTION(use_store ? "prefix with store" : "prefix") {
+            Formula conj;
+            conj.add_predicate(Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({x1}), std::vector<BasicTerm>({get, x2}) })));
+            conj.add_predicate(Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({x1}), std::vector<BasicTerm>({post, x3}) })));
+            FormulaPreprocessor prep(conj, aut_ass, {}, {});
+            prep.set_literal_store(use_store ? &store : nullptr);
+            CHECK(prep.contains_unsat_eqs_or_diseqs());
+        }
+
+        SECTION(use_store ? "compatible prefix with store" : "compatible prefix") {
+            Formula conj;
+            conj.add_predicate(Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({x1}), std::vector<BasicTerm>({get, x2}) })));
+            conj.add_predicate(Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({x1}), std::vector<BasicTerm>({ge, x3}) })));
+            FormulaPreprocessor prep(conj, aut_ass, {}, {});
+            prep.set_literal_store(use_store ? &store : nullptr);
+            CHECK(!prep.contains_unsat_eqs_or_diseqs());
+        }
+
+        SECTION(use_store ? "suffix with store" : "suffix") {
+            Formula conj;
+            conj.add_predicate(Predicate(PredicateType::Equation, std::vector<std::vector<BasicTerm>>({ std::vector<BasicTerm>({x1, end1}), std::vector<BasicTerm>({x2, end2}) })));
+            FormulaPreprocessor prep(conj, aut_ass, {}, {});
+            prep.set_literal_store(use_store ? &store : nullptr);
+            CHECK(prep.contains_unsat_eqs_or_diseqs());
+        }
+    }
+}
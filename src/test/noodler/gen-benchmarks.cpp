@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+// Generator of synthetic SMT-LIB families, each of them isolates one scaling dimension of the string solver. The
+// instance of size n of a family is fully determined by n, so the generated files are reproducible. Usage:
+//   gen-noodler-benchmarks <family> <n>                  prints the instance of size n of the family
+//   gen-noodler-benchmarks all <from> <to> <out dir>     writes <out dir>/<family>/<family>-<n>.smt2 for all families
+// The directory can be run by 'bench-noodler.py run' (Z3_NOODLER_BENCH_DIR), the results of the files of one family
+// give the scaling curve of the corresponding hot path.
+
+namespace {
+
+    std::string var(const std::string& prefix, unsigned i) {
+        return prefix + std::to_string(i);
+    }
+
+    std::string repeat(const std::string& s, unsigned n) {
+        std::string res;
+        for (unsigned i = 0; i < n; ++i) {
+            res += s;
+        }
+        return res;
+    }
+
+    void header(std::ostream& out, const std::string& family, unsigned n, const std::string& status) {
+        out << "; " << family << " of size " << n << " (generated by gen-noodler-benchmarks)\n";
+        out << "(set-logic QF_SLIA)\n";
+        out << "(set-info :status " << status << ")\n";
+    }
+
+    void declare_strings(std::ostream& out, const std::string& prefix, unsigned from, unsigned to) {
+        for (unsigned i = from; i <= to; ++i) {
+            out << "(declare-fun " << var(prefix, i) << " () String)\n";
+        }
+    }
+
+    void footer(std::ostream& out) {
+        out << "(check-sat)\n(exit)\n";
+    }
+
+    // y = x1 ... xn with xi in (a|b)+, y in (ab)* and |y| = 2n (the equation and the noodlification of its sides)
+    void concat_chain(std::ostream& out, unsigned n) {
+        header(out, "concat-chain", n, "sat");
+        declare_strings(out, "x", 1, n);
+        out << "(declare-fun y () String)\n";
+        for (unsigned i = 1; i <= n; ++i) {
+            out << "(assert (str.in_re " << var("x", i) << " (re.+ (re.union (str.to_re \"a\") (str.to_re \"b\")))))\n";
+        }
+        out << "(assert (= y (str.++";
+        for (unsigned i = 1; i <= n; ++i) {
+            out << " " << var("x", i);
+        }
+        out << ")))\n";
+        out << "(assert (str.in_re y (re.* (str.to_re \"ab\"))))\n";
+        out << "(assert (= (str.len y) " << 2 * n << "))\n";
+        footer(out);
+    }
+
+    // x in ((... ((a|b){1,2}){1,2} ...){1,2}) nested n times, containing "ba" and of the maximal length 2^n (at least
+    // 2^20 for n > 20) (construction and determinization of the automata of the loops)
+    void nested_loops(std::ostream& out, unsigned n) {
+        header(out, "nested-loops", n, "sat");
+        std::string re = "(re.union (str.to_re \"a\") (str.to_re \"b\"))";
+        for (unsigned i = 0; i < n; ++i) {
+            re = "((_ re.loop 1 2) " + re + ")";
+        }
+        out << "(declare-fun x () String)\n";
+        out << "(assert (str.in_re x " << re << "))\n";
+        out << "(assert (str.in_re x (re.++ re.all (str.to_re \"ba\") re.all)))\n";
+        out << "(assert (>= (str.len x) " << (1u << std::min(n, 20u)) << "))\n";
+        footer(out);
+    }
+
+    // n memberships of one variable in pairwise disjoint languages: words of length i modulo n (the product of the
+    // automata of memberships)
+    void disjoint_memberships(std::ostream& out, unsigned n) {
+        const bool sat = n < 2;
+        header(out, "disjoint-memberships", n, sat ? "sat" : "unsat");
+        out << "(declare-fun x () String)\n";
+        for (unsigned i = 0; i < n; ++i) {
+            out << "(assert (str.in_re x (re.++ (re.* ((_ re.loop " << n << " " << n << ") re.allchar)) ((_ re.loop "
+                << i << " " << i << ") re.allchar))))\n";
+        }
+        footer(out);
+    }
+
+    // x_i a x_{i+1} = x_{i+1} a x_i for i < n, each variable occurs at most twice in each equation (quadratic
+    // equations of the Nielsen transformation), x_1 != x_n forces a nontrivial solution
+    void quadratic_system(std::ostream& out, unsigned n) {
+        // for n = 1, there are no equations and x1 != x1 is unsatisfiable
+        header(out, "quadratic-system", n, n < 2 ? "unsat" : "sat");
+        declare_strings(out, "x", 1, n);
+        for (unsigned i = 1; i < n; ++i) {
+            out << "(assert (= (str.++ " << var("x", i) << " \"a\" " << var("x", i + 1) << ") (str.++ "
+                << var("x", i + 1) << " \"a\" " << var("x", i) << ")))\n";
+        }
+        out << "(assert (not (= x1 " << var("x", n) << ")))\n";
+        footer(out);
+    }
+
+    // y is the largest number with n digits: |y| = n and to_int(y) + 1 = to_int(z) where z has n + 1 digits without
+    // a leading zero (the encodings of the conversions up to the length n)
+    void digit_system(std::ostream& out, unsigned n) {
+        header(out, "digit-system", n, "sat");
+        out << "(declare-fun y () String)\n(declare-fun z () String)\n(declare-fun k () Int)\n";
+        out << "(assert (= y (str.from_int k)))\n";
+        out << "(assert (= (str.len y) " << n << "))\n";
+        out << "(assert (= (+ (str.to_int y) 1) (str.to_int z)))\n";
+        out << "(assert (= (str.len z) " << n + 1 << "))\n";
+        out << "(assert (str.in_re z (re.+ (re.range \"0\" \"9\"))))\n";
+        out << "(assert (not (str.prefixof \"0\" z)))\n";
+        footer(out);
+    }
+
+    // x over {a, b} of length at least n contains ab but does not contain a^i bb for any i <= n (the automata of
+    // not-contains with growing patterns)
+    void not_contains(std::ostream& out, unsigned n) {
+        header(out, "not-contains", n, "sat");
+        out << "(declare-fun x () String)\n";
+        out << "(assert (str.in_re x (re.* (re.union (str.to_re \"a\") (str.to_re \"b\")))))\n";
+        out << "(assert (>= (str.len x) " << n << "))\n";
+        out << "(assert (str.in_re x (re.++ re.all (str.to_re \"ab\") re.all)))\n";
+        for (unsigned i = 1; i <= n; ++i) {
+            out << "(assert (not (str.contains x \"" << repeat("a", i) << "bb\")))\n";
+        }
+        footer(out);
+    }
+
+    const std::map<std::string, std::function<void(std::ostream&, unsigned)>> families = {
+        {"concat-chain", concat_chain},
+        {"nested-loops", nested_loops},
+        {"disjoint-memberships", disjoint_memberships},
+        {"quadratic-system", quadratic_system},
+        {"digit-system", digit_system},
+        {"not-contains", not_contains},
+    };
+
+    int usage(const char* name) {
+        std::cerr << "usage: " << name << " <family> <n>" << std::endl;
+        std::cerr << "       " << name << " all <from> <to> <out dir>" << std::endl;
+        std::cerr << "families:";
+        for (const auto& [family, gen] : families) {
+            std::cerr << " " << family;
+        }
+        std::cerr << std::endl;
+        return 2;
+    }
+
+    bool parse_size(const char* arg, unsigned& n) {
+        char* end = nullptr;
+        unsigned long val = std::strtoul(arg, &end, 10);
+        if (end == arg || *end != '\0' || val == 0 || val > 100000) {
+            return false;
+        }
+        n = static_cast<unsigned>(val);
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && families.count(argv[1]) != 0) {
+        unsigned n;
+        if (!parse_size(argv[2], n)) {
+            return usage(argv[0]);
+        }
+        families.at(argv[1])(std::cout, n);
+        return 0;
+    }
+    if (argc == 5 && std::string(argv[1]) == "all") {
+        unsigned from, to;
+        if (!parse_size(argv[2], from) || !parse_size(argv[3], to) || from > to) {
+            return usage(argv[0]);
+        }
+        for (const auto& [family, gen] : families) {
+            std::filesystem::path dir = std::filesystem::path(argv[4]) / family;
+            std::filesystem::create_directories(dir);
+            for (unsigned n = from; n <= to; ++n) {
+                std::ofstream out(dir / (family + "-" + std::to_string(n) + ".smt2"));
+                if (!out) {
+                    std::cerr << "cannot write to " << dir << std::endl;
+                    return 1;
+                }
+                gen(out, n);
+            }
+        }
+        return 0;
+    }
+    return usage(argv[0]);
+}
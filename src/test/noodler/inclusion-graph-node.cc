@@ -1,9 +1,11 @@
 #include <iostream>
+#include <thread>
 
 #include <catch2/catch_test_macros.hpp>
 #include <mata/nfa/nfa.hh>
 
 #include "smt/theory_str_noodler/inclusion_graph.h"
+#include "smt/theory_str_noodler/aut_assignment.h"
 
 using namespace smt::noodler;
 
@@ -83,6 +85,44 @@ TEST_CASE("Conversion to strings", "[noodler]") {
     } );
 }
 
+TEST_CASE("Interned basic terms", "[noodler]") {
+    BasicTerm x{ BasicTermType::Variable, "x_42" };
+    BasicTerm lit_x{ BasicTermType::Literal, "x_42" };
+    CHECK(x.get_id() == BasicTerm{ BasicTermType::Variable, "x_42" }.get_id());
+    CHECK(x.get_id() != lit_x.get_id());
+    CHECK(x != lit_x);
+    CHECK(x.get_id() < BasicTerm::get_number_of_ids());
+
+    BasicTerm y{ BasicTermType::Variable, "y_58" };
+    y.set_name("x_42");
+    CHECK(y == x);
+    CHECK(BasicTerm::HashFunction()(y) == BasicTerm::HashFunction()(x));
+    CHECK(!(y < x));
+    CHECK(BasicTerm(BasicTermType::Variable, "a") < BasicTerm(BasicTermType::Variable, "b"));
+
+    BasicTerm fresh1 = BasicTerm::mk_fresh_variable("fresh_test");
+    BasicTerm fresh2 = BasicTerm::mk_fresh_variable("fresh_test");
+    CHECK(fresh1.is_fresh());
+    CHECK(fresh1 != fresh2);
+    CHECK(fresh1 < fresh2);
+    CHECK(!(fresh2 < fresh1));
+    CHECK(x < fresh1);
+    CHECK(fresh1.get_id() < BasicTerm::get_number_of_ids());
+    CHECK(fresh2.get_name() == zstring("fresh_test!n1"));
+    // a variable with the same name is a different term
+    CHECK(BasicTerm(BasicTermType::Variable, fresh1.get_name()) != fresh1);
+}
+
+TEST_CASE("Interned basic terms of more threads", "[noodler]") {
+    BasicTerm::InternScope scope;
+    BasicTerm x{ BasicTermType::Variable, "x_thread" };
+    unsigned id_of_thread = 0;
+    std::thread thread([&]() { id_of_thread = BasicTerm{ BasicTermType::Variable, "x_thread" }.get_id(); });
+    thread.join();
+    CHECK(id_of_thread == x.get_id());
+    CHECK(BasicTerm{ BasicTermType::Variable, "x_thread" } == x);
+}
+
 TEST_CASE("Mata integration", "[noodler]") {
     auto nfa = mata::nfa::Nfa(3);
     nfa.initial = { 0, 1};
@@ -96,6 +136,26 @@ TEST_CASE("Mata integration", "[noodler]") {
     CHECK(!nfa.delta.empty());
 }
 
+TEST_CASE("Automata pool", "[noodler]") {
+    AutomataPool pool;
+    auto word = pool.get_word(zstring("ab"));
+    CHECK(word == pool.get_word(zstring("ab")));
+    CHECK(word == pool.intern(AutAssignment::create_word_nfa(zstring("ab"))));
+    CHECK(word != pool.get_word(zstring("ba")));
+
+    auto sigma_star = pool.get_sigma_star({'a', 'b'});
+    CHECK(sigma_star == pool.get_sigma_star({'a', 'b'}));
+    CHECK(sigma_star != pool.get_sigma_star({'a'}));
+    CHECK(sigma_star->alphabet == nullptr);
+
+    auto inters = pool.get_intersection(word, sigma_star);
+    CHECK(inters == pool.get_intersection(sigma_star, word));
+    CHECK(pool.is_included(inters, word));
+    CHECK(pool.is_included(word, inters));
+    CHECK(pool.is_included(word, sigma_star));
+    CHECK(!pool.is_included(sigma_star, word));
+}
+
 TEST_CASE("Graph::get_edges_to", "[noodler]") {
     Graph graph;
     Formula formula;
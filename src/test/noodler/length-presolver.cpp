@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "smt/theory_str_noodler/length_presolver.h"
+#include "ast/reg_decl_plugins.h"
+
+using namespace smt::noodler;
+
+TEST_CASE("Length presolver", "[noodler]") {
+    ast_manager m;
+    reg_decl_plugins(m);
+    arith_util a(m);
+    LengthPresolver presolver(m);
+
+    expr_ref x(m.mk_const(symbol("x"), a.mk_int()), m);
+    expr_ref y(m.mk_const(symbol("y"), a.mk_int()), m);
+    expr_ref z(m.mk_const(symbol("z"), a.mk_int()), m);
+    expr_ref n(m.mk_const(symbol("n"), a.mk_int()), m);
+
+    SECTION("negative cycle of difference constraints") {
+        // x - y <= 1, y - z <= -2, z - x <= 0
+        expr_ref f(m.mk_and(
+            a.mk_le(a.mk_sub(x, y), a.mk_int(1)),
+            a.mk_le(a.mk_sub(y, z), a.mk_int(-2)),
+            a.mk_le(z, x)
+        ), m);
+        CHECK(presolver.check(f) == l_false);
+    }
+
+    SECTION("satisfiable difference constraints") {
+        expr_ref f(m.mk_and(
+            a.mk_le(a.mk_sub(x, y), a.mk_int(1)),
+            a.mk_le(a.mk_sub(y, z), a.mk_int(-1)),
+            a.mk_le(z, x)
+        ), m);
+        CHECK(presolver.check(f) == l_undef);
+    }
+
+    SECTION("bounds and negated atoms") {
+        // x >= 3 and not (x < 5) and x = y and y <= 4
+        expr_ref f(m.mk_and(
+            m.mk_and(a.mk_ge(x, a.mk_int(3)), m.mk_not(a.mk_lt(x, a.mk_int(5)))),
+            m.mk_and(m.mk_eq(x, y), a.mk_le(y, a.mk_int(4)))
+        ), m);
+        CHECK(presolver.check(f) == l_false);
+    }
+
+    SECTION("periodic constraints") {
+        // x = 1 + 2*n and x = 4 + 2*y has no integer solution, but the presolver does not combine equalities
+        expr_ref f(m.mk_and(
+            m.mk_eq(x, a.mk_add(a.mk_int(1), a.mk_mul(a.mk_int(2), n))),
+            m.mk_eq(x, a.mk_add(a.mk_int(4), a.mk_mul(a.mk_int(2), y)))
+        ), m);
+        CHECK(presolver.check(f) == l_undef);
+        expr_ref g(m.mk_eq(a.mk_mul(a.mk_int(2), x), a.mk_add(a.mk_int(1), a.mk_mul(a.mk_int(4), n))), m);
+        CHECK(presolver.check(g) == l_false);
+    }
+
+    SECTION("modular constraints") {
+        // (2*x mod 4) = 1 means 2*x - 4*q = 1 for the quotient q
+        expr_ref f(m.mk_eq(a.mk_mod(a.mk_mul(a.mk_int(2), x), a.mk_int(4)), a.mk_int(1)), m);
+        CHECK(presolver.check(f) == l_false);
+        expr_ref g(m.mk_eq(a.mk_mod(x, a.mk_int(4)), a.mk_int(1)), m);
+        CHECK(presolver.check(g) == l_undef);
+    }
+
+    SECTION("constraints outside of the fragment are ignored") {
+        expr_ref f(m.mk_and(
+            m.mk_or(a.mk_le(x, a.mk_int(0)), a.mk_ge(x, a.mk_int(10))),
+            a.mk_le(a.mk_mul(x, y), a.mk_int(1))
+        ), m);
+        CHECK(presolver.check(f) == l_undef);
+        expr_ref g(m.mk_and(f, m.mk_false()), m);
+        CHECK(presolver.check(g) == l_false);
+    }
+}
@@ -0,0 +1,111 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "ast/reg_decl_plugins.h"
+#include "cmd_context/cmd_context.h"
+#include "parsers/smt2/smt2parser.h"
+#include "smt/smt_kernel.h"
+#include "smt/theory_str_noodler/decision_procedure.h"
+#include "smt/theory_str_noodler/instance_record.h"
+#include "smt/theory_str_noodler/util.h"
+#include "util/gparams.h"
+#include "util/stopwatch.h"
+
+// Replay of an instance recorded by the string solver (see str.record_dir): the decision procedure is run on the
+// recorded input and the length formulas of its solutions are checked against the recorded arithmetic context, as in
+// the final check. Usage: replay-noodler <instance file> [<param>=<value> ...] (parameters of the solver, e.g.
+// str.inclusion_order=1).
+
+using namespace smt::noodler;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <instance file> [<param>=<value> ...]" << std::endl;
+        return 2;
+    }
+    memory::initialize(0);
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            gparams::set(argv[i]);
+        }
+        smt_params params(gparams::get_module("smt"));
+        theory_str_noodler_params& noodler_params = params;
+
+        std::ifstream in(argv[1]);
+        if (!in) {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 2;
+        }
+        RecordedInstance instance = read_instance(in);
+
+        ast_manager m;
+        reg_decl_plugins(m);
+        seq_util m_util_s(m);
+        arith_util m_util_a(m);
+
+        // the recorded context is asserted to the length solver
+        cmd_context cmd(false, &m);
+        cmd.set_ignore_check(true);
+        std::istringstream context_in(instance.arith_context);
+        if (!parse_smt2_commands(cmd, context_in)) {
+            std::cerr << "cannot parse the arithmetic context" << std::endl;
+            return 2;
+        }
+        smt::kernel len_solver(m, params);
+        for (expr* a : cmd.assertions()) {
+            len_solver.assert_expr(a);
+        }
+
+        // string variables are the constants of the context with the same names
+        std::map<BasicTerm, expr_ref> var_name;
+        for (const Predicate& pred : instance.formula.get_predicates()) {
+            for (const auto& side : pred.get_params()) {
+                for (const BasicTerm& term : side) {
+                    if (term.is_variable()) {
+                        var_name.insert({term, expr_ref(m.mk_const(symbol(term.get_name().encode().c_str()), m_util_s.mk_string_sort()), m)});
+                    }
+                }
+            }
+        }
+
+        stopwatch total;
+        total.start();
+        DecisionProcedure dec_proc(instance.formula, instance.aut_assignment, instance.length_sensitive_vars, noodler_params, instance.conversions);
+        lbool result = dec_proc.preprocess(PreprocessType::PLAIN, instance.len_eq_vars);
+        std::cout << "preprocessing: " << result << " (" << total.get_current_seconds() << " s)" << std::endl;
+        unsigned num_solutions = 0;
+        if (result != l_false) {
+            dec_proc.init_computation();
+            while (true) {
+                result = dec_proc.compute_next_solution();
+                if (result != l_true) {
+                    break;
+                }
+                ++num_solutions;
+                expr_ref lengths = util::len_to_expr(dec_proc.get_lengths().first, var_name, m, m_util_s, m_util_a);
+                len_solver.push();
+                len_solver.assert_expr(lengths);
+                lbool len_result = len_solver.check();
+                len_solver.pop(1);
+                std::cout << "solution " << num_solutions << ": lengths " << len_result << " (" << total.get_current_seconds() << " s)" << std::endl;
+                if (len_result == l_true) {
+                    break;
+                }
+            }
+        }
+        const DecisionProcedureStats& stats = dec_proc.get_stats();
+        std::cout << "result: " << (result == l_true ? "sat" : result == l_false ? "unsat" : "unknown") << std::endl
+                  << "solutions: " << num_solutions << std::endl
+                  << "noodlifications: " << stats.num_noodlifications << std::endl
+                  << "noodles: " << stats.num_noodles << std::endl
+                  << "solving states: " << stats.num_solving_states << std::endl
+                  << "time: " << total.get_current_seconds() << " s" << std::endl;
+    } catch (const z3_exception& ex) {
+        std::cerr << "error: " << ex.msg() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -21,7 +21,8 @@ public:
 
     using theory_str_noodler::m_util_s, theory_str_noodler::m, theory_str_noodler::m_util_a;
     using theory_str_noodler::mk_str_var_fresh, theory_str_noodler::mk_int_var_fresh, theory_str_noodler::mk_literal;
-    using theory_str_noodler::extract_symbols;
+    using theory_str_noodler::extract_symbols, theory_str_noodler::normalize_ranges;
+    using theory_str_noodler::len_node_to_z3_formula;
 };
 
 class DecisionProcedureCUT : public DecisionProcedure {
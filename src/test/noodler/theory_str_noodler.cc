@@ -7,3 +7,37 @@
 #include "smt/theory_str_noodler/util.h"
 #include "ast/reg_decl_plugins.h"
 #include "test_utils.h"
+#include "api/z3.h"
+
+namespace {
+    /**
+     * @brief Check @p script by a new context using the noodler string solver, returns the output of the script.
+     */
+    std::string check_by_noodler(const std::string& script) {
+        Z3_global_param_set("smt.string_solver", "noodler");
+        Z3_config cfg = Z3_mk_config();
+        Z3_context ctx = Z3_mk_context(cfg);
+        Z3_del_config(cfg);
+        std::string res = Z3_eval_smtlib2_string(ctx, script.c_str());
+        Z3_del_context(ctx);
+        Z3_global_param_reset_all();
+        return res;
+    }
+}
+
+TEST_CASE("Independent components", "[noodler]") {
+    // the component of the disequation has a solution of the equations only if the lengths are ignored (both
+    // sides of any alignment of the disequation have the same symbol), the other component is satisfiable
+    const std::string script = R"(
+        (declare-fun x () String)
+        (declare-fun y () String)
+        (declare-fun z () String)
+        (declare-fun w () String)
+        (assert (not (= x y)))
+        (assert (str.in_re x ((_ re.loop 1 1) (str.to_re "a"))))
+        (assert (str.in_re y ((_ re.loop 1 1) (str.to_re "a"))))
+        (assert (= z (str.++ "b" w)))
+        (check-sat)
+    )";
+    CHECK(check_by_noodler(script) == "unsat\n");
+}
@@ -54,6 +54,53 @@ TEST_CASE("theory_str_noodler::util") {
         CHECK(alphabet == std::set<uint32_t>{ '\x02', '\x45', '\x77', '\x78', '\x79', '\x7a' });
     }
 
+    SECTION("theory_str_noodler::extract_symbols() with ranges") {
+        auto range_ac{ m_util_s.re.mk_range(m_util_s.str.mk_string("a"), m_util_s.str.mk_string("c")) };
+        auto range_bd{ m_util_s.re.mk_range(m_util_s.str.mk_string("b"), m_util_s.str.mk_string("d")) };
+        auto expr_union{ m_util_s.re.mk_union(range_ac, m_util_s.re.mk_star(range_bd)) };
+
+        std::vector<std::pair<uint32_t,uint32_t>> ranges;
+        std::set<uint32_t> symbols;
+        noodler.extract_symbols(expr_union, symbols, &ranges);
+        CHECK(symbols.empty());
+        CHECK(ranges.size() == 2);
+        CHECK(TheoryStrNoodlerCUT::normalize_ranges(ranges) == std::vector<std::pair<uint32_t,uint32_t>>{ { 'a', 'd' } });
+
+        noodler.extract_symbols(expr_union, symbols);
+        CHECK(symbols == std::set<uint32_t>{ 'a', 'b', 'c', 'd' });
+    }
+
+    SECTION("regex::NfaCache::are_equivalent()") {
+        regex::NfaCache cache;
+        regex::Alphabet alph(alphabet);
+        expr_ref x_star{ m_util_s.re.mk_star(m_util_s.re.mk_to_re(m_util_s.str.mk_string("x"))), m };
+        expr_ref x_plus{ m_util_s.re.mk_plus(m_util_s.re.mk_to_re(m_util_s.str.mk_string("x"))), m };
+        expr_ref x_opt_plus{ m_util_s.re.mk_opt(x_plus), m };
+
+        std::vector<mata::Symbol> witness;
+        CHECK(!cache.are_equivalent(to_app(x_star), to_app(x_plus), m_util_s, m, alph, &witness));
+        CHECK(witness.empty());
+        CHECK(cache.are_equivalent(to_app(x_star), to_app(x_opt_plus), m_util_s, m, alph));
+        CHECK(cache.get_equivalence_hits() == 0);
+        // the pair is cached in both orders
+        CHECK(!cache.are_equivalent(to_app(x_plus), to_app(x_star), m_util_s, m, alph));
+        CHECK(cache.get_equivalence_hits() == 1);
+    }
+
+    SECTION("AutAssignment::deduplicate()") {
+        AutAssignment aut_ass;
+        aut_ass[get_var('x')] = regex_to_nfa("(a|b)*");
+        aut_ass[get_var('y')] = regex_to_nfa("(a|b)*");
+        aut_ass[get_var('z')] = regex_to_nfa("a");
+        REQUIRE(aut_ass.at(get_var('x')) != aut_ass.at(get_var('y')));
+        aut_ass.deduplicate();
+        CHECK(aut_ass.at(get_var('x')) == aut_ass.at(get_var('y')));
+        CHECK(aut_ass.at(get_var('x')) != aut_ass.at(get_var('z')));
+        aut_ass.reduce();
+        CHECK(aut_ass.at(get_var('x')) == aut_ass.at(get_var('y')));
+        CHECK(aut_ass.is_sat());
+    }
+
     SECTION("util::is_str_variable()") {
         expr_ref str_variable{ noodler.mk_str_var_fresh("var1"), m };
         CHECK(util::is_str_variable(str_variable, m_util_s));
@@ -164,3 +211,15 @@ TEST_CASE("theory_str_noodler::util") {
         }
     }
 }
+
+TEST_CASE("Product of automata", "[noodler]") {
+    const std::vector<std::string> regexes{ "(a|b)*", "a*b", "(ab)*", "b*c", "(a|b)*c(a|b)*", "aba" };
+    for (const std::string& left : regexes) {
+        for (const std::string& right : regexes) {
+            mata::nfa::Nfa product = intersect(*regex_to_nfa(left), *regex_to_nfa(right));
+            CHECK(mata::nfa::are_equivalent(product, mata::nfa::intersection(*regex_to_nfa(left), *regex_to_nfa(right))));
+            // the product is trimmed
+            CHECK(product.num_of_states() == mata::nfa::Nfa(product).trim().num_of_states());
+        }
+    }
+}
@@ -719,6 +719,22 @@ public:
         }
     }
 
+    static void translate() {
+        std::cout << "translate\n";
+        pdd_manager m1(3), m2(3);
+        unsigned_vector l2v;
+        l2v.push_back(2); l2v.push_back(0); l2v.push_back(1);
+        m2.reset(l2v);
+        pdd a = m1.mk_var(0), b = m1.mk_var(1), c = m1.mk_var(2);
+        pdd p = a*a*b + 3*b*c - c + 5;
+        pdd q = m2.translate(p);
+        VERIFY(&q.manager() == &m2);
+        pdd a2 = m2.mk_var(0), b2 = m2.mk_var(1), c2 = m2.mk_var(2);
+        VERIFY(q == a2*a2*b2 + 3*b2*c2 - c2 + 5);
+        VERIFY(m1.translate(q) == p);
+        VERIFY(m1.translate(m2.mk_val(7)) == m1.mk_val(7));
+    }
+
 };
 
 }
@@ -744,4 +760,5 @@ void tst_pdd() {
     dd::test::subst_get();
     dd::test::univariate();
     dd::test::factors();
+    dd::test::translate();
 }
@@ -190,6 +190,24 @@ static void test7() {
   M.display(std::cout);
 }
 
+static void test8() {
+  // a reset matrix reuses its rows and columns
+  unsynch_mpq_manager m;
+  qmatrix M(m);
+  vector<vector<rational>> K1, K2;
+  add(M, vec(1, 2, 3, 4, 10));
+  add(M, vec(2, 2, 3, 4, 11));
+  kernel_ffe(M, K1);
+  M.reset();
+  VERIFY(M.num_rows() == 0 && M.num_vars() == 0);
+  add(M, vec(1, 2, 3));
+  M.reset();
+  add(M, vec(1, 2, 3, 4, 10));
+  add(M, vec(2, 2, 3, 4, 11));
+  kernel_ffe(M, K2);
+  VERIFY(K1 == K2);
+}
+
 void tst_simplex() {
     reslimit rl; Simplex S(rl);
 
@@ -228,4 +246,5 @@ void tst_simplex() {
     test5();
     test6();
     test7();
+    test8();
 }
@@ -39,4 +39,21 @@ void tst_solver_pool() {
     std::cout << *s1;
     std::cout << *s2;
     std::cout << *base;
+
+    // warm solvers are reused after they are released
+    solver* w1 = pool.acquire_solver();
+    w1->assert_expr(m.mk_not(a));
+    w1->assert_expr(m.mk_not(b));
+    ENSURE(w1->check_sat() == l_false);
+    pool.release_solver(w1);
+    ENSURE(w1->get_scope_level() == 0);
+    solver* w2 = pool.acquire_solver();
+    ENSURE(w1 == w2);
+    solver* w3 = pool.acquire_solver();
+    ENSURE(w2 != w3);
+    w2->assert_expr(m.mk_not(a));
+    ENSURE(w2->check_sat() == l_true);
+    ENSURE(w3->check_sat() == l_true);
+    pool.release_solver(w3);
+    pool.release_solver(w2);
 }
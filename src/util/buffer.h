@@ -21,6 +21,7 @@ Revision History:
 --*/
 #pragma once
 
+#include <algorithm>
 #include <type_traits>
 #include "util/memory_manager.h"
 #include "debug.h"
@@ -40,8 +41,12 @@ protected:
     }
 
     void expand() {
+        grow(m_capacity << 1);
+    }
+
+    void grow(unsigned new_capacity) {
         static_assert(std::is_nothrow_move_constructible<T>::value);
-        unsigned new_capacity = m_capacity << 1;
+        SASSERT(new_capacity > m_capacity);
         T * new_buffer        = reinterpret_cast<T*>(memory::allocate(sizeof(T) * new_capacity));
         for (unsigned i = 0; i < m_pos; ++i) {
             new (&new_buffer[i]) T(std::move(m_buffer[i]));
@@ -194,8 +199,17 @@ public:
     }
 
     void append(unsigned n, T const * elems) {
+        if (m_pos + n > m_capacity) {
+            // elems may point into this buffer
+            bool own = m_buffer <= elems && elems < m_buffer + m_pos;
+            unsigned offset = own ? static_cast<unsigned>(elems - m_buffer) : 0;
+            grow(std::max(m_pos + n, m_capacity << 1));
+            if (own)
+                elems = m_buffer + offset;
+        }
         for (unsigned i = 0; i < n; i++) {
-            push_back(elems[i]);
+            new (m_buffer + m_pos) T(elems[i]);
+            m_pos++;
         }
     }
 
@@ -228,6 +242,11 @@ public:
         m_buffer[idx] = val;
     }
 
+    void reserve(unsigned n) {
+        if (n > m_capacity)
+            grow(n);
+    }
+
     void resize(unsigned nsz, const T & elem=T()) {
         unsigned sz = size();
         if (nsz > sz) {
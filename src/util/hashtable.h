@@ -124,6 +124,19 @@ public:
     void mark_as_free() { m_ptr = 0; }
 };
 
+/**
+   \brief Compare the hash of an entry with the hash of the searched data.
+   Entries that define identity_eq are equal only if their pointers are equal, the hash
+   comparison is skipped for them since it would dereference the pointer of every probed entry.
+*/
+template<typename Entry>
+inline bool hash_matches(Entry const * curr, unsigned hash) {
+    if constexpr (requires { Entry::identity_eq; })
+        return true;
+    else
+        return curr->get_hash() == hash;
+}
+
 template<typename Entry, typename HashProc, typename EqProc>
 class core_hashtable : private HashProc, private EqProc {
 protected:
@@ -362,7 +375,7 @@ public:
     
 #define INSERT_LOOP_BODY() {                                                            \
         if (curr->is_used()) {                                                          \
-            if (curr->get_hash() == hash && equals(curr->get_data(), e)) {              \
+            if (hash_matches(curr, hash) && equals(curr->get_data(), e)) {              \
                 curr->set_data(std::move(e));                                           \
                 return;                                                                 \
             }                                                                           \
@@ -411,7 +424,7 @@ public:
 
 #define INSERT_LOOP_CORE_BODY() {                                               \
         if (curr->is_used()) {                                                  \
-            if (curr->get_hash() == hash && equals(curr->get_data(), e)) {      \
+            if (hash_matches(curr, hash) && equals(curr->get_data(), e)) {      \
                 et = curr;                                                      \
                 return false;                                                   \
             }                                                                   \
@@ -489,7 +502,7 @@ public:
     
 #define FIND_LOOP_BODY() {                                                      \
         if (curr->is_used()) {                                                  \
-            if (curr->get_hash() == hash && equals(curr->get_data(), e)) {      \
+            if (hash_matches(curr, hash) && equals(curr->get_data(), e)) {      \
                 return curr;                                                    \
             }                                                                   \
             HS_CODE(const_cast<core_hashtable*>(this)->m_st_collision++;);      \
@@ -543,7 +556,7 @@ public:
 
 #define REMOVE_LOOP_BODY() {                                                    \
         if (curr->is_used()) {                                                  \
-            if (curr->get_hash() == hash && equals(curr->get_data(), e)) {      \
+            if (hash_matches(curr, hash) && equals(curr->get_data(), e)) {      \
                 goto end_remove;                                                \
             }                                                                   \
             HS_CODE(m_st_collision++;);                                         \
@@ -665,7 +678,7 @@ public:
 
 #define COLL_LOOP_BODY() {                                              \
     if (curr->is_used()) {                                          \
-        if (curr->get_hash() == hash && equals(curr->get_data(), e)) return; \
+        if (hash_matches(curr, hash) && equals(curr->get_data(), e)) return; \
         collisions.push_back(curr->get_data());                         \
         continue;                                                       \
     }                                                                   \
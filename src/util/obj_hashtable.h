@@ -32,6 +32,8 @@ class obj_hash_entry {
     T *             m_ptr = nullptr;
 public:
     typedef T * data;
+    // entries are compared by ptr_eq (see hash_matches)
+    static constexpr bool identity_eq = true;
     unsigned get_hash() const { return m_ptr->hash(); }
     bool is_free() const { return m_ptr == nullptr; }
     bool is_deleted() const { return m_ptr == reinterpret_cast<T *>(1); }
@@ -81,6 +83,8 @@ public:
         key_data m_data;
     public:
         typedef key_data data;
+        // keys are compared by pointer (see hash_matches)
+        static constexpr bool identity_eq = true;
         unsigned get_hash() const { return m_data.hash(); }
         bool is_free() const { return m_data.m_key == nullptr; }
         bool is_deleted() const { return m_data.m_key == reinterpret_cast<Key *>(1); }
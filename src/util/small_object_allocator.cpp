@@ -23,6 +23,7 @@ Revision History:
 #include "util/debug.h"
 #include "util/util.h"
 #include "util/vector.h"
+#include "util/statistics.h"
 #include<iomanip>
 #ifdef Z3DEBUG
 # include <iostream>
@@ -244,3 +245,41 @@ void small_object_allocator::consolidate() {
                << " :memory " << std::fixed << std::setprecision(2) 
                << static_cast<double>(memory::get_allocation_size())/static_cast<double>(1024*1024) << ")" << std::endl;);
 }
+
+static size_t num_free_objs(void * free_list) {
+    size_t r = 0;
+    for (void ** ptr = reinterpret_cast<void**>(free_list); ptr != nullptr; ptr = reinterpret_cast<void**>(*ptr))
+        r++;
+    return r;
+}
+
+void small_object_allocator::collect_statistics(statistics & st) const {
+    size_t num_chunks = 0, unused = 0;
+    for (unsigned slot_id = 1; slot_id < NUM_SLOTS; slot_id++) {
+        for (chunk * c = m_chunks[slot_id]; c != nullptr; c = c->m_next) {
+            num_chunks++;
+            unused += (c->m_data + CHUNK_SIZE) - c->m_curr;
+        }
+        unused += num_free_objs(m_free_list[slot_id]) * (slot_id << PTR_ALIGNMENT);
+    }
+    st.update("small alloc chunks", static_cast<unsigned>(num_chunks));
+    st.update("small alloc chunk memory", static_cast<double>((100 * num_chunks * sizeof(chunk)) / (1024 * 1024)) / 100.0);
+    st.update("small alloc unused memory", static_cast<double>((100 * unused) / (1024 * 1024)) / 100.0);
+}
+
+std::ostream& small_object_allocator::display_size_classes(std::ostream & out) const {
+    for (unsigned slot_id = 1; slot_id < NUM_SLOTS; slot_id++) {
+        if (m_chunks[slot_id] == nullptr)
+            continue;
+        size_t obj_size = slot_id << PTR_ALIGNMENT;
+        size_t num_chunks = 0, num_objs = 0;
+        for (chunk * c = m_chunks[slot_id]; c != nullptr; c = c->m_next) {
+            num_chunks++;
+            num_objs += (c->m_curr - c->m_data) / obj_size;
+        }
+        size_t num_free = num_free_objs(m_free_list[slot_id]);
+        out << "(small-alloc :size " << obj_size << " :chunks " << num_chunks 
+            << " :used " << (num_objs - num_free) << " :free " << num_free << ")\n";
+    }
+    return out;
+}
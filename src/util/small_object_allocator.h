@@ -23,6 +23,8 @@ Revision History:
 #include "util/debug.h"
 #include "util/trace.h"
 
+class statistics;
+
 class small_object_allocator {
     static const unsigned CHUNK_SIZE     = (8192 - sizeof(void*)*2);
     static const unsigned SMALL_OBJ_SIZE = 256;
@@ -49,6 +51,15 @@ public:
     size_t get_wasted_size() const;
     size_t get_num_free_objs() const;
     void consolidate();
+    /**
+       \brief Add the number of chunks, the bytes of the chunks and the unused bytes of the chunks
+       (free objects and the unallocated rest of the chunks) to st.
+    */
+    void collect_statistics(statistics & st) const;
+    /**
+       \brief Display the chunks, the objects in use and the free objects of each size class.
+    */
+    std::ostream& display_size_classes(std::ostream & out) const;
 };
 
 inline void * operator new(size_t s, small_object_allocator & r) { return r.allocate(s); }
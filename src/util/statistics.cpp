@@ -138,6 +138,37 @@ std::ostream& statistics::display_smt2(std::ostream & out) const {
     return out;
 }
 
+/**
+   \brief Display the statistics as a JSON object on a single line (without a new line).
+*/
+std::ostream& statistics::display_json(std::ostream & out) const {
+    INIT_DISPLAY();
+    (void)max;
+    out << "{";
+    for (unsigned i = 0; i < keys.size(); i++) {
+        char const * k = keys.get(i);
+        if (i > 0)
+            out << ", ";
+        out << "\"";
+        for (char const * c = (*k == ':') ? k + 1 : k; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                out << "\\";
+            out << *c;
+        }
+        out << "\": ";
+        unsigned val;
+        if (m_u.find(k, val))
+            out << val;
+        else {
+            double d_val = 0.0;
+            m_d.find(k, d_val);
+            out << std::fixed << std::setprecision(2) << d_val;
+        }
+    }
+    out << "}";
+    return out;
+}
+
 std::ostream& statistics::display(std::ostream & out) const {
     INIT_DISPLAY();
 
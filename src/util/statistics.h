@@ -34,6 +34,7 @@ public:
     void update(char const * key, double inc);
     std::ostream& display(std::ostream & out) const;
     std::ostream& display_smt2(std::ostream & out) const;
+    std::ostream& display_json(std::ostream & out) const;
     void display_internal(std::ostream & out) const;
     unsigned size() const;
     bool is_uint(unsigned idx) const;
@@ -14,6 +14,7 @@ Author:
     Nikolaj Bjorner (nbjorner) 2021-01-26
 
 --*/
+#include <cstring>
 #include "util/gparams.h"
 #include "util/zstring.h"
 
@@ -33,7 +34,7 @@ static bool is_hex_digit(char ch, unsigned& d) {
     return false;
 }
 
-bool zstring::is_escape_char(char const *& s, unsigned& result) {
+bool zstring::is_escape_char(char const *& s, unsigned max_char, unsigned& result) {
     unsigned d;
     if (*s == '\\' && s[1] == 'u' && s[2] == '{' && s[3] != '}') {
         result = 0;
@@ -42,7 +43,7 @@ bool zstring::is_escape_char(char const *& s, unsigned& result) {
                 result = 16*result + d;
             }
             else if (*(s+3+i) == '}') {
-                if (result > max_char())
+                if (result > max_char)
                     return false;
                 s += 4 + i;
                 return true;                
@@ -63,7 +64,7 @@ bool zstring::is_escape_char(char const *& s, unsigned& result) {
         result = 16*result + d2;
         result = 16*result + d3;
         result = 16*result + d4;
-        if (result > max_char())
+        if (result > max_char)
             return false;
         s += 6;
         return true;
@@ -72,9 +73,12 @@ bool zstring::is_escape_char(char const *& s, unsigned& result) {
 }
 
 zstring::zstring(char const* s) {
+    // every character of s gives at most one character of the string
+    m_buffer.reserve(static_cast<unsigned>(strlen(s)));
+    unsigned max = max_char();
     while (*s) {
         unsigned ch = 0;
-        if (is_escape_char(s, ch)) {
+        if (*s == '\\' && is_escape_char(s, max, ch)) {
             m_buffer.push_back(ch);
         }
         else {
@@ -96,8 +100,9 @@ string_encoding zstring::get_encoding() {
 }
 
 bool zstring::well_formed() const {
+    unsigned max = max_char();
     for (unsigned ch : m_buffer) {
-        if (ch > max_char()) {
+        if (ch > max) {
             IF_VERBOSE(0, verbose_stream() << "large character: " << ch << "\n";);
             return false;
         }
@@ -230,11 +235,9 @@ int zstring::last_indexof(zstring const& other) const {
 
 zstring zstring::extract(unsigned offset, unsigned len) const {
     zstring result;
-    if (offset + len < offset) return result;
-    int last = std::min(offset+len, length());
-    for (int i = offset; i < last; ++i) {
-        result.m_buffer.push_back(m_buffer[i]);
-    }
+    if (offset + len < offset || offset >= length()) return result;
+    unsigned last = std::min(offset+len, length());
+    result.m_buffer.append(last - offset, m_buffer.data() + offset);
     return result;
 }
 
@@ -243,7 +246,9 @@ unsigned zstring::hash() const {
 }
 
 zstring zstring::operator+(zstring const& other) const {
-    zstring result(*this);
+    zstring result;
+    result.m_buffer.reserve(length() + other.length());
+    result.m_buffer.append(m_buffer);
     result.m_buffer.append(other.m_buffer);
     return result;
 }
@@ -251,15 +256,8 @@ zstring zstring::operator+(zstring const& other) const {
 
 bool zstring::operator==(const zstring& other) const {
     // two strings are equal iff they have the same length and characters
-    if (length() != other.length()) {
-        return false;
-    }
-    for (unsigned i = 0; i < length(); ++i) {
-        if (m_buffer[i] != other[i]) {
-            return false;
-        }
-    }
-    return true;
+    return length() == other.length() && 
+        (empty() || memcmp(m_buffer.data(), other.m_buffer.data(), sizeof(uint32_t) * length()) == 0);
 }
 
 bool zstring::operator!=(const zstring& other) const {
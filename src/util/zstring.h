@@ -31,7 +31,7 @@ class zstring {
 private:
     buffer<uint32_t> m_buffer;
     bool well_formed() const;
-    bool is_escape_char(char const *& s, unsigned& result);
+    static bool is_escape_char(char const *& s, unsigned max_char, unsigned& result);
 public:
     static unsigned unicode_max_char() { return 196607; }
     static unsigned unicode_num_bits() { return 18; }